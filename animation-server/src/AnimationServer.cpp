@@ -782,7 +782,8 @@ AnimationServer::AnimationServer(int &argc, char **argv) :
     ::voxelEditPacketSender->initialize(!::nonThreadedPacketSender);
     
     if (::jurisdictionListener) {
-        ::voxelEditPacketSender->setVoxelServerJurisdictions(::jurisdictionListener->getJurisdictions());
+        ::voxelEditPacketSender->setVoxelServerJurisdictions(::jurisdictionListener->getJurisdictions(),
+                                                             ::jurisdictionListener->getJurisdictionsVersion());
     }
     if (::nonThreadedPacketSender) {
         ::voxelEditPacketSender->setProcessCallIntervalHint(PROCESSING_INTERVAL_USECS);
@@ -12,6 +12,7 @@
 
 #include <AccountManager.h>
 #include <Assignment.h>
+#include <HTTPManager.h>
 #include <Logging.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
@@ -90,6 +91,15 @@ AssignmentClient::AssignmentClient(int &argc, char **argv) :
         nodeList->setAssignmentServerSocket(customAssignmentSocket);
     }
     
+    // serve the metrics for whatever assignment we end up running, from this thread so that scraping them never
+    // gets in the way of the assignment's own thread
+    const char METRICS_PORT_OPTION[] = "--metricsPort";
+    const char* metricsPortString = getCmdOption(argc, (const char**) argv, METRICS_PORT_OPTION);
+    if (metricsPortString) {
+        QString documentRoot = QString("%1/resources/web").arg(QCoreApplication::applicationDirPath());
+        new HTTPManager(atoi(metricsPortString), documentRoot, NULL, this);
+    }
+    
     // call a timer function every ASSIGNMENT_REQUEST_INTERVAL_MSECS to ask for assignment, if required
     qDebug() << "Waiting for assignment -" << _requestAssignment;
     
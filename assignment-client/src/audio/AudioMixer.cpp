@@ -37,6 +37,7 @@
 #include <QtCore/QTimer>
 
 #include <Logging.h>
+#include <MetricsRegistry.h>
 #include <NodeList.h>
 #include <Node.h>
 #include <PacketHeaders.h>
@@ -398,8 +399,17 @@ void AudioMixer::run() {
     
     const int TRAILING_AVERAGE_FRAMES = 100;
     int framesSinceCutoffEvent = TRAILING_AVERAGE_FRAMES;
+    
+    MetricsRegistry* metrics = MetricsRegistry::getInstance();
+    MetricHistogram* frameTimeMetric = metrics->histogram("hifi_audio_mixer_frame_usecs",
+                                                          "Time the audio mixer spent on each frame, not counting sleep");
+    MetricGauge* sleepRatioMetric = metrics->gauge("hifi_audio_mixer_sleep_ratio",
+                                                   "Trailing ratio of each frame the audio mixer spent asleep");
+    MetricGauge* throttlingRatioMetric = metrics->gauge("hifi_audio_mixer_throttling_ratio",
+                                                        "How far the audio mixer has raised its audibility threshold");
 
     while (!_isFinished) {
+        quint64 frameStart = usecTimestampNow();
         
         foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
             if (node->getLinkedData()) {
@@ -421,6 +431,7 @@ void AudioMixer::run() {
         
         _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
             + (usecToSleep * CURRENT_FRAME_RATIO / (float) BUFFER_SEND_INTERVAL_USECS);
+        sleepRatioMetric->set(_trailingSleepRatio);
         
         float lastCutoffRatio = _performanceThrottlingRatio;
         bool hasRatioChanged = false;
@@ -458,6 +469,7 @@ void AudioMixer::run() {
         if (!hasRatioChanged) {
             ++framesSinceCutoffEvent;
         }
+        throttlingRatioMetric->set(_performanceThrottlingRatio);
         
         foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
             if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData()
@@ -487,6 +499,8 @@ void AudioMixer::run() {
         if (_isFinished) {
             break;
         }
+        
+        frameTimeMetric->observe(usecTimestampNow() - frameStart);
 
         usecToSleep = usecTimestamp(&startTime) + (++nextFrame * BUFFER_SEND_INTERVAL_USECS) - usecTimestampNow();
 
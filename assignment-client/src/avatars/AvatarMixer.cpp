@@ -12,11 +12,13 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
+#include <QtCore/QHash>
 #include <QtCore/QJsonObject>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
 
 #include <Logging.h>
+#include <MetricsRegistry.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
@@ -39,7 +41,11 @@ AvatarMixer::AvatarMixer(const QByteArray& packet) :
     _sumListeners(0),
     _numStatFrames(0),
     _sumBillboardPackets(0),
-    _sumIdentityPackets(0)
+    _sumIdentityPackets(0),
+    _frameTimeMetric(MetricsRegistry::getInstance()->histogram("hifi_avatar_mixer_frame_usecs",
+                                                               "Time the avatar mixer spent on each broadcast")),
+    _sleepRatioMetric(MetricsRegistry::getInstance()->gauge("hifi_avatar_mixer_sleep_ratio",
+                                                            "Trailing ratio of each frame the avatar mixer spent idle"))
 {
     // make sure we hear about node kills so we can tell the other nodes
     connect(NodeList::getInstance(), &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
@@ -62,6 +68,7 @@ const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
 //    1) use the view frustum to cull those avatars that are out of view. Since avatar data doesn't need to be present
 //       if the avatar is not in view or in the keyhole.
 void AvatarMixer::broadcastAvatarData() {
+    quint64 frameStart = usecTimestampNow();
     
     int idleTime = QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp;
     
@@ -80,6 +87,7 @@ void AvatarMixer::broadcastAvatarData() {
     
     _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
         + (idleTime * CURRENT_FRAME_RATIO / (float) AVATAR_DATA_SEND_INTERVAL_MSECS);
+    _sleepRatioMetric->set(_trailingSleepRatio);
     
     float lastCutoffRatio = _performanceThrottlingRatio;
     bool hasRatioChanged = false;
@@ -123,6 +131,16 @@ void AvatarMixer::broadcastAvatarData() {
     AvatarMixerClientData* nodeData = NULL;
     AvatarMixerClientData* otherNodeData = NULL;
     
+    // pack each avatar once per frame, so that every listener gets the same keyframes and deltas against them
+    QHash<QUuid, QByteArray> packedAvatars;
+    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        if (node->getLinkedData() && node->getType() == NodeType::Agent
+            && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
+            packedAvatars.insert(node->getUUID(), nodeData->getAvatar().toByteArray());
+            nodeData->getMutex().unlock();
+        }
+    }
+    
     foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
         if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
             && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
@@ -138,6 +156,7 @@ void AvatarMixer::broadcastAvatarData() {
             // send back a packet with other active node data to this node
             foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
                 if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
+                    && packedAvatars.contains(otherNode->getUUID())
                     && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
                     
                     AvatarMixerClientData* otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData());
@@ -149,12 +168,15 @@ void AvatarMixer::broadcastAvatarData() {
                     //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
                     const float FULL_RATE_DISTANCE = 2.f;
                     
-                    //  Decide whether to send this avatar's data based on it's distance from us
-                    if ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
-                        && (distanceToAvatar == 0.f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar)) {
+                    //  Decide whether to send this avatar's data based on it's distance from us, keyframes always go out
+                    //  since the deltas that follow are useless without them
+                    const QByteArray& packedAvatar = packedAvatars[otherNode->getUUID()];
+                    if (AvatarData::isKeyframe(packedAvatar)
+                        || ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
+                            && (distanceToAvatar == 0.f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar))) {
                         QByteArray avatarByteArray;
                         avatarByteArray.append(otherNode->getUUID().toRfc4122());
-                        avatarByteArray.append(otherAvatar.toByteArray());
+                        avatarByteArray.append(packedAvatar);
                         
                         if (avatarByteArray.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
                             nodeList->writeDatagram(mixedAvatarByteArray, node);
@@ -213,6 +235,7 @@ void AvatarMixer::broadcastAvatarData() {
     }
     
     _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
+    _frameTimeMetric->observe(usecTimestampNow() - frameStart);
 }
 
 void AvatarMixer::nodeKilled(SharedNodePointer killedNode) {
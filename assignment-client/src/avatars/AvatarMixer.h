@@ -11,6 +11,9 @@
 
 #include <ThreadedAssignment.h>
 
+class MetricGauge;
+class MetricHistogram;
+
 /// Handles assignments of type AvatarMixer - distribution of avatar data to various clients
 class AvatarMixer : public ThreadedAssignment {
 public:
@@ -41,6 +44,9 @@ private:
     int _numStatFrames;
     int _sumBillboardPackets;
     int _sumIdentityPackets;
+    
+    MetricHistogram* _frameTimeMetric;
+    MetricGauge* _sleepRatioMetric;
 };
 
 #endif /* defined(__hifi__AvatarMixer__) */
@@ -25,7 +25,8 @@ MetavoxelServer::MetavoxelServer(const QByteArray& packet) :
 }
 
 void MetavoxelServer::applyEdit(const MetavoxelEditMessage& edit) {
-    edit.apply(_data, SharedObject::getWeakHash());
+    // objects are looked up by ID in their own shard of the registry, rather than copying the whole registry per edit
+    edit.apply(_data);
 }
 
 const QString METAVOXEL_SERVER_LOGGING_NAME = "metavoxel-server";
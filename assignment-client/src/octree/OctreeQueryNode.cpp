@@ -11,6 +11,7 @@
 #include "OctreeQueryNode.h"
 #include <cstring>
 #include <cstdio>
+#include <QMutexLocker>
 #include "OctreeSendThread.h"
 
 OctreeQueryNode::OctreeQueryNode() :
@@ -40,6 +41,8 @@ OctreeQueryNode::OctreeQueryNode() :
     _myPacketType(PacketTypeUnknown),
     _isShuttingDown(false)
 {
+    // stream the content nearest to the viewer first
+    nodeBag.setViewFrustum(&_currentViewFrustum);
 }
 
 OctreeQueryNode::~OctreeQueryNode() {
@@ -285,6 +288,12 @@ void OctreeQueryNode::setViewSent(bool viewSent) {
     }
 }
 
+void OctreeQueryNode::updateSceneSubtreeVersions() {
+    // parseData() runs with our mutex held, so this keeps us from copying the versions while they're being replaced
+    QMutexLocker locker(&getMutex());
+    _sceneSubtreeVersions = getSubtreeVersions();
+}
+
 void OctreeQueryNode::updateLastKnownViewFrustum() {
     // if shutting down, return immediately
     if (_isShuttingDown) {
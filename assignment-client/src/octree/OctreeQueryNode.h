@@ -14,6 +14,7 @@
 #include <OctreePacketData.h>
 #include <OctreeQuery.h>
 
+#include <CoverageBuffer.h>
 #include <CoverageMap.h>
 #include <OctreeConstants.h>
 #include <OctreeElementBag.h>
@@ -53,6 +54,7 @@ public:
 
     OctreeElementBag nodeBag;
     CoverageMap map;
+    CoverageBuffer coverageBuffer; // used instead of the map by clients that ask for it
 
     ViewFrustum& getCurrentViewFrustum() { return _currentViewFrustum; }
     ViewFrustum& getLastKnownViewFrustum() { return _lastKnownViewFrustum; }
@@ -80,6 +82,11 @@ public:
     }
 
     bool hasLodChanged() const { return _lodChanged; };
+
+    /// The client's cached subtrees as they were when the current scene started. The query can be updated at any time
+    /// from the network receive, so the send thread works from this copy instead.
+    const OctreeSubtreeVersions& getSceneSubtreeVersions() const { return _sceneSubtreeVersions; }
+    void updateSceneSubtreeVersions();
     
     OctreeSceneStats stats;
     
@@ -127,6 +134,8 @@ private:
     float _lastClientOctreeSizeScale;
     bool _lodChanged;
     bool _lodInitialized;
+
+    OctreeSubtreeVersions _sceneSubtreeVersions;
     
     OCTREE_PACKET_SEQUENCE _sequenceNumber;
     quint64 _lastRootTimestamp;
@@ -23,6 +23,7 @@ OctreeSendThread::OctreeSendThread(OctreeServer* myServer, SharedNodePointer nod
     _myServer(myServer),
     _nodeUUID(node->getUUID()),
     _packetData(),
+    _parallelEncoder(NULL),
     _nodeMissingCount(0),
     _processLock(),
     _isShuttingDown(false)
@@ -34,6 +35,10 @@ OctreeSendThread::OctreeSendThread(OctreeServer* myServer, SharedNodePointer nod
     qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client connected "
                                             "- starting sending thread [" << this << "]";
 
+    if (_myServer && _myServer->getEncodeThreadPool()) {
+        _parallelEncoder = new OctreeParallelEncoder(_myServer->getOctree(), _myServer->getEncodeThreadPool());
+    }
+
     OctreeServer::clientConnected();
 }
 
@@ -44,6 +49,7 @@ OctreeSendThread::~OctreeSendThread() {
     }
     qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client disconnected "
                                             "- ending sending thread [" << this << "]";
+    delete _parallelEncoder; // waits for any of our workers to return
     OctreeServer::clientDisconnected();
 }
 
@@ -53,6 +59,10 @@ void OctreeSendThread::setIsShuttingDown() {
     
     // this will cause us to wait till the process loop is complete, we do this after we change _isShuttingDown
     QMutexLocker locker(&_processLock); 
+
+    if (_parallelEncoder) {
+        _parallelEncoder->cancel();
+    }
 }
 
 
@@ -308,9 +318,18 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
 
     const ViewFrustum* lastViewFrustum =  wantDelta ? &nodeData->getLastKnownViewFrustum() : NULL;
 
+    bool parallelSceneInProgress = _parallelEncoder && _parallelEncoder->isActive();
+
     // If the current view frustum has changed OR we have nothing to send, then search against
     // the current view frustum for things to send.
-    if (viewFrustumChanged || nodeData->nodeBag.isEmpty()) {
+    if (viewFrustumChanged || (nodeData->nodeBag.isEmpty() && !parallelSceneInProgress)) {
+
+        // anything the workers had left to encode was for the old view
+        if (parallelSceneInProgress) {
+            _parallelEncoder->takeEncodeStats(nodeData->stats);
+            _parallelEncoder->cancel();
+            parallelSceneInProgress = false;
+        }
 
         // if our view has changed, we need to reset these things...
         if (viewFrustumChanged) {
@@ -318,6 +337,7 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
                 nodeData->dumpOutOfView();
             }
             nodeData->map.erase();
+            nodeData->coverageBuffer.erase();
         }
 
         if (!viewFrustumChanged && !nodeData->getWantDelta()) {
@@ -350,17 +370,41 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
         // start tracking our stats
         nodeData->stats.sceneStarted(isFullScene, viewFrustumChanged, _myServer->getOctree()->getRoot(), _myServer->getJurisdiction());
 
+        // the subtrees the client already has cached are only honored for the scene they were current for
+        nodeData->updateSceneSubtreeVersions();
+
         // This is the start of "resending" the scene.
         bool dontRestartSceneOnMove = false; // this is experimental
         if (dontRestartSceneOnMove) {
             if (nodeData->nodeBag.isEmpty()) {
                 nodeData->nodeBag.insert(_myServer->getOctree()->getRoot()); // only in case of empty
             }
+        } else if (_parallelEncoder && isFullScene && !nodeData->getWantOcclusionCulling()) {
+            // full scenes are split across the encode thread pool instead of going through our bag
+            nodeData->nodeBag.deleteAll();
+
+            int boundaryLevelAdjust = nodeData->getBoundaryLevelAdjust() + (viewFrustumChanged && nodeData->getWantLowResMoving()
+                                                                            ? LOW_RES_MOVING_ADJUST : NO_BOUNDARY_ADJUST);
+            EncodeBitstreamParams params(INT_MAX, &nodeData->getCurrentViewFrustum(), wantColor,
+                                         WANT_EXISTS_BITS, DONT_CHOP, wantDelta, lastViewFrustum,
+                                         NO_OCCLUSION_CULLING, IGNORE_COVERAGE_MAP, boundaryLevelAdjust,
+                                         nodeData->getOctreeSizeScale(), nodeData->getLastTimeBagEmpty(),
+                                         isFullScene, IGNORE_SCENE_STATS, _myServer->getJurisdiction());
+            params.subtreeVersions = &nodeData->getSceneSubtreeVersions();
+            _parallelEncoder->start(params, wantCompression);
+            parallelSceneInProgress = true;
         } else {
             nodeData->nodeBag.insert(_myServer->getOctree()->getRoot()); // original behavior, reset on move or empty
         }
     }
 
+    if (parallelSceneInProgress) {
+        int clientMaxPacketsPerInterval = std::max(1,(nodeData->getMaxOctreePacketsPerSecond() / INTERVALS_PER_SECOND));
+        int maxPacketsPerInterval = std::min(clientMaxPacketsPerInterval, _myServer->getPacketsPerClientPerInterval());
+        packetsSentThisInterval += sendParallelEncodedSections(node, nodeData, maxPacketsPerInterval - packetsSentThisInterval,
+                                                               trueBytesSent, truePacketsSent);
+    }
+
     // If we have something in our nodeBag, then turn them into packets and send them out...
     if (!nodeData->nodeBag.isEmpty()) {
         int bytesWritten = 0;
@@ -422,6 +466,10 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
                                              wantOcclusionCulling, coverageMap, boundaryLevelAdjust, voxelSizeScale,
                                              nodeData->getLastTimeBagEmpty(),
                                              isFullScene, &nodeData->stats, _myServer->getJurisdiction());
+                params.subtreeVersions = &nodeData->getSceneSubtreeVersions();
+                if (wantOcclusionCulling && nodeData->getWantCoverageBuffer()) {
+                    params.coverageBuffer = &nodeData->coverageBuffer;
+                }
 
                 // TODO: should this include the lock time or not? This stat is sent down to the client,
                 // it seems like it may be a good idea to include the lock time as part of the encode time
@@ -565,9 +613,52 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
             nodeData->updateLastKnownViewFrustum();
             nodeData->setViewSent(true);
             nodeData->map.erase(); // It would be nice if we could save this, and only reset it when the view frustum changes
+            nodeData->coverageBuffer.erase();
         }
 
     } // end if bag wasn't empty, and so we sent stuff...
 
     return truePacketsSent;
 }
+
+/// Sends the sections the parallel encoder has finished, in scene order, packing them into wire packets the same way
+/// packetDistributor() does for sections it encodes itself.
+int OctreeSendThread::sendParallelEncodedSections(const SharedNodePointer& node, OctreeQueryNode* nodeData,
+                                                  int maxPacketsPerInterval, int& trueBytesSent, int& truePacketsSent) {
+    int packetsSent = 0;
+    _parallelEncoder->scheduleWorkers();
+
+    QByteArray section;
+    while (packetsSent < maxPacketsPerInterval && !nodeData->isShuttingDown() && _parallelEncoder->takeNextSection(section)) {
+        quint64 compressAndWriteStart = usecTimestampNow();
+        unsigned int writtenSize = section.size()
+                + (nodeData->getCurrentPacketIsCompressed() ? sizeof(OCTREE_PACKET_INTERNAL_SECTION_SIZE) : 0);
+        if (writtenSize > nodeData->getAvailable()) {
+            packetsSent += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
+        }
+        nodeData->writeToPacket(reinterpret_cast<const unsigned char*>(section.constData()), section.size());
+        OctreeServer::trackCompressAndWriteTime((float)(usecTimestampNow() - compressAndWriteStart));
+
+        // uncompressed sections fill a whole packet, compressed ones we keep packing while there's room
+        if (!nodeData->getCurrentPacketIsCompressed() || nodeData->getAvailable() < MINIMUM_ATTEMPT_MORE_PACKING) {
+            packetsSent += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
+        }
+        _parallelEncoder->scheduleWorkers(); // we've made room, let the workers get ahead again
+    }
+
+    // don't hold on to a partly packed packet while we wait for the workers
+    if (nodeData->isPacketWaiting() && packetsSent < maxPacketsPerInterval) {
+        packetsSent += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
+    }
+
+    _parallelEncoder->takeEncodeStats(nodeData->stats);
+
+    if (_parallelEncoder->isComplete()) {
+        _parallelEncoder->cancel(); // resets it for the next scene
+        nodeData->updateLastKnownViewFrustum();
+        nodeData->setViewSent(true);
+        nodeData->map.erase();
+        nodeData->coverageBuffer.erase();
+    }
+    return packetsSent;
+}
@@ -13,6 +13,7 @@
 #include <GenericThread.h>
 #include <NetworkPacket.h>
 #include <OctreeElementBag.h>
+#include <OctreeParallelEncoder.h>
 #include "OctreeQueryNode.h"
 #include "OctreeServer.h"
 
@@ -43,8 +44,11 @@ private:
 
     int handlePacketSend(const SharedNodePointer& node, OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent);
     int packetDistributor(const SharedNodePointer& node, OctreeQueryNode* nodeData, bool viewFrustumChanged);
+    int sendParallelEncodedSections(const SharedNodePointer& node, OctreeQueryNode* nodeData, int maxPacketsPerInterval,
+                                    int& trueBytesSent, int& truePacketsSent);
 
     OctreePacketData _packetData;
+    OctreeParallelEncoder* _parallelEncoder; // only used if the server has parallel encoding turned on
     
     int _nodeMissingCount;
     QMutex _processLock; // don't allow us to have our nodeData, or our thread to be deleted while we're processing
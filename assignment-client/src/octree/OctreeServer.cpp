@@ -14,11 +14,27 @@
 #include <time.h>
 #include <HTTPConnection.h>
 #include <Logging.h>
+#include <MetricsRegistry.h>
 #include <UUID.h>
 
 #include "OctreeServer.h"
 #include "OctreeServerConsts.h"
 
+static MetricHistogram* encodeTimeMetric = MetricsRegistry::getInstance()->histogram("hifi_octree_encode_usecs",
+    "Time spent encoding each packet's worth of the octree");
+static MetricHistogram* treeWaitTimeMetric = MetricsRegistry::getInstance()->histogram("hifi_octree_tree_lock_wait_usecs",
+    "Time send threads waited to lock the octree for reading");
+static MetricHistogram* processWaitTimeMetric = MetricsRegistry::getInstance()->histogram(
+    "hifi_octree_process_lock_wait_usecs", "Time send threads waited to lock the octree to process its deletions");
+static MetricHistogram* compressAndWriteTimeMetric = MetricsRegistry::getInstance()->histogram(
+    "hifi_octree_compress_and_write_usecs", "Time spent compressing and writing each packet's worth of the octree");
+static MetricGauge* inboundQueueDepthMetric = MetricsRegistry::getInstance()->gauge("hifi_octree_inbound_queue_depth",
+    "Edit packets waiting to be processed");
+static MetricGauge* clientCountMetric = MetricsRegistry::getInstance()->gauge("hifi_octree_clients",
+    "Clients the octree server is sending to");
+static MetricGauge* elementCountMetric = MetricsRegistry::getInstance()->gauge("hifi_octree_elements",
+    "Elements in the octree");
+
 OctreeServer* OctreeServer::_instance = NULL;
 int OctreeServer::_clientCount = 0;
 const int MOVING_AVERAGE_SAMPLE_COUNTS = 1000000;
@@ -133,6 +149,7 @@ void OctreeServer::trackEncodeTime(float time) {
         _extraLongEncode++;
         _averageExtraLongEncodeTime.updateAverage(time);
     }
+    encodeTimeMetric->observe(time); // skips too, as zeros, just as the averages count them
     _averageEncodeTime.updateAverage(time); 
 }
 
@@ -152,6 +169,7 @@ void OctreeServer::trackTreeWaitTime(float time) {
         _extraLongTreeWait++;
         _averageTreeExtraLongWaitTime.updateAverage(time);
     }
+    treeWaitTimeMetric->observe(time);
     _averageTreeWaitTime.updateAverage(time);
 }
 
@@ -171,6 +189,7 @@ void OctreeServer::trackCompressAndWriteTime(float time) {
         _extraLongCompress++;
         _averageExtraLongCompressTime.updateAverage(time);
     }
+    compressAndWriteTimeMetric->observe(time);
     _averageCompressAndWriteTime.updateAverage(time); 
 }
 
@@ -199,6 +218,7 @@ void OctreeServer::trackProcessWaitTime(float time) {
         _extraLongProcessWait++;
         _averageProcessExtraLongWaitTime.updateAverage(time);
     }
+    processWaitTimeMetric->observe(time);
     _averageProcessWaitTime.updateAverage(time);
 }
 
@@ -228,6 +248,7 @@ OctreeServer::OctreeServer(const QByteArray& packet) :
     _jurisdictionSender(NULL),
     _octreeInboundPacketProcessor(NULL),
     _persistThread(NULL),
+    _encodeThreadPool(NULL),
     _started(time(0)),
     _startedUSecs(usecTimestampNow())
 {
@@ -260,6 +281,12 @@ OctreeServer::~OctreeServer() {
         _persistThread->deleteLater();
     }
 
+    if (_encodeThreadPool) {
+        _encodeThreadPool->waitForDone();
+        delete _encodeThreadPool;
+        _encodeThreadPool = NULL;
+    }
+
     delete _jurisdiction;
     _jurisdiction = NULL;
     qDebug() << qPrintable(_safeServerName) << "server DONE shutting down... [" << this << "]";
@@ -1006,6 +1033,17 @@ void OctreeServer::run() {
     qDebug("packetsPerSecondTotalMax=%s _packetsTotalPerInterval=%d", 
                     packetsPerSecondTotalMax, _packetsTotalPerInterval);
 
+    // Encode full scenes for new clients on a pool of worker threads, optionally with a specific number of threads
+    const char* PARALLEL_ENCODE = "--parallelEncode";
+    if (cmdOptionExists(_argc, _argv, PARALLEL_ENCODE)) {
+        _encodeThreadPool = new QThreadPool();
+        const char* parallelEncodeThreads = getCmdOption(_argc, _argv, PARALLEL_ENCODE);
+        if (parallelEncodeThreads && atoi(parallelEncodeThreads) > 0) {
+            _encodeThreadPool->setMaxThreadCount(atoi(parallelEncodeThreads));
+        }
+        qDebug("parallelEncode threads=%d", _encodeThreadPool->maxThreadCount());
+    }
+
     HifiSockAddr senderSockAddr;
 
     // set up our jurisdiction broadcaster...
@@ -1168,6 +1206,12 @@ void OctreeServer::sendStatsPacket() {
     //    3) automatically break up into multiple packets
     static QJsonObject statsObject1;
     
+    clientCountMetric->set(getCurrentClientCount());
+    elementCountMetric->set(OctreeElement::getNodeCount());
+    if (_octreeInboundPacketProcessor) {
+        inboundQueueDepthMetric->set(_octreeInboundPacketProcessor->packetsToProcessCount());
+    }
+    
     QString baseName = getMyServerName() + QString("Server");
     
     statsObject1[baseName + QString(".0.1.configuration")] = getConfiguration();
@@ -12,6 +12,7 @@
 
 #include <QStringList>
 #include <QDateTime>
+#include <QThreadPool>
 #include <QtCore/QCoreApplication>
 
 #include <HTTPManager.h>
@@ -41,6 +42,9 @@ public:
     bool wantsVerboseDebug() const { return _verboseDebug; }
 
     Octree* getOctree() { return _tree; }
+
+    /// The pool shared by all the send threads for encoding full scenes in parallel, NULL if parallel encoding is off
+    QThreadPool* getEncodeThreadPool() { return _encodeThreadPool; }
     JurisdictionMap* getJurisdiction() { return _jurisdiction; }
 
     int getPacketsPerClientPerInterval() const { return std::min(_packetsPerClientPerInterval, 
@@ -153,6 +157,7 @@ protected:
     JurisdictionSender* _jurisdictionSender;
     OctreeInboundPacketProcessor* _octreeInboundPacketProcessor;
     OctreePersistThread* _persistThread;
+    QThreadPool* _encodeThreadPool;
 
     static OctreeServer* _instance;
 
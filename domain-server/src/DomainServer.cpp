@@ -17,7 +17,9 @@
 #include <QtCore/QTimer>
 
 #include <AccountManager.h>
+#include <DomainListPacker.h>
 #include <HTTPConnection.h>
+#include <MetricsRegistry.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
 #include <UUID.h>
@@ -414,71 +416,39 @@ NodeSet DomainServer::nodeInterestListFromPacket(const QByteArray& packet, int n
     return nodeInterestSet;
 }
 
-void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr &senderSockAddr,
-                                        const NodeSet& nodeInterestList) {
-    
-    QByteArray broadcastPacket = byteArrayWithPopulatedHeader(PacketTypeDomainList);
-    
-    // always send the node their own UUID back
-    QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
-    broadcastDataStream << node->getUUID();
-    
-    int numBroadcastPacketLeadBytes = broadcastDataStream.device()->pos();
-    
+/// Hands out the secrets for the domain list, making one up the first time two nodes are introduced.
+class DomainServerListPacker : public DomainListPacker {
+protected:
+    virtual QUuid getConnectionSecret(const SharedNodePointer& node, const SharedNodePointer& otherNode);
+};
+
+QUuid DomainServerListPacker::getConnectionSecret(const SharedNodePointer& node, const SharedNodePointer& otherNode) {
     DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
-    
+    QUuid secretUUID = nodeData->getSessionSecretHash().value(otherNode->getUUID());
+    if (secretUUID.isNull()) {
+        // generate a new secret UUID these two nodes can use
+        secretUUID = QUuid::createUuid();
+        
+        // set that on the current Node's sessionSecretHash
+        nodeData->getSessionSecretHash().insert(otherNode->getUUID(), secretUUID);
+        
+        // set it on the other Node's sessionSecretHash
+        reinterpret_cast<DomainServerNodeData*>(otherNode->getLinkedData())
+            ->getSessionSecretHash().insert(node->getUUID(), secretUUID);
+    }
+    return secretUUID;
+}
+
+void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr &senderSockAddr,
+                                        const NodeSet& nodeInterestList, quint32 lastEpoch, quint32 lastVersion) {
     NodeList* nodeList = NodeList::getInstance();
     
-    
-    if (nodeInterestList.size() > 0) {
-        // if the node has any interest types, send back those nodes as well
-        foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
-            
-            // reset our nodeByteArray and nodeDataStream
-            QByteArray nodeByteArray;
-            QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
-            
-            if (otherNode->getUUID() != node->getUUID() && nodeInterestList.contains(otherNode->getType())) {
-                
-                // don't send avatar nodes to other avatars, that will come from avatar mixer
-                nodeDataStream << *otherNode.data();
-                
-                // pack the secret that these two nodes will use to communicate with each other
-                QUuid secretUUID = nodeData->getSessionSecretHash().value(otherNode->getUUID());
-                if (secretUUID.isNull()) {
-                    // generate a new secret UUID these two nodes can use
-                    secretUUID = QUuid::createUuid();
-                    
-                    // set that on the current Node's sessionSecretHash
-                    nodeData->getSessionSecretHash().insert(otherNode->getUUID(), secretUUID);
-                    
-                    // set it on the other Node's sessionSecretHash
-                    reinterpret_cast<DomainServerNodeData*>(otherNode->getLinkedData())
-                        ->getSessionSecretHash().insert(node->getUUID(), secretUUID);
-                    
-                }
-                
-                nodeDataStream << secretUUID;
-                
-                if (broadcastPacket.size() +  nodeByteArray.size() > MAX_PACKET_SIZE) {
-                    // we need to break here and start a new packet
-                    // so send the current one
-                    
-                    nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
-                    
-                    // reset the broadcastPacket structure
-                    broadcastPacket.resize(numBroadcastPacketLeadBytes);
-                    broadcastDataStream.device()->seek(numBroadcastPacketLeadBytes);
-                }
-                
-                // append the nodeByteArray to the current state of broadcastDataStream
-                broadcastPacket.append(nodeByteArray);
-            }
-        }
+    DomainServerListPacker packer;
+    QList<QByteArray> packets = packer.pack(_membershipLog, node, nodeList->getNodeHash(), nodeInterestList,
+                                            lastEpoch, lastVersion);
+    foreach (const QByteArray& broadcastPacket, packets) {
+        nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
     }
-    
-    // always write the last broadcastPacket
-    nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
 }
 
 void DomainServer::readAvailableDatagrams() {
@@ -553,14 +523,29 @@ void DomainServer::readAvailableDatagrams() {
                 int numNodeInfoBytes = parseNodeDataFromByteArray(throwawayNodeType, nodePublicAddress, nodeLocalAddress,
                                                                   receivedPacket, senderSockAddr);
                 
-                SharedNodePointer checkInNode = nodeList->updateSocketsForNode(nodeUUID, nodePublicAddress, nodeLocalAddress);
+                // the other nodes only hear about a socket change through the membership log
+                SharedNodePointer checkInNode = nodeList->nodeWithUUID(nodeUUID);
+                if (checkInNode && (checkInNode->getPublicSocket() != nodePublicAddress
+                                    || checkInNode->getLocalSocket() != nodeLocalAddress)) {
+                    _membershipLog.nodeAdded(nodeUUID);
+                }
+                
+                checkInNode = nodeList->updateSocketsForNode(nodeUUID, nodePublicAddress, nodeLocalAddress);
             
                 // update last receive to now
                 quint64 timeNow = usecTimestampNow();
                 checkInNode->setLastHeardMicrostamp(timeNow);
                 
+                // the interest list is followed by the version of the domain list the node already has
+                NodeSet nodeInterestList = nodeInterestListFromPacket(receivedPacket, numNodeInfoBytes);
+                QDataStream packetStream(receivedPacket);
+                packetStream.skipRawData(numNodeInfoBytes + sizeof(quint8) + nodeInterestList.size() * sizeof(NodeType_t));
+                
+                quint32 lastEpoch = 0;
+                quint32 lastVersion = NO_DOMAIN_LIST_VERSION;
+                packetStream >> lastEpoch >> lastVersion;
                 
-                sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestListFromPacket(receivedPacket, numNodeInfoBytes));
+                sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestList, lastEpoch, lastVersion);
                 
             } else if (requestType == PacketTypeRequestAssignment) {
                 
@@ -860,9 +845,12 @@ void DomainServer::refreshStaticAssignmentAndAddToQueue(SharedAssignmentPointer&
 void DomainServer::nodeAdded(SharedNodePointer node) {
     // we don't use updateNodeWithData, so add the DomainServerNodeData to the node here
     node->setLinkedData(new DomainServerNodeData());
+    
+    _membershipLog.nodeAdded(node->getUUID());
 }
 
 void DomainServer::nodeKilled(SharedNodePointer node) {
+    _membershipLog.nodeRemoved(node->getUUID());
     
     DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
     if (nodeData) {
@@ -18,6 +18,7 @@
 #include <QtCore/QUrl>
 
 #include <Assignment.h>
+#include <DomainMembershipLog.h>
 #include <HTTPManager.h>
 #include <NodeList.h>
 
@@ -50,7 +51,8 @@ private:
                                     HifiSockAddr& localSockAddr, const QByteArray& packet, const HifiSockAddr& senderSockAddr);
     NodeSet nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes);
     void sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr& senderSockAddr,
-                              const NodeSet& nodeInterestList);
+                              const NodeSet& nodeInterestList, quint32 lastEpoch = 0,
+                              quint32 lastVersion = NO_DOMAIN_LIST_VERSION);
     
     void parseCommandLineTypeConfigs(const QStringList& argumentList, QSet<Assignment::Type>& excludedTypes);
     void readConfigFile(const QString& path, QSet<Assignment::Type>& excludedTypes);
@@ -78,6 +80,8 @@ private:
     QStringList _argumentList;
     
     QHash<QString, QJsonObject> _redeemedTokenResponses;
+    
+    DomainMembershipLog _membershipLog;
 private slots:
     void requestCreationFromDataServer();
     void processCreateResponseFromDataServer(const QJsonObject& jsonObject);
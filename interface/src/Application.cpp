@@ -35,7 +35,6 @@
 #include <QMouseEvent>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QNetworkDiskCache>
 #include <QOpenGLFramebufferObject>
 #include <QObject>
 #include <QWheelEvent>
@@ -60,6 +59,7 @@
 #include <ParticlesScriptingInterface.h>
 #include <PerfStat.h>
 #include <ResourceCache.h>
+#include <ResourceDiskCache.h>
 #include <UUID.h>
 #include <OctreeSceneStats.h>
 #include <LocalVoxelsList.h>
@@ -146,9 +146,8 @@ Application::Application(int& argc, char** argv, timeval &startup_time) :
         _sharedVoxelSystem(TREE_SCALE, DEFAULT_MAX_VOXELS_PER_SYSTEM, &_clipboard),
         _wantToKillLocalVoxels(false),
         _viewFrustum(),
-        _lastQueriedViewFrustum(),
-        _lastQueriedTime(usecTimestampNow()),
         _audioScope(256, 200, true),
+        _voxelCache("voxels"),
         _mirrorViewRect(QRect(MIRROR_VIEW_LEFT_PADDING, MIRROR_VIEW_TOP_PADDING, MIRROR_VIEW_WIDTH, MIRROR_VIEW_HEIGHT)),
         _mouseX(0),
         _mouseY(0),
@@ -286,12 +285,20 @@ Application::Application(int& argc, char** argv, timeval &startup_time) :
     billboardPacketTimer->start(AVATAR_BILLBOARD_PACKET_SEND_INTERVAL_MSECS);
 
     QString cachePath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    if (cachePath.isEmpty()) {
+        cachePath = "interfaceCache";
+    }
+    
+    // the old network cache lived right in the cache path; it's dead weight now
+    ResourceDiskCache::removeNetworkDiskCache(cachePath);
 
     _networkAccessManager = new QNetworkAccessManager(this);
-    QNetworkDiskCache* cache = new QNetworkDiskCache(_networkAccessManager);
-    cache->setCacheDirectory(!cachePath.isEmpty() ? cachePath : "interfaceCache");
+    ResourceDiskCache* cache = new ResourceDiskCache(_networkAccessManager);
+    cache->setCacheDirectory(cachePath + "/resourceCache");
     _networkAccessManager->setCache(cache);
 
+    _voxelCache.setCacheDirectory(cachePath + "/octreeCache");
+
     ResourceCache::setNetworkAccessManager(_networkAccessManager);
     ResourceCache::setRequestLimit(3);
 
@@ -309,8 +316,8 @@ Application::Application(int& argc, char** argv, timeval &startup_time) :
     // initialization continues in initializeGL when OpenGL context is ready
 
     // Tell our voxel edit sender about our known jurisdictions
-    _voxelEditSender.setVoxelServerJurisdictions(&_voxelServerJurisdictions);
-    _particleEditSender.setServerJurisdictions(&_particleServerJurisdictions);
+    _voxelEditSender.setVoxelServerJurisdictions(&_voxelServerJurisdictions, &_voxelServerJurisdictionsVersion);
+    _particleEditSender.setServerJurisdictions(&_particleServerJurisdictions, &_particleServerJurisdictionsVersion);
 
     Particle::setVoxelEditPacketSender(&_voxelEditSender);
     Particle::setParticleEditPacketSender(&_particleEditSender);
@@ -354,6 +361,8 @@ Application::~Application() {
     
     Menu::getInstance()->saveSettings();
     _rearMirrorTools->saveSettings(_settings);
+
+    _voxelCache.saveAllServers(_voxels.getTree());
     
     _sharedVoxelSystem.changeTree(new VoxelTree);
     if (_voxelImporter) {
@@ -1284,6 +1293,7 @@ void Application::removeVoxel(glm::vec3 position,
 
     // delete it locally to see the effect immediately (and in case no voxel server is present)
     _voxels.getTree()->deleteVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s);
+    _voxels.publishTreeSnapshot();
 }
 
 
@@ -1308,6 +1318,7 @@ void Application::makeVoxel(glm::vec3 position,
     _voxels.getTree()->createVoxel(voxel.x, voxel.y, voxel.z, voxel.s,
                         voxel.red, voxel.green, voxel.blue,
                         isDestructive);
+    _voxels.publishTreeSnapshot();
    }
 
 glm::vec3 Application::getMouseVoxelWorldCoordinates(const VoxelDetail& mouseVoxel) {
@@ -1915,23 +1926,15 @@ void Application::updateMyAvatar(float deltaTime) {
     // to the server.
     loadViewFrustum(_myCamera, _viewFrustum);
     
-    // Update my voxel servers with my current voxel query...
-    quint64 now = usecTimestampNow();
-    quint64 sinceLastQuery = now - _lastQueriedTime;
-    const quint64 TOO_LONG_SINCE_LAST_QUERY = 3 * USECS_PER_SECOND;
-    bool queryIsDue = sinceLastQuery > TOO_LONG_SINCE_LAST_QUERY;
-    bool viewIsDifferentEnough = !_lastQueriedViewFrustum.isVerySimilar(_viewFrustum);
-
-    // if it's been a while since our last query or the view has significantly changed then send a query, otherwise suppress it
-    if (queryIsDue || viewIsDifferentEnough) {
-        _lastQueriedTime = now;
+    // Update my voxel servers with my current voxel query, if the view or LOD has moved enough to matter
+    if (_octreeQueryManager.isQueryDue(_viewFrustum, Menu::getInstance()->getVoxelSizeScale(),
+            Menu::getInstance()->getBoundaryLevelAdjust(), usecTimestampNow())) {
         queryOctree(NodeType::VoxelServer, PacketTypeVoxelQuery, _voxelServerJurisdictions);
         queryOctree(NodeType::ParticleServer, PacketTypeParticleQuery, _particleServerJurisdictions);
-        _lastQueriedViewFrustum = _viewFrustum;
     }
 }
 
-void Application::queryOctree(NodeType_t serverType, PacketType packetType, NodeToJurisdictionMap& jurisdictions) {
+void Application::queryOctree(NodeType_t serverType, PacketType packetType, const NodeToJurisdictionMap& jurisdictions) {
 
     // if voxels are disabled, then don't send this at all...
     if (!Menu::getInstance()->isOptionChecked(MenuOption::Voxels)) {
@@ -1946,7 +1949,8 @@ void Application::queryOctree(NodeType_t serverType, PacketType packetType, Node
     _octreeQuery.setWantLowResMoving(true);
     _octreeQuery.setWantColor(true);
     _octreeQuery.setWantDelta(true);
-    _octreeQuery.setWantOcclusionCulling(false);
+    _octreeQuery.setWantOcclusionCulling(Menu::getInstance()->isOptionChecked(MenuOption::ServerOcclusionCulling));
+    _octreeQuery.setWantCoverageBuffer(true);
     _octreeQuery.setWantCompression(true);
 
     _octreeQuery.setCameraPosition(_viewFrustum.getPosition());
@@ -1961,159 +1965,119 @@ void Application::queryOctree(NodeType_t serverType, PacketType packetType, Node
 
     unsigned char queryPacket[MAX_PACKET_SIZE];
 
-    // Iterate all of the nodes, and get a count of how many voxel servers we have...
-    int totalServers = 0;
-    int inViewServers = 0;
-    int unknownJurisdictionServers = 0;
+    // gather the servers of this type and their jurisdictions, and divide the budget between them
+    QVector<SharedNodePointer> servers;
+    QVector<OctreeServerBudget> budgets;
+    NodeList* nodeList = NodeList::getInstance();
 
-    foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
+    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
         // only send to the NodeTypes that are serverType
         if (node->getActiveSocket() && node->getType() == serverType) {
-            totalServers++;
-
-            // get the server bounds for this server
-            QUuid nodeUUID = node->getUUID();
+            OctreeServerBudget budget;
+            budget.nodeUUID = node->getUUID();
 
             // if we haven't heard from this voxel server, go ahead and send it a query, so we
             // can get the jurisdiction...
-            if (jurisdictions.find(nodeUUID) == jurisdictions.end()) {
-                unknownJurisdictionServers++;
-            } else {
-                const JurisdictionMap& map = (jurisdictions)[nodeUUID];
-
-                unsigned char* rootCode = map.getRootOctalCode();
-
-                if (rootCode) {
-                    VoxelPositionSize rootDetails;
-                    voxelDetailsForCode(rootCode, rootDetails);
-                    AABox serverBounds(glm::vec3(rootDetails.x, rootDetails.y, rootDetails.z), rootDetails.s);
-                    serverBounds.scale(TREE_SCALE);
-
-                    ViewFrustum::location serverFrustumLocation = _viewFrustum.boxInFrustum(serverBounds);
-
-                    if (serverFrustumLocation != ViewFrustum::OUTSIDE) {
-                        inViewServers++;
+            NodeToJurisdictionMap::const_iterator jurisdiction = jurisdictions.find(budget.nodeUUID);
+            if (jurisdiction != jurisdictions.end()) {
+                budget.isJurisdictionKnown = true;
+                budget.hasBounds = OctreeQueryManager::getJurisdictionBounds(*jurisdiction, budget.bounds);
+                if (!budget.hasBounds) {
+                    if (wantExtraDebugging) {
+                        qDebug() << "Jurisdiction without RootCode for node " << *node << ". That's unusual!";
                     }
                 }
             }
+            servers.append(node);
+            budgets.append(budget);
         }
     }
+    OctreeQueryManager::allocateBudget(_viewFrustum, Menu::getInstance()->getMaxVoxelPacketsPerSecond(), budgets);
 
     if (wantExtraDebugging) {
-        qDebug("Servers: total %d, in view %d, unknown jurisdiction %d",
-            totalServers, inViewServers, unknownJurisdictionServers);
-    }
-
-    int perServerPPS = 0;
-    const int SMALL_BUDGET = 10;
-    int perUnknownServer = SMALL_BUDGET;
-    int totalPPS = Menu::getInstance()->getMaxVoxelPacketsPerSecond();
-
-    // determine PPS based on number of servers
-    if (inViewServers >= 1) {
-        // set our preferred PPS to be exactly evenly divided among all of the voxel servers... and allocate 1 PPS
-        // for each unknown jurisdiction server
-        perServerPPS = (totalPPS / inViewServers) - (unknownJurisdictionServers * perUnknownServer);
-    } else {
-        if (unknownJurisdictionServers > 0) {
-            perUnknownServer = (totalPPS / unknownJurisdictionServers);
+        for (int i = 0; i < budgets.size(); i++) {
+            qDebug() << "server" << budgets.at(i).nodeUUID << "known" << budgets.at(i).isJurisdictionKnown
+                << "in view" << budgets.at(i).isInView << "visible volume" << budgets.at(i).visibleVolume
+                << "PPS" << budgets.at(i).packetsPerSecond;
         }
     }
 
-    if (wantExtraDebugging) {
-        qDebug("perServerPPS: %d perUnknownServer: %d", perServerPPS, perUnknownServer);
-    }
-
-    NodeList* nodeList = NodeList::getInstance();
-
-    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-        // only send to the NodeTypes that are serverType
-        if (node->getActiveSocket() && node->getType() == serverType) {
-
+    quint64 now = usecTimestampNow();
+    for (int i = 0; i < servers.size(); i++) {
+        const SharedNodePointer& node = servers.at(i);
+        const OctreeServerBudget& budget = budgets.at(i);
+        QUuid nodeUUID = budget.nodeUUID;
+
+        // a server whose query wouldn't change, such as one out of view that's already been told to send nothing,
+        // doesn't need another
+        if (!_octreeQueryManager.isServerQueryDue(nodeUUID, node->getWakeMicrostamp(), budget.packetsPerSecond, now)) {
+            _octreeQueryManager.queryWasSkipped(nodeUUID);
+            continue;
+        }
 
-            // get the server bounds for this server
-            QUuid nodeUUID = node->getUUID();
+        _octreeQuery.setCameraPosition(_viewFrustum.getPosition());
+        _octreeQuery.setCameraOrientation(_viewFrustum.getOrientation());
+        _octreeQuery.setCameraNearClip(_viewFrustum.getNearClip());
+        _octreeQuery.setCameraFarClip(_viewFrustum.getFarClip());
+        _octreeQuery.setMaxOctreePacketsPerSecond(budget.packetsPerSecond);
 
-            bool inView = false;
-            bool unknownView = false;
+        bool usingRealView = true;
+        if (!budget.isJurisdictionKnown) {
+            if (wantExtraDebugging) {
+                qDebug() << "no known jurisdiction for node " << *node << ", give it budget of "
+                        << budget.packetsPerSecond << " to send us jurisdiction.";
+            }
 
-            // if we haven't heard from this voxel server, go ahead and send it a query, so we
-            // can get the jurisdiction...
-            if (jurisdictions.find(nodeUUID) == jurisdictions.end()) {
-                unknownView = true; // assume it's in view
+            // set the query's position/orientation to be degenerate in a manner that will get the scene quickly
+            // If there's only one server, then don't do this, and just let the normal voxel query pass through
+            // as expected... this way, we will actually get a valid scene if there is one to be seen
+            if (servers.size() > 1) {
+                _octreeQuery.setCameraPosition(glm::vec3(-0.1,-0.1,-0.1));
+                const glm::quat OFF_IN_NEGATIVE_SPACE = glm::quat(-0.5, 0, -0.5, 1.0);
+                _octreeQuery.setCameraOrientation(OFF_IN_NEGATIVE_SPACE);
+                _octreeQuery.setCameraNearClip(0.1f);
+                _octreeQuery.setCameraFarClip(0.1f);
+                usingRealView = false;
                 if (wantExtraDebugging) {
-                    qDebug() << "no known jurisdiction for node " << *node << ", assume it's visible.";
+                    qDebug() << "Using 'minimal' camera position for node" << *node;
                 }
             } else {
-                const JurisdictionMap& map = (jurisdictions)[nodeUUID];
-
-                unsigned char* rootCode = map.getRootOctalCode();
-
-                if (rootCode) {
-                    VoxelPositionSize rootDetails;
-                    voxelDetailsForCode(rootCode, rootDetails);
-                    AABox serverBounds(glm::vec3(rootDetails.x, rootDetails.y, rootDetails.z), rootDetails.s);
-                    serverBounds.scale(TREE_SCALE);
-
-                    ViewFrustum::location serverFrustumLocation = _viewFrustum.boxInFrustum(serverBounds);
-                    if (serverFrustumLocation != ViewFrustum::OUTSIDE) {
-                        inView = true;
-                    } else {
-                        inView = false;
-                    }
-                } else {
-                    if (wantExtraDebugging) {
-                        qDebug() << "Jurisdiction without RootCode for node " << *node << ". That's unusual!";
-                    }
-                }
-            }
-
-            if (inView) {
-                _octreeQuery.setMaxOctreePacketsPerSecond(perServerPPS);
-            } else if (unknownView) {
                 if (wantExtraDebugging) {
-                    qDebug() << "no known jurisdiction for node " << *node << ", give it budget of "
-                            << perUnknownServer << " to send us jurisdiction.";
+                    qDebug() << "Using regular camera position for node" << *node;
                 }
-
-                // set the query's position/orientation to be degenerate in a manner that will get the scene quickly
-                // If there's only one server, then don't do this, and just let the normal voxel query pass through
-                // as expected... this way, we will actually get a valid scene if there is one to be seen
-                if (totalServers > 1) {
-                    _octreeQuery.setCameraPosition(glm::vec3(-0.1,-0.1,-0.1));
-                    const glm::quat OFF_IN_NEGATIVE_SPACE = glm::quat(-0.5, 0, -0.5, 1.0);
-                    _octreeQuery.setCameraOrientation(OFF_IN_NEGATIVE_SPACE);
-                    _octreeQuery.setCameraNearClip(0.1f);
-                    _octreeQuery.setCameraFarClip(0.1f);
-                    if (wantExtraDebugging) {
-                        qDebug() << "Using 'minimal' camera position for node" << *node;
-                    }
-                } else {
-                    if (wantExtraDebugging) {
-                        qDebug() << "Using regular camera position for node" << *node;
-                    }
-                }
-                _octreeQuery.setMaxOctreePacketsPerSecond(perUnknownServer);
-            } else {
-                _octreeQuery.setMaxOctreePacketsPerSecond(0);
             }
-            // set up the packet for sending...
-            unsigned char* endOfQueryPacket = queryPacket;
+        }
+        // let the voxel server know which parts of the scene we still have from last time
+        if (serverType == NodeType::VoxelServer && usingRealView) {
+            float voxelSizeScale = Menu::getInstance()->getVoxelSizeScale();
+            int boundaryLevelAdjust = Menu::getInstance()->getBoundaryLevelAdjust();
+            if (_voxelCache.loadServer(nodeUUID, _voxels.getTree(), _viewFrustum, voxelSizeScale, boundaryLevelAdjust)) {
+                _voxels.forceRedrawEntireTree();
+            }
+            _voxelCache.prepareQuery(nodeUUID, _octreeQuery, _viewFrustum, voxelSizeScale, boundaryLevelAdjust);
+        } else if (serverType == NodeType::VoxelServer) {
+            _voxelCache.prepareQueryWithoutView(nodeUUID, _octreeQuery);
+        } else {
+            _octreeQuery.setSubtreeVersions(OctreeSubtreeVersions());
+        }
 
-            // insert packet type/version and node UUID
-            endOfQueryPacket += populatePacketHeader(reinterpret_cast<char*>(endOfQueryPacket), packetType);
+        // set up the packet for sending...
+        unsigned char* endOfQueryPacket = queryPacket;
 
-            // encode the query data...
-            endOfQueryPacket += _octreeQuery.getBroadcastData(endOfQueryPacket);
+        // insert packet type/version and node UUID
+        endOfQueryPacket += populatePacketHeader(reinterpret_cast<char*>(endOfQueryPacket), packetType);
 
-            int packetLength = endOfQueryPacket - queryPacket;
+        // encode the query data...
+        endOfQueryPacket += _octreeQuery.getBroadcastData(endOfQueryPacket);
 
-            // make sure we still have an active socket
-            nodeList->writeDatagram(reinterpret_cast<const char*>(queryPacket), packetLength, node);
+        int packetLength = endOfQueryPacket - queryPacket;
 
-            // Feed number of bytes to corresponding channel of the bandwidth meter
-            _bandwidthMeter.outputStream(BandwidthMeter::VOXELS).updateValue(packetLength);
-        }
+        // make sure we still have an active socket
+        nodeList->writeDatagram(reinterpret_cast<const char*>(queryPacket), packetLength, node);
+        _octreeQueryManager.queryWasSent(nodeUUID, node->getWakeMicrostamp(), budget.packetsPerSecond, packetLength, now);
+
+        // Feed number of bytes to corresponding channel of the bandwidth meter
+        _bandwidthMeter.outputStream(BandwidthMeter::VOXELS).updateValue(packetLength);
     }
 }
 
@@ -2629,11 +2593,11 @@ void Application::displayStats() {
         displayStatsBackground(backgroundColor, horizontalOffset, 0, 175, lines * STATS_PELS_PER_LINE + 10);
         horizontalOffset += 5;
 
-        char audioJitter[30];
+        char audioJitter[50];
         sprintf(audioJitter,
-                "Buffer msecs %.1f",
+                "Buffer msecs %.1f  Dropped %d",
                 (float) (_audio.getNetworkBufferLengthSamplesPerChannel() + (float) _audio.getJitterBufferSamples()) /
-                (float)_audio.getNetworkSampleRate() * 1000.f);
+                (float)_audio.getNetworkSampleRate() * 1000.f, _audio.getDroppedReceivedAudioCount());
         drawText(30, _glWidget->height() - 22, 0.10f, 0.f, 2.f, audioJitter, WHITE_TEXT);
         
                  
@@ -2667,7 +2631,7 @@ void Application::displayStats() {
 
     glm::vec3 avatarPos = _myAvatar->getPosition();
 
-    lines = _statsExpanded ? 5 : 3;
+    lines = _statsExpanded ? 7 : 3;
     displayStatsBackground(backgroundColor, horizontalOffset, 0, _glWidget->width() - (mirrorEnabled ? 301 : 411) - horizontalOffset, lines * STATS_PELS_PER_LINE + 10);
     horizontalOffset += 5;
 
@@ -2705,6 +2669,16 @@ void Application::displayStats() {
         verticalOffset += STATS_PELS_PER_LINE;
         drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, avatarMixerStats, WHITE_TEXT);
         
+        int simulatedAvatars = _avatarManager.getLastSimulatedAvatarCount();
+        char avatarSimulateStats[200];
+        sprintf(avatarSimulateStats, "Avatar simulate: %d usecs, %d avg usecs/avatar, %d max usecs/avatar",
+                (int)_avatarManager.getLastSimulateUsecs(),
+                simulatedAvatars ? (int)(_avatarManager.getLastTotalAvatarSimulateUsecs() / simulatedAvatars) : 0,
+                (int)_avatarManager.getLastMaxAvatarSimulateUsecs());
+        
+        verticalOffset += STATS_PELS_PER_LINE;
+        drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, avatarSimulateStats, WHITE_TEXT);
+        
         stringstream downloadStats;
         downloadStats << "Downloads: ";
         foreach (Resource* resource, ResourceCache::getLoadingRequests()) {
@@ -2715,12 +2689,23 @@ void Application::displayStats() {
         
         verticalOffset += STATS_PELS_PER_LINE;
         drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, downloadStats.str().c_str(), WHITE_TEXT);
+
+        int completedDownloads = ResourceCache::getCompletedRequestCount();
+        char downloadCacheStats[200];
+        const float BYTES_PER_MEGABYTE = 1024.0f * 1024.0f;
+        sprintf(downloadCacheStats, "Download cache: %d%% hits, %.1f MB saved, %.1f MB downloaded",
+                completedDownloads ? ResourceCache::getCachedRequestCount() * 100 / completedDownloads : 0,
+                ResourceCache::getBytesFromCache() / BYTES_PER_MEGABYTE,
+                ResourceCache::getBytesFromNetwork() / BYTES_PER_MEGABYTE);
+
+        verticalOffset += STATS_PELS_PER_LINE;
+        drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, downloadCacheStats, WHITE_TEXT);
     }
 
     verticalOffset = 0;
     horizontalOffset = _glWidget->width() - (mirrorEnabled ? 300 : 410);
 
-    lines = _statsExpanded ? 12 : 3;
+    lines = _statsExpanded ? 14 : 3;
     displayStatsBackground(backgroundColor, horizontalOffset, 0, _glWidget->width() - horizontalOffset, lines * STATS_PELS_PER_LINE + 10);
     horizontalOffset += 5;
 
@@ -2813,6 +2798,32 @@ void Application::displayStats() {
         drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, (char*)voxelStats.str().c_str(), WHITE_TEXT);
     }
 
+    // Outgoing queries, and the ones that weren't needed
+    if (_statsExpanded) {
+        voxelStats.str("");
+        voxelStats << "Octree queries: " << _octreeQueryManager.getSentPacketsPerSecond() << " pps, "
+            << _octreeQueryManager.getSentBytesPerSecond() << " bytes/sec  Saved: "
+            << _octreeQueryManager.getSavedPacketsPerSecond() << " pps, "
+            << _octreeQueryManager.getSavedBytesPerSecond() << " bytes/sec";
+        verticalOffset += STATS_PELS_PER_LINE;
+        drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, (char*)voxelStats.str().c_str(), WHITE_TEXT);
+
+        // Outgoing edits, with the rate sent to each server over what its link currently allows
+        voxelStats.str("");
+        voxelStats << "Edits:";
+        QVector<DestinationRate> editRates = _voxelEditSender.getDestinationRates() +
+            _particleEditSender.getDestinationRates();
+        if (editRates.isEmpty()) {
+            voxelStats << " none";
+        }
+        foreach (const DestinationRate& rate, editRates) {
+            voxelStats << " " << rate.nodeType << ":" << qPrintable(uuidStringWithoutCurlyBraces(rate.uuid).left(4)) << " "
+                << (int)rate.packetsPerSecond << "/" << (int)rate.targetPacketsPerSecond << " pps";
+        }
+        verticalOffset += STATS_PELS_PER_LINE;
+        drawText(horizontalOffset, verticalOffset, 0.10f, 0.f, 2.f, (char*)voxelStats.str().c_str(), WHITE_TEXT);
+    }
+
     if (_resetRecentMaxPacketsSoon && voxelPacketsToProcess > 0) {
         _recentMaxPackets = 0;
         _resetRecentMaxPacketsSoon = false;
@@ -2924,7 +2935,7 @@ void Application::checkStatsClick() {
     }
 
     // top-right stats click
-    lines = _statsExpanded ? 11 : 3;
+    lines = _statsExpanded ? 14 : 3;
     statsX = _glWidget->width() - 410;
     statsHeight = lines * STATS_PELS_PER_LINE + 10;
     statsWidth = _glWidget->width() - statsX;
@@ -3214,6 +3225,7 @@ void Application::deleteVoxelAt(const VoxelDetail& voxel) {
 
         // delete it locally to see the effect immediately (and in case no voxel server is present)
         _voxels.getTree()->deleteVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s);
+        _voxels.publishTreeSnapshot();
     }
 }
 
@@ -3275,12 +3287,18 @@ void Application::domainChanged(const QString& domainHostname) {
 
     // reset our node to stats and node to jurisdiction maps... since these must be changing...
     _voxelServerJurisdictions.clear();
+    _voxelServerJurisdictionsVersion.ref();
     _octreeServerSceneStats.clear();
     _particleServerJurisdictions.clear();
+    _particleServerJurisdictionsVersion.ref();
     
     // reset the particle renderer
     _particles.clear();
 
+    // keep what we got from the old domain's voxel servers for the next time we visit
+    _voxelCache.saveAllServers(_voxels.getTree());
+    _voxelCache.forgetAllServers();
+
     // reset the voxels renderer
     _voxels.killLocalVoxels();
 }
@@ -3328,8 +3346,12 @@ void Application::nodeKilled(SharedNodePointer node) {
 
             // If the voxel server is going away, remove it from our jurisdiction map so we don't send voxels to a dead server
             _voxelServerJurisdictions.erase(_voxelServerJurisdictions.find(nodeUUID));
+            _voxelServerJurisdictionsVersion.ref();
         }
 
+        _voxelCache.saveServer(nodeUUID, _voxels.getTree());
+        _voxelCache.forgetServer(nodeUUID);
+
         // also clean up scene stats for that server
         _octreeSceneStatsLock.lockForWrite();
         if (_octreeServerSceneStats.find(nodeUUID) != _octreeServerSceneStats.end()) {
@@ -3359,6 +3381,7 @@ void Application::nodeKilled(SharedNodePointer node) {
 
             // If the voxel server is going away, remove it from our jurisdiction map so we don't send voxels to a dead server
             _particleServerJurisdictions.erase(_particleServerJurisdictions.find(nodeUUID));
+            _particleServerJurisdictionsVersion.ref();
         }
 
         // also clean up scene stats for that server
@@ -3418,10 +3441,13 @@ int Application::parseOctreeStats(const QByteArray& packet, const SharedNodePoin
 
         // see if this is the first we've heard of this node...
         NodeToJurisdictionMap* jurisdiction = NULL;
+        QAtomicInt* jurisdictionVersion = NULL;
         if (sendingNode->getType() == NodeType::VoxelServer) {
             jurisdiction = &_voxelServerJurisdictions;
+            jurisdictionVersion = &_voxelServerJurisdictionsVersion;
         } else {
             jurisdiction = &_particleServerJurisdictions;
+            jurisdictionVersion = &_particleServerJurisdictionsVersion;
         }
 
 
@@ -3445,6 +3471,12 @@ int Application::parseOctreeStats(const QByteArray& packet, const SharedNodePoin
         JurisdictionMap jurisdictionMap;
         jurisdictionMap.copyContents(temp.getJurisdictionRoot(), temp.getJurisdictionEndNodes());
         (*jurisdiction)[nodeUUID] = jurisdictionMap;
+        jurisdictionVersion->ref();
+
+        // each stats message marks the end of a scene, which may bring our cached copy of this server's voxels up to date
+        if (sendingNode->getType() == NodeType::VoxelServer) {
+            _voxelCache.sceneCompleted(nodeUUID, temp, _voxels.getTree());
+        }
     }
     return statsMessageLength;
 }
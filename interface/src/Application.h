@@ -28,7 +28,9 @@
 #include <ParticleCollisionSystem.h>
 #include <ParticleEditPacketSender.h>
 #include <ScriptEngine.h>
+#include <OctreeCache.h>
 #include <OctreeQuery.h>
+#include <OctreeQueryManager.h>
 #include <ViewFrustum.h>
 #include <VoxelEditPacketSender.h>
 
@@ -322,7 +324,7 @@ private:
     void renderLookatIndicator(glm::vec3 pointOfInterest);
 
     void updateMyAvatar(float deltaTime);
-    void queryOctree(NodeType_t serverType, PacketType packetType, NodeToJurisdictionMap& jurisdictions);
+    void queryOctree(NodeType_t serverType, PacketType packetType, const NodeToJurisdictionMap& jurisdictions);
     void loadViewFrustum(Camera& camera, ViewFrustum& viewFrustum);
 
     glm::vec3 getSunDirection();
@@ -393,13 +395,13 @@ private:
     MetavoxelSystem _metavoxels;
 
     ViewFrustum _viewFrustum; // current state of view frustum, perspective, orientation, etc.
-    ViewFrustum _lastQueriedViewFrustum; /// last view frustum used to query octree servers (voxels, particles)
     ViewFrustum _shadowViewFrustum;
-    quint64 _lastQueriedTime;
 
     Oscilloscope _audioScope;
 
     OctreeQuery _octreeQuery; // NodeData derived class for querying voxels from voxel server
+    OctreeQueryManager _octreeQueryManager; // when to query the octree servers (voxels, particles), and their budgets
+    OctreeCache _voxelCache; // voxels received from each voxel server, kept on disk for the next time we see them
 
     AvatarManager _avatarManager;
     MyAvatar* _myAvatar;            // TODO: move this and relevant code to AvatarManager (or MyAvatar as the case may be)
@@ -477,6 +479,8 @@ private:
 
     NodeToJurisdictionMap _voxelServerJurisdictions;
     NodeToJurisdictionMap _particleServerJurisdictions;
+    QAtomicInt _voxelServerJurisdictionsVersion; // bumped on every change to _voxelServerJurisdictions
+    QAtomicInt _particleServerJurisdictionsVersion; // bumped on every change to _particleServerJurisdictions
     NodeToOctreeSceneStats _octreeServerSceneStats;
     QReadWriteLock _octreeSceneStatsLock;
 
@@ -35,6 +35,9 @@ static const float AUDIO_CALLBACK_MSECS = (float) NETWORK_BUFFER_LENGTH_SAMPLES_
 
 static const int NUMBER_OF_NOISE_SAMPLE_FRAMES = 300;
 
+// over a second of mixed audio, if the audio thread falls that far behind the packets are no use anyway
+static const int RECEIVED_AUDIO_QUEUE_CAPACITY = 64;
+
 // Mute icon configration
 static const int MUTE_ICON_SIZE = 24;
 
@@ -55,6 +58,7 @@ Audio::Audio(Oscilloscope* scope, int16_t initialJitterBufferSamples, QObject* p
     _proceduralOutputDevice(NULL),
     _inputRingBuffer(0),
     _ringBuffer(NETWORK_BUFFER_LENGTH_BYTES_PER_CHANNEL),
+    _receivedAudioQueue(RECEIVED_AUDIO_QUEUE_CAPACITY),
     _scope(scope),
     _averagedLatency(0.0),
     _measuredJitter(0),
@@ -566,6 +570,20 @@ void Audio::handleAudioInput() {
     }
 }
 
+void Audio::queueReceivedAudio(QByteArray& audioByteArray) {
+    if (_receivedAudioQueue.push(audioByteArray, QWeakPointer<Node>()) && _receivedAudioQueue.shouldWakeConsumer()) {
+        QMetaObject::invokeMethod(this, "processQueuedAudio", Qt::QueuedConnection);
+    }
+}
+
+void Audio::processQueuedAudio() {
+    _receivedAudioQueue.consumerWoke();
+    for (QueuedDatagram* queued = _receivedAudioQueue.getFront(); queued; queued = _receivedAudioQueue.getFront()) {
+        addReceivedAudioToBuffer(queued->datagram);
+        _receivedAudioQueue.pop();
+    }
+}
+
 void Audio::addReceivedAudioToBuffer(const QByteArray& audioByteArray) {
     const int NUM_INITIAL_PACKETS_DISCARD = 3;
     const int STANDARD_DEVIATION_SAMPLE_COUNT = 500;
@@ -29,6 +29,7 @@
 
 #include <AbstractAudioInterface.h>
 #include <AudioRingBuffer.h>
+#include <DatagramQueue.h>
 #include <StdDev.h>
 
 #include "ui/Oscilloscope.h"
@@ -76,9 +77,17 @@ public:
     int getNetworkSampleRate() { return SAMPLE_RATE; }
     int getNetworkBufferLengthSamplesPerChannel() { return NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; }
 
+    /// Hands mixed audio from the network thread to the audio thread, leaving a spare buffer in its place.
+    /// \thread the network thread
+    void queueReceivedAudio(QByteArray& audioByteArray);
+
+    /// \return the number of received audio packets dropped because the audio thread had fallen behind
+    int getDroppedReceivedAudioCount() const { return _receivedAudioQueue.getDroppedCount(); }
+
 public slots:
     void start();
     void addReceivedAudioToBuffer(const QByteArray& audioByteArray);
+    void processQueuedAudio();
     void handleAudioInput();
     void reset();
     void toggleMute();
@@ -119,6 +128,7 @@ private:
     QIODevice* _proceduralOutputDevice;
     AudioRingBuffer _inputRingBuffer;
     AudioRingBuffer _ringBuffer;
+    DatagramQueue _receivedAudioQueue;
 
     QString _inputAudioDeviceName;
     QString _outputAudioDeviceName;
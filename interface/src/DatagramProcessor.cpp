@@ -27,6 +27,7 @@ void DatagramProcessor::processDatagrams() {
     
     HifiSockAddr senderSockAddr;
     
+    // handing a packet to the audio or avatar queue swaps this for one of the queue's spare buffers
     static QByteArray incomingPacket;
     
     Application* application = Application::getInstance();
@@ -44,8 +45,8 @@ void DatagramProcessor::processDatagrams() {
             // only process this packet if we have a match on the packet version
             switch (packetTypeForPacket(incomingPacket)) {
                 case PacketTypeMixedAudio:
-                    QMetaObject::invokeMethod(&application->_audio, "addReceivedAudioToBuffer", Qt::QueuedConnection,
-                                              Q_ARG(QByteArray, incomingPacket));
+                    // straight to the audio thread, which never waits on the main thread or anything queued behind it
+                    application->_audio.queueReceivedAudio(incomingPacket);
                     break;
                     
                 case PacketTypeParticleAddResponse:
@@ -97,16 +98,14 @@ void DatagramProcessor::processDatagrams() {
                     // update having heard from the avatar-mixer and record the bytes received
                     SharedNodePointer avatarMixer = nodeList->sendingNodeForPacket(incomingPacket);
                     
+                    application->_bandwidthMeter.inputStream(BandwidthMeter::AVATARS).updateValue(incomingPacket.size());
+                    
                     if (avatarMixer) {
                         avatarMixer->setLastHeardMicrostamp(usecTimestampNow());
                         avatarMixer->recordBytesReceived(incomingPacket.size());
                         
-                        QMetaObject::invokeMethod(&application->getAvatarManager(), "processAvatarMixerDatagram",
-                                                  Q_ARG(const QByteArray&, incomingPacket),
-                                                  Q_ARG(const QWeakPointer<Node>&, avatarMixer));
+                        application->getAvatarManager().queueAvatarMixerDatagram(incomingPacket, avatarMixer);
                     }
-                    
-                    application->_bandwidthMeter.inputStream(BandwidthMeter::AVATARS).updateValue(incomingPacket.size());
                     break;
                 }
                 default:
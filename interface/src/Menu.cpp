@@ -278,6 +278,9 @@ Menu::Menu() :
     addActionToQMenuAndActionHash(voxelOptionsMenu, MenuOption::LodTools, Qt::SHIFT | Qt::Key_L, this, SLOT(lodTools()));
     addCheckableActionToQMenuAndActionHash(voxelOptionsMenu, MenuOption::DontFadeOnVoxelServerChanges);
     addCheckableActionToQMenuAndActionHash(voxelOptionsMenu, MenuOption::DisableAutoAdjustLOD);
+    addCheckableActionToQMenuAndActionHash(voxelOptionsMenu, MenuOption::ServerOcclusionCulling);
+    addCheckableActionToQMenuAndActionHash(voxelOptionsMenu, MenuOption::ChunkedVoxelMeshes, 0, false,
+                                           appInstance->getVoxels(), SLOT(setUseChunkedMeshes(bool)));
 
     QMenu* avatarOptionsMenu = developerMenu->addMenu("Avatar Options");
 
@@ -394,6 +397,11 @@ void Menu::loadSettings(QSettings* settings) {
     _maxVoxelPacketsPerSecond = loadSetting(settings, "maxVoxelsPPS", DEFAULT_MAX_VOXEL_PPS);
     _voxelSizeScale = loadSetting(settings, "voxelSizeScale", DEFAULT_OCTREE_SIZE_SCALE);
     _boundaryLevelAdjust = loadSetting(settings, "boundaryLevelAdjust", 0);
+    _avatarSimulationLOD.setBlendshapeDistance(loadSetting(settings, "avatarBlendshapeDistance",
+        DEFAULT_AVATAR_BLENDSHAPE_DISTANCE));
+    _avatarSimulationLOD.setReducedRateDistance(loadSetting(settings, "avatarReducedRateDistance",
+        DEFAULT_AVATAR_REDUCED_RATE_DISTANCE));
+    _avatarSimulationLOD.setReducedRate(loadSetting(settings, "avatarReducedRate", DEFAULT_AVATAR_REDUCED_RATE));
 
     settings->beginGroup("View Frustum Offset Camera");
     // in case settings is corrupt or missing loadSetting() will check for NaN
@@ -433,6 +441,9 @@ void Menu::saveSettings(QSettings* settings) {
     settings->setValue("maxVoxelsPPS", _maxVoxelPacketsPerSecond);
     settings->setValue("voxelSizeScale", _voxelSizeScale);
     settings->setValue("boundaryLevelAdjust", _boundaryLevelAdjust);
+    settings->setValue("avatarBlendshapeDistance", _avatarSimulationLOD.getBlendshapeDistance());
+    settings->setValue("avatarReducedRateDistance", _avatarSimulationLOD.getReducedRateDistance());
+    settings->setValue("avatarReducedRate", _avatarSimulationLOD.getReducedRate());
     settings->beginGroup("View Frustum Offset Camera");
     settings->setValue("viewFrustumOffsetYaw", _viewFrustumOffset.yaw);
     settings->setValue("viewFrustumOffsetPitch", _viewFrustumOffset.pitch);
@@ -14,6 +14,7 @@
 #include <QKeySequence>
 #include <QPointer>
 
+#include <AvatarSimulationLOD.h>
 #include <EventTypes.h>
 #include <MenuItemProperties.h>
 #include <OctreeConstants.h>
@@ -89,6 +90,7 @@ public:
     void setVoxelSizeScale(float sizeScale);
     float getVoxelSizeScale() const { return _voxelSizeScale; }
     float getAvatarLODDistanceMultiplier() const { return _avatarLODDistanceMultiplier; }
+    AvatarSimulationLOD& getAvatarSimulationLOD() { return _avatarSimulationLOD; }
     void setBoundaryLevelAdjust(int boundaryLevelAdjust);
     int getBoundaryLevelAdjust() const { return _boundaryLevelAdjust; }
 
@@ -206,6 +208,7 @@ private:
     int _maxVoxels;
     float _voxelSizeScale;
     float _avatarLODDistanceMultiplier;
+    AvatarSimulationLOD _avatarSimulationLOD;
     int _boundaryLevelAdjust;
     QAction* _useVoxelShader;
     int _maxVoxelPacketsPerSecond;
@@ -229,6 +232,7 @@ namespace MenuOption {
     const QString BandwidthDetails = "Bandwidth Details";
     const QString BuckyBalls = "Bucky Balls";
     const QString ChatCircling = "Chat Circling";
+    const QString ChunkedVoxelMeshes = "Chunked Voxel Meshes";
     const QString Collisions = "Collisions";
     const QString CollideWithAvatars = "Collide With Avatars";
     const QString CollideWithParticles = "Collide With Particles";
@@ -292,6 +296,7 @@ namespace MenuOption {
     const QString RenderHeadCollisionProxies = "Head Collision Proxies";
     const QString ResetAvatarSize = "Reset Avatar Size";
     const QString RunTimingTests = "Run Timing Tests";
+    const QString ServerOcclusionCulling = "Server Occlusion Culling";
     const QString SettingsImport = "Import Settings";
     const QString Shadows = "Shadows";
     const QString SettingsExport = "Export Settings";
@@ -241,7 +241,7 @@ void MetavoxelClient::guide(MetavoxelVisitor& visitor) {
 
 void MetavoxelClient::applyEdit(const MetavoxelEditMessage& edit) {
     // apply immediately to local tree
-    edit.apply(_data, _sequencer.getWeakSharedObjectHash());
+    edit.apply(_data, &_sequencer.getWeakSharedObjectHash());
 
     // start sending it out
     _sequencer.sendHighPriorityMessage(QVariant::fromValue(edit));
@@ -281,7 +281,7 @@ void MetavoxelClient::readPacket(Bitstream& in) {
     // reapply local edits
     foreach (const DatagramSequencer::HighPriorityMessage& message, _sequencer.getHighPriorityMessages()) {
         if (message.data.userType() == MetavoxelEditMessage::Type) {
-            message.data.value<MetavoxelEditMessage>().apply(_data, _sequencer.getWeakSharedObjectHash());
+            message.data.value<MetavoxelEditMessage>().apply(_data, &_sequencer.getWeakSharedObjectHash());
         }
     }
 }
@@ -57,7 +57,15 @@ Avatar::Avatar() :
     _collisionFlags(0),
     _initialized(false),
     _shouldRenderBillboard(true),
-    _modelsDirty(true)
+    _modelsDirty(true),
+    _isSkeletonSimulating(false),
+    _skeletonNeedsJoints(false),
+    _lastSimulateUsecs(0),
+    _simulationTier(AvatarSimulationLOD::FULL_TIER),
+    _areJointsDue(true),
+    _lastJointsUpdate(0),
+    _isSkeletonInterpolating(false),
+    _jointInterpolation(1.0f)
 {
     // we may have been created in the network thread, but we live in the main thread
     moveToThread(Application::getInstance()->thread());
@@ -96,6 +104,14 @@ float Avatar::getLODDistance() const {
 }
 
 void Avatar::simulate(float deltaTime) {
+    if (beginSimulate(deltaTime)) {
+        simulateJoints();
+    }
+    finishSimulate(deltaTime);
+}
+
+bool Avatar::beginSimulate(float deltaTime) {
+    quint64 start = usecTimestampNow();
     if (_scale != _targetScale) {
         setScale(_targetScale);
     }
@@ -115,6 +131,27 @@ void Avatar::simulate(float deltaTime) {
     bool inViewFrustum = Application::getInstance()->getViewFrustum()->sphereInFrustum(_position, boundingRadius) !=
         ViewFrustum::OUTSIDE;
 
+    // pick the detail to simulate in; far avatars only update their joints now and then, while their bodies keep moving
+    const AvatarSimulationLOD& simulationLOD = Menu::getInstance()->getAvatarSimulationLOD();
+    _simulationTier = simulationLOD.getTier(getLODDistance(), inViewFrustum);
+    quint64 now = usecTimestampNow();
+    _areJointsDue = simulationLOD.isJointUpdateDue(_simulationTier, _lastJointsUpdate, now);
+    if (_areJointsDue) {
+        _lastJointsUpdate = now;
+    }
+    bool blendshapesEnabled = (_simulationTier == AvatarSimulationLOD::FULL_TIER);
+    _skeletonModel.setBlendshapesEnabled(blendshapesEnabled);
+    getHead()->getFaceModel().setBlendshapesEnabled(blendshapesEnabled);
+    
+    _isSkeletonSimulating = false;
+    _skeletonNeedsJoints = false;
+    _isSkeletonInterpolating = false;
+    if (_simulationTier == AvatarSimulationLOD::FROZEN_TIER) {
+        // out of view: leave the models as they are until we can see them again
+        _lastSimulateUsecs = usecTimestampNow() - start;
+        return false;
+    }
+
     getHand()->simulate(deltaTime, false);
     _skeletonModel.setLODDistance(getLODDistance());
     
@@ -123,16 +160,53 @@ void Avatar::simulate(float deltaTime) {
         const JointData& data = _jointData.at(i);
         _skeletonModel.setJointState(i, data.valid, data.rotation);
     }
+    _isSkeletonSimulating = !_shouldRenderBillboard;
+    if (_isSkeletonSimulating) {
+        // reduced rate joints blend from one update to the next; leaving the tier part way there, finish at once
+        bool reducedRate = (_simulationTier == AvatarSimulationLOD::REDUCED_RATE_TIER);
+        if (!reducedRate && _skeletonModel.isInterpolatingJoints()) {
+            _modelsDirty = true;
+        }
+        _skeletonModel.setInterpolatingJoints(reducedRate);
+        
+        // keep the models dirty until the joints are due, so that a reduced rate update doesn't miss the latest data
+        bool fullUpdate = _modelsDirty && _areJointsDue;
+        _skeletonNeedsJoints = _skeletonModel.beginSimulate(fullUpdate);
+        if (fullUpdate) {
+            _modelsDirty = false;
+        }
+        _jointInterpolation = simulationLOD.getJointInterpolation(_lastJointsUpdate, now);
+        _isSkeletonInterpolating = !_skeletonNeedsJoints && _skeletonModel.isInterpolatingJoints();
+    }
+    _lastSimulateUsecs = usecTimestampNow() - start;
+    return _skeletonNeedsJoints || _isSkeletonInterpolating;
+}
+
+void Avatar::simulateJoints() {
+    quint64 start = usecTimestampNow();
+    if (_skeletonNeedsJoints) {
+        _skeletonModel.simulateJoints();
+    } else if (_isSkeletonInterpolating) {
+        _skeletonModel.interpolateJoints(_jointInterpolation);
+    }
+    _lastSimulateUsecs += usecTimestampNow() - start;
+}
+
+void Avatar::finishSimulate(float deltaTime) {
+    quint64 start = usecTimestampNow();
     glm::vec3 headPosition = _position;
-    if (!_shouldRenderBillboard && inViewFrustum) {
-        _skeletonModel.simulate(deltaTime, _modelsDirty);
-        _modelsDirty = false;
+    if (_skeletonNeedsJoints || _isSkeletonInterpolating) {
+        _skeletonModel.finishSimulate(deltaTime);
+    }
+    if (_isSkeletonSimulating) {
         _skeletonModel.getHeadPosition(headPosition);
     }
     Head* head = getHead();
     head->setPosition(headPosition);
     head->setScale(_scale);
-    head->simulate(deltaTime, false, _shouldRenderBillboard);
+    if (_simulationTier != AvatarSimulationLOD::FROZEN_TIER) {
+        head->simulate(deltaTime, false, _shouldRenderBillboard, _areJointsDue);
+    }
     
     // use speed and angular velocity to determine walking vs. standing
     if (_speed + fabs(_bodyYawDelta) > 0.2) {
@@ -163,6 +237,7 @@ void Avatar::simulate(float deltaTime) {
         }
         _displayNameAlpha = abs(_displayNameAlpha - _displayNameTargetAlpha) < 0.01? _displayNameTargetAlpha : _displayNameAlpha;
     }
+    _lastSimulateUsecs += usecTimestampNow() - start;
 }
 
 void Avatar::setMouseRay(const glm::vec3 &origin, const glm::vec3 &direction) {
@@ -15,6 +15,7 @@
 #include <QtCore/QUuid>
 
 #include <AvatarData.h>
+#include <AvatarSimulationLOD.h>
 
 #include "Hand.h"
 #include "Head.h"
@@ -75,6 +76,19 @@ public:
     void init();
     void simulate(float deltaTime);
     
+    /// The parts of simulate, for AvatarManager to fan the skeletons of many avatars out across worker threads.  The
+    /// beginning and end run on the main thread; simulateJoints only touches this avatar's skeleton and may run anywhere.
+    /// \return whether simulateJoints needs calling before finishSimulate
+    bool beginSimulate(float deltaTime);
+    void simulateJoints();
+    void finishSimulate(float deltaTime);
+    
+    /// Returns the time spent in the last simulation, across all its parts and threads.
+    quint64 getLastSimulateUsecs() const { return _lastSimulateUsecs; }
+    
+    /// Returns the detail in which the avatar was last simulated.
+    AvatarSimulationLOD::Tier getSimulationTier() const { return _simulationTier; }
+    
     enum RenderMode { NORMAL_RENDER_MODE, SHADOW_RENDER_MODE, MIRROR_RENDER_MODE };
     
     virtual void render(const glm::vec3& cameraPosition, RenderMode renderMode = NORMAL_RENDER_MODE);
@@ -193,6 +207,14 @@ private:
     QScopedPointer<Texture> _billboardTexture;
     bool _shouldRenderBillboard;
     bool _modelsDirty;
+    bool _isSkeletonSimulating;
+    bool _skeletonNeedsJoints;
+    quint64 _lastSimulateUsecs;
+    AvatarSimulationLOD::Tier _simulationTier;
+    bool _areJointsDue;
+    quint64 _lastJointsUpdate;
+    bool _isSkeletonInterpolating;
+    float _jointInterpolation;
 
     void renderBillboard();
     
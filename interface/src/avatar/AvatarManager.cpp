@@ -5,12 +5,14 @@
 //  Created by Stephen Birarda on 1/23/2014.
 //  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
 //
+#include <cstring>
 #include <string>
 
 #include <glm/gtx/string_cast.hpp>
 
 #include <PerfStat.h>
 #include <UUID.h>
+#include <WorkStealingPool.h>
 
 #include "Application.h"
 #include "Avatar.h"
@@ -22,8 +24,27 @@
 // We add _myAvatar into the hash with all the other AvatarData, and we use the default NULL QUid as the key.
 const QUuid MY_AVATAR_KEY;  // NULL key
 
+// a few frames of datagrams from a busy mixer, past which they spill over into queued calls
+const int MIXER_DATAGRAM_QUEUE_CAPACITY = 256;
+
+/// Updates the skeleton joints of one avatar on a worker thread.
+class AvatarJointsTask : public WorkStealingTask {
+public:
+    AvatarJointsTask() : avatar(NULL) { }
+
+    virtual void run() { avatar->simulateJoints(); }
+
+    Avatar* avatar;
+};
+
 AvatarManager::AvatarManager(QObject* parent) :
-    _avatarFades() {
+    _avatarFades(),
+    _mixerDatagrams(MIXER_DATAGRAM_QUEUE_CAPACITY),
+    _lastSimulateUsecs(0),
+    _lastSimulatedAvatarCount(0),
+    _lastTotalAvatarSimulateUsecs(0),
+    _lastMaxAvatarSimulateUsecs(0) {
+    memset(_lastTierCounts, 0, sizeof(_lastTierCounts));
     // register a meta type for the weak pointer we'll use for the owning avatar mixer for each avatar
     qRegisterMetaType<QWeakPointer<Node> >("NodeWeakPointer");
     _myAvatar = QSharedPointer<MyAvatar>(new MyAvatar());
@@ -44,7 +65,10 @@ void AvatarManager::updateOtherAvatars(float deltaTime) {
     glm::vec3 mouseOrigin = applicationInstance->getMouseRayOrigin();
     glm::vec3 mouseDirection = applicationInstance->getMouseRayDirection();
 
-    // simulate avatars
+    // begin simulating avatars here, since that may load models and touch GL
+    quint64 start = usecTimestampNow();
+    _simulatingAvatars.clear();
+    QVector<AvatarJointsTask> tasks;
     AvatarHash::iterator avatarIterator = _avatarHash.begin();
     while (avatarIterator != _avatarHash.end()) {
         Avatar* avatar = static_cast<Avatar*>(avatarIterator.value().data());
@@ -56,8 +80,11 @@ void AvatarManager::updateOtherAvatars(float deltaTime) {
         }
         if (avatar->getOwningAvatarMixer()) {
             // this avatar's mixer is still around, go ahead and simulate it
-            avatar->simulate(deltaTime);
-            avatar->setMouseRay(mouseOrigin, mouseDirection);
+            _simulatingAvatars.append(avatar);
+            if (avatar->beginSimulate(deltaTime)) {
+                tasks.resize(tasks.size() + 1);
+                tasks.last().avatar = avatar;
+            }
             ++avatarIterator;
         } else {
             // the mixer that owned this avatar is gone, give it to the vector of fades and kill it
@@ -65,6 +92,37 @@ void AvatarManager::updateOtherAvatars(float deltaTime) {
         }
     }
     
+    // fan the skeletons out across the pool; each task only touches its own avatar's joints, and we join before
+    // anything else reads them
+    if (tasks.size() == 1) {
+        tasks[0].run();
+        
+    } else if (!tasks.isEmpty()) {
+        WorkStealingPool* pool = WorkStealingPool::getInstance();
+        WorkStealingGroup group;
+        for (int i = 0; i < tasks.size(); i++) {
+            pool->start(&tasks[i], group);
+        }
+        pool->wait(group);
+    }
+    
+    // finish here, where the faces load and simulate and the blenders are posted
+    quint64 totalAvatarUsecs = 0;
+    quint64 maxAvatarUsecs = 0;
+    memset(_lastTierCounts, 0, sizeof(_lastTierCounts));
+    foreach (Avatar* avatar, _simulatingAvatars) {
+        avatar->finishSimulate(deltaTime);
+        avatar->setMouseRay(mouseOrigin, mouseDirection);
+        _lastTierCounts[avatar->getSimulationTier()]++;
+        
+        totalAvatarUsecs += avatar->getLastSimulateUsecs();
+        maxAvatarUsecs = qMax(maxAvatarUsecs, avatar->getLastSimulateUsecs());
+    }
+    _lastSimulateUsecs = usecTimestampNow() - start;
+    _lastSimulatedAvatarCount = _simulatingAvatars.size();
+    _lastTotalAvatarSimulateUsecs = totalAvatarUsecs;
+    _lastMaxAvatarSimulateUsecs = maxAvatarUsecs;
+    
     // simulate avatar fades
     simulateAvatarFades(deltaTime);
 }
@@ -141,6 +199,31 @@ AvatarSharedPointer AvatarManager::matchingOrNewAvatar(const QUuid& nodeUUID, co
     return matchingAvatar;
 }
 
+void AvatarManager::queueAvatarMixerDatagram(QByteArray& datagram, const QWeakPointer<Node>& mixerWeakPointer) {
+    // identities and kills mustn't be lost or overtaken, so a full ring spills rather than drops
+    _mixerDatagrams.pushOrSpill(datagram, mixerWeakPointer);
+    if (_mixerDatagrams.shouldWakeConsumer()) {
+        QMetaObject::invokeMethod(this, "processQueuedAvatarMixerDatagrams", Qt::QueuedConnection);
+    }
+}
+
+void AvatarManager::processQueuedAvatarMixerDatagrams() {
+    _mixerDatagrams.consumerWoke();
+    QList<QueuedDatagram> spilled;
+    while (true) {
+        for (QueuedDatagram* queued = _mixerDatagrams.getFront(); queued; queued = _mixerDatagrams.getFront()) {
+            processAvatarMixerDatagram(queued->datagram, queued->sendingNode);
+            _mixerDatagrams.pop();
+        }
+        if (!_mixerDatagrams.takeSpilled(spilled)) {
+            break;
+        }
+        foreach (const QueuedDatagram& queued, spilled) {
+            processAvatarMixerDatagram(queued.datagram, queued.sendingNode);
+        }
+    }
+}
+
 void AvatarManager::processAvatarMixerDatagram(const QByteArray& datagram, const QWeakPointer<Node>& mixerWeakPointer) {
     switch (packetTypeForPacket(datagram)) {
         case PacketTypeBulkAvatarData:
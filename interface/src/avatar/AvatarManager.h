@@ -14,6 +14,7 @@
 #include <QtCore/QSharedPointer>
 
 #include <AvatarHashMap.h>
+#include <DatagramQueue.h>
 
 #include "Avatar.h"
 
@@ -32,9 +33,26 @@ public:
     void renderAvatars(Avatar::RenderMode renderMode, bool selfAvatarOnly = false);
     
     void clearOtherAvatars();
+    
+    /// Returns the wall clock time of the last update of the other avatars.
+    quint64 getLastSimulateUsecs() const { return _lastSimulateUsecs; }
+    
+    int getLastSimulatedAvatarCount() const { return _lastSimulatedAvatarCount; }
+    
+    /// Returns the sum of the last simulation times of each avatar, which exceeds the wall clock time when they overlap.
+    quint64 getLastTotalAvatarSimulateUsecs() const { return _lastTotalAvatarSimulateUsecs; }
+    
+    quint64 getLastMaxAvatarSimulateUsecs() const { return _lastMaxAvatarSimulateUsecs; }
+    
+    /// Returns the number of avatars simulated in the given detail in the last update.
+    int getLastTierCount(AvatarSimulationLOD::Tier tier) const { return _lastTierCounts[tier]; }
+
+    /// Network thread only: hands an avatar mixer datagram to the main thread, taking its buffer and leaving a spare.
+    void queueAvatarMixerDatagram(QByteArray& datagram, const QWeakPointer<Node>& mixerWeakPointer);
 
 public slots:
     void processAvatarMixerDatagram(const QByteArray& datagram, const QWeakPointer<Node>& mixerWeakPointer);
+    void processQueuedAvatarMixerDatagrams();
     
 private:
     AvatarManager(const AvatarManager& other);
@@ -54,6 +72,15 @@ private:
     
     QVector<AvatarSharedPointer> _avatarFades;
     QSharedPointer<MyAvatar> _myAvatar;
+
+    DatagramQueue _mixerDatagrams;
+    
+    QVector<Avatar*> _simulatingAvatars;
+    quint64 _lastSimulateUsecs;
+    int _lastSimulatedAvatarCount;
+    quint64 _lastTotalAvatarSimulateUsecs;
+    quint64 _lastMaxAvatarSimulateUsecs;
+    int _lastTierCounts[AvatarSimulationLOD::TIER_COUNT];
 };
 
 #endif /* defined(__hifi__AvatarManager__) */
@@ -18,7 +18,7 @@ FaceModel::FaceModel(Head* owningHead) :
 {
 }
 
-void FaceModel::simulate(float deltaTime) {
+void FaceModel::simulate(float deltaTime, bool fullUpdate) {
     QVector<JointState> newJointStates = updateGeometry();
     if (!isActive()) {
         return;
@@ -42,7 +42,7 @@ void FaceModel::simulate(float deltaTime) {
     setPupilDilation(_owningHead->getPupilDilation());
     setBlendshapeCoefficients(_owningHead->getBlendshapeCoefficients());
     
-    Model::simulate(deltaTime, true, newJointStates);
+    Model::simulate(deltaTime, fullUpdate, newJointStates);
 }
 
 void FaceModel::maybeUpdateNeckRotation(const JointState& parentState, const FBXJoint& joint, JointState& state) {
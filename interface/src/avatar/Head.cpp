@@ -57,7 +57,7 @@ void Head::reset() {
     _faceModel.reset();
 }
 
-void Head::simulate(float deltaTime, bool isMine, bool billboard) {
+void Head::simulate(float deltaTime, bool isMine, bool billboard, bool updateFaceJoints) {
     //  Update audio trailing average for rendering facial animations
     Faceshift* faceshift = Application::getInstance()->getFaceshift();
     Visage* visage = Application::getInstance()->getVisage();
@@ -160,7 +160,7 @@ void Head::simulate(float deltaTime, bool isMine, bool billboard) {
     }
     _leftEyePosition = _rightEyePosition = getPosition();
     if (!billboard) {
-        _faceModel.simulate(deltaTime);
+        _faceModel.simulate(deltaTime, updateFaceJoints);
         _faceModel.getEyePositions(_leftEyePosition, _rightEyePosition);
     }
     _eyePosition = calculateAverageEyePosition();
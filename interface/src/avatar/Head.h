@@ -36,7 +36,8 @@ public:
     
     void init();
     void reset();
-    void simulate(float deltaTime, bool isMine, bool billboard = false);
+    /// \param updateFaceJoints whether to update the face model's joints, which far avatars only do at a reduced rate
+    void simulate(float deltaTime, bool isMine, bool billboard = false, bool updateFaceJoints = true);
     void render(float alpha, bool forShadowMap);
     void setScale(float scale);
     void setPosition(glm::vec3 position) { _position = position; }
@@ -17,6 +17,7 @@
 
 #include <AccountManager.h>
 #include <NodeList.h>
+#include <OctreeSnapshot.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
 
@@ -767,9 +768,14 @@ void MyAvatar::updateCollisionWithVoxels(float deltaTime, float radius) {
     const float VOXEL_COLLISION_FREQUENCY = 0.5f;
     glm::vec3 penetration;
     float pelvisFloatingHeight = getPelvisFloatingHeight();
-    if (Application::getInstance()->getVoxelTree()->findCapsulePenetration(
-            _position - glm::vec3(0.0f, pelvisFloatingHeight - radius, 0.0f),
-            _position + glm::vec3(0.0f, getSkeletonHeight() - pelvisFloatingHeight + radius, 0.0f), radius, penetration)) {
+    glm::vec3 start = _position - glm::vec3(0.0f, pelvisFloatingHeight - radius, 0.0f);
+    glm::vec3 end = _position + glm::vec3(0.0f, getSkeletonHeight() - pelvisFloatingHeight + radius, 0.0f);
+
+    // until the first snapshot is published, ask the tree itself
+    VoxelTree* tree = Application::getInstance()->getVoxelTree();
+    QSharedPointer<const OctreeSnapshot> voxels = tree->getSnapshot();
+    if (voxels ? voxels->findCapsulePenetration(start, end, radius, penetration) :
+            tree->findCapsulePenetration(start, end, radius, penetration)) {
         _lastCollisionPosition = _position;
         updateCollisionSound(penetration, deltaTime, VOXEL_COLLISION_FREQUENCY);
         applyHardCollision(penetration, VOXEL_ELASTICITY, VOXEL_DAMPING);
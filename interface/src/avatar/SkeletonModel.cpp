@@ -19,12 +19,10 @@ SkeletonModel::SkeletonModel(Avatar* owningAvatar) :
 }
 
 void SkeletonModel::simulate(float deltaTime, bool fullUpdate) {
-    setTranslation(_owningAvatar->getPosition());
-    setRotation(_owningAvatar->getOrientation() * glm::angleAxis(PI, glm::vec3(0.0f, 1.0f, 0.0f)));
-    const float MODEL_SCALE = 0.0006f;
-    setScale(glm::vec3(1.0f, 1.0f, 1.0f) * _owningAvatar->getScale() * MODEL_SCALE);
-    
-    Model::simulate(deltaTime, fullUpdate);
+    if (beginSimulate(fullUpdate)) {
+        simulateJoints();
+        finishSimulate(deltaTime);
+    }
     
     if (!(isActive() && _owningAvatar->isMyAvatar())) {
         return; // only simulate for own avatar
@@ -62,6 +60,15 @@ void SkeletonModel::simulate(float deltaTime, bool fullUpdate) {
     }
 }
 
+bool SkeletonModel::beginSimulate(bool fullUpdate) {
+    setTranslation(_owningAvatar->getPosition());
+    setRotation(_owningAvatar->getOrientation() * glm::angleAxis(PI, glm::vec3(0.0f, 1.0f, 0.0f)));
+    const float MODEL_SCALE = 0.0006f;
+    setScale(glm::vec3(1.0f, 1.0f, 1.0f) * _owningAvatar->getScale() * MODEL_SCALE);
+    
+    return Model::beginSimulate(fullUpdate);
+}
+
 void SkeletonModel::getHandShapes(int jointIndex, QVector<const Shape*>& shapes) const {
     if (jointIndex < 0 || jointIndex >= int(_shapes.size())) {
         return;
@@ -23,6 +23,10 @@ public:
     SkeletonModel(Avatar* owningAvatar);
     
     void simulate(float deltaTime, bool fullUpdate = true);
+    
+    /// Places the model on its avatar, then begins simulating as Model::beginSimulate does.  Used for other avatars, whose
+    /// hands follow their joint data rather than the palms that simulate applies.
+    bool beginSimulate(bool fullUpdate = true);
 
     /// \param jointIndex index of hand joint
     /// \param shapes[out] list in which is stored pointers to hand shapes
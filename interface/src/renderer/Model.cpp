@@ -32,8 +32,11 @@ Model::Model(QObject* parent) :
     QObject(parent),
     _scale(1.0f, 1.0f, 1.0f),
     _shapesAreDirty(true),
+    _interpolatingJoints(false),
+    _jointInterpolation(1.0f),
     _lodDistance(0.0f),
     _pupilDilation(0.0f),
+    _blendshapesEnabled(true),
     _boundingRadius(0.f) {
     // we may have been created in the network thread, but we live in the main thread
     moveToThread(Application::getInstance()->thread());
@@ -198,6 +201,10 @@ void Model::simulate(float deltaTime, bool fullUpdate) {
     simulate(deltaTime, fullUpdate, updateGeometry());
 }
 
+bool Model::beginSimulate(bool fullUpdate) {
+    return beginSimulate(fullUpdate, updateGeometry());
+}
+
 bool Model::render(float alpha, bool forShadowMap) {
     // render the attachments
     foreach (Model* attachment, _attachments) {
@@ -552,8 +559,15 @@ void Blender::run() {
 }
 
 void Model::simulate(float deltaTime, bool fullUpdate, const QVector<JointState>& newJointStates) {
+    if (beginSimulate(fullUpdate, newJointStates)) {
+        simulateJoints();
+        finishSimulate(deltaTime);
+    }
+}
+
+bool Model::beginSimulate(bool fullUpdate, const QVector<JointState>& newJointStates) {
     if (!isActive()) {
-        return;
+        return false;
     }
     
     // set up world vertices on first simulate after load
@@ -588,17 +602,74 @@ void Model::simulate(float deltaTime, bool fullUpdate, const QVector<JointState>
         createCollisionShapes();
     }
     
-    // exit early if we don't have to perform a full update
-    if (!fullUpdate) {
-        return;
-    }
-    
+    // only a full update goes on to the joints
+    return fullUpdate;
+}
+
+void Model::simulateJoints() {
     // update the world space transforms for all joints
     for (int i = 0; i < _jointStates.size(); i++) {
         updateJointState(i);
     }
     
+    if (!_interpolatingJoints) {
+        updateClusterMatrices();
+        return;
+    }
+    // start from where the joints are shown, unless they've only just been created
+    bool interpolating = (_jointInterpolations.size() == _jointStates.size());
+    _jointInterpolations.resize(_jointStates.size());
+    for (int i = 0; i < _jointStates.size(); i++) {
+        JointInterpolation& interpolation = _jointInterpolations[i];
+        const JointState& state = _jointStates.at(i);
+        if (interpolating) {
+            interpolation.previousRotation = safeMix(interpolation.previousRotation, interpolation.latestRotation,
+                _jointInterpolation);
+            interpolation.previousTranslation = glm::mix(interpolation.previousTranslation,
+                interpolation.latestTranslation, _jointInterpolation);
+        } else {
+            interpolation.previousRotation = state.rotation;
+            interpolation.previousTranslation = state.translation;
+        }
+        interpolation.latestRotation = state.rotation;
+        interpolation.latestTranslation = state.translation;
+    }
+    interpolateJoints(interpolating ? 0.0f : 1.0f);
+}
+
+void Model::interpolateJoints(float proportion) {
+    if (_jointInterpolations.size() != _jointStates.size()) {
+        return;
+    }
+    // blend each joint relative to its parent, then walk the chain so the bones stay rigid
+    _jointInterpolation = proportion;
+    for (int i = 0; i < _jointStates.size(); i++) {
+        const JointInterpolation& interpolation = _jointInterpolations.at(i);
+        JointState& state = _jointStates[i];
+        state.rotation = safeMix(interpolation.previousRotation, interpolation.latestRotation, proportion);
+        state.translation = glm::mix(interpolation.previousTranslation, interpolation.latestTranslation, proportion);
+    }
+    for (int i = 0; i < _jointStates.size(); i++) {
+        updateJointState(i);
+    }
+    updateClusterMatrices();
+}
+
+void Model::updateClusterMatrices() {
+    const FBXGeometry& geometry = _geometry->getFBXGeometry();
+    for (int i = 0; i < _meshStates.size(); i++) {
+        MeshState& state = _meshStates[i];
+        const FBXMesh& mesh = geometry.meshes.at(i);
+        for (int j = 0; j < mesh.clusters.size(); j++) {
+            const FBXCluster& cluster = mesh.clusters.at(j);
+            state.clusterMatrices[j] = _jointStates[cluster.jointIndex].transform * cluster.inverseBindMatrix;
+        }
+    }
+}
+
+void Model::finishSimulate(float deltaTime) {
     // update the attachment transforms and simulate them
+    const FBXGeometry& geometry = _geometry->getFBXGeometry();
     for (int i = 0; i < _attachments.size(); i++) {
         const FBXAttachment& attachment = geometry.attachments.at(i);
         Model* model = _attachments.at(i);
@@ -615,17 +686,8 @@ void Model::simulate(float deltaTime, bool fullUpdate, const QVector<JointState>
         model->simulate(deltaTime);
     }
     
-    for (int i = 0; i < _meshStates.size(); i++) {
-        MeshState& state = _meshStates[i];
-        const FBXMesh& mesh = geometry.meshes.at(i);
-        for (int j = 0; j < mesh.clusters.size(); j++) {
-            const FBXCluster& cluster = mesh.clusters.at(j);
-            state.clusterMatrices[j] = _jointStates[cluster.jointIndex].transform * cluster.inverseBindMatrix;
-        }
-    }
-    
     // post the blender
-    if (geometry.hasBlendedMeshes()) {
+    if (geometry.hasBlendedMeshes() && _blendshapesEnabled) {
         QThreadPool::globalInstance()->start(new Blender(this, _geometry, geometry.meshes, _blendshapeCoefficients));
     }
 }
@@ -46,6 +46,10 @@ public:
     void setBlendshapeCoefficients(const QVector<float>& coefficients) { _blendshapeCoefficients = coefficients; }
     const QVector<float>& getBlendshapeCoefficients() const { return _blendshapeCoefficients; }
     
+    /// Sets whether simulating blends the meshes' blendshapes.  When disabled, the meshes keep their last blend.
+    void setBlendshapesEnabled(bool enabled) { _blendshapesEnabled = enabled; }
+    bool areBlendshapesEnabled() const { return _blendshapesEnabled; }
+    
     bool isActive() const { return _geometry && _geometry->isLoaded(); }
     
     bool isRenderable() const { return !_meshStates.isEmpty(); }
@@ -58,6 +62,27 @@ public:
     void createCollisionShapes();
     void updateShapePositions();
     void simulate(float deltaTime, bool fullUpdate = true);
+    
+    /// The parts of simulate, for callers that simulate many models at once.  The beginning and end load geometry, touch
+    /// GL and post blenders, so they run on the main thread; in between, simulateJoints only updates the model's own joint
+    /// and mesh state and may run on a worker thread, alongside other models' joints.
+    /// \return whether the joints need updating, in which case simulateJoints and then finishSimulate must follow
+    bool beginSimulate(bool fullUpdate = true);
+    void simulateJoints();
+    void finishSimulate(float deltaTime);
+    
+    /// Sets whether simulateJoints blends toward the joints it computes rather than jumping to them, for models whose
+    /// joints update at a reduced rate.  Each update starts from wherever the joints were, and interpolateJoints moves
+    /// them the rest of the way between updates.
+    void setInterpolatingJoints(bool interpolating) { _interpolatingJoints = interpolating; }
+    
+    /// Returns whether the joints are still on their way to those of the last update.
+    bool isInterpolatingJoints() const { return _interpolatingJoints && _jointInterpolation < 1.0f; }
+    
+    /// Places the joints the given proportion of the way from where they were at the last update to where it put them,
+    /// along with the mesh state that follows them.  Like simulateJoints, it may run on a worker thread.
+    void interpolateJoints(float proportion);
+    
     bool render(float alpha = 1.0f, bool forShadowMap = false);
     
     /// Sets the URL of the model to render.
@@ -212,8 +237,24 @@ protected:
     
     QVector<MeshState> _meshStates;
     
+    class JointInterpolation {
+    public:
+        glm::quat previousRotation;     // rotation relative to parent, as shown when the last update began
+        glm::quat latestRotation;       // rotation relative to parent, as computed by the last update
+        glm::vec3 previousTranslation;
+        glm::vec3 latestTranslation;
+    };
+    
+    bool _interpolatingJoints;
+    float _jointInterpolation;
+    QVector<JointInterpolation> _jointInterpolations;
+    
     QVector<JointState> updateGeometry();
+    
+    /// Updates the mesh clusters to follow the joints.
+    void updateClusterMatrices();
     void simulate(float deltaTime, bool fullUpdate, const QVector<JointState>& newJointStates);
+    bool beginSimulate(bool fullUpdate, const QVector<JointState>& newJointStates);
     
     /// Updates the state of the joint at the specified index.
     virtual void updateJointState(int index);
@@ -258,6 +299,7 @@ private:
     
     float _pupilDilation;
     QVector<float> _blendshapeCoefficients;
+    bool _blendshapesEnabled;
     
     QUrl _url;
         
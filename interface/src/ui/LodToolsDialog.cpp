@@ -14,12 +14,19 @@
 #include <QSlider>
 #include <QPushButton>
 #include <QString>
+#include <QTimer>
 
 #include <VoxelConstants.h>
 
+#include "Application.h"
 #include "Menu.h"
 #include "ui/LodToolsDialog.h"
 
+const int MAX_AVATAR_LOD_DISTANCE = 50;
+const int MAX_AVATAR_REDUCED_RATE = 60;
+const int AVATAR_LOD_TICK_INTERVAL = 5;
+const int AVATAR_FEEDBACK_INTERVAL_MSECS = 1000;
+
 
 LodToolsDialog::LodToolsDialog(QWidget* parent) :
     QDialog(parent, Qt::Window | Qt::WindowCloseButtonHint | Qt::WindowStaysOnTopHint) 
@@ -73,6 +80,47 @@ LodToolsDialog::LodToolsDialog(QWidget* parent) :
     _feedback->setFixedWidth(FEEDBACK_WIDTH);
     form->addRow("You can see... ", _feedback);
     
+    // avatar simulation detail, whose distances are in meters before the avatar LOD multiplier
+    const AvatarSimulationLOD& simulationLOD = Menu::getInstance()->getAvatarSimulationLOD();
+    _avatarBlendshapeDistance = new QSlider(Qt::Horizontal);
+    _avatarBlendshapeDistance->setRange(0, MAX_AVATAR_LOD_DISTANCE);
+    _avatarBlendshapeDistance->setTickInterval(AVATAR_LOD_TICK_INTERVAL);
+    _avatarBlendshapeDistance->setTickPosition(QSlider::TicksBelow);
+    _avatarBlendshapeDistance->setFixedWidth(SLIDER_WIDTH);
+    _avatarBlendshapeDistance->setValue(simulationLOD.getBlendshapeDistance());
+    form->addRow("Avatar Blendshape Distance:", _avatarBlendshapeDistance);
+    connect(_avatarBlendshapeDistance, SIGNAL(valueChanged(int)), this, SLOT(avatarBlendshapeDistanceValueChanged(int)));
+    
+    _avatarReducedRateDistance = new QSlider(Qt::Horizontal);
+    _avatarReducedRateDistance->setRange(0, MAX_AVATAR_LOD_DISTANCE);
+    _avatarReducedRateDistance->setTickInterval(AVATAR_LOD_TICK_INTERVAL);
+    _avatarReducedRateDistance->setTickPosition(QSlider::TicksBelow);
+    _avatarReducedRateDistance->setFixedWidth(SLIDER_WIDTH);
+    _avatarReducedRateDistance->setValue(simulationLOD.getReducedRateDistance());
+    form->addRow("Avatar Reduced Rate Distance:", _avatarReducedRateDistance);
+    connect(_avatarReducedRateDistance, SIGNAL(valueChanged(int)), this,
+        SLOT(avatarReducedRateDistanceValueChanged(int)));
+    
+    _avatarReducedRate = new QSlider(Qt::Horizontal);
+    _avatarReducedRate->setRange(0, MAX_AVATAR_REDUCED_RATE);
+    _avatarReducedRate->setTickInterval(AVATAR_LOD_TICK_INTERVAL);
+    _avatarReducedRate->setTickPosition(QSlider::TicksBelow);
+    _avatarReducedRate->setFixedWidth(SLIDER_WIDTH);
+    _avatarReducedRate->setValue(simulationLOD.getReducedRate());
+    form->addRow("Avatar Reduced Rate:", _avatarReducedRate);
+    connect(_avatarReducedRate, SIGNAL(valueChanged(int)), this, SLOT(avatarReducedRateValueChanged(int)));
+    
+    _avatarFeedback = new QLabel();
+    _avatarFeedback->setFixedWidth(FEEDBACK_WIDTH);
+    _avatarFeedback->setWordWrap(true);
+    form->addRow("Avatars... ", _avatarFeedback);
+    updateAvatarFeedback();
+    
+    // the counts of avatars in each tier change as they and we move around
+    QTimer* avatarFeedbackTimer = new QTimer(this);
+    connect(avatarFeedbackTimer, SIGNAL(timeout()), this, SLOT(updateAvatarFeedback()));
+    avatarFeedbackTimer->start(AVATAR_FEEDBACK_INTERVAL_MSECS);
+    
     // Add a button to reset
     QPushButton* resetButton = new QPushButton("Reset");
     form->addRow("", resetButton);
@@ -85,12 +133,22 @@ LodToolsDialog::~LodToolsDialog() {
     delete _feedback;
     delete _lodSize;
     delete _boundaryLevelAdjust;
+    delete _avatarBlendshapeDistance;
+    delete _avatarReducedRateDistance;
+    delete _avatarReducedRate;
+    delete _avatarFeedback;
 }
 
 void LodToolsDialog::reloadSliders() {
     _lodSize->setValue(Menu::getInstance()->getVoxelSizeScale() / TREE_SCALE);
     _boundaryLevelAdjust->setValue(Menu::getInstance()->getBoundaryLevelAdjust());
     _feedback->setText(Menu::getInstance()->getLODFeedbackText());
+    
+    const AvatarSimulationLOD& simulationLOD = Menu::getInstance()->getAvatarSimulationLOD();
+    _avatarBlendshapeDistance->setValue(simulationLOD.getBlendshapeDistance());
+    _avatarReducedRateDistance->setValue(simulationLOD.getReducedRateDistance());
+    _avatarReducedRate->setValue(simulationLOD.getReducedRate());
+    updateAvatarFeedback();
 }
 
 void LodToolsDialog::sizeScaleValueChanged(int value) {
@@ -105,11 +163,44 @@ void LodToolsDialog::boundaryLevelValueChanged(int value) {
     _feedback->setText(Menu::getInstance()->getLODFeedbackText());
 }
 
+void LodToolsDialog::avatarBlendshapeDistanceValueChanged(int value) {
+    Menu::getInstance()->getAvatarSimulationLOD().setBlendshapeDistance(value);
+    updateAvatarFeedback();
+}
+
+void LodToolsDialog::avatarReducedRateDistanceValueChanged(int value) {
+    Menu::getInstance()->getAvatarSimulationLOD().setReducedRateDistance(value);
+    updateAvatarFeedback();
+}
+
+void LodToolsDialog::avatarReducedRateValueChanged(int value) {
+    Menu::getInstance()->getAvatarSimulationLOD().setReducedRate(value);
+    updateAvatarFeedback();
+}
+
+void LodToolsDialog::updateAvatarFeedback() {
+    const AvatarSimulationLOD& simulationLOD = Menu::getInstance()->getAvatarSimulationLOD();
+    QString feedback = QString("Blendshapes within %1m, every joint update within %2m, then %3 updates/sec; off screen "
+        "avatars are frozen.  Now:").arg(simulationLOD.getBlendshapeDistance()).arg(
+            simulationLOD.getReducedRateDistance()).arg(simulationLOD.getReducedRate());
+    const AvatarManager& avatarManager = Application::getInstance()->getAvatarManager();
+    for (int i = 0; i < AvatarSimulationLOD::TIER_COUNT; i++) {
+        AvatarSimulationLOD::Tier tier = (AvatarSimulationLOD::Tier)i;
+        feedback += QString(" %1 %2").arg(avatarManager.getLastTierCount(tier)).arg(
+            AvatarSimulationLOD::getTierName(tier));
+        feedback += (i == AvatarSimulationLOD::TIER_COUNT - 1) ? "." : ",";
+    }
+    _avatarFeedback->setText(feedback);
+}
+
 void LodToolsDialog::resetClicked(bool checked) {
     int sliderValue = DEFAULT_OCTREE_SIZE_SCALE / TREE_SCALE;
     //sizeScaleValueChanged(sliderValue);
     _lodSize->setValue(sliderValue);
     _boundaryLevelAdjust->setValue(0);
+    _avatarBlendshapeDistance->setValue(DEFAULT_AVATAR_BLENDSHAPE_DISTANCE);
+    _avatarReducedRateDistance->setValue(DEFAULT_AVATAR_REDUCED_RATE_DISTANCE);
+    _avatarReducedRate->setValue(DEFAULT_AVATAR_REDUCED_RATE);
 }
 
 void LodToolsDialog::reject() {
@@ -27,6 +27,10 @@ public slots:
     void reject();
     void sizeScaleValueChanged(int value);
     void boundaryLevelValueChanged(int value);
+    void avatarBlendshapeDistanceValueChanged(int value);
+    void avatarReducedRateDistanceValueChanged(int value);
+    void avatarReducedRateValueChanged(int value);
+    void updateAvatarFeedback();
     void resetClicked(bool checked);
     void reloadSliders();
 
@@ -39,6 +43,10 @@ private:
     QSlider* _lodSize;
     QSlider* _boundaryLevelAdjust;
     QLabel* _feedback;
+    QSlider* _avatarBlendshapeDistance;
+    QSlider* _avatarReducedRateDistance;
+    QSlider* _avatarReducedRate;
+    QLabel* _avatarFeedback;
 };
 
 #endif /* defined(__interface__LodToolsDialog__) */
@@ -240,7 +240,7 @@ void OctreeStatsDialog::showAllOctreeServers() {
 }
 
 void OctreeStatsDialog::showOctreeServersOfType(int& serverCount, NodeType_t serverType, const char* serverTypeName,
-                                                NodeToJurisdictionMap& serverJurisdictions) {
+                                                const NodeToJurisdictionMap& serverJurisdictions) {
                                                 
     QLocale locale(QLocale::English);
     
@@ -278,7 +278,7 @@ void OctreeStatsDialog::showOctreeServersOfType(int& serverCount, NodeType_t ser
             if (serverJurisdictions.find(nodeUUID) == serverJurisdictions.end()) {
                 serverDetails << " unknown jurisdiction ";
             } else {
-                const JurisdictionMap& map = serverJurisdictions[nodeUUID];
+                const JurisdictionMap& map = *serverJurisdictions.find(nodeUUID);
                 
                 unsigned char* rootCode = map.getRootOctalCode();
                 
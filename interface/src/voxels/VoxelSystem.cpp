@@ -6,6 +6,7 @@
 //
 
 
+#include <cstddef>
 #include <cstring>
 #include <cmath>
 #include <iostream> // to load voxels from file
@@ -61,9 +62,10 @@ VoxelSystem::VoxelSystem(float treeScale, int maxVoxels, VoxelTree* tree)
     _writeArraysLock(QReadWriteLock::Recursive),
     _readArraysLock(QReadWriteLock::Recursive),
     _inOcclusions(false),
+    _useChunkedMeshes(false),
     _showCulledSharedFaces(false),
     _usePrimitiveRenderer(false),
-    _renderer(0) 
+    _renderer(0)
 {
 
     _voxelsInReadArrays = _voxelsInWriteArrays = _voxelsUpdated = 0;
@@ -127,8 +129,9 @@ void VoxelSystem::setDisableFastVoxelPipeline(bool disableFastVoxelPipeline) {
 void VoxelSystem::elementUpdated(OctreeElement* element) {
     VoxelTreeElement* voxel = (VoxelTreeElement*)element;
 
-    // If we're in SetupNewVoxelsForDrawing() or _writeRenderFullVBO then bail..
-    if (!_useFastVoxelPipeline || _inSetupNewVoxelsForDrawing || _writeRenderFullVBO) {
+    // If we're in SetupNewVoxelsForDrawing() or _writeRenderFullVBO then bail.. chunked meshes are rebuilt by region
+    // in setupNewVoxelsForDrawing(), so they've no use for single voxel updates either
+    if (!_useFastVoxelPipeline || _inSetupNewVoxelsForDrawing || _writeRenderFullVBO || _useChunkedMeshes) {
         return;
     }
 
@@ -236,6 +239,7 @@ VoxelSystem::~VoxelSystem() {
     VoxelTreeElement::removeDeleteHook(this);
     VoxelTreeElement::removeUpdateHook(this);
 
+    cleanupChunkedMeshes();
     cleanupVoxelMemory();
     delete _tree;
 }
@@ -596,7 +600,8 @@ int VoxelSystem::parseData(const QByteArray& packet) {
         default:
             break;
     }
-    if (!_useFastVoxelPipeline || _writeRenderFullVBO) {
+    // the single node path only touches the arrays, which chunked meshes don't draw from
+    if (!_useFastVoxelPipeline || _writeRenderFullVBO || _useChunkedMeshes) {
         setupNewVoxelsForDrawing();
     } else {
         setupNewVoxelsForDrawingSingleNode(DONT_BAIL_EARLY);
@@ -634,14 +639,20 @@ void VoxelSystem::setupNewVoxelsForDrawing() {
         PerformanceWarning warn(Menu::getInstance()->isOptionChecked(MenuOption::PipelineWarnings), buffer);
         _callsToTreesToArrays++;
 
-        if (_writeRenderFullVBO) {
-            if (_usePrimitiveRenderer) {
-                _renderer->release();
-                clearAllNodesBufferIndex();
+        if (_useChunkedMeshes) {
+            // the regions are meshed on the workers and swapped in when next rendered, there are no arrays to fill
+            buildChunkedMeshes(_writeRenderFullVBO);
+            _voxelsUpdated = 0;
+        } else {
+            if (_writeRenderFullVBO) {
+                if (_usePrimitiveRenderer) {
+                    _renderer->release();
+                    clearAllNodesBufferIndex();
+                }
+                clearFreeBufferIndexes();
             }
-            clearFreeBufferIndexes();
+            _voxelsUpdated = newTreeToArrays(_tree->getRoot());
         }
-        _voxelsUpdated = newTreeToArrays(_tree->getRoot());
         _tree->clearDirtyBit(); // after we pull the trees into the array, we can consider the tree clean
 
         if (_writeRenderFullVBO) {
@@ -657,7 +668,7 @@ void VoxelSystem::setupNewVoxelsForDrawing() {
         if (_voxelsUpdated) {
             _voxelsDirty=true;
         }
-    } else {
+    } else if (!_useChunkedMeshes) {
         // lock on the buffer write lock so we can't modify the data when the GPU is reading it
         _readArraysLock.lockForWrite();
 
@@ -684,6 +695,26 @@ void VoxelSystem::setupNewVoxelsForDrawing() {
     }
 }
 
+// the snapshot is a full copy of the tree, so while packets are streaming in it only trails the tree by this much
+const quint64 SNAPSHOT_PUBLISH_INTERVAL_USECS = USECS_PER_SECOND / 4;
+
+void VoxelSystem::publishTreeSnapshot() {
+    // collisions and picks query a snapshot, so they neither wait on the tree's lock nor give up when it's busy. The
+    // copy is made here rather than as packets arrive, so the packet thread never holds the tree's lock for it, and
+    // checkForCulling() catches whatever changed since
+    if (!_snapshotPublishLock.tryLock()) {
+        return; // another thread is already publishing
+    }
+    quint64 now = usecTimestampNow();
+    if (_tree->isSnapshotStale() && now - _lastSnapshotPublished >= SNAPSHOT_PUBLISH_INTERVAL_USECS) {
+        _tree->lockForRead();
+        _tree->publishSnapshot();
+        _tree->unlock();
+        _lastSnapshotPublished = now;
+    }
+    _snapshotPublishLock.unlock();
+}
+
 void VoxelSystem::setupNewVoxelsForDrawingSingleNode(bool allowBailEarly) {
     PerformanceWarning warn(Menu::getInstance()->isOptionChecked(MenuOption::PipelineWarnings),
                             "setupNewVoxelsForDrawingSingleNode() xxxxx");
@@ -824,7 +855,16 @@ void VoxelSystem::checkForCulling() {
     _lastKnownVoxelSizeScale = Menu::getInstance()->getVoxelSizeScale();
     _lastKnownBoundaryLevelAdjust = Menu::getInstance()->getBoundaryLevelAdjust();
 
-    if (fullRedraw) {
+    if (_useChunkedMeshes) {
+        // chunks are checked against the frustum as they're drawn, so all that can change with the view is which level
+        // of detail renders, and the regions are rebuilt for that once the view settles
+        if (fullRedraw || forceFullFrustum) {
+            buildChunkedMeshes(true);
+        } else if (_tree->isDirty()) {
+            // picks up local edits, and the last packet's changes if setupNewVoxelsForDrawing() bailed early on them
+            setupNewVoxelsForDrawing();
+        }
+    } else if (fullRedraw) {
         // this will remove all old geometry and recreate the correct geometry for all in view voxels
         recreateVoxelGeometryInView();
     } else {
@@ -836,6 +876,9 @@ void VoxelSystem::checkForCulling() {
         _lastViewCullingElapsed = (endViewCulling - start) / 1000;
     }
 
+    // local edits and scripts change the tree without coming through here, so this keeps their snapshot from trailing
+    publishTreeSnapshot();
+
     // Once we call cleanupRemovedVoxels() we do need to rebuild our VBOs (if anything was actually removed). So,
     // we should consider putting this someplace else... as this might be able to occur less frequently, and save us on
     // VBO reubuilding. Possibly we should do this only if our actual VBO usage crosses some lower boundary.
@@ -1160,6 +1203,7 @@ void VoxelSystem::init() {
     _callsToTreesToArrays = 0;
     _setupNewVoxelsForDrawingLastFinished = 0;
     _setupNewVoxelsForDrawingLastElapsed = 0;
+    _lastSnapshotPublished = 0;
     _lastViewCullingElapsed = _lastViewCulling = _lastAudit = _lastViewIsChanging = 0;
     _hasRecentlyChanged = false;
 
@@ -1321,6 +1365,11 @@ void VoxelSystem::render() {
         return;
     }
 
+    if (_useChunkedMeshes) {
+        renderChunkedMeshes(texture);
+        return;
+    }
+
     updateVBOs();
 
     // if not don't... then do...
@@ -1468,6 +1517,101 @@ void VoxelSystem::render() {
     }
 }
 
+void VoxelSystem::buildChunkedMeshes(bool rebuildAll) {
+    PerformanceWarning warn(Menu::getInstance()->isOptionChecked(MenuOption::PipelineWarnings), "buildChunkedMeshes()");
+    ViewFrustum viewFrustum = *_viewFrustum;
+    _tree->lockForRead();
+    int regionsBuilt = _meshBuilder.build(_tree, viewFrustum, Menu::getInstance()->getVoxelSizeScale(),
+                                          Menu::getInstance()->getBoundaryLevelAdjust(), rebuildAll);
+    _tree->unlock();
+
+    if (Application::getInstance()->getLogger()->extraDebugging()) {
+        qDebug("buildChunkedMeshes() built %d regions in %llu usecs", regionsBuilt, _meshBuilder.getLastBuildUsecs());
+    }
+}
+
+void VoxelSystem::renderChunkedMeshes(bool texture) {
+    bool showWarnings = Menu::getInstance()->isOptionChecked(MenuOption::PipelineWarnings);
+    {
+        PerformanceWarning warn(showWarnings, "renderChunkedMeshes().. upload");
+
+        // the meshes were built on the workers, all that's left here is to take them and hand them to the GPU
+        QVector<VoxelMeshUpdate> updates;
+        _meshBuilder.swapMeshes(updates);
+        foreach (const VoxelMeshUpdate& update, updates) {
+            QHash<int, ChunkBuffer>::iterator buffer = _chunkBuffers.find(update.key);
+            if (!update.mesh) {
+                if (buffer != _chunkBuffers.end()) {
+                    glDeleteBuffers(1, &buffer->vboID);
+                    _chunkBuffers.erase(buffer);
+                }
+                continue;
+            }
+            if (buffer == _chunkBuffers.end()) {
+                buffer = _chunkBuffers.insert(update.key, ChunkBuffer());
+                glGenBuffers(1, &buffer->vboID);
+            }
+            buffer->vertexCount = update.mesh->vertices.size();
+            buffer->bounds = update.mesh->bounds;
+            glBindBuffer(GL_ARRAY_BUFFER, buffer->vboID);
+            glBufferData(GL_ARRAY_BUFFER, buffer->vertexCount * sizeof(VoxelMeshVertex),
+                         update.mesh->vertices.constData(), GL_STATIC_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    PerformanceWarning warn(showWarnings, "renderChunkedMeshes().. draw");
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    applyScaleAndBindProgram(texture);
+    glEnable(GL_CULL_FACE);
+
+    for (QHash<int, ChunkBuffer>::const_iterator buffer = _chunkBuffers.constBegin();
+            buffer != _chunkBuffers.constEnd(); buffer++) {
+        if (buffer->vertexCount == 0) {
+            continue;
+        }
+        AABox bounds = buffer->bounds;
+        bounds.scale(_treeScale);
+        if (_viewFrustum->boxInFrustum(bounds) == ViewFrustum::OUTSIDE) {
+            continue;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer->vboID);
+        glVertexPointer(3, GL_FLOAT, sizeof(VoxelMeshVertex), BUFFER_OFFSET(offsetof(VoxelMeshVertex, position)));
+        glNormalPointer(GL_BYTE, sizeof(VoxelMeshVertex), BUFFER_OFFSET(offsetof(VoxelMeshVertex, normal)));
+        glColorPointer(3, GL_UNSIGNED_BYTE, sizeof(VoxelMeshVertex), BUFFER_OFFSET(offsetof(VoxelMeshVertex, color)));
+        glDrawArrays(GL_QUADS, 0, buffer->vertexCount);
+    }
+
+    glDisable(GL_CULL_FACE);
+    removeScaleAndReleaseProgram(texture);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VoxelSystem::cleanupChunkedMeshes() {
+    for (QHash<int, ChunkBuffer>::iterator buffer = _chunkBuffers.begin(); buffer != _chunkBuffers.end(); buffer++) {
+        glDeleteBuffers(1, &buffer->vboID);
+    }
+    _chunkBuffers.clear();
+    _meshBuilder.reset();
+}
+
+// only called on main thread
+void VoxelSystem::setUseChunkedMeshes(bool useChunkedMeshes) {
+    if (_useChunkedMeshes == useChunkedMeshes) {
+        return;
+    }
+    cleanupChunkedMeshes();
+    _useChunkedMeshes = useChunkedMeshes;
+    _writeRenderFullVBO = true;
+    _tree->setDirtyBit();
+    setupNewVoxelsForDrawing();
+}
+
 void VoxelSystem::applyScaleAndBindProgram(bool texture) {
 
     if (Menu::getInstance()->isOptionChecked(MenuOption::Shadows)) {
@@ -1797,6 +1941,8 @@ public:
     ViewFrustum lastViewFrustum;
     bool culledOnce;
     bool wantDeltaFrustums;
+    float voxelSizeScale;
+    int boundaryLevelAdjust;
     unsigned long nodesScanned;
     unsigned long nodesRemoved;
     unsigned long nodesInside;
@@ -1817,6 +1963,8 @@ public:
         lastViewFrustum(*voxelSystem->getLastCulledViewFrustum()),
         culledOnce(culledOnce),
         wantDeltaFrustums(wantDeltaFrustums),
+        voxelSizeScale(Menu::getInstance()->getVoxelSizeScale()),
+        boundaryLevelAdjust(Menu::getInstance()->getBoundaryLevelAdjust()),
         nodesScanned(0),
         nodesRemoved(0),
         nodesInside(0),
@@ -1885,9 +2033,10 @@ void VoxelSystem::hideOutOfView(bool forceFullFrustum) {
 
     {
         PerformanceWarning warn(Menu::getInstance()->isOptionChecked(MenuOption::PipelineWarnings), 
-                            "VoxelSystem::... recurseTreeWithOperation(hideOutOfViewOperation)");
+                            "VoxelSystem::... visitTree(hideOutOfViewOperation)");
+        OctreeOperationVisitor<hideOutOfViewOperation> visitor(&args);
         _tree->lockForRead();
-        _tree->recurseTreeWithOperation(hideOutOfViewOperation,(void*)&args);
+        _tree->visitTree(visitor);
         _tree->unlock();
     }
     _lastCulledViewFrustum = args.thisViewFrustum; // save last stable
@@ -1963,9 +2112,8 @@ bool VoxelSystem::showAllSubTreeOperation(OctreeElement* element, void* extraDat
 
     args->nodesInside++;
 
-    float voxelSizeScale = Menu::getInstance()->getVoxelSizeScale();
-    int boundaryLevelAdjust = Menu::getInstance()->getBoundaryLevelAdjust();
-    bool shouldRender = voxel->calculateShouldRender(&args->thisViewFrustum, voxelSizeScale, boundaryLevelAdjust);
+    bool shouldRender = voxel->calculateShouldRender(&args->thisViewFrustum, args->voxelSizeScale,
+                                                     args->boundaryLevelAdjust);
     voxel->setShouldRender(shouldRender);
 
     if (shouldRender && !voxel->isKnownBufferIndex()) {
@@ -2013,7 +2161,8 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             // if this node is fully OUTSIDE the view, but previously intersected and/or was inside the last view, then
             // we need to hide it. Additionally we know that ALL of it's children are also fully OUTSIDE so we can recurse
             // the children and simply mark them as hidden
-            args->tree->recurseNodeWithOperation(voxel, hideAllSubTreeOperation, args );
+            OctreeOperationVisitor<hideAllSubTreeOperation> hideAllVisitor(args);
+            args->tree->visitSubTree(voxel, hideAllVisitor);
             return false;
 
         } break;
@@ -2030,7 +2179,8 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             // if this node is fully INSIDE the view, but previously INTERSECTED and/or was OUTSIDE the last view, then
             // we need to show it. Additionally we know that ALL of it's children are also fully INSIDE so we can recurse
             // the children and simply mark them as visible (as appropriate based on LOD)
-            args->tree->recurseNodeWithOperation(voxel, showAllSubTreeOperation, args);
+            OctreeOperationVisitor<showAllSubTreeOperation> showAllVisitor(args);
+            args->tree->visitSubTree(voxel, showAllVisitor);
             return false;
         } break;
         case ViewFrustum::INTERSECT: {
@@ -2049,9 +2199,8 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             // if it should render but is missing it's VBO index, then we want to flip it on, and we can stop recursing from
             // here because we know will block any children anyway
             
-            float voxelSizeScale = Menu::getInstance()->getVoxelSizeScale();
-            int boundaryLevelAdjust = Menu::getInstance()->getBoundaryLevelAdjust();
-            bool shouldRender = voxel->calculateShouldRender(&args->thisViewFrustum, voxelSizeScale, boundaryLevelAdjust);
+            bool shouldRender = voxel->calculateShouldRender(&args->thisViewFrustum, args->voxelSizeScale,
+                                                             args->boundaryLevelAdjust);
             voxel->setShouldRender(shouldRender);
             
             if (voxel->getShouldRender() && !voxel->isKnownBufferIndex()) {
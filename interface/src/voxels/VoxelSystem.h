@@ -16,6 +16,7 @@
 
 #include <NodeData.h>
 #include <ViewFrustum.h>
+#include <VoxelMeshBuilder.h>
 #include <VoxelTree.h>
 #include <OctreePersistThread.h>
 
@@ -76,6 +77,10 @@ public:
 
     void killLocalVoxels();
 
+    /// Republishes the tree's snapshot, for collisions and picks, if the tree has changed since it was last published and
+    /// a quarter second has passed. Call without the tree locked.
+    void publishTreeSnapshot();
+
     virtual void hideOutOfView(bool forceFullFrustum = false);
     void inspectForOcclusions();
     bool hasViewChanged();
@@ -98,6 +103,7 @@ public slots:
     void setDisableFastVoxelPipeline(bool disableFastVoxelPipeline);
     void setUseVoxelShader(bool useVoxelShader);
     void setVoxelsAsPoints(bool voxelsAsPoints);
+    void setUseChunkedMeshes(bool useChunkedMeshes);
 
 protected:
     float _treeScale;
@@ -183,6 +189,8 @@ private:
 
     int _setupNewVoxelsForDrawingLastElapsed;
     quint64 _setupNewVoxelsForDrawingLastFinished;
+    quint64 _lastSnapshotPublished;
+    QMutex _snapshotPublishLock; // local edits publish from the main thread, culling from the hide/show thread
     quint64 _lastViewCulling;
     quint64 _lastViewIsChanging;
     quint64 _lastAudit;
@@ -259,6 +267,22 @@ private:
     int _lastKnownBoundaryLevelAdjust;
 
     bool _inOcclusions;
+
+    /// A region's mesh, uploaded.
+    class ChunkBuffer {
+    public:
+        GLuint vboID;
+        int vertexCount;
+        AABox bounds;
+    };
+
+    void buildChunkedMeshes(bool rebuildAll);
+    void renderChunkedMeshes(bool texture);
+    void cleanupChunkedMeshes();
+
+    bool _useChunkedMeshes;                     ///< Build meshes on worker threads instead of filling the VBO arrays
+    VoxelMeshBuilder _meshBuilder;
+    QHash<int, ChunkBuffer> _chunkBuffers;      ///< Render thread only, by region
     bool _showCulledSharedFaces;                ///< Flag visibility of culled faces
     bool _usePrimitiveRenderer;                 ///< Flag primitive renderer for use
     PrimitiveRenderer* _renderer;               ///< Voxel renderer
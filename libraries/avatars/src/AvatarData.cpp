@@ -8,6 +8,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <limits>
 #include <stdint.h>
 
 #include <QtCore/QDataStream>
@@ -46,7 +47,11 @@ AvatarData::AvatarData() :
     _displayNameTargetAlpha(0.0f), 
     _displayNameAlpha(0.0f),
     _billboard(),
-    _errorLogExpiry(0)
+    _errorLogExpiry(0),
+    _sentKeyframeSequence(0),
+    _framesSinceKeyframe(AVATAR_KEYFRAME_INTERVAL),
+    _receivedKeyframeSequence(0),
+    _hasReceivedKeyframe(false)
 {
     
 }
@@ -65,58 +70,74 @@ void AvatarData::setHandPosition(const glm::vec3& handPosition) {
     _handPosition = glm::inverse(getOrientation()) * (handPosition - _position);
 }
 
-QByteArray AvatarData::toByteArray() {
+// the quantization for fields that don't have a shared packing helper
+const int HEAD_LEAN_RADIX = 12; // 4.12 fixed point
+const float AUDIO_LOUDNESS_CONVERSION_RATIO = std::numeric_limits<uint16_t>::max() / MAX_AUDIO_LOUDNESS;
+const int MAX_CHAT_MESSAGE_SIZE = std::numeric_limits<unsigned char>::max();
+const int FACE_DATA_HEADER_SIZE = 1 + 2 + 2 * sizeof(float) + 1; // connected, eye blinks, loudness and lift, blendshape count
+const int BYTES_PER_JOINT_ROTATION = 6; // smallest three quaternion compression
+
+// blendshape weights and eye blinks are between 0 and 1, and only need 8 bits
+static int packUnitFloatToByte(unsigned char* buffer, float value) {
+    return packFloatToByte(buffer, glm::clamp(value, 0.0f, 1.0f), 1.0f);
+}
+
+void AvatarData::packFields(QByteArray& fields, QVector<int>& offsets) {
     // TODO: DRY this up to a shared method
     // that can pack any type given the number of bytes
     // and return the number of bytes to push the pointer
-    
-    // lazily allocate memory for HeadData in case we're not an Avatar instance
-    if (!_headData) {
-        _headData = new HeadData(this);
-    }
-    
-    QByteArray avatarDataByteArray;
-    avatarDataByteArray.resize(MAX_PACKET_SIZE);
-    
-    unsigned char* destinationBuffer = reinterpret_cast<unsigned char*>(avatarDataByteArray.data());
+    int chatMessageSize = std::min((int)_chatMessage.size(), MAX_CHAT_MESSAGE_SIZE);
+    fields.resize(MAX_PACKET_SIZE + _headData->_blendshapeCoefficients.size()
+        + _jointData.size() * BYTES_PER_JOINT_ROTATION);
+    offsets.resize(NUM_AVATAR_FIELDS + 1);
+
+    unsigned char* destinationBuffer = reinterpret_cast<unsigned char*>(fields.data());
     unsigned char* startPosition = destinationBuffer;
-    
+
+    offsets[AVATAR_FIELD_POSITION] = destinationBuffer - startPosition;
     memcpy(destinationBuffer, &_position, sizeof(_position));
     destinationBuffer += sizeof(_position);
-    
+
     // Body rotation (NOTE: This needs to become a quaternion to save two bytes)
+    offsets[AVATAR_FIELD_BODY_ROTATION] = destinationBuffer - startPosition;
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyYaw);
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyPitch);
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyRoll);
 
     // Body scale
+    offsets[AVATAR_FIELD_SCALE] = destinationBuffer - startPosition;
     destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _targetScale);
 
     // Head rotation (NOTE: This needs to become a quaternion to save two bytes)
+    offsets[AVATAR_FIELD_HEAD_ROTATION] = destinationBuffer - startPosition;
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalYaw());
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalPitch());
     destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalRoll());
-    
+
     // Head lean X,Z (head lateral and fwd/back motion relative to torso)
-    memcpy(destinationBuffer, &_headData->_leanSideways, sizeof(_headData->_leanSideways));
-    destinationBuffer += sizeof(_headData->_leanSideways);
-    memcpy(destinationBuffer, &_headData->_leanForward, sizeof(_headData->_leanForward));
-    destinationBuffer += sizeof(_headData->_leanForward);
+    offsets[AVATAR_FIELD_HEAD_LEAN] = destinationBuffer - startPosition;
+    destinationBuffer += packFloatScalarToSignedTwoByteFixed(destinationBuffer, _headData->_leanSideways, HEAD_LEAN_RADIX);
+    destinationBuffer += packFloatScalarToSignedTwoByteFixed(destinationBuffer, _headData->_leanForward, HEAD_LEAN_RADIX);
 
     // Lookat Position
+    offsets[AVATAR_FIELD_LOOK_AT] = destinationBuffer - startPosition;
     memcpy(destinationBuffer, &_headData->_lookAtPosition, sizeof(_headData->_lookAtPosition));
     destinationBuffer += sizeof(_headData->_lookAtPosition);
-     
+
     // Instantaneous audio loudness (used to drive facial animation)
-    memcpy(destinationBuffer, &_headData->_audioLoudness, sizeof(float));
-    destinationBuffer += sizeof(float);
+    offsets[AVATAR_FIELD_AUDIO_LOUDNESS] = destinationBuffer - startPosition;
+    uint16_t audioLoudness = glm::clamp(_headData->_audioLoudness, 0.0f, MAX_AUDIO_LOUDNESS) * AUDIO_LOUDNESS_CONVERSION_RATIO;
+    memcpy(destinationBuffer, &audioLoudness, sizeof(audioLoudness));
+    destinationBuffer += sizeof(audioLoudness);
 
     // chat message
-    *destinationBuffer++ = _chatMessage.size();
-    memcpy(destinationBuffer, _chatMessage.data(), _chatMessage.size() * sizeof(char));
-    destinationBuffer += _chatMessage.size() * sizeof(char);
-    
+    offsets[AVATAR_FIELD_CHAT_MESSAGE] = destinationBuffer - startPosition;
+    *destinationBuffer++ = chatMessageSize;
+    memcpy(destinationBuffer, _chatMessage.data(), chatMessageSize * sizeof(char));
+    destinationBuffer += chatMessageSize * sizeof(char);
+
     // bitMask of less than byte wide items
+    offsets[AVATAR_FIELD_STATE_FLAGS] = destinationBuffer - startPosition;
     unsigned char bitItems = 0;
 
     // key state
@@ -130,30 +151,31 @@ QByteArray AvatarData::toByteArray() {
     }
     *destinationBuffer++ = bitItems;
 
-    // If it is connected, pack up the data
+    // face data, led by whether there is any so that the field can be skipped without the state flags
+    offsets[AVATAR_FIELD_FACE] = destinationBuffer - startPosition;
+    *destinationBuffer++ = _headData->_isFaceshiftConnected;
     if (_headData->_isFaceshiftConnected) {
-        memcpy(destinationBuffer, &_headData->_leftEyeBlink, sizeof(float));
-        destinationBuffer += sizeof(float);
-
-        memcpy(destinationBuffer, &_headData->_rightEyeBlink, sizeof(float));
-        destinationBuffer += sizeof(float);
+        destinationBuffer += packUnitFloatToByte(destinationBuffer, _headData->_leftEyeBlink);
+        destinationBuffer += packUnitFloatToByte(destinationBuffer, _headData->_rightEyeBlink);
 
         memcpy(destinationBuffer, &_headData->_averageLoudness, sizeof(float));
         destinationBuffer += sizeof(float);
 
         memcpy(destinationBuffer, &_headData->_browAudioLift, sizeof(float));
         destinationBuffer += sizeof(float);
-        
+
         *destinationBuffer++ = _headData->_blendshapeCoefficients.size();
-        memcpy(destinationBuffer, _headData->_blendshapeCoefficients.data(),
-            _headData->_blendshapeCoefficients.size() * sizeof(float));
-        destinationBuffer += _headData->_blendshapeCoefficients.size() * sizeof(float);
+        foreach (float coefficient, _headData->_blendshapeCoefficients) {
+            destinationBuffer += packUnitFloatToByte(destinationBuffer, coefficient);
+        }
     }
-    
+
     // pupil dilation
+    offsets[AVATAR_FIELD_PUPIL_DILATION] = destinationBuffer - startPosition;
     destinationBuffer += packFloatToByte(destinationBuffer, _headData->_pupilDilation, 1.0f);
 
     // joint data
+    offsets[AVATAR_FIELD_JOINTS] = destinationBuffer - startPosition;
     *destinationBuffer++ = _jointData.size();
     unsigned char validity = 0;
     int validityBit = 0;
@@ -171,11 +193,61 @@ QByteArray AvatarData::toByteArray() {
     }
     foreach (const JointData& data, _jointData) {
         if (data.valid) {
-            destinationBuffer += packOrientationQuatToBytes(destinationBuffer, data.rotation);
+            destinationBuffer += packOrientationQuatToSixBytes(destinationBuffer, data.rotation);
         }
     }
-        
-    return avatarDataByteArray.left(destinationBuffer - startPosition);
+
+    offsets[NUM_AVATAR_FIELDS] = destinationBuffer - startPosition;
+    fields.resize(destinationBuffer - startPosition);
+}
+
+QByteArray AvatarData::toByteArray(bool forceKeyframe) {
+    // lazily allocate memory for HeadData in case we're not an Avatar instance
+    if (!_headData) {
+        _headData = new HeadData(this);
+    }
+
+    QByteArray fields;
+    QVector<int> offsets;
+    packFields(fields, offsets);
+
+    QByteArray avatarDataByteArray;
+    unsigned char frameFlags = 0;
+
+    if (forceKeyframe || ++_framesSinceKeyframe >= AVATAR_KEYFRAME_INTERVAL) {
+        _sentKeyframe = fields;
+        _sentKeyframeOffsets = offsets;
+        _sentKeyframeSequence++;
+        _framesSinceKeyframe = 0;
+
+        setAtBit(frameFlags, IS_KEYFRAME_BIT);
+        avatarDataByteArray.append(frameFlags);
+        avatarDataByteArray.append(_sentKeyframeSequence);
+        avatarDataByteArray.append(fields);
+        return avatarDataByteArray;
+    }
+
+    // only the fields that changed since the keyframe go out, in field order
+    uint16_t fieldMask = 0;
+    QByteArray changedFields;
+    for (int field = 0; field < NUM_AVATAR_FIELDS; field++) {
+        int fieldSize = offsets[field + 1] - offsets[field];
+        int keyframeFieldSize = _sentKeyframeOffsets[field + 1] - _sentKeyframeOffsets[field];
+        if (fieldSize != keyframeFieldSize || memcmp(fields.constData() + offsets[field],
+                _sentKeyframe.constData() + _sentKeyframeOffsets[field], fieldSize) != 0) {
+            fieldMask |= (1 << field);
+            changedFields.append(fields.constData() + offsets[field], fieldSize);
+        }
+    }
+    avatarDataByteArray.append(frameFlags);
+    avatarDataByteArray.append(_sentKeyframeSequence);
+    avatarDataByteArray.append(reinterpret_cast<const char*>(&fieldMask), sizeof(fieldMask));
+    avatarDataByteArray.append(changedFields);
+    return avatarDataByteArray;
+}
+
+bool AvatarData::isKeyframe(const QByteArray& avatarData) {
+    return !avatarData.isEmpty() && oneAtBit(avatarData.at(0), IS_KEYFRAME_BIT);
 }
 
 bool AvatarData::shouldLogError(const quint64& now) {
@@ -186,6 +258,72 @@ bool AvatarData::shouldLogError(const quint64& now) {
     return false;
 }
 
+// returns the number of bytes a packed field takes up, or -1 if it runs past the available bytes
+int AvatarData::packedFieldSize(int field, const unsigned char* sourceBuffer, int availableBytes) {
+    int fieldSize = 0;
+    switch (field) {
+        case AVATAR_FIELD_POSITION:
+        case AVATAR_FIELD_LOOK_AT:
+            fieldSize = sizeof(glm::vec3);
+            break;
+        case AVATAR_FIELD_BODY_ROTATION:
+        case AVATAR_FIELD_HEAD_ROTATION:
+            fieldSize = 3 * sizeof(uint16_t);
+            break;
+        case AVATAR_FIELD_HEAD_LEAN:
+            fieldSize = 2 * sizeof(int16_t);
+            break;
+        case AVATAR_FIELD_SCALE:
+        case AVATAR_FIELD_AUDIO_LOUDNESS:
+            fieldSize = sizeof(uint16_t);
+            break;
+        case AVATAR_FIELD_STATE_FLAGS:
+        case AVATAR_FIELD_PUPIL_DILATION:
+            fieldSize = 1;
+            break;
+        case AVATAR_FIELD_CHAT_MESSAGE:
+            if (availableBytes < 1) {
+                return -1;
+            }
+            fieldSize = 1 + sourceBuffer[0];
+            break;
+        case AVATAR_FIELD_FACE: {
+            if (availableBytes < 1) {
+                return -1;
+            }
+            if (!sourceBuffer[0]) {
+                fieldSize = 1;
+            } else if (availableBytes < FACE_DATA_HEADER_SIZE) {
+                return -1;
+            } else {
+                fieldSize = FACE_DATA_HEADER_SIZE + sourceBuffer[FACE_DATA_HEADER_SIZE - 1]; // a byte per blendshape
+            }
+            break;
+        }
+        case AVATAR_FIELD_JOINTS: {
+            if (availableBytes < 1) {
+                return -1;
+            }
+            int numJoints = sourceBuffer[0];
+            int bytesOfValidity = (int)ceil((float)numJoints / (float)BITS_IN_BYTE);
+            if (availableBytes < 1 + bytesOfValidity) {
+                return -1;
+            }
+            int numValidJoints = 0;
+            for (int i = 0; i < numJoints; i++) {
+                if (sourceBuffer[1 + i / BITS_IN_BYTE] & (1 << (i % BITS_IN_BYTE))) {
+                    numValidJoints++;
+                }
+            }
+            fieldSize = 1 + bytesOfValidity + numValidJoints * BYTES_PER_JOINT_ROTATION;
+            break;
+        }
+        default:
+            return -1;
+    }
+    return (fieldSize <= availableBytes) ? fieldSize : -1;
+}
+
 // read data in packet starting at byte offset and return number of bytes parsed
 int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     // lazily allocate memory for HeadData in case we're not an Avatar instance
@@ -202,28 +340,20 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     const unsigned char* sourceBuffer = startPosition;
     quint64 now = usecTimestampNow();
 
-    // The absolute minimum size of the update data is as follows:
-    // 50 bytes of "plain old data" {
-    //     position      = 12 bytes
-    //     bodyYaw       =  2 (compressed float)
-    //     bodyPitch     =  2 (compressed float)
-    //     bodyRoll      =  2 (compressed float)
-    //     targetScale   =  2 (compressed float)
-    //     headYaw       =  2 (compressed float)
-    //     headPitch     =  2 (compressed float)
-    //     headRoll      =  2 (compressed float)
-    //     leanSideways  =  4
-    //     leanForward   =  4
-    //     lookAt        = 12
-    //     audioLoudness =  4
-    // }
-    // + 1 byte for messageSize (0)
-    // + 1 byte for pupilSize
-    // + 1 byte for numJoints (0)
-    // = 53 bytes
-    int minPossibleSize = 53; 
-    
+    // every frame starts with the frame flags and the keyframe sequence number, deltas then have the mask of the
+    // fields they include
     int maxAvailableSize = packet.size() - offset;
+    unsigned char frameFlags = 0;
+    unsigned char keyframeSequence = 0;
+    uint16_t fieldMask = (1 << NUM_AVATAR_FIELDS) - 1;
+    int minPossibleSize = sizeof(frameFlags) + sizeof(keyframeSequence);
+    if (minPossibleSize <= maxAvailableSize) {
+        frameFlags = *sourceBuffer++;
+        keyframeSequence = *sourceBuffer++;
+        if (!oneAtBit(frameFlags, IS_KEYFRAME_BIT)) {
+            minPossibleSize += sizeof(fieldMask);
+        }
+    }
     if (minPossibleSize > maxAvailableSize) {
         if (shouldLogError(now)) {
             qDebug() << "Malformed AvatarData packet at the start; "
@@ -234,257 +364,229 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
         // this packet is malformed so we report all bytes as consumed
         return maxAvailableSize;
     }
+    bool isKeyframe = oneAtBit(frameFlags, IS_KEYFRAME_BIT);
+    if (!isKeyframe) {
+        memcpy(&fieldMask, sourceBuffer, sizeof(fieldMask));
+        sourceBuffer += sizeof(fieldMask);
+    }
 
-    { // Body world position, rotation, and scale
-        // position
-        glm::vec3 position;
-        memcpy(&position, sourceBuffer, sizeof(position));
-        sourceBuffer += sizeof(position);
-        
-        if (glm::isnan(position.x) || glm::isnan(position.y) || glm::isnan(position.z)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::position; displayName = '" << _displayName << "'";
+    // find where each of the included fields starts
+    const unsigned char* fieldStarts[NUM_AVATAR_FIELDS];
+    for (int field = 0; field < NUM_AVATAR_FIELDS; field++) {
+        if (fieldMask & (1 << field)) {
+            int fieldSize = packedFieldSize(field, sourceBuffer, maxAvailableSize - (sourceBuffer - startPosition));
+            if (fieldSize < 0) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Malformed AvatarData packet in field" << field << ";"
+                        << " displayName = '" << _displayName << "'"
+                        << " maxAvailableSize = " << maxAvailableSize;
+                }
+                return maxAvailableSize;
             }
-            return maxAvailableSize;
+            fieldStarts[field] = sourceBuffer;
+            sourceBuffer += fieldSize;
         }
-        _position = position;
-        
-        // rotation (NOTE: This needs to become a quaternion to save two bytes)
-        float yaw, pitch, roll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
-        if (glm::isnan(yaw) || glm::isnan(pitch) || glm::isnan(roll)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::yaw,pitch,roll; displayName = '" << _displayName << "'";
-            }
-            return maxAvailableSize;
+    }
+    int bytesRead = sourceBuffer - startPosition;
+
+    if (isKeyframe) {
+        _receivedKeyframe = QByteArray(reinterpret_cast<const char*>(startPosition) + 2, bytesRead - 2);
+        _receivedKeyframeOffsets.resize(NUM_AVATAR_FIELDS);
+        for (int field = 0; field < NUM_AVATAR_FIELDS; field++) {
+            _receivedKeyframeOffsets[field] = fieldStarts[field] - (startPosition + 2);
         }
-        _bodyYaw = yaw;
-        _bodyPitch = pitch;
-        _bodyRoll = roll;
-        
-        // scale
-        float scale;
-        sourceBuffer += unpackFloatRatioFromTwoByte(sourceBuffer, scale);
-        if (glm::isnan(scale)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::scale; displayName = '" << _displayName << "'";
+        _receivedKeyframeSequence = keyframeSequence;
+        _hasReceivedKeyframe = true;
+
+    } else if (!_hasReceivedKeyframe || keyframeSequence != _receivedKeyframeSequence) {
+        // we missed the keyframe this delta is against, so we have to wait for the next one
+        return bytesRead;
+
+    } else {
+        // the fields that weren't included are unchanged since the keyframe
+        for (int field = 0; field < NUM_AVATAR_FIELDS; field++) {
+            if (!(fieldMask & (1 << field))) {
+                fieldStarts[field] = reinterpret_cast<const unsigned char*>(_receivedKeyframe.constData())
+                    + _receivedKeyframeOffsets[field];
             }
-            return maxAvailableSize;
         }
-        _targetScale = scale;
-    } // 20 bytes
-    
-    { // Head rotation 
-        //(NOTE: This needs to become a quaternion to save two bytes)
-        float headYaw, headPitch, headRoll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
-        if (glm::isnan(headYaw) || glm::isnan(headPitch) || glm::isnan(headRoll)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::headYaw,headPitch,headRoll; displayName = '" << _displayName << "'";
+    }
+
+    for (int field = 0; field < NUM_AVATAR_FIELDS; field++) {
+        if (!unpackField(field, fieldStarts[field], now)) {
+            break; // the rest of this avatar's update is discarded
+        }
+    }
+    return bytesRead;
+}
+
+// applies a single packed field, returns false if the field held bad data
+bool AvatarData::unpackField(int field, const unsigned char* sourceBuffer, const quint64& now) {
+    switch (field) {
+        case AVATAR_FIELD_POSITION: {
+            glm::vec3 position;
+            memcpy(&position, sourceBuffer, sizeof(position));
+            if (glm::isnan(position.x) || glm::isnan(position.y) || glm::isnan(position.z)) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Discard nan AvatarData::position; displayName = '" << _displayName << "'";
+                }
+                return false;
             }
-            return maxAvailableSize;
+            _position = position;
+            break;
         }
-        _headData->setBaseYaw(headYaw);
-        _headData->setBasePitch(headPitch);
-        _headData->setBaseRoll(headRoll);
-    } // 6 bytes
-        
-    // Head lean (relative to pelvis)
-    {
-        float leanSideways, leanForward;
-        memcpy(&leanSideways, sourceBuffer, sizeof(float));
-        sourceBuffer += sizeof(float);
-        memcpy(&leanForward, sourceBuffer, sizeof(float));
-        sourceBuffer += sizeof(float);
-        if (glm::isnan(leanSideways) || glm::isnan(leanForward)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::leanSideways,leanForward; displayName = '" << _displayName << "'";
+        case AVATAR_FIELD_BODY_ROTATION: {
+            // (NOTE: This needs to become a quaternion to save two bytes)
+            float yaw, pitch, roll;
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
+            if (glm::isnan(yaw) || glm::isnan(pitch) || glm::isnan(roll)) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Discard nan AvatarData::yaw,pitch,roll; displayName = '" << _displayName << "'";
+                }
+                return false;
             }
-            return maxAvailableSize;
+            _bodyYaw = yaw;
+            _bodyPitch = pitch;
+            _bodyRoll = roll;
+            break;
         }
-        _headData->_leanSideways = leanSideways;
-        _headData->_leanForward = leanForward;
-    } // 8 bytes
-    
-    { // Lookat Position
-        glm::vec3 lookAt;
-        memcpy(&lookAt, sourceBuffer, sizeof(lookAt));
-        sourceBuffer += sizeof(lookAt);
-        if (glm::isnan(lookAt.x) || glm::isnan(lookAt.y) || glm::isnan(lookAt.z)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::lookAt; displayName = '" << _displayName << "'";
+        case AVATAR_FIELD_SCALE: {
+            float scale;
+            unpackFloatRatioFromTwoByte(sourceBuffer, scale);
+            if (glm::isnan(scale)) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Discard nan AvatarData::scale; displayName = '" << _displayName << "'";
+                }
+                return false;
             }
-            return maxAvailableSize;
+            _targetScale = scale;
+            break;
         }
-        _headData->_lookAtPosition = lookAt;
-    } // 12 bytes
-    
-    { // AudioLoudness
-        // Instantaneous audio loudness (used to drive facial animation)
-        float audioLoudness;
-        memcpy(&audioLoudness, sourceBuffer, sizeof(float));
-        sourceBuffer += sizeof(float);
-        if (glm::isnan(audioLoudness)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::audioLoudness; displayName = '" << _displayName << "'";
+        case AVATAR_FIELD_HEAD_ROTATION: {
+            //(NOTE: This needs to become a quaternion to save two bytes)
+            float headYaw, headPitch, headRoll;
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
+            if (glm::isnan(headYaw) || glm::isnan(headPitch) || glm::isnan(headRoll)) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Discard nan AvatarData::headYaw,headPitch,headRoll; displayName = '" << _displayName << "'";
+                }
+                return false;
             }
-            return maxAvailableSize;
-         }
-        _headData->_audioLoudness = audioLoudness;
-    } // 4 bytes
-    
-    // chat
-    int chatMessageSize = *sourceBuffer++;
-    minPossibleSize += chatMessageSize;
-    if (minPossibleSize > maxAvailableSize) {
-        if (shouldLogError(now)) {
-            qDebug() << "Malformed AvatarData packet before ChatMessage;"
-                << " displayName = '" << _displayName << "'"
-                << " minPossibleSize = " << minPossibleSize 
-                << " maxAvailableSize = " << maxAvailableSize;
+            _headData->setBaseYaw(headYaw);
+            _headData->setBasePitch(headPitch);
+            _headData->setBaseRoll(headRoll);
+            break;
         }
-        return maxAvailableSize;
-    }
-    { // chat payload
-        _chatMessage = string((char*)sourceBuffer, chatMessageSize);
-        sourceBuffer += chatMessageSize * sizeof(char);
-    } // 1 + chatMessageSize bytes
-    
-    { // bitFlags and face data
-        unsigned char bitItems = 0;
-        bitItems = (unsigned char)*sourceBuffer++;
-    
-        // key state, stored as a semi-nibble in the bitItems
-        _keyState = (KeyState)getSemiNibbleAt(bitItems,KEY_STATE_START_BIT);
-        
-        // hand state, stored as a semi-nibble in the bitItems
-        _handState = getSemiNibbleAt(bitItems,HAND_STATE_START_BIT);
-        
-        _headData->_isFaceshiftConnected = oneAtBit(bitItems, IS_FACESHIFT_CONNECTED);
-        _isChatCirclingEnabled = oneAtBit(bitItems, IS_CHAT_CIRCLING_ENABLED);
-        
-        if (_headData->_isFaceshiftConnected) {
-            float leftEyeBlink, rightEyeBlink, averageLoudness, browAudioLift;
-            minPossibleSize += sizeof(leftEyeBlink) + sizeof(rightEyeBlink) + sizeof(averageLoudness) + sizeof(browAudioLift);
-            minPossibleSize++; // one byte for blendDataSize
-            if (minPossibleSize > maxAvailableSize) {
+        case AVATAR_FIELD_HEAD_LEAN: {
+            // Head lean (relative to pelvis)
+            sourceBuffer += unpackFloatScalarFromSignedTwoByteFixed((const int16_t*) sourceBuffer,
+                                                                    &_headData->_leanSideways, HEAD_LEAN_RADIX);
+            sourceBuffer += unpackFloatScalarFromSignedTwoByteFixed((const int16_t*) sourceBuffer,
+                                                                    &_headData->_leanForward, HEAD_LEAN_RADIX);
+            break;
+        }
+        case AVATAR_FIELD_LOOK_AT: {
+            glm::vec3 lookAt;
+            memcpy(&lookAt, sourceBuffer, sizeof(lookAt));
+            if (glm::isnan(lookAt.x) || glm::isnan(lookAt.y) || glm::isnan(lookAt.z)) {
                 if (shouldLogError(now)) {
-                    qDebug() << "Malformed AvatarData packet after BitItems;"
-                        << " displayName = '" << _displayName << "'"
-                        << " minPossibleSize = " << minPossibleSize 
-                        << " maxAvailableSize = " << maxAvailableSize;
+                    qDebug() << "Discard nan AvatarData::lookAt; displayName = '" << _displayName << "'";
                 }
-                return maxAvailableSize;
+                return false;
             }
-            // unpack face data
-            memcpy(&leftEyeBlink, sourceBuffer, sizeof(float));
-            sourceBuffer += sizeof(float);
-            
-            memcpy(&rightEyeBlink, sourceBuffer, sizeof(float));
-            sourceBuffer += sizeof(float);
-            
+            _headData->_lookAtPosition = lookAt;
+            break;
+        }
+        case AVATAR_FIELD_AUDIO_LOUDNESS: {
+            // Instantaneous audio loudness (used to drive facial animation)
+            uint16_t audioLoudness;
+            memcpy(&audioLoudness, sourceBuffer, sizeof(audioLoudness));
+            _headData->_audioLoudness = audioLoudness / AUDIO_LOUDNESS_CONVERSION_RATIO;
+            break;
+        }
+        case AVATAR_FIELD_CHAT_MESSAGE: {
+            int chatMessageSize = *sourceBuffer++;
+            _chatMessage = string((char*)sourceBuffer, chatMessageSize);
+            break;
+        }
+        case AVATAR_FIELD_STATE_FLAGS: {
+            unsigned char bitItems = *sourceBuffer;
+
+            // key state, stored as a semi-nibble in the bitItems
+            _keyState = (KeyState)getSemiNibbleAt(bitItems,KEY_STATE_START_BIT);
+
+            // hand state, stored as a semi-nibble in the bitItems
+            _handState = getSemiNibbleAt(bitItems,HAND_STATE_START_BIT);
+
+            _headData->_isFaceshiftConnected = oneAtBit(bitItems, IS_FACESHIFT_CONNECTED);
+            _isChatCirclingEnabled = oneAtBit(bitItems, IS_CHAT_CIRCLING_ENABLED);
+            break;
+        }
+        case AVATAR_FIELD_FACE: {
+            if (!*sourceBuffer++) {
+                break;
+            }
+            float leftEyeBlink, rightEyeBlink, averageLoudness, browAudioLift;
+            sourceBuffer += unpackFloatFromByte(sourceBuffer, leftEyeBlink, 1.0f);
+            sourceBuffer += unpackFloatFromByte(sourceBuffer, rightEyeBlink, 1.0f);
+
             memcpy(&averageLoudness, sourceBuffer, sizeof(float));
             sourceBuffer += sizeof(float);
-            
+
             memcpy(&browAudioLift, sourceBuffer, sizeof(float));
             sourceBuffer += sizeof(float);
-            
-            if (glm::isnan(leftEyeBlink) || glm::isnan(rightEyeBlink) 
+
+            if (glm::isnan(leftEyeBlink) || glm::isnan(rightEyeBlink)
                     || glm::isnan(averageLoudness) || glm::isnan(browAudioLift)) {
                 if (shouldLogError(now)) {
                     qDebug() << "Discard nan AvatarData::faceData; displayName = '" << _displayName << "'";
                 }
-                return maxAvailableSize;
+                return false;
             }
             _headData->_leftEyeBlink = leftEyeBlink;
             _headData->_rightEyeBlink = rightEyeBlink;
             _headData->_averageLoudness = averageLoudness;
             _headData->_browAudioLift = browAudioLift;
-            
-            int numCoefficients = (int)(*sourceBuffer++);
-            int blendDataSize = numCoefficients * sizeof(float);
-            minPossibleSize += blendDataSize;
-            if (minPossibleSize > maxAvailableSize) {
-                if (shouldLogError(now)) {
-                    qDebug() << "Malformed AvatarData packet after Blendshapes;"
-                        << " displayName = '" << _displayName << "'"
-                        << " minPossibleSize = " << minPossibleSize 
-                        << " maxAvailableSize = " << maxAvailableSize;
-                }
-                return maxAvailableSize;
-            }
 
+            int numCoefficients = (int)(*sourceBuffer++);
             _headData->_blendshapeCoefficients.resize(numCoefficients);
-            memcpy(_headData->_blendshapeCoefficients.data(), sourceBuffer, blendDataSize);
-            sourceBuffer += numCoefficients * sizeof(float);
-    
-            //bitItemsDataSize = 4 * sizeof(float) + 1 + blendDataSize;
-        }
-    } // 1 + bitItemsDataSize bytes
-    
-    { // pupil dilation
-        sourceBuffer += unpackFloatFromByte(sourceBuffer, _headData->_pupilDilation, 1.0f);
-    } // 1 byte
-    
-    // joint data
-    int numJoints = *sourceBuffer++;
-    int bytesOfValidity = (int)ceil((float)numJoints / (float)BITS_IN_BYTE);
-    minPossibleSize += bytesOfValidity;
-    if (minPossibleSize > maxAvailableSize) {
-        if (shouldLogError(now)) {
-            qDebug() << "Malformed AvatarData packet after JointValidityBits;"
-                << " displayName = '" << _displayName << "'"
-                << " minPossibleSize = " << minPossibleSize 
-                << " maxAvailableSize = " << maxAvailableSize;
+            for (int i = 0; i < numCoefficients; i++) {
+                sourceBuffer += unpackFloatFromByte(sourceBuffer, _headData->_blendshapeCoefficients[i], 1.0f);
+            }
+            break;
         }
-        return maxAvailableSize;
-    }
-    int numValidJoints = 0;
-    _jointData.resize(numJoints);
-    { // validity bits
-        unsigned char validity = 0;
-        int validityBit = 0;
-        for (int i = 0; i < numJoints; i++) {
-            if (validityBit == 0) {
-                validity = *sourceBuffer++;
+        case AVATAR_FIELD_PUPIL_DILATION:
+            unpackFloatFromByte(sourceBuffer, _headData->_pupilDilation, 1.0f);
+            break;
+
+        case AVATAR_FIELD_JOINTS: {
+            int numJoints = *sourceBuffer++;
+            _jointData.resize(numJoints);
+            { // validity bits
+                unsigned char validity = 0;
+                int validityBit = 0;
+                for (int i = 0; i < numJoints; i++) {
+                    if (validityBit == 0) {
+                        validity = *sourceBuffer++;
+                    }
+                    _jointData[i].valid = (bool)(validity & (1 << validityBit));
+                    validityBit = (validityBit + 1) % BITS_IN_BYTE;
+                }
             }
-            bool valid = (bool)(validity & (1 << validityBit));
-            if (valid) {
-                ++numValidJoints;
+            for (int i = 0; i < numJoints; i++) {
+                JointData& data = _jointData[i];
+                if (data.valid) {
+                    sourceBuffer += unpackOrientationQuatFromSixBytes(sourceBuffer, data.rotation);
+                }
             }
-            _jointData[i].valid = valid;
-            validityBit = (validityBit + 1) % BITS_IN_BYTE; 
-        }
-    }
-    // 1 + bytesOfValidity bytes
-
-    // each joint rotation component is stored in two bytes (sizeof(uint16_t))
-    int COMPONENTS_PER_QUATERNION = 4;
-    minPossibleSize += numValidJoints * COMPONENTS_PER_QUATERNION * sizeof(uint16_t);
-    if (minPossibleSize > maxAvailableSize) {
-        if (shouldLogError(now)) {
-            qDebug() << "Malformed AvatarData packet after JointData;"
-                << " displayName = '" << _displayName << "'"
-                << " minPossibleSize = " << minPossibleSize 
-                << " maxAvailableSize = " << maxAvailableSize;
+            break;
         }
-        return maxAvailableSize;
     }
-
-    { // joint data
-        for (int i = 0; i < numJoints; i++) {
-            JointData& data = _jointData[i];
-            if (data.valid) {
-                sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, data.rotation);
-            }
-        }
-    } // numJoints * 8 bytes
-    
-    return sourceBuffer - startPosition;
+    return true;
 }
 
 void AvatarData::setJointData(int index, const glm::quat& rotation) {
@@ -54,6 +54,31 @@ static const float MIN_AVATAR_SCALE = .005f;
 
 const float MAX_AUDIO_LOUDNESS = 1000.0; // close enough for mouth animation
 
+// Avatar state is sent as a run of fields that are each packed on their own, so that the frames between keyframes can
+// carry only the fields whose packed form differs from the last keyframe's
+enum AvatarDataField {
+    AVATAR_FIELD_POSITION = 0,
+    AVATAR_FIELD_BODY_ROTATION,
+    AVATAR_FIELD_SCALE,
+    AVATAR_FIELD_HEAD_ROTATION,
+    AVATAR_FIELD_HEAD_LEAN,
+    AVATAR_FIELD_LOOK_AT,
+    AVATAR_FIELD_AUDIO_LOUDNESS,
+    AVATAR_FIELD_CHAT_MESSAGE,
+    AVATAR_FIELD_STATE_FLAGS,
+    AVATAR_FIELD_FACE,
+    AVATAR_FIELD_PUPIL_DILATION,
+    AVATAR_FIELD_JOINTS,
+    NUM_AVATAR_FIELDS
+};
+
+// Frame flags
+const int IS_KEYFRAME_BIT = 0;
+
+// Deltas are taken against the last keyframe rather than the previous frame, so a lost delta costs nothing and a lost
+// keyframe only stalls the receiver until the next one
+const int AVATAR_KEYFRAME_INTERVAL = 30; // frames
+
 const int AVATAR_IDENTITY_PACKET_SEND_INTERVAL_MSECS = 1000;
 const int AVATAR_BILLBOARD_PACKET_SEND_INTERVAL_MSECS = 5000;
 
@@ -103,7 +128,13 @@ public:
     glm::vec3 getHandPosition() const;
     void setHandPosition(const glm::vec3& handPosition);
 
-    QByteArray toByteArray();
+    /// Packs the avatar state for sending. Every AVATAR_KEYFRAME_INTERVAL calls the full state goes out as a keyframe,
+    /// otherwise only the fields that differ from the last keyframe are included.
+    /// \param forceKeyframe send the full state now, regardless of when the last keyframe was sent
+    QByteArray toByteArray(bool forceKeyframe = false);
+
+    /// \return true if the data packed by toByteArray() is a keyframe
+    static bool isKeyframe(const QByteArray& avatarData);
 
     /// \return true if an error should be logged
     bool shouldLogError(const quint64& now);
@@ -260,7 +291,21 @@ protected:
 
     quint64 _errorLogExpiry; ///< time in future when to log an error
 
+    // the last keyframe we sent, and the last one we received, which the deltas in each direction are taken against
+    QByteArray _sentKeyframe;
+    QVector<int> _sentKeyframeOffsets;
+    unsigned char _sentKeyframeSequence;
+    int _framesSinceKeyframe;
+    QByteArray _receivedKeyframe;
+    QVector<int> _receivedKeyframeOffsets;
+    unsigned char _receivedKeyframeSequence;
+    bool _hasReceivedKeyframe;
+
 private:
+    void packFields(QByteArray& fields, QVector<int>& offsets);
+    bool unpackField(int field, const unsigned char* sourceBuffer, const quint64& now);
+    static int packedFieldSize(int field, const unsigned char* sourceBuffer, int availableBytes);
+
     // privatize the copy constructor and assignment operator so they cannot be called
     AvatarData(const AvatarData&);
     AvatarData& operator= (const AvatarData&);
@@ -0,0 +1,67 @@
+//
+//  AvatarSimulationLOD.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <SharedUtil.h>
+
+#include "AvatarSimulationLOD.h"
+
+AvatarSimulationLOD::AvatarSimulationLOD() :
+    _blendshapeDistance(DEFAULT_AVATAR_BLENDSHAPE_DISTANCE),
+    _reducedRateDistance(DEFAULT_AVATAR_REDUCED_RATE_DISTANCE),
+    _reducedRate(DEFAULT_AVATAR_REDUCED_RATE) {
+}
+
+AvatarSimulationLOD::Tier AvatarSimulationLOD::getTier(float lodDistance, bool inView) const {
+    if (!inView) {
+        return FROZEN_TIER;
+    }
+    if (lodDistance > _reducedRateDistance) {
+        return REDUCED_RATE_TIER;
+    }
+    return (lodDistance > _blendshapeDistance) ? NO_BLENDSHAPES_TIER : FULL_TIER;
+}
+
+bool AvatarSimulationLOD::isJointUpdateDue(Tier tier, quint64 lastUpdate, quint64 now) const {
+    switch (tier) {
+        case FULL_TIER:
+        case NO_BLENDSHAPES_TIER:
+            return true;
+
+        case REDUCED_RATE_TIER:
+            return _reducedRate <= 0.0f || now - lastUpdate >= (quint64)(USECS_PER_SECOND / _reducedRate);
+
+        default:
+            return false;
+    }
+}
+
+float AvatarSimulationLOD::getJointInterpolation(quint64 lastUpdate, quint64 now) const {
+    if (_reducedRate <= 0.0f) {
+        return 1.0f;
+    }
+    // each update is reached just as the next is due, so the joints trail the data by one interval
+    return qMin((now - lastUpdate) * _reducedRate / USECS_PER_SECOND, 1.0f);
+}
+
+const char* AvatarSimulationLOD::getTierName(Tier tier) {
+    switch (tier) {
+        case FULL_TIER:
+            return "full";
+
+        case NO_BLENDSHAPES_TIER:
+            return "no blendshapes";
+
+        case REDUCED_RATE_TIER:
+            return "reduced rate";
+
+        case FROZEN_TIER:
+            return "frozen";
+
+        default:
+            return "unknown";
+    }
+}
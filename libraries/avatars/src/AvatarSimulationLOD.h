@@ -0,0 +1,58 @@
+//
+//  AvatarSimulationLOD.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Tiers of detail in which other avatars are simulated, by distance and visibility
+//
+
+#ifndef __hifi__AvatarSimulationLOD__
+#define __hifi__AvatarSimulationLOD__
+
+#include <QtCore/QtGlobal>
+
+const float DEFAULT_AVATAR_BLENDSHAPE_DISTANCE = 8.0f;
+const float DEFAULT_AVATAR_REDUCED_RATE_DISTANCE = 16.0f;
+const float DEFAULT_AVATAR_REDUCED_RATE = 10.0f;
+
+/// Decides how much of an avatar to simulate each frame. Near avatars get everything; past the blendshape distance
+/// their faces stop blending; past the reduced rate distance their joints only update a few times a second, blending
+/// from one update to the next in between, while their bodies keep moving every frame; and avatars out of view are
+/// frozen until they come back into it. Distances are LOD distances, so they're scaled by the avatar LOD multiplier and
+/// the avatar's own scale, like the switch to billboards.
+class AvatarSimulationLOD {
+public:
+    enum Tier { FULL_TIER, NO_BLENDSHAPES_TIER, REDUCED_RATE_TIER, FROZEN_TIER, TIER_COUNT };
+
+    AvatarSimulationLOD();
+
+    void setBlendshapeDistance(float distance) { _blendshapeDistance = distance; }
+    float getBlendshapeDistance() const { return _blendshapeDistance; }
+
+    void setReducedRateDistance(float distance) { _reducedRateDistance = distance; }
+    float getReducedRateDistance() const { return _reducedRateDistance; }
+
+    /// Sets the number of times per second that the joints of avatars in the reduced rate tier update, or zero for
+    /// every frame.
+    void setReducedRate(float rate) { _reducedRate = rate; }
+    float getReducedRate() const { return _reducedRate; }
+
+    Tier getTier(float lodDistance, bool inView) const;
+
+    /// \return whether an avatar in the tier, whose joints last updated at lastUpdate, should update them at now
+    bool isJointUpdateDue(Tier tier, quint64 lastUpdate, quint64 now) const;
+
+    /// \return how far the joints of an avatar in the reduced rate tier, whose joints last updated at lastUpdate,
+    /// should have moved from their previous update toward that one by now, from zero to one
+    float getJointInterpolation(quint64 lastUpdate, quint64 now) const;
+
+    static const char* getTierName(Tier tier);
+
+private:
+    float _blendshapeDistance;
+    float _reducedRateDistance;
+    float _reducedRate;
+};
+
+#endif /* defined(__hifi__AvatarSimulationLOD__) */
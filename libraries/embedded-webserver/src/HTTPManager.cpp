@@ -9,9 +9,12 @@
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
 #include <QtCore/QMimeDatabase>
 #include <QtNetwork/QTcpSocket>
 
+#include <MetricsRegistry.h>
+
 #include "HTTPConnection.h"
 #include "HTTPManager.h"
 
@@ -22,6 +25,19 @@ bool HTTPManager::handleHTTPRequest(HTTPConnection* connection, const QUrl& url)
         return true;
     }
     
+    // every server we embed in can be scraped for its metrics
+    if (connection->requestOperation() == QNetworkAccessManager::GetOperation) {
+        if (url.path() == "/metrics") {
+            connection->respond(HTTPConnection::StatusCode200, MetricsRegistry::getInstance()->toPrometheusText(),
+                                "text/plain; version=0.0.4");
+            return true;
+        } else if (url.path() == "/metrics.json") {
+            QJsonDocument metricsDocument(MetricsRegistry::getInstance()->toJSON());
+            connection->respond(HTTPConnection::StatusCode200, metricsDocument.toJson(), "application/json");
+            return true;
+        }
+    }
+    
     // check to see if there is a file to serve from the document root for this path
     QString subPath = url.path();
     
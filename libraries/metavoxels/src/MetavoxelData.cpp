@@ -11,6 +11,7 @@
 #include <QtDebug>
 
 #include <GeometryUtil.h>
+#include <WorkStealingPool.h>
 
 #include "MetavoxelData.h"
 #include "MetavoxelUtil.h"
@@ -784,7 +785,7 @@ void MetavoxelNode::writeSpannerSubdivision(MetavoxelStreamState& state) const {
 }
 
 void MetavoxelNode::decrementReferenceCount(const AttributePointer& attribute) {
-    if (--_referenceCount == 0) {
+    if (!_referenceCount.deref()) {
         destroy(attribute);
         delete this;
     }
@@ -845,7 +846,8 @@ MetavoxelVisitor::MetavoxelVisitor(const QVector<AttributePointer>& inputs,
     _inputs(inputs),
     _outputs(outputs),
     _lod(lod),
-    _minimumLODThresholdMultiplier(FLT_MAX) {
+    _minimumLODThresholdMultiplier(FLT_MAX),
+    _parallelLevels(0) {
     
     // find the minimum LOD threshold multiplier over all attributes
     foreach (const AttributePointer& attribute, _inputs) {
@@ -946,6 +948,18 @@ int RaySpannerIntersectionVisitor::visit(MetavoxelInfo& info, float distance) {
     return info.isLeaf ? STOP_RECURSION : _order;
 }
 
+// the encoded order packs the child indices into three bits apiece
+const int ORDER_ELEMENT_BITS = 3;
+const int ORDER_ELEMENT_MASK = (1 << ORDER_ELEMENT_BITS) - 1;
+
+static MetavoxelVisitation createChildVisitation(MetavoxelVisitation& parent) {
+    MetavoxelVisitation visitation = { &parent, parent.visitor,
+        QVector<MetavoxelNode*>(parent.inputNodes.size()), QVector<MetavoxelNode*>(parent.outputNodes.size()),
+        { glm::vec3(), parent.info.size * 0.5f, QVector<AttributeValue>(parent.inputNodes.size()),
+            QVector<OwnedAttributeValue>(parent.outputNodes.size()) } };
+    return visitation;
+}
+
 DefaultMetavoxelGuide::DefaultMetavoxelGuide() {
 }
 
@@ -975,66 +989,23 @@ bool DefaultMetavoxelGuide::guide(MetavoxelVisitation& visitation) {
     if (encodedOrder == MetavoxelVisitor::STOP_RECURSION) {
         return true;
     }
-    MetavoxelVisitation nextVisitation = { &visitation, visitation.visitor,
-        QVector<MetavoxelNode*>(visitation.inputNodes.size()), QVector<MetavoxelNode*>(visitation.outputNodes.size()),
-        { glm::vec3(), visitation.info.size * 0.5f, QVector<AttributeValue>(visitation.inputNodes.size()),
-            QVector<OwnedAttributeValue>(visitation.outputNodes.size()) } };
-    for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
-        // the encoded order tells us the child indices for each iteration
-        const int ORDER_ELEMENT_BITS = 3;
-        const int ORDER_ELEMENT_MASK = (1 << ORDER_ELEMENT_BITS) - 1;
-        int index = encodedOrder & ORDER_ELEMENT_MASK;
-        encodedOrder >>= ORDER_ELEMENT_BITS;
-        for (int j = 0; j < visitation.inputNodes.size(); j++) {
-            MetavoxelNode* node = visitation.inputNodes.at(j);
-            const AttributeValue& parentValue = visitation.info.inputValues.at(j);
-            MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
-                parentValue.getAttribute()->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
-            nextVisitation.info.inputValues[j] = ((nextVisitation.inputNodes[j] = child)) ?
-                child->getAttributeValue(parentValue.getAttribute()) : parentValue;
-        }
-        for (int j = 0; j < visitation.outputNodes.size(); j++) {
-            MetavoxelNode* node = visitation.outputNodes.at(j);
-            MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
-                visitation.visitor.getOutputs().at(j)->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
-            nextVisitation.outputNodes[j] = child;
-        }
-        nextVisitation.info.minimum = getNextMinimum(visitation.info.minimum, nextVisitation.info.size, index);
-        if (!static_cast<MetavoxelGuide*>(nextVisitation.info.inputValues.last().getInlineValue<
-                SharedObjectPointer>().data())->guide(nextVisitation)) {
+    int parallelLevels = visitation.visitor.getParallelLevels();
+    if (parallelLevels > 0 && visitation.isWithinTopLevels(parallelLevels)) {
+        if (!guideChildrenInParallel(visitation, lodBase, encodedOrder)) {
             return false;
         }
-        for (int j = 0; j < nextVisitation.outputNodes.size(); j++) {
-            OwnedAttributeValue& value = nextVisitation.info.outputValues[j];
-            if (!value.getAttribute()) {
-                continue;
-            }
-            // replace the child
-            OwnedAttributeValue& parentValue = visitation.info.outputValues[j];
-            if (!parentValue.getAttribute()) {
-                // shallow-copy the parent node on first change
-                parentValue = value;
-                MetavoxelNode*& node = visitation.outputNodes[j];
-                if (node) {
-                    node = new MetavoxelNode(value.getAttribute(), node);
-                } else {
-                    // create leaf with inherited value
-                    node = new MetavoxelNode(visitation.getInheritedOutputValue(j));
-                }
-            }
-            MetavoxelNode* node = visitation.outputNodes.at(j);
-            MetavoxelNode* child = node->getChild(i);
-            if (child) {
-                child->decrementReferenceCount(value.getAttribute());
-            } else {
-                // it's a leaf; we need to split it up
-                AttributeValue nodeValue = node->getAttributeValue(value.getAttribute());
-                for (int k = 1; k < MetavoxelNode::CHILD_COUNT; k++) {
-                    node->setChild((index + k) % MetavoxelNode::CHILD_COUNT, new MetavoxelNode(nodeValue));
-                }
+    } else {
+        MetavoxelVisitation nextVisitation = createChildVisitation(visitation);
+        for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+            // the encoded order tells us the child indices for each iteration
+            int index = encodedOrder & ORDER_ELEMENT_MASK;
+            encodedOrder >>= ORDER_ELEMENT_BITS;
+            nextVisitation.setToChild(visitation, lodBase, index);
+            if (!static_cast<MetavoxelGuide*>(nextVisitation.info.inputValues.last().getInlineValue<
+                    SharedObjectPointer>().data())->guide(nextVisitation)) {
+                return false;
             }
-            node->setChild(index, nextVisitation.outputNodes.at(j));
-            value = AttributeValue();
+            nextVisitation.replaceChildOutputs(visitation, index);
         }
     }
     for (int i = 0; i < visitation.outputNodes.size(); i++) {
@@ -1048,6 +1019,68 @@ bool DefaultMetavoxelGuide::guide(MetavoxelVisitation& visitation) {
     return true;
 }
 
+/// Guides one child of a visitation on the work-stealing pool.
+class ChildGuideTask : public WorkStealingTask {
+public:
+    
+    MetavoxelVisitation visitation;
+    bool keepGoing;
+    
+    ChildGuideTask(MetavoxelVisitation& parent);
+    
+    virtual void run();
+};
+
+ChildGuideTask::ChildGuideTask(MetavoxelVisitation& parent) :
+    visitation(createChildVisitation(parent)),
+    keepGoing(true) {
+}
+
+void ChildGuideTask::run() {
+    keepGoing = static_cast<MetavoxelGuide*>(visitation.info.inputValues.last().getInlineValue<
+        SharedObjectPointer>().data())->guide(visitation);
+}
+
+bool DefaultMetavoxelGuide::guideChildrenInParallel(MetavoxelVisitation& visitation, float lodBase, int encodedOrder) {
+    // the children only read from the parent visitation and write to their own, so nothing is shared until they're done
+    WorkStealingPool* pool = WorkStealingPool::getInstance();
+    WorkStealingGroup group;
+    QVector<ChildGuideTask*> tasks;
+    QVector<int> indices;
+    for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+        int index = encodedOrder & ORDER_ELEMENT_MASK;
+        encodedOrder >>= ORDER_ELEMENT_BITS;
+        ChildGuideTask* task = new ChildGuideTask(visitation);
+        task->visitation.setToChild(visitation, lodBase, index);
+        tasks.append(task);
+        indices.append(index);
+        pool->start(task, group);
+    }
+    pool->wait(group);
+    
+    // replace the children in the requested order, stopping where a serial tour would have
+    bool keepGoing = true;
+    for (int i = 0; i < tasks.size(); i++) {
+        MetavoxelVisitation& childVisitation = tasks.at(i)->visitation;
+        if (keepGoing && !(keepGoing = tasks.at(i)->keepGoing)) {
+            continue; // the child that short-circuited leaves its outputs as they are, just as it would have serially
+        }
+        if (keepGoing) {
+            childVisitation.replaceChildOutputs(visitation, indices.at(i));
+            continue;
+        }
+        // later children ran anyway; release the nodes they created, since nothing will reference them
+        for (int j = 0; j < childVisitation.outputNodes.size(); j++) {
+            AttributePointer attribute = childVisitation.info.outputValues.at(j).getAttribute();
+            if (attribute) {
+                childVisitation.outputNodes.at(j)->decrementReferenceCount(attribute);
+            }
+        }
+    }
+    qDeleteAll(tasks);
+    return keepGoing;
+}
+
 ThrobbingMetavoxelGuide::ThrobbingMetavoxelGuide() : _rate(10.0) {
 }
 
@@ -1202,6 +1235,69 @@ AttributeValue MetavoxelVisitation::getInheritedOutputValue(int index) const {
     return AttributeValue(visitor.getOutputs().at(index));
 }
 
+bool MetavoxelVisitation::isWithinTopLevels(int levels) const {
+    const MetavoxelVisitation* visitation = previous;
+    for (int i = 1; i < levels; i++) {
+        if (!visitation) {
+            return true;
+        }
+        visitation = visitation->previous;
+    }
+    return !visitation;
+}
+
+void MetavoxelVisitation::setToChild(const MetavoxelVisitation& parent, float lodBase, int index) {
+    for (int j = 0; j < parent.inputNodes.size(); j++) {
+        MetavoxelNode* node = parent.inputNodes.at(j);
+        const AttributeValue& parentValue = parent.info.inputValues.at(j);
+        MetavoxelNode* child = (node && (parent.info.size >= lodBase *
+            parentValue.getAttribute()->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
+        info.inputValues[j] = ((inputNodes[j] = child)) ? child->getAttributeValue(parentValue.getAttribute()) : parentValue;
+    }
+    for (int j = 0; j < parent.outputNodes.size(); j++) {
+        MetavoxelNode* node = parent.outputNodes.at(j);
+        MetavoxelNode* child = (node && (parent.info.size >= lodBase *
+            visitor.getOutputs().at(j)->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
+        outputNodes[j] = child;
+    }
+    info.minimum = getNextMinimum(parent.info.minimum, info.size, index);
+}
+
+void MetavoxelVisitation::replaceChildOutputs(MetavoxelVisitation& parent, int index) {
+    for (int j = 0; j < outputNodes.size(); j++) {
+        OwnedAttributeValue& value = info.outputValues[j];
+        if (!value.getAttribute()) {
+            continue;
+        }
+        // replace the child
+        OwnedAttributeValue& parentValue = parent.info.outputValues[j];
+        if (!parentValue.getAttribute()) {
+            // shallow-copy the parent node on first change
+            parentValue = value;
+            MetavoxelNode*& node = parent.outputNodes[j];
+            if (node) {
+                node = new MetavoxelNode(value.getAttribute(), node);
+            } else {
+                // create leaf with inherited value
+                node = new MetavoxelNode(parent.getInheritedOutputValue(j));
+            }
+        }
+        MetavoxelNode* node = parent.outputNodes.at(j);
+        MetavoxelNode* child = node->getChild(index);
+        if (child) {
+            child->decrementReferenceCount(value.getAttribute());
+        } else {
+            // it's a leaf; we need to split it up
+            AttributeValue nodeValue = node->getAttributeValue(value.getAttribute());
+            for (int k = 1; k < MetavoxelNode::CHILD_COUNT; k++) {
+                node->setChild((index + k) % MetavoxelNode::CHILD_COUNT, new MetavoxelNode(nodeValue));
+            }
+        }
+        node->setChild(index, outputNodes.at(j));
+        value = AttributeValue();
+    }
+}
+
 const float DEFAULT_GRANULARITY = 0.01f;
 
 Spanner::Spanner() :
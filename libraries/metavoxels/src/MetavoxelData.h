@@ -9,6 +9,7 @@
 #ifndef __interface__MetavoxelData__
 #define __interface__MetavoxelData__
 
+#include <QAtomicInt>
 #include <QBitArray>
 #include <QHash>
 #include <QSharedData>
@@ -161,7 +162,7 @@ public:
     void writeSpannerSubdivision(MetavoxelStreamState& state) const;
 
     /// Increments the node's reference count.
-    void incrementReferenceCount() { _referenceCount++; }
+    void incrementReferenceCount() { _referenceCount.ref(); }
 
     /// Decrements the node's reference count.  If the resulting reference count is zero, destroys the node
     /// and calls delete this.
@@ -176,7 +177,7 @@ private:
     
     void clearChildren(const AttributePointer& attribute);
     
-    int _referenceCount;
+    QAtomicInt _referenceCount;
     void* _attributeValue;
     MetavoxelNode* _children[CHILD_COUNT];
 };
@@ -232,6 +233,12 @@ public:
     
     float getMinimumLODThresholdMultiplier() const { return _minimumLODThresholdMultiplier; }
     
+    /// Sets the number of levels at the top of the tour whose children the default guide visits in parallel.  Only
+    /// visitors whose visit() may be called from several threads at once, in any order, should set this; the default of
+    /// zero visits everything on the calling thread, in the requested order.
+    void setParallelLevels(int parallelLevels) { _parallelLevels = parallelLevels; }
+    int getParallelLevels() const { return _parallelLevels; }
+    
     /// Prepares for a new tour of the metavoxel data.
     virtual void prepare();
     
@@ -246,6 +253,7 @@ protected:
     QVector<AttributePointer> _outputs;
     MetavoxelLOD _lod;
     float _minimumLODThresholdMultiplier;
+    int _parallelLevels;
 };
 
 /// Base class for visitors to spanners.
@@ -332,6 +340,11 @@ public:
     Q_INVOKABLE DefaultMetavoxelGuide();
     
     virtual bool guide(MetavoxelVisitation& visitation);
+
+private:
+    
+    /// Guides the children on the shared work-stealing pool, then replaces the changed ones in order.
+    bool guideChildrenInParallel(MetavoxelVisitation& visitation, float lodBase, int encodedOrder);
 };
 
 /// A temporary test guide that just makes the existing voxels throb with delight.
@@ -402,6 +415,15 @@ public:
     
     bool allInputNodesLeaves() const;
     AttributeValue getInheritedOutputValue(int index) const;
+    
+    /// Checks whether this visitation is one of the first levels of the tour.
+    bool isWithinTopLevels(int levels) const;
+    
+    /// Sets up this visitation for the child of the parent visitation at the given index.
+    void setToChild(const MetavoxelVisitation& parent, float lodBase, int index);
+    
+    /// Replaces the parent's child at the given index with any outputs this visitation changed.
+    void replaceChildOutputs(MetavoxelVisitation& parent, int index);
 };
 
 /// An object that spans multiple octree cells.
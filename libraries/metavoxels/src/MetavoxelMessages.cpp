@@ -8,7 +8,7 @@
 
 #include "MetavoxelMessages.h"
 
-void MetavoxelEditMessage::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void MetavoxelEditMessage::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     static_cast<const MetavoxelEdit*>(edit.data())->apply(data, objects);
 }
 
@@ -31,9 +31,15 @@ private:
     const BoxSetEdit& _edit;
 };
 
+// a box edit can reach every leaf beneath it, so the first two levels are spread over the pool's threads
+const int BOX_SET_PARALLEL_LEVELS = 2;
+
 BoxSetEditVisitor::BoxSetEditVisitor(const BoxSetEdit& edit) :
     MetavoxelVisitor(QVector<AttributePointer>(), QVector<AttributePointer>() << edit.value.getAttribute()),
     _edit(edit) {
+    
+    // visit() only reads the edit and writes the outputs of the metavoxel it's given
+    setParallelLevels(BOX_SET_PARALLEL_LEVELS);
 }
 
 int BoxSetEditVisitor::visit(MetavoxelInfo& info) {
@@ -58,7 +64,7 @@ int BoxSetEditVisitor::visit(MetavoxelInfo& info) {
     return DEFAULT_ORDER; // subdivide
 }
 
-void BoxSetEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void BoxSetEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     // expand to fit the entire edit
     while (!data.getBounds().contains(region)) {
         data.expand();
@@ -94,7 +100,7 @@ int GlobalSetEditVisitor::visit(MetavoxelInfo& info) {
     return STOP_RECURSION; // entirely contained
 }
 
-void GlobalSetEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void GlobalSetEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     GlobalSetEditVisitor visitor(*this);
     data.guide(visitor);
 }
@@ -104,7 +110,7 @@ InsertSpannerEdit::InsertSpannerEdit(const AttributePointer& attribute, const Sh
     spanner(spanner) {
 }
 
-void InsertSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void InsertSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     data.insert(attribute, spanner);
 }
 
@@ -113,8 +119,8 @@ RemoveSpannerEdit::RemoveSpannerEdit(const AttributePointer& attribute, int id)
     id(id) {
 }
 
-void RemoveSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
-    SharedObject* object = objects.value(id);
+void RemoveSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
+    SharedObjectPointer object = objects ? SharedObjectPointer(objects->value(id).data()) : SharedObject::getObject(id);
     if (!object) {
         qDebug() << "Missing object to remove" << id;
         return;
@@ -126,7 +132,7 @@ ClearSpannersEdit::ClearSpannersEdit(const AttributePointer& attribute) :
     attribute(attribute) {
 }
 
-void ClearSpannersEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void ClearSpannersEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     data.clear(attribute);
 }
 
@@ -155,7 +161,7 @@ SetSpannerEdit::SetSpannerEdit(const SharedObjectPointer& spanner) :
     spanner(spanner) {
 }
 
-void SetSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const {
+void SetSpannerEdit::apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const {
     Spanner* spanner = static_cast<Spanner*>(this->spanner.data());
     
     // expand to fit the entire spanner
@@ -66,7 +66,9 @@ public:
     
     STREAM QVariant edit;
     
-    void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    /// Applies the edit to the data.
+    /// \param objects the objects the edit may refer to by ID, or NULL to look them up among all the local objects
+    void apply(MetavoxelData& data, const WeakSharedObjectHash* objects = NULL) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(MetavoxelEditMessage)
@@ -77,7 +79,7 @@ public:
 
     virtual ~MetavoxelEdit();
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const = 0;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const = 0;
 };
 
 /// An edit that sets the region within a box to a value.
@@ -93,7 +95,7 @@ public:
     BoxSetEdit(const Box& region = Box(), float granularity = 0.0f,
         const OwnedAttributeValue& value = OwnedAttributeValue());
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(BoxSetEdit)
@@ -108,7 +110,7 @@ public:
     
     GlobalSetEdit(const OwnedAttributeValue& value = OwnedAttributeValue());
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(GlobalSetEdit)
@@ -125,7 +127,7 @@ public:
     InsertSpannerEdit(const AttributePointer& attribute = AttributePointer(),
         const SharedObjectPointer& spanner = SharedObjectPointer());
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(InsertSpannerEdit)
@@ -141,7 +143,7 @@ public:
     
     RemoveSpannerEdit(const AttributePointer& attribute = AttributePointer(), int id = 0);
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(RemoveSpannerEdit)
@@ -156,7 +158,7 @@ public:
     
     ClearSpannersEdit(const AttributePointer& attribute = AttributePointer());
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(ClearSpannersEdit)
@@ -171,7 +173,7 @@ public:
     
     SetSpannerEdit(const SharedObjectPointer& spanner = SharedObjectPointer());
     
-    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash& objects) const;
+    virtual void apply(MetavoxelData& data, const WeakSharedObjectHash* objects) const;
 };
 
 DECLARE_STREAMABLE_METATYPE(SetSpannerEdit)
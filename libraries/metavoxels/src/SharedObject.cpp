@@ -10,6 +10,7 @@
 #include <QFormLayout>
 #include <QItemEditorFactory>
 #include <QMetaProperty>
+#include <QMutexLocker>
 #include <QVBoxLayout>
 
 #include "Bitstream.h"
@@ -19,24 +20,63 @@
 REGISTER_META_OBJECT(SharedObject)
 
 SharedObject::SharedObject() :
-    _id(++_lastID),
+    _id(_lastID.fetchAndAddOrdered(1) + 1),
     _remoteID(0),
     _referenceCount(0) {
     
-    _weakHash.insert(_id, this);
+    RegistryShard& shard = getRegistryShard(_id);
+    QMutexLocker locker(&shard.mutex);
+    shard.objects.insert(_id, this);
+}
+
+WeakSharedObjectHash SharedObject::getWeakHash() {
+    WeakSharedObjectHash hash;
+    for (int i = 0; i < REGISTRY_SHARD_COUNT; i++) {
+        QMutexLocker locker(&_registryShards[i].mutex);
+        hash.unite(_registryShards[i].objects);
+    }
+    return hash;
+}
+
+SharedObjectPointer SharedObject::getObject(int id) {
+    RegistryShard& shard = getRegistryShard(id);
+    QMutexLocker locker(&shard.mutex);
+    SharedObject* object = shard.objects.value(id);
+    
+    // the count of an object that's being destroyed has already hit zero, but it stays registered (keeping us out)
+    // until it's done
+    if (!(object && object->tryIncrementReferenceCount())) {
+        return SharedObjectPointer();
+    }
+    SharedObjectPointer pointer(object);
+    object->decrementReferenceCount();
+    return pointer;
 }
 
 void SharedObject::incrementReferenceCount() {
-    _referenceCount++;
+    _referenceCount.ref();
 }
 
 void SharedObject::decrementReferenceCount() {
-    if (--_referenceCount == 0) {
-        _weakHash.remove(_id);
+    if (!_referenceCount.deref()) {
+        {
+            RegistryShard& shard = getRegistryShard(_id);
+            QMutexLocker locker(&shard.mutex);
+            shard.objects.remove(_id);
+        }
         delete this;
     }
 }
 
+bool SharedObject::tryIncrementReferenceCount() {
+    for (int count = _referenceCount.load(); count != 0; count = _referenceCount.load()) {
+        if (_referenceCount.testAndSetOrdered(count, count + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 SharedObject* SharedObject::clone() const {
     // default behavior is to make a copy using the no-arg constructor and copy the stored properties
     const QMetaObject* metaObject = this->metaObject();
@@ -91,8 +131,8 @@ void SharedObject::dump(QDebug debug) const {
     }
 }
 
-int SharedObject::_lastID = 0;
-WeakSharedObjectHash SharedObject::_weakHash;
+QAtomicInt SharedObject::_lastID(0);
+SharedObject::RegistryShard SharedObject::_registryShards[SharedObject::REGISTRY_SHARD_COUNT];
 
 void pruneWeakSharedObjectHash(WeakSharedObjectHash& hash) {
     for (WeakSharedObjectHash::iterator it = hash.begin(); it != hash.end(); ) {
@@ -9,8 +9,10 @@
 #ifndef __interface__SharedObject__
 #define __interface__SharedObject__
 
+#include <QAtomicInt>
 #include <QHash>
 #include <QMetaType>
+#include <QMutex>
 #include <QObject>
 #include <QPointer>
 #include <QSet>
@@ -21,6 +23,8 @@ class QComboBox;
 
 class SharedObject;
 
+template<class T> class SharedObjectPointerTemplate;
+
 typedef QHash<int, QPointer<SharedObject> > WeakSharedObjectHash;
 
 /// A QObject that may be shared over the network.
@@ -29,8 +33,13 @@ class SharedObject : public QObject {
     
 public:
 
-    /// Returns the weak hash under which all local shared objects are registered.
-    static const WeakSharedObjectHash& getWeakHash() { return _weakHash; }
+    /// Returns a snapshot of the weak hash under which all local shared objects are registered.  This copies every shard
+    /// of the registry, so look objects up one at a time with getObject wherever that will do.
+    static WeakSharedObjectHash getWeakHash();
+
+    /// Returns a reference to the local object with the specified ID, or a null pointer if there isn't one that's
+    /// currently referenced.  Unlike a pointer taken from the weak hash, this can't race with the object's destruction.
+    static SharedObjectPointerTemplate<SharedObject> getObject(int id);
 
     Q_INVOKABLE SharedObject();
 
@@ -42,7 +51,7 @@ public:
     
     void setRemoteID(int remoteID) { _remoteID = remoteID; }
 
-    int getReferenceCount() const { return _referenceCount; }
+    int getReferenceCount() const { return _referenceCount.load(); }
     void incrementReferenceCount();
     void decrementReferenceCount();
 
@@ -57,12 +66,27 @@ public:
 
 private:
     
+    /// Increments the reference count unless it has already dropped to zero.
+    bool tryIncrementReferenceCount();
+    
     int _id;
     int _remoteID;
-    int _referenceCount;
+    QAtomicInt _referenceCount;
+    
+    /// One slice of the registry; objects are spread over the shards by ID so that threads creating and destroying
+    /// objects rarely contend for the same lock.
+    class RegistryShard {
+    public:
+        QMutex mutex;
+        WeakSharedObjectHash objects;
+    };
+    
+    static const int REGISTRY_SHARD_COUNT = 16;
+    
+    static RegistryShard& getRegistryShard(int id) { return _registryShards[(uint)id % REGISTRY_SHARD_COUNT]; }
     
-    static int _lastID;
-    static WeakSharedObjectHash _weakHash;
+    static QAtomicInt _lastID;
+    static RegistryShard _registryShards[REGISTRY_SHARD_COUNT];
 };
 
 /// Removes the null references from the supplied hash.
@@ -204,6 +204,37 @@ bool AABox::findRayIntersection(const glm::vec3& origin, const glm::vec3& direct
     return false;
 }
 
+bool AABox::findRayIntersection(const glm::vec3& corner, float scale, const glm::vec3& origin,
+                                const glm::vec3& direction, const glm::vec3& inverseDirection,
+                                float& distance, BoxFace& face) {
+    float entryDistance = -FLT_MAX;
+    float exitDistance = FLT_MAX;
+    BoxFace entryFace = MIN_X_FACE;
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0.0f) {
+            // parallel to this axis' slab, so the ray is either always within it or never
+            if (origin[axis] < corner[axis] || origin[axis] > corner[axis] + scale) {
+                return false;
+            }
+            continue;
+        }
+        bool positive = direction[axis] > 0.0f;
+        float axisEntry = ((positive ? corner[axis] : corner[axis] + scale) - origin[axis]) * inverseDirection[axis];
+        float axisExit = ((positive ? corner[axis] + scale : corner[axis]) - origin[axis]) * inverseDirection[axis];
+        if (axisEntry > entryDistance) {
+            entryDistance = axisEntry;
+            entryFace = (BoxFace)(axis * 2 + (positive ? 0 : 1));
+        }
+        exitDistance = glm::min(exitDistance, axisExit);
+    }
+    if (exitDistance < entryDistance || exitDistance < 0.0f) {
+        return false;
+    }
+    distance = glm::max(entryDistance, 0.0f);
+    face = entryFace;
+    return true;
+}
+
 bool AABox::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration) const {
     glm::vec4 center4 = glm::vec4(center, 1.0f);
     
@@ -65,6 +65,12 @@ public:
     bool expandedContains(const glm::vec3& point, float expansion) const;
     bool expandedIntersectsSegment(const glm::vec3& start, const glm::vec3& end, float expansion) const;
     bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance, BoxFace& face) const;
+
+    /// Slab test for casting one ray at many boxes, with the ray's inverse direction worked out once up front. Like
+    /// findRayIntersection, a box containing the origin is hit at distance 0.
+    static bool findRayIntersection(const glm::vec3& corner, float scale, const glm::vec3& origin,
+                                    const glm::vec3& direction, const glm::vec3& inverseDirection,
+                                    float& distance, BoxFace& face);
     bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration) const;
     bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration) const;
 
@@ -0,0 +1,143 @@
+//
+//  CoverageBuffer.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cfloat>
+#include <cmath>
+
+#include <QtCore/QDebug>
+
+#include "CoverageBuffer.h"
+
+const float CoverageBuffer::NOT_COVERED = FLT_MAX;
+
+static int cellAt(float coordinate) {
+    return qBound(0, (int)floorf((coordinate + 1.0f) * 0.5f * CoverageBuffer::RESOLUTION), CoverageBuffer::RESOLUTION - 1);
+}
+
+static float cellEdge(int cell) {
+    return cell * 2.0f / CoverageBuffer::RESOLUTION - 1.0f;
+}
+
+CoverageBuffer::CoverageBuffer() :
+    _checkCount(0),
+    _occludedCount(0),
+    _storedCount(0)
+{
+    for (int resolution = RESOLUTION; resolution > 0; resolution >>= 1) {
+        _levels.append(QVector<float>(resolution * resolution, NOT_COVERED));
+    }
+}
+
+CoverageMapStorageResult CoverageBuffer::checkBuffer(const OctreeProjectedPolygon& polygon, float nearDistance,
+                                                     float farDistance, bool storeIt) {
+    _checkCount++;
+    int minX = cellAt(polygon.getMinX());
+    int minY = cellAt(polygon.getMinY());
+    int maxX = cellAt(polygon.getMaxX());
+    int maxY = cellAt(polygon.getMaxY());
+
+    if (isCovered(_levels.size() - 1, 0, 0, minX, minY, maxX, maxY, nearDistance)) {
+        _occludedCount++;
+        return OCCLUDED;
+    }
+    if (storeIt && store(polygon, farDistance, minX, minY, maxX, maxY)) {
+        _storedCount++;
+        return STORED;
+    }
+    return NOT_STORED;
+}
+
+void CoverageBuffer::erase() {
+    for (int i = 0; i < _levels.size(); i++) {
+        _levels[i].fill(NOT_COVERED);
+    }
+    _checkCount = 0;
+    _occludedCount = 0;
+    _storedCount = 0;
+}
+
+void CoverageBuffer::printStats() const {
+    qDebug("CoverageBuffer: checks=%d occluded=%d stored=%d", _checkCount, _occludedCount, _storedCount);
+}
+
+bool CoverageBuffer::isCovered(int level, int cellX, int cellY, int minX, int minY, int maxX, int maxY,
+                               float nearDistance) const {
+    int resolution = RESOLUTION >> level;
+    if (_levels[level][cellY * resolution + cellX] < nearDistance) {
+        return true; // everything beneath this cell is covered by something nearer
+    }
+    if (level == 0) {
+        return false;
+    }
+    // otherwise every child that overlaps the polygon's cells has to settle it
+    int childLevel = level - 1;
+    for (int childY = cellY << 1; childY <= (cellY << 1) + 1; childY++) {
+        if ((childY << childLevel) > maxY || ((childY + 1) << childLevel) <= minY) {
+            continue;
+        }
+        for (int childX = cellX << 1; childX <= (cellX << 1) + 1; childX++) {
+            if ((childX << childLevel) > maxX || ((childX + 1) << childLevel) <= minX) {
+                continue;
+            }
+            if (!isCovered(childLevel, childX, childY, minX, minY, maxX, maxY, nearDistance)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CoverageBuffer::store(const OctreeProjectedPolygon& polygon, float farDistance,
+                           int minX, int minY, int maxX, int maxY) {
+    // only cells whose corners are all inside the polygon count as covered, so the buffer never claims more than the
+    // polygon hides; neighboring cells share corners, so test each corner once
+    int cornersWide = maxX - minX + 2;
+    int cornersHigh = maxY - minY + 2;
+    QVector<char> inside(cornersWide * cornersHigh);
+    for (int y = 0; y < cornersHigh; y++) {
+        for (int x = 0; x < cornersWide; x++) {
+            inside[y * cornersWide + x] = polygon.pointInside(glm::vec2(cellEdge(minX + x), cellEdge(minY + y)));
+        }
+    }
+
+    QVector<float>& finest = _levels[0];
+    bool stored = false;
+    for (int y = 0; y < cornersHigh - 1; y++) {
+        for (int x = 0; x < cornersWide - 1; x++) {
+            int corner = y * cornersWide + x;
+            if (inside[corner] && inside[corner + 1] && inside[corner + cornersWide] && inside[corner + cornersWide + 1]) {
+                float& depth = finest[(minY + y) * RESOLUTION + minX + x];
+                if (farDistance < depth) {
+                    depth = farDistance;
+                    stored = true;
+                }
+            }
+        }
+    }
+    if (!stored) {
+        return false;
+    }
+
+    // refresh the coarser cells above the ones that changed
+    for (int level = 1; level < _levels.size(); level++) {
+        minX >>= 1;
+        minY >>= 1;
+        maxX >>= 1;
+        maxY >>= 1;
+        int resolution = RESOLUTION >> level;
+        const QVector<float>& children = _levels[level - 1];
+        QVector<float>& cells = _levels[level];
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                int child = (y << 1) * (resolution << 1) + (x << 1);
+                cells[y * resolution + x] = qMax(qMax(children[child], children[child + 1]),
+                    qMax(children[child + (resolution << 1)], children[child + (resolution << 1) + 1]));
+            }
+        }
+    }
+    return true;
+}
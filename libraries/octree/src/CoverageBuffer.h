@@ -0,0 +1,59 @@
+//
+//  CoverageBuffer.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Low resolution occupancy pyramid of the screen, an alternative to CoverageMap for server side occlusion culling
+//
+
+#ifndef __hifi__CoverageBuffer__
+#define __hifi__CoverageBuffer__
+
+#include <QtCore/QVector>
+
+#include "CoverageMap.h"
+#include "OctreeProjectedPolygon.h"
+
+/// Rasterizes the shadows of stored polygons into a grid over the -1 to 1 screen space the polygons are projected into.
+/// Each finest cell keeps the farthest depth of the nearest polygon that covers it completely, and each coarser cell
+/// keeps the largest depth of its four children, so a check can stop at the coarsest cells that settle it. Unlike
+/// CoverageMap, which only occludes a polygon that a single stored polygon covers, the buffer occludes a polygon
+/// covered by any combination of them.
+///
+/// Depths are conservative: polygons are stored at the far side of their voxel and checked at the near side, so the
+/// answer doesn't depend on the order the encoder visits them in.
+class CoverageBuffer {
+public:
+    static const int RESOLUTION = 128; // finest cells along each side of the screen
+    static const float NOT_COVERED;
+
+    CoverageBuffer();
+
+    /// \param nearDistance the distance to the nearest point of the polygon's voxel
+    /// \param farDistance the distance to the farthest point, which is what covered cells record when stored
+    /// \return OCCLUDED if every cell the polygon touches is covered by something nearer, otherwise STORED if storeIt
+    /// and the polygon covered at least one cell more closely than before, else NOT_STORED
+    CoverageMapStorageResult checkBuffer(const OctreeProjectedPolygon& polygon, float nearDistance, float farDistance,
+                                         bool storeIt);
+
+    /// Clears all coverage, for the start of a new scene.
+    void erase();
+
+    int getCheckCount() const { return _checkCount; }
+    int getOccludedCount() const { return _occludedCount; }
+    int getStoredCount() const { return _storedCount; }
+
+    void printStats() const;
+
+private:
+    bool isCovered(int level, int cellX, int cellY, int minX, int minY, int maxX, int maxY, float nearDistance) const;
+    bool store(const OctreeProjectedPolygon& polygon, float farDistance, int minX, int minY, int maxX, int maxY);
+
+    QVector<QVector<float> > _levels; // finest first, each a row major grid of RESOLUTION >> level cells a side
+    int _checkCount;
+    int _occludedCount;
+    int _storedCount;
+};
+
+#endif /* defined(__hifi__CoverageBuffer__) */
@@ -0,0 +1,111 @@
+//
+//  JurisdictionIndex.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <OctalCode.h>
+
+#include "JurisdictionIndex.h"
+
+JurisdictionIndex::TrieNode::TrieNode() {
+    for (int i = 0; i < 8; i++) {
+        children[i] = NO_CHILD;
+    }
+}
+
+JurisdictionIndex::JurisdictionIndex() :
+    _compiledVersion(NOT_COMPILED)
+{
+}
+
+void JurisdictionIndex::update(const NodeToJurisdictionMap& jurisdictions, int version) {
+    if (version != _compiledVersion) {
+        compile(jurisdictions);
+        _compiledVersion = version;
+    }
+}
+
+void JurisdictionIndex::compile(const NodeToJurisdictionMap& jurisdictions) {
+    _servers.clear();
+    _trie.clear();
+    _trie.append(TrieNode());
+
+    for (NodeToJurisdictionMap::const_iterator i = jurisdictions.constBegin(); i != jurisdictions.constEnd(); ++i) {
+        const JurisdictionMap& map = i.value();
+
+        // a server without a root has no jurisdiction at all
+        if (!map.getRootOctalCode()) {
+            continue;
+        }
+        int server = _servers.size();
+        _servers.append(i.key());
+
+        _trie[insertCode(map.getRootOctalCode())].roots.append(server);
+        for (int endNode = 0; endNode < map.getEndNodeCount(); endNode++) {
+            if (map.getEndNodeOctalCode(endNode)) {
+                _trie[insertCode(map.getEndNodeOctalCode(endNode))].endNodes.append(server);
+            }
+        }
+    }
+    resolve(0, QSet<int>(), QSet<int>());
+}
+
+int JurisdictionIndex::insertCode(const unsigned char* octalCode) {
+    int trieNode = 0;
+    int length = numberOfThreeBitSectionsInCode(octalCode);
+    for (int section = 0; section < length; section++) {
+        int value = getOctalCodeSectionValue(octalCode, section);
+        if (_trie[trieNode].children[value] == NO_CHILD) {
+            _trie[trieNode].children[value] = _trie.size();
+            _trie.append(TrieNode());
+        }
+        trieNode = _trie[trieNode].children[value];
+    }
+    return trieNode;
+}
+
+void JurisdictionIndex::resolve(int trieNode, const QSet<int>& inherited, const QSet<int>& excluded) {
+    // an element is within a server's jurisdiction if it's strictly below the root, and isn't at or below an end node
+    QSet<int> excludedHere = excluded;
+    foreach (int server, _trie[trieNode].endNodes) {
+        excludedHere.insert(server);
+    }
+
+    QSet<int> withinAtNode = inherited;
+    withinAtNode.subtract(excludedHere);
+
+    QSet<int> withinBelowNode = withinAtNode;
+    foreach (int server, _trie[trieNode].roots) {
+        if (!excludedHere.contains(server)) {
+            withinBelowNode.insert(server);
+        }
+    }
+
+    _trie[trieNode].withinAtNode = withinAtNode.toList().toVector();
+    _trie[trieNode].withinBelowNode = withinBelowNode.toList().toVector();
+
+    for (int i = 0; i < 8; i++) {
+        int child = _trie[trieNode].children[i];
+        if (child != NO_CHILD) {
+            resolve(child, withinBelowNode, excludedHere);
+        }
+    }
+}
+
+const QVector<int>& JurisdictionIndex::serversFor(const unsigned char* octalCode) const {
+    if (_trie.isEmpty() || !octalCode) {
+        return _noServers;
+    }
+    int trieNode = 0;
+    int length = numberOfThreeBitSectionsInCode(octalCode);
+    for (int section = 0; section < length; section++) {
+        int child = _trie[trieNode].children[(int)getOctalCodeSectionValue(octalCode, section)];
+        if (child == NO_CHILD) {
+            return _trie[trieNode].withinBelowNode;
+        }
+        trieNode = child;
+    }
+    return _trie[trieNode].withinAtNode;
+}
@@ -0,0 +1,65 @@
+//
+//  JurisdictionIndex.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Finds every server whose jurisdiction an octal code is within, with a single walk down the code
+//
+
+#ifndef __hifi__JurisdictionIndex__
+#define __hifi__JurisdictionIndex__
+
+#include <QtCore/QSet>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+
+#include "JurisdictionMap.h"
+
+/// Compiled form of the jurisdictions of a set of servers. The roots and end nodes of all the jurisdictions are merged into
+/// one trie of octal code sections. Each node of the trie knows which servers an element at that node is WITHIN, and which
+/// servers an element below it is WITHIN when the rest of its code isn't in the trie, so a lookup never has to look at the
+/// jurisdictions themselves.
+class JurisdictionIndex {
+public:
+    JurisdictionIndex();
+
+    /// Recompiles the index if the jurisdictions have changed since it was last compiled.
+    /// \param version the writers' count of changes to the map, bumped by them on every insert, remove or clear
+    void update(const NodeToJurisdictionMap& jurisdictions, int version);
+
+    /// Rebuilds the index from the jurisdictions.
+    void compile(const NodeToJurisdictionMap& jurisdictions);
+
+    /// \return indexes (see getServerUUID()) of the servers whose jurisdiction the octal code is WITHIN, the same answer
+    /// as checking each server's JurisdictionMap::isMyJurisdiction() with CHECK_NODE_ONLY
+    const QVector<int>& serversFor(const unsigned char* octalCode) const;
+
+    const QUuid& getServerUUID(int server) const { return _servers.at(server); }
+    int getServerCount() const { return _servers.size(); }
+
+private:
+    class TrieNode {
+    public:
+        TrieNode();
+        int children[8]; // indexes into _trie, or NO_CHILD
+
+        QVector<int> roots; // servers whose jurisdiction is rooted here
+        QVector<int> endNodes; // servers with an end node here
+
+        QVector<int> withinAtNode; // servers an element at this node is within
+        QVector<int> withinBelowNode; // servers an element below this node, that isn't in the trie, is within
+    };
+    static const int NO_CHILD = -1;
+    static const int NOT_COMPILED = -1;
+
+    int insertCode(const unsigned char* octalCode);
+    void resolve(int trieNode, const QSet<int>& inherited, const QSet<int>& excluded);
+
+    int _compiledVersion; // the version update() last compiled, or NOT_COMPILED
+    QVector<QUuid> _servers;
+    QVector<TrieNode> _trie;
+    QVector<int> _noServers;
+};
+
+#endif /* defined(__hifi__JurisdictionIndex__) */
@@ -11,6 +11,8 @@
 #ifndef __shared__JurisdictionListener__
 #define __shared__JurisdictionListener__
 
+#include <QtCore/QAtomicInt>
+
 #include <NodeList.h>
 #include <PacketSender.h>
 #include <ReceivedPacketProcessor.h>
@@ -34,6 +36,9 @@ public:
 
     NodeToJurisdictionMap* getJurisdictions() { return &_jurisdictions; };
 
+    /// \return count of changes made to getJurisdictions(), for telling when it needs to be looked at again
+    const QAtomicInt* getJurisdictionsVersion() const { return &_jurisdictionsVersion; }
+
 
     NodeType_t getNodeType() const { return _nodeType; }
     void setNodeType(NodeType_t type) { _nodeType = type; }
@@ -53,6 +58,7 @@ protected:
 
 private:
     NodeToJurisdictionMap _jurisdictions;
+    QAtomicInt _jurisdictionsVersion;
     NodeType_t _nodeType;
 
     bool queueJurisdictionRequest();
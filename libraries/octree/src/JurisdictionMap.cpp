@@ -90,6 +90,8 @@ void JurisdictionMap::clear() {
         }
     }
     _endNodes.clear();
+    _rootSections.clear();
+    _endNodeTrie.clear();
 }
 
 JurisdictionMap::JurisdictionMap(NodeType_t type) : _rootOctalCode(NULL) {
@@ -172,6 +174,7 @@ JurisdictionMap::JurisdictionMap(const char* rootHexCode, const char* endNodesHe
         myDebugPrintOctalCode(endNodeOctcode, true);
 
     }    
+    compile();
 }
 
 
@@ -179,29 +182,93 @@ void JurisdictionMap::init(unsigned char* rootOctalCode, const std::vector<unsig
     clear(); // clean up our own memory
     _rootOctalCode = rootOctalCode;
     _endNodes = endNodes;
+    compile();
+}
+
+JurisdictionMap::EndNodeTrieNode::EndNodeTrieNode() : isEndNode(false) {
+    for (int i = 0; i < 8; i++) {
+        children[i] = NO_TRIE_CHILD;
+    }
+}
+
+void JurisdictionMap::compile() {
+    _rootSections.clear();
+    _endNodeTrie.clear();
+    
+    if (_rootOctalCode) {
+        int rootLength = numberOfThreeBitSectionsInCode(_rootOctalCode);
+        for (int section = 0; section < rootLength; section++) {
+            _rootSections.append(getOctalCodeSectionValue(_rootOctalCode, section));
+        }
+    }
+    
+    if (!_endNodes.empty()) {
+        _endNodeTrie.append(EndNodeTrieNode());
+        for (size_t i = 0; i < _endNodes.size(); i++) {
+            if (!_endNodes[i]) {
+                continue;
+            }
+            int trieNode = 0;
+            int endNodeLength = numberOfThreeBitSectionsInCode(_endNodes[i]);
+            for (int section = 0; section < endNodeLength; section++) {
+                int value = getOctalCodeSectionValue(_endNodes[i], section);
+                if (_endNodeTrie[trieNode].children[value] == NO_TRIE_CHILD) {
+                    _endNodeTrie[trieNode].children[value] = _endNodeTrie.size();
+                    _endNodeTrie.append(EndNodeTrieNode());
+                }
+                trieNode = _endNodeTrie[trieNode].children[value];
+            }
+            _endNodeTrie[trieNode].isEndNode = true;
+        }
+    }
 }
 
 JurisdictionMap::Area JurisdictionMap::isMyJurisdiction(const unsigned char* nodeOctalCode, int childIndex) const {
+    if (!_rootOctalCode || !nodeOctalCode) {
+        return BELOW;
+    }
+    
     // to be in our jurisdiction, we must be under the root...
+    int nodeLength = numberOfThreeBitSectionsInCode(nodeOctalCode);
+    int rootLength = _rootSections.size();
 
     // if the node is an ancestor of my root, then we return ABOVE
-    if (isAncestorOf(nodeOctalCode, _rootOctalCode)) {
-        return ABOVE;
+    if (nodeLength <= rootLength) {
+        bool isAncestorOfRoot = true;
+        for (int section = 0; section < nodeLength && isAncestorOfRoot; section++) {
+            isAncestorOfRoot = (getOctalCodeSectionValue(nodeOctalCode, section) == _rootSections[section]);
+        }
+        if (isAncestorOfRoot) {
+            return ABOVE;
+        }
+    }
+    
+    // otherwise the node (or its child, if we were given one) has to be a descendant of the root
+    int descendantLength = (childIndex == CHECK_NODE_ONLY) ? nodeLength : nodeLength + 1;
+    if (rootLength > descendantLength) {
+        return BELOW;
+    }
+    for (int section = 0; section < rootLength; section++) {
+        char sectionValue = (section < nodeLength) ? getOctalCodeSectionValue(nodeOctalCode, section) : childIndex;
+        if (sectionValue != _rootSections[section]) {
+            return BELOW;
+        }
     }
     
-    // otherwise...
-    bool isInJurisdiction = isAncestorOf(_rootOctalCode, nodeOctalCode, childIndex);
     // if we're under the root, then we can't be under any of the endpoints
-    if (isInJurisdiction) {
-        for (size_t i = 0; i < _endNodes.size(); i++) {
-            bool isUnderEndNode = isAncestorOf(_endNodes[i], nodeOctalCode);
-            if (isUnderEndNode) {
-                isInJurisdiction = false;
+    if (!_endNodeTrie.isEmpty()) {
+        int trieNode = 0;
+        for (int section = 0; trieNode != NO_TRIE_CHILD; section++) {
+            if (_endNodeTrie[trieNode].isEndNode) {
+                return BELOW;
+            }
+            if (section == nodeLength) {
                 break;
             }
+            trieNode = _endNodeTrie[trieNode].children[(int)getOctalCodeSectionValue(nodeOctalCode, section)];
         }
     }
-    return isInJurisdiction ? WITHIN : BELOW;
+    return WITHIN;
 }
 
 
@@ -228,6 +295,7 @@ bool JurisdictionMap::readFromFile(const char* filename) {
         _endNodes.push_back(octcode);
     }
     settings.endGroup();
+    compile();
     return true;
 }
 
@@ -368,6 +436,7 @@ int JurisdictionMap::unpackFromMessage(const unsigned char* sourceBuffer, int av
             }
         }
     }
+    compile();
     
     return sourceBuffer - startPosition; // includes header!
 }
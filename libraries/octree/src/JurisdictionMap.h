@@ -15,6 +15,7 @@
 
 #include <QtCore/QString>
 #include <QtCore/QUuid>
+#include <QtCore/QVector>
 
 #include <Node.h>
 
@@ -71,10 +72,25 @@ private:
     void copyContents(const JurisdictionMap& other); // use assignment instead
     void clear();
     void init(unsigned char* rootOctalCode, const std::vector<unsigned char*>& endNodes);
+    void compile();
+
+    /// A node in the trie of end node octal code sections, so that isMyJurisdiction() can check all the end nodes with a
+    /// single walk down the code
+    class EndNodeTrieNode {
+    public:
+        EndNodeTrieNode();
+        int children[8]; // indexes into _endNodeTrie, or NO_TRIE_CHILD
+        bool isEndNode;
+    };
+    static const int NO_TRIE_CHILD = -1;
 
     unsigned char* _rootOctalCode;
     std::vector<unsigned char*> _endNodes;
     NodeType_t _nodeType;
+
+    // the root and end nodes in the form isMyJurisdiction() uses, rebuilt by compile() whenever they change
+    QVector<char> _rootSections;
+    QVector<EndNodeTrieNode> _endNodeTrie;
 };
 
 /// Map between node IDs and their reported JurisdictionMap. Typically used by classes that need to know which nodes are 
@@ -53,6 +53,8 @@ bool JurisdictionSender::process() {
         } else {
             sizeOut = JurisdictionMap::packEmptyJurisdictionIntoMessage(getNodeType(), bufferOut, MAX_PACKET_SIZE);
         }
+        // every requester gets the same packet, which the send queue copies into its own buffers
+        QByteArray jurisdictionPacket = QByteArray::fromRawData(reinterpret_cast<char*>(bufferOut), sizeOut);
         int nodeCount = 0;
 
         lockRequestingNodes();
@@ -63,7 +65,7 @@ bool JurisdictionSender::process() {
             SharedNodePointer node = NodeList::getInstance()->nodeWithUUID(nodeUUID);
 
             if (node && node->getActiveSocket()) {
-                _packetSender.queuePacketForSending(node, QByteArray(reinterpret_cast<char *>(bufferOut), sizeOut));
+                _packetSender.queuePacketForSending(node, jurisdictionPacket);
                 nodeCount++;
             }
         }
@@ -17,6 +17,7 @@
 
 #include <QDebug>
 
+#include "CoverageBuffer.h"
 #include "CoverageMap.h"
 #include <GeometryUtil.h>
 #include "OctalCode.h"
@@ -28,6 +29,7 @@
 #include "ViewFrustum.h"
 #include "OctreeConstants.h"
 #include "OctreeElementBag.h"
+#include "OctreeSnapshot.h"
 #include "Octree.h"
 
 float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeScale) {
@@ -40,6 +42,7 @@ Octree::Octree(bool shouldReaverage) :
     _shouldReaverage(shouldReaverage),
     _stopImport(false),
     _lock(),
+    _isSnapshotStale(1),
     _isViewing(false) 
 {
 }
@@ -50,6 +53,16 @@ Octree::~Octree() {
     delete _rootNode;
 }
 
+// Adapts a RecurseOctreeOperation to the visitor walks.
+class OperationVisitor {
+public:
+    OperationVisitor(RecurseOctreeOperation operation, void* extraData) : _operation(operation), _extraData(extraData) { }
+    bool visit(OctreeElement* element) { return _operation(element, _extraData); }
+private:
+    RecurseOctreeOperation _operation;
+    void* _extraData;
+};
+
 // Recurses voxel tree calling the RecurseOctreeOperation function for each node.
 // stops recursion if operation function returns false.
 void Octree::recurseTreeWithOperation(RecurseOctreeOperation operation, void* extraData) {
@@ -61,22 +74,11 @@ void Octree::recurseTreeWithPostOperation(RecurseOctreeOperation operation, void
     recurseNodeWithPostOperation(_rootNode, operation, extraData);
 }
 
-// Recurses voxel node with an operation function
+// Recurses voxel node with an operation function. The walk uses an explicit stack, so it has no depth limit.
 void Octree::recurseNodeWithOperation(OctreeElement* node, RecurseOctreeOperation operation, void* extraData,
                         int recursionCount) {
-    if (recursionCount > DANGEROUSLY_DEEP_RECURSION) {
-        qDebug() << "Octree::recurseNodeWithOperation() reached DANGEROUSLY_DEEP_RECURSION, bailing!";
-        return;
-    }
-
-    if (operation(node, extraData)) {
-        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
-            OctreeElement* child = node->getChildAtIndex(i);
-            if (child) {
-                recurseNodeWithOperation(child, operation, extraData, recursionCount+1);
-            }
-        }
-    }
+    OperationVisitor visitor(operation, extraData);
+    visitSubTree(node, visitor);
 }
 
 // Recurses voxel node with an operation function
@@ -96,15 +98,15 @@ void Octree::recurseNodeWithPostOperation(OctreeElement* node, RecurseOctreeOper
 	operation(node, extraData);
 }
 
-// Recurses voxel tree calling the RecurseOctreeOperation function for each node.
+// Recurses voxel tree calling the RecurseOctreeOperation function for each node, children nearest the point first.
 // stops recursion if operation function returns false.
 void Octree::recurseTreeWithOperationDistanceSorted(RecurseOctreeOperation operation,
                                                        const glm::vec3& point, void* extraData) {
-
-    recurseNodeWithOperationDistanceSorted(_rootNode, operation, point, extraData);
+    OperationVisitor visitor(operation, extraData);
+    visitTreeNearestFirst(point, visitor);
 }
 
-// Recurses voxel node with an operation function
+// Recurses voxel node with an operation function, children nearest the point first
 void Octree::recurseNodeWithOperationDistanceSorted(OctreeElement* node, RecurseOctreeOperation operation,
                                                        const glm::vec3& point, void* extraData, int recursionCount) {
 
@@ -114,31 +116,14 @@ void Octree::recurseNodeWithOperationDistanceSorted(OctreeElement* node, Recurse
     }
 
     if (operation(node, extraData)) {
-        // determine the distance sorted order of our children
-        OctreeElement* sortedChildren[NUMBER_OF_CHILDREN] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-        float distancesToChildren[NUMBER_OF_CHILDREN] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-        int indexOfChildren[NUMBER_OF_CHILDREN] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-        int currentCount = 0;
-
+        const AABox& box = node->getAABox();
+        float halfScale = box.getScale() * 0.5f;
+        int octant = (point.x >= box.getCorner().x + halfScale ? 4 : 0) |
+            (point.y >= box.getCorner().y + halfScale ? 2 : 0) | (point.z >= box.getCorner().z + halfScale ? 1 : 0);
         for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
-            OctreeElement* childNode = node->getChildAtIndex(i);
-            if (childNode) {
-                // chance to optimize, doesn't need to be actual distance!! Could be distance squared
-                float distanceSquared = childNode->distanceSquareToPoint(point);
-                //qDebug("recurseNodeWithOperationDistanceSorted() CHECKING child[%d] point=%f,%f center=%f,%f distance=%f...\n", i, point.x, point.y, center.x, center.y, distance);
-                //childNode->printDebugDetails("");
-                currentCount = insertIntoSortedArrays((void*)childNode, distanceSquared, i,
-                                                      (void**)&sortedChildren, (float*)&distancesToChildren,
-                                                      (int*)&indexOfChildren, currentCount, NUMBER_OF_CHILDREN);
-            }
-        }
-
-        for (int i = 0; i < currentCount; i++) {
-            OctreeElement* childNode = sortedChildren[i];
+            OctreeElement* childNode = node->getChildAtIndex(NEAREST_FIRST_CHILD_ORDERS[octant][i]);
             if (childNode) {
-                //qDebug("recurseNodeWithOperationDistanceSorted() PROCESSING child[%d] distance=%f...\n", i, distancesToChildren[i]);
-                //childNode->printDebugDetails("");
-                recurseNodeWithOperationDistanceSorted(childNode, operation, point, extraData);
+                recurseNodeWithOperationDistanceSorted(childNode, operation, point, extraData, recursionCount + 1);
             }
         }
     }
@@ -215,7 +200,7 @@ int Octree::readNodeData(OctreeElement* destinationNode, const unsigned char* no
             if (!destinationNode->getChildAtIndex(i)) {
                 destinationNode->addChildAtIndex(i);
                 if (destinationNode->isDirty()) {
-                    _isDirty = true;
+                    setDirtyBit();
                 }
             }
 
@@ -234,7 +219,7 @@ int Octree::readNodeData(OctreeElement* destinationNode, const unsigned char* no
                 nodeIsDirty = childNodeAt->isDirty();
             }
             if (nodeIsDirty) {
-                _isDirty = true;
+                setDirtyBit();
             }
         }
     }
@@ -255,7 +240,7 @@ int Octree::readNodeData(OctreeElement* destinationNode, const unsigned char* no
                 destinationNode->addChildAtIndex(childIndex);
                 bool nodeIsDirty = destinationNode->isDirty();
                 if (nodeIsDirty) {
-                    _isDirty = true;
+                    setDirtyBit();
                 }
             }
 
@@ -272,7 +257,7 @@ int Octree::readNodeData(OctreeElement* destinationNode, const unsigned char* no
             // subtree/node, because it shouldn't actually exist in the tree.
             if (!oneAtBit(childrenInTreeMask, i) && destinationNode->getChildAtIndex(i)) {
                 destinationNode->safeDeepDeleteChildAtIndex(i);
-                _isDirty = true; // by definition!
+                setDirtyBit(); // by definition!
             }
         }
     }
@@ -303,7 +288,7 @@ void Octree::readBitstreamToTree(const unsigned char * bitstream, unsigned long
             // octal code is always relative to root!
             bitstreamRootNode = createMissingNode(args.destinationNode, (unsigned char*) bitstreamAt);
             if (bitstreamRootNode->isDirty()) {
-                _isDirty = true;
+                setDirtyBit();
             }
         }
 
@@ -400,7 +385,7 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
             }
             ancestorNode = ancestorNode->getChildAtIndex(index);
         }
-        _isDirty = true;
+        setDirtyBit();
         args->pathChanged = true;
 
         // ends recursion, unwinds up stack
@@ -423,7 +408,7 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
         node->deleteChildAtIndex(childIndex); // note: this will track dirtiness and lastChanged for this node
 
         // track our tree dirtiness
-        _isDirty = true;
+        setDirtyBit();
 
         // track that path has changed
         args->pathChanged = true;
@@ -450,7 +435,7 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
 void Octree::eraseAllOctreeElements() {
     delete _rootNode; // this will recurse and delete all children
     _rootNode = createNewElement();
-    _isDirty = true;
+    setDirtyBit();
 }
 
 void Octree::processRemoveOctreeElementsBitstream(const unsigned char* bitstream, int bufferSizeBytes) {
@@ -543,42 +528,52 @@ OctreeElement* Octree::getOrCreateChildElementAt(float x, float y, float z, floa
 }
 
 
-// combines the ray cast arguments into a single object
-class RayArgs {
-public:
-    glm::vec3 origin;
-    glm::vec3 direction;
-    OctreeElement*& node;
-    float& distance;
-    BoxFace& face;
-    bool found;
-};
-
-bool findRayIntersectionOp(OctreeElement* node, void* extraData) {
-    RayArgs* args = static_cast<RayArgs*>(extraData);
-    AABox box = node->getAABox();
-    float distance;
-    BoxFace face;
-    if (!box.findRayIntersection(args->origin, args->direction, distance, face)) {
-        return false;
-    }
-    if (!node->isLeaf()) {
-        return true; // recurse on children
-    }
-    distance *= TREE_SCALE;
-    if (node->hasContent() && (!args->found || distance < args->distance)) {
-        args->node = node;
-        args->distance = distance;
-        args->face = face;
-        args->found = true;
+// The queries below walk the tree with an explicit stack instead of recurseTreeWithOperation, so a query is a loop
+// over elements rather than a callback per element.
+
+static bool findRayIntersectionInTree(OctreeElement* root, const glm::vec3& origin, const glm::vec3& direction,
+                                      OctreeElement*& element, float& distance, BoxFace& face) {
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    int nearestChild = OctreeElement::getNearestChildIndexForRay(direction);
+
+    OctreeElementStack stack;
+    float rootDistance;
+    BoxFace rootFace;
+    if (AABox::findRayIntersection(root->getAABox().getCorner(), root->getAABox().getScale(), origin, direction,
+            inverseDirection, rootDistance, rootFace)) {
+        stack.append(root);
+    }
+    while (!stack.isEmpty()) {
+        OctreeElement* next = stack.last();
+        stack.removeLast();
+        if (next->isLeaf()) {
+            if (next->hasContent()) {
+                // elements come off the stack nearest first, so the first leaf with content is the one the ray hits
+                const AABox& box = next->getAABox();
+                AABox::findRayIntersection(box.getCorner(), box.getScale(), origin, direction, inverseDirection,
+                                           distance, face);
+                element = next;
+                distance *= TREE_SCALE;
+                return true;
+            }
+            continue;
+        }
+        // push the farthest children first, so the nearest come off the stack first
+        for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+            OctreeElement* child = next->getChildAtIndex(i ^ nearestChild);
+            float childDistance;
+            BoxFace childFace;
+            if (child && AABox::findRayIntersection(child->getAABox().getCorner(), child->getAABox().getScale(),
+                    origin, direction, inverseDirection, childDistance, childFace)) {
+                stack.append(child);
+            }
+        }
     }
     return false;
 }
 
 bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
                                     OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType) {
-    RayArgs args = { origin / (float)(TREE_SCALE), direction, node, distance, face };
-
     bool gotLock = false;
     if (lockType == Octree::Lock) {
         lockForRead();
@@ -586,59 +581,27 @@ bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direc
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            return false; // if we wanted to tryLock, and we couldn't then just bail...
         }
     }
 
-    recurseTreeWithOperation(findRayIntersectionOp, &args);
+    bool found = _rootNode && findRayIntersectionInTree(_rootNode, origin / (float)(TREE_SCALE), direction,
+                                                        node, distance, face);
 
     if (gotLock) {
         unlock();
     }
 
-    return args.found;
-}
-
-class SphereArgs {
-public:
-    glm::vec3 center;
-    float radius;
-    glm::vec3& penetration;
-    bool found;
-    void* penetratedObject; /// the type is defined by the type of Octree, the caller is assumed to know the type
-};
-
-bool findSpherePenetrationOp(OctreeElement* element, void* extraData) {
-    SphereArgs* args = static_cast<SphereArgs*>(extraData);
-
-    // coarse check against bounds
-    const AABox& box = element->getAABox();
-    if (!box.expandedContains(args->center, args->radius)) {
-        return false;
-    }
-    if (!element->isLeaf()) {
-        return true; // recurse on children
-    }
-    if (element->hasContent()) {
-        glm::vec3 elementPenetration;
-        if (element->findSpherePenetration(args->center, args->radius, elementPenetration, &args->penetratedObject)) {
-            // NOTE: it is possible for this penetration accumulation algorithm to produce a final penetration vector with zero length.
-            args->penetration = addPenetrations(args->penetration, elementPenetration * (float)(TREE_SCALE));
-            args->found = true;
-        }
-    }
-    return false;
+    return found;
 }
 
 bool Octree::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
                     void** penetratedObject, Octree::lockType lockType) {
 
-    SphereArgs args = {
-        center / (float)(TREE_SCALE),
-        radius / (float)(TREE_SCALE),
-        penetration,
-        false,
-        NULL };
+    glm::vec3 scaledCenter = center / (float)(TREE_SCALE);
+    float scaledRadius = radius / (float)(TREE_SCALE);
+    void* lastPenetratedObject = NULL; /// the type is defined by the type of Octree, the caller is assumed to know the type
+    bool found = false;
     penetration = glm::vec3(0.0f, 0.0f, 0.0f);
 
     bool gotLock = false;
@@ -648,61 +611,58 @@ bool Octree::findSpherePenetration(const glm::vec3& center, float radius, glm::v
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            return found; // if we wanted to tryLock, and we couldn't then just bail...
         }
     }
 
-    recurseTreeWithOperation(findSpherePenetrationOp, &args);
+    OctreeElementStack stack;
+    if (_rootNode) {
+        stack.append(_rootNode);
+    }
+    while (!stack.isEmpty()) {
+        OctreeElement* element = stack.last();
+        stack.removeLast();
+
+        // coarse check against bounds
+        if (!element->getAABox().expandedContains(scaledCenter, scaledRadius)) {
+            continue;
+        }
+        if (!element->isLeaf()) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = element->getChildAtIndex(i);
+                if (child) {
+                    stack.append(child);
+                }
+            }
+            continue;
+        }
+        if (element->hasContent()) {
+            glm::vec3 elementPenetration;
+            if (element->findSpherePenetration(scaledCenter, scaledRadius, elementPenetration, &lastPenetratedObject)) {
+                // NOTE: it is possible for this penetration accumulation algorithm to produce a final penetration vector with zero length.
+                penetration = addPenetrations(penetration, elementPenetration * (float)(TREE_SCALE));
+                found = true;
+            }
+        }
+    }
     if (penetratedObject) {
-        *penetratedObject = args.penetratedObject;
+        *penetratedObject = lastPenetratedObject;
     }
 
     if (gotLock) {
         unlock();
     }
     
-    return args.found;
-}
-
-class CapsuleArgs {
-public:
-    glm::vec3 start;
-    glm::vec3 end;
-    float radius;
-    glm::vec3& penetration;
-    bool found;
-};
-
-bool findCapsulePenetrationOp(OctreeElement* node, void* extraData) {
-    CapsuleArgs* args = static_cast<CapsuleArgs*>(extraData);
-
-    // coarse check against bounds
-    const AABox& box = node->getAABox();
-    if (!box.expandedIntersectsSegment(args->start, args->end, args->radius)) {
-        return false;
-    }
-    if (!node->isLeaf()) {
-        return true; // recurse on children
-    }
-    if (node->hasContent()) {
-        glm::vec3 nodePenetration;
-        if (box.findCapsulePenetration(args->start, args->end, args->radius, nodePenetration)) {
-            args->penetration = addPenetrations(args->penetration, nodePenetration * (float)(TREE_SCALE));
-            args->found = true;
-        }
-    }
-    return false;
+    return found;
 }
 
 bool Octree::findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, 
                     glm::vec3& penetration, Octree::lockType lockType) {
                     
-    CapsuleArgs args = {
-        start / (float)(TREE_SCALE),
-        end / (float)(TREE_SCALE),
-        radius / (float)(TREE_SCALE),
-        penetration,
-        false };
+    glm::vec3 scaledStart = start / (float)(TREE_SCALE);
+    glm::vec3 scaledEnd = end / (float)(TREE_SCALE);
+    float scaledRadius = radius / (float)(TREE_SCALE);
+    bool found = false;
     penetration = glm::vec3(0.0f, 0.0f, 0.0f);
 
     bool gotLock = false;
@@ -712,16 +672,61 @@ bool Octree::findCapsulePenetration(const glm::vec3& start, const glm::vec3& end
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            return found; // if we wanted to tryLock, and we couldn't then just bail...
         }
     }
 
-    recurseTreeWithOperation(findCapsulePenetrationOp, &args);
+    OctreeElementStack stack;
+    if (_rootNode) {
+        stack.append(_rootNode);
+    }
+    while (!stack.isEmpty()) {
+        OctreeElement* element = stack.last();
+        stack.removeLast();
+
+        // coarse check against bounds
+        const AABox& box = element->getAABox();
+        if (!box.expandedIntersectsSegment(scaledStart, scaledEnd, scaledRadius)) {
+            continue;
+        }
+        if (!element->isLeaf()) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = element->getChildAtIndex(i);
+                if (child) {
+                    stack.append(child);
+                }
+            }
+            continue;
+        }
+        if (element->hasContent()) {
+            glm::vec3 elementPenetration;
+            if (box.findCapsulePenetration(scaledStart, scaledEnd, scaledRadius, elementPenetration)) {
+                penetration = addPenetrations(penetration, elementPenetration * (float)(TREE_SCALE));
+                found = true;
+            }
+        }
+    }
     
     if (gotLock) {
         unlock();
     }
-    return args.found;
+    return found;
+}
+
+void Octree::publishSnapshot() {
+    _isSnapshotStale.store(0); // before the copy, so a change that races past the caller's lock is caught next time
+    QSharedPointer<const OctreeSnapshot> snapshot(new OctreeSnapshot(this));
+    QMutexLocker locker(&_snapshotMutex);
+    _snapshot = snapshot;
+}
+
+QSharedPointer<const OctreeSnapshot> Octree::getSnapshot() const {
+    QMutexLocker locker(&_snapshotMutex);
+    return _snapshot;
+}
+
+void Octree::copySnapshotColor(const OctreeElement* element, unsigned char* color) const {
+    memset(color, 0, BYTES_PER_COLOR);
 }
 
 class GetElementEnclosingArgs {
@@ -862,6 +867,35 @@ int Octree::encodeTreeBitstream(OctreeElement* node,
     return bytesWritten;
 }
 
+// Checks an element's shadow against whichever occlusion backend the client asked for, storing it if storeIt. Shadows that
+// aren't all in view are never occluded and never stored.
+static CoverageMapStorageResult checkOcclusion(EncodeBitstreamParams& params, OctreeElement* element, bool storeIt) {
+    AABox voxelBox = element->getAABox();
+    voxelBox.scale(TREE_SCALE);
+    OctreeProjectedPolygon* voxelPolygon = new OctreeProjectedPolygon(params.viewFrustum->getProjectedPolygon(voxelBox));
+    if (!voxelPolygon->getAllInView()) {
+        delete voxelPolygon;
+        return NOT_STORED;
+    }
+    CoverageMapStorageResult result;
+    if (params.coverageBuffer) {
+        // the polygon's distance is to the center of the box, so widen it to the box's nearest and farthest points
+        const float HALF_DIAGONAL = sqrtf(3.0f) * 0.5f;
+        float halfDiagonal = voxelBox.getScale() * HALF_DIAGONAL;
+        result = params.coverageBuffer->checkBuffer(*voxelPolygon, voxelPolygon->getDistance() - halfDiagonal,
+                                                    voxelPolygon->getDistance() + halfDiagonal, storeIt);
+        delete voxelPolygon;
+        return result;
+    }
+    result = params.map->checkMap(voxelPolygon, storeIt);
+
+    // In the case where it is stored, the CoverageMap will free memory for us later.
+    if (result != STORED) {
+        delete voxelPolygon;
+    }
+    return result;
+}
+
 int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
                                             OctreePacketData* packetData, OctreeElementBag& bag,
                                             EncodeBitstreamParams& params, int& currentEncodeLevel,
@@ -983,29 +1017,31 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
             return bytesAtThisLevel;
         }
 
+        // If the receiver told us it already has this subtree, and the subtree hasn't changed since the version they have,
+        // then there's no need to send any of it
+        if (params.subtreeVersions && !params.subtreeVersions->isEmpty()) {
+            const unsigned char* octalCode = node->getOctalCode();
+            QByteArray subtreeKey = QByteArray::fromRawData(reinterpret_cast<const char*>(octalCode),
+                                        bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode)));
+            OctreeSubtreeVersions::const_iterator cachedVersion = params.subtreeVersions->constFind(subtreeKey);
+            if (cachedVersion != params.subtreeVersions->constEnd() && !node->hasChangedSince(cachedVersion.value())) {
+                if (params.stats) {
+                    params.stats->skippedNoChange(node);
+                }
+                params.stopReason = EncodeBitstreamParams::NO_CHANGE;
+                return bytesAtThisLevel;
+            }
+        }
+
         // If the user also asked for occlusion culling, check if this node is occluded, but only if it's not a leaf.
         // leaf occlusion is handled down below when we check child nodes
         if (params.wantOcclusionCulling && !node->isLeaf()) {
-            AABox voxelBox = node->getAABox();
-            voxelBox.scale(TREE_SCALE);
-            OctreeProjectedPolygon* voxelPolygon = new OctreeProjectedPolygon(params.viewFrustum->getProjectedPolygon(voxelBox));
-
-            // In order to check occlusion culling, the shadow has to be "all in view" otherwise, we will ignore occlusion
-            // culling and proceed as normal
-            if (voxelPolygon->getAllInView()) {
-                CoverageMapStorageResult result = params.map->checkMap(voxelPolygon, false);
-                delete voxelPolygon; // cleanup
-                if (result == OCCLUDED) {
-                    if (params.stats) {
-                        params.stats->skippedOccluded(node);
-                    }
-                    params.stopReason = EncodeBitstreamParams::OCCLUDED;
-                    return bytesAtThisLevel;
+            if (checkOcclusion(params, node, false) == OCCLUDED) {
+                if (params.stats) {
+                    params.stats->skippedOccluded(node);
                 }
-            } else {
-                // If this shadow wasn't "all in view" then we ignored it for occlusion culling, but
-                // we do need to clean up memory and proceed as normal...
-                delete voxelPolygon;
+                params.stopReason = EncodeBitstreamParams::OCCLUDED;
+                return bytesAtThisLevel;
             }
         }
     }
@@ -1116,31 +1152,10 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
 
                 // If the user also asked for occlusion culling, check if this node is occluded
                 if (params.wantOcclusionCulling && childNode->isLeaf()) {
-                    // Don't check occlusion here, just add them to our distance ordered array...
-
-                    AABox voxelBox = childNode->getAABox();
-                    voxelBox.scale(TREE_SCALE);
-                    OctreeProjectedPolygon* voxelPolygon = new OctreeProjectedPolygon(
-                                params.viewFrustum->getProjectedPolygon(voxelBox));
-
-                    // In order to check occlusion culling, the shadow has to be "all in view" otherwise, we will ignore occlusion
-                    // culling and proceed as normal
-                    if (voxelPolygon->getAllInView()) {
-                        CoverageMapStorageResult result = params.map->checkMap(voxelPolygon, true);
-
-                        // In all cases where the shadow wasn't stored, we need to free our own memory.
-                        // In the case where it is stored, the CoverageMap will free memory for us later.
-                        if (result != STORED) {
-                            delete voxelPolygon;
-                        }
-
-                        // If while attempting to add this voxel's shadow, we determined it was occluded, then
-                        // we don't need to process it further and we can exit early.
-                        if (result == OCCLUDED) {
-                            childIsOccluded = true;
-                        }
-                    } else {
-                        delete voxelPolygon;
+                    // If while attempting to add this voxel's shadow, we determined it was occluded, then
+                    // we don't need to process it further and we can exit early.
+                    if (checkOcclusion(params, childNode, true) == OCCLUDED) {
+                        childIsOccluded = true;
                     }
                 } // wants occlusion culling & isLeaf()
 
@@ -12,12 +12,14 @@
 #include <set>
 #include <SimpleMovingAverage.h>
 
+class CoverageBuffer;
 class CoverageMap;
 class ReadBitstreamToTreeParams;
 class Octree;
 class OctreeElement;
 class OctreeElementBag;
 class OctreePacketData;
+class OctreeSnapshot;
 
 
 #include "JurisdictionMap.h"
@@ -27,11 +29,56 @@ class OctreePacketData;
 #include "OctreePacketData.h"
 #include "OctreeSceneStats.h"
 
+#include <QAtomicInt>
+#include <QDebug>
+#include <QMutex>
 #include <QObject>
 #include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QVarLengthArray>
 
 // Callback function, for recuseTreeWithOperation
 typedef bool (*RecurseOctreeOperation)(OctreeElement* node, void* extraData);
+
+/// Elements waiting to be visited by a depth first walk. A walk holds at most seven siblings per level, so this rarely
+/// leaves the stack.
+typedef QVarLengthArray<OctreeElement*, 256> OctreeElementStack;
+
+/// Visits with an existing RecurseOctreeOperation named at compile time, so the walk can inline it rather than call
+/// through a pointer. The operation can be a private static member where the class names it.
+template<RecurseOctreeOperation Operation> class OctreeOperationVisitor {
+public:
+    OctreeOperationVisitor(void* extraData = NULL) : _extraData(extraData) { }
+    bool visit(OctreeElement* element) { return Operation(element, _extraData); }
+private:
+    void* _extraData;
+};
+
+/// One level of a visitor's walk: the element whose children are being visited, the order to visit them in, and how
+/// many of them have been looked at.
+class OctreeVisitFrame {
+public:
+    OctreeElement* element;
+    const unsigned char* childOrder;
+    int nextChild;
+};
+typedef QVarLengthArray<OctreeVisitFrame, 32> OctreeVisitStack;
+
+/// The children of an element in index order.
+const unsigned char INDEX_CHILD_ORDER[NUMBER_OF_CHILDREN] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+/// For each octant a point can be in relative to an element's center, the element's children from the one in that octant
+/// out to the one opposite: those sharing two halves with the point, then one, then none.
+const unsigned char NEAREST_FIRST_CHILD_ORDERS[NUMBER_OF_CHILDREN][NUMBER_OF_CHILDREN] = {
+    { 0, 1, 2, 4, 3, 5, 6, 7 },
+    { 1, 0, 3, 5, 2, 4, 7, 6 },
+    { 2, 3, 0, 6, 1, 7, 4, 5 },
+    { 3, 2, 1, 7, 0, 6, 5, 4 },
+    { 4, 5, 6, 0, 7, 1, 2, 3 },
+    { 5, 4, 7, 1, 6, 0, 3, 2 },
+    { 6, 7, 4, 2, 5, 3, 0, 1 },
+    { 7, 6, 5, 3, 4, 2, 1, 0 }
+};
 typedef enum {GRADIENT, RANDOM, NATURAL} creationMode;
 
 const bool NO_EXISTS_BITS         = false;
@@ -51,7 +98,9 @@ const quint64 IGNORE_LAST_SENT  = 0;
 #define IGNORE_SCENE_STATS       NULL
 #define IGNORE_VIEW_FRUSTUM      NULL
 #define IGNORE_COVERAGE_MAP      NULL
+#define IGNORE_COVERAGE_BUFFER   NULL
 #define IGNORE_JURISDICTION_MAP  NULL
+#define IGNORE_SUBTREE_VERSIONS  NULL
 
 class EncodeBitstreamParams {
 public:
@@ -70,7 +119,9 @@ public:
     bool forceSendScene;
     OctreeSceneStats* stats;
     CoverageMap* map;
+    CoverageBuffer* coverageBuffer; // when set, occlusion culling uses this instead of the map
     JurisdictionMap* jurisdictionMap;
+    const OctreeSubtreeVersions* subtreeVersions; // subtrees the receiver already has, skipped if unchanged since
 
     // output hints from the encode process
     typedef enum {
@@ -118,7 +169,9 @@ public:
             forceSendScene(forceSendScene),
             stats(stats),
             map(map),
+            coverageBuffer(IGNORE_COVERAGE_BUFFER),
             jurisdictionMap(jurisdictionMap),
+            subtreeVersions(IGNORE_SUBTREE_VERSIONS),
             stopReason(UNKNOWN)
     {}
 
@@ -214,12 +267,30 @@ public:
     void recurseTreeWithOperationDistanceSorted(RecurseOctreeOperation operation,
                                                 const glm::vec3& point, void* extraData = NULL);
 
+    /// Walks the tree depth first, parents before children and children in index order, like recurseTreeWithOperation.
+    /// The visitor is any class with a bool visit(OctreeElement* element) that returns whether to go on to the element's
+    /// children. Its type is known here, unlike a RecurseOctreeOperation's, so the compiler can inline the call, and
+    /// the walk is a loop over an explicit stack rather than a recursion. The stack holds only the elements being
+    /// descended through, and each child is read from its parent when its turn comes, so a visit may delete the
+    /// element's children or siblings. It mustn't delete the element's ancestors, or the element itself and then return
+    /// true. Like the recursion, the walk goes no deeper than DANGEROUSLY_DEEP_RECURSION.
+    template<class Visitor> void visitTree(Visitor& visitor) { visitSubTree(_rootNode, visitor); }
+    template<class Visitor> void visitSubTree(OctreeElement* element, Visitor& visitor) {
+        walkSubTree(element, visitor, false, glm::vec3());
+    }
+
+    /// Like visitTree, but visits each element's children nearest to the point first, by the octant the point is in.
+    /// \param point in the tree's 0 to 1 units
+    template<class Visitor> void visitTreeNearestFirst(const glm::vec3& point, Visitor& visitor) {
+        walkSubTree(_rootNode, visitor, true, point);
+    }
+
     int encodeTreeBitstream(OctreeElement* node, OctreePacketData* packetData, OctreeElementBag& bag,
                             EncodeBitstreamParams& params) ;
 
     bool isDirty() const { return _isDirty; }
     void clearDirtyBit() { _isDirty = false; }
-    void setDirtyBit() { _isDirty = true; }
+    void setDirtyBit() { _isDirty = true; _isSnapshotStale.store(1); }
 
     // Octree does not currently handle its own locking, caller must use these to lock/unlock
     void lockForRead() { _lock.lockForRead(); }
@@ -245,6 +316,19 @@ public:
 
     OctreeElement* getElementEnclosingPoint(const glm::vec3& point, Octree::lockType lockType = Octree::TryLock);
 
+    /// Copies the tree into a new snapshot for queries that shouldn't wait on, or give up on, the tree's lock. Call with at
+    /// least a read lock held, whenever the tree has changed enough to matter.
+    void publishSnapshot();
+
+    /// \return whether the tree has changed since the last snapshot was published, whoever has cleared the dirty bit since
+    bool isSnapshotStale() const { return _isSnapshotStale.load() != 0; }
+
+    /// \return the last published snapshot, which may trail the tree or be null. Safe to call and query from any thread.
+    QSharedPointer<const OctreeSnapshot> getSnapshot() const;
+
+    /// Fills in the color a snapshot reports for a leaf with content. Black, unless the tree has colors.
+    virtual void copySnapshotColor(const OctreeElement* element, unsigned char* color) const;
+
     // Note: this assumes the fileFormat is the HIO individual voxels code files
     void loadOctreeFile(const char* fileName, bool wantColorRandomizer);
 
@@ -283,6 +367,10 @@ public slots:
 
 
 protected:
+    /// The walk behind visitSubTree and visitTreeNearestFirst.
+    template<class Visitor> void walkSubTree(OctreeElement* element, Visitor& visitor, bool nearestFirst,
+        const glm::vec3& point);
+
     void deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraData);
 
     int encodeTreeBitstreamRecursion(OctreeElement* node,
@@ -304,6 +392,10 @@ protected:
     bool _stopImport;
 
     QReadWriteLock _lock;
+
+    QAtomicInt _isSnapshotStale; // set with the dirty bit, but only cleared by publishing
+    mutable QMutex _snapshotMutex; // only held to swap or copy the pointer, never while a snapshot is built
+    QSharedPointer<const OctreeSnapshot> _snapshot;
     
     /// This tree is receiving inbound viewer datagrams.
     bool _isViewing;
@@ -311,4 +403,49 @@ protected:
 
 float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeScale);
 
+template<class Visitor> inline void Octree::walkSubTree(OctreeElement* element, Visitor& visitor, bool nearestFirst,
+        const glm::vec3& point) {
+    if (!element || !visitor.visit(element)) {
+        return;
+    }
+    OctreeVisitStack stack;
+    OctreeVisitFrame frame = { element, INDEX_CHILD_ORDER, 0 };
+    while (true) {
+        if (nearestFirst) {
+            const AABox& box = frame.element->getAABox();
+            float halfScale = box.getScale() * 0.5f;
+            const glm::vec3& corner = box.getCorner();
+            int octant = (point.x >= corner.x + halfScale ? 4 : 0) | (point.y >= corner.y + halfScale ? 2 : 0) |
+                (point.z >= corner.z + halfScale ? 1 : 0);
+            frame.childOrder = NEAREST_FIRST_CHILD_ORDERS[octant];
+        }
+        stack.append(frame);
+
+        // find the next child to descend into, popping the levels that have run out
+        bool descend = false;
+        while (!descend && !stack.isEmpty()) {
+            OctreeVisitFrame& top = stack.last();
+            if (top.nextChild == NUMBER_OF_CHILDREN) {
+                stack.removeLast();
+                continue;
+            }
+            OctreeElement* child = top.element->getChildAtIndex(top.childOrder[top.nextChild++]);
+            if (!child || !visitor.visit(child)) {
+                continue;
+            }
+            if (stack.size() > DANGEROUSLY_DEEP_RECURSION) {
+                qDebug() << "Octree::walkSubTree() reached DANGEROUSLY_DEEP_RECURSION, bailing!";
+                continue;
+            }
+            frame.element = child;
+            frame.childOrder = INDEX_CHILD_ORDER;
+            frame.nextChild = 0;
+            descend = true;
+        }
+        if (!descend) {
+            return;
+        }
+    }
+}
+
 #endif /* defined(__hifi__Octree__) */
@@ -0,0 +1,288 @@
+//
+//  OctreeCache.cpp
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+
+#include <OctalCode.h>
+#include <PacketHeaders.h>
+#include <UUID.h>
+
+#include "OctreeElementBag.h"
+#include "OctreePacketData.h"
+
+#include "OctreeCache.h"
+
+OctreeCache::ServerCache::ServerCache() :
+    isLoaded(false),
+    isRevalidating(false),
+    hasSceneStats(false),
+    cachedOctreeSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
+    cachedBoundaryLevelAdjust(NO_BOUNDARY_ADJUST),
+    hasQueriedView(false),
+    queriedOctreeSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
+    queriedBoundaryLevelAdjust(NO_BOUNDARY_ADJUST)
+{
+}
+
+OctreeCache::OctreeCache(const QString& name) :
+    _name(name),
+    _directory(QDir::tempPath())
+{
+}
+
+QString OctreeCache::pathForServer(const QUuid& serverUUID) const {
+    return QDir(_directory).filePath(QString("%1-%2.svo").arg(_name, uuidStringWithoutCurlyBraces(serverUUID)));
+}
+
+QByteArray OctreeCache::keyForElement(const OctreeElement* element) {
+    const unsigned char* octalCode = element->getOctalCode();
+    return QByteArray(reinterpret_cast<const char*>(octalCode),
+                      bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode)));
+}
+
+bool OctreeCache::isSimilarView(const ViewFrustum& cachedView, float cachedOctreeSizeScale, int cachedBoundaryLevelAdjust,
+                                const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust) {
+    return cachedOctreeSizeScale == octreeSizeScale && cachedBoundaryLevelAdjust == boundaryLevelAdjust
+        && cachedView.isVerySimilar(viewFrustum);
+}
+
+// Note: must be called with the tree locked
+void OctreeCache::collectSubtrees(Octree* tree, const JurisdictionMap& jurisdiction,
+                                  QList<OctreeElement*>& subtrees) const {
+    QList<OctreeElement*> elements;
+    elements.append(tree->getRoot());
+    while (!elements.isEmpty()) {
+        OctreeElement* element = elements.takeFirst();
+        if (element->getLevel() < CACHED_SUBTREE_LEVEL) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = element->getChildAtIndex(i);
+                if (child) {
+                    elements.append(child);
+                }
+            }
+        } else if (jurisdiction.isMyJurisdiction(element->getOctalCode(), CHECK_NODE_ONLY) == JurisdictionMap::WITHIN) {
+            subtrees.append(element);
+        }
+    }
+}
+
+bool OctreeCache::loadServer(const QUuid& serverUUID, Octree* tree, const ViewFrustum& viewFrustum,
+                             float octreeSizeScale, int boundaryLevelAdjust) {
+    QMutexLocker locker(&_mutex);
+    ServerCache& server = _servers[serverUUID];
+    if (server.isLoaded) {
+        return false;
+    }
+    server.isLoaded = true;
+
+    QFile file(pathForServer(serverUUID));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 format;
+    quint8 packetType, packetVersion;
+    in >> format >> packetType >> packetVersion;
+    PacketType expectedType = tree->expectedDataPacketType();
+    if (format != CACHE_FILE_FORMAT || packetType != expectedType || packetVersion != versionForPacketType(expectedType)) {
+        qDebug() << "Ignoring out of date octree cache" << file.fileName();
+        return false;
+    }
+
+    glm::vec3 position, eyeOffsetPosition;
+    glm::quat orientation;
+    float fieldOfView, aspectRatio, nearClip, farClip, cachedOctreeSizeScale;
+    qint32 cachedBoundaryLevelAdjust;
+    in >> position.x >> position.y >> position.z;
+    in >> orientation.x >> orientation.y >> orientation.z >> orientation.w;
+    in >> fieldOfView >> aspectRatio >> nearClip >> farClip;
+    in >> eyeOffsetPosition.x >> eyeOffsetPosition.y >> eyeOffsetPosition.z;
+    in >> cachedOctreeSizeScale >> cachedBoundaryLevelAdjust;
+
+    OctreeSubtreeVersions versions;
+    QByteArray bitstream;
+    in >> versions >> bitstream;
+    if (in.status() != QDataStream::Ok || versions.isEmpty()) {
+        return false;
+    }
+
+    ViewFrustum cachedView;
+    cachedView.setPosition(position);
+    cachedView.setOrientation(orientation);
+    cachedView.setFieldOfView(fieldOfView);
+    cachedView.setAspectRatio(aspectRatio);
+    cachedView.setNearClip(nearClip);
+    cachedView.setFarClip(farClip);
+    cachedView.setEyeOffsetPosition(eyeOffsetPosition);
+    cachedView.calculate();
+
+    if (!isSimilarView(cachedView, cachedOctreeSizeScale, cachedBoundaryLevelAdjust,
+                       viewFrustum, octreeSizeScale, boundaryLevelAdjust)) {
+        qDebug() << "Not using octree cache" << file.fileName() << "since it was captured from a different view";
+        return false;
+    }
+
+    tree->lockForWrite();
+    ReadBitstreamToTreeParams args(WANT_COLOR, NO_EXISTS_BITS, NULL, serverUUID);
+    tree->readBitstreamToTree(reinterpret_cast<const unsigned char*>(bitstream.constData()), bitstream.size(), args);
+    tree->unlock();
+
+    server.versions = versions;
+    server.cachedView = cachedView;
+    server.cachedOctreeSizeScale = cachedOctreeSizeScale;
+    server.cachedBoundaryLevelAdjust = cachedBoundaryLevelAdjust;
+    server.isRevalidating = true;
+
+    qDebug() << "Loaded" << versions.size() << "cached subtrees from" << file.fileName();
+    return true;
+}
+
+void OctreeCache::prepareQuery(const QUuid& serverUUID, OctreeQuery& query, const ViewFrustum& viewFrustum,
+                               float octreeSizeScale, int boundaryLevelAdjust) {
+    QMutexLocker locker(&_mutex);
+    ServerCache& server = _servers[serverUUID];
+    server.hasQueriedView = true;
+    server.queriedView = viewFrustum;
+    server.queriedOctreeSizeScale = octreeSizeScale;
+    server.queriedBoundaryLevelAdjust = boundaryLevelAdjust;
+
+    if (server.isRevalidating && isSimilarView(server.cachedView, server.cachedOctreeSizeScale,
+            server.cachedBoundaryLevelAdjust, viewFrustum, octreeSizeScale, boundaryLevelAdjust)) {
+        query.setSubtreeVersions(server.versions);
+    } else {
+        query.setSubtreeVersions(OctreeSubtreeVersions());
+    }
+}
+
+void OctreeCache::prepareQueryWithoutView(const QUuid& serverUUID, OctreeQuery& query) {
+    QMutexLocker locker(&_mutex);
+    _servers[serverUUID].hasQueriedView = false;
+    query.setSubtreeVersions(OctreeSubtreeVersions());
+}
+
+void OctreeCache::sceneCompleted(const QUuid& serverUUID, const OctreeSceneStats& stats, Octree* tree) {
+    QMutexLocker locker(&_mutex);
+    ServerCache& server = _servers[serverUUID];
+
+    server.hasSceneStats = true;
+    server.jurisdiction.copyContents(stats.getJurisdictionRoot(), stats.getJurisdictionEndNodes());
+
+    // only full scenes tell us that everything in view is current, deltas only cover what changed
+    if (!stats.isFullScene() || !server.hasQueriedView) {
+        return;
+    }
+
+    tree->lockForRead();
+    QList<OctreeElement*> subtrees;
+    collectSubtrees(tree, server.jurisdiction, subtrees);
+
+    // subtrees that were out of view weren't looked at by the server, so they keep whatever version they had
+    OctreeSubtreeVersions versions;
+    foreach (OctreeElement* subtree, subtrees) {
+        QByteArray key = keyForElement(subtree);
+        if (subtree->isInView(server.queriedView)) {
+            versions.insert(key, stats.getSceneStartTime());
+        } else if (server.versions.contains(key)) {
+            versions.insert(key, server.versions.value(key));
+        }
+    }
+    tree->unlock();
+
+    server.versions = versions;
+    server.cachedView = server.queriedView;
+    server.cachedOctreeSizeScale = server.queriedOctreeSizeScale;
+    server.cachedBoundaryLevelAdjust = server.queriedBoundaryLevelAdjust;
+    server.isRevalidating = false;
+}
+
+void OctreeCache::saveServer(const QUuid& serverUUID, Octree* tree) {
+    QMutexLocker locker(&_mutex);
+    if (_servers.contains(serverUUID)) {
+        saveServerLocked(serverUUID, _servers[serverUUID], tree);
+    }
+}
+
+void OctreeCache::saveAllServers(Octree* tree) {
+    QMutexLocker locker(&_mutex);
+    for (QHash<QUuid, ServerCache>::iterator server = _servers.begin(); server != _servers.end(); server++) {
+        saveServerLocked(server.key(), server.value(), tree);
+    }
+}
+
+void OctreeCache::saveServerLocked(const QUuid& serverUUID, ServerCache& server, Octree* tree) {
+    // until the server has told us its jurisdiction, we can't tell its content apart from any other server's
+    if (!server.hasSceneStats || server.versions.isEmpty()) {
+        return;
+    }
+
+    QByteArray bitstream;
+    OctreeElementBag bag;
+    OctreePacketData packetData;
+
+    tree->lockForRead();
+    QList<OctreeElement*> subtrees;
+    collectSubtrees(tree, server.jurisdiction, subtrees);
+    foreach (OctreeElement* subtree, subtrees) {
+        if (server.versions.contains(keyForElement(subtree))) {
+            bag.insert(subtree);
+        }
+    }
+    while (!bag.isEmpty()) {
+        OctreeElement* subtree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+        params.jurisdictionMap = &server.jurisdiction;
+        int bytesWritten = tree->encodeTreeBitstream(subtree, &packetData, bag, params);
+
+        // if the subtree didn't fit, flush what we have and try it again in an empty packet
+        if (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT && packetData.hasContent()) {
+            bitstream.append(reinterpret_cast<const char*>(packetData.getFinalizedData()), packetData.getFinalizedSize());
+            packetData.reset();
+            bag.insert(subtree);
+        }
+    }
+    tree->unlock();
+
+    if (packetData.hasContent()) {
+        bitstream.append(reinterpret_cast<const char*>(packetData.getFinalizedData()), packetData.getFinalizedSize());
+    }
+
+    QDir().mkpath(_directory);
+    QFile file(pathForServer(serverUUID));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Unable to write octree cache" << file.fileName();
+        return;
+    }
+    QDataStream out(&file);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    PacketType expectedType = tree->expectedDataPacketType();
+    out << CACHE_FILE_FORMAT << (quint8)expectedType << (quint8)versionForPacketType(expectedType);
+
+    const ViewFrustum& view = server.cachedView;
+    out << view.getPosition().x << view.getPosition().y << view.getPosition().z;
+    out << view.getOrientation().x << view.getOrientation().y << view.getOrientation().z << view.getOrientation().w;
+    out << view.getFieldOfView() << view.getAspectRatio() << view.getNearClip() << view.getFarClip();
+    out << view.getEyeOffsetPosition().x << view.getEyeOffsetPosition().y << view.getEyeOffsetPosition().z;
+    out << server.cachedOctreeSizeScale << (qint32)server.cachedBoundaryLevelAdjust;
+
+    out << server.versions << bitstream;
+}
+
+void OctreeCache::forgetServer(const QUuid& serverUUID) {
+    QMutexLocker locker(&_mutex);
+    _servers.remove(serverUUID);
+}
+
+void OctreeCache::forgetAllServers() {
+    QMutexLocker locker(&_mutex);
+    _servers.clear();
+}
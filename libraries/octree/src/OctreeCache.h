@@ -0,0 +1,106 @@
+//
+//  OctreeCache.h
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Client side, on disk cache of the octree content received from each server
+//
+
+#ifndef __hifi__OctreeCache__
+#define __hifi__OctreeCache__
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QUuid>
+
+#include "JurisdictionMap.h"
+#include "Octree.h"
+#include "OctreeConstants.h"
+#include "OctreeQuery.h"
+#include "OctreeSceneStats.h"
+#include "ViewFrustum.h"
+
+/// Keeps a copy of the content a client received from each octree server on disk, so that a returning client can show it
+/// right away and only has to be sent what changed while it was gone. Content is cached as the subtrees CACHED_SUBTREE_LEVEL
+/// levels below the root, each tagged with the server time its content was last known to be current. Those versions are
+/// advertised to the server in the OctreeQuery, and the server skips any of them that haven't changed since.
+class OctreeCache {
+public:
+    /// \param name used to tell the caches for different kinds of trees apart on disk, e.g. "voxels"
+    OctreeCache(const QString& name);
+
+    void setCacheDirectory(const QString& directory) { _directory = directory; }
+
+    /// Loads the cached content for a server into the tree, if we haven't already. The cache is only used if it was
+    /// captured from a view similar to the current one, since the cached subtrees only hold what the server's LOD and
+    /// frustum decisions sent for that view.
+    /// \return true if cached content was loaded
+    bool loadServer(const QUuid& serverUUID, Octree* tree, const ViewFrustum& viewFrustum,
+                    float octreeSizeScale, int boundaryLevelAdjust);
+
+    /// Sets the subtree versions the query should advertise to this server. We only advertise them until the first full
+    /// scene from the server completes, and only while our view is still similar to the one the cache was captured from.
+    void prepareQuery(const QUuid& serverUUID, OctreeQuery& query, const ViewFrustum& viewFrustum,
+                      float octreeSizeScale, int boundaryLevelAdjust);
+
+    /// Used instead of prepareQuery() when the query doesn't carry our real view, e.g. while we're only asking the server
+    /// for its jurisdiction. Nothing is advertised, and scenes sent for that query don't update the cache.
+    void prepareQueryWithoutView(const QUuid& serverUUID, OctreeQuery& query);
+
+    /// Called with the stats for each scene the server completes. A full scene brings every subtree that was in view up to
+    /// date as of the time the server started the scene.
+    void sceneCompleted(const QUuid& serverUUID, const OctreeSceneStats& stats, Octree* tree);
+
+    /// Writes the cached subtrees for this server to disk.
+    void saveServer(const QUuid& serverUUID, Octree* tree);
+
+    /// Writes the cached subtrees for every server we know of to disk.
+    void saveAllServers(Octree* tree);
+
+    /// Drops what we know about a server, without touching its file on disk.
+    void forgetServer(const QUuid& serverUUID);
+    void forgetAllServers();
+
+    static const int CACHED_SUBTREE_LEVEL = 3; // the root is level 1, so there are at most 64 cached subtrees
+    static const quint32 CACHE_FILE_FORMAT = 1;
+
+private:
+    class ServerCache {
+    public:
+        ServerCache();
+
+        bool isLoaded; // we've looked for a cache file for this server
+        bool isRevalidating; // our cached versions are being sent to the server, until its first full scene completes
+        bool hasSceneStats; // the server has told us its jurisdiction
+        JurisdictionMap jurisdiction;
+        OctreeSubtreeVersions versions;
+
+        // the view the cached content was received for
+        ViewFrustum cachedView;
+        float cachedOctreeSizeScale;
+        int cachedBoundaryLevelAdjust;
+
+        // the view we most recently asked the server for
+        bool hasQueriedView;
+        ViewFrustum queriedView;
+        float queriedOctreeSizeScale;
+        int queriedBoundaryLevelAdjust;
+    };
+
+    QString pathForServer(const QUuid& serverUUID) const;
+    void collectSubtrees(Octree* tree, const JurisdictionMap& jurisdiction, QList<OctreeElement*>& subtrees) const;
+    void saveServerLocked(const QUuid& serverUUID, ServerCache& server, Octree* tree);
+
+    static QByteArray keyForElement(const OctreeElement* element);
+    static bool isSimilarView(const ViewFrustum& cachedView, float cachedOctreeSizeScale, int cachedBoundaryLevelAdjust,
+                              const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust);
+
+    QString _name;
+    QString _directory;
+    QMutex _mutex;
+    QHash<QUuid, ServerCache> _servers;
+};
+
+#endif /* defined(__hifi__OctreeCache__) */
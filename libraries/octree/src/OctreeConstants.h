@@ -19,6 +19,9 @@
 #include <PacketHeaders.h>
 #include <glm/glm.hpp>
 
+#include <QByteArray>
+#include <QHash>
+
 // this is where the coordinate system is represented
 const glm::vec3 IDENTITY_RIGHT = glm::vec3( 1.0f, 0.0f, 0.0f);
 const glm::vec3 IDENTITY_UP    = glm::vec3( 0.0f, 1.0f, 0.0f);
@@ -44,4 +47,8 @@ const int DANGEROUSLY_DEEP_RECURSION = 200; // use this for something that needs
 
 const int DEFAULT_MAX_OCTREE_PPS = 600; // the default maximum PPS we think any octree based server should send to a client
 
+// Subtrees that a client already has a copy of, keyed by the octal code of the subtree's root, along with the time (in the
+// server's clock) that the client's copy was known to be current
+typedef QHash<QByteArray, quint64> OctreeSubtreeVersions;
+
 #endif
\ No newline at end of file
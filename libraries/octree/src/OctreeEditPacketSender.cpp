@@ -34,6 +34,7 @@ OctreeEditPacketSender::OctreeEditPacketSender() :
     _maxPendingMessages(DEFAULT_MAX_PENDING_MESSAGES),
     _releaseQueuedMessagesPending(false),
     _serverJurisdictions(NULL),
+    _serverJurisdictionsVersion(NULL),
     _sequenceNumber(0),
     _maxPacketSize(MAX_PACKET_SIZE) {
     //printf("OctreeEditPacketSender::OctreeEditPacketSender() [%p] created... \n", this);
@@ -69,7 +70,7 @@ bool OctreeEditPacketSender::serversExist() const {
             if (_serverJurisdictions) {
                 // lookup our nodeUUID in the jurisdiction map, if it's missing then we're
                 // missing at least one jurisdiction
-                if ((*_serverJurisdictions).find(nodeUUID) == (*_serverJurisdictions).end()) {
+                if (!_serverJurisdictions->contains(nodeUUID)) {
                     atLeastOnJurisdictionMissing = true;
                 }
             }
@@ -176,18 +177,24 @@ void OctreeEditPacketSender::queuePacketToNodes(unsigned char* buffer, ssize_t l
     // for a different server... So we need to actually manage multiple queued packets... one
     // for each server
 
+    if (_serverJurisdictions) {
+        // one lookup in the compiled jurisdictions finds every server this message belongs to
+        _jurisdictionIndex.update(*_serverJurisdictions, _serverJurisdictionsVersion->load());
+        NodeList* nodeList = NodeList::getInstance();
+        foreach (int server, _jurisdictionIndex.serversFor(octCode)) {
+            SharedNodePointer node = nodeList->nodeWithUUID(_jurisdictionIndex.getServerUUID(server));
+            // only send to the NodeTypes that are getMyNodeType()
+            if (node && node->getActiveSocket() && node->getType() == getMyNodeType()) {
+                queuePacketToNode(node->getUUID(), buffer, length);
+            }
+        }
+        return;
+    }
+
     foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
         // only send to the NodeTypes that are getMyNodeType()
         if (node->getActiveSocket() && node->getType() == getMyNodeType()) {
-            QUuid nodeUUID = node->getUUID();
-            bool isMyJurisdiction = true;
-            // we need to get the jurisdiction for this
-            // here we need to get the "pending packet" for this server
-            const JurisdictionMap& map = (*_serverJurisdictions)[nodeUUID];
-            isMyJurisdiction = (map.isMyJurisdiction(octCode, CHECK_NODE_ONLY) == JurisdictionMap::WITHIN);
-            if (isMyJurisdiction) {
-                queuePacketToNode(nodeUUID, buffer, length);
-            }
+            queuePacketToNode(node->getUUID(), buffer, length);
         }
     }
 }
@@ -225,51 +232,56 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
     // for a different server... So we need to actually manage multiple queued packets... one
     // for each server
 
+    if (_serverJurisdictions) {
+        // one lookup in the compiled jurisdictions finds every server this message belongs to
+        _jurisdictionIndex.update(*_serverJurisdictions, _serverJurisdictionsVersion->load());
+        NodeList* nodeList = NodeList::getInstance();
+        foreach (int server, _jurisdictionIndex.serversFor(codeColorBuffer)) {
+            SharedNodePointer node = nodeList->nodeWithUUID(_jurisdictionIndex.getServerUUID(server));
+            // only send to the NodeTypes that are getMyNodeType()
+            if (node && node->getActiveSocket() && node->getType() == getMyNodeType()) {
+                queueOctreeEditMessageToNode(node, type, codeColorBuffer, length);
+            }
+        }
+        return;
+    }
+
     foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
         // only send to the NodeTypes that are getMyNodeType()
         if (node->getActiveSocket() && node->getType() == getMyNodeType()) {
-            QUuid nodeUUID = node->getUUID();
-            bool isMyJurisdiction = true;
-
-            if (_serverJurisdictions) {
-                // we need to get the jurisdiction for this
-                // here we need to get the "pending packet" for this server
-                if ((*_serverJurisdictions).find(nodeUUID) != (*_serverJurisdictions).end()) {
-                    const JurisdictionMap& map = (*_serverJurisdictions)[nodeUUID];
-                    isMyJurisdiction = (map.isMyJurisdiction(codeColorBuffer, CHECK_NODE_ONLY) == JurisdictionMap::WITHIN);
-                } else {
-                    isMyJurisdiction = false;
-                }
-            }
-            if (isMyJurisdiction) {
-                EditPacketBuffer& packetBuffer = _pendingEditPackets[nodeUUID];
-                packetBuffer._nodeUUID = nodeUUID;
-
-                // If we're switching type, then we send the last one and start over
-                if ((type != packetBuffer._currentType && packetBuffer._currentSize > 0) ||
-                    (packetBuffer._currentSize + length >= _maxPacketSize)) {
-                    releaseQueuedPacket(packetBuffer);
-                    initializePacket(packetBuffer, type);
-                }
+            queueOctreeEditMessageToNode(node, type, codeColorBuffer, length);
+        }
+    }
+}
 
-                // If the buffer is empty and not correctly initialized for our type...
-                if (type != packetBuffer._currentType && packetBuffer._currentSize == 0) {
-                    initializePacket(packetBuffer, type);
-                }
+void OctreeEditPacketSender::queueOctreeEditMessageToNode(const SharedNodePointer& node, PacketType type,
+                                                          unsigned char* codeColorBuffer, ssize_t length) {
+    QUuid nodeUUID = node->getUUID();
+    EditPacketBuffer& packetBuffer = _pendingEditPackets[nodeUUID];
+    packetBuffer._nodeUUID = nodeUUID;
+
+    // If we're switching type, then we send the last one and start over
+    if ((type != packetBuffer._currentType && packetBuffer._currentSize > 0) ||
+        (packetBuffer._currentSize + length >= _maxPacketSize)) {
+        releaseQueuedPacket(packetBuffer);
+        initializePacket(packetBuffer, type);
+    }
 
-                // This is really the first time we know which server/node this particular edit message
-                // is going to, so we couldn't adjust for clock skew till now. But here's our chance.
-                // We call this virtual function that allows our specific type of EditPacketSender to
-                // fixup the buffer for any clock skew
-                if (node->getClockSkewUsec() != 0) {
-                    adjustEditPacketForClockSkew(codeColorBuffer, length, node->getClockSkewUsec());
-                }
+    // If the buffer is empty and not correctly initialized for our type...
+    if (type != packetBuffer._currentType && packetBuffer._currentSize == 0) {
+        initializePacket(packetBuffer, type);
+    }
 
-                memcpy(&packetBuffer._currentBuffer[packetBuffer._currentSize], codeColorBuffer, length);
-                packetBuffer._currentSize += length;
-            }
-        }
+    // This is really the first time we know which server/node this particular edit message
+    // is going to, so we couldn't adjust for clock skew till now. But here's our chance.
+    // We call this virtual function that allows our specific type of EditPacketSender to
+    // fixup the buffer for any clock skew
+    if (node->getClockSkewUsec() != 0) {
+        adjustEditPacketForClockSkew(codeColorBuffer, length, node->getClockSkewUsec());
     }
+
+    memcpy(&packetBuffer._currentBuffer[packetBuffer._currentSize], codeColorBuffer, length);
+    packetBuffer._currentSize += length;
 }
 
 void OctreeEditPacketSender::releaseQueuedMessages() {
@@ -11,8 +11,11 @@
 #ifndef __shared__OctreeEditPacketSender__
 #define __shared__OctreeEditPacketSender__
 
+#include <QtCore/QAtomicInt>
+
 #include <PacketSender.h>
 #include <PacketHeaders.h>
+#include "JurisdictionIndex.h"
 #include "JurisdictionMap.h"
 
 /// Used for construction of edit packets
@@ -58,9 +61,11 @@ public:
     /// call this to inform the OctreeEditPacketSender of the server jurisdictions. This is required for normal operation.
     /// The internal contents of the jurisdiction map may change throughout the lifetime of the OctreeEditPacketSender. This map
     /// can be set prior to servers being present, so long as the contents of the map accurately reflect the current
-    /// known jurisdictions.
-    void setServerJurisdictions(NodeToJurisdictionMap* serverJurisdictions) { 
+    /// known jurisdictions. Whoever writes the map must bump the version after every change to it.
+    void setServerJurisdictions(NodeToJurisdictionMap* serverJurisdictions,
+                                const QAtomicInt* serverJurisdictionsVersion) {
         _serverJurisdictions = serverJurisdictions;
+        _serverJurisdictionsVersion = serverJurisdictionsVersion;
     }
 
     /// if you're running in non-threaded mode, you must call this method regularly
@@ -94,6 +99,8 @@ protected:
     void queuePacketToNode(const QUuid& nodeID, unsigned char* buffer, ssize_t length);
     void queuePendingPacketToNodes(PacketType type, unsigned char* buffer, ssize_t length);
     void queuePacketToNodes(unsigned char* buffer, ssize_t length);
+    void queueOctreeEditMessageToNode(const SharedNodePointer& node, PacketType type,
+                                      unsigned char* codeColorBuffer, ssize_t length);
     void initializePacket(EditPacketBuffer& packetBuffer, PacketType type);
     void releaseQueuedPacket(EditPacketBuffer& packetBuffer); // releases specific queued packet
     
@@ -110,6 +117,8 @@ protected:
     QVector<EditPacketBuffer*> _preServerSingleMessagePackets; // these will go out as is
 
     NodeToJurisdictionMap* _serverJurisdictions;
+    const QAtomicInt* _serverJurisdictionsVersion;
+    JurisdictionIndex _jurisdictionIndex; // compiled from _serverJurisdictions, for routing edit messages
     
     unsigned short int _sequenceNumber;
     int _maxPacketSize;
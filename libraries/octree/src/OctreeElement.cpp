@@ -90,6 +90,7 @@ void OctreeElement::init(unsigned char * octalCode) {
     _isDirty = true;
     _shouldRender = false;
     _sourceUUIDKey = 0;
+    _bagMembership.store(0);
     calculateAABox();
     markWithChangedTime();
 }
@@ -110,6 +111,16 @@ OctreeElement::~OctreeElement() {
     deleteAllChildren();
 }
 
+void OctreeElement::setInBag(int slot, bool inBag) {
+    // several send threads may be flipping their own bits at the same time, so we swap the whole word
+    unsigned int slotBit = 1u << slot;
+    unsigned int oldValue, newValue;
+    do {
+        oldValue = _bagMembership.load();
+        newValue = inBag ? (oldValue | slotBit) : (oldValue & ~slotBit);
+    } while (!_bagMembership.testAndSetOrdered((int)oldValue, (int)newValue));
+}
+
 void OctreeElement::markWithChangedTime() {
     _lastChanged = usecTimestampNow();
     notifyUpdateHooks(); // if the node has changed, notify our hooks
@@ -13,6 +13,7 @@
 //#define SIMPLE_CHILD_ARRAY
 #define SIMPLE_EXTERNAL_CHILDREN
 
+#include <QAtomicInt>
 #include <QReadWriteLock>
 
 #include <SharedUtil.h>
@@ -99,6 +100,14 @@ public:
     // Base class methods you don't need to implement
     const unsigned char* getOctalCode() const { return (_octcodePointer) ? _octalCode.pointer : &_octalCode.buffer[0]; }
     OctreeElement* getChildAtIndex(int childIndex) const;
+
+    /// \return the child a ray travelling in this direction would meet first. Visiting children in the order
+    /// i ^ getNearestChildIndexForRay(direction), for i from 0 up, takes the ones the ray passes through nearest first,
+    /// since a ray only ever crosses an element's midplanes in the direction it's travelling.
+    static int getNearestChildIndexForRay(const glm::vec3& direction) {
+        return (direction.x < 0.0f ? 4 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 1 : 0);
+    }
+
     void deleteChildAtIndex(int childIndex);
     OctreeElement* removeChildAtIndex(int childIndex);
 
@@ -151,6 +160,11 @@ public:
 
     static void addUpdateHook(OctreeElementUpdateHook* hook);
     static void removeUpdateHook(OctreeElementUpdateHook* hook);
+
+    /// Used by OctreeElementBag to track which bags this element is in without hashing. Each bag owns one slot.
+    static const int MAX_BAG_MEMBERSHIP_SLOTS = 32;
+    bool isInBag(int slot) const { return ((unsigned int)_bagMembership.load() & (1u << slot)) != 0; }
+    void setInBag(int slot, bool inBag);
     
     static void resetPopulationStatistics();
     static unsigned long getNodeCount() { return _voxelNodeCount; }
@@ -285,6 +299,8 @@ protected:
          _unknownBufferIndex : 1,
          _childrenExternal : 1; /// Client only, is this voxel's VBO buffer the unknown buffer index, 1 bit
 
+    QAtomicInt _bagMembership; /// Server mostly, one bit per OctreeElementBag slot this element is in, 4 bytes
+
     static QReadWriteLock _deleteHooksLock;
     static std::vector<OctreeElementDeleteHook*> _deleteHooks;
 
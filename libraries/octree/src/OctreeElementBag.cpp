@@ -6,11 +6,49 @@
 //  Copyright (c) 2013 High Fidelity, Inc. All rights reserved.
 //
 
+#include <algorithm>
+
+#include <QAtomicInt>
+
 #include "OctreeElementBag.h"
 #include <OctalCode.h>
 
+static QAtomicInt membershipSlotsInUse(0); // one bit per slot
+static QAtomicInt membershipSlotReleases(0); // bumped whenever a slot frees up, so bags without one know to try again
+
+int OctreeElementBag::acquireMembershipSlot() {
+    // bags on several send threads fill up at the same time, so we claim our bit by swapping the whole word
+    unsigned int oldValue = membershipSlotsInUse.load();
+    while (~oldValue != 0u) {
+        int slot = 0;
+        while (oldValue & (1u << slot)) {
+            slot++;
+        }
+        if (membershipSlotsInUse.testAndSetOrdered((int)oldValue, (int)(oldValue | (1u << slot)))) {
+            return slot;
+        }
+        oldValue = membershipSlotsInUse.load();
+    }
+    return NO_MEMBERSHIP_SLOT;
+}
+
+void OctreeElementBag::releaseMembershipSlot(int slot) {
+    unsigned int slotBit = 1u << slot;
+    unsigned int oldValue;
+    do {
+        oldValue = membershipSlotsInUse.load();
+    } while (!membershipSlotsInUse.testAndSetOrdered((int)oldValue, (int)(oldValue & ~slotBit)));
+    membershipSlotReleases.ref();
+}
+
 OctreeElementBag::OctreeElementBag() : 
-    _bagElements()
+    _bagElements(),
+    _removedElements(),
+    _nextSequence(0),
+    _viewFrustum(NULL),
+    _membershipSlot(NO_MEMBERSHIP_SLOT),
+    _slotReleasesSeen(0),
+    _overflowMembers()
 {
     OctreeElement::addDeleteHook(this);
 };
@@ -26,29 +64,127 @@ void OctreeElementBag::elementDeleted(OctreeElement* element) {
 
 
 void OctreeElementBag::deleteAll() {
+    for (size_t i = 0; i < _bagElements.size(); i++) {
+        // dead entries may point at deleted elements
+        if (!_removedElements.contains(_bagElements[i].element)) {
+            setMember(_bagElements[i].element, false);
+        }
+    }
     _bagElements.clear();
+    _removedElements.clear();
+    _overflowMembers.clear();
+    releaseSlotIfEmpty();
 }
 
+float OctreeElementBag::calculatePriority(OctreeElement* element) const {
+    // with no view frustum every element has the same priority, and the sequence number makes us FIFO
+    return _viewFrustum ? element->distanceToCamera(*_viewFrustum) : 0.0f;
+}
+
+void OctreeElementBag::setMember(OctreeElement* element, bool isMember) {
+    if (_membershipSlot == NO_MEMBERSHIP_SLOT) {
+        if (isMember) {
+            _overflowMembers.insert(element);
+        } else {
+            _overflowMembers.remove(element);
+        }
+    } else {
+        element->setInBag(_membershipSlot, isMember);
+    }
+}
+
+void OctreeElementBag::acquireSlotIfFree() {
+    // an empty bag always tries, a bag making do with the set only once another bag has given a slot back
+    int releases = membershipSlotReleases.load();
+    if (!isEmpty() && releases == _slotReleasesSeen) {
+        return;
+    }
+    _slotReleasesSeen = releases;
+    _membershipSlot = acquireMembershipSlot();
+    if (_membershipSlot != NO_MEMBERSHIP_SLOT) {
+        foreach (OctreeElement* element, _overflowMembers) {
+            element->setInBag(_membershipSlot, true);
+        }
+        _overflowMembers.clear();
+    }
+}
+
+void OctreeElementBag::releaseSlotIfEmpty() {
+    if (!isEmpty()) {
+        return;
+    }
+    // whatever's left is dead
+    _bagElements.clear();
+    _removedElements.clear();
+    if (_membershipSlot != NO_MEMBERSHIP_SLOT) {
+        releaseMembershipSlot(_membershipSlot);
+        _membershipSlot = NO_MEMBERSHIP_SLOT;
+    }
+}
 
 void OctreeElementBag::insert(OctreeElement* element) {
-    _bagElements.insert(element);
+    if (_membershipSlot == NO_MEMBERSHIP_SLOT) {
+        acquireSlotIfFree();
+    }
+    if (contains(element)) {
+        return;
+    }
+    setMember(element, true);
+    if (!_removedElements.isEmpty() && _removedElements.remove(element)) {
+        // its old entry is still in the heap, so bring that back rather than adding another
+        return;
+    }
+    BagEntry entry = { calculatePriority(element), _nextSequence++, element };
+    _bagElements.push_back(entry);
+    std::push_heap(_bagElements.begin(), _bagElements.end());
 }
 
 OctreeElement* OctreeElementBag::extract() {
     OctreeElement* result = NULL;
 
-    if (_bagElements.size() > 0) {
-        QSet<OctreeElement*>::iterator front = _bagElements.begin();
-        result = *front;
-        _bagElements.erase(front);
+    while (!isEmpty()) {
+        std::pop_heap(_bagElements.begin(), _bagElements.end());
+        OctreeElement* element = _bagElements.back().element;
+        _bagElements.pop_back();
+        if (!_removedElements.isEmpty() && _removedElements.remove(element)) {
+            continue;
+        }
+        result = element;
+        setMember(result, false);
+        releaseSlotIfEmpty();
+        break;
     }
     return result;
 }
 
 bool OctreeElementBag::contains(OctreeElement* element) {
-    return _bagElements.contains(element);
+    if (_membershipSlot == NO_MEMBERSHIP_SLOT) {
+        return _overflowMembers.contains(element);
+    }
+    return element->isInBag(_membershipSlot);
 }
 
 void OctreeElementBag::remove(OctreeElement* element) {
-    _bagElements.remove(element);
+    // the common case, especially from the delete hook, is that the element isn't in our bag at all
+    if (!contains(element)) {
+        return;
+    }
+    // rather than find its entry, leave it in the heap as dead for extract to skip. The element may be on its way to
+    // being deleted, so from here on its entry's pointer is only ever compared, never followed.
+    _removedElements.insert(element);
+    setMember(element, false);
+    releaseSlotIfEmpty();
+
+    // don't let the dead outnumber the living
+    if (_removedElements.size() > count()) {
+        size_t liveEntries = 0;
+        for (size_t i = 0; i < _bagElements.size(); i++) {
+            if (!_removedElements.contains(_bagElements[i].element)) {
+                _bagElements[liveEntries++] = _bagElements[i];
+            }
+        }
+        _bagElements.resize(liveEntries);
+        _removedElements.clear();
+        std::make_heap(_bagElements.begin(), _bagElements.end());
+    }
 }
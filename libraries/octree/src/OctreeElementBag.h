@@ -10,10 +10,20 @@
 //  more than once (in other words, it de-dupes automatically), also, it supports collapsing it's several peer nodes
 //  into a parent node in cases where you add enough peers that it makes more sense to just add the parent.
 //
+//  The bag is a priority queue. If a view frustum has been set, elements are extracted nearest to the viewer first,
+//  otherwise they come out in the order they were inserted. Membership is tracked with a bit on the element itself
+//  so that contains() and the delete hook don't need to hash. There are only 32 of those bits to go around, so a bag
+//  holds one only while it has elements in it, and one that found them all taken uses a set until one frees up.
+//  Removing an element leaves its entry in the heap marked dead, and extract skips it.
+//
 
 #ifndef __hifi__OctreeElementBag__
 #define __hifi__OctreeElementBag__
 
+#include <vector>
+
+#include <QSet>
+
 #include "OctreeElement.h"
 
 class OctreeElementBag : public OctreeElementDeleteHook {
@@ -23,18 +33,56 @@ public:
     ~OctreeElementBag();
     
     void insert(OctreeElement* element); // put a element into the bag
-    OctreeElement* extract(); // pull a element out of the bag (could come in any order)
+    OctreeElement* extract(); // pull the nearest element out of the bag (or oldest if no view frustum is set)
     bool contains(OctreeElement* element); // is this element in the bag?
     void remove(OctreeElement* element); // remove a specific element from the bag
     
-    bool isEmpty() const { return _bagElements.isEmpty(); }
-    int count() const { return _bagElements.size(); }
+    bool isEmpty() const { return _bagElements.size() == (size_t)_removedElements.size(); }
+    int count() const { return _bagElements.size() - _removedElements.size(); }
+
+    /// Sets the view frustum used to prioritize elements on insert. Pass NULL to extract in insertion order. Elements
+    /// already in the bag keep the priority they were inserted with.
+    void setViewFrustum(const ViewFrustum* viewFrustum) { _viewFrustum = viewFrustum; }
+    const ViewFrustum* getViewFrustum() const { return _viewFrustum; }
+
+    /// Is membership being tracked with a bit on the elements, rather than with the set we fall back to when they're
+    /// all taken? An empty bag holds no bit.
+    bool hasMembershipSlot() const { return _membershipSlot != NO_MEMBERSHIP_SLOT; }
 
     void deleteAll();
     virtual void elementDeleted(OctreeElement* element);
 
 private:
-    QSet<OctreeElement*> _bagElements;
+    static const int NO_MEMBERSHIP_SLOT = -1;
+
+    class BagEntry {
+    public:
+        float priority;
+        quint64 sequence;
+        OctreeElement* element;
+
+        // std heaps are max heaps, so "less" means further away (or inserted later)
+        bool operator<(const BagEntry& other) const {
+            return (priority != other.priority) ? (priority > other.priority) : (sequence > other.sequence);
+        }
+    };
+
+    float calculatePriority(OctreeElement* element) const;
+    void setMember(OctreeElement* element, bool isMember);
+    void acquireSlotIfFree();
+    void releaseSlotIfEmpty();
+
+    static int acquireMembershipSlot();
+    static void releaseMembershipSlot(int slot);
+
+    std::vector<BagEntry> _bagElements;
+    QSet<OctreeElement*> _removedElements; // whose entries are still in _bagElements, but dead
+    quint64 _nextSequence;
+    const ViewFrustum* _viewFrustum;
+
+    int _membershipSlot; // bit index into OctreeElement::_bagMembership, or NO_MEMBERSHIP_SLOT if empty or none free
+    int _slotReleasesSeen; // how many slots had been given back when we last tried for one
+    QSet<OctreeElement*> _overflowMembers; // only used when we couldn't get a membership slot
 };
 
 #endif /* defined(__hifi__OctreeElementBag__) */
@@ -34,7 +34,7 @@ void OctreeHeadlessViewer::init() {
 void OctreeHeadlessViewer::queryOctree() {
     NodeType_t serverType = getMyNodeType();
     PacketType packetType = getMyQueryMessageType();
-    NodeToJurisdictionMap& jurisdictions = *_jurisdictionListener->getJurisdictions();
+    const NodeToJurisdictionMap& jurisdictions = *_jurisdictionListener->getJurisdictions();
 
     bool wantExtraDebugging = false;
 
@@ -43,7 +43,7 @@ void OctreeHeadlessViewer::queryOctree() {
         qDebug() << "---------------";
         qDebug() << "_jurisdictionListener=" << _jurisdictionListener;
         qDebug() << "Jurisdictions...";
-        for (NodeToJurisdictionMapIterator i = jurisdictions.begin(); i != jurisdictions.end(); ++i) {
+        for (NodeToJurisdictionMap::const_iterator i = jurisdictions.begin(); i != jurisdictions.end(); ++i) {
             qDebug() << i.key() << ": " << &i.value();
         }
         qDebug() << "---------------";
@@ -86,7 +86,7 @@ void OctreeHeadlessViewer::queryOctree() {
             if (jurisdictions.find(nodeUUID) == jurisdictions.end()) {
                 unknownJurisdictionServers++;
             } else {
-                const JurisdictionMap& map = (jurisdictions)[nodeUUID];
+                const JurisdictionMap& map = *jurisdictions.find(nodeUUID);
 
                 unsigned char* rootCode = map.getRootOctalCode();
 
@@ -152,7 +152,7 @@ void OctreeHeadlessViewer::queryOctree() {
                     qDebug() << "no known jurisdiction for node " << *node << ", assume it's visible.";
                 }
             } else {
-                const JurisdictionMap& map = (jurisdictions)[nodeUUID];
+                const JurisdictionMap& map = *jurisdictions.find(nodeUUID);
 
                 unsigned char* rootCode = map.getRootOctalCode();
 
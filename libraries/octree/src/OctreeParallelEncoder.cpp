@@ -0,0 +1,294 @@
+//
+//  OctreeParallelEncoder.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <algorithm>
+
+#include <QMutexLocker>
+
+#include "OctreePacketData.h"
+
+#include "OctreeParallelEncoder.h"
+
+OctreeParallelEncoder::OctreeParallelEncoder(Octree* tree, QThreadPool* threadPool) :
+    _tree(tree),
+    _threadPool(threadPool),
+    _activeWorkers(0),
+    _isCanceled(false),
+    _wantCompression(false),
+    _isStarted(false),
+    _headPending(false),
+    _nextSequenceToSend(0),
+    _bufferedSections(0),
+    _unclaimedSubtrees(0)
+{
+}
+
+OctreeParallelEncoder::~OctreeParallelEncoder() {
+    cancel();
+}
+
+static void collectSubtrees(OctreeElement* element, int depth, OctreeElementBag& bag) {
+    if (depth == OctreeParallelEncoder::SPLIT_DEPTH) {
+        bag.insert(element);
+        return;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            collectSubtrees(child, depth + 1, bag);
+        }
+    }
+}
+
+void OctreeParallelEncoder::start(const EncodeBitstreamParams& params, bool wantCompression) {
+    cancel(); // make sure we're not still working on a previous scene
+
+    QMutexLocker locker(&_mutex);
+
+    // take our own copies of the frustums, the send thread will keep updating the client's as new queries come in
+    _params = params;
+    if (params.viewFrustum) {
+        _viewFrustum = *params.viewFrustum;
+        _params.viewFrustum = &_viewFrustum;
+    }
+    if (params.lastViewFrustum) {
+        _lastViewFrustum = *params.lastViewFrustum;
+        _params.lastViewFrustum = &_lastViewFrustum;
+    }
+    if (params.subtreeVersions) {
+        _subtreeVersions = *params.subtreeVersions;
+        _params.subtreeVersions = &_subtreeVersions;
+    }
+    // the coverage map and the stats aren't safe to share between workers
+    _params.wantOcclusionCulling = false;
+    _params.map = IGNORE_COVERAGE_MAP;
+    _params.stats = IGNORE_SCENE_STATS;
+    _wantCompression = wantCompression;
+
+    // the top SPLIT_DEPTH levels go out first as the head of the scene, then each subtree below that, nearest first
+    _tree->lockForRead();
+    _pendingSubtrees.setViewFrustum(_params.viewFrustum);
+    collectSubtrees(_tree->getRoot(), 0, _pendingSubtrees);
+    _unclaimedSubtrees = _pendingSubtrees.count();
+    _tree->unlock();
+
+    _headPending = true;
+    _sequence.append(SequencedSections());
+    _isStarted = true;
+
+    locker.unlock();
+    scheduleWorkers();
+}
+
+void OctreeParallelEncoder::cancel() {
+    QMutexLocker locker(&_mutex);
+    _isCanceled = true;
+    while (_activeWorkers > 0) {
+        _workersDone.wait(&_mutex);
+    }
+    clearScene();
+    _isCanceled = false;
+}
+
+void OctreeParallelEncoder::clearScene() {
+    // the bags hold tree elements, so they may only be touched with the tree locked
+    _tree->lockForRead();
+    _pendingSubtrees.deleteAll();
+    foreach (EncodeUnit* unit, _parkedUnits) {
+        delete unit;
+    }
+    _tree->unlock();
+
+    _parkedUnits.clear();
+    _sequence.clear();
+    _nextSequenceToSend = 0;
+    _bufferedSections = 0;
+    _unclaimedSubtrees = 0;
+    _headPending = false;
+    _isStarted = false;
+    _encodeStats.reset();
+}
+
+bool OctreeParallelEncoder::isActive() {
+    QMutexLocker locker(&_mutex);
+    return _isStarted;
+}
+
+bool OctreeParallelEncoder::isComplete() {
+    QMutexLocker locker(&_mutex);
+    if (!_isStarted || _activeWorkers > 0 || _headPending || _unclaimedSubtrees > 0 || !_parkedUnits.isEmpty()) {
+        return false;
+    }
+    for (int i = _nextSequenceToSend; i < _sequence.size(); i++) {
+        if (!_sequence[i].finished || !_sequence[i].sections.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OctreeParallelEncoder::scheduleWorkers() {
+    QMutexLocker locker(&_mutex);
+    if (!_isStarted || _isCanceled || _bufferedSections >= MAX_BUFFERED_SECTIONS) {
+        return;
+    }
+    int availableUnits = (_headPending ? 1 : 0) + _unclaimedSubtrees + _parkedUnits.size();
+    int wantedWorkers = std::min(availableUnits, _threadPool->maxThreadCount());
+    while (_activeWorkers < wantedWorkers) {
+        _activeWorkers++;
+        _threadPool->start(new Worker(this));
+    }
+}
+
+bool OctreeParallelEncoder::takeNextSection(QByteArray& section) {
+    QMutexLocker locker(&_mutex);
+    while (_nextSequenceToSend < _sequence.size()) {
+        SequencedSections& next = _sequence[_nextSequenceToSend];
+        if (!next.sections.isEmpty()) {
+            section = next.sections.takeFirst();
+            _bufferedSections--;
+            return true;
+        }
+        if (!next.finished) {
+            return false; // we have to wait for this one, the ones after it can't go out first
+        }
+        _nextSequenceToSend++;
+    }
+    return false;
+}
+
+void OctreeParallelEncoder::takeEncodeStats(OctreeSceneStats& stats) {
+    QMutexLocker locker(&_mutex);
+    stats.accumulateEncodeStats(_encodeStats);
+    _encodeStats.reset();
+}
+
+// Note: must be called with the tree locked for read
+OctreeParallelEncoder::EncodeUnit* OctreeParallelEncoder::claimUnit() {
+    QMutexLocker locker(&_mutex);
+    if (_isCanceled || _bufferedSections >= MAX_BUFFERED_SECTIONS) {
+        return NULL;
+    }
+
+    // resume parked units first, since the sender is waiting on the earliest sequence
+    if (!_parkedUnits.isEmpty()) {
+        int earliest = 0;
+        for (int i = 1; i < _parkedUnits.size(); i++) {
+            if (_parkedUnits[i]->sequence < _parkedUnits[earliest]->sequence) {
+                earliest = i;
+            }
+        }
+        return _parkedUnits.takeAt(earliest);
+    }
+
+    if (_headPending) {
+        _headPending = false;
+        EncodeUnit* unit = new EncodeUnit(0, true);
+        unit->bag.insert(_tree->getRoot());
+        return unit;
+    }
+
+    OctreeElement* subtree = _pendingSubtrees.extract();
+    if (!subtree) {
+        _unclaimedSubtrees = 0; // some may have been deleted out from under us
+        return NULL;
+    }
+    _unclaimedSubtrees--;
+    EncodeUnit* unit = new EncodeUnit(_sequence.size(), false);
+    _sequence.append(SequencedSections());
+    unit->bag.insert(subtree);
+    return unit;
+}
+
+void OctreeParallelEncoder::work() {
+    // leave room in the wire packet for the section size when we're packing compressed sections
+    int sectionSize = _wantCompression
+        ? MAX_OCTREE_PACKET_DATA_SIZE - sizeof(OCTREE_PACKET_INTERNAL_SECTION_SIZE) - COMPRESS_PADDING
+        : MAX_OCTREE_PACKET_DATA_SIZE;
+    OctreePacketData packetData(_wantCompression, sectionSize);
+    OctreeSceneStats stats;
+
+    bool keepWorking = true;
+    while (keepWorking) {
+        _tree->lockForRead();
+        EncodeUnit* unit = claimUnit();
+        if (!unit) {
+            _tree->unlock();
+            break;
+        }
+
+        bool isLocked = true;
+        bool shouldPark = false;
+        while (!unit->bag.isEmpty()) {
+            OctreeElement* subTree = unit->bag.extract();
+
+            EncodeBitstreamParams params = _params;
+            params.stats = &stats;
+            if (unit->isHead) {
+                // stop at the roots of the subtrees that the other units are encoding
+                params.maxEncodeLevel = SPLIT_DEPTH - (subTree->getLevel() - 1) + 1;
+            }
+
+            stats.encodeStarted();
+            int bytesWritten = _tree->encodeTreeBitstream(subTree, &packetData, unit->bag, params);
+            stats.encodeStopped();
+
+            bool didntFit = (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT);
+            if (didntFit) {
+                if (packetData.hasContent()) {
+                    unit->bag.insert(subTree);
+                } else {
+                    unit->bag.remove(subTree); // it won't fit in an empty section either, don't spin on it
+                }
+            }
+
+            if ((didntFit || unit->bag.isEmpty()) && packetData.hasContent()) {
+                QByteArray section(reinterpret_cast<const char*>(packetData.getFinalizedData()),
+                                   packetData.getFinalizedSize());
+                packetData.reset();
+
+                // let any writers in between sections
+                _tree->unlock();
+                isLocked = false;
+
+                QMutexLocker locker(&_mutex);
+                _sequence[unit->sequence].sections.append(section);
+                _bufferedSections++;
+                if (_isCanceled || _bufferedSections >= MAX_BUFFERED_SECTIONS) {
+                    shouldPark = true;
+                    break;
+                }
+                locker.unlock();
+
+                _tree->lockForRead();
+                isLocked = true;
+            }
+        }
+        if (!isLocked) {
+            _tree->lockForRead(); // the unit's bag may only be touched with the tree locked
+        }
+
+        QMutexLocker locker(&_mutex);
+        _encodeStats.accumulateEncodeStats(stats);
+        stats.reset();
+        if (shouldPark && !unit->bag.isEmpty() && !_isCanceled) {
+            // the sender has fallen behind, we'll pick this up again the next time we're scheduled
+            _parkedUnits.append(unit);
+        } else {
+            _sequence[unit->sequence].finished = true;
+            delete unit;
+        }
+        keepWorking = !shouldPark;
+        locker.unlock();
+
+        _tree->unlock();
+    }
+
+    QMutexLocker locker(&_mutex);
+    _activeWorkers--;
+    _workersDone.wakeAll();
+}
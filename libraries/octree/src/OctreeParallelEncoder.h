@@ -0,0 +1,113 @@
+//
+//  OctreeParallelEncoder.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Encodes a full scene for a single client on a shared pool of worker threads
+//
+
+#ifndef __hifi__OctreeParallelEncoder__
+#define __hifi__OctreeParallelEncoder__
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "Octree.h"
+#include "OctreeElementBag.h"
+#include "OctreeSceneStats.h"
+#include "ViewFrustum.h"
+
+/// Splits the tree below the root into subtrees that are encoded in parallel on a shared QThreadPool. Each worker fills
+/// its own OctreePacketData, and the finished sections are handed back to the send thread in a fixed sequence (the top
+/// levels first, then the subtrees nearest to the viewer) so that packets still go out in a stable order.
+class OctreeParallelEncoder {
+public:
+    OctreeParallelEncoder(Octree* tree, QThreadPool* threadPool);
+    ~OctreeParallelEncoder();
+
+    /// Starts encoding a full scene. The view frustums and subtree versions referenced by params are copied, so the caller
+    /// is free to change them while the scene is being encoded.
+    void start(const EncodeBitstreamParams& params, bool wantCompression);
+
+    /// Stops encoding the current scene and waits for any running workers to return.
+    void cancel();
+
+    /// Is a scene being encoded or are there still sections waiting to be sent?
+    bool isActive();
+
+    /// Have all the sections of the current scene been encoded and taken?
+    bool isComplete();
+
+    /// Makes sure there are workers running if there is more to encode and we're not too far ahead of the sender.
+    void scheduleWorkers();
+
+    /// Pulls the next finalized section of the scene, in sequence order.
+    /// \return false if the next section in sequence isn't ready yet (or there are no more)
+    bool takeNextSection(QByteArray& section);
+
+    /// Adds the element stats from all encoding done since the last call into stats.
+    void takeEncodeStats(OctreeSceneStats& stats);
+
+    static const int SPLIT_DEPTH = 2; // subtrees are rooted this many levels below the root (up to 64 of them)
+    static const int MAX_BUFFERED_SECTIONS = 256; // how far the workers can get ahead of the sender
+
+private:
+    class Worker : public QRunnable {
+    public:
+        Worker(OctreeParallelEncoder* encoder) : _encoder(encoder) { }
+        virtual void run() { _encoder->work(); }
+    private:
+        OctreeParallelEncoder* _encoder;
+    };
+
+    /// One independently encoded piece of the scene. The bag holds the elements left to encode for this unit.
+    class EncodeUnit {
+    public:
+        EncodeUnit(int sequence, bool isHead) : sequence(sequence), isHead(isHead) { }
+        int sequence;
+        bool isHead;
+        OctreeElementBag bag;
+    };
+
+    class SequencedSections {
+    public:
+        SequencedSections() : finished(false) { }
+        QList<QByteArray> sections;
+        bool finished;
+    };
+
+    void work();
+    EncodeUnit* claimUnit();
+    void clearScene();
+
+    Octree* _tree;
+    QThreadPool* _threadPool;
+
+    QMutex _mutex;
+    QWaitCondition _workersDone;
+    int _activeWorkers;
+    bool _isCanceled;
+
+    EncodeBitstreamParams _params;
+    ViewFrustum _viewFrustum;
+    ViewFrustum _lastViewFrustum;
+    OctreeSubtreeVersions _subtreeVersions;
+    bool _wantCompression;
+
+    bool _isStarted;
+    bool _headPending;
+    OctreeElementBag _pendingSubtrees;
+    QList<EncodeUnit*> _parkedUnits;
+    QList<SequencedSections> _sequence;
+    int _nextSequenceToSend;
+    int _bufferedSections;
+    int _unclaimedSubtrees;
+    OctreeSceneStats _encodeStats;
+};
+
+#endif /* defined(__hifi__OctreeParallelEncoder__) */
@@ -6,6 +6,8 @@
 //  Copyright (c) 2013 High Fidelity, Inc. All rights reserved.
 //
 
+#include <algorithm>
+
 #include <SharedUtil.h>
 
 #include "OctreeConstants.h"
@@ -24,6 +26,7 @@ OctreeQuery::OctreeQuery() :
     _wantLowResMoving(true),
     _wantOcclusionCulling(false), // disabled by default
     _wantCompression(false), // disabled by default
+    _wantCoverageBuffer(false), // disabled by default
     _maxOctreePPS(DEFAULT_MAX_OCTREE_PPS),
     _octreeElementSizeScale(DEFAULT_OCTREE_SIZE_SCALE)
 {
@@ -59,6 +62,7 @@ int OctreeQuery::getBroadcastData(unsigned char* destinationBuffer) {
     if (_wantDelta)            { setAtBit(bitItems, WANT_DELTA_AT_BIT); }
     if (_wantOcclusionCulling) { setAtBit(bitItems, WANT_OCCLUSION_CULLING_BIT); }
     if (_wantCompression)      { setAtBit(bitItems, WANT_COMPRESSION); }
+    if (_wantCoverageBuffer)   { setAtBit(bitItems, WANT_COVERAGE_BUFFER_BIT); }
 
     *destinationBuffer++ = bitItems;
 
@@ -73,6 +77,19 @@ int OctreeQuery::getBroadcastData(unsigned char* destinationBuffer) {
     // desired boundaryLevelAdjust
     memcpy(destinationBuffer, &_boundaryLevelAdjust, sizeof(_boundaryLevelAdjust));
     destinationBuffer += sizeof(_boundaryLevelAdjust);
+
+    // cached subtrees, each is the octal code of the subtree root followed by its version
+    quint16 subtreeCount = std::min(_subtreeVersions.size(), MAX_QUERY_SUBTREE_VERSIONS);
+    memcpy(destinationBuffer, &subtreeCount, sizeof(subtreeCount));
+    destinationBuffer += sizeof(subtreeCount);
+    OctreeSubtreeVersions::const_iterator subtree = _subtreeVersions.constBegin();
+    for (int i = 0; i < subtreeCount; i++, subtree++) {
+        memcpy(destinationBuffer, subtree.key().constData(), subtree.key().size());
+        destinationBuffer += subtree.key().size();
+        quint64 version = subtree.value();
+        memcpy(destinationBuffer, &version, sizeof(version));
+        destinationBuffer += sizeof(version);
+    }
     
     return destinationBuffer - bufferStart;
 }
@@ -105,6 +122,7 @@ int OctreeQuery::parseData(const QByteArray& packet) {
     _wantDelta = oneAtBit(bitItems, WANT_DELTA_AT_BIT);
     _wantOcclusionCulling = oneAtBit(bitItems, WANT_OCCLUSION_CULLING_BIT);
     _wantCompression = oneAtBit(bitItems, WANT_COMPRESSION);
+    _wantCoverageBuffer = oneAtBit(bitItems, WANT_COVERAGE_BUFFER_BIT);
 
     // desired Max Octree PPS
     memcpy(&_maxOctreePPS, sourceBuffer, sizeof(_maxOctreePPS));
@@ -118,6 +136,27 @@ int OctreeQuery::parseData(const QByteArray& packet) {
     memcpy(&_boundaryLevelAdjust, sourceBuffer, sizeof(_boundaryLevelAdjust));
     sourceBuffer += sizeof(_boundaryLevelAdjust);
 
+    // cached subtrees
+    _subtreeVersions.clear();
+    const unsigned char* endPosition = startPosition + packet.size();
+    quint16 subtreeCount = 0;
+    if (sourceBuffer + sizeof(subtreeCount) <= endPosition) {
+        memcpy(&subtreeCount, sourceBuffer, sizeof(subtreeCount));
+        sourceBuffer += sizeof(subtreeCount);
+    }
+    for (int i = 0; i < subtreeCount && sourceBuffer < endPosition; i++) {
+        int codeLength = bytesRequiredForCodeLength(*sourceBuffer);
+        quint64 version = 0;
+        if (sourceBuffer + codeLength + sizeof(version) > endPosition) {
+            break; // truncated, ignore the rest
+        }
+        QByteArray octalCode(reinterpret_cast<const char*>(sourceBuffer), codeLength);
+        sourceBuffer += codeLength;
+        memcpy(&version, sourceBuffer, sizeof(version));
+        sourceBuffer += sizeof(version);
+        _subtreeVersions.insert(octalCode, version);
+    }
+
     return sourceBuffer - startPosition;
 }
 
@@ -30,12 +30,17 @@ typedef unsigned long long quint64;
 
 #include <NodeData.h>
 
+#include "OctreeConstants.h"
+
 // First bitset
 const int WANT_LOW_RES_MOVING_BIT = 0;
 const int WANT_COLOR_AT_BIT = 1;
 const int WANT_DELTA_AT_BIT = 2;
 const int WANT_OCCLUSION_CULLING_BIT = 3;
 const int WANT_COMPRESSION = 4; // 5th bit
+const int WANT_COVERAGE_BUFFER_BIT = 5; // 6th bit, occlusion cull with a CoverageBuffer instead of a CoverageMap
+
+const int MAX_QUERY_SUBTREE_VERSIONS = 64; // keeps the cached subtree list well within a single query packet
 
 class OctreeQuery : public NodeData {
     Q_OBJECT
@@ -73,16 +78,22 @@ public:
     bool getWantLowResMoving() const { return _wantLowResMoving; }
     bool getWantOcclusionCulling() const { return _wantOcclusionCulling; }
     bool getWantCompression() const { return _wantCompression; }
+    bool getWantCoverageBuffer() const { return _wantCoverageBuffer; }
     int getMaxOctreePacketsPerSecond() const { return _maxOctreePPS; }
     float getOctreeSizeScale() const { return _octreeElementSizeScale; }
     int getBoundaryLevelAdjust() const { return _boundaryLevelAdjust; }
 
+    /// the subtrees the client already has cached, the server may skip any of these that haven't changed since
+    const OctreeSubtreeVersions& getSubtreeVersions() const { return _subtreeVersions; }
+    void setSubtreeVersions(const OctreeSubtreeVersions& subtreeVersions) { _subtreeVersions = subtreeVersions; }
+
 public slots:
     void setWantLowResMoving(bool wantLowResMoving) { _wantLowResMoving = wantLowResMoving; }
     void setWantColor(bool wantColor) { _wantColor = wantColor; }
     void setWantDelta(bool wantDelta) { _wantDelta = wantDelta; }
     void setWantOcclusionCulling(bool wantOcclusionCulling) { _wantOcclusionCulling = wantOcclusionCulling; }
     void setWantCompression(bool wantCompression) { _wantCompression = wantCompression; }
+    void setWantCoverageBuffer(bool wantCoverageBuffer) { _wantCoverageBuffer = wantCoverageBuffer; }
     void setMaxOctreePacketsPerSecond(int maxOctreePPS) { _maxOctreePPS = maxOctreePPS; }
     void setOctreeSizeScale(float octreeSizeScale) { _octreeElementSizeScale = octreeSizeScale; }
     void setBoundaryLevelAdjust(int boundaryLevelAdjust) { _boundaryLevelAdjust = boundaryLevelAdjust; }
@@ -103,9 +114,11 @@ protected:
     bool _wantLowResMoving;
     bool _wantOcclusionCulling;
     bool _wantCompression;
+    bool _wantCoverageBuffer;
     int _maxOctreePPS;
     float _octreeElementSizeScale; /// used for LOD calculations
     int _boundaryLevelAdjust; /// used for LOD calculations
+    OctreeSubtreeVersions _subtreeVersions;
 
 private:
     // privatize the copy constructor and assignment operator so they cannot be called
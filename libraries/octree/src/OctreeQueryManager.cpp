@@ -0,0 +1,183 @@
+//
+//  OctreeQueryManager.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <OctalCode.h>
+#include <SharedUtil.h>
+
+#include "OctreeConstants.h"
+#include "OctreeQueryManager.h"
+
+// look for new servers and jurisdictions this often even if the view is still
+const quint64 QUERY_CHECK_INTERVAL_USECS = 3 * USECS_PER_SECOND;
+
+// queries are unreliable, so resend each server's now and then in case one was lost
+const quint64 QUERY_RESEND_INTERVAL_USECS = 10 * USECS_PER_SECOND;
+
+// servers whose jurisdiction we don't know get this much, to tell it to us
+const int UNKNOWN_JURISDICTION_PPS = 10;
+
+// a server that's in view at all should send something
+const int MIN_IN_VIEW_PPS = 1;
+
+OctreeServerBudget::OctreeServerBudget() :
+    isJurisdictionKnown(false),
+    hasBounds(false),
+    isInView(false),
+    visibleVolume(0.0f),
+    packetsPerSecond(0) {
+}
+
+OctreeQueryManager::OctreeQueryManager() :
+    _lastOctreeSizeScale(0.0f),
+    _lastBoundaryLevelAdjust(0),
+    _lastQueryCheck(0),
+    _viewChanged(false),
+    _rateWindowStart(0),
+    _sentPackets(0),
+    _sentBytes(0),
+    _savedPackets(0),
+    _savedBytes(0),
+    _sentPacketsPerSecond(0),
+    _sentBytesPerSecond(0),
+    _savedPacketsPerSecond(0),
+    _savedBytesPerSecond(0) {
+}
+
+bool OctreeQueryManager::isQueryDue(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust,
+        quint64 now) {
+    updateRates(now);
+
+    bool isFirstQuery = (_lastQueryCheck == 0);
+    _viewChanged = isFirstQuery || !_lastQueriedViewFrustum.isVerySimilar(viewFrustum) ||
+        octreeSizeScale != _lastOctreeSizeScale || boundaryLevelAdjust != _lastBoundaryLevelAdjust;
+    if (!_viewChanged && now - _lastQueryCheck < QUERY_CHECK_INTERVAL_USECS) {
+        return false;
+    }
+    _lastQueryCheck = now;
+    if (_viewChanged) {
+        _lastQueriedViewFrustum = viewFrustum;
+        _lastOctreeSizeScale = octreeSizeScale;
+        _lastBoundaryLevelAdjust = boundaryLevelAdjust;
+    }
+    return true;
+}
+
+// the volume of the overlap of two boxes, given as corners
+static float overlapVolume(const glm::vec3& minimumA, const glm::vec3& maximumA,
+        const glm::vec3& minimumB, const glm::vec3& maximumB) {
+    glm::vec3 extent = glm::min(maximumA, maximumB) - glm::max(minimumA, minimumB);
+    return (extent.x > 0.0f && extent.y > 0.0f && extent.z > 0.0f) ? extent.x * extent.y * extent.z : 0.0f;
+}
+
+void OctreeQueryManager::allocateBudget(const ViewFrustum& viewFrustum, int totalPacketsPerSecond,
+        QVector<OctreeServerBudget>& servers) {
+    // the frustum's bounding box stands in for the visible region
+    glm::vec3 viewMinimum = viewFrustum.getNearTopLeft();
+    glm::vec3 viewMaximum = viewMinimum;
+    const glm::vec3 CORNERS[] = { viewFrustum.getNearTopRight(), viewFrustum.getNearBottomLeft(),
+        viewFrustum.getNearBottomRight(), viewFrustum.getFarTopLeft(), viewFrustum.getFarTopRight(),
+        viewFrustum.getFarBottomLeft(), viewFrustum.getFarBottomRight() };
+    for (unsigned int i = 0; i < sizeof(CORNERS) / sizeof(CORNERS[0]); i++) {
+        viewMinimum = glm::min(viewMinimum, CORNERS[i]);
+        viewMaximum = glm::max(viewMaximum, CORNERS[i]);
+    }
+
+    int unknownServers = 0;
+    int inViewServers = 0;
+    float totalVisibleVolume = 0.0f;
+    for (int i = 0; i < servers.size(); i++) {
+        OctreeServerBudget& server = servers[i];
+        server.isInView = false;
+        server.visibleVolume = 0.0f;
+        server.packetsPerSecond = 0;
+        if (!server.isJurisdictionKnown) {
+            unknownServers++;
+            continue;
+        }
+        if (!server.hasBounds) {
+            continue;
+        }
+        if (viewFrustum.boxInFrustum(server.bounds) != ViewFrustum::OUTSIDE) {
+            server.isInView = true;
+            server.visibleVolume = overlapVolume(viewMinimum, viewMaximum, server.bounds.getCorner(),
+                server.bounds.getCorner() + glm::vec3(server.bounds.getScale()));
+            totalVisibleVolume += server.visibleVolume;
+            inViewServers++;
+        }
+    }
+
+    int perUnknownServer = UNKNOWN_JURISDICTION_PPS;
+    if (inViewServers == 0 && unknownServers > 0) {
+        perUnknownServer = totalPacketsPerSecond / unknownServers;
+    }
+    int inViewBudget = qMax(0, totalPacketsPerSecond - unknownServers * perUnknownServer);
+
+    for (int i = 0; i < servers.size(); i++) {
+        OctreeServerBudget& server = servers[i];
+        if (!server.isJurisdictionKnown) {
+            server.packetsPerSecond = perUnknownServer;
+
+        } else if (server.isInView) {
+            // a server that only grazes the view has no volume in it, so split evenly if nothing has any
+            float share = (totalVisibleVolume > 0.0f) ? server.visibleVolume / totalVisibleVolume : 1.0f / inViewServers;
+            server.packetsPerSecond = qMax(MIN_IN_VIEW_PPS, (int)(inViewBudget * share));
+        }
+    }
+}
+
+bool OctreeQueryManager::getJurisdictionBounds(const JurisdictionMap& jurisdiction, AABox& bounds) {
+    unsigned char* rootCode = jurisdiction.getRootOctalCode();
+    if (!rootCode) {
+        return false;
+    }
+    VoxelPositionSize rootDetails;
+    voxelDetailsForCode(rootCode, rootDetails);
+    bounds = AABox(glm::vec3(rootDetails.x, rootDetails.y, rootDetails.z), rootDetails.s);
+    bounds.scale(TREE_SCALE);
+    return true;
+}
+
+bool OctreeQueryManager::isServerQueryDue(const QUuid& nodeUUID, quint64 wakeMicrostamp, int packetsPerSecond,
+        quint64 now) const {
+    QHash<QUuid, ServerQuery>::const_iterator it = _serverQueries.constFind(nodeUUID);
+    if (it == _serverQueries.constEnd() || it->wakeMicrostamp != wakeMicrostamp) {
+        return true;
+    }
+    return it->packetsPerSecond != packetsPerSecond || (packetsPerSecond > 0 && _viewChanged) ||
+        now - it->sentAt > QUERY_RESEND_INTERVAL_USECS;
+}
+
+void OctreeQueryManager::queryWasSent(const QUuid& nodeUUID, quint64 wakeMicrostamp, int packetsPerSecond, int bytes,
+        quint64 now) {
+    ServerQuery& query = _serverQueries[nodeUUID];
+    query.wakeMicrostamp = wakeMicrostamp;
+    query.packetsPerSecond = packetsPerSecond;
+    query.bytes = bytes;
+    query.sentAt = now;
+
+    _sentPackets++;
+    _sentBytes += bytes;
+}
+
+void OctreeQueryManager::queryWasSkipped(const QUuid& nodeUUID) {
+    _savedPackets++;
+    _savedBytes += _serverQueries.value(nodeUUID).bytes;
+}
+
+void OctreeQueryManager::updateRates(quint64 now) {
+    if (now - _rateWindowStart < USECS_PER_SECOND) {
+        return;
+    }
+    // report rates for the window just ended, or zero if nothing has been counted for longer than that
+    bool isLastWindow = (now - _rateWindowStart < 2 * USECS_PER_SECOND);
+    _sentPacketsPerSecond = isLastWindow ? _sentPackets : 0;
+    _sentBytesPerSecond = isLastWindow ? _sentBytes : 0;
+    _savedPacketsPerSecond = isLastWindow ? _savedPackets : 0;
+    _savedBytesPerSecond = isLastWindow ? _savedBytes : 0;
+    _sentPackets = _sentBytes = _savedPackets = _savedBytes = 0;
+    _rateWindowStart = now;
+}
@@ -0,0 +1,111 @@
+//
+//  OctreeQueryManager.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Decides when the octree servers need a new query, and how to divide the packets per second budget between them
+//
+
+#ifndef __hifi__OctreeQueryManager__
+#define __hifi__OctreeQueryManager__
+
+#include <QtCore/QHash>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+
+#include "AABox.h"
+#include "JurisdictionMap.h"
+#include "ViewFrustum.h"
+
+/// One server's share of a query budget. The caller fills in who the server is and where its jurisdiction lies, and
+/// OctreeQueryManager::allocateBudget fills in the rest.
+class OctreeServerBudget {
+public:
+    OctreeServerBudget();
+
+    QUuid nodeUUID;
+    bool isJurisdictionKnown;
+    bool hasBounds; ///< whether the known jurisdiction had a root; one without gets no budget
+    AABox bounds; ///< the root of the server's jurisdiction, in meters
+
+    bool isInView;
+    float visibleVolume; ///< cubic meters of the view's bounding box inside the jurisdiction's root
+    int packetsPerSecond;
+};
+
+/// Keeps the octree queries of a client to the ones that tell a server something new. A query goes out when the view or
+/// LOD moves far enough from the last one to change what the servers should send, and then only to the servers whose
+/// query that changes: a server with nothing in view that was already told to send nothing isn't told again. The budget
+/// goes to the servers in proportion to how much of the view each one's jurisdiction covers, the same way for voxel and
+/// particle servers.
+class OctreeQueryManager {
+public:
+    OctreeQueryManager();
+
+    /// Called once a frame.
+    /// \return whether to look at the servers' queries this frame: the view or LOD has changed enough since the last time
+    /// this returned true, or enough time has passed to look for new servers and jurisdictions
+    bool isQueryDue(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust, quint64 now);
+
+    /// \return whether the last check that was due found the view or LOD changed, rather than just time passed
+    bool hasViewChanged() const { return _viewChanged; }
+
+    /// Divides the packets per second among one type of server. Servers whose jurisdiction isn't yet known get a small
+    /// budget to tell us it; the rest goes to the servers in view in proportion to their visible volume. A server whose
+    /// jurisdiction is known but has no root gets nothing.
+    static void allocateBudget(const ViewFrustum& viewFrustum, int totalPacketsPerSecond,
+        QVector<OctreeServerBudget>& servers);
+
+    /// \return whether the root of the jurisdiction was set, as a box in meters
+    static bool getJurisdictionBounds(const JurisdictionMap& jurisdiction, AABox& bounds);
+
+    /// \param wakeMicrostamp when the node joined, so that a server that comes back under the same UUID is queried again
+    /// \return whether the server needs a query: it hasn't had one, its budget has changed, the view has changed and it has
+    /// a budget to spend on it, or it's been long enough that an earlier query may have been lost
+    bool isServerQueryDue(const QUuid& nodeUUID, quint64 wakeMicrostamp, int packetsPerSecond, quint64 now) const;
+
+    void queryWasSent(const QUuid& nodeUUID, quint64 wakeMicrostamp, int packetsPerSecond, int bytes, quint64 now);
+
+    /// Counts a query that would have been sent to the server had it not been skipped.
+    void queryWasSkipped(const QUuid& nodeUUID);
+
+    // over the last whole second
+    int getSentPacketsPerSecond() const { return _sentPacketsPerSecond; }
+    int getSentBytesPerSecond() const { return _sentBytesPerSecond; }
+    int getSavedPacketsPerSecond() const { return _savedPacketsPerSecond; }
+    int getSavedBytesPerSecond() const { return _savedBytesPerSecond; }
+
+private:
+    class ServerQuery {
+    public:
+        ServerQuery() : wakeMicrostamp(0), packetsPerSecond(0), bytes(0), sentAt(0) { }
+
+        quint64 wakeMicrostamp;
+        int packetsPerSecond;
+        int bytes;
+        quint64 sentAt;
+    };
+
+    void updateRates(quint64 now);
+
+    ViewFrustum _lastQueriedViewFrustum;
+    float _lastOctreeSizeScale;
+    int _lastBoundaryLevelAdjust;
+    quint64 _lastQueryCheck;
+    bool _viewChanged;
+
+    QHash<QUuid, ServerQuery> _serverQueries;
+
+    quint64 _rateWindowStart;
+    int _sentPackets;
+    int _sentBytes;
+    int _savedPackets;
+    int _savedBytes;
+    int _sentPacketsPerSecond;
+    int _sentBytesPerSecond;
+    int _savedPacketsPerSecond;
+    int _savedBytesPerSecond;
+};
+
+#endif /* defined(__hifi__OctreeQueryManager__) */
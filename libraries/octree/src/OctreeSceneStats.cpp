@@ -295,6 +295,47 @@ void OctreeSceneStats::reset() {
     _jurisdictionEndNodes.clear();
 }
 
+void OctreeSceneStats::accumulateEncodeStats(const OctreeSceneStats& other) {
+    _totalEncodeTime += other._totalEncodeTime;
+
+    _traversed += other._traversed;
+    _internal += other._internal;
+    _leaves += other._leaves;
+
+    _skippedDistance += other._skippedDistance;
+    _internalSkippedDistance += other._internalSkippedDistance;
+    _leavesSkippedDistance += other._leavesSkippedDistance;
+
+    _skippedOutOfView += other._skippedOutOfView;
+    _internalSkippedOutOfView += other._internalSkippedOutOfView;
+    _leavesSkippedOutOfView += other._leavesSkippedOutOfView;
+
+    _skippedWasInView += other._skippedWasInView;
+    _internalSkippedWasInView += other._internalSkippedWasInView;
+    _leavesSkippedWasInView += other._leavesSkippedWasInView;
+
+    _skippedNoChange += other._skippedNoChange;
+    _internalSkippedNoChange += other._internalSkippedNoChange;
+    _leavesSkippedNoChange += other._leavesSkippedNoChange;
+
+    _skippedOccluded += other._skippedOccluded;
+    _internalSkippedOccluded += other._internalSkippedOccluded;
+    _leavesSkippedOccluded += other._leavesSkippedOccluded;
+
+    _colorSent += other._colorSent;
+    _internalColorSent += other._internalColorSent;
+    _leavesColorSent += other._leavesColorSent;
+
+    _didntFit += other._didntFit;
+    _internalDidntFit += other._internalDidntFit;
+    _leavesDidntFit += other._leavesDidntFit;
+
+    _colorBitsWritten += other._colorBitsWritten;
+    _existsBitsWritten += other._existsBitsWritten;
+    _existsInPacketBitsWritten += other._existsInPacketBitsWritten;
+    _treesRemoved += other._treesRemoved;
+}
+
 void OctreeSceneStats::packetSent(int bytes) {
     _packets++;
     _bytes += bytes;
@@ -786,8 +827,9 @@ const char* OctreeSceneStats::getItemValue(Item item) {
             break;
         }
         case ITEM_SKIPPED_OCCLUDED: {
-            sprintf(_itemValueBuffer, "%lu total %lu internal %lu leaves", 
-                    _skippedOccluded, _internalSkippedOccluded, _leavesSkippedOccluded);
+            float percentOfTraversed = _traversed ? (100.0f * _skippedOccluded / _traversed) : 0.0f;
+            sprintf(_itemValueBuffer, "%lu total %lu internal %lu leaves (%.1f%% of traversed)",
+                    _skippedOccluded, _internalSkippedOccluded, _leavesSkippedOccluded, percentOfTraversed);
             break;
         }
         case ITEM_COLORS: {
@@ -85,6 +85,10 @@ public:
     /// Fix up tracking statistics in case where bitmasks were removed for some reason
     void childBitsRemoved(bool includesExistsBits, bool includesColors);
 
+    /// Adds the element and encode time counters of another stats object to ours. Used to fold in the results of
+    /// encoding done on other threads, which each track into their own OctreeSceneStats.
+    void accumulateEncodeStats(const OctreeSceneStats& other);
+
     /// Pack the details of the statistics into a buffer for sending as a network packet
     int packIntoMessage(unsigned char* destinationBuffer, int availableBytes);
 
@@ -144,6 +148,8 @@ public:
     const std::vector<unsigned char*>& getJurisdictionEndNodes() const { return _jurisdictionEndNodes; }
     
     bool isMoving() const { return _isMoving; };
+    bool isFullScene() const { return _isFullScene; }
+    quint64 getSceneStartTime() const { return _start; } /// in the server's clock
     unsigned long getTotalElements() const { return _totalElements; }
     unsigned long getTotalInternal() const { return _totalInternal; }
     unsigned long getTotalLeaves() const { return _totalLeaves; }
@@ -64,7 +64,8 @@ void OctreeScriptingInterface::init() {
     } else {
         _managedPacketSender = true;
         _packetSender = createPacketSender();
-        _packetSender->setServerJurisdictions(_jurisdictionListener->getJurisdictions());
+        _packetSender->setServerJurisdictions(_jurisdictionListener->getJurisdictions(),
+                                              _jurisdictionListener->getJurisdictionsVersion());
     }
 
     if (QCoreApplication::instance()) {
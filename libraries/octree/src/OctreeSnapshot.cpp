@@ -0,0 +1,197 @@
+//
+//  OctreeSnapshot.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cstring>
+
+#include <QtCore/QVarLengthArray>
+
+#include <GeometryUtil.h>
+
+#include "Octree.h"
+#include "OctreeSnapshot.h"
+
+static glm::vec3 childOffset(int childIndex) {
+    return glm::vec3((childIndex >> 2) & 1, (childIndex >> 1) & 1, childIndex & 1);
+}
+
+// where a child is among its siblings, which are stored side by side in child index order
+static int childRank(unsigned char childMask, int childIndex) {
+    int rank = 0;
+    for (unsigned char before = childMask & ((1 << childIndex) - 1); before; before &= before - 1) {
+        rank++;
+    }
+    return rank;
+}
+
+OctreeSnapshot::OctreeSnapshot(Octree* tree) :
+    _created(usecTimestampNow())
+{
+    OctreeElement* root = tree->getRoot();
+    if (!root) {
+        return;
+    }
+    // the tree element behind each snapshot element, in the same breadth first order
+    QVector<OctreeElement*> sources;
+    sources.append(root);
+    for (int i = 0; i < sources.size(); i++) {
+        OctreeElement* source = sources.at(i);
+        Element element;
+        element.firstChild = sources.size();
+        element.childMask = 0;
+        element.hasContent = source->isLeaf() && source->hasContent();
+        for (int childIndex = 0; childIndex < NUMBER_OF_CHILDREN; childIndex++) {
+            OctreeElement* child = source->getChildAtIndex(childIndex);
+
+            // empty leaves can't be hit, so leave them out
+            if (child && !(child->isLeaf() && !child->hasContent())) {
+                element.childMask |= (1 << childIndex);
+                sources.append(child);
+            }
+        }
+        if (element.hasContent) {
+            tree->copySnapshotColor(source, element.color);
+        } else {
+            memset(element.color, 0, sizeof(rgbColor));
+        }
+        _elements.append(element);
+    }
+}
+
+bool OctreeSnapshot::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance,
+                                         BoxFace& face, OctreeSnapshotHit* hit) const {
+    glm::vec3 scaledOrigin = origin / (float)(TREE_SCALE);
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    int nearestChild = OctreeElement::getNearestChildIndexForRay(direction);
+
+    QVarLengthArray<Visit, 256> stack;
+    Visit root(0, glm::vec3(0.0f, 0.0f, 0.0f), 1.0f);
+    float rootDistance;
+    BoxFace rootFace;
+    if (!_elements.isEmpty() && AABox::findRayIntersection(root.corner, root.scale, scaledOrigin, direction,
+            inverseDirection, rootDistance, rootFace)) {
+        stack.append(root);
+    }
+    while (!stack.isEmpty()) {
+        Visit visit = stack.last();
+        stack.removeLast();
+        const Element& element = _elements.at(visit.index);
+        if (!element.childMask) {
+            if (element.hasContent) {
+                // elements come off the stack nearest first, so the first leaf with content is the one the ray hits
+                AABox::findRayIntersection(visit.corner, visit.scale, scaledOrigin, direction, inverseDirection,
+                                           distance, face);
+                distance *= TREE_SCALE;
+                fillHit(visit, hit);
+                return true;
+            }
+            continue;
+        }
+        // push the farthest children first, so the nearest come off the stack first
+        float childScale = visit.scale * 0.5f;
+        for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+            int childIndex = i ^ nearestChild;
+            if (!(element.childMask & (1 << childIndex))) {
+                continue;
+            }
+            glm::vec3 childCorner = visit.corner + childOffset(childIndex) * childScale;
+            float childDistance;
+            BoxFace childFace;
+            if (AABox::findRayIntersection(childCorner, childScale, scaledOrigin, direction, inverseDirection,
+                    childDistance, childFace)) {
+                stack.append(Visit(element.firstChild + childRank(element.childMask, childIndex), childCorner,
+                                   childScale));
+            }
+        }
+    }
+    return false;
+}
+
+bool OctreeSnapshot::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                                           OctreeSnapshotHit* hit) const {
+    glm::vec3 scaledCenter = center / (float)(TREE_SCALE);
+    float scaledRadius = radius / (float)(TREE_SCALE);
+    bool found = false;
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    QVarLengthArray<Visit, 256> stack;
+    if (!_elements.isEmpty()) {
+        stack.append(Visit(0, glm::vec3(0.0f, 0.0f, 0.0f), 1.0f));
+    }
+    while (!stack.isEmpty()) {
+        Visit visit = stack.last();
+        stack.removeLast();
+        AABox box(visit.corner, visit.scale);
+        if (!box.expandedContains(scaledCenter, scaledRadius)) {
+            continue;
+        }
+        const Element& element = _elements.at(visit.index);
+        if (element.childMask) {
+            float childScale = visit.scale * 0.5f;
+            int child = element.firstChild;
+            for (int childIndex = 0; childIndex < NUMBER_OF_CHILDREN; childIndex++) {
+                if (element.childMask & (1 << childIndex)) {
+                    stack.append(Visit(child++, visit.corner + childOffset(childIndex) * childScale, childScale));
+                }
+            }
+            continue;
+        }
+        glm::vec3 elementPenetration;
+        if (element.hasContent && box.findSpherePenetration(scaledCenter, scaledRadius, elementPenetration)) {
+            penetration = addPenetrations(penetration, elementPenetration * (float)(TREE_SCALE));
+            fillHit(visit, hit);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool OctreeSnapshot::findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius,
+                                            glm::vec3& penetration) const {
+    glm::vec3 scaledStart = start / (float)(TREE_SCALE);
+    glm::vec3 scaledEnd = end / (float)(TREE_SCALE);
+    float scaledRadius = radius / (float)(TREE_SCALE);
+    bool found = false;
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    QVarLengthArray<Visit, 256> stack;
+    if (!_elements.isEmpty()) {
+        stack.append(Visit(0, glm::vec3(0.0f, 0.0f, 0.0f), 1.0f));
+    }
+    while (!stack.isEmpty()) {
+        Visit visit = stack.last();
+        stack.removeLast();
+        AABox box(visit.corner, visit.scale);
+        if (!box.expandedIntersectsSegment(scaledStart, scaledEnd, scaledRadius)) {
+            continue;
+        }
+        const Element& element = _elements.at(visit.index);
+        if (element.childMask) {
+            float childScale = visit.scale * 0.5f;
+            int child = element.firstChild;
+            for (int childIndex = 0; childIndex < NUMBER_OF_CHILDREN; childIndex++) {
+                if (element.childMask & (1 << childIndex)) {
+                    stack.append(Visit(child++, visit.corner + childOffset(childIndex) * childScale, childScale));
+                }
+            }
+            continue;
+        }
+        glm::vec3 elementPenetration;
+        if (element.hasContent && box.findCapsulePenetration(scaledStart, scaledEnd, scaledRadius, elementPenetration)) {
+            penetration = addPenetrations(penetration, elementPenetration * (float)(TREE_SCALE));
+            found = true;
+        }
+    }
+    return found;
+}
+
+void OctreeSnapshot::fillHit(const Visit& visit, OctreeSnapshotHit* hit) const {
+    if (hit) {
+        hit->corner = visit.corner;
+        hit->scale = visit.scale;
+        memcpy(hit->color, _elements.at(visit.index).color, sizeof(rgbColor));
+    }
+}
@@ -0,0 +1,78 @@
+//
+//  OctreeSnapshot.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Immutable copy of an octree's shape, for ray and shape queries that don't take the tree's lock
+//
+
+#ifndef __hifi__OctreeSnapshot__
+#define __hifi__OctreeSnapshot__
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+
+#include "AABox.h"
+
+class Octree;
+
+/// The leaf a snapshot query hit, in the tree's 0 to 1 units like OctreeElement::getAABox().
+class OctreeSnapshotHit {
+public:
+    glm::vec3 corner;
+    float scale;
+    rgbColor color;
+};
+
+/// Elements are stored breadth first with each one's children side by side, and only the child mask and position of the
+/// first child are kept: boxes are worked out on the way down. Takes the same arguments, in meters, as the matching
+/// Octree queries and gives the same answers, except that leaves are treated as solid boxes rather than asking the
+/// element, which is what voxels do anyway.
+class OctreeSnapshot {
+public:
+    /// Copies the tree, which the caller holds at least a read lock on.
+    OctreeSnapshot(Octree* tree);
+
+    int getElementCount() const { return _elements.size(); }
+    quint64 getCreated() const { return _created; }
+
+    bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance, BoxFace& face,
+                             OctreeSnapshotHit* hit = NULL) const;
+
+    /// \param hit if not null, gets the last leaf that was penetrated
+    bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                               OctreeSnapshotHit* hit = NULL) const;
+
+    bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius,
+                                glm::vec3& penetration) const;
+
+private:
+    class Element {
+    public:
+        int firstChild;
+        unsigned char childMask;
+        bool hasContent;
+        rgbColor color;
+    };
+
+    /// An element waiting on a query's stack, with the box it was given on the way down.
+    class Visit {
+    public:
+        Visit() { }
+        Visit(int index, const glm::vec3& corner, float scale) : index(index), corner(corner), scale(scale) { }
+        int index;
+        glm::vec3 corner;
+        float scale;
+    };
+
+    void fillHit(const Visit& visit, OctreeSnapshotHit* hit) const;
+
+    QVector<Element> _elements;
+    quint64 _created;
+};
+
+#endif /* defined(__hifi__OctreeSnapshot__) */
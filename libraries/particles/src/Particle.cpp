@@ -112,6 +112,7 @@ void Particle::init(glm::vec3 position, float radius, rgbColor color, glm::vec3
     } else {
         _id = id;
     }
+    _creatorTokenID = UNKNOWN_TOKEN;
     quint64 now = usecTimestampNow();
     _lastEdited = now;
     _lastUpdated = now;
@@ -828,22 +829,26 @@ void Particle::update(const quint64& now) {
 
     // If the ball is in hand, it doesn't move or have gravity effect it
     if (!isInHand) {
-        _position += _velocity * timeElapsed;
-
-        // handle bounces off the ground...
-        if (_position.y <= 0) {
-            _velocity = _velocity * glm::vec3(1,-1,1);
-            _position.y = 0;
-        }
+        integrate(_position, _velocity, _gravity, _damping, timeElapsed);
+    }
+}
 
-        // handle gravity....
-        _velocity += _gravity * timeElapsed;
+void Particle::integrate(glm::vec3& position, glm::vec3& velocity, const glm::vec3& gravity, float damping,
+                         float timeElapsed) {
+    position += velocity * timeElapsed;
 
-        // handle damping
-        glm::vec3 dampingResistance = _velocity * _damping;
-        _velocity -= dampingResistance * timeElapsed;
-        //printf("applying damping to Particle timeElapsed=%f\n",timeElapsed);
+    // handle bounces off the ground...
+    if (position.y <= 0) {
+        velocity = velocity * glm::vec3(1,-1,1);
+        position.y = 0;
     }
+
+    // handle gravity....
+    velocity += gravity * timeElapsed;
+
+    // handle damping
+    glm::vec3 dampingResistance = velocity * damping;
+    velocity -= dampingResistance * timeElapsed;
 }
 
 void Particle::startParticleScriptContext(ScriptEngine& engine, ParticleScriptObject& particleScriptable) {
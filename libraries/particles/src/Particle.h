@@ -236,6 +236,7 @@ public:
 
     /// The last updated/simulated time of this particle from the time perspective of the authoritative server/source
     quint64 getLastUpdated() const { return _lastUpdated; }
+    void setLastUpdated(quint64 lastUpdated) { _lastUpdated = lastUpdated; }
 
     /// The last edited time of this particle from the time perspective of the authoritative server/source
     quint64 getLastEdited() const { return _lastEdited; }
@@ -295,6 +296,12 @@ public:
     void applyHardCollision(const CollisionInfo& collisionInfo);
 
     void update(const quint64& now);
+
+    /// Advances a particle's motion by a step of simulation: what update() does to particles that aren't in hand, once
+    /// their scripts have run.
+    static void integrate(glm::vec3& position, glm::vec3& velocity, const glm::vec3& gravity, float damping,
+                          float timeElapsed);
+
     void collisionWithParticle(Particle* other, const glm::vec3& penetration);
     void collisionWithVoxel(VoxelDetail* voxel, const glm::vec3& penetration);
 
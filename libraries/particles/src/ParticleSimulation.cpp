@@ -0,0 +1,105 @@
+//
+//  ParticleSimulation.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <SharedUtil.h>
+#include <WorkStealingPool.h>
+
+#include "Particle.h"
+#include "ParticleTreeElement.h"
+#include "ParticleSimulation.h"
+
+// enough particles to be worth a task of their own
+const int PARTICLES_PER_SIMULATE_TASK = 4096;
+
+class SimulateTask : public WorkStealingTask {
+public:
+    SimulateTask() : simulation(NULL), begin(0), end(0) { }
+
+    virtual void run() { simulation->simulateRange(begin, end); }
+
+    ParticleSimulation* simulation;
+    int begin;
+    int end;
+};
+
+ParticleSimulation::ParticleSimulation(WorkStealingPool* pool) :
+    _pool(pool ? pool : WorkStealingPool::getInstance()),
+    _count(0),
+    _lastSimulateUsecs(0) {
+}
+
+void ParticleSimulation::addParticle(ParticleTreeElement* element, int index, const Particle& particle, quint64 now) {
+    if (_count == _positions.size()) {
+        int size = qMax(PARTICLES_PER_SIMULATE_TASK, _count * 2);
+        _positions.resize(size);
+        _velocities.resize(size);
+        _gravities.resize(size);
+        _dampings.resize(size);
+        _timesElapsed.resize(size);
+        _elementBoxes.resize(size);
+        _flags.resize(size);
+        _sources.resize(size);
+    }
+    int slot = _count++;
+
+    Source& source = _sources[slot];
+    source.element = element;
+    source.index = index;
+    source.id = particle.getID();
+    source.creatorTokenID = particle.getCreatorTokenID();
+    source.lastEdited = particle.getLastEdited();
+    source.lastUpdated = particle.getLastUpdated();
+    source.isScripted = !particle.getScript().isEmpty();
+
+    _positions[slot] = particle.getPosition();
+    _velocities[slot] = particle.getVelocity();
+    _gravities[slot] = particle.getGravity();
+    _dampings[slot] = particle.getDamping();
+    _timesElapsed[slot] = (float)(now - particle.getLastUpdated()) / (float)USECS_PER_SECOND;
+    _elementBoxes[slot] = element->getAABox();
+
+    // the same test Particle::update makes, before scripts get their say
+    unsigned char flags = 0;
+    if (particle.getInHand() || source.isScripted) {
+        flags |= NOT_MOVING;
+    }
+    if (particle.getAge() > particle.getLifetime() || particle.getShouldDie()) {
+        flags |= SHOULD_DIE;
+    }
+    _flags[slot] = flags;
+}
+
+void ParticleSimulation::simulate() {
+    quint64 start = usecTimestampNow();
+    if (_count <= PARTICLES_PER_SIMULATE_TASK) {
+        simulateRange(0, _count);
+
+    } else {
+        QVector<SimulateTask> tasks((_count + PARTICLES_PER_SIMULATE_TASK - 1) / PARTICLES_PER_SIMULATE_TASK);
+        WorkStealingGroup group;
+        for (int i = 0; i < tasks.size(); i++) {
+            SimulateTask& task = tasks[i];
+            task.simulation = this;
+            task.begin = i * PARTICLES_PER_SIMULATE_TASK;
+            task.end = qMin(task.begin + PARTICLES_PER_SIMULATE_TASK, _count);
+            _pool->start(&task, group);
+        }
+        _pool->wait(group);
+    }
+    _lastSimulateUsecs = usecTimestampNow() - start;
+}
+
+void ParticleSimulation::simulateRange(int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        if (!(_flags[i] & NOT_MOVING)) {
+            Particle::integrate(_positions[i], _velocities[i], _gravities[i], _dampings[i], _timesElapsed[i]);
+        }
+        if (!_elementBoxes[i].contains(_positions[i])) {
+            _flags[i] |= LEFT_ELEMENT;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+//
+//  ParticleSimulation.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Steps the motion of a tree's particles in flat arrays, on worker threads, away from the tree and its lock
+//
+
+#ifndef __hifi__ParticleSimulation__
+#define __hifi__ParticleSimulation__
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+#include <AABox.h>
+
+class Particle;
+class ParticleTreeElement;
+class WorkStealingPool;
+
+/// The particles of a tree copied out for one step of simulation. ParticleTree::update adds every particle while it holds
+/// a read lock, steps them all with no lock held, then writes the results back and re-buckets the ones that left their
+/// element under its write lock. Motion is kept as structure of arrays, so that a step streams through just the
+/// positions, velocities and forces; where each particle came from is kept apart, since only the write back needs it.
+/// The arrays only ever grow, so a tree steps without allocating once it's seen its largest population.
+class ParticleSimulation {
+public:
+    /// Where a particle came from, so that the write back can find it again.
+    class Source {
+    public:
+        ParticleTreeElement* element;
+        int index; // in the element's particles when copied out
+        uint32_t id;
+        uint32_t creatorTokenID;
+        quint64 lastEdited; // if the particle has been edited since, the step is stale
+        quint64 lastUpdated;
+        bool isScripted; // scripts run on the particle itself, under the write lock, as they always have
+    };
+
+    /// \param pool the pool to step on, or NULL for the process wide one
+    ParticleSimulation(WorkStealingPool* pool = NULL);
+
+    /// Forgets the particles of the last step, keeping the storage.
+    void clear() { _count = 0; }
+
+    void addParticle(ParticleTreeElement* element, int index, const Particle& particle, quint64 now);
+
+    /// Steps every particle to now, splitting the work across the pool once there's enough of it.
+    void simulate();
+
+    int getCount() const { return _count; }
+    const Source& getSource(int index) const { return _sources.at(index); }
+    const glm::vec3& getPosition(int index) const { return _positions.at(index); }
+    const glm::vec3& getVelocity(int index) const { return _velocities.at(index); }
+    bool getShouldDie(int index) const { return _flags.at(index) & SHOULD_DIE; }
+
+    /// \return whether the particle wants to die or has left its element's bounds, and so needs re-bucketing
+    bool isMoving(int index) const { return _flags.at(index) & (SHOULD_DIE | LEFT_ELEMENT); }
+
+    quint64 getLastSimulateUsecs() const { return _lastSimulateUsecs; }
+
+    /// Steps a range of the particles; the work of one task.
+    void simulateRange(int begin, int end);
+
+private:
+    enum Flag {
+        NOT_MOVING = 0x01, // in hand or scripted
+        SHOULD_DIE = 0x02,
+        LEFT_ELEMENT = 0x04
+    };
+
+    WorkStealingPool* _pool;
+    int _count;
+
+    QVector<glm::vec3> _positions;
+    QVector<glm::vec3> _velocities;
+    QVector<glm::vec3> _gravities;
+    QVector<float> _dampings;
+    QVector<float> _timesElapsed;
+    QVector<AABox> _elementBoxes;
+    QVector<unsigned char> _flags;
+
+    QVector<Source> _sources;
+
+    quint64 _lastSimulateUsecs;
+};
+
+#endif /* defined(__hifi__ParticleSimulation__) */
@@ -6,12 +6,24 @@
 //  Copyright (c) 2013 High Fidelity, Inc. All rights reserved.
 //
 
+#include <OctalCode.h>
+
 #include "ParticleTree.h"
 
-ParticleTree::ParticleTree(bool shouldReaverage) : Octree(shouldReaverage) {
+ParticleTree::ParticleTree(bool shouldReaverage) :
+    Octree(shouldReaverage),
+    _lastFullPrune(0),
+    _lastUpdateUsecs(0),
+    _lastUpdateLockedUsecs(0) {
     _rootNode = createNewElement();
 }
 
+ParticleTree::~ParticleTree() {
+    // the elements take their particles out of the index as they go, so they need to go while it's still here
+    delete _rootNode;
+    _rootNode = NULL;
+}
+
 ParticleTreeElement* ParticleTree::createNewElement(unsigned char * octalCode) {
     ParticleTreeElement* newElement = new ParticleTreeElement(octalCode);
     newElement->setTree(this);
@@ -29,114 +41,62 @@ bool ParticleTree::handlesEditPacketType(PacketType packetType) const {
     }
 }
 
-class FindAndDeleteParticlesArgs {
-public:
-    QList<uint32_t> _idsToDelete;
-};
-
-bool ParticleTree::findAndDeleteOperation(OctreeElement* element, void* extraData) {
-    //qDebug() << "findAndDeleteOperation()";
-
-    FindAndDeleteParticlesArgs* args = static_cast< FindAndDeleteParticlesArgs*>(extraData);
-
-    // if we've found and deleted all our target particles, then we can stop looking
-    if (args->_idsToDelete.size() <= 0) {
-        return false;
-    }
-
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-
-    //qDebug() << "findAndDeleteOperation() args->_idsToDelete.size():" << args->_idsToDelete.size();
-
-    for (QList<uint32_t>::iterator it = args->_idsToDelete.begin(); it != args->_idsToDelete.end(); it++) {
-        uint32_t particleID = *it;
-        //qDebug() << "findAndDeleteOperation() particleID:" << particleID;
-
-        if (particleTreeElement->removeParticleWithID(particleID)) {
-            // if the particle was in this element, then remove it from our search list.
-            //qDebug() << "findAndDeleteOperation() it = args->_idsToDelete.erase(it)";
-            it = args->_idsToDelete.erase(it);
-        }
-
-        if (it == args->_idsToDelete.end()) {
-            //qDebug() << "findAndDeleteOperation() breaking";
-            break;
-        }
+void ParticleTree::particleEnteredElement(const Particle& particle, ParticleTreeElement* element) {
+    if (particle.getID() != UNKNOWN_PARTICLE_ID) {
+        _particleToElementMap.insert(particle.getID(), element);
     }
-
-    // if we've found and deleted all our target particles, then we can stop looking
-    if (args->_idsToDelete.size() <= 0) {
-        return false;
+    if (particle.getCreatorTokenID() != UNKNOWN_TOKEN) {
+        _creatorTokenToElementMap.insert(particle.getCreatorTokenID(), element);
     }
-    return true;
 }
 
+void ParticleTree::particleLeftElement(const Particle& particle, ParticleTreeElement* element) {
+    // a viewing tree can briefly hold two copies of a particle, ours and the server's, so only forget the element if
+    // it's the one we have on record and it no longer holds the ID at all
+    if (particle.getID() != UNKNOWN_PARTICLE_ID && _particleToElementMap.value(particle.getID()) == element
+            && !element->getParticleWithID(particle.getID())) {
+        _particleToElementMap.remove(particle.getID());
+    }
+    if (particle.getCreatorTokenID() != UNKNOWN_TOKEN
+            && _creatorTokenToElementMap.value(particle.getCreatorTokenID()) == element) {
+        _creatorTokenToElementMap.remove(particle.getCreatorTokenID());
+    }
 
-class FindAndUpdateParticleArgs {
-public:
-    const Particle& searchParticle;
-    bool found;
-};
-
-bool ParticleTree::findAndUpdateOperation(OctreeElement* element, void* extraData) {
-    FindAndUpdateParticleArgs* args = static_cast<FindAndUpdateParticleArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-    // Note: updateParticle() will only operate on correctly found particles
-    if (particleTreeElement->updateParticle(args->searchParticle)) {
-        args->found = true;
-        return false; // stop searching
+    // left for the next update to prune
+    if (!element->hasParticles() && element->isLeaf()) {
+        const unsigned char* octalCode = element->getOctalCode();
+        _emptiedElementCodes.insert(QByteArray(reinterpret_cast<const char*>(octalCode),
+            bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode))));
     }
-    return true;
 }
 
 void ParticleTree::storeParticle(const Particle& particle, const SharedNodePointer& senderNode) {
     // First, look for the existing particle in the tree..
-    FindAndUpdateParticleArgs args = { particle, false };
-    recurseTreeWithOperation(findAndUpdateOperation, &args);
+    ParticleTreeElement* element = NULL;
+    if (particle.getID() != UNKNOWN_PARTICLE_ID) {
+        element = getContainingElement(particle.getID());
+    }
 
     // if we didn't find it in the tree, then store it...
-    if (!args.found) {
+    if (!element || !element->updateParticle(particle)) {
         glm::vec3 position = particle.getPosition();
         float size = std::max(MINIMUM_PARTICLE_ELEMENT_SIZE, particle.getRadius());
 
-        ParticleTreeElement* element = (ParticleTreeElement*)getOrCreateChildElementAt(position.x, position.y, position.z, size);
+        element = (ParticleTreeElement*)getOrCreateChildElementAt(position.x, position.y, position.z, size);
         element->storeParticle(particle);
     }
     // what else do we need to do here to get reaveraging to work
-    _isDirty = true;
-}
-
-class FindAndUpdateParticleWithIDandPropertiesArgs {
-public:
-    const ParticleID& particleID;
-    const ParticleProperties& properties;
-    bool found;
-};
-
-bool ParticleTree::findAndUpdateWithIDandPropertiesOperation(OctreeElement* element, void* extraData) {
-    FindAndUpdateParticleWithIDandPropertiesArgs* args = static_cast<FindAndUpdateParticleWithIDandPropertiesArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-    // Note: updateParticle() will only operate on correctly found particles
-    if (particleTreeElement->updateParticle(args->particleID, args->properties)) {
-        args->found = true;
-        return false; // stop searching
-    }
-
-    // if we've found our particle stop searching
-    if (args->found) {
-        return false;
-    }
-
-    return true;
+    setDirtyBit();
 }
 
 void ParticleTree::updateParticle(const ParticleID& particleID, const ParticleProperties& properties) {
     // First, look for the existing particle in the tree..
-    FindAndUpdateParticleWithIDandPropertiesArgs args = { particleID, properties, false };
-    recurseTreeWithOperation(findAndUpdateWithIDandPropertiesOperation, &args);
+    ParticleTreeElement* element = particleID.isKnownID ? getContainingElement(particleID.id)
+        : _creatorTokenToElementMap.value(particleID.creatorTokenID);
+
     // if we found it in the tree, then mark the tree as dirty
-    if (args.found) {
-        _isDirty = true;
+    if (element && element->updateParticle(particleID, properties)) {
+        setDirtyBit();
     }
 }
 
@@ -152,39 +112,20 @@ void ParticleTree::addParticle(const ParticleID& particleID, const ParticlePrope
     ParticleTreeElement* element = (ParticleTreeElement*)getOrCreateChildElementAt(position.x, position.y, position.z, size);
     element->storeParticle(particle);
     
-    _isDirty = true;
+    setDirtyBit();
 }
 
 void ParticleTree::deleteParticle(const ParticleID& particleID) {
     if (particleID.isKnownID) {
-        FindAndDeleteParticlesArgs args;
-        args._idsToDelete.push_back(particleID.id);
-        recurseTreeWithOperation(findAndDeleteOperation, &args);
-    }
-}
-
-// scans the tree and handles mapping locally created particles to know IDs.
-// in the event that this tree is also viewing the scene, then we need to also
-// search the tree to make sure we don't have a duplicate particle from the viewing
-// operation.
-bool ParticleTree::findAndUpdateParticleIDOperation(OctreeElement* element, void* extraData) {
-    bool keepSearching = true;
-
-    FindAndUpdateParticleIDArgs* args = static_cast<FindAndUpdateParticleIDArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-
-    // Note: updateParticleID() will only operate on correctly found particles
-    particleTreeElement->updateParticleID(args);
-
-    // if we've found and replaced both the creatorTokenID and the viewedParticle, then we
-    // can stop looking, otherwise we will keep looking    
-    if (args->creatorTokenFound && args->viewedParticleFound) {
-        keepSearching = false;
+        ParticleTreeElement* element = getContainingElement(particleID.id);
+        if (element) {
+            element->removeParticleWithID(particleID.id);
+        }
     }
-    
-    return keepSearching;
 }
 
+// handles mapping locally created particles to known IDs. in the event that this tree is also viewing the scene, then
+// we need to also remove any duplicate particle from the viewing operation.
 void ParticleTree::handleAddParticleResponse(const QByteArray& packet) {
     int numBytesPacketHeader = numBytesForPacketHeader(packet);
     
@@ -214,7 +155,15 @@ void ParticleTree::handleAddParticleResponse(const QByteArray& packet) {
                 << " getIsViewing()=" << getIsViewing();
     }
     lockForWrite();
-    recurseTreeWithOperation(findAndUpdateParticleIDOperation, &args);
+    // look both up before either changes the index: ours by its token, and the viewed copy by the ID it already has
+    ParticleTreeElement* creatorElement = _creatorTokenToElementMap.value(creatorTokenID);
+    ParticleTreeElement* viewedElement = getIsViewing() ? getContainingElement(particleID) : NULL;
+    if (creatorElement) {
+        creatorElement->updateParticleID(&args);
+    }
+    if (viewedElement && viewedElement != creatorElement) {
+        viewedElement->updateParticleID(&args);
+    }
     unlock();
 }
 
@@ -337,49 +286,16 @@ void ParticleTree::findParticlesForUpdate(const AABox& box, QVector<Particle*> f
     foundParticles.swap(args._foundParticles);
 }
 
-class FindByIDArgs {
-public:
-    uint32_t id;
-    bool found;
-    const Particle* foundParticle;
-};
-
-
-bool ParticleTree::findByIDOperation(OctreeElement* element, void* extraData) {
-//qDebug() << "ParticleTree::findByIDOperation()....";
-
-    FindByIDArgs* args = static_cast<FindByIDArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-
-    // if already found, stop looking
-    if (args->found) {
-        return false;
-    }
-
-    // as the tree element if it has this particle
-    const Particle* foundParticle = particleTreeElement->getParticleWithID(args->id);
-    if (foundParticle) {
-        args->foundParticle = foundParticle;
-        args->found = true;
-        return false;
-    }
-
-    // keep looking
-    return true;
-}
-
-
 const Particle* ParticleTree::findParticleByID(uint32_t id, bool alreadyLocked) {
-    FindByIDArgs args = { id, false, NULL };
-
     if (!alreadyLocked) {
         lockForRead();
     }
-    recurseTreeWithOperation(findByIDOperation, &args);
+    ParticleTreeElement* element = getContainingElement(id);
+    const Particle* foundParticle = element ? element->getParticleWithID(id) : NULL;
     if (!alreadyLocked) {
         unlock();
     }
-    return args.foundParticle;
+    return foundParticle;
 }
 
 
@@ -439,13 +355,6 @@ void ParticleTree::removeNewlyCreatedHook(NewlyCreatedParticleHook* hook) {
 }
 
 
-bool ParticleTree::updateOperation(OctreeElement* element, void* extraData) {
-    ParticleTreeUpdateArgs* args = static_cast<ParticleTreeUpdateArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-    particleTreeElement->update(*args);
-    return true;
-}
-
 bool ParticleTree::pruneOperation(OctreeElement* element, void* extraData) {
     ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
     for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
@@ -457,12 +366,78 @@ bool ParticleTree::pruneOperation(OctreeElement* element, void* extraData) {
     return true;
 }
 
+// copies every particle in the tree out into the simulation
+class SimulationGatherVisitor {
+public:
+    SimulationGatherVisitor(ParticleSimulation& simulation, quint64 now) : _simulation(simulation), _now(now) { }
+
+    bool visit(OctreeElement* element) {
+        ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
+        const QList<Particle>& particles = particleTreeElement->getParticles();
+        for (int i = 0; i < particles.size(); i++) {
+            _simulation.addParticle(particleTreeElement, i, particles.at(i), _now);
+        }
+        return true;
+    }
+
+private:
+    ParticleSimulation& _simulation;
+    quint64 _now;
+};
+
+// the rest of the tree is pruned as it goes, but whatever else leaves empty leaves behind is caught this often
+const quint64 FULL_PRUNE_INTERVAL_USECS = USECS_PER_SECOND;
+
 void ParticleTree::update() {
+    quint64 start = usecTimestampNow();
+
+    lockForRead();
+    quint64 now = usecTimestampNow();
+    _simulation.clear();
+    SimulationGatherVisitor gatherVisitor(_simulation, now);
+    visitTree(gatherVisitor);
+    unlock();
+
+    _simulation.simulate();
+
     lockForWrite();
-    _isDirty = true;
+    quint64 lockedAt = usecTimestampNow();
+    setDirtyBit();
+
+    // copy the steps back, noting which elements have particles to move out
+    QVector<ParticleTreeElement*> elementsWithMovingParticles;
+    ParticleTreeElement* lastElement = NULL;
+    for (int i = 0; i < _simulation.getCount(); i++) {
+        const ParticleSimulation::Source& source = _simulation.getSource(i);
+        Particle* particle = findSimulatedParticle(source);
+        if (!particle) {
+            continue; // deleted, moved or edited since it was copied out, it'll be stepped next time
+        }
+        bool isMoving;
+        if (source.isScripted) {
+            particle->update(now);
+            isMoving = particle->getShouldDie() || !source.element->getAABox().contains(particle->getPosition());
+        } else {
+            particle->setPosition(_simulation.getPosition(i));
+            particle->setVelocity(_simulation.getVelocity(i));
+            particle->setShouldDie(_simulation.getShouldDie(i));
+            particle->setLastUpdated(now);
+            isMoving = _simulation.isMoving(i);
+        }
+        // each element's particles were copied out together
+        if (source.element != lastElement) {
+            source.element->markWithChangedTime();
+            lastElement = source.element;
+        }
+        if (isMoving && (elementsWithMovingParticles.isEmpty() || elementsWithMovingParticles.last() != source.element)) {
+            elementsWithMovingParticles.append(source.element);
+        }
+    }
 
-    ParticleTreeUpdateArgs args = { };
-    recurseTreeWithOperation(updateOperation, &args);
+    ParticleTreeUpdateArgs args;
+    for (int i = 0; i < elementsWithMovingParticles.size(); i++) {
+        elementsWithMovingParticles[i]->takeMovingParticles(args);
+    }
 
     // now add back any of the particles that moved elements....
     int movingParticles = args._movingParticles.size();
@@ -484,10 +459,69 @@ void ParticleTree::update() {
     }
 
     // prune the tree...
-    recurseTreeWithOperation(pruneOperation, NULL);
+    pruneEmptiedElements();
+    if (now - _lastFullPrune > FULL_PRUNE_INTERVAL_USECS) {
+        OctreeOperationVisitor<pruneOperation> pruneVisitor;
+        visitTree(pruneVisitor);
+        _lastFullPrune = now;
+    }
+    quint64 end = usecTimestampNow();
     unlock();
+
+    _lastUpdateUsecs = end - start;
+    _lastUpdateLockedUsecs = end - lockedAt;
 }
 
+Particle* ParticleTree::findSimulatedParticle(const ParticleSimulation::Source& source) {
+    // the index only holds live elements, so if it still points at the source's, the source's is still there
+    ParticleTreeElement* element = NULL;
+    if (source.id != UNKNOWN_PARTICLE_ID) {
+        element = getContainingElement(source.id);
+    } else if (source.creatorTokenID != UNKNOWN_TOKEN) {
+        element = _creatorTokenToElementMap.value(source.creatorTokenID);
+    }
+    if (!element || element != source.element) {
+        return NULL;
+    }
+    QList<Particle>& particles = element->getParticles();
+    Particle* particle = NULL;
+    if (source.index < particles.size() && particles[source.index].getID() == source.id
+            && particles[source.index].getCreatorTokenID() == source.creatorTokenID) {
+        particle = &particles[source.index];
+    } else {
+        for (int i = 0; i < particles.size(); i++) {
+            if (particles[i].getID() == source.id && particles[i].getCreatorTokenID() == source.creatorTokenID) {
+                particle = &particles[i];
+                break;
+            }
+        }
+    }
+    if (particle && (particle->getLastEdited() != source.lastEdited || particle->getLastUpdated() != source.lastUpdated)) {
+        return NULL;
+    }
+    return particle;
+}
+
+void ParticleTree::pruneEmptiedElements() {
+    QSet<QByteArray> emptiedElementCodes;
+    emptiedElementCodes.swap(_emptiedElementCodes);
+    foreach (const QByteArray& code, emptiedElementCodes) {
+        const unsigned char* octalCode = reinterpret_cast<const unsigned char*>(code.constData());
+        OctreeElement* parent = NULL;
+        OctreeElement* element = nodeForOctalCode(_rootNode, octalCode, &parent);
+
+        // the lookup stops short at the nearest ancestor if the element is already gone
+        if (*element->getOctalCode() != *octalCode) {
+            continue;
+        }
+        while (parent && element->isLeaf() && !static_cast<ParticleTreeElement*>(element)->hasParticles()) {
+            parent->deleteChildAtIndex(branchIndexWithDescendant(parent->getOctalCode(), element->getOctalCode()));
+            element = parent;
+            parent = NULL;
+            nodeForOctalCode(_rootNode, element->getOctalCode(), &parent);
+        }
+    }
+}
 
 bool ParticleTree::hasParticlesDeletedSince(quint64 sinceTime) {
     // we can probably leverage the ordered nature of QMultiMap to do this quickly...
@@ -612,8 +646,6 @@ void ParticleTree::processEraseMessage(const QByteArray& dataByteArray, const Sh
     processedBytes += sizeof(numberOfIds);
 
     if (numberOfIds > 0) {
-        FindAndDeleteParticlesArgs args;
-
         for (size_t i = 0; i < numberOfIds; i++) {
             if (processedBytes + sizeof(uint32_t) > packetLength) {
                 break; // bail to prevent buffer overflow
@@ -624,10 +656,10 @@ void ParticleTree::processEraseMessage(const QByteArray& dataByteArray, const Sh
             dataAt += sizeof(particleID);
             processedBytes += sizeof(particleID);
 
-            args._idsToDelete.push_back(particleID);
+            ParticleTreeElement* element = getContainingElement(particleID);
+            if (element) {
+                element->removeParticleWithID(particleID);
+            }
         }
-
-        // calling recurse to actually delete the particles
-        recurseTreeWithOperation(findAndDeleteOperation, &args);
     }
 }
@@ -9,7 +9,12 @@
 #ifndef __hifi__ParticleTree__
 #define __hifi__ParticleTree__
 
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+
 #include <Octree.h>
+#include "ParticleSimulation.h"
 #include "ParticleTreeElement.h"
 
 class NewlyCreatedParticleHook {
@@ -21,6 +26,7 @@ class ParticleTree : public Octree {
     Q_OBJECT
 public:
     ParticleTree(bool shouldReaverage = false);
+    virtual ~ParticleTree();
 
     /// Implements our type specific root element factory
     virtual ParticleTreeElement* createNewElement(unsigned char * octalCode = NULL);
@@ -37,8 +43,15 @@ public:
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& senderNode);
 
+    /// Steps the simulation: particles are copied out under a read lock and stepped on worker threads with no lock
+    /// held. The write lock is only taken to copy the results back, run particle scripts, re-bucket the particles
+    /// that left their elements and prune the elements they left empty.
     virtual void update();
 
+    /// \return how long the last update took, and how much of that it held the write lock for
+    quint64 getLastUpdateUsecs() const { return _lastUpdateUsecs; }
+    quint64 getLastUpdateLockedUsecs() const { return _lastUpdateLockedUsecs; }
+
     void storeParticle(const Particle& particle, const SharedNodePointer& senderNode = SharedNodePointer());
     void updateParticle(const ParticleID& particleID, const ParticleProperties& properties);
     void addParticle(const ParticleID& particleID, const ParticleProperties& properties);
@@ -46,6 +59,9 @@ public:
     const Particle* findClosestParticle(glm::vec3 position, float targetRadius);
     const Particle* findParticleByID(uint32_t id, bool alreadyLocked = false);
 
+    /// \return the element holding the particle with the given ID, or NULL if there's none, in constant time
+    ParticleTreeElement* getContainingElement(uint32_t particleID) const { return _particleToElementMap.value(particleID); }
+
     /// finds all particles that touch a sphere
     /// \param center the center of the sphere
     /// \param radius the radius of the sphere
@@ -71,16 +87,23 @@ public:
     void handleAddParticleResponse(const QByteArray& packet);
 
 private:
+    friend class ParticleTreeElement; // to keep the index up to date as particles come and go
 
-    static bool updateOperation(OctreeElement* element, void* extraData);
-    static bool findAndUpdateOperation(OctreeElement* element, void* extraData);
-    static bool findAndUpdateWithIDandPropertiesOperation(OctreeElement* element, void* extraData);
     static bool findNearPointOperation(OctreeElement* element, void* extraData);
     static bool findInSphereOperation(OctreeElement* element, void* extraData);
     static bool pruneOperation(OctreeElement* element, void* extraData);
-    static bool findByIDOperation(OctreeElement* element, void* extraData);
-    static bool findAndDeleteOperation(OctreeElement* element, void* extraData);
-    static bool findAndUpdateParticleIDOperation(OctreeElement* element, void* extraData);
+
+    /// Called by an element whenever a particle is added to it, or gets a new ID or creator token.
+    void particleEnteredElement(const Particle& particle, ParticleTreeElement* element);
+
+    /// Called by an element whenever a particle is removed from it.
+    void particleLeftElement(const Particle& particle, ParticleTreeElement* element);
+
+    /// \return the particle a simulation copied out, if it's still where it was and hasn't been edited since
+    Particle* findSimulatedParticle(const ParticleSimulation::Source& source);
+
+    /// Deletes the elements particles have left empty, and any parents that leaves empty in turn.
+    void pruneEmptiedElements();
 
     void notifyNewlyCreatedParticle(const Particle& newParticle, const SharedNodePointer& senderNode);
 
@@ -90,6 +113,17 @@ private:
 
     QReadWriteLock _recentlyDeletedParticlesLock;
     QMultiMap<quint64, uint32_t> _recentlyDeletedParticleIDs;
+
+    // which element each particle lives in, by ID and, for particles we created that the server hasn't yet
+    // given an ID, by creator token; guarded by the tree's lock like the elements themselves
+    QHash<uint32_t, ParticleTreeElement*> _particleToElementMap;
+    QHash<uint32_t, ParticleTreeElement*> _creatorTokenToElementMap;
+
+    ParticleSimulation _simulation;
+    QSet<QByteArray> _emptiedElementCodes; // codes rather than elements, since the elements may be gone by the prune
+    quint64 _lastFullPrune;
+    quint64 _lastUpdateUsecs;
+    quint64 _lastUpdateLockedUsecs;
 };
 
 #endif /* defined(__hifi__ParticleTree__) */
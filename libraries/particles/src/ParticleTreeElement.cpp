@@ -11,12 +11,21 @@
 #include "ParticleTree.h"
 #include "ParticleTreeElement.h"
 
-ParticleTreeElement::ParticleTreeElement(unsigned char* octalCode) : OctreeElement(), _particles(NULL) {
+ParticleTreeElement::ParticleTreeElement(unsigned char* octalCode) : OctreeElement(), _myTree(NULL), _particles(NULL) {
     init(octalCode);
 };
 
 ParticleTreeElement::~ParticleTreeElement() {
     _voxelMemoryUsage -= sizeof(ParticleTreeElement);
+
+    // take our particles out of the tree's index, emptying the list first so that none of them are still found here
+    QList<Particle> particles;
+    particles.swap(*_particles);
+    if (_myTree) {
+        for (int i = 0; i < particles.size(); i++) {
+            _myTree->particleLeftElement(particles[i], this);
+        }
+    }
     delete _particles;
     _particles = NULL;
 }
@@ -68,10 +77,18 @@ void ParticleTreeElement::update(ParticleTreeUpdateArgs& args) {
     // TODO: early exit when _particles is empty
 
     // update our contained particles
+    QList<Particle>::iterator particleItr = _particles->begin();
+    while(particleItr != _particles->end()) {
+        (*particleItr).update(_lastChanged);
+        ++particleItr;
+    }
+    takeMovingParticles(args);
+}
+
+void ParticleTreeElement::takeMovingParticles(ParticleTreeUpdateArgs& args) {
     QList<Particle>::iterator particleItr = _particles->begin();
     while(particleItr != _particles->end()) {
         Particle& particle = (*particleItr);
-        particle.update(_lastChanged);
 
         // If the particle wants to die, or if it's left our bounding box, then move it
         // into the arguments moving particles. These will be added back or deleted completely
@@ -80,6 +97,7 @@ void ParticleTreeElement::update(ParticleTreeUpdateArgs& args) {
 
             // erase this particle
             particleItr = _particles->erase(particleItr);
+            _myTree->particleLeftElement(args._movingParticles.last(), this);
         } else {
             ++particleItr;
         }
@@ -144,7 +162,15 @@ bool ParticleTreeElement::updateParticle(const Particle& particle) {
                             (localOlder ? "OLDER" : "NEWER"),
                             difference, debug::valueOf(particle.isNewlyCreated()) );
                 }
+                // the server's copy may not carry our creator token, so keep the index in step with it
+                bool tokenChanged = thisParticle.getCreatorTokenID() != particle.getCreatorTokenID();
+                if (tokenChanged) {
+                    _myTree->particleLeftElement(thisParticle, this);
+                }
                 thisParticle.copyChangedProperties(particle);
+                if (tokenChanged) {
+                    _myTree->particleEnteredElement(thisParticle, this);
+                }
             } else {
                 if (wantDebug) {
                     printf(">>> IGNORING SERVER!!! Would've caused jutter! <<<  "
@@ -199,6 +225,7 @@ void ParticleTreeElement::updateParticleID(FindAndUpdateParticleIDArgs* args) {
             // first, we're looking for matching creatorTokenIDs, if we find that, then we fix it to know the actual ID
             if (thisParticle.getCreatorTokenID() == args->creatorTokenID) {
                 thisParticle.setID(args->particleID);
+                _myTree->particleEnteredElement(thisParticle, this);
                 args->creatorTokenFound = true;
             }
         }
@@ -206,7 +233,8 @@ void ParticleTreeElement::updateParticleID(FindAndUpdateParticleIDArgs* args) {
         // if we're in an isViewing tree, we also need to look for an kill any viewed particles
         if (!args->viewedParticleFound && args->isViewing) {
             if (thisParticle.getCreatorTokenID() == UNKNOWN_TOKEN && thisParticle.getID() == args->particleID) {
-                _particles->removeAt(i); // remove the particle at this index
+                Particle viewedParticle = _particles->takeAt(i); // remove the particle at this index
+                _myTree->particleLeftElement(viewedParticle, this);
                 numberOfParticles--; // this means we have 1 fewer particle in this list
                 i--; // and we actually want to back up i as well.
                 args->viewedParticleFound = true;
@@ -278,7 +306,8 @@ bool ParticleTreeElement::removeParticleWithID(uint32_t id) {
     for (uint16_t i = 0; i < numberOfParticles; i++) {
         if ((*_particles)[i].getID() == id) {
             foundParticle = true;
-            _particles->removeAt(i);
+            Particle removedParticle = _particles->takeAt(i);
+            _myTree->particleLeftElement(removedParticle, this);
             break;
         }
     }
@@ -332,6 +361,7 @@ bool ParticleTreeElement::collapseChildren() {
 
 void ParticleTreeElement::storeParticle(const Particle& particle) {
     _particles->push_back(particle);
+    _myTree->particleEnteredElement(particle, this);
     markWithChangedTime();
 }
 
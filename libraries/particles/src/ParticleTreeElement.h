@@ -95,6 +95,10 @@ public:
     bool hasParticles() const { return _particles->size() > 0; }
 
     void update(ParticleTreeUpdateArgs& args);
+
+    /// Moves the particles that want to die or have left this element's bounds into the args' moving particles, without
+    /// updating any. ParticleTree::update calls it on just the elements its simulation found particles leaving.
+    void takeMovingParticles(ParticleTreeUpdateArgs& args);
     void setTree(ParticleTree* tree) { _myTree = tree; }
 
     bool updateParticle(const Particle& particle);
@@ -0,0 +1,63 @@
+//
+//  DatagramQueue.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include "DatagramQueue.h"
+#include "SharedUtil.h"
+
+DatagramQueue::DatagramQueue(int capacity) :
+    SPSCQueue<QueuedDatagram>(capacity),
+    _isConsumerAwake(0),
+    _droppedCount(0),
+    _isSpilling(0)
+{
+    for (int i = 0; i < getCapacity(); i++) {
+        getSlot(i).datagram.reserve(MAX_PACKET_SIZE);
+    }
+}
+
+bool DatagramQueue::push(QByteArray& datagram, const QWeakPointer<Node>& sendingNode) {
+    QueuedDatagram* slot = getBack();
+    if (!slot) {
+        _droppedCount.fetchAndAddRelaxed(1);
+        return false;
+    }
+    slot->datagram.swap(datagram);
+    slot->sendingNode = sendingNode;
+    SPSCQueue<QueuedDatagram>::push();
+    return true;
+}
+
+void DatagramQueue::pushOrSpill(QByteArray& datagram, const QWeakPointer<Node>& sendingNode) {
+    // only this thread sets the flag, so if it's clear the ring has nothing behind it
+    if (!_isSpilling.loadAcquire()) {
+        QueuedDatagram* slot = getBack();
+        if (slot) {
+            slot->datagram.swap(datagram);
+            slot->sendingNode = sendingNode;
+            SPSCQueue<QueuedDatagram>::push();
+            return;
+        }
+    }
+    QMutexLocker locker(&_spillMutex);
+    QueuedDatagram spilled;
+    spilled.datagram = datagram;
+    spilled.sendingNode = sendingNode;
+    _spilled.append(spilled);
+    _isSpilling.storeRelease(1);
+}
+
+bool DatagramQueue::takeSpilled(QList<QueuedDatagram>& datagrams) {
+    QMutexLocker locker(&_spillMutex);
+    datagrams.clear();
+    if (_spilled.isEmpty()) {
+        // the ring is empty and nothing is behind it, so the producer can go back to it
+        _isSpilling.storeRelease(0);
+        return false;
+    }
+    datagrams.swap(_spilled);
+    return true;
+}
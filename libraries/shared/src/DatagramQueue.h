@@ -0,0 +1,69 @@
+//
+//  DatagramQueue.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Datagrams handed from the network thread to one subsystem's thread in pooled buffers
+//
+
+#ifndef __hifi__DatagramQueue__
+#define __hifi__DatagramQueue__
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QWeakPointer>
+
+#include "Node.h"
+#include "SPSCQueue.h"
+
+/// A datagram waiting on a subsystem, with the node it came from.
+class QueuedDatagram {
+public:
+    QByteArray datagram;
+    QWeakPointer<Node> sendingNode;
+};
+
+/// The datagrams for one subsystem, filled by DatagramProcessor on the network thread and drained on the subsystem's own
+/// thread. Every slot's buffer is allocated up front at the largest packet size, and the network thread swaps its read
+/// buffer with a slot's rather than copying, so handing a datagram over neither copies nor allocates. Datagrams that
+/// mustn't be dropped can spill past a full ring into a locked list, which the consumer drains after the ring.
+class DatagramQueue : public SPSCQueue<QueuedDatagram> {
+public:
+    DatagramQueue(int capacity);
+
+    /// Network thread only: hands over the datagram, leaving a spare buffer in its place.
+    /// \return whether there was room for it
+    bool push(QByteArray& datagram, const QWeakPointer<Node>& sendingNode);
+
+    /// Network thread only: hands over the datagram like push, but copies it into the spill list rather than dropping it
+    /// when the ring is full. Once anything has spilled, everything after it spills too until the consumer has drained
+    /// the list, so the datagrams still come out in the order they went in.
+    void pushOrSpill(QByteArray& datagram, const QWeakPointer<Node>& sendingNode);
+
+    /// Consumer only: call once the ring is empty, and process what it returns before looking at the ring again.
+    /// eturn whether there were any spilled datagrams, which are moved to the given list; when there weren't, the
+    /// producer goes back to the ring
+    bool takeSpilled(QList<QueuedDatagram>& datagrams);
+
+    /// Network thread only.
+    /// \return whether the consumer needs waking, which is true for just the first push since its last drain
+    bool shouldWakeConsumer() { return _isConsumerAwake.testAndSetOrdered(0, 1); }
+
+    /// Consumer only: call before draining, so that anything pushed from here on wakes the consumer again.
+    void consumerWoke() { _isConsumerAwake.fetchAndStoreOrdered(0); }
+
+    int getDroppedCount() const { return _droppedCount.load(); }
+
+private:
+    QAtomicInt _isConsumerAwake;
+    QAtomicInt _droppedCount; // written by the network thread, read for the stats
+
+    QMutex _spillMutex;
+    QList<QueuedDatagram> _spilled;
+    QAtomicInt _isSpilling; // set by the producer and cleared by the consumer, both holding the mutex
+};
+
+#endif /* defined(__hifi__DatagramQueue__) */
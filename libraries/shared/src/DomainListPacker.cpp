@@ -0,0 +1,95 @@
+//
+//  DomainListPacker.cpp
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QDataStream>
+
+#include "PacketHeaders.h"
+#include "SharedUtil.h"
+
+#include "DomainListPacker.h"
+
+DomainListPacker::~DomainListPacker() {
+    
+}
+
+QList<QByteArray> DomainListPacker::pack(const DomainMembershipLog& log, const SharedNodePointer& node,
+                                         const NodeHash& nodes, const NodeSet& nodeInterestList,
+                                         quint32 lastEpoch, quint32 lastVersion) {
+    // if we still have the changes since the last version this node saw, that's all we need to send it
+    QList<DomainMembershipLog::Change> changes;
+    bool isFullList = !log.changesSince(lastEpoch, lastVersion, changes);
+    
+    QList<QByteArray> entries;
+    
+    if (nodeInterestList.size() > 0) {
+        // if the node has any interest types, send back those nodes as well
+        if (isFullList) {
+            foreach (const SharedNodePointer& otherNode, nodes) {
+                if (otherNode->getUUID() != node->getUUID() && nodeInterestList.contains(otherNode->getType())) {
+                    entries.append(entryForNode(node, otherNode));
+                }
+            }
+        } else {
+            foreach (const DomainMembershipLog::Change& change, changes) {
+                if (change.nodeUUID == node->getUUID()) {
+                    continue;
+                }
+                
+                if (change.type == DomainMembershipLog::NodeAdded) {
+                    SharedNodePointer otherNode = nodes.value(change.nodeUUID);
+                    if (otherNode && nodeInterestList.contains(otherNode->getType())) {
+                        entries.append(entryForNode(node, otherNode));
+                    }
+                } else {
+                    // we no longer know what type the removed node was, the node will ignore it if it never had it
+                    QByteArray entryByteArray;
+                    QDataStream entryDataStream(&entryByteArray, QIODevice::Append);
+                    entryDataStream << (quint8) DomainMembershipLog::NodeRemoved << change.nodeUUID;
+                    entries.append(entryByteArray);
+                }
+            }
+        }
+    }
+    
+    // always send the node their own UUID back, followed by the version of the list this brings it up to
+    QByteArray leadBytes = byteArrayWithPopulatedHeader(PacketTypeDomainList);
+    QDataStream leadDataStream(&leadBytes, QIODevice::Append);
+    leadDataStream << node->getUUID() << log.getEpoch() << log.getVersion() << (quint8) isFullList;
+    
+    // each packet also says which of how many it is, so the node knows when it has the whole version
+    const int NUM_PACKET_COUNT_BYTES = 2 * sizeof(quint8);
+    
+    QList<QByteArray> packetBodies;
+    packetBodies.append(QByteArray());
+    foreach (const QByteArray& entry, entries) {
+        if (leadBytes.size() + NUM_PACKET_COUNT_BYTES + packetBodies.last().size() + entry.size() > MAX_PACKET_SIZE) {
+            // we need to break here and start a new packet
+            packetBodies.append(QByteArray());
+        }
+        packetBodies.last().append(entry);
+    }
+    
+    QList<QByteArray> packets;
+    for (int i = 0; i < packetBodies.size(); i++) {
+        QByteArray broadcastPacket = leadBytes;
+        QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
+        broadcastDataStream << (quint8) i << (quint8) packetBodies.size();
+        broadcastPacket.append(packetBodies[i]);
+        packets.append(broadcastPacket);
+    }
+    return packets;
+}
+
+QByteArray DomainListPacker::entryForNode(const SharedNodePointer& node, const SharedNodePointer& otherNode) {
+    QByteArray entryByteArray;
+    QDataStream entryDataStream(&entryByteArray, QIODevice::Append);
+    
+    entryDataStream << (quint8) DomainMembershipLog::NodeAdded << *otherNode.data()
+        << getConnectionSecret(node, otherNode);
+    
+    return entryByteArray;
+}
@@ -0,0 +1,41 @@
+//
+//  DomainListPacker.h
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+//  Packs the domain-server's answer to a node's check-in
+//
+
+#ifndef __hifi__DomainListPacker__
+#define __hifi__DomainListPacker__
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QUuid>
+
+#include "DomainMembershipLog.h"
+#include "NodeList.h"
+
+/// Packs the domain list for a node that checked in. The node gets its own UUID back and the version of the list the
+/// packets bring it up to, followed by either every node it's interested in or only the nodes that changed since the
+/// version it last saw, split across as many packets as it takes. Each packet says which of how many it is.
+class DomainListPacker {
+public:
+    virtual ~DomainListPacker();
+
+    /// \param nodes every node in the domain
+    /// \param lastEpoch, lastVersion the version of the list the node reported, NO_DOMAIN_LIST_VERSION for none
+    /// \return the packets to send the node
+    QList<QByteArray> pack(const DomainMembershipLog& log, const SharedNodePointer& node, const NodeHash& nodes,
+                           const NodeSet& nodeInterestList, quint32 lastEpoch, quint32 lastVersion);
+
+protected:
+    /// \return the secret the two nodes use to communicate with each other
+    virtual QUuid getConnectionSecret(const SharedNodePointer& node, const SharedNodePointer& otherNode) = 0;
+
+private:
+    QByteArray entryForNode(const SharedNodePointer& node, const SharedNodePointer& otherNode);
+};
+
+#endif /* defined(__hifi__DomainListPacker__) */
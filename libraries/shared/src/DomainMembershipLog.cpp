@@ -0,0 +1,49 @@
+//
+//  DomainMembershipLog.cpp
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QSet>
+
+#include "DomainMembershipLog.h"
+
+DomainMembershipLog::DomainMembershipLog(int maxChanges) :
+    _epoch(QUuid::createUuid().data1),
+    _version(NO_DOMAIN_LIST_VERSION),
+    _maxChanges(maxChanges),
+    _changes()
+{
+    
+}
+
+void DomainMembershipLog::addChange(ChangeType type, const QUuid& nodeUUID) {
+    _changes.enqueue(Change(++_version, type, nodeUUID));
+    
+    while (_changes.size() > _maxChanges) {
+        _changes.dequeue();
+    }
+}
+
+bool DomainMembershipLog::changesSince(quint32 epoch, quint32 version, QList<Change>& changes) const {
+    if (epoch != _epoch || version == NO_DOMAIN_LIST_VERSION || version > _version) {
+        return false;
+    }
+    
+    if (version < _version && (_changes.isEmpty() || _changes.first().version > version + 1)) {
+        // the changes right after this version have already dropped off the end of the log
+        return false;
+    }
+    
+    // walk back from the newest change so that only the latest change for each node is kept
+    QSet<QUuid> changedNodes;
+    for (int i = _changes.size() - 1; i >= 0 && _changes.at(i).version > version; i--) {
+        const Change& change = _changes.at(i);
+        if (!changedNodes.contains(change.nodeUUID)) {
+            changedNodes.insert(change.nodeUUID);
+            changes.prepend(change);
+        }
+    }
+    return true;
+}
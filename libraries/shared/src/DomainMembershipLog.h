@@ -0,0 +1,65 @@
+//
+//  DomainMembershipLog.h
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+//  Versioned record of the nodes joining and leaving a domain
+//
+
+#ifndef __hifi__DomainMembershipLog__
+#define __hifi__DomainMembershipLog__
+
+#include <QtCore/QList>
+#include <QtCore/QQueue>
+#include <QtCore/QUuid>
+
+/// The version a node reports when it has no copy of the domain list yet, and so needs the full list.
+const quint32 NO_DOMAIN_LIST_VERSION = 0;
+
+/// Every node that joins, changes sockets or leaves the domain bumps the log's version. A node that reports the last
+/// version it saw can be sent only the changes since then, as long as the log still reaches back that far. The epoch
+/// tells logs from different domain-server runs apart, so a version from before a restart is never trusted.
+class DomainMembershipLog {
+public:
+    enum ChangeType {
+        NodeAdded = 0, ///< the node joined, or its sockets changed
+        NodeRemoved
+    };
+
+    class Change {
+    public:
+        Change() : version(NO_DOMAIN_LIST_VERSION), type(NodeAdded) { }
+        Change(quint32 version, ChangeType type, const QUuid& nodeUUID) :
+            version(version), type(type), nodeUUID(nodeUUID) { }
+
+        quint32 version;
+        ChangeType type;
+        QUuid nodeUUID;
+    };
+
+    DomainMembershipLog(int maxChanges = DEFAULT_MAX_CHANGES);
+
+    quint32 getEpoch() const { return _epoch; }
+    quint32 getVersion() const { return _version; }
+
+    void nodeAdded(const QUuid& nodeUUID) { addChange(NodeAdded, nodeUUID); }
+    void nodeRemoved(const QUuid& nodeUUID) { addChange(NodeRemoved, nodeUUID); }
+
+    /// Collects the changes made after the given version, with only the latest change kept for each node.
+    /// \return false if the changes can't be given, because the version is from another epoch or the log no longer reaches
+    /// back that far, in which case the full list has to be sent instead
+    bool changesSince(quint32 epoch, quint32 version, QList<Change>& changes) const;
+
+    static const int DEFAULT_MAX_CHANGES = 4096;
+
+private:
+    void addChange(ChangeType type, const QUuid& nodeUUID);
+
+    quint32 _epoch;
+    quint32 _version;
+    int _maxChanges;
+    QQueue<Change> _changes;
+};
+
+#endif /* defined(__hifi__DomainMembershipLog__) */
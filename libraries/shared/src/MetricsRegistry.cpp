@@ -0,0 +1,257 @@
+//
+//  MetricsRegistry.cpp
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+
+#include <string.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+
+#include "MetricsRegistry.h"
+
+// Pending values are kept in plain 32 bit atomics, which every platform we build for has lock free. Rather than let one
+// wrap between scrapes, whoever pushes it past this folds it into the 64 bit total under the registry's lock.
+const quint64 FOLD_PENDING_THRESHOLD = Q_UINT64_C(1) << 28;
+
+Metric::Metric(Type type, const QString& name, const QString& help) :
+    _type(type),
+    _name(name),
+    _help(help)
+{
+}
+
+Metric::~Metric() {
+}
+
+MetricCounter::MetricCounter(const QString& name, const QString& help) :
+    Metric(CounterType, name, help),
+    _pending(0),
+    _total(0)
+{
+}
+
+void MetricCounter::increment(quint64 amount) {
+    if (amount < FOLD_PENDING_THRESHOLD) {
+        quint32 previous = _pending.fetchAndAddRelaxed((int)amount);
+        if (previous + amount < FOLD_PENDING_THRESHOLD) {
+            return;
+        }
+        amount = 0;
+    }
+    foldPending(amount);
+}
+
+void MetricCounter::foldPending(quint64 amount) {
+    QMutexLocker locker(&MetricsRegistry::getInstance()->_mutex);
+    _total += (quint32)_pending.fetchAndStoreRelaxed(0) + amount;
+}
+
+quint64 MetricCounter::collect() {
+    _total += (quint32)_pending.fetchAndStoreRelaxed(0);
+    return _total;
+}
+
+MetricGauge::MetricGauge(const QString& name, const QString& help) :
+    Metric(GaugeType, name, help),
+    _bits(0)
+{
+    set(0.0f);
+}
+
+void MetricGauge::set(float value) {
+    int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    _bits.storeRelease(bits);
+}
+
+float MetricGauge::get() const {
+    int bits = _bits.loadAcquire();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+MetricHistogram::MetricHistogram(const QString& name, const QString& help, const QVector<quint64>& bucketBounds) :
+    Metric(HistogramType, name, help),
+    _bucketBounds(bucketBounds),
+    _pendingBucketCounts(new QAtomicInt[bucketBounds.size() + 1]),
+    _pendingSum(0),
+    _totalBucketCounts(bucketBounds.size() + 1, 0),
+    _totalSum(0)
+{
+}
+
+MetricHistogram::~MetricHistogram() {
+    delete[] _pendingBucketCounts;
+}
+
+QVector<quint64> MetricHistogram::defaultLatencyBucketsUsecs() {
+    static QVector<quint64> buckets = QVector<quint64>() << 100 << 250 << 500 << 1000 << 2500 << 5000 << 10000
+        << 25000 << 50000 << 100000 << 250000 << 500000 << 1000000;
+    return buckets;
+}
+
+void MetricHistogram::observe(quint64 value) {
+    int bucket = 0;
+    while (bucket < _bucketBounds.size() && value > _bucketBounds[bucket]) {
+        bucket++;
+    }
+    _pendingBucketCounts[bucket].fetchAndAddRelaxed(1);
+
+    if (value < FOLD_PENDING_THRESHOLD) {
+        quint32 previous = _pendingSum.fetchAndAddRelaxed((int)value);
+        if (previous + value < FOLD_PENDING_THRESHOLD) {
+            return;
+        }
+        value = 0;
+    }
+    foldPendingSum(value);
+}
+
+void MetricHistogram::foldPendingSum(quint64 value) {
+    QMutexLocker locker(&MetricsRegistry::getInstance()->_mutex);
+    _totalSum += (quint32)_pendingSum.fetchAndStoreRelaxed(0) + value;
+}
+
+void MetricHistogram::collect(QVector<quint64>& bucketCounts, quint64& sum) {
+    for (int i = 0; i < _totalBucketCounts.size(); i++) {
+        _totalBucketCounts[i] += (quint32)_pendingBucketCounts[i].fetchAndStoreRelaxed(0);
+    }
+    _totalSum += (quint32)_pendingSum.fetchAndStoreRelaxed(0);
+    bucketCounts = _totalBucketCounts;
+    sum = _totalSum;
+}
+
+MetricsRegistry* MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return &instance;
+}
+
+MetricsRegistry::MetricsRegistry() {
+}
+
+Metric* MetricsRegistry::registeredMetric(const QString& name, Metric::Type type, bool& isType) {
+    Metric* metric = _metrics.value(name);
+    isType = !metric || metric->getType() == type;
+    if (!isType) {
+        // handing back a metric that isn't exported would leak it and hide the mistake
+        qDebug() << "Metric" << name << "was already registered as a different type.";
+    }
+    return metric;
+}
+
+MetricCounter* MetricsRegistry::counter(const QString& name, const QString& help) {
+    QMutexLocker locker(&_mutex);
+    bool isType;
+    Metric* metric = registeredMetric(name, Metric::CounterType, isType);
+    if (metric) {
+        return isType ? static_cast<MetricCounter*>(metric) : NULL;
+    }
+    MetricCounter* counter = new MetricCounter(name, help);
+    _metrics.insert(name, counter);
+    return counter;
+}
+
+MetricGauge* MetricsRegistry::gauge(const QString& name, const QString& help) {
+    QMutexLocker locker(&_mutex);
+    bool isType;
+    Metric* metric = registeredMetric(name, Metric::GaugeType, isType);
+    if (metric) {
+        return isType ? static_cast<MetricGauge*>(metric) : NULL;
+    }
+    MetricGauge* gauge = new MetricGauge(name, help);
+    _metrics.insert(name, gauge);
+    return gauge;
+}
+
+MetricHistogram* MetricsRegistry::histogram(const QString& name, const QString& help,
+                                            const QVector<quint64>& bucketBounds) {
+    QMutexLocker locker(&_mutex);
+    bool isType;
+    Metric* metric = registeredMetric(name, Metric::HistogramType, isType);
+    if (metric) {
+        return isType ? static_cast<MetricHistogram*>(metric) : NULL;
+    }
+    MetricHistogram* histogram = new MetricHistogram(name, help, bucketBounds);
+    _metrics.insert(name, histogram);
+    return histogram;
+}
+
+QByteArray MetricsRegistry::toPrometheusText() {
+    QMutexLocker locker(&_mutex);
+    QByteArray text;
+    foreach (Metric* metric, _metrics) {
+        QByteArray name = metric->getName().toUtf8();
+        text += "# HELP " + name + " " + metric->getHelp().toUtf8() + "\n";
+
+        switch (metric->getType()) {
+            case Metric::CounterType:
+                text += "# TYPE " + name + " counter\n";
+                text += name + " " + QByteArray::number(static_cast<MetricCounter*>(metric)->collect()) + "\n";
+                break;
+            case Metric::GaugeType:
+                text += "# TYPE " + name + " gauge\n";
+                text += name + " " + QByteArray::number(static_cast<MetricGauge*>(metric)->get()) + "\n";
+                break;
+            case Metric::HistogramType: {
+                MetricHistogram* histogram = static_cast<MetricHistogram*>(metric);
+                QVector<quint64> bucketCounts;
+                quint64 sum;
+                histogram->collect(bucketCounts, sum);
+
+                text += "# TYPE " + name + " histogram\n";
+                quint64 cumulativeCount = 0;
+                for (int i = 0; i < bucketCounts.size(); i++) {
+                    cumulativeCount += bucketCounts[i];
+                    QByteArray bound = (i < histogram->getBucketBounds().size())
+                        ? QByteArray::number(histogram->getBucketBounds()[i]) : QByteArray("+Inf");
+                    text += name + "_bucket{le=\"" + bound + "\"} " + QByteArray::number(cumulativeCount) + "\n";
+                }
+                text += name + "_sum " + QByteArray::number(sum) + "\n";
+                text += name + "_count " + QByteArray::number(cumulativeCount) + "\n";
+                break;
+            }
+        }
+    }
+    return text;
+}
+
+QJsonObject MetricsRegistry::toJSON() {
+    QMutexLocker locker(&_mutex);
+    QJsonObject metricsObject;
+    foreach (Metric* metric, _metrics) {
+        switch (metric->getType()) {
+            case Metric::CounterType:
+                metricsObject[metric->getName()] = (double)static_cast<MetricCounter*>(metric)->collect();
+                break;
+            case Metric::GaugeType:
+                metricsObject[metric->getName()] = static_cast<MetricGauge*>(metric)->get();
+                break;
+            case Metric::HistogramType: {
+                MetricHistogram* histogram = static_cast<MetricHistogram*>(metric);
+                QVector<quint64> bucketCounts;
+                quint64 sum;
+                histogram->collect(bucketCounts, sum);
+
+                QJsonObject bucketsObject;
+                quint64 cumulativeCount = 0;
+                for (int i = 0; i < bucketCounts.size(); i++) {
+                    cumulativeCount += bucketCounts[i];
+                    QString bound = (i < histogram->getBucketBounds().size())
+                        ? QString::number(histogram->getBucketBounds()[i]) : QString("+Inf");
+                    bucketsObject[bound] = (double)cumulativeCount;
+                }
+                QJsonObject histogramObject;
+                histogramObject["buckets"] = bucketsObject;
+                histogramObject["sum"] = (double)sum;
+                histogramObject["count"] = (double)cumulativeCount;
+                metricsObject[metric->getName()] = histogramObject;
+                break;
+            }
+        }
+    }
+    return metricsObject;
+}
@@ -0,0 +1,138 @@
+//
+//  MetricsRegistry.h
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+//  Process wide counters, gauges and latency histograms that can be scraped without locking whoever updates them
+//
+
+#ifndef __hifi__MetricsRegistry__
+#define __hifi__MetricsRegistry__
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+class Metric {
+public:
+    enum Type {
+        CounterType,
+        GaugeType,
+        HistogramType
+    };
+
+    Metric(Type type, const QString& name, const QString& help);
+    virtual ~Metric();
+
+    Type getType() const { return _type; }
+    const QString& getName() const { return _name; }
+    const QString& getHelp() const { return _help; }
+
+private:
+    Type _type;
+    QString _name;
+    QString _help;
+};
+
+/// A total that only goes up, e.g. packets sent. Rates are left to whoever scrapes it.
+class MetricCounter : public Metric {
+public:
+    MetricCounter(const QString& name, const QString& help);
+
+    void increment(quint64 amount = 1);
+
+private:
+    friend class MetricsRegistry;
+    quint64 collect();
+    void foldPending(quint64 amount);
+
+    // increments since the last scrape, as an unsigned 32 bit value; folded into the total early if it grows large
+    QAtomicInt _pending;
+    quint64 _total; // only touched with the registry's lock held
+};
+
+/// A value that is set rather than accumulated, e.g. a queue depth or the mixer's sleep ratio.
+class MetricGauge : public Metric {
+public:
+    MetricGauge(const QString& name, const QString& help);
+
+    void set(float value);
+    float get() const;
+
+private:
+    QAtomicInt _bits; // the float, bit for bit
+};
+
+/// Counts observations into fixed buckets. Each bucket is an upper bound, and a last bucket catches everything above
+/// the highest bound.
+class MetricHistogram : public Metric {
+public:
+    MetricHistogram(const QString& name, const QString& help, const QVector<quint64>& bucketBounds);
+    ~MetricHistogram();
+
+    void observe(quint64 value);
+
+    const QVector<quint64>& getBucketBounds() const { return _bucketBounds; }
+
+    /// 100 usecs up to one second, roughly 1-2.5-5 per decade
+    static QVector<quint64> defaultLatencyBucketsUsecs();
+
+private:
+    friend class MetricsRegistry;
+    void collect(QVector<quint64>& bucketCounts, quint64& sum);
+    void foldPendingSum(quint64 value);
+
+    QVector<quint64> _bucketBounds;
+    QAtomicInt* _pendingBucketCounts; // one per bound, plus the last bucket, as unsigned 32 bit values
+    QAtomicInt _pendingSum; // as an unsigned 32 bit value; folded into the total early if it grows large
+
+    // only touched with the registry's lock held
+    QVector<quint64> _totalBucketCounts;
+    quint64 _totalSum;
+};
+
+/// Holds every metric in the process. Metrics are registered once and live as long as the process does, so callers
+/// keep the pointer they're handed and update it directly. Updates are 32 bit atomic operations, and only take the
+/// registry's own lock in the rare case that a pending value has grown large enough to need folding into its total;
+/// otherwise only registering and scraping take it.
+class MetricsRegistry {
+public:
+    static MetricsRegistry* getInstance();
+
+    /// \return the counter with this name, registering it the first time it's asked for, or NULL if the name is already
+    /// registered as another type
+    MetricCounter* counter(const QString& name, const QString& help);
+
+    /// \return the gauge with this name, registering it the first time it's asked for, or NULL if the name is already
+    /// registered as another type
+    MetricGauge* gauge(const QString& name, const QString& help);
+
+    /// \return the histogram with this name, registering it the first time it's asked for, or NULL if the name is already
+    /// registered as another type. The bounds are only used the first time.
+    MetricHistogram* histogram(const QString& name, const QString& help,
+                               const QVector<quint64>& bucketBounds = MetricHistogram::defaultLatencyBucketsUsecs());
+
+    /// \return every metric in the Prometheus text exposition format
+    QByteArray toPrometheusText();
+
+    /// \return every metric keyed by name, histograms as an object of cumulative bucket counts plus their sum and count
+    QJsonObject toJSON();
+
+private:
+    friend class MetricCounter;
+    friend class MetricHistogram;
+
+    MetricsRegistry();
+    /// \return the metric registered with this name, if any, and whether it is of this type
+    Metric* registeredMetric(const QString& name, Metric::Type type, bool& isType);
+
+    QMutex _mutex;
+    QMap<QString, Metric*> _metrics;
+};
+
+#endif /* defined(__hifi__MetricsRegistry__) */
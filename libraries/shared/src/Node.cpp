@@ -57,6 +57,10 @@ Node::Node(const QUuid& uuid, char type, const HifiSockAddr& publicSocket, const
     _bytesReceivedMovingAverage(NULL),
     _linkedData(NULL),
     _isAlive(true),
+    _pingMs(0),
+    _pingsSent(0),
+    _pingRepliesReceived(0),
+    _pingLossRate(0.0f),
     _clockSkewUsec(0),
     _mutex()
 {
@@ -117,6 +121,20 @@ void Node::recordBytesReceived(int bytesReceived) {
     _bytesReceivedMovingAverage->updateAverage((float) bytesReceived);
 }
 
+void Node::recordPingSent() {
+    const int PINGS_PER_LOSS_SAMPLE = 5;
+    const float LOSS_RATE_SMOOTHING = 0.5f;
+
+    // pings go out about once a second, so by the time the next one goes the replies to the last ones should be in
+    if (_pingsSent == PINGS_PER_LOSS_SAMPLE) {
+        float lossRate = (float)qMax(_pingsSent - _pingRepliesReceived, 0) / _pingsSent;
+        _pingLossRate += (lossRate - _pingLossRate) * LOSS_RATE_SMOOTHING;
+        _pingsSent = 0;
+        _pingRepliesReceived = 0;
+    }
+    _pingsSent++;
+}
+
 float Node::getAveragePacketsPerSecond() {
     if (_bytesReceivedMovingAverage) {
         return (1 / _bytesReceivedMovingAverage->getEventDeltaAverage());
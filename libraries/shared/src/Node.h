@@ -95,6 +95,15 @@ public:
     int getPingMs() const { return _pingMs; }
     void setPingMs(int pingMs) { _pingMs = pingMs; }
 
+    /// Counts a ping sent to this node, for estimating the loss on the link to it.
+    void recordPingSent();
+
+    /// Counts a reply to one of the pings counted by recordPingSent.
+    void recordPingReply() { _pingRepliesReceived++; }
+
+    /// \return the smoothed fraction of recent pings that went unanswered
+    float getPingLossRate() const { return _pingLossRate; }
+
     int getClockSkewUsec() const { return _clockSkewUsec; }
     void setClockSkewUsec(int clockSkew) { _clockSkewUsec = clockSkew; }
     QMutex& getMutex() { return _mutex; }
@@ -120,6 +129,9 @@ private:
     NodeData* _linkedData;
     bool _isAlive;
     int _pingMs;
+    int _pingsSent;
+    int _pingRepliesReceived;
+    float _pingLossRate;
     int _clockSkewUsec;
     QMutex _mutex;
 };
@@ -20,6 +20,7 @@
 #include "Assignment.h"
 #include "HifiSockAddr.h"
 #include "Logging.h"
+#include "MetricsRegistry.h"
 #include "NodeList.h"
 #include "PacketHeaders.h"
 #include "SharedUtil.h"
@@ -66,13 +67,24 @@ NodeList::NodeList(char newOwnerType, unsigned short int newSocketListenPort) :
     _nodeTypesOfInterest(),
     _sessionUUID(),
     _numNoReplyDomainCheckIns(0),
+    _domainListEpoch(0),
+    _domainListVersion(NO_DOMAIN_LIST_VERSION),
+    _pendingDomainListVersion(NO_DOMAIN_LIST_VERSION),
+    _pendingDomainListPackets(),
     _assignmentServerSocket(),
     _publicSockAddr(),
     _hasCompletedInitialSTUNFailure(false),
     _stunRequestsSinceSuccess(0),
     _numCollectedPackets(0),
     _numCollectedBytes(0),
-    _packetStatTimer()
+    _packetStatTimer(),
+    _packetsSentMetric(MetricsRegistry::getInstance()->counter("hifi_packets_sent_total", "Packets sent")),
+    _bytesSentMetric(MetricsRegistry::getInstance()->counter("hifi_bytes_sent_total", "Bytes sent")),
+    _packetsReceivedMetric(MetricsRegistry::getInstance()->counter("hifi_packets_received_total",
+                                                                   "Packets received, before version and hash checks")),
+    _bytesReceivedMetric(MetricsRegistry::getInstance()->counter("hifi_bytes_received_total",
+                                                                 "Bytes received, before version and hash checks")),
+    _nodeCountMetric(MetricsRegistry::getInstance()->gauge("hifi_nodes", "Nodes in the node list"))
 {
     _nodeSocket.bind(QHostAddress::AnyIPv4, newSocketListenPort);
     qDebug() << "NodeList socket is listening on" << _nodeSocket.localPort();
@@ -111,6 +123,9 @@ void NodeList::changeSendSocketBufferSize(int numSendBytes) {
 }
 
 bool NodeList::packetVersionAndHashMatch(const QByteArray& packet) {
+    _packetsReceivedMetric->increment();
+    _bytesReceivedMetric->increment(packet.size());
+    
     PacketType checkType = packetTypeForPacket(packet);
     if (packet[1] != versionForPacketType(checkType)
         && checkType != PacketTypeStunResponse) {
@@ -194,6 +209,8 @@ qint64 NodeList::writeDatagram(const QByteArray& datagram, const HifiSockAddr& d
     // stat collection for packets
     ++_numCollectedPackets;
     _numCollectedBytes += datagram.size();
+    _packetsSentMetric->increment();
+    _bytesSentMetric->increment(datagram.size());
     
     qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy, destinationSockAddr.getAddress(), destinationSockAddr.getPort());
     
@@ -219,7 +236,7 @@ qint64 NodeList::writeDatagram(const QByteArray& datagram, const SharedNodePoint
             }
         }
         
-        writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret());
+        return writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret());
     }
     
     // didn't have a destinationNode to send to, return 0
@@ -260,6 +277,11 @@ void NodeList::timePingReply(const QByteArray& packet, const SharedNodePointer&
     
     sendingNode->setPingMs(pingTime / 1000);
     sendingNode->setClockSkewUsec(clockSkew);
+
+    // only the broadcast pings are counted as sent, not the ones punching through to inactive nodes
+    if (pingType == PingType::Agnostic) {
+        sendingNode->recordPingReply();
+    }
     
     const bool wantDebug = false;
     
@@ -409,6 +431,7 @@ void NodeList::eraseAllNodes() {
 void NodeList::reset() {
     eraseAllNodes();
     _numNoReplyDomainCheckIns = 0;
+    resetDomainListVersion();
 
     // refresh the owner UUID to the NULL UUID
     setSessionUUID(QUuid());
@@ -419,10 +442,25 @@ void NodeList::reset() {
 
 void NodeList::addNodeTypeToInterestSet(NodeType_t nodeTypeToAdd) {
     _nodeTypesOfInterest << nodeTypeToAdd;
+    
+    // the changes we've been sent so far only covered our old interests, ask for the full list again
+    resetDomainListVersion();
 }
 
 void NodeList::addSetOfNodeTypesToNodeInterestSet(const NodeSet& setOfNodeTypes) {
     _nodeTypesOfInterest.unite(setOfNodeTypes);
+    resetDomainListVersion();
+}
+
+void NodeList::resetNodeInterestSet() {
+    _nodeTypesOfInterest.clear();
+    resetDomainListVersion();
+}
+
+void NodeList::resetDomainListVersion() {
+    _domainListVersion = NO_DOMAIN_LIST_VERSION;
+    _pendingDomainListVersion = NO_DOMAIN_LIST_VERSION;
+    _pendingDomainListPackets.clear();
 }
 
 const uint32_t RFC_5389_MAGIC_COOKIE = 0x2112A442;
@@ -573,7 +611,9 @@ void NodeList::killNodeWithUUID(const QUuid& nodeUUID) {
 NodeHash::iterator NodeList::killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill) {
     qDebug() << "Killed" << *nodeItemToKill.value();
     emit nodeKilled(nodeItemToKill.value());
-    return _nodeHash.erase(nodeItemToKill);
+    NodeHash::iterator nextItem = _nodeHash.erase(nodeItemToKill);
+    _nodeCountMetric->set(_nodeHash.size());
+    return nextItem;
 }
 
 void NodeList::processKillNode(const QByteArray& dataByteArray) {
@@ -623,6 +663,11 @@ void NodeList::sendDomainServerCheckIn() {
                 packetStream << nodeTypeOfInterest;
             }
             
+            if (domainPacketType == PacketTypeDomainListRequest) {
+                // tell the domain-server which version of the list we have, so it only has to send what changed since
+                packetStream << _domainListEpoch << _domainListVersion;
+            }
+            
             writeDatagram(domainServerPacket, _domainInfo.getSockAddr(), _domainInfo.getConnectionSecret());
             const int NUM_DOMAIN_SERVER_CHECKINS_PER_STUN_REQUEST = 5;
             static unsigned int numDomainCheckins = 0;
@@ -684,8 +729,22 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     packetStream >> newUUID;
     setSessionUUID(newUUID);
     
-    // pull each node in the packet
+    // then the version of the domain list this brings us up to, and which of the packets for it this is
+    quint32 epoch, version;
+    quint8 isFullList, packetIndex, numPackets;
+    packetStream >> epoch >> version >> isFullList >> packetIndex >> numPackets;
+    
+    // pull each node change in the packet
+    quint8 changeType;
     while(packetStream.device()->pos() < packet.size()) {
+        packetStream >> changeType;
+        
+        if (changeType == DomainMembershipLog::NodeRemoved) {
+            packetStream >> nodeUUID;
+            killNodeWithUUID(nodeUUID);
+            continue;
+        }
+        
         packetStream >> nodeType >> nodeUUID >> nodePublicSocket >> nodeLocalSocket;
 
         // if the public socket address is 0 then it's reachable at the same IP
@@ -700,6 +759,17 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
         node->setConnectionSecret(connectionUUID);
     }
     
+    // only move up to the new version once we have every packet for it, otherwise we'll be sent the changes again
+    if (epoch != _domainListEpoch || version != _pendingDomainListVersion) {
+        _pendingDomainListVersion = version;
+        _pendingDomainListPackets.clear();
+    }
+    _domainListEpoch = epoch;
+    _pendingDomainListPackets.insert(packetIndex);
+    if (_pendingDomainListPackets.size() >= numPackets) {
+        _domainListVersion = version;
+    }
+    
     // ping inactive nodes in conjunction with receipt of list from domain-server
     // this makes it happen every second and also pings any newly added nodes
     pingInactiveNodes();
@@ -817,6 +887,7 @@ SharedNodePointer NodeList::addOrUpdateNode(const QUuid& uuid, char nodeType,
         SharedNodePointer newNodeSharedPointer(newNode, &QObject::deleteLater);
         
         _nodeHash.insert(newNode->getUUID(), newNodeSharedPointer);
+        _nodeCountMetric->set(_nodeHash.size());
         
         _nodeHashMutex.unlock();
         
@@ -858,11 +929,16 @@ SharedNodePointer NodeList::updateSocketsForNode(const QUuid& uuid,
 
 unsigned NodeList::broadcastToNodes(const QByteArray& packet, const NodeSet& destinationNodeTypes) {
     unsigned n = 0;
+    bool isPing = packetTypeForPacket(packet) == PacketTypePing;
 
     foreach (const SharedNodePointer& node, getNodeHash()) {
         // only send to the NodeTypes we are asked to send to.
         if (destinationNodeTypes.contains(node->getType())) {
             writeDatagram(packet, node);
+            if (isPing) {
+                // the regular pings are what we measure the loss on each link with
+                node->recordPingSent();
+            }
             ++n;
         }
     }
@@ -935,6 +1011,9 @@ void NodeList::removeSilentNodes() {
         if ((usecTimestampNow() - node->getLastHeardMicrostamp()) > NODE_SILENCE_THRESHOLD_USECS) {
             // call our private method to kill this node (removes it and emits the right signal)
             nodeItem = killNodeAtHashIterator(nodeItem);
+            
+            // the domain-server won't tell us about this node again unless it changes, so ask for the full list
+            _domainListVersion = NO_DOMAIN_LIST_VERSION;
         } else {
             // we didn't kill this node, push the iterator forwards
             ++nodeItem;
@@ -30,8 +30,12 @@
 #include <QtNetwork/QUdpSocket>
 
 #include "DomainInfo.h"
+#include "DomainMembershipLog.h"
 #include "Node.h"
 
+class MetricCounter;
+class MetricGauge;
+
 const quint64 NODE_SILENCE_THRESHOLD_USECS = 2 * 1000 * 1000;
 const quint64 DOMAIN_SERVER_CHECK_IN_USECS = 1 * 1000000;
 const quint64 PING_INACTIVE_NODE_INTERVAL_USECS = 1 * 1000 * 1000;
@@ -93,9 +97,12 @@ public:
     const NodeSet& getNodeInterestSet() const { return _nodeTypesOfInterest; }
     void addNodeTypeToInterestSet(NodeType_t nodeTypeToAdd);
     void addSetOfNodeTypesToNodeInterestSet(const NodeSet& setOfNodeTypes);
-    void resetNodeInterestSet() { _nodeTypesOfInterest.clear(); }
+    void resetNodeInterestSet();
 
     int processDomainServerList(const QByteArray& packet);
+    
+    /// \return the version of the domain list we have all of, or NO_DOMAIN_LIST_VERSION if we need the full list
+    quint32 getDomainListVersion() const { return _domainListVersion; }
 
     void setAssignmentServerSocket(const HifiSockAddr& serverSocket) { _assignmentServerSocket = serverSocket; }
     void sendAssignment(Assignment& assignment);
@@ -162,6 +169,8 @@ private:
     void timePingReply(const QByteArray& packet, const SharedNodePointer& sendingNode);
     
     void changeSendSocketBufferSize(int numSendBytes);
+    
+    void resetDomainListVersion();
 
     NodeHash _nodeHash;
     QMutex _nodeHashMutex;
@@ -171,6 +180,10 @@ private:
     DomainInfo _domainInfo;
     QUuid _sessionUUID;
     int _numNoReplyDomainCheckIns;
+    quint32 _domainListEpoch;
+    quint32 _domainListVersion;
+    quint32 _pendingDomainListVersion;
+    QSet<int> _pendingDomainListPackets;
     HifiSockAddr _assignmentServerSocket;
     HifiSockAddr _publicSockAddr;
     bool _hasCompletedInitialSTUNFailure;
@@ -178,6 +191,12 @@ private:
     int _numCollectedPackets;
     int _numCollectedBytes;
     QElapsedTimer _packetStatTimer;
+
+    MetricCounter* _packetsSentMetric;
+    MetricCounter* _bytesSentMetric;
+    MetricCounter* _packetsReceivedMetric;
+    MetricCounter* _bytesReceivedMetric;
+    MetricGauge* _nodeCountMetric;
 };
 
 #endif /* defined(__hifi__NodeList__) */
@@ -301,13 +301,14 @@ bool isAncestorOf(const unsigned char* possibleAncestor, const unsigned char* po
     }
 
     int descendentCodeLength = numberOfThreeBitSectionsInCode(possibleDescendent);
+    int descendentCodeLengthWithChild = descendentCodeLength;
     
     // if the caller also include a child, then our descendent length is actually one extra!
     if (descendentsChild != CHECK_NODE_ONLY) {
-        descendentCodeLength++;
+        descendentCodeLengthWithChild++;
     }
     
-    if (ancestorCodeLength > descendentCodeLength) {
+    if (ancestorCodeLength > descendentCodeLengthWithChild) {
         return false; // if the descendent is shorter, it can't be a descendent
     }
 
@@ -315,7 +316,7 @@ bool isAncestorOf(const unsigned char* possibleAncestor, const unsigned char* po
     for (int section = 0; section < ancestorCodeLength; section++) {
         char sectionValueAncestor = getOctalCodeSectionValue(possibleAncestor, section);
         char sectionValueDescendent;
-        if (ancestorCodeLength <= descendentCodeLength) {
+        if (section < descendentCodeLength) {
             sectionValueDescendent = getOctalCodeSectionValue(possibleDescendent, section);
         } else {
             assert(descendentsChild != CHECK_NODE_ONLY);
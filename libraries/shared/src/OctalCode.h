@@ -32,6 +32,9 @@ const int UNKNOWN_OCTCODE_LENGTH = -2;
 /// \param int maxBytes number of bytes that octalCode is expected to be, -1 if unknown
 int numberOfThreeBitSectionsInCode(const unsigned char* octalCode, int maxBytes = UNKNOWN_OCTCODE_LENGTH);
 
+/// \return the three bit value (0-7) of the given section of the code, section must be less than the code's length
+char getOctalCodeSectionValue(const unsigned char* octalCode, int section);
+
 unsigned char* chopOctalCode(const unsigned char* originalOctalCode, int chopLevels);
 unsigned char* rebaseOctalCode(const unsigned char* originalOctalCode, const unsigned char* newParentOctalCode, 
                                bool includeColorSpace = false);
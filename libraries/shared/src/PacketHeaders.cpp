@@ -45,14 +45,16 @@ int packArithmeticallyCodedValue(int value, char* destination) {
 PacketVersion versionForPacketType(PacketType type) {
     switch (type) {
         case PacketTypeAvatarData:
-            return 3;
+            return 5;
+        case PacketTypeBulkAvatarData:
+            return 2;
         case PacketTypeEnvironmentData:
             return 1;
         case PacketTypeParticleData:
             return 1;
         case PacketTypeDomainList:
         case PacketTypeDomainListRequest:
-            return 1;
+            return 2;
         case PacketTypeCreateAssignment:
         case PacketTypeRequestAssignment:
             return 1;
@@ -64,6 +66,9 @@ PacketVersion versionForPacketType(PacketType type) {
         case PacketTypeVoxelSet:
         case PacketTypeVoxelSetDestructive:
             return 1;
+        case PacketTypeVoxelQuery:
+        case PacketTypeParticleQuery:
+            return 1;
         default:
             return 0;
     }
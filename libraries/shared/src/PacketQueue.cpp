@@ -0,0 +1,111 @@
+//
+//  PacketQueue.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cstring>
+
+#include <QtCore/QMutexLocker>
+#include <QtDebug>
+
+#include "PacketQueue.h"
+#include "SharedUtil.h"
+
+PacketQueue::PacketQueue(int capacity) :
+    _head(0),
+    _tail(0),
+    _overflowSize(0),
+    _overflowCount(0) {
+
+    int size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _slots = new Slot[size];
+    for (int i = 0; i < size; i++) {
+        _slots[i].sequence.store(i);
+    }
+    _mask = size - 1;
+}
+
+PacketQueue::~PacketQueue() {
+    delete[] _slots;
+}
+
+void PacketQueue::push(const SharedNodePointer& node, const QByteArray& packet) {
+    if (packet.size() == 0 || packet.size() > MAX_PACKET_SIZE) {
+        qDebug(">>> PacketQueue::push() unexpected length = %d", packet.size());
+        return;
+    }
+    // once packets have overflowed, later ones follow them until the consumer has caught up, so that each thread's
+    // packets stay in order
+    if (_overflowSize.loadAcquire() == 0 && pushToRing(node, packet)) {
+        return;
+    }
+    // a deep copy, as into a slot: the caller's buffer may not be its own (see QByteArray::fromRawData) or may be reused
+    QByteArray copy(packet.constData(), packet.size());
+    _overflowMutex.lock();
+    _overflow.push_back(NetworkPacket(node, copy));
+    _overflowSize.fetchAndAddRelease(1);
+    _overflowMutex.unlock();
+    _overflowCount.fetchAndAddRelaxed(1);
+}
+
+bool PacketQueue::peekNode(SharedNodePointer& node) {
+    unsigned int position = _head.load();
+    Slot& slot = _slots[position & _mask];
+    if ((unsigned int)slot.sequence.loadAcquire() == position + 1) {
+        node = slot.node;
+        return true;
+    }
+    // as in drain(), overflowed packets only come up once the ring has been drained right up to its tail
+    if (_overflowSize.loadAcquire() > 0 && position == (unsigned int)_tail.loadAcquire()) {
+        QMutexLocker locker(&_overflowMutex);
+        if (!_overflow.empty()) {
+            node = _overflow.front().getDestinationNode();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PacketQueue::pushToRing(const SharedNodePointer& node, const QByteArray& packet) {
+    unsigned int position = _tail.load();
+    Slot* slot;
+    forever {
+        slot = &_slots[position & _mask];
+        int difference = (int)((unsigned int)slot->sequence.loadAcquire() - position);
+        if (difference == 0) {
+            // the slot's free for this position; claim it, unless another producer beat us to it
+            if (_tail.testAndSetRelaxed(position, position + 1)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // the slot still holds the packet from a lap ago
+            return false;
+        }
+        position = _tail.load();
+    }
+
+    slot->node = node;
+    if (slot->packet.capacity() < packet.size()) {
+        // the first use of the slot; from now on its buffer is reused rather than reallocated
+        slot->packet.reserve(MAX_PACKET_SIZE);
+    }
+    slot->packet.resize(packet.size());
+    memcpy(slot->packet.data(), packet.constData(), packet.size());
+
+    slot->sequence.storeRelease(position + 1);
+    return true;
+}
+
+void PacketQueue::takeOverflow(int maxCount) {
+    _overflowMutex.lock();
+    int count = qMin(maxCount, (int)_overflow.size());
+    _overflowBatch.insert(_overflowBatch.end(), _overflow.begin(), _overflow.begin() + count);
+    _overflow.erase(_overflow.begin(), _overflow.begin() + count);
+    _overflowSize.fetchAndAddRelease(-count);
+    _overflowMutex.unlock();
+}
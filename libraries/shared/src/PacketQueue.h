@@ -0,0 +1,120 @@
+//
+//  PacketQueue.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Bounded ring of reusable packet buffers filled by any number of threads and drained by one, without locking
+//
+
+#ifndef __hifi__PacketQueue__
+#define __hifi__PacketQueue__
+
+#include <climits>
+#include <deque>
+#include <vector>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+
+#include "NetworkPacket.h"
+#include "NodeList.h"
+
+const int DEFAULT_PACKET_QUEUE_CAPACITY = 1024;
+
+/// The queue between the threads that produce packets and the one thread that sends or processes them. Producers claim a
+/// slot of the ring with a compare and swap and copy their packet into its buffer, which is allocated on the slot's first
+/// use and reused from then on; the consumer drains ready slots in order and hands each buffer to its handler in place.
+/// Nothing is dropped when the ring is full: packets go to an overflow list under a lock until the consumer catches up,
+/// and every packet that had to is counted, so that a producer running ahead of its consumer shows up in the stats.
+class PacketQueue {
+public:
+    /// \param capacity the number of slots, rounded up to a power of two
+    PacketQueue(int capacity = DEFAULT_PACKET_QUEUE_CAPACITY);
+    ~PacketQueue();
+
+    /// Copies a packet onto the back of the queue. Packets from one thread are drained in the order that thread pushed them.
+    /// \thread any
+    void push(const SharedNodePointer& node, const QByteArray& packet);
+
+    /// Hands the oldest packets, up to maxCount of them, to handler.handlePacket(const SharedNodePointer&,
+    /// const QByteArray&) and frees their slots. The packet is only valid for the duration of the call.
+    /// \return the number of packets handled
+    /// \thread the consumer
+    template<class Handler> int drain(Handler& handler, int maxCount = INT_MAX);
+
+    /// Looks at where the oldest packet is going, without taking it, so the consumer can decide whether to drain it.
+    /// \return false if there's no packet ready
+    /// \thread the consumer
+    bool peekNode(SharedNodePointer& node);
+
+    /// \return the number of packets waiting, which may be stale by the time it's used
+    int size() const { return (int)((unsigned int)_tail.load() - (unsigned int)_head.load()) + _overflowSize.load(); }
+
+    bool isEmpty() const { return size() == 0; }
+
+    int getCapacity() const { return _mask + 1; }
+
+    /// \return the number of packets that found the ring full and waited in the overflow list
+    int getOverflowCount() const { return _overflowCount.load(); }
+
+private:
+    PacketQueue(const PacketQueue& other);
+    PacketQueue& operator=(const PacketQueue& other);
+
+    class Slot {
+    public:
+        QAtomicInt sequence; // the position the slot is ready to be pushed at, or one past the position it was pushed at
+        SharedNodePointer node;
+        QByteArray packet;
+    };
+
+    bool pushToRing(const SharedNodePointer& node, const QByteArray& packet);
+
+    /// Moves up to maxCount of the oldest overflowed packets into _overflowBatch.
+    void takeOverflow(int maxCount);
+
+    Slot* _slots;
+    int _mask;
+    QAtomicInt _head; // the next position to drain, only ever written by the consumer
+    QAtomicInt _tail; // the next position to claim
+
+    QMutex _overflowMutex;
+    std::deque<NetworkPacket> _overflow;
+    QAtomicInt _overflowSize;
+    QAtomicInt _overflowCount;
+    std::vector<NetworkPacket> _overflowBatch; // the consumer's, reused from one drain to the next
+};
+
+template<class Handler> inline int PacketQueue::drain(Handler& handler, int maxCount) {
+    int count = 0;
+    unsigned int position = _head.load();
+    while (count < maxCount) {
+        Slot& slot = _slots[position & _mask];
+        if ((unsigned int)slot.sequence.loadAcquire() != position + 1) {
+            break;
+        }
+        handler.handlePacket(slot.node, slot.packet);
+        slot.node.clear();
+
+        // ready the slot for the push one lap of the ring from now
+        slot.sequence.storeRelease(position + _mask + 1);
+        position++;
+        count++;
+    }
+    _head.storeRelease(position);
+
+    // overflowed packets are newer than everything in the ring, including slots claimed but not yet filled, so they wait
+    // until the ring's drained right up to its tail
+    if (count < maxCount && _overflowSize.loadAcquire() > 0 && position == (unsigned int)_tail.loadAcquire()) {
+        takeOverflow(maxCount - count);
+        for (size_t i = 0; i < _overflowBatch.size(); i++) {
+            handler.handlePacket(_overflowBatch[i].getDestinationNode(), _overflowBatch[i].getByteArray());
+        }
+        count += (int)_overflowBatch.size();
+        _overflowBatch.clear();
+    }
+    return count;
+}
+
+#endif /* defined(__hifi__PacketQueue__) */
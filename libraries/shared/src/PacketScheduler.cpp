@@ -0,0 +1,258 @@
+//
+//  PacketScheduler.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cstring>
+#include <limits>
+
+#include "PacketScheduler.h"
+#include "SharedUtil.h"
+
+const float MINIMUM_DESTINATION_PACKETS_PER_SECOND = 1.0f;
+
+// the regular pings come once a second, so there's nothing new to adapt to any sooner
+const quint64 ADAPT_INTERVAL_USECS = USECS_PER_SECOND;
+
+// a link is congested once its pings start going missing, or take this much longer than the quietest ever did
+const float CONGESTED_LOSS_RATE = 0.05f;
+const float CONGESTED_PING_RATIO = 2.0f;
+const int CONGESTED_PING_SLACK_MSECS = 20;
+
+// the rate is halved on congestion and grows back by a tenth of the overall rate each second without it
+const float RATE_DECREASE = 0.5f;
+const float RATE_INCREASE = 0.1f;
+
+// a destination with nothing to send for this many intervals is forgotten, along with what we learned of its link
+const int FORGET_IDLE_INTERVALS = 10;
+
+// a packet the socket refuses is retried after a moment, for as long as it takes; edits must not be lost
+const quint64 SOCKET_RETRY_USECS = USECS_PER_MSEC;
+
+PacketScheduler::PacketScheduler(int packetsPerSecond) :
+    _packetsPerSecond(packetsPerSecond),
+    _burstUsecs(0),
+    _virtualTime(0.0),
+    _tokens(1.0f),
+    _hasRefilled(false),
+    _lastRefill(0),
+    _lastAdapt(0),
+    _retryAfter(0),
+    _queuedPacketCount(0),
+    _isWaitingForRoom(false) {
+}
+
+void PacketScheduler::setWeight(const QUuid& uuid, float weight) {
+    QMutexLocker locker(&_ratesMutex);
+    _weights.insert(uuid, weight);
+}
+
+bool PacketScheduler::hasRoomFor(const SharedNodePointer& node, quint64 now) {
+    refill(now);
+    Destination& destination = getDestination(node ? node->getUUID() : QUuid());
+    _isWaitingForRoom = (int)destination.packets.size() >= (int)destination.tokens ||
+        _queuedPacketCount.load() >= (int)_tokens;
+    _waitingUuid = destination.uuid;
+    return !_isWaitingForRoom;
+}
+
+void PacketScheduler::queuePacket(const SharedNodePointer& node, const QByteArray& packet) {
+    Destination& destination = getDestination(node ? node->getUUID() : QUuid());
+    destination.node = node;
+
+    // a copy of our own, since the caller's buffer is likely to be reused as soon as we return
+    QueuedPacket queued;
+    if (_freeBuffers.empty()) {
+        queued.packet.reserve(MAX_PACKET_SIZE);
+    } else {
+        queued.packet = _freeBuffers.back();
+        _freeBuffers.pop_back();
+    }
+    queued.packet.resize(packet.size());
+    memcpy(queued.packet.data(), packet.constData(), packet.size());
+
+    // the packet finishes where the destination's last one did, or now if it has caught up, plus its share of a send
+    queued.startTag = qMax(_virtualTime, destination.lastFinishTag);
+    queued.finishTag = queued.startTag + 1.0 / destination.weight;
+    destination.lastFinishTag = queued.finishTag;
+    destination.packets.push_back(queued);
+    _queuedPacketCount.fetchAndAddRelaxed(1);
+}
+
+static qint64 getUsecsUntilToken(float tokens, float packetsPerSecond) {
+    return (tokens >= 1.0f) ? 0 : (qint64)((1.0f - tokens) * USECS_PER_SECOND / packetsPerSecond);
+}
+
+qint64 PacketScheduler::getUsecsUntilNextSend(quint64 now) const {
+    if (_queuedPacketCount.load() == 0 && !_isWaitingForRoom) {
+        return -1;
+    }
+    float overallRate = qMax((float)_packetsPerSecond, MINIMUM_DESTINATION_PACKETS_PER_SECOND);
+    qint64 destinationUsecs = std::numeric_limits<qint64>::max();
+    foreach (const Destination& destination, _destinations) {
+        if (!destination.packets.empty() || (_isWaitingForRoom && destination.uuid == _waitingUuid)) {
+            destinationUsecs = qMin(destinationUsecs, getUsecsUntilToken(destination.tokens,
+                qMin(destination.packetsPerSecond, overallRate)));
+        }
+    }
+    if (destinationUsecs == std::numeric_limits<qint64>::max()) {
+        destinationUsecs = 0; // the destination we were waiting on has been forgotten, so it starts with a full bucket
+    }
+    qint64 usecs = qMax(getUsecsUntilToken(_tokens, overallRate), destinationUsecs);
+
+    // the tokens are as of the last refill
+    if (_hasRefilled && now > _lastRefill) {
+        usecs -= (qint64)(now - _lastRefill);
+    }
+    if (_retryAfter > now) {
+        usecs = qMax(usecs, (qint64)(_retryAfter - now));
+    }
+    return qMax(usecs, (qint64)0);
+}
+
+QVector<DestinationRate> PacketScheduler::getDestinationRates() const {
+    QMutexLocker locker(&_ratesMutex);
+    return _rates;
+}
+
+PacketScheduler::Destination& PacketScheduler::getDestination(const QUuid& uuid) {
+    for (int i = 0; i < _destinations.size(); i++) {
+        if (_destinations.at(i).uuid == uuid) {
+            return _destinations[i];
+        }
+    }
+    Destination destination;
+    destination.uuid = uuid;
+    _ratesMutex.lock();
+    destination.weight = _weights.value(uuid, 1.0f);
+    _ratesMutex.unlock();
+    destination.lastFinishTag = _virtualTime;
+    destination.tokens = 1.0f;
+    destination.packetsPerSecond = qMax((float)_packetsPerSecond, MINIMUM_DESTINATION_PACKETS_PER_SECOND);
+    destination.minPingMs = 0;
+    destination.lastLossRate = 0.0f;
+    destination.sentThisInterval = 0;
+    destination.sentPacketsPerSecond = 0.0f;
+    destination.idleIntervals = 0;
+    _destinations.append(destination);
+    return _destinations.last();
+}
+
+float PacketScheduler::getBurstTokens(float packetsPerSecond) const {
+    return qMax(1.0f, packetsPerSecond * _burstUsecs / USECS_PER_SECOND);
+}
+
+void PacketScheduler::refill(quint64 now) {
+    if (!_hasRefilled) {
+        _hasRefilled = true;
+        _lastRefill = _lastAdapt = now;
+        return;
+    }
+    if (now <= _lastRefill) {
+        return;
+    }
+    float seconds = (float)(now - _lastRefill) / USECS_PER_SECOND;
+    _lastRefill = now;
+
+    float overallRate = qMax((float)_packetsPerSecond, MINIMUM_DESTINATION_PACKETS_PER_SECOND);
+    _tokens = qMin(_tokens + overallRate * seconds, getBurstTokens(overallRate));
+    for (int i = 0; i < _destinations.size(); i++) {
+        Destination& destination = _destinations[i];
+        float packetsPerSecond = qMin(destination.packetsPerSecond, overallRate);
+        destination.tokens = qMin(destination.tokens + packetsPerSecond * seconds, getBurstTokens(packetsPerSecond));
+    }
+
+    if (now - _lastAdapt >= ADAPT_INTERVAL_USECS) {
+        adaptRates(now);
+    }
+}
+
+void PacketScheduler::adaptRates(quint64 now) {
+    float seconds = (float)(now - _lastAdapt) / USECS_PER_SECOND;
+    _lastAdapt = now;
+    float overallRate = qMax((float)_packetsPerSecond, MINIMUM_DESTINATION_PACKETS_PER_SECOND);
+
+    QMutexLocker locker(&_ratesMutex);
+    _rates.clear();
+    for (int i = 0; i < _destinations.size(); i++) {
+        Destination& destination = _destinations[i];
+        if (destination.packets.empty() && destination.sentThisInterval == 0) {
+            if (++destination.idleIntervals > FORGET_IDLE_INTERVALS) {
+                _destinations.remove(i--);
+                continue;
+            }
+        } else {
+            destination.idleIntervals = 0;
+        }
+        destination.sentPacketsPerSecond = destination.sentThisInterval / seconds;
+        destination.sentThisInterval = 0;
+        destination.weight = _weights.value(destination.uuid, 1.0f);
+
+        if (destination.node) {
+            int pingMs = destination.node->getPingMs();
+            if (pingMs > 0 && (destination.minPingMs == 0 || pingMs < destination.minPingMs)) {
+                destination.minPingMs = pingMs;
+            }
+            float lossRate = destination.node->getPingLossRate();
+            bool pingSwollen = destination.minPingMs > 0 &&
+                pingMs > destination.minPingMs * CONGESTED_PING_RATIO + CONGESTED_PING_SLACK_MSECS;
+
+            // back off when a fresh loss sample comes in or queues are building; hold while the loss lingers
+            if (lossRate > destination.lastLossRate || pingSwollen) {
+                destination.packetsPerSecond = qMax(destination.packetsPerSecond * RATE_DECREASE,
+                    MINIMUM_DESTINATION_PACKETS_PER_SECOND);
+
+            } else if (lossRate <= CONGESTED_LOSS_RATE) {
+                destination.packetsPerSecond += overallRate * RATE_INCREASE;
+            }
+            destination.lastLossRate = lossRate;
+        }
+        destination.packetsPerSecond = qMin(destination.packetsPerSecond, overallRate);
+
+        DestinationRate rate;
+        rate.uuid = destination.uuid;
+        rate.nodeType = destination.node ? destination.node->getType() : NodeType::Unassigned;
+        rate.packetsPerSecond = destination.sentPacketsPerSecond;
+        rate.targetPacketsPerSecond = destination.packetsPerSecond;
+        rate.queuedPackets = destination.packets.size();
+        _rates.append(rate);
+    }
+}
+
+PacketScheduler::Destination* PacketScheduler::getNextDestination() {
+    if (_tokens < 1.0f) {
+        return NULL;
+    }
+    Destination* next = NULL;
+    for (int i = 0; i < _destinations.size(); i++) {
+        Destination& destination = _destinations[i];
+        if (!destination.packets.empty() && destination.tokens >= 1.0f &&
+                (!next || destination.packets.front().finishTag < next->packets.front().finishTag)) {
+            next = &destination;
+        }
+    }
+    return next;
+}
+
+void PacketScheduler::packetSent(Destination& destination) {
+    _tokens -= 1.0f;
+    destination.tokens -= 1.0f;
+    destination.sentThisInterval++;
+    _virtualTime = destination.packets.front().startTag;
+    _freeBuffers.push_back(destination.packets.front().packet);
+    destination.packets.pop_front();
+
+    if (_queuedPacketCount.fetchAndAddRelaxed(-1) == 1) {
+        // everyone has caught up; start the tags over so that they stay precise
+        _virtualTime = 0.0;
+        for (int i = 0; i < _destinations.size(); i++) {
+            _destinations[i].lastFinishTag = 0.0;
+        }
+    }
+}
+
+void PacketScheduler::packetFailed(quint64 now) {
+    _retryAfter = now + SOCKET_RETRY_USECS;
+}
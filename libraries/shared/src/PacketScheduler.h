@@ -0,0 +1,156 @@
+//
+//  PacketScheduler.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Per destination token buckets and weighted fair queuing for outbound packets, with rates adapted to each link
+//
+
+#ifndef __hifi__PacketScheduler__
+#define __hifi__PacketScheduler__
+
+#include <deque>
+#include <vector>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+#include "NodeList.h"
+
+/// The send rate to one destination, as shown in the stats.
+class DestinationRate {
+public:
+    QUuid uuid;
+    NodeType_t nodeType;
+    float packetsPerSecond; // sent over the last second
+    float targetPacketsPerSecond; // what its bucket lets through, given the state of the link
+    int queuedPackets;
+};
+
+/// Decides which queued packets go out when, for a PacketSender. Each destination has its own queue and its own token
+/// bucket, filled at a rate that starts at the sender's packets per second and is halved when the pings to the
+/// destination show loss or a swollen round trip, then grown back a step at a time while they don't. Destinations with
+/// tokens share the sender's overall rate by weighted fair queuing: each packet is tagged with the virtual time its
+/// destination would finish sending it were the link shared by weight, and the earliest tag goes first, so that a burst
+/// to one server waits its turn behind the others rather than starving them.
+class PacketScheduler {
+public:
+    PacketScheduler(int packetsPerSecond);
+
+    /// Sets the overall rate, which also caps the rate to each destination.
+    void setPacketsPerSecond(int packetsPerSecond) { _packetsPerSecond = packetsPerSecond; }
+    int getPacketsPerSecond() const { return _packetsPerSecond; }
+
+    /// Sets how long a burst each bucket can save up for; at least as long as the gap between calls to sendPackets.
+    void setBurstUsecs(quint64 burstUsecs) { _burstUsecs = burstUsecs; }
+
+    /// Sets the share of the overall rate a destination gets when the others are sending too; 1 by default. Takes
+    /// effect within a second.
+    /// \thread any
+    void setWeight(const QUuid& uuid, float weight);
+
+    /// Is there a token for another of node's packets, on top of the ones already queued here? The sender only takes a
+    /// packet off its own queue when there is, so that its queue stays the bounded one and we only ever hold what we're
+    /// about to send. If there isn't, getUsecsUntilNextSend() covers the wait for that destination's next token.
+    bool hasRoomFor(const SharedNodePointer& node, quint64 now);
+
+    /// Did the last call to hasRoomFor() find no room?
+    bool isWaitingForRoom() const { return _isWaitingForRoom; }
+
+    /// Copies the packet into one of our own buffers, which are reused once their packets have gone.
+    void queuePacket(const SharedNodePointer& node, const QByteArray& packet);
+
+    /// Hands the packets due by now to sender.sendPacket(const SharedNodePointer&, const QByteArray&), which returns
+    /// false if the socket couldn't take the packet, in which case it's tried again on a later call.
+    /// \return the number of packets sent
+    template<class Sender> int sendPackets(Sender& sender, quint64 now);
+
+    /// \return the usecs until the next packet is due, or until there's room for the one hasRoomFor() was last refused,
+    /// or -1 if there are none queued or waiting
+    qint64 getUsecsUntilNextSend(quint64 now) const;
+
+    int getQueuedPacketCount() const { return _queuedPacketCount.load(); }
+
+    /// \thread any
+    QVector<DestinationRate> getDestinationRates() const;
+
+private:
+    class QueuedPacket {
+    public:
+        QByteArray packet;
+        double startTag;
+        double finishTag;
+    };
+
+    class Destination {
+    public:
+        QUuid uuid;
+        SharedNodePointer node;
+        float weight;
+        std::deque<QueuedPacket> packets;
+        double lastFinishTag;
+        float tokens;
+        float packetsPerSecond; // the bucket's fill rate
+        int minPingMs; // the quietest round trip seen, the baseline for spotting queues building along the link
+        float lastLossRate;
+        int sentThisInterval;
+        float sentPacketsPerSecond;
+        int idleIntervals;
+    };
+
+    Destination& getDestination(const QUuid& uuid);
+
+    /// Adds the tokens earned since the last call and, once a second, adapts each destination's rate to its link.
+    void refill(quint64 now);
+    void adaptRates(quint64 now);
+
+    /// \return the destination whose head packet has the earliest finish tag and that has a token to send it, or NULL
+    Destination* getNextDestination();
+
+    float getBurstTokens(float packetsPerSecond) const;
+
+    void packetSent(Destination& destination);
+    void packetFailed(quint64 now);
+
+    int _packetsPerSecond;
+    quint64 _burstUsecs;
+    QVector<Destination> _destinations;
+    double _virtualTime;
+    float _tokens;
+    bool _hasRefilled;
+    quint64 _lastRefill;
+    quint64 _lastAdapt;
+    quint64 _retryAfter; // when the socket last refused a packet, not before this
+    QAtomicInt _queuedPacketCount;
+    bool _isWaitingForRoom;
+    QUuid _waitingUuid; // the destination hasRoomFor() last refused
+    std::vector<QByteArray> _freeBuffers; // from packets that have been sent, for the next ones queued
+
+    mutable QMutex _ratesMutex; // guards the rates and weights, which other threads reach
+    QVector<DestinationRate> _rates;
+    QHash<QUuid, float> _weights;
+};
+
+template<class Sender> inline int PacketScheduler::sendPackets(Sender& sender, quint64 now) {
+    refill(now);
+    if (now < _retryAfter) {
+        return 0;
+    }
+    int sent = 0;
+    Destination* destination;
+    while ((destination = getNextDestination())) {
+        if (!sender.sendPacket(destination->node, destination->packets.front().packet)) {
+            // most likely the socket's send buffer is full; give it a moment to drain, and try the same packet again
+            packetFailed(now);
+            break;
+        }
+        packetSent(*destination);
+        sent++;
+    }
+    return sent;
+}
+
+#endif /* defined(__hifi__PacketScheduler__) */
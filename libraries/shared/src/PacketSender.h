@@ -11,26 +11,26 @@
 #ifndef __shared__PacketSender__
 #define __shared__PacketSender__
 
+#include <QElapsedTimer>
 #include <QWaitCondition>
 
 #include "GenericThread.h"
 #include "NetworkPacket.h"
 #include "NodeList.h"
+#include "PacketQueue.h"
+#include "PacketScheduler.h"
 #include "SharedUtil.h"
 
-/// Generalized threaded processor for queueing and sending of outbound packets.
+/// Generalized threaded processor for queueing and sending of outbound packets. The packets per second is the overall
+/// rate; a PacketScheduler shares it fairly between destinations and slows down the ones whose links are struggling.
 class PacketSender : public GenericThread {
     Q_OBJECT
 public:
 
     static const quint64 USECS_PER_SECOND;
-    static const quint64 SENDING_INTERVAL_ADJUST;
-    static const int TARGET_FPS;
-    static const int MAX_SLEEP_INTERVAL;
 
     static const int DEFAULT_PACKETS_PER_SECOND;
     static const int MINIMUM_PACKETS_PER_SECOND;
-    static const int MINIMAL_SLEEP_INTERVAL;
 
     PacketSender(int packetsPerSecond = DEFAULT_PACKETS_PER_SECOND);
     ~PacketSender();
@@ -49,10 +49,20 @@ public:
     virtual void terminating();
 
     /// are there packets waiting in the send queue to be sent
-    bool hasPacketsToSend() const { return _packets.size() > 0; }
+    bool hasPacketsToSend() const { return packetsToSendCount() > 0; }
 
     /// how many packets are there in the send queue waiting to be sent
-    int packetsToSendCount() const { return _packets.size(); }
+    int packetsToSendCount() const { return _packets.size() + _scheduler.getQueuedPacketCount(); }
+
+    /// Sets the share of the packets per second a destination gets when others are being sent to as well; 1 by default.
+    void setDestinationWeight(const QUuid& nodeUUID, float weight) { _scheduler.setWeight(nodeUUID, weight); }
+
+    /// returns the current send rate to each destination, and the rate its link is allowing
+    QVector<DestinationRate> getDestinationRates() const { return _scheduler.getDestinationRates(); }
+
+    /// how many queued packets found the send queue full and had to wait in its overflow, a sign that we're being handed
+    /// packets faster than we can send them
+    int getOverflowCount() const { return _packets.getOverflowCount(); }
 
     /// If you're running in non-threaded mode, call this to give us a hint as to how frequently you will call process.
     /// This has no effect in threaded mode. This is only considered a hint in non-threaded mode.
@@ -101,15 +111,27 @@ protected:
     SimpleMovingAverage _averageProcessCallTime;
 
 private:
-    std::vector<NetworkPacket> _packets;
-    quint64 _lastSendTime;
+    friend class PacketQueue;
+    friend class PacketScheduler;
+
+    /// hands one packet drained from the queue to the scheduler, which copies it out of the queue's buffer
+    void handlePacket(const SharedNodePointer& destinationNode, const QByteArray& packet);
+
+    /// sends one packet the scheduler says is due
+    /// \return false if the socket couldn't take it
+    bool sendPacket(const SharedNodePointer& destinationNode, const QByteArray& packet);
+
+    /// \return the time from our clock, the one clock all of our pacing runs on
+    quint64 getClockUsecs() const { return _clock.nsecsElapsed() / NSECS_PER_USEC; }
+
+    PacketQueue _packets;
+    PacketScheduler _scheduler;
+    QElapsedTimer _clock;
+    bool _hasSent;
 
     bool threadedProcess();
     bool nonThreadedProcess();
 
-    quint64 _lastPPSCheck;
-    int _packetsOverCheckInterval;
-
     quint64 _started;
     quint64 _totalPacketsSent;
     quint64 _totalBytesSent;
@@ -20,29 +20,21 @@ void ReceivedPacketProcessor::queueReceivedPacket(const SharedNodePointer& desti
     // Make sure our Node and NodeList knows we've heard from this node.
     destinationNode->setLastHeardMicrostamp(usecTimestampNow());
 
-    NetworkPacket networkPacket(destinationNode, packet);
-    lock();
-    _packets.push_back(networkPacket);
-    unlock();
-    
+    _packets.push(destinationNode, packet);
+
     // Make sure to  wake our actual processing thread because we  now have packets for it to process.
     _hasPackets.wakeAll();
 }
 
 bool ReceivedPacketProcessor::process() {
 
-    if (_packets.size() == 0) {
+    if (_packets.isEmpty()) {
         _waitingOnPacketsMutex.lock();
         _hasPackets.wait(&_waitingOnPacketsMutex);
         _waitingOnPacketsMutex.unlock();
     }
-    while (_packets.size() > 0) {
-        lock(); // lock to make sure nothing changes on us
-        NetworkPacket& packet = _packets.front(); // get the oldest packet
-        NetworkPacket temporary = packet; // make a copy of the packet in case the vector is resized on us
-        _packets.erase(_packets.begin()); // remove the oldest packet
-        unlock(); // let others add to the packets
-        processPacket(temporary.getDestinationNode(), temporary.getByteArray()); // process our temporary copy
+    // process the packets in place, in the order they arrived, until we've caught up
+    while (_packets.drain(*this) > 0) {
     }
     return isStillRunning();  // keep running till they terminate us
 }
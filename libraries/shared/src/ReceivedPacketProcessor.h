@@ -14,7 +14,7 @@
 #include <QWaitCondition>
 
 #include "GenericThread.h"
-#include "NetworkPacket.h"
+#include "PacketQueue.h"
 
 /// Generalized threaded processor for handling received inbound packets. 
 class ReceivedPacketProcessor : public GenericThread {
@@ -30,11 +30,14 @@ public:
     void queueReceivedPacket(const SharedNodePointer& destinationNode, const QByteArray& packet);
 
     /// Are there received packets waiting to be processed
-    bool hasPacketsToProcess() const { return _packets.size() > 0; }
+    bool hasPacketsToProcess() const { return !_packets.isEmpty(); }
 
     /// How many received packets waiting are to be processed
     int packetsToProcessCount() const { return _packets.size(); }
 
+    /// How many received packets found the processing queue full and had to wait in its overflow
+    int getOverflowCount() const { return _packets.getOverflowCount(); }
+
 protected:
     /// Callback for processing of recieved packets. Implement this to process the incoming packets.
     /// \param sockaddr& senderAddress the address of the sender
@@ -49,8 +52,11 @@ protected:
     virtual void terminating();
 
 private:
+    friend class PacketQueue;
+
+    void handlePacket(const SharedNodePointer& sendingNode, const QByteArray& packet) { processPacket(sendingNode, packet); }
 
-    std::vector<NetworkPacket> _packets;
+    PacketQueue _packets;
     QWaitCondition _hasPackets;
     QMutex _waitingOnPacketsMutex;
 };
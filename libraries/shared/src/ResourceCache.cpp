@@ -9,6 +9,9 @@
 #include <cfloat>
 #include <cmath>
 
+#include <QAbstractNetworkCache>
+#include <QDateTime>
+#include <QNetworkAccessManager>
 #include <QTimer>
 #include <QtDebug>
 
@@ -57,21 +60,34 @@ void ResourceCache::addUnusedResource(const QSharedPointer<Resource>& resource)
 }
 
 void ResourceCache::attemptRequest(Resource* resource) {
+    // a copy that's fresh on disk won't touch the network, so it needn't wait for a turn at it
+    if (isFreshInCache(resource->_url)) {
+        resource->_usingRequestSlot = false;
+        _loadingRequests.append(resource);
+        resource->makeRequest();
+        return;
+    }
     if (_requestLimit <= 0) {
         // wait until a slot becomes available
         _pendingRequests.append(resource);
         return;
     }
     _requestLimit--;
+    resource->_usingRequestSlot = true;
     _loadingRequests.append(resource);
     resource->makeRequest();
 }
 
 void ResourceCache::requestCompleted(Resource* resource) {
     _loadingRequests.removeOne(resource);
+    if (!resource->_usingRequestSlot) {
+        return;
+    }
+    resource->_usingRequestSlot = false;
     _requestLimit++;
     
-    // look for the highest priority pending request
+    // look for the highest priority pending request; priorities are read now rather than when the requests were queued, so
+    // changes made while they waited take effect
     int highestIndex = -1;
     float highestPriority = -FLT_MAX;
     for (int i = 0; i < _pendingRequests.size(); ) {
@@ -92,6 +108,29 @@ void ResourceCache::requestCompleted(Resource* resource) {
     }
 }
 
+void ResourceCache::countDownload(QNetworkReply* reply) {
+    if (reply->error() != QNetworkReply::NoError) {
+        return;
+    }
+    _completedRequestCount++;
+    if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool()) {
+        _cachedRequestCount++;
+        _bytesFromCache += reply->bytesAvailable();
+    } else {
+        _bytesFromNetwork += reply->bytesAvailable();
+    }
+}
+
+bool ResourceCache::isFreshInCache(const QUrl& url) {
+    QAbstractNetworkCache* cache = _networkAccessManager->cache();
+    if (!cache) {
+        return false;
+    }
+    QNetworkCacheMetaData metaData = cache->metaData(url);
+    return metaData.isValid() && metaData.expirationDate().isValid() &&
+        metaData.expirationDate() > QDateTime::currentDateTimeUtc();
+}
+
 QNetworkAccessManager* ResourceCache::_networkAccessManager = NULL;
 
 const int DEFAULT_REQUEST_LIMIT = 10;
@@ -99,6 +138,10 @@ int ResourceCache::_requestLimit = DEFAULT_REQUEST_LIMIT;
 
 QList<QPointer<Resource> > ResourceCache::_pendingRequests;
 QList<Resource*> ResourceCache::_loadingRequests;
+int ResourceCache::_completedRequestCount = 0;
+int ResourceCache::_cachedRequestCount = 0;
+qint64 ResourceCache::_bytesFromCache = 0;
+qint64 ResourceCache::_bytesFromNetwork = 0;
 
 Resource::Resource(const QUrl& url, bool delayLoad) :
     _url(url),
@@ -108,13 +151,16 @@ Resource::Resource(const QUrl& url, bool delayLoad) :
     _loaded(false),
     _lruKey(0),
     _reply(NULL),
-    _attempts(0) {
+    _usingRequestSlot(false),
+    _attempts(0),
+    _usingCachedCopy(false) {
     
     if (!(url.isValid() && ResourceCache::getNetworkAccessManager())) {
         _startedLoading = _failedToLoad = true;
         return;
     }
-    _request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+    // use a cached copy while it's fresh, and check a stale one with a conditional request rather than fetch it again
+    _request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork);
     
     // start loading immediately unless instructed otherwise
     if (!delayLoad) {    
@@ -218,7 +264,9 @@ void Resource::handleDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
     _replyTimer->disconnect(this);
     _replyTimer->deleteLater();
     _replyTimer = NULL;
+    _usingCachedCopy = false;
     ResourceCache::requestCompleted(this);
+    ResourceCache::countDownload(reply);
     
     downloadFinished(reply);
 }
@@ -233,7 +281,12 @@ void Resource::handleReplyTimeout() {
 }
 
 void Resource::makeRequest() {
-    _reply = ResourceCache::getNetworkAccessManager()->get(_request);
+    QNetworkRequest request = _request;
+    if (_usingCachedCopy) {
+        // for this attempt only; later retries should still go to the network
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysCache);
+    }
+    _reply = ResourceCache::getNetworkAccessManager()->get(request);
     
     connect(_reply, SIGNAL(downloadProgress(qint64,qint64)), SLOT(handleDownloadProgress(qint64,qint64)));
     connect(_reply, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(handleReplyError()));
@@ -253,6 +306,8 @@ void Resource::handleReplyError(QNetworkReply::NetworkError error, QDebug debug)
     _replyTimer->disconnect(this);
     _replyTimer->deleteLater();
     _replyTimer = NULL;
+    bool triedCachedCopy = _usingCachedCopy;
+    _usingCachedCopy = false;
     ResourceCache::requestCompleted(this);
     
     // retry for certain types of failures
@@ -266,6 +321,14 @@ void Resource::handleReplyError(QNetworkReply::NetworkError error, QDebug debug)
         case QNetworkReply::UnknownProxyError:
         case QNetworkReply::UnknownContentError:
         case QNetworkReply::ProtocolFailure: {        
+            // if the server can't be reached but we have a copy, stale or not, use that rather than keep trying
+            QAbstractNetworkCache* cache = ResourceCache::getNetworkAccessManager()->cache();
+            if (!triedCachedCopy && cache && cache->metaData(_url).isValid()) {
+                _usingCachedCopy = true;
+                QTimer::singleShot(0, this, SLOT(attemptRequest()));
+                debug << "-- using cached copy";
+                return;
+            }
             // retry with increasing delays
             const int MAX_ATTEMPTS = 8;
             const int BASE_DELAY_MS = 1000;
@@ -41,6 +41,15 @@ public:
 
     static int getPendingRequestCount() { return _pendingRequests.size(); }
 
+    /// Returns the number of downloads that finished, in total and served from the network access manager's cache (with
+    /// or without a conditional request to check it was current).
+    static int getCompletedRequestCount() { return _completedRequestCount; }
+    static int getCachedRequestCount() { return _cachedRequestCount; }
+
+    /// Returns the bytes of the finished downloads that came from the cache rather than the network.
+    static qint64 getBytesFromCache() { return _bytesFromCache; }
+    static qint64 getBytesFromNetwork() { return _bytesFromNetwork; }
+
     ResourceCache(QObject* parent = NULL);
     virtual ~ResourceCache();
 
@@ -63,6 +72,10 @@ protected:
     
     static void attemptRequest(Resource* resource);
     static void requestCompleted(Resource* resource);
+    static void countDownload(QNetworkReply* reply);
+
+    /// Checks whether the URL has a copy in the cache that can be used without asking the server.
+    static bool isFreshInCache(const QUrl& url);
 
 private:
     
@@ -75,6 +88,10 @@ private:
     static int _requestLimit;
     static QList<QPointer<Resource> > _pendingRequests;
     static QList<Resource*> _loadingRequests;
+    static int _completedRequestCount;
+    static int _cachedRequestCount;
+    static qint64 _bytesFromCache;
+    static qint64 _bytesFromNetwork;
 };
 
 /// Base class for resources.
@@ -165,11 +182,13 @@ private:
     
     int _lruKey;
     QNetworkReply* _reply;
+    bool _usingRequestSlot;
     QTimer* _replyTimer;
     int _index;
     qint64 _bytesReceived;
     qint64 _bytesTotal;
     int _attempts;
+    bool _usingCachedCopy; // whether the current attempt takes the cached copy because the server couldn't be reached
 };
 
 uint qHash(const QPointer<QObject>& value, uint seed = 0);
@@ -0,0 +1,250 @@
+//
+//  ResourceDiskCache.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QBuffer>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMultiMap>
+#include <QtCore/QSaveFile>
+
+#include "ResourceDiskCache.h"
+
+const qint64 DEFAULT_MAXIMUM_CACHE_SIZE = 512 * 1024 * 1024;
+
+// written at the start of each entry file, so that files from another version are dropped rather than misread
+const quint32 ENTRY_FILE_MAGIC = 0x52444301;
+
+const QString ENTRIES_DIRECTORY = "/entries/";
+const QString CONTENT_DIRECTORY = "/content/";
+
+ResourceDiskCache::ResourceDiskCache(QObject* parent) :
+    QAbstractNetworkCache(parent),
+    _maximumCacheSize(DEFAULT_MAXIMUM_CACHE_SIZE),
+    _cacheSize(0) {
+}
+
+void ResourceDiskCache::setCacheDirectory(const QString& cacheDirectory) {
+    _cacheDirectory = cacheDirectory;
+    _entries.clear();
+    _contentReferences.clear();
+    _cacheSize = 0;
+
+    QDir().mkpath(_cacheDirectory + ENTRIES_DIRECTORY);
+    QDir().mkpath(_cacheDirectory + CONTENT_DIRECTORY);
+
+    foreach (const QFileInfo& entryInfo, QDir(_cacheDirectory + ENTRIES_DIRECTORY).entryInfoList(QDir::Files)) {
+        Entry entry;
+        bool isValid = false;
+        QFile file(entryInfo.filePath());
+        if (file.open(QIODevice::ReadOnly)) {
+            QDataStream in(&file);
+            in.setVersion(QDataStream::Qt_5_0);
+            quint32 magic = 0;
+            in >> magic;
+            if (magic == ENTRY_FILE_MAGIC) {
+                in >> entry.metaData >> entry.contentHash >> entry.size;
+                isValid = in.status() == QDataStream::Ok && entry.metaData.url().isValid() &&
+                    getEntryPath(entry.metaData.url()) == entryInfo.filePath() &&
+                    QFileInfo(getContentPath(entry.contentHash)).size() == entry.size;
+            }
+            file.close();
+        }
+        if (!isValid) {
+            QFile::remove(entryInfo.filePath());
+            continue;
+        }
+        // what we remember of the order of use from one run to the next is when each entry was last written
+        entry.lastUsed = entryInfo.lastModified().toMSecsSinceEpoch();
+        _entries.insert(entry.metaData.url(), entry);
+        if (_contentReferences[entry.contentHash]++ == 0) {
+            _cacheSize += entry.size;
+        }
+    }
+
+    // drop content no entry refers to, left by a run that stopped partway through an insert or removal
+    foreach (const QFileInfo& contentInfo, QDir(_cacheDirectory + CONTENT_DIRECTORY).entryInfoList(QDir::Files)) {
+        if (!_contentReferences.contains(QByteArray::fromHex(contentInfo.fileName().toLatin1()))) {
+            QFile::remove(contentInfo.filePath());
+        }
+    }
+    expire();
+}
+
+void ResourceDiskCache::setMaximumCacheSize(qint64 maximumCacheSize) {
+    _maximumCacheSize = maximumCacheSize;
+    expire();
+}
+
+QNetworkCacheMetaData ResourceDiskCache::metaData(const QUrl& url) {
+    QHash<QUrl, Entry>::const_iterator it = _entries.constFind(url);
+    return (it == _entries.constEnd()) ? QNetworkCacheMetaData() : it->metaData;
+}
+
+void ResourceDiskCache::updateMetaData(const QNetworkCacheMetaData& metaData) {
+    // called when a conditional request comes back unmodified, with the fresh headers
+    QHash<QUrl, Entry>::iterator it = _entries.find(metaData.url());
+    if (it == _entries.end()) {
+        return;
+    }
+    it->metaData = metaData;
+    it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    if (!writeEntry(*it)) {
+        removeEntry(metaData.url());
+    }
+}
+
+QIODevice* ResourceDiskCache::data(const QUrl& url) {
+    QHash<QUrl, Entry>::iterator it = _entries.find(url);
+    if (it == _entries.end()) {
+        return NULL;
+    }
+    QFile* file = new QFile(getContentPath(it->contentHash));
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        removeEntry(url);
+        return NULL;
+    }
+    it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    return file;
+}
+
+bool ResourceDiskCache::remove(const QUrl& url) {
+    // the access manager also removes the URLs of downloads it abandons after preparing them
+    for (QHash<QIODevice*, QNetworkCacheMetaData>::iterator it = _preparing.begin(); it != _preparing.end(); ) {
+        if (it.value().url() == url) {
+            delete it.key();
+            it = _preparing.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (!_entries.contains(url)) {
+        return false;
+    }
+    removeEntry(url);
+    return true;
+}
+
+QIODevice* ResourceDiskCache::prepare(const QNetworkCacheMetaData& metaData) {
+    if (_cacheDirectory.isEmpty() || !metaData.isValid() || !metaData.url().isValid() || !metaData.saveToDisk()) {
+        return NULL;
+    }
+    // the whole body is needed to find its hash, so it's kept in memory until it's all arrived
+    QBuffer* buffer = new QBuffer();
+    buffer->open(QIODevice::ReadWrite);
+    _preparing.insert(buffer, metaData);
+    return buffer;
+}
+
+void ResourceDiskCache::insert(QIODevice* device) {
+    QHash<QIODevice*, QNetworkCacheMetaData>::iterator preparing = _preparing.find(device);
+    if (preparing == _preparing.end()) {
+        return;
+    }
+    Entry entry;
+    entry.metaData = preparing.value();
+    _preparing.erase(preparing);
+    QByteArray content = static_cast<QBuffer*>(device)->data();
+    delete device;
+
+    if (content.size() > _maximumCacheSize) {
+        return;
+    }
+    entry.contentHash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+    entry.size = content.size();
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+
+    if (!_contentReferences.contains(entry.contentHash)) {
+        QSaveFile file(getContentPath(entry.contentHash));
+        if (!(file.open(QIODevice::WriteOnly) && file.write(content) == content.size() && file.commit())) {
+            return;
+        }
+    }
+    // reference the content before dropping any earlier entry for the URL, which may have had the same content
+    if (_contentReferences[entry.contentHash]++ == 0) {
+        _cacheSize += entry.size;
+    }
+    QUrl url = entry.metaData.url();
+    if (_entries.contains(url)) {
+        removeEntry(url);
+    }
+    _entries.insert(url, entry);
+    if (!writeEntry(entry)) {
+        removeEntry(url);
+    }
+    expire();
+}
+
+void ResourceDiskCache::removeNetworkDiskCache(const QString& directory) {
+    // the data directory is named for the QNetworkDiskCache format version; remove any we might have left behind
+    QStringList oldDirectories = QDir(directory).entryList(QStringList() << "data[0-9]" << "prepared", QDir::Dirs);
+    foreach (const QString& oldDirectory, oldDirectories) {
+        QDir(directory + "/" + oldDirectory).removeRecursively();
+    }
+}
+
+void ResourceDiskCache::clear() {
+    foreach (const QUrl& url, _entries.keys()) {
+        removeEntry(url);
+    }
+    foreach (QIODevice* device, _preparing.keys()) {
+        delete device;
+    }
+    _preparing.clear();
+}
+
+QString ResourceDiskCache::getEntryPath(const QUrl& url) const {
+    return _cacheDirectory + ENTRIES_DIRECTORY +
+        QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex();
+}
+
+QString ResourceDiskCache::getContentPath(const QByteArray& contentHash) const {
+    return _cacheDirectory + CONTENT_DIRECTORY + contentHash.toHex();
+}
+
+bool ResourceDiskCache::writeEntry(const Entry& entry) {
+    QSaveFile file(getEntryPath(entry.metaData.url()));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << ENTRY_FILE_MAGIC << entry.metaData << entry.contentHash << entry.size;
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+void ResourceDiskCache::removeEntry(const QUrl& url) {
+    Entry entry = _entries.take(url);
+    QFile::remove(getEntryPath(url));
+
+    QHash<QByteArray, int>::iterator references = _contentReferences.find(entry.contentHash);
+    if (references != _contentReferences.end() && --references.value() == 0) {
+        _contentReferences.erase(references);
+        _cacheSize -= entry.size;
+        QFile::remove(getContentPath(entry.contentHash));
+    }
+}
+
+void ResourceDiskCache::expire() {
+    if (_cacheSize <= _maximumCacheSize) {
+        return;
+    }
+    // drop a little more than needed, so as not to expire again on the next insert
+    const qint64 EXPIRED_CACHE_SIZE = _maximumCacheSize * 9 / 10;
+    QMultiMap<qint64, QUrl> urlsByLastUse;
+    for (QHash<QUrl, Entry>::const_iterator it = _entries.constBegin(); it != _entries.constEnd(); it++) {
+        urlsByLastUse.insert(it->lastUsed, it.key());
+    }
+    for (QMultiMap<qint64, QUrl>::const_iterator it = urlsByLastUse.constBegin();
+            it != urlsByLastUse.constEnd() && _cacheSize > EXPIRED_CACHE_SIZE; it++) {
+        removeEntry(it.value());
+    }
+}
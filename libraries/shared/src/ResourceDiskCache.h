@@ -0,0 +1,85 @@
+//
+//  ResourceDiskCache.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Size bounded network cache that keeps each distinct download on disk once, however many URLs it was fetched from
+//
+
+#ifndef __hifi__ResourceDiskCache__
+#define __hifi__ResourceDiskCache__
+
+#include <QtCore/QHash>
+#include <QtCore/QUrl>
+#include <QtNetwork/QAbstractNetworkCache>
+#include <QtNetwork/QNetworkCacheMetaData>
+
+/// A disk cache for the network access manager that ResourceCache loads through. Bodies are stored under the SHA-1 of their
+/// content, so an avatar's textures shared by several models, or a mesh moved to a new URL, take the space of one copy,
+/// while each URL keeps its own headers. Those headers are what lets the access manager revalidate a stale copy with a
+/// conditional request and reuse it on a 304 rather than downloading it again. Once over its maximum size, the cache drops
+/// the least recently used URLs, and any content no URL refers to any more, until it's back under.
+class ResourceDiskCache : public QAbstractNetworkCache {
+    Q_OBJECT
+
+public:
+
+    ResourceDiskCache(QObject* parent = NULL);
+
+    /// Sets the directory and loads whatever a previous run left in it.
+    void setCacheDirectory(const QString& cacheDirectory);
+    const QString& getCacheDirectory() const { return _cacheDirectory; }
+
+    void setMaximumCacheSize(qint64 maximumCacheSize);
+    qint64 getMaximumCacheSize() const { return _maximumCacheSize; }
+
+    /// Returns the number of URLs cached.
+    int getEntryCount() const { return _entries.size(); }
+
+    /// Returns the number of distinct bodies stored for them.
+    int getContentCount() const { return _contentReferences.size(); }
+
+    virtual QNetworkCacheMetaData metaData(const QUrl& url);
+    virtual void updateMetaData(const QNetworkCacheMetaData& metaData);
+    virtual QIODevice* data(const QUrl& url);
+    virtual bool remove(const QUrl& url);
+    virtual qint64 cacheSize() const { return _cacheSize; }
+    virtual QIODevice* prepare(const QNetworkCacheMetaData& metaData);
+    virtual void insert(QIODevice* device);
+
+    /// Deletes what a QNetworkDiskCache left in the directory, which is where resources were cached before this cache
+    /// replaced it. Leaves anything else in the directory alone.
+    static void removeNetworkDiskCache(const QString& directory);
+
+public slots:
+
+    virtual void clear();
+
+private:
+
+    class Entry {
+    public:
+        QNetworkCacheMetaData metaData;
+        QByteArray contentHash;
+        qint64 size;
+        qint64 lastUsed; ///< msecs since the epoch
+    };
+
+    QString getEntryPath(const QUrl& url) const;
+    QString getContentPath(const QByteArray& contentHash) const;
+
+    bool writeEntry(const Entry& entry);
+    void removeEntry(const QUrl& url);
+    void expire();
+
+    QString _cacheDirectory;
+    qint64 _maximumCacheSize;
+    qint64 _cacheSize; ///< bytes of distinct content
+
+    QHash<QUrl, Entry> _entries;
+    QHash<QByteArray, int> _contentReferences; ///< URLs per content hash
+    QHash<QIODevice*, QNetworkCacheMetaData> _preparing;
+};
+
+#endif /* defined(__hifi__ResourceDiskCache__) */
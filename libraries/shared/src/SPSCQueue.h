@@ -0,0 +1,84 @@
+//
+//  SPSCQueue.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Fixed capacity ring of reusable slots handed from one producer thread to one consumer thread without locking
+//
+
+#ifndef __hifi__SPSCQueue__
+#define __hifi__SPSCQueue__
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QVector>
+
+/// A lock free queue for exactly one producing and one consuming thread. Its slots are allocated once and never freed,
+/// and are filled and read in place: the producer gets the back slot, fills it and pushes it; the consumer gets the front
+/// slot, reads it and pops it. Slots keep their contents after a pop, so a slot holding a buffer hands that buffer's
+/// storage back to the producer for the next push rather than freeing it.
+template<class T> class SPSCQueue {
+public:
+    /// \param capacity the number of slots, rounded up to a power of two
+    SPSCQueue(int capacity);
+
+    /// Producer only.
+    /// \return the slot to fill before calling push, or NULL if the queue is full
+    T* getBack();
+
+    /// Producer only: makes the slot returned by getBack visible to the consumer.
+    void push() { _tail.fetchAndAddRelease(1); }
+
+    /// Consumer only.
+    /// \return the oldest pushed slot, or NULL if the queue is empty
+    T* getFront();
+
+    /// Consumer only: returns the slot returned by getFront to the producer.
+    void pop() { _head.fetchAndAddRelease(1); }
+
+    /// \return the number of pushed slots not yet popped, which may be stale by the time it's used
+    int size() const { return (unsigned int)_tail.loadAcquire() - (unsigned int)_head.loadAcquire(); }
+
+    int getCapacity() const { return _slots.size(); }
+
+    /// \return one of the slots by position, for setting them up before the queue is shared
+    T& getSlot(int index) { return _data[index]; }
+
+private:
+    SPSCQueue(const SPSCQueue& other);
+    SPSCQueue& operator=(const SPSCQueue& other);
+
+    QVector<T> _slots;
+    T* _data; // the slots, without QVector's detach check on every access
+    int _mask;
+    QAtomicInt _head; // next slot to consume, only ever written by the consumer
+    QAtomicInt _tail; // next slot to produce, only ever written by the producer
+};
+
+template<class T> inline SPSCQueue<T>::SPSCQueue(int capacity) : _head(0), _tail(0) {
+    int size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _slots.resize(size);
+    _data = _slots.data();
+    _mask = size - 1;
+}
+
+template<class T> inline T* SPSCQueue<T>::getBack() {
+    unsigned int tail = _tail.load();
+    if (tail - (unsigned int)_head.loadAcquire() == (unsigned int)_slots.size()) {
+        return NULL;
+    }
+    return &_data[tail & _mask];
+}
+
+template<class T> inline T* SPSCQueue<T>::getFront() {
+    unsigned int head = _head.load();
+    if ((unsigned int)_tail.loadAcquire() == head) {
+        return NULL;
+    }
+    return &_data[head & _mask];
+}
+
+#endif /* defined(__hifi__SPSCQueue__) */
@@ -0,0 +1,66 @@
+//
+//  ShapeBatch.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include "CapsuleShape.h"
+#include "ShapeBatch.h"
+#include "SphereShape.h"
+
+const int MIN_BATCH_CAPACITY = 16;
+
+int SphereBatch::addSphere(const glm::vec3& center, float radius) {
+    if (_size == _radii.size()) {
+        int capacity = qMax(MIN_BATCH_CAPACITY, _size * 2);
+        _x.resize(capacity);
+        _y.resize(capacity);
+        _z.resize(capacity);
+        _radii.resize(capacity);
+    }
+    _x[_size] = center.x;
+    _y[_size] = center.y;
+    _z[_size] = center.z;
+    _radii[_size] = radius;
+    return _size++;
+}
+
+int SphereBatch::addShape(const SphereShape* sphere) {
+    return addSphere(sphere->getPosition(), sphere->getRadius());
+}
+
+int CapsuleBatch::addCapsule(const glm::vec3& center, const glm::vec3& axis, float halfHeight, float radius) {
+    if (_size == _radii.size()) {
+        int capacity = qMax(MIN_BATCH_CAPACITY, _size * 2);
+        _x.resize(capacity);
+        _y.resize(capacity);
+        _z.resize(capacity);
+        _axisX.resize(capacity);
+        _axisY.resize(capacity);
+        _axisZ.resize(capacity);
+        _halfHeights.resize(capacity);
+        _radii.resize(capacity);
+    }
+    _x[_size] = center.x;
+    _y[_size] = center.y;
+    _z[_size] = center.z;
+    _axisX[_size] = axis.x;
+    _axisY[_size] = axis.y;
+    _axisZ[_size] = axis.z;
+    _halfHeights[_size] = halfHeight;
+    _radii[_size] = radius;
+    return _size++;
+}
+
+int CapsuleBatch::addShape(const CapsuleShape* capsule) {
+    glm::vec3 axis;
+    capsule->computeNormalizedAxis(axis);
+    return addCapsule(capsule->getPosition(), axis, capsule->getHalfHeight(), capsule->getRadius());
+}
+
+ContactBuffer::ContactBuffer(int maxSize) :
+    _maxSize(maxSize),
+    _size(0) {
+    _contacts.resize(_maxSize);
+}
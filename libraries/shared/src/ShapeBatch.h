@@ -0,0 +1,123 @@
+//
+//  ShapeBatch.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Spheres and capsules laid out as structure of arrays, for colliding many at once
+//
+
+#ifndef __hifi__ShapeBatch__
+#define __hifi__ShapeBatch__
+
+#include <glm/glm.hpp>
+
+#include <QVector>
+
+class CapsuleShape;
+class SphereShape;
+
+/// Spheres as separate arrays of center coordinates and radii, so that the batched colliders can test one shape against
+/// several of these at a time. Like CollisionList, meant to be cleared and refilled rather than reallocated.
+class SphereBatch {
+public:
+    SphereBatch() : _size(0) { }
+
+    int size() const { return _size; }
+
+    /// \return the index of the new sphere
+    int addSphere(const glm::vec3& center, float radius);
+    int addShape(const SphereShape* sphere);
+
+    glm::vec3 getCenter(int index) const { return glm::vec3(_x.at(index), _y.at(index), _z.at(index)); }
+    float getRadius(int index) const { return _radii.at(index); }
+
+    /// Forgets the spheres, keeping the storage.
+    void clear() { _size = 0; }
+
+    const float* x() const { return _x.constData(); }
+    const float* y() const { return _y.constData(); }
+    const float* z() const { return _z.constData(); }
+    const float* radii() const { return _radii.constData(); }
+
+private:
+    int _size;
+    QVector<float> _x;
+    QVector<float> _y;
+    QVector<float> _z;
+    QVector<float> _radii;
+};
+
+/// Capsules as separate arrays of center coordinates, unit axis components, half heights and radii.
+class CapsuleBatch {
+public:
+    CapsuleBatch() : _size(0) { }
+
+    int size() const { return _size; }
+
+    /// \param axis the unit axis from the center towards the end cap
+    /// \return the index of the new capsule
+    int addCapsule(const glm::vec3& center, const glm::vec3& axis, float halfHeight, float radius);
+    int addShape(const CapsuleShape* capsule);
+
+    glm::vec3 getCenter(int index) const { return glm::vec3(_x.at(index), _y.at(index), _z.at(index)); }
+    glm::vec3 getAxis(int index) const { return glm::vec3(_axisX.at(index), _axisY.at(index), _axisZ.at(index)); }
+    float getHalfHeight(int index) const { return _halfHeights.at(index); }
+    float getRadius(int index) const { return _radii.at(index); }
+
+    /// Forgets the capsules, keeping the storage.
+    void clear() { _size = 0; }
+
+    const float* x() const { return _x.constData(); }
+    const float* y() const { return _y.constData(); }
+    const float* z() const { return _z.constData(); }
+    const float* axisX() const { return _axisX.constData(); }
+    const float* axisY() const { return _axisY.constData(); }
+    const float* axisZ() const { return _axisZ.constData(); }
+    const float* halfHeights() const { return _halfHeights.constData(); }
+    const float* radii() const { return _radii.constData(); }
+
+private:
+    int _size;
+    QVector<float> _x;
+    QVector<float> _y;
+    QVector<float> _z;
+    QVector<float> _axisX;
+    QVector<float> _axisY;
+    QVector<float> _axisZ;
+    QVector<float> _halfHeights;
+    QVector<float> _radii;
+};
+
+/// A touch between shape indexA of the first batch and shape indexB of the second, with the same meaning as the
+/// CollisionInfo the scalar colliders produce: the penetration points from A into B and the contact point is on A.
+class ShapeContact {
+public:
+    int indexA;
+    int indexB;
+    glm::vec3 penetration;
+    glm::vec3 contactPoint;
+};
+
+/// The contacts found by the batched colliders, allocated once at a fixed capacity.
+class ContactBuffer {
+public:
+    ContactBuffer(int maxSize);
+
+    /// \return pointer to the next contact, or NULL if the buffer is full
+    ShapeContact* getNewContact() { return (_size < _maxSize) ? &_contacts[_size++] : NULL; }
+
+    const ShapeContact& getContact(int index) const { return _contacts.at(index); }
+
+    bool isFull() const { return _size == _maxSize; }
+    int size() const { return _size; }
+
+    void clear() { _size = 0; }
+
+private:
+    int _maxSize;
+    int _size;
+    QVector<ShapeContact> _contacts;
+};
+
+#endif /* defined(__hifi__ShapeBatch__) */
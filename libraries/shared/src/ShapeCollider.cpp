@@ -413,4 +413,145 @@ bool listList(const ListShape* listA, const ListShape* listB, CollisionList& col
     return touching;
 }
 
+// as many of B as are tested at once, few enough that the scratch arrays stay in cache
+const int COLLISION_BLOCK_SIZE = 64;
+
+int sphereSphereBatch(const SphereBatch& spheresA, const SphereBatch& spheresB, ContactBuffer& contacts) {
+    int startSize = contacts.size();
+    const float* x = spheresB.x();
+    const float* y = spheresB.y();
+    const float* z = spheresB.z();
+    const float* radii = spheresB.radii();
+    float distancesSquared[COLLISION_BLOCK_SIZE];
+    float overlaps[COLLISION_BLOCK_SIZE];
+
+    for (int a = 0; a < spheresA.size(); a++) {
+        glm::vec3 centerA = spheresA.getCenter(a);
+        float radiusA = spheresA.getRadius(a);
+
+        for (int start = 0; start < spheresB.size(); start += COLLISION_BLOCK_SIZE) {
+            int blockSize = glm::min(COLLISION_BLOCK_SIZE, spheresB.size() - start);
+            for (int i = 0; i < blockSize; i++) {
+                float dx = x[start + i] - centerA.x;
+                float dy = y[start + i] - centerA.y;
+                float dz = z[start + i] - centerA.z;
+                float distanceSquared = dx * dx + dy * dy + dz * dz;
+                float totalRadius = radiusA + radii[start + i];
+                distancesSquared[i] = distanceSquared;
+                overlaps[i] = totalRadius * totalRadius - distanceSquared;
+            }
+            for (int i = 0; i < blockSize; i++) {
+                if (overlaps[i] <= 0.f) {
+                    continue;
+                }
+                ShapeContact* contact = contacts.getNewContact();
+                if (!contact) {
+                    return contacts.size() - startSize;
+                }
+                int b = start + i;
+                glm::vec3 BA = spheresB.getCenter(b) - centerA;
+                float totalRadius = radiusA + radii[b];
+                float distance = sqrtf(distancesSquared[i]);
+                if (distance < EPSILON) {
+                    // the spheres are on top of each other, so we pick an arbitrary penetration direction
+                    BA = glm::vec3(0.f, 1.f, 0.f);
+                    distance = totalRadius;
+                } else {
+                    BA /= distance;
+                }
+                contact->indexA = a;
+                contact->indexB = b;
+                contact->penetration = BA * (totalRadius - distance);
+                contact->contactPoint = centerA + radiusA * BA;
+            }
+        }
+    }
+    return contacts.size() - startSize;
+}
+
+int sphereCapsuleBatch(const SphereBatch& spheresA, const CapsuleBatch& capsulesB, ContactBuffer& contacts) {
+    int startSize = contacts.size();
+    const float* x = capsulesB.x();
+    const float* y = capsulesB.y();
+    const float* z = capsulesB.z();
+    const float* axisX = capsulesB.axisX();
+    const float* axisY = capsulesB.axisY();
+    const float* axisZ = capsulesB.axisZ();
+    const float* halfHeights = capsulesB.halfHeights();
+    const float* radii = capsulesB.radii();
+    float axialDistances[COLLISION_BLOCK_SIZE];
+    float radialDistancesSquared[COLLISION_BLOCK_SIZE];
+    int touches[COLLISION_BLOCK_SIZE];
+
+    for (int a = 0; a < spheresA.size(); a++) {
+        glm::vec3 centerA = spheresA.getCenter(a);
+        float radiusA = spheresA.getRadius(a);
+
+        for (int start = 0; start < capsulesB.size(); start += COLLISION_BLOCK_SIZE) {
+            int blockSize = glm::min(COLLISION_BLOCK_SIZE, capsulesB.size() - start);
+            for (int i = 0; i < blockSize; i++) {
+                // sphereCapsule's tests, with the cap case folded in by clamping to the capsule's segment
+                float bx = x[start + i] - centerA.x;
+                float by = y[start + i] - centerA.y;
+                float bz = z[start + i] - centerA.z;
+                float axialDistance = -(bx * axisX[start + i] + by * axisY[start + i] + bz * axisZ[start + i]);
+                float halfHeight = halfHeights[start + i];
+                float clampedDistance = glm::min(glm::max(axialDistance, -halfHeight), halfHeight);
+                float rx = bx + clampedDistance * axisX[start + i];
+                float ry = by + clampedDistance * axisY[start + i];
+                float rz = bz + clampedDistance * axisZ[start + i];
+                float radialDistanceSquared = rx * rx + ry * ry + rz * rz;
+                float totalRadius = radiusA + radii[start + i];
+                axialDistances[i] = axialDistance;
+                radialDistancesSquared[i] = radialDistanceSquared;
+                touches[i] = (fabsf(axialDistance) < totalRadius + halfHeight) &
+                    (radialDistanceSquared <= totalRadius * totalRadius);
+            }
+            for (int i = 0; i < blockSize; i++) {
+                if (!touches[i]) {
+                    continue;
+                }
+                int b = start + i;
+                glm::vec3 capsuleAxis = capsulesB.getAxis(b);
+                float halfHeight = halfHeights[b];
+                float totalRadius = radiusA + radii[b];
+                float axialDistance = axialDistances[i];
+                float absAxialDistance = fabsf(axialDistance);
+                ShapeContact* contact;
+                if (radialDistancesSquared[i] > EPSILON * EPSILON) {
+                    contact = contacts.getNewContact();
+                    if (!contact) {
+                        return contacts.size() - startSize;
+                    }
+                    float clampedDistance = glm::min(glm::max(axialDistance, -halfHeight), halfHeight);
+                    glm::vec3 radialAxis = capsulesB.getCenter(b) - centerA + clampedDistance * capsuleAxis;
+                    float radialDistance = sqrtf(radialDistancesSquared[i]);
+                    radialAxis /= radialDistance;
+                    contact->penetration = (totalRadius - radialDistance) * radialAxis;
+                    contact->contactPoint = centerA + radiusA * radialAxis;
+
+                } else {
+                    // A is on B's axis: the cylinder case doesn't count, as in sphereCapsule
+                    if (absAxialDistance > halfHeight) {
+                        continue;
+                    }
+                    contact = contacts.getNewContact();
+                    if (!contact) {
+                        return contacts.size() - startSize;
+                    }
+                    if (axialDistance < 0.f) {
+                        capsuleAxis *= -1;
+                    }
+                    float sign = (axialDistance > 0.f) ? -1.f : 1.f;
+                    contact->penetration = (sign * (totalRadius + halfHeight - absAxialDistance)) * capsuleAxis;
+                    contact->contactPoint = centerA + (sign * radiusA) * capsuleAxis;
+                }
+                contact->indexA = a;
+                contact->indexB = b;
+            }
+        }
+    }
+    return contacts.size() - startSize;
+}
+
 }   // namespace ShapeCollider
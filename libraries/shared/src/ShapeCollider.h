@@ -12,6 +12,7 @@
 #include "CapsuleShape.h"
 #include "CollisionInfo.h"
 #include "ListShape.h"
+#include "ShapeBatch.h"
 #include "SharedUtil.h" 
 #include "SphereShape.h"
 
@@ -77,6 +78,23 @@ namespace ShapeCollider {
     /// \return true if shapes collide
     bool listList(const ListShape* listA, const ListShape* listB, CollisionList& collisions);
 
+    // The batched colliders test each shape of A against every shape of B, a block of B at a time. The tests for a
+    // block are one loop over B's arrays, and only the pairs that touch are worked up into contacts, with the same
+    // results as the scalar colliders. Nothing here is hand vectorized, and no caller uses them yet; ShapeBatchTests
+    // measures them against shapeShape. They stop when the buffer fills.
+
+    /// \param spheresA the first shapes
+    /// \param spheresB the second shapes
+    /// \param[out] contacts where to append the contacts, as sphereSphere would find them
+    /// \return the number of contacts appended
+    int sphereSphereBatch(const SphereBatch& spheresA, const SphereBatch& spheresB, ContactBuffer& contacts);
+
+    /// \param spheresA the first shapes
+    /// \param capsulesB the second shapes
+    /// \param[out] contacts where to append the contacts, as sphereCapsule would find them
+    /// \return the number of contacts appended
+    int sphereCapsuleBatch(const SphereBatch& spheresA, const CapsuleBatch& capsulesB, ContactBuffer& contacts);
+
 }   // namespace ShapeCollider
 
 #endif // __hifi__ShapeCollider__
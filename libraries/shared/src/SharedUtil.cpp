@@ -478,7 +478,7 @@ int packFloatScalarToSignedTwoByteFixed(unsigned char* buffer, float scalar, int
     return sizeof(uint16_t);
 }
 
-int unpackFloatScalarFromSignedTwoByteFixed(int16_t* byteFixedPointer, float* destinationPointer, int radix) {
+int unpackFloatScalarFromSignedTwoByteFixed(const int16_t* byteFixedPointer, float* destinationPointer, int radix) {
     *destinationPointer = *byteFixedPointer / (float)(1 << radix);
     return sizeof(int16_t);
 }
@@ -538,6 +538,62 @@ int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatO
     return sizeof(quatParts);
 }
 
+const int SMALLEST_THREE_BITS = 15;
+const float SMALLEST_THREE_LIMIT = 0.70710678f; // 1/sqrt(2), the largest the other components can be
+
+int packOrientationQuatToSixBytes(unsigned char* buffer, const glm::quat& quatInput) {
+    float components[4] = { quatInput.x, quatInput.y, quatInput.z, quatInput.w };
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(components[i]) > fabsf(components[largest])) {
+            largest = i;
+        }
+    }
+    // q and -q are the same orientation, so flip the quat to make the dropped component positive
+    float sign = (components[largest] < 0.f) ? -1.f : 1.f;
+
+    const float QUAT_PART_CONVERSION_RATIO = ((1 << SMALLEST_THREE_BITS) - 1) / (2.f * SMALLEST_THREE_LIMIT);
+    uint16_t quatParts[3];
+    for (int i = 0, part = 0; i < 4; i++) {
+        if (i != largest) {
+            float component = glm::clamp(sign * components[i], -SMALLEST_THREE_LIMIT, SMALLEST_THREE_LIMIT);
+            quatParts[part++] = floorf((component + SMALLEST_THREE_LIMIT) * QUAT_PART_CONVERSION_RATIO + 0.5f);
+        }
+    }
+    // the index of the dropped component goes in the top bits of the first two parts
+    quatParts[0] |= (largest & 1) << SMALLEST_THREE_BITS;
+    quatParts[1] |= (largest >> 1) << SMALLEST_THREE_BITS;
+
+    memcpy(buffer, &quatParts, sizeof(quatParts));
+    return sizeof(quatParts);
+}
+
+int unpackOrientationQuatFromSixBytes(const unsigned char* buffer, glm::quat& quatOutput) {
+    uint16_t quatParts[3];
+    memcpy(&quatParts, buffer, sizeof(quatParts));
+
+    const uint16_t PART_MASK = (1 << SMALLEST_THREE_BITS) - 1;
+    int largest = (quatParts[0] >> SMALLEST_THREE_BITS) | ((quatParts[1] >> SMALLEST_THREE_BITS) << 1);
+
+    float components[4];
+    float sumOfSquares = 0.f;
+    for (int i = 0, part = 0; i < 4; i++) {
+        if (i != largest) {
+            components[i] = ((quatParts[part++] & PART_MASK) / (float)PART_MASK) * 2.f * SMALLEST_THREE_LIMIT
+                - SMALLEST_THREE_LIMIT;
+            sumOfSquares += components[i] * components[i];
+        }
+    }
+    components[largest] = sqrtf(std::max(0.f, 1.f - sumOfSquares));
+
+    quatOutput.x = components[0];
+    quatOutput.y = components[1];
+    quatOutput.z = components[2];
+    quatOutput.w = components[3];
+
+    return sizeof(quatParts);
+}
+
 float SMALL_LIMIT = 10.f;
 float LARGE_LIMIT = 1000.f;
 
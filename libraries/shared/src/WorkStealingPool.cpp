@@ -0,0 +1,153 @@
+//
+//  WorkStealingPool.cpp
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QMutexLocker>
+
+#include "WorkStealingPool.h"
+
+WorkStealingTask::WorkStealingTask() :
+    _group(NULL)
+{
+}
+
+WorkStealingTask::~WorkStealingTask() {
+}
+
+WorkStealingGroup::WorkStealingGroup() :
+    _pendingTasks(0)
+{
+}
+
+WorkStealingPool::Worker::Worker(WorkStealingPool* pool, int queue) :
+    _pool(pool),
+    _queue(queue)
+{
+}
+
+void WorkStealingPool::Worker::run() {
+    _pool->workerLoop(_queue);
+}
+
+WorkStealingPool* WorkStealingPool::getInstance() {
+    static WorkStealingPool instance(qMax(QThread::idealThreadCount() - 1, 0));
+    return &instance;
+}
+
+WorkStealingPool::WorkStealingPool(int workerCount) :
+    _queuedTaskCount(0),
+    _isStopping(false)
+{
+    _queues.append(new TaskQueue());
+    for (int i = 0; i < workerCount; i++) {
+        _queues.append(new TaskQueue());
+        _workers.append(new Worker(this, _queues.size() - 1));
+    }
+    foreach (Worker* worker, _workers) {
+        worker->start();
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        QMutexLocker locker(&_idleMutex);
+        _isStopping = true;
+        _taskQueued.wakeAll();
+    }
+    foreach (Worker* worker, _workers) {
+        worker->wait();
+        delete worker;
+    }
+    foreach (TaskQueue* queue, _queues) {
+        delete queue;
+    }
+}
+
+void WorkStealingPool::start(WorkStealingTask* task, WorkStealingGroup& group) {
+    task->_group = &group;
+    group._pendingTasks.ref();
+
+    // counted before it's queued so the count never goes negative when the task is taken straight away
+    _queuedTaskCount.ref();
+    TaskQueue* queue = _queues.at(currentQueue());
+    queue->mutex.lock();
+    queue->tasks.append(task);
+    queue->mutex.unlock();
+
+    // idle workers check the count with the idle lock held, so taking it here means the wake can't be missed
+    QMutexLocker locker(&_idleMutex);
+    _taskQueued.wakeOne();
+    _taskQueuedOrGroupDone.wakeAll();
+}
+
+void WorkStealingPool::wait(WorkStealingGroup& group) {
+    int queue = currentQueue();
+    while (!group.isDone()) {
+        WorkStealingTask* task = takeTask(queue);
+        if (task) {
+            runTask(task);
+            continue;
+        }
+        // whatever is left of the group is running on other threads; sleep until a group finishes or there's more to
+        // run. Both are signaled with the idle lock held, so checking under it means neither wake can be missed
+        QMutexLocker locker(&_idleMutex);
+        while (!group.isDone() && _queuedTaskCount.loadAcquire() == 0) {
+            _taskQueuedOrGroupDone.wait(&_idleMutex);
+        }
+    }
+}
+
+int WorkStealingPool::currentQueue() const {
+    return _workerQueues.hasLocalData() ? _workerQueues.localData() : 0;
+}
+
+WorkStealingTask* WorkStealingPool::takeTask(int queue) {
+    TaskQueue* ownQueue = _queues.at(queue);
+    {
+        QMutexLocker locker(&ownQueue->mutex);
+        if (!ownQueue->tasks.isEmpty()) {
+            _queuedTaskCount.deref();
+            return ownQueue->tasks.takeLast();
+        }
+    }
+    for (int i = 1; i < _queues.size(); i++) {
+        TaskQueue* victim = _queues.at((queue + i) % _queues.size());
+        QMutexLocker locker(&victim->mutex);
+        if (!victim->tasks.isEmpty()) {
+            _queuedTaskCount.deref();
+            return victim->tasks.takeFirst();
+        }
+    }
+    return NULL;
+}
+
+void WorkStealingPool::runTask(WorkStealingTask* task) {
+    // once the count drops the waiter may destroy both the task and the group, so neither can be touched after
+    WorkStealingGroup* group = task->_group;
+    task->run();
+    if (!group->_pendingTasks.deref()) {
+        QMutexLocker locker(&_idleMutex);
+        _taskQueuedOrGroupDone.wakeAll();
+    }
+}
+
+void WorkStealingPool::workerLoop(int queue) {
+    _workerQueues.setLocalData(queue);
+    while (true) {
+        WorkStealingTask* task = takeTask(queue);
+        if (task) {
+            runTask(task);
+            continue;
+        }
+        QMutexLocker locker(&_idleMutex);
+        while (_queuedTaskCount.loadAcquire() == 0 && !_isStopping) {
+            _taskQueued.wait(&_idleMutex);
+        }
+        if (_isStopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+//
+//  WorkStealingPool.h
+//  hifi
+//
+//  Copyright (c) 2014 HighFidelity, Inc. All rights reserved.
+//
+//  Fork-join thread pool where each worker keeps its own queue and steals from the others when it runs dry
+//
+
+#ifndef __hifi__WorkStealingPool__
+#define __hifi__WorkStealingPool__
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+class WorkStealingGroup;
+
+/// A unit of work run by the pool. The pool never owns tasks, whoever starts one keeps it alive until its group is waited
+/// on, which usually means it lives on the starter's stack.
+class WorkStealingTask {
+public:
+    WorkStealingTask();
+    virtual ~WorkStealingTask();
+
+    virtual void run() = 0;
+
+private:
+    friend class WorkStealingPool;
+    WorkStealingGroup* _group;
+};
+
+/// The tasks started by one caller, which that caller then waits on.
+class WorkStealingGroup {
+public:
+    WorkStealingGroup();
+
+    bool isDone() const { return _pendingTasks.loadAcquire() == 0; }
+
+private:
+    friend class WorkStealingPool;
+    QAtomicInt _pendingTasks;
+};
+
+/// Runs tasks on a fixed set of worker threads. Tasks started from a worker go on the back of that worker's queue and the
+/// worker takes from the back, so nested work stays depth first and cache warm; idle workers steal from the front of the
+/// other queues, which is where the biggest pieces of work are. Waiting on a group runs queued tasks, and only sleeps when
+/// there are none, so tasks can start and wait on tasks of their own without tying up the pool.
+class WorkStealingPool {
+public:
+    /// \return the process wide pool, with a worker per core besides the calling thread
+    static WorkStealingPool* getInstance();
+
+    WorkStealingPool(int workerCount);
+    ~WorkStealingPool();
+
+    int getWorkerCount() const { return _workers.size(); }
+
+    /// Queues the task as part of the group.
+    void start(WorkStealingTask* task, WorkStealingGroup& group);
+
+    /// Runs queued tasks until every task in the group has finished, sleeping while the last of them run elsewhere.
+    void wait(WorkStealingGroup& group);
+
+private:
+    class Worker : public QThread {
+    public:
+        Worker(WorkStealingPool* pool, int queue);
+    protected:
+        virtual void run();
+    private:
+        WorkStealingPool* _pool;
+        int _queue;
+    };
+
+    class TaskQueue {
+    public:
+        QMutex mutex;
+        QList<WorkStealingTask*> tasks;
+    };
+
+    int currentQueue() const;
+    WorkStealingTask* takeTask(int queue);
+    void runTask(WorkStealingTask* task);
+    void workerLoop(int queue);
+
+    QVector<TaskQueue*> _queues; // the first is shared by threads outside the pool, then one per worker
+    QVector<Worker*> _workers;
+    QThreadStorage<int> _workerQueues;
+
+    QAtomicInt _queuedTaskCount;
+    QMutex _idleMutex;
+    QWaitCondition _taskQueued;
+    QWaitCondition _taskQueuedOrGroupDone; // for threads in wait(), when a task is queued or a group finishes
+    bool _isStopping;
+};
+
+#endif /* defined(__hifi__WorkStealingPool__) */
@@ -36,9 +36,10 @@ public:
     /// call this to inform the VoxelEditPacketSender of the voxel server jurisdictions. This is required for normal operation.
     /// The internal contents of the jurisdiction map may change throughout the lifetime of the VoxelEditPacketSender. This map
     /// can be set prior to voxel servers being present, so long as the contents of the map accurately reflect the current
-    /// known jurisdictions.
-    void setVoxelServerJurisdictions(NodeToJurisdictionMap* voxelServerJurisdictions) { 
-        setServerJurisdictions(voxelServerJurisdictions);
+    /// known jurisdictions, and the version must be bumped after every change to them.
+    void setVoxelServerJurisdictions(NodeToJurisdictionMap* voxelServerJurisdictions,
+                                     const QAtomicInt* voxelServerJurisdictionsVersion) {
+        setServerJurisdictions(voxelServerJurisdictions, voxelServerJurisdictionsVersion);
     }
 
     // is there a voxel server available to send packets to    
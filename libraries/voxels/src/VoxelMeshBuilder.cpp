@@ -0,0 +1,359 @@
+//
+//  VoxelMeshBuilder.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSet>
+
+#include <OctalCode.h>
+#include <SharedUtil.h>
+#include <WorkStealingPool.h>
+
+#include "VoxelMeshBuilder.h"
+#include "VoxelTree.h"
+
+const int FACES_PER_VOXEL = 6;
+const int CORNERS_PER_FACE = 4;
+const int CHUNK_KEY_BITS = 10;
+
+static const signed char FACE_NORMALS[FACES_PER_VOXEL][3] = {
+    { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+};
+
+// each face's corners, counterclockwise seen from outside so back face culling works
+static const unsigned char FACE_CORNERS[FACES_PER_VOXEL][CORNERS_PER_FACE][3] = {
+    { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },
+    { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+    { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+    { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+    { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+    { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } }
+};
+
+const signed char BYTE_NORMAL_SCALE = 127;
+
+// whether a leaf with content, at least as big as the given scale, holds the point
+static bool isCoveredAt(OctreeElement* root, const glm::vec3& point, float scale) {
+    if (!root->getAABox().contains(point)) {
+        return false;
+    }
+    OctreeElement* element = root;
+    while (!element->isLeaf()) {
+        // an element the voxel's size with children only covers part of the face
+        const float SAME_SCALE_TOLERANCE = 1.5f;
+        if (element->getScale() < scale * SAME_SCALE_TOLERANCE) {
+            return false;
+        }
+        glm::vec3 center = element->getAABox().calcCenter();
+        int childIndex = (point.x >= center.x ? 4 : 0) | (point.y >= center.y ? 2 : 0) | (point.z >= center.z ? 1 : 0);
+        element = element->getChildAtIndex(childIndex);
+        if (!element) {
+            return false;
+        }
+    }
+    return element->hasContent();
+}
+
+void appendVoxelFaces(VoxelTreeElement* root, VoxelTreeElement* voxel, VoxelMesh& mesh) {
+    const glm::vec3& corner = voxel->getCorner();
+    float scale = voxel->getScale();
+    glm::vec3 center = corner + glm::vec3(scale, scale, scale) * 0.5f;
+    const nodeColor& color = voxel->getColor();
+
+    for (int face = 0; face < FACES_PER_VOXEL; face++) {
+        glm::vec3 normal(FACE_NORMALS[face][0], FACE_NORMALS[face][1], FACE_NORMALS[face][2]);
+        if (isCoveredAt(root, center + normal * scale, scale)) {
+            mesh.culledFaceCount++;
+            continue;
+        }
+        for (int i = 0; i < CORNERS_PER_FACE; i++) {
+            VoxelMeshVertex vertex;
+            for (int axis = 0; axis < 3; axis++) {
+                vertex.position[axis] = corner[axis] + FACE_CORNERS[face][i][axis] * scale;
+                vertex.normal[axis] = FACE_NORMALS[face][axis] * BYTE_NORMAL_SCALE;
+            }
+            vertex.color[0] = color[RED_INDEX];
+            vertex.color[1] = color[GREEN_INDEX];
+            vertex.color[2] = color[BLUE_INDEX];
+            mesh.vertices.append(vertex);
+        }
+    }
+    mesh.voxelCount++;
+}
+
+// Walks down to the chunk level, meshing what renders above it and collecting the regions at it.
+class ChunkLevelVisitor {
+public:
+    ChunkLevelVisitor(VoxelTreeElement* root, int chunkLevel, const ViewFrustum& viewFrustum, float voxelSizeScale,
+                      int boundaryLevelAdjust, quint64 topBuiltAt) :
+        root(root),
+        chunkLevel(chunkLevel),
+        viewFrustum(viewFrustum),
+        voxelSizeScale(voxelSizeScale),
+        boundaryLevelAdjust(boundaryLevelAdjust),
+        topBuiltAt(topBuiltAt),
+        topChanged(false),
+        topMesh(new VoxelMesh()) {
+        topMesh->bounds = root->getAABox();
+    }
+
+    bool visit(OctreeElement* element) {
+        if (element->getLevel() >= chunkLevel) {
+            regions.append(static_cast<VoxelTreeElement*>(element));
+            return false;
+        }
+        topChanged |= element->hasChangedSince(topBuiltAt);
+        if (element->calculateShouldRender(&viewFrustum, voxelSizeScale, boundaryLevelAdjust)) {
+            appendVoxelFaces(root, static_cast<VoxelTreeElement*>(element), *topMesh);
+        }
+        return true;
+    }
+
+    VoxelTreeElement* root;
+    int chunkLevel;
+    const ViewFrustum& viewFrustum;
+    float voxelSizeScale;
+    int boundaryLevelAdjust;
+    quint64 topBuiltAt;
+    bool topChanged;
+    QSharedPointer<VoxelMesh> topMesh;
+    QVector<VoxelTreeElement*> regions;
+};
+
+class ChangedSinceVisitor {
+public:
+    ChangedSinceVisitor(quint64 since) : since(since), changed(false) { }
+    bool visit(OctreeElement* element) {
+        changed |= element->hasChangedSince(since);
+        return !changed;
+    }
+    quint64 since;
+    bool changed;
+};
+
+class RegionMeshVisitor {
+public:
+    RegionMeshVisitor(VoxelTreeElement* root, const ViewFrustum& viewFrustum, float voxelSizeScale,
+                      int boundaryLevelAdjust, VoxelMesh& mesh) :
+        root(root),
+        viewFrustum(viewFrustum),
+        voxelSizeScale(voxelSizeScale),
+        boundaryLevelAdjust(boundaryLevelAdjust),
+        mesh(mesh) { }
+
+    bool visit(OctreeElement* element) {
+        if (element->calculateShouldRender(&viewFrustum, voxelSizeScale, boundaryLevelAdjust)) {
+            appendVoxelFaces(root, static_cast<VoxelTreeElement*>(element), mesh);
+        }
+        return true;
+    }
+
+    VoxelTreeElement* root;
+    const ViewFrustum& viewFrustum;
+    float voxelSizeScale;
+    int boundaryLevelAdjust;
+    VoxelMesh& mesh;
+};
+
+// Checks a region for changes, or builds its mesh. Each task only reads the tree, which the builder's caller has locked.
+class RegionTask : public WorkStealingTask {
+public:
+    RegionTask() : tree(NULL), region(NULL), key(0), viewFrustum(NULL), voxelSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
+        boundaryLevelAdjust(0), checkOnly(false), since(0), changed(false) { }
+
+    virtual void run() {
+        if (checkOnly) {
+            ChangedSinceVisitor visitor(since);
+            tree->visitSubTree(region, visitor);
+            changed = visitor.changed;
+            return;
+        }
+        mesh = QSharedPointer<VoxelMesh>(new VoxelMesh());
+        mesh->bounds = region->getAABox();
+        RegionMeshVisitor visitor(tree->getRoot(), *viewFrustum, voxelSizeScale, boundaryLevelAdjust, *mesh);
+        tree->visitSubTree(region, visitor);
+    }
+
+    VoxelTree* tree;
+    VoxelTreeElement* region;
+    int key;
+    const ViewFrustum* viewFrustum;
+    float voxelSizeScale;
+    int boundaryLevelAdjust;
+
+    bool checkOnly;
+    quint64 since;
+    bool changed;
+    QSharedPointer<VoxelMesh> mesh;
+};
+
+VoxelMeshBuilder::VoxelMeshBuilder(int chunkLevel, WorkStealingPool* pool) :
+    _chunkLevel(qMin(chunkLevel, MAX_VOXEL_MESH_CHUNK_LEVEL)),
+    _pool(pool ? pool : WorkStealingPool::getInstance()),
+    _lastBuildUsecs(0) {
+}
+
+int VoxelMeshBuilder::build(VoxelTree* tree, const ViewFrustum& viewFrustum, float voxelSizeScale,
+                            int boundaryLevelAdjust, bool rebuildAll) {
+    QMutexLocker buildLocker(&_buildMutex);
+    quint64 start = usecTimestampNow();
+
+    // when each region was last built, and which regions there were
+    QHash<int, quint64> builtAt;
+    {
+        QMutexLocker locker(&_chunksMutex);
+        for (QHash<int, Chunk>::const_iterator it = _chunks.constBegin(); it != _chunks.constEnd(); it++) {
+            builtAt.insert(it.key(), it.value().builtAt);
+        }
+    }
+
+    ChunkLevelVisitor chunkLevelVisitor(tree->getRoot(), _chunkLevel, viewFrustum, voxelSizeScale, boundaryLevelAdjust,
+                                        builtAt.value(VOXEL_MESH_TOP_CHUNK, 0));
+    tree->visitTree(chunkLevelVisitor);
+    const QVector<VoxelTreeElement*>& regions = chunkLevelVisitor.regions;
+
+    QVector<RegionTask> tasks(regions.size());
+    for (int i = 0; i < regions.size(); i++) {
+        RegionTask& task = tasks[i];
+        task.tree = tree;
+        task.region = regions.at(i);
+        task.key = chunkKey(task.region->getCorner());
+        task.viewFrustum = &viewFrustum;
+        task.voxelSizeScale = voxelSizeScale;
+        task.boundaryLevelAdjust = boundaryLevelAdjust;
+    }
+
+    // find the regions that changed, then add their neighbors, whose faces against them may have come or gone
+    QSet<int> rebuildKeys;
+    if (!rebuildAll) {
+        WorkStealingGroup checkGroup;
+        for (int i = 0; i < tasks.size(); i++) {
+            RegionTask& task = tasks[i];
+            if (!builtAt.contains(task.key)) {
+                task.changed = true;
+                continue;
+            }
+            task.checkOnly = true;
+            task.since = builtAt.value(task.key);
+            _pool->start(&task, checkGroup);
+        }
+        _pool->wait(checkGroup);
+
+        const int keyMask = (1 << CHUNK_KEY_BITS) - 1;
+        for (int i = 0; i < tasks.size(); i++) {
+            const RegionTask& task = tasks.at(i);
+            if (!task.changed) {
+                continue;
+            }
+            rebuildKeys.insert(task.key);
+            for (int axis = 0; axis < 3; axis++) {
+                int shift = axis * CHUNK_KEY_BITS;
+                int coordinate = (task.key >> shift) & keyMask;
+                if (coordinate > 0) {
+                    rebuildKeys.insert(task.key - (1 << shift));
+                }
+                if (coordinate < keyMask) {
+                    rebuildKeys.insert(task.key + (1 << shift));
+                }
+            }
+        }
+    }
+
+    WorkStealingGroup buildGroup;
+    int regionsBuilt = 0;
+    for (int i = 0; i < tasks.size(); i++) {
+        RegionTask& task = tasks[i];
+        if (rebuildAll || rebuildKeys.contains(task.key)) {
+            task.checkOnly = false;
+            _pool->start(&task, buildGroup);
+            regionsBuilt++;
+        }
+    }
+    _pool->wait(buildGroup);
+
+    for (int i = 0; i < tasks.size(); i++) {
+        const RegionTask& task = tasks.at(i);
+        builtAt.remove(task.key);
+        if (task.mesh) {
+            publish(task.key, task.mesh, start);
+        }
+    }
+    bool hadTop = builtAt.contains(VOXEL_MESH_TOP_CHUNK);
+    builtAt.remove(VOXEL_MESH_TOP_CHUNK);
+    if (rebuildAll || chunkLevelVisitor.topChanged || !hadTop) {
+        publish(VOXEL_MESH_TOP_CHUNK, chunkLevelVisitor.topMesh, start);
+    }
+
+    // whatever's left were regions that are no longer in the tree
+    for (QHash<int, quint64>::const_iterator it = builtAt.constBegin(); it != builtAt.constEnd(); it++) {
+        publish(it.key(), VoxelMeshPointer(), start);
+    }
+
+    _lastBuildUsecs = usecTimestampNow() - start;
+    return regionsBuilt;
+}
+
+void VoxelMeshBuilder::swapMeshes(QVector<VoxelMeshUpdate>& updates) {
+    QMutexLocker locker(&_chunksMutex);
+    QHash<int, Chunk>::iterator it = _chunks.begin();
+    while (it != _chunks.end()) {
+        Chunk& chunk = it.value();
+        if (!chunk.hasPending) {
+            it++;
+            continue;
+        }
+        VoxelMeshUpdate update;
+        update.key = it.key();
+        update.mesh = chunk.pending;
+        updates.append(update);
+
+        if (!chunk.pending) {
+            it = _chunks.erase(it);
+            continue;
+        }
+        chunk.current = chunk.pending;
+        chunk.pending.clear();
+        chunk.hasPending = false;
+        it++;
+    }
+}
+
+void VoxelMeshBuilder::reset() {
+    QMutexLocker buildLocker(&_buildMutex);
+    QMutexLocker locker(&_chunksMutex);
+    for (QHash<int, Chunk>::iterator it = _chunks.begin(); it != _chunks.end(); it++) {
+        it.value().pending.clear();
+        it.value().hasPending = true;
+        it.value().builtAt = 0;
+    }
+}
+
+int VoxelMeshBuilder::getFaceCount() const {
+    QMutexLocker locker(&_chunksMutex);
+    int faceCount = 0;
+    for (QHash<int, Chunk>::const_iterator it = _chunks.constBegin(); it != _chunks.constEnd(); it++) {
+        if (it.value().current) {
+            faceCount += it.value().current->getFaceCount();
+        }
+    }
+    return faceCount;
+}
+
+int VoxelMeshBuilder::chunkKey(const glm::vec3& corner) const {
+    float chunksPerSide = (float)(1 << (_chunkLevel - 1));
+    int x = (int)(corner.x * chunksPerSide + 0.5f);
+    int y = (int)(corner.y * chunksPerSide + 0.5f);
+    int z = (int)(corner.z * chunksPerSide + 0.5f);
+    return (x << (2 * CHUNK_KEY_BITS)) | (y << CHUNK_KEY_BITS) | z;
+}
+
+void VoxelMeshBuilder::publish(int key, const VoxelMeshPointer& mesh, quint64 builtAt) {
+    QMutexLocker locker(&_chunksMutex);
+    Chunk& chunk = _chunks[key];
+    chunk.pending = mesh;
+    chunk.hasPending = true;
+    chunk.builtAt = builtAt;
+}
@@ -0,0 +1,121 @@
+//
+//  VoxelMeshBuilder.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Builds the faces of a voxel tree into per region meshes on worker threads, ready for the renderer to upload
+//
+
+#ifndef __hifi__VoxelMeshBuilder__
+#define __hifi__VoxelMeshBuilder__
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+
+#include <AABox.h>
+#include <ViewFrustum.h>
+
+class VoxelTree;
+class VoxelTreeElement;
+class WorkStealingPool;
+
+/// The level of the elements the tree is split into regions at, each a 256 meter cube.
+const int DEFAULT_VOXEL_MESH_CHUNK_LEVEL = 7;
+
+/// Regions are keyed by their coordinates at the chunk level, ten bits each, so that's as deep as they can go.
+const int MAX_VOXEL_MESH_CHUNK_LEVEL = 11;
+
+/// The key of the mesh for elements that render above the chunk level, which are few and far away.
+const int VOXEL_MESH_TOP_CHUNK = -1;
+
+/// A corner of a face, interleaved so that a mesh is a single buffer: drawn as GL_QUADS, with the position in the tree's
+/// 0 to 1 units, the normal as GL_BYTE and the color as GL_UNSIGNED_BYTE.
+class VoxelMeshVertex {
+public:
+    float position[3];
+    signed char normal[3];
+    unsigned char color[3];
+};
+
+/// The visible faces of one region of the tree.
+class VoxelMesh {
+public:
+    VoxelMesh() : voxelCount(0), culledFaceCount(0) { }
+
+    int getFaceCount() const { return vertices.size() / 4; }
+
+    AABox bounds;
+    QVector<VoxelMeshVertex> vertices; // four per face
+    int voxelCount;
+    int culledFaceCount; // faces left out because a neighboring voxel covers them
+};
+
+typedef QSharedPointer<const VoxelMesh> VoxelMeshPointer;
+
+/// A region's mesh as handed to the renderer. A null mesh means the region is gone and its buffer can be freed.
+class VoxelMeshUpdate {
+public:
+    int key;
+    VoxelMeshPointer mesh;
+};
+
+/// Splits the tree into regions at the chunk level and builds each region's mesh as a task on a WorkStealingPool, with the
+/// faces that voxels share already left out. Regions are double buffered: a build only ever replaces a region's pending
+/// mesh, and the renderer takes the pending meshes with swapMeshes, so neither waits on the other for more than a pointer
+/// copy. Whichever element VoxelSystem would render is meshed, by the same calculateShouldRender test.
+class VoxelMeshBuilder {
+public:
+    /// \param pool the pool to build on, or NULL for the process wide one
+    VoxelMeshBuilder(int chunkLevel = DEFAULT_VOXEL_MESH_CHUNK_LEVEL, WorkStealingPool* pool = NULL);
+
+    int getChunkLevel() const { return _chunkLevel; }
+
+    /// Rebuilds the meshes of the regions that changed since they were last built, along with their neighbors whose
+    /// shared faces may have changed, or of every region for a new view or level of detail. Returns once they're all
+    /// built. The caller holds at least a read lock on the tree throughout.
+    /// \return the number of regions built
+    int build(VoxelTree* tree, const ViewFrustum& viewFrustum, float voxelSizeScale, int boundaryLevelAdjust,
+              bool rebuildAll);
+
+    /// Called by the renderer to take the meshes built since it last asked, making them the regions' current meshes.
+    void swapMeshes(QVector<VoxelMeshUpdate>& updates);
+
+    /// Forgets every region, so the next build builds them all and the next swap drops the ones that are gone.
+    void reset();
+
+    /// \return the number of faces in the regions' current meshes
+    int getFaceCount() const;
+
+    quint64 getLastBuildUsecs() const { return _lastBuildUsecs; }
+
+private:
+    class Chunk {
+    public:
+        Chunk() : hasPending(false), builtAt(0) { }
+        VoxelMeshPointer current; // the renderer's
+        VoxelMeshPointer pending; // the newest build, until the renderer swaps it in
+        bool hasPending;
+        quint64 builtAt;
+    };
+
+    int chunkKey(const glm::vec3& corner) const;
+    void publish(int key, const VoxelMeshPointer& mesh, quint64 builtAt);
+
+    int _chunkLevel;
+    WorkStealingPool* _pool;
+
+    QMutex _buildMutex; // one build at a time
+    mutable QMutex _chunksMutex; // held just long enough to move pointers
+    QHash<int, Chunk> _chunks;
+    quint64 _lastBuildUsecs;
+};
+
+/// Adds the visible faces of an element to a mesh, leaving out those against a leaf with content at least as big: the
+/// faces VoxelSystem::cullSharedFaces hides.
+/// \param root the element to look for neighbors under, usually the tree's root
+void appendVoxelFaces(VoxelTreeElement* root, VoxelTreeElement* voxel, VoxelMesh& mesh);
+
+#endif /* defined(__hifi__VoxelMeshBuilder__) */
@@ -0,0 +1,256 @@
+//
+//  VoxelSVOStream.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+
+#include <OctalCode.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+
+#include "VoxelSVOStream.h"
+
+bool VoxelSVOCell::fromOctalCode(const unsigned char* octalCode, VoxelSVOCell& cell) {
+    // checked before asking for the length, so a code long enough to need more than one length byte is refused too
+    if (*octalCode > MAX_SVO_STREAM_LEVELS) {
+        return false;
+    }
+    int length = numberOfThreeBitSectionsInCode(octalCode);
+    cell = VoxelSVOCell();
+    for (int section = 0; section < length; section++) {
+        cell = cell.getChild(getOctalCodeSectionValue(octalCode, section));
+    }
+    return true;
+}
+
+bool VoxelSVOCell::contains(const VoxelSVOCell& other) const {
+    if (other.level < level) {
+        return false;
+    }
+    int shift = other.level - level;
+    return (other.x >> shift) == x && (other.y >> shift) == y && (other.z >> shift) == z;
+}
+
+void VoxelSVOCell::appendOctalCode(QByteArray& output) const {
+    int start = output.size();
+    int codeLength = bytesRequiredForCodeLength(level);
+    output.resize(start + codeLength);
+    unsigned char* octalCode = (unsigned char*)output.data() + start;
+    memset(octalCode, 0, codeLength);
+    octalCode[0] = level;
+
+    for (int section = 0; section < level; section++) {
+        int shift = level - 1 - section;
+        int value = (int)((((x >> shift) & 1) << 2) | (((y >> shift) & 1) << 1) | ((z >> shift) & 1));
+        for (int bit = 0; bit < BITS_IN_OCTAL; bit++) {
+            if (value & (1 << (BITS_IN_OCTAL - 1 - bit))) {
+                int bitIndex = section * BITS_IN_OCTAL + bit;
+                octalCode[1 + bitIndex / BITS_IN_BYTE] |= (1 << (BITS_IN_BYTE - 1 - bitIndex % BITS_IN_BYTE));
+            }
+        }
+    }
+}
+
+uint qHash(const VoxelSVOCell& cell) {
+    return qHash((cell.x * 73856093ULL) ^ (cell.y * 19349663ULL) ^ (cell.z * 83492791ULL) ^ (quint64)cell.level);
+}
+
+VoxelSVOVisitor::~VoxelSVOVisitor() {
+}
+
+VoxelSVOReader::VoxelSVOReader(const QString& fileName) :
+    _file(fileName),
+    _bytesRead(0),
+    _hasError(false)
+{
+    if (!_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Couldn't open" << fileName << "for reading:" << _file.errorString();
+        _hasError = true;
+    }
+}
+
+bool VoxelSVOReader::readBatch(VoxelSVOBatch& batch, int maxBytes) {
+    batch._data = _partialRecord;
+    batch._offsets.clear();
+    _partialRecord.clear();
+    if (_hasError) {
+        batch._data.clear();
+        return false;
+    }
+
+    int offset = 0;
+    while (true) {
+        if (batch._data.size() < maxBytes && !_file.atEnd()) {
+            QByteArray data = _file.read(maxBytes - batch._data.size());
+            _bytesRead += data.size();
+            batch._data.append(data);
+        }
+        const unsigned char* data = (const unsigned char*)batch._data.constData();
+        int length = 0;
+        while (offset < batch._data.size() && (length = recordLength(data + offset, batch._data.size() - offset)) > 0) {
+            batch._offsets.append(offset);
+            offset += length;
+        }
+        if (offset == batch._data.size()) {
+            break;
+        }
+        if (length < 0) {
+            qDebug() << "SVO file" << _file.fileName() << "has a record deeper than" << MAX_SVO_STREAM_LEVELS
+                << "levels at byte" << (_bytesRead - batch._data.size() + offset);
+            _hasError = true;
+            break;
+        }
+        if (!batch._offsets.isEmpty()) {
+            // the last record was cut off by the read, hold on to it for the next batch
+            _partialRecord = batch._data.mid(offset);
+            batch._data.truncate(offset);
+            break;
+        }
+        if (_file.atEnd()) {
+            qDebug() << "SVO file" << _file.fileName() << "ends part way through a record";
+            _hasError = true;
+            break;
+        }
+        // a record bigger than the batch, which no packet could have held, but there's no harm in reading on
+        maxBytes *= 2;
+    }
+    if (_hasError) {
+        batch._data.clear();
+        batch._offsets.clear();
+        return false;
+    }
+    if (batch._offsets.isEmpty()) {
+        return false;
+    }
+    batch._offsets.append(batch._data.size());
+    return true;
+}
+
+int VoxelSVOReader::recordLength(const unsigned char* data, int bytesLeft) {
+    if (bytesLeft < 1) {
+        return 0;
+    }
+    if (*data > MAX_SVO_STREAM_LEVELS) {
+        return -1;
+    }
+    int codeLength = bytesRequiredForCodeLength(*data);
+    if (bytesLeft < codeLength) {
+        return 0;
+    }
+    int nodeLength = nodeDataLength(data + codeLength, bytesLeft - codeLength, *data);
+    return (nodeLength > 0) ? codeLength + nodeLength : nodeLength;
+}
+
+int VoxelSVOReader::nodeDataLength(const unsigned char* nodeData, int bytesLeft, int level) {
+    // node data describes the children, which would be past the deepest level we can place
+    if (level >= MAX_SVO_STREAM_LEVELS) {
+        return -1;
+    }
+    if (bytesLeft < 1) {
+        return 0;
+    }
+    unsigned char colorMask = nodeData[0];
+    int bytesRead = sizeof(colorMask);
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(colorMask, i)) {
+            bytesRead += SIZE_OF_COLOR_DATA;
+        }
+    }
+    if (bytesLeft < bytesRead + 1) {
+        return 0;
+    }
+    unsigned char childMask = nodeData[bytesRead];
+    bytesRead += sizeof(childMask);
+
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(childMask, i)) {
+            int childLength = nodeDataLength(nodeData + bytesRead, bytesLeft - bytesRead, level + 1);
+            if (childLength <= 0) {
+                return childLength;
+            }
+            bytesRead += childLength;
+        }
+    }
+    return bytesRead;
+}
+
+void VoxelSVOReader::visitRecord(const unsigned char* record, VoxelSVOVisitor& visitor) {
+    VoxelSVOCell cell;
+    VoxelSVOCell::fromOctalCode(record, cell);
+    visitNodeData(record + bytesRequiredForCodeLength(*record), cell, visitor);
+}
+
+int VoxelSVOReader::visitNodeData(const unsigned char* nodeData, const VoxelSVOCell& cell, VoxelSVOVisitor& visitor) {
+    unsigned char colorMask = nodeData[0];
+    int bytesRead = sizeof(colorMask);
+    const unsigned char* colors[NUMBER_OF_CHILDREN];
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(colorMask, i)) {
+            colors[i] = nodeData + bytesRead;
+            bytesRead += SIZE_OF_COLOR_DATA;
+        }
+    }
+    unsigned char childMask = nodeData[bytesRead];
+    bytesRead += sizeof(childMask);
+
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(colorMask, i)) {
+            visitor.visitVoxel(cell.getChild(i), colors[i], oneAtBit(childMask, i));
+        }
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(childMask, i)) {
+            bytesRead += visitNodeData(nodeData + bytesRead, cell.getChild(i), visitor);
+        }
+    }
+    return bytesRead;
+}
+
+VoxelSVOWriter::VoxelSVOWriter(const QString& fileName) :
+    _fileName(fileName),
+    _file(fileName),
+    _bytesWritten(0),
+    _hasError(false)
+{
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Couldn't open" << fileName << "for writing:" << _file.errorString();
+        _hasError = true;
+    }
+}
+
+void VoxelSVOWriter::write(const QByteArray& records) {
+    write((const unsigned char*)records.constData(), records.size());
+}
+
+void VoxelSVOWriter::write(const unsigned char* records, int length) {
+    QMutexLocker locker(&_mutex);
+    if (_hasError || length == 0) {
+        return;
+    }
+    if (_file.write((const char*)records, length) != length) {
+        qDebug() << "Couldn't write to" << _fileName << ":" << _file.errorString();
+        _hasError = true;
+        return;
+    }
+    _bytesWritten += length;
+}
+
+void appendVoxelRecord(QByteArray& output, const VoxelSVOCell& parent, unsigned char colorMask,
+                       const unsigned char* childColors) {
+    parent.appendOctalCode(output);
+    output.append((char)colorMask);
+    int colorCount = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(colorMask, i)) {
+            colorCount++;
+        }
+    }
+    output.append((const char*)childColors, colorCount * SIZE_OF_COLOR_DATA);
+
+    const unsigned char NO_CHILD_DATA = 0;
+    output.append((char)NO_CHILD_DATA);
+}
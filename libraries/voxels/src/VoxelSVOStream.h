@@ -0,0 +1,145 @@
+//
+//  VoxelSVOStream.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Reads and writes voxel SVO files a run of records at a time, without loading them into a VoxelTree
+//
+
+#ifndef __hifi__VoxelSVOStream__
+#define __hifi__VoxelSVOStream__
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/// The deepest level the streaming tools handle, which keeps a cell's coordinates within 64 bits. That's a voxel far
+/// smaller than anything that's ever been edited.
+const int MAX_SVO_STREAM_LEVELS = 60;
+
+/// An element of the tree, as its level and integer coordinates at that level.
+class VoxelSVOCell {
+public:
+    VoxelSVOCell() : x(0), y(0), z(0), level(0) { }
+    VoxelSVOCell(quint64 x, quint64 y, quint64 z, int level) : x(x), y(y), z(z), level(level) { }
+
+    /// \return false if the code is deeper than MAX_SVO_STREAM_LEVELS
+    static bool fromOctalCode(const unsigned char* octalCode, VoxelSVOCell& cell);
+
+    VoxelSVOCell getChild(int childIndex) const {
+        return VoxelSVOCell((x << 1) | ((childIndex >> 2) & 1), (y << 1) | ((childIndex >> 1) & 1),
+            (z << 1) | (childIndex & 1), level + 1);
+    }
+    VoxelSVOCell getParent() const { return VoxelSVOCell(x >> 1, y >> 1, z >> 1, level - 1); }
+    int getIndexInParent() const { return (int)(((x & 1) << 2) | ((y & 1) << 1) | (z & 1)); }
+
+    /// \return true if other is this cell or lies beneath it
+    bool contains(const VoxelSVOCell& other) const;
+
+    /// Appends the root relative octal code for the cell.
+    void appendOctalCode(QByteArray& output) const;
+
+    bool operator==(const VoxelSVOCell& other) const {
+        return level == other.level && x == other.x && y == other.y && z == other.z;
+    }
+
+    quint64 x;
+    quint64 y;
+    quint64 z;
+    int level;
+};
+
+uint qHash(const VoxelSVOCell& cell);
+
+/// Whole records read from an SVO file. A record is the octal code of a subtree's root followed by the node data
+/// Octree::readNodeData reads for it: the colors of the root's children, then the children's own node data.
+class VoxelSVOBatch {
+public:
+    int getRecordCount() const { return qMax(_offsets.size() - 1, 0); }
+    const unsigned char* getRecord(int index) const { return (const unsigned char*)_data.constData() + _offsets[index]; }
+    int getRecordLength(int index) const { return _offsets[index + 1] - _offsets[index]; }
+
+    /// \return the records, back to back
+    const QByteArray& getData() const { return _data; }
+
+private:
+    friend class VoxelSVOReader;
+    QByteArray _data;
+    QVector<int> _offsets; // where each record starts, then where the last one ends
+};
+
+/// Called for the colored voxels in a record.
+class VoxelSVOVisitor {
+public:
+    virtual ~VoxelSVOVisitor();
+
+    /// \param hasChildData whether the record goes on to describe this voxel's children. Their data may instead be in
+    /// another record, rooted at this voxel, when they didn't fit in the same packet.
+    virtual void visitVoxel(const VoxelSVOCell& cell, const unsigned char* color, bool hasChildData) = 0;
+};
+
+/// Reads an SVO file in batches of whole records, holding no more than a batch and a partial record in memory.
+class VoxelSVOReader {
+public:
+    VoxelSVOReader(const QString& fileName);
+
+    bool isOpen() const { return _file.isOpen(); }
+    bool hasError() const { return _hasError; }
+    qint64 getFileSize() const { return _file.size(); }
+    qint64 getBytesRead() const { return _bytesRead; }
+
+    /// Replaces the batch with the next records, roughly maxBytes of them.
+    /// \return false once the file is done, or if the rest of it isn't a valid record
+    bool readBatch(VoxelSVOBatch& batch, int maxBytes);
+
+    /// \return the record's length, 0 if it runs past the end of the data, or -1 if it's deeper than the streaming
+    /// tools handle
+    static int recordLength(const unsigned char* data, int bytesLeft);
+
+    /// \return the length of the node data, with the same 0 and -1 as recordLength
+    static int nodeDataLength(const unsigned char* nodeData, int bytesLeft, int level);
+
+    /// Calls the visitor for every colored voxel in a record already checked with recordLength.
+    static void visitRecord(const unsigned char* record, VoxelSVOVisitor& visitor);
+
+private:
+    static int visitNodeData(const unsigned char* nodeData, const VoxelSVOCell& cell, VoxelSVOVisitor& visitor);
+
+    QFile _file;
+    QByteArray _partialRecord; // the start of a record that was cut off by the end of the last read
+    qint64 _bytesRead;
+    bool _hasError;
+};
+
+/// Writes records to an SVO file. Writes are serialized, so workers can share one writer.
+class VoxelSVOWriter {
+public:
+    VoxelSVOWriter(const QString& fileName);
+
+    bool isOpen() const { return _file.isOpen(); }
+    bool hasError() const { return _hasError; }
+    const QString& getFileName() const { return _fileName; }
+    qint64 getBytesWritten() const { return _bytesWritten; }
+
+    /// Appends whole records. Any set of records makes a valid SVO file, as each is read relative to the root.
+    void write(const QByteArray& records);
+    void write(const unsigned char* records, int length);
+
+private:
+    QString _fileName;
+    QFile _file;
+    QMutex _mutex;
+    qint64 _bytesWritten;
+    bool _hasError;
+};
+
+/// Appends a record that colors one or more children of a parent cell, leaving everything else about it alone.
+/// \param childColors the color of each child in colorMask, in child index order
+void appendVoxelRecord(QByteArray& output, const VoxelSVOCell& parent, unsigned char colorMask,
+                       const unsigned char* childColors);
+
+#endif /* defined(__hifi__VoxelSVOStream__) */
@@ -0,0 +1,399 @@
+//
+//  VoxelSVOTools.cpp
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <QtCore/QDebug>
+#include <QtCore/QSet>
+
+#include <OctalCode.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+#include <WorkStealingPool.h>
+
+#include "VoxelSVOStream.h"
+#include "VoxelSVOTools.h"
+
+// two batches are held at once, the one being worked on and the one being read
+const int STREAM_BATCH_BYTES = 4 * 1024 * 1024;
+const int STREAM_SLICE_BYTES = 256 * 1024;
+const int STREAM_FLUSH_BYTES = 1024 * 1024;
+
+const int ROOT_OUTPUT = 0;
+
+VoxelSVOStats::VoxelSVOStats() :
+    recordCount(0),
+    byteCount(0),
+    voxelCount(0),
+    voxelsPerLevel(MAX_SVO_STREAM_LEVELS + 1, 0)
+{
+}
+
+void VoxelSVOStats::add(const VoxelSVOStats& other) {
+    recordCount += other.recordCount;
+    byteCount += other.byteCount;
+    voxelCount += other.voxelCount;
+    for (int i = 0; i < voxelsPerLevel.size(); i++) {
+        voxelsPerLevel[i] += other.voxelsPerLevel[i];
+    }
+}
+
+/// What one slice of a batch produces: a buffer of records for each output file, written out whenever it gets big.
+class RecordOutput {
+public:
+    RecordOutput(const QVector<VoxelSVOWriter*>& writers) : _writers(writers), _buffers(writers.size()) { }
+
+    QByteArray& getBuffer(int output) { return _buffers[output]; }
+
+    void flush(int minimumBytes = 0) {
+        for (int i = 0; i < _buffers.size(); i++) {
+            if (_buffers[i].size() > minimumBytes) {
+                _writers[i]->write(_buffers[i]);
+                _buffers[i].clear();
+            }
+        }
+    }
+
+    VoxelSVOStats stats;
+
+private:
+    QVector<VoxelSVOWriter*> _writers;
+    QVector<QByteArray> _buffers;
+};
+
+class RecordOperation {
+public:
+    virtual ~RecordOperation() { }
+
+    /// Called from the pool's threads, for records that have already been checked by the reader.
+    virtual void processRecord(const unsigned char* record, int length, RecordOutput& output) const = 0;
+};
+
+class RecordSliceTask : public WorkStealingTask {
+public:
+    RecordSliceTask(const VoxelSVOBatch& batch, int firstRecord, int lastRecord, const RecordOperation& operation,
+                    const QVector<VoxelSVOWriter*>& writers) :
+        output(writers),
+        _batch(batch),
+        _firstRecord(firstRecord),
+        _lastRecord(lastRecord),
+        _operation(operation) { }
+
+    virtual void run() {
+        for (int i = _firstRecord; i < _lastRecord; i++) {
+            _operation.processRecord(_batch.getRecord(i), _batch.getRecordLength(i), output);
+            output.flush(STREAM_FLUSH_BYTES);
+        }
+        output.flush();
+    }
+
+    RecordOutput output;
+
+private:
+    const VoxelSVOBatch& _batch;
+    int _firstRecord;
+    int _lastRecord;
+    const RecordOperation& _operation;
+};
+
+static bool processRecords(const QString& fileName, const RecordOperation& operation,
+                           const QVector<VoxelSVOWriter*>& writers, VoxelSVOStats& stats) {
+    VoxelSVOReader reader(fileName);
+    WorkStealingPool* pool = WorkStealingPool::getInstance();
+    const int PROGRESS_STEP = 10;
+    int lastProgress = 0;
+
+    VoxelSVOBatch batches[2];
+    int current = 0;
+    bool haveBatch = reader.readBatch(batches[current], STREAM_BATCH_BYTES);
+    while (haveBatch) {
+        const VoxelSVOBatch& batch = batches[current];
+        WorkStealingGroup group;
+        QVector<RecordSliceTask*> tasks;
+        int firstRecord = 0;
+        int sliceBytes = 0;
+        for (int i = 0; i < batch.getRecordCount(); i++) {
+            sliceBytes += batch.getRecordLength(i);
+            if (sliceBytes >= STREAM_SLICE_BYTES || i == batch.getRecordCount() - 1) {
+                tasks.append(new RecordSliceTask(batch, firstRecord, i + 1, operation, writers));
+                pool->start(tasks.last(), group);
+                firstRecord = i + 1;
+                sliceBytes = 0;
+            }
+        }
+
+        // read the next batch while the workers get on with this one
+        haveBatch = reader.readBatch(batches[1 - current], STREAM_BATCH_BYTES);
+        pool->wait(group);
+
+        foreach (RecordSliceTask* task, tasks) {
+            stats.add(task->output.stats);
+            delete task;
+        }
+        current = 1 - current;
+
+        int progress = (reader.getFileSize() > 0) ? (int)(100 * reader.getBytesRead() / reader.getFileSize()) : 100;
+        if (progress >= lastProgress + PROGRESS_STEP) {
+            qDebug("%s: %d%% (%llu records)", fileName.toLocal8Bit().constData(), progress, stats.recordCount);
+            lastProgress = progress;
+        }
+    }
+
+    bool ok = !reader.hasError();
+    foreach (VoxelSVOWriter* writer, writers) {
+        ok = ok && !writer->hasError();
+    }
+    return ok;
+}
+
+class StatsVisitor : public VoxelSVOVisitor {
+public:
+    StatsVisitor(VoxelSVOStats& stats) : _stats(stats) { }
+
+    virtual void visitVoxel(const VoxelSVOCell& cell, const unsigned char* color, bool hasChildData) {
+        _stats.voxelCount++;
+        _stats.voxelsPerLevel[cell.level]++;
+    }
+
+private:
+    VoxelSVOStats& _stats;
+};
+
+class StatsOperation : public RecordOperation {
+public:
+    virtual void processRecord(const unsigned char* record, int length, RecordOutput& output) const {
+        output.stats.recordCount++;
+        output.stats.byteCount += length;
+        StatsVisitor visitor(output.stats);
+        VoxelSVOReader::visitRecord(record, visitor);
+    }
+};
+
+bool VoxelSVOTools::computeStats(const QString& fileName, VoxelSVOStats& stats) {
+    return processRecords(fileName, StatsOperation(), QVector<VoxelSVOWriter*>(), stats);
+}
+
+class SplitOperation : public RecordOperation {
+public:
+    SplitOperation(const QVector<VoxelSVOCell>& endNodes) : _endNodes(endNodes) { }
+
+    virtual void processRecord(const unsigned char* record, int length, RecordOutput& output) const {
+        VoxelSVOCell root;
+        VoxelSVOCell::fromOctalCode(record, root);
+
+        // a record at or beneath an end node goes to it whole. Were end nodes to nest, the shallowest one gets
+        // everything beneath it, the same as it would were we walking down to it from above
+        int owner = -1;
+        bool holdsEndNode = false;
+        for (int i = 0; i < _endNodes.size(); i++) {
+            if (_endNodes[i].contains(root)) {
+                if (owner == -1 || _endNodes[i].level < _endNodes[owner].level) {
+                    owner = i;
+                }
+            } else if (root.contains(_endNodes[i])) {
+                holdsEndNode = true;
+            }
+        }
+        if (owner != -1) {
+            output.getBuffer(owner + 1).append((const char*)record, length);
+            return;
+        }
+        if (!holdsEndNode) {
+            output.getBuffer(ROOT_OUTPUT).append((const char*)record, length);
+            return;
+        }
+        int codeLength = bytesRequiredForCodeLength(*record);
+        output.getBuffer(ROOT_OUTPUT).append((const char*)record, codeLength);
+        splitNodeData(record + codeLength, length - codeLength, root, output);
+    }
+
+private:
+    /// Copies the node data to the root's output, less the end node subtrees, which go to their own outputs.
+    /// \return the length of the node data
+    int splitNodeData(const unsigned char* nodeData, int bytesLeft, const VoxelSVOCell& cell,
+                      RecordOutput& output) const {
+        QByteArray& kept = output.getBuffer(ROOT_OUTPUT);
+
+        // the colors of the children stay with the root, they're the view of the end nodes from above
+        unsigned char colorMask = nodeData[0];
+        int bytesRead = sizeof(colorMask);
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            if (oneAtBit(colorMask, i)) {
+                bytesRead += SIZE_OF_COLOR_DATA;
+            }
+        }
+        kept.append((const char*)nodeData, bytesRead);
+
+        unsigned char childMask = nodeData[bytesRead];
+        bytesRead += sizeof(childMask);
+        int childMaskAt = kept.size();
+        kept.append((char)childMask);
+
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            if (!oneAtBit(childMask, i)) {
+                continue;
+            }
+            VoxelSVOCell child = cell.getChild(i);
+            int childLength = VoxelSVOReader::nodeDataLength(nodeData + bytesRead, bytesLeft - bytesRead, child.level);
+            int endNode = _endNodes.indexOf(child);
+            if (endNode != -1) {
+                QByteArray& endNodeOutput = output.getBuffer(endNode + 1);
+                child.appendOctalCode(endNodeOutput);
+                endNodeOutput.append((const char*)nodeData + bytesRead, childLength);
+                kept.data()[childMaskAt] &= ~(1 << (7 - i));
+
+            } else if (holdsEndNode(child)) {
+                splitNodeData(nodeData + bytesRead, bytesLeft - bytesRead, child, output);
+
+            } else {
+                kept.append((const char*)nodeData + bytesRead, childLength);
+            }
+            bytesRead += childLength;
+        }
+        return bytesRead;
+    }
+
+    bool holdsEndNode(const VoxelSVOCell& cell) const {
+        foreach (const VoxelSVOCell& endNode, _endNodes) {
+            if (cell.contains(endNode)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QVector<VoxelSVOCell> _endNodes;
+};
+
+bool VoxelSVOTools::split(const QString& fileName, const JurisdictionMap& jurisdiction,
+                          const QString& rootFileName, const QStringList& endNodeFileNames) {
+    if (endNodeFileNames.size() != jurisdiction.getEndNodeCount()) {
+        qDebug() << "Expected" << jurisdiction.getEndNodeCount() << "end node files, got" << endNodeFileNames.size();
+        return false;
+    }
+    QVector<VoxelSVOCell> endNodes;
+    for (int i = 0; i < jurisdiction.getEndNodeCount(); i++) {
+        VoxelSVOCell endNode;
+        if (!VoxelSVOCell::fromOctalCode(jurisdiction.getEndNodeOctalCode(i), endNode)) {
+            qDebug() << "End node" << i << "is deeper than" << MAX_SVO_STREAM_LEVELS << "levels";
+            return false;
+        }
+        endNodes.append(endNode);
+    }
+
+    QVector<VoxelSVOWriter*> writers;
+    writers.append(new VoxelSVOWriter(rootFileName));
+    foreach (const QString& endNodeFileName, endNodeFileNames) {
+        writers.append(new VoxelSVOWriter(endNodeFileName));
+    }
+    VoxelSVOStats stats;
+    bool ok = processRecords(fileName, SplitOperation(endNodes), writers, stats);
+    foreach (VoxelSVOWriter* writer, writers) {
+        qDebug() << "Wrote" << writer->getBytesWritten() << "bytes to" << writer->getFileName();
+        delete writer;
+    }
+    return ok;
+}
+
+bool VoxelSVOTools::merge(const QStringList& fileNames, const QString& outputFileName) {
+    VoxelSVOWriter writer(outputFileName);
+    foreach (const QString& fileName, fileNames) {
+        // nothing to do but check that each record is whole, so there's nothing to gain from the pool
+        VoxelSVOReader reader(fileName);
+        VoxelSVOBatch batch;
+        while (reader.readBatch(batch, STREAM_BATCH_BYTES)) {
+            writer.write(batch.getData());
+        }
+        if (reader.hasError() || writer.hasError()) {
+            return false;
+        }
+        qDebug() << "Merged" << reader.getBytesRead() << "bytes from" << fileName;
+    }
+    return !writer.hasError();
+}
+
+class FillVisitor : public VoxelSVOVisitor {
+public:
+    FillVisitor(const QSet<VoxelSVOCell>& recordRoots, RecordOutput& output) :
+        _recordRoots(recordRoots),
+        _output(output) { }
+
+    virtual void visitVoxel(const VoxelSVOCell& cell, const unsigned char* color, bool hasChildData) {
+        if (hasChildData || _recordRoots.contains(cell)) {
+            return; // not a leaf
+        }
+        unsigned char colors[2 * SIZE_OF_COLOR_DATA];
+        memcpy(colors, color, SIZE_OF_COLOR_DATA);
+        memcpy(colors + SIZE_OF_COLOR_DATA, color, SIZE_OF_COLOR_DATA);
+
+        // the leaf and everything beneath it, a record per parent, which holds two of them when they share it
+        quint64 y = cell.y;
+        while (true) {
+            VoxelSVOCell voxel(cell.x, y, cell.z, cell.level);
+            unsigned char colorMask = 1 << (7 - voxel.getIndexInParent());
+            int voxelsInParent = 1;
+            if (y & 1) {
+                VoxelSVOCell below(cell.x, y - 1, cell.z, cell.level);
+                colorMask |= 1 << (7 - below.getIndexInParent());
+                voxelsInParent = 2;
+            }
+            appendVoxelRecord(_output.getBuffer(ROOT_OUTPUT), voxel.getParent(), colorMask, colors);
+            _output.stats.recordCount++;
+            _output.stats.voxelCount += voxelsInParent;
+            _output.stats.voxelsPerLevel[cell.level] += voxelsInParent;
+            _output.flush(STREAM_FLUSH_BYTES);
+
+            if (y < (quint64)voxelsInParent) {
+                break;
+            }
+            y -= voxelsInParent;
+        }
+    }
+
+private:
+    const QSet<VoxelSVOCell>& _recordRoots;
+    RecordOutput& _output;
+};
+
+class FillOperation : public RecordOperation {
+public:
+    FillOperation(const QSet<VoxelSVOCell>& recordRoots) : _recordRoots(recordRoots) { }
+
+    virtual void processRecord(const unsigned char* record, int length, RecordOutput& output) const {
+        FillVisitor visitor(_recordRoots, output);
+        VoxelSVOReader::visitRecord(record, visitor);
+    }
+
+private:
+    const QSet<VoxelSVOCell>& _recordRoots;
+};
+
+bool VoxelSVOTools::fill(const QString& fileName, const QString& outputFileName, VoxelSVOStats& created) {
+    // A voxel whose children didn't fit in its parent's packet has them in a record of its own, which could come
+    // anywhere later in the file. To tell leaves from those we first note where every record starts, which costs a few
+    // dozen bytes a record, a small fraction of the file.
+    QSet<VoxelSVOCell> recordRoots;
+    {
+        VoxelSVOReader reader(fileName);
+        VoxelSVOBatch batch;
+        while (reader.readBatch(batch, STREAM_BATCH_BYTES)) {
+            for (int i = 0; i < batch.getRecordCount(); i++) {
+                VoxelSVOCell root;
+                VoxelSVOCell::fromOctalCode(batch.getRecord(i), root);
+                recordRoots.insert(root);
+            }
+        }
+        if (reader.hasError()) {
+            return false;
+        }
+    }
+
+    VoxelSVOWriter writer(outputFileName);
+    QVector<VoxelSVOWriter*> writers;
+    writers.append(&writer);
+    bool ok = processRecords(fileName, FillOperation(recordRoots), writers, created);
+    created.byteCount = writer.getBytesWritten();
+    return ok;
+}
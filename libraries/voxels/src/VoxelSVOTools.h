@@ -0,0 +1,57 @@
+//
+//  VoxelSVOTools.h
+//  hifi
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+//  Split, merge, fill and stats for SVO files too big to load, streamed a batch of records at a time
+//
+
+#ifndef __hifi__VoxelSVOTools__
+#define __hifi__VoxelSVOTools__
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include <JurisdictionMap.h>
+
+class VoxelSVOStats {
+public:
+    VoxelSVOStats();
+
+    void add(const VoxelSVOStats& other);
+
+    quint64 recordCount;
+    quint64 byteCount;
+    quint64 voxelCount;
+    QVector<quint64> voxelsPerLevel;
+};
+
+/// Each tool reads its input once, a batch at a time, and hands slices of each batch to the work stealing pool while
+/// the next batch is read. Memory use depends on the batch size and the number of cores, never on the size of the file.
+/// The records of an SVO file never describe the same element twice, so the tools write them out in whatever order the
+/// slices finish.
+class VoxelSVOTools {
+public:
+    /// Counts the records, bytes and colored voxels in a file, including the colors of interior voxels.
+    static bool computeStats(const QString& fileName, VoxelSVOStats& stats);
+
+    /// Splits a file by the end nodes of a jurisdiction, like voxel-edit's --splitSVO but without the placeholder
+    /// voxels. Everything at or beneath an end node goes to that end node's file, everything else to the root's file.
+    /// An end node's own color stays in the root's file, as part of the root server's view of it.
+    static bool split(const QString& fileName, const JurisdictionMap& jurisdiction,
+                      const QString& rootFileName, const QStringList& endNodeFileNames);
+
+    /// Concatenates the records of each file, which has the same effect as loading each into a tree in turn. Loading
+    /// doesn't clear anything, so where the files overlap, a voxel in a later file recolors the same voxel from an
+    /// earlier one but leaves any smaller voxels the earlier file had inside it.
+    static bool merge(const QStringList& fileNames, const QString& outputFileName);
+
+    /// Writes each leaf voxel along with a column of same sized voxels beneath it, down to the bottom of the world,
+    /// like voxel-edit's --fillSVO. The colors of interior voxels are dropped, to be reaveraged by whoever loads it.
+    /// \param created gets the records and voxels that were written
+    static bool fill(const QString& fileName, const QString& outputFileName, VoxelSVOStats& created);
+};
+
+#endif /* defined(__hifi__VoxelSVOTools__) */
@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include <QtCore/QDebug>
+#include <QtCore/QtAlgorithms>
 #include <QImage>
 #include <QRgb>
 
@@ -250,6 +251,15 @@ void VoxelTree::nudgeSubTree(VoxelTreeElement* elementToNudge, const glm::vec3&
 
 
 
+// how far an import's progress goes while reading the file, the rest is for creating its voxels
+const int IMPORT_READ_PROGRESS = 50;
+
+static void appendVoxel(QVector<VoxelDetail>& voxels, float x, float y, float z, float s,
+                        unsigned char red, unsigned char green, unsigned char blue) {
+    VoxelDetail voxel = { x, y, z, s, red, green, blue };
+    voxels.append(voxel);
+}
+
 bool VoxelTree::readFromSquareARGB32Pixels(const char* filename) {
     emit importProgress(0);
     int minAlpha = INT_MAX;
@@ -272,10 +282,11 @@ bool VoxelTree::readFromSquareARGB32Pixels(const char* filename) {
 
     QRgb pixel;
     int minNeighborhoodAlpha;
+    QVector<VoxelDetail> voxels;
 
     for (int i = 0; i < pngImage.width(); ++i) {
         for (int j = 0; j < pngImage.height(); ++j) {
-            emit importProgress((100 * (i * pngImage.height() + j)) /
+            emit importProgress((IMPORT_READ_PROGRESS * (i * pngImage.height() + j)) /
                                 (pngImage.width() * pngImage.height()));
 
             pixel = pngImage.pixel(i, j);
@@ -296,18 +307,19 @@ bool VoxelTree::readFromSquareARGB32Pixels(const char* filename) {
 
             while (qAlpha(pixel) > minNeighborhoodAlpha) {
                 ++minNeighborhoodAlpha;
-                createVoxel(i * size,
+                appendVoxel(voxels,
+                            i * size,
                             (minNeighborhoodAlpha - minAlpha) * size,
                             j * size,
                             size,
                             qRed(pixel),
                             qGreen(pixel),
-                            qBlue(pixel),
-                            true);
+                            qBlue(pixel));
             }
 
         }
     }
+    createVoxels(voxels, true, IMPORT_READ_PROGRESS);
 
     emit importProgress(100);
     return true;
@@ -345,15 +357,18 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
     int create = 1;
     int red = 128, green = 128, blue = 128;
     int count = 0;
+    QVector<VoxelDetail> voxels;
 
     for (int y = 0; y < schematics.getHeight(); ++y) {
         for (int z = 0; z < schematics.getLength(); ++z) {
-            emit importProgress((int) 100 * (y * schematics.getLength() + z) / (schematics.getHeight() * schematics.getLength()));
+            emit importProgress(IMPORT_READ_PROGRESS * (y * schematics.getLength() + z) /
+                                (schematics.getHeight() * schematics.getLength()));
 
             for (int x = 0; x < schematics.getWidth(); ++x) {
                 if (_stopImport) {
                     qDebug("[DEBUG] Canceled import at %d voxels.", count);
                     _stopImport = false;
+                    createVoxels(voxels, true);
                     return true;
                 }
 
@@ -366,35 +381,35 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
 
                 switch (create) {
                     case 1:
-                        createVoxel(size * x, size * y, size * z, size, red, green, blue, true);
+                        appendVoxel(voxels, size * x, size * y, size * z, size, red, green, blue);
                         ++count;
                         break;
                     case 2:
                         switch (data) {
                             case 0:
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
+                                appendVoxel(voxels, size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue);
+                                appendVoxel(voxels, size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue);
                                 break;
                             case 1:
-                                createVoxel(size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
+                                appendVoxel(voxels, size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue);
+                                appendVoxel(voxels, size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue);
                                 break;
                             case 2:
-                                createVoxel(size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
+                                appendVoxel(voxels, size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue);
+                                appendVoxel(voxels, size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue);
                                 break;
                             case 3:
-                                createVoxel(size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue, true);
+                                appendVoxel(voxels, size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue);
+                                appendVoxel(voxels, size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue);
                                 break;
                         }
                         count += 2;
                         // There's no break on purpose.
                     case 3:
-                        createVoxel(size * x           , size * y, size * z           , size / 2, red, green, blue, true);
-                        createVoxel(size * x + size / 2, size * y, size * z           , size / 2, red, green, blue, true);
-                        createVoxel(size * x           , size * y, size * z + size / 2, size / 2, red, green, blue, true);
-                        createVoxel(size * x + size / 2, size * y, size * z + size / 2, size / 2, red, green, blue, true);
+                        appendVoxel(voxels, size * x           , size * y, size * z           , size / 2, red, green, blue);
+                        appendVoxel(voxels, size * x + size / 2, size * y, size * z           , size / 2, red, green, blue);
+                        appendVoxel(voxels, size * x           , size * y, size * z + size / 2, size / 2, red, green, blue);
+                        appendVoxel(voxels, size * x + size / 2, size * y, size * z + size / 2, size / 2, red, green, blue);
                         count += 4;
                         break;
                 }
@@ -402,6 +417,8 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
         }
     }
 
+    createVoxels(voxels, true, IMPORT_READ_PROGRESS);
+
     emit importProgress(100);
     qDebug("Created %d voxels from minecraft import.", count);
 
@@ -432,39 +449,10 @@ void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadC
     // Since we traverse the tree in code order, we know that if our code
     // matches, then we've reached  our target node.
     if (lengthOfNodeCode == args.lengthOfCode) {
-        // we've reached our target -- we might have found our node, but that node might have children.
-        // in this case, we only allow you to set the color if you explicitly asked for a destructive
-        // write.
-        if (!node->isLeaf() && args.destructive) {
-            // if it does exist, make sure it has no children
-            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
-                node->deleteChildAtIndex(i);
-            }
-        } else {
-            if (!node->isLeaf()) {
-                qDebug("WARNING! operation would require deleting children, add Voxel ignored!");
-            }
-        }
-
-        // If we get here, then it means, we either had a true leaf to begin with, or we were in
-        // destructive mode and we deleted all the child trees. So we can color.
-        if (node->isLeaf()) {
-            // give this node its color
-            int octalCodeBytes = bytesRequiredForCodeLength(args.lengthOfCode);
-
-            nodeColor newColor;
-            memcpy(newColor, args.codeColorBuffer + octalCodeBytes, SIZE_OF_COLOR_DATA);
-            newColor[SIZE_OF_COLOR_DATA] = 1;
-            node->setColor(newColor);
-
-            // It's possible we just reset the node to it's exact same color, in
-            // which case we don't consider this to be dirty...
-            if (node->isDirty()) {
-                // track our tree dirtiness
-                _isDirty = true;
-                // track that path has changed
-                args.pathChanged = true;
-            }
+        int octalCodeBytes = bytesRequiredForCodeLength(args.lengthOfCode);
+        if (colorVoxel(node, args.codeColorBuffer + octalCodeBytes, args.destructive)) {
+            // track that path has changed
+            args.pathChanged = true;
         }
         return;
     }
@@ -491,6 +479,277 @@ void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadC
     }
 }
 
+bool VoxelTree::colorVoxel(VoxelTreeElement* element, const unsigned char* color, bool destructive) {
+    // we've reached our target -- we might have found our node, but that node might have children.
+    // in this case, we only allow you to set the color if you explicitly asked for a destructive
+    // write.
+    if (!element->isLeaf() && destructive) {
+        // if it does exist, make sure it has no children
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            element->deleteChildAtIndex(i);
+        }
+    } else {
+        if (!element->isLeaf()) {
+            qDebug("WARNING! operation would require deleting children, add Voxel ignored!");
+        }
+    }
+
+    // If we get here, then it means, we either had a true leaf to begin with, or we were in
+    // destructive mode and we deleted all the child trees. So we can color.
+    if (element->isLeaf()) {
+        // give this node its color
+        nodeColor newColor;
+        memcpy(newColor, color, SIZE_OF_COLOR_DATA);
+        newColor[SIZE_OF_COLOR_DATA] = 1;
+        element->setColor(newColor);
+
+        // It's possible we just reset the node to it's exact same color, in
+        // which case we don't consider this to be dirty...
+        if (element->isDirty()) {
+            // track our tree dirtiness
+            setDirtyBit();
+            return true;
+        }
+    }
+    return false;
+}
+
+// the deepest voxel the bulk loader handles itself, as many three bit sections as fit in a quint64
+const int MAX_BULK_VOXEL_LEVELS = 21;
+
+class BulkVoxel {
+public:
+    quint64 sections; // the octal code, one section per three bits with the first section highest
+    int order; // where it came in the batch
+    int levels;
+    rgbColor color;
+
+    int getSection(int level) const { return (sections >> (3 * (levels - 1 - level))) & 7; }
+
+    bool isAncestorOf(const BulkVoxel& other) const {
+        return levels < other.levels && (other.sections >> (3 * (other.levels - levels))) == sections;
+    }
+
+    bool hasSameCode(const BulkVoxel& other) const { return levels == other.levels && sections == other.sections; }
+
+    /// Orders voxels by octal code, ancestors ahead of their descendants.
+    bool operator<(const BulkVoxel& other) const {
+        int shift = 3 * (MAX_BULK_VOXEL_LEVELS - levels);
+        int otherShift = 3 * (MAX_BULK_VOXEL_LEVELS - other.levels);
+        quint64 aligned = sections << shift;
+        quint64 otherAligned = other.sections << otherShift;
+        return aligned < otherAligned || (aligned == otherAligned && levels < other.levels);
+    }
+};
+
+/// Computes the octal code of a voxel the same way pointToVoxel() does, without allocating it.
+/// \return false if the voxel is too small to fit in a BulkVoxel
+static bool voxelToBulkVoxel(const VoxelDetail& voxel, BulkVoxel& bulkVoxel) {
+    bulkVoxel.sections = 0;
+    bulkVoxel.levels = 0;
+    bulkVoxel.color[RED_INDEX] = voxel.red;
+    bulkVoxel.color[GREEN_INDEX] = voxel.green;
+    bulkVoxel.color[BLUE_INDEX] = voxel.blue;
+
+    // special case for size 1, the root node
+    if (voxel.s >= 1.0f) {
+        return true;
+    }
+    float sTest = 0.5f;
+    bulkVoxel.levels = 1;
+    while (sTest > voxel.s) {
+        sTest /= 2.0;
+        if (++bulkVoxel.levels > MAX_BULK_VOXEL_LEVELS) {
+            return false;
+        }
+    }
+
+    float xTest, yTest, zTest;
+    xTest = yTest = zTest = sTest = 0.5f;
+    for (int level = 0; level < bulkVoxel.levels; level++) {
+        int section = 0;
+        if (voxel.x >= xTest) {
+            section |= 4;
+            xTest += sTest / 2.0;
+        } else {
+            xTest -= sTest / 2.0;
+        }
+        if (voxel.y >= yTest) {
+            section |= 2;
+            yTest += sTest / 2.0;
+        } else {
+            yTest -= sTest / 2.0;
+        }
+        if (voxel.z >= zTest) {
+            section |= 1;
+            zTest += sTest / 2.0;
+        } else {
+            zTest -= sTest / 2.0;
+        }
+        bulkVoxel.sections = (bulkVoxel.sections << 3) | section;
+        sTest /= 2.0;
+    }
+    return true;
+}
+
+// the voxels sharing one octal code on the path down to the current voxel, while overlaps are resolved
+class BulkVoxelGroup {
+public:
+    int begin;
+    int end;
+    int minOrder;
+    int maxOrder;
+    int latestAncestorOrder; // -1 if none
+    int earliestDescendantOrder; // INT_MAX if none yet
+};
+
+/// Finishes with a group once all its descendants have been seen: refuses, if need be, and passes what it knows up.
+static void closeBulkVoxelGroup(QVector<BulkVoxelGroup>& groups, const QVector<BulkVoxel>& bulkVoxels,
+                                QVector<bool>& dropped, bool destructive) {
+    BulkVoxelGroup group = groups.last();
+    groups.removeLast();
+    if (!destructive) {
+        for (int i = group.begin; i < group.end; i++) {
+            if (bulkVoxels.at(i).order > group.earliestDescendantOrder) {
+                dropped[i] = true;
+            }
+        }
+    }
+    if (!groups.isEmpty()) {
+        BulkVoxelGroup& parent = groups.last();
+        parent.earliestDescendantOrder = qMin(parent.earliestDescendantOrder,
+                                              qMin(group.minOrder, group.earliestDescendantOrder));
+    }
+}
+
+/// Drops the voxels in a sorted batch that creating the batch in its own order would have wiped out or refused, so that
+/// creating the rest ancestors first comes out the same. A destructive voxel wipes out whatever beneath it came earlier
+/// in the batch; otherwise a voxel is refused if anything beneath it came earlier, as that leaves it with children.
+static void resolveOverlaps(QVector<BulkVoxel>& bulkVoxels, bool destructive) {
+    QVector<bool> dropped(bulkVoxels.size(), false);
+    QVector<BulkVoxelGroup> groups;
+    for (int i = 0; i < bulkVoxels.size(); i++) {
+        const BulkVoxel& bulkVoxel = bulkVoxels.at(i);
+        if (!groups.isEmpty() && bulkVoxels.at(groups.last().begin).hasSameCode(bulkVoxel)) {
+            BulkVoxelGroup& group = groups.last();
+            group.end = i + 1;
+            group.minOrder = qMin(group.minOrder, bulkVoxel.order);
+            group.maxOrder = qMax(group.maxOrder, bulkVoxel.order);
+        } else {
+            while (!groups.isEmpty() && !bulkVoxels.at(groups.last().begin).isAncestorOf(bulkVoxel)) {
+                closeBulkVoxelGroup(groups, bulkVoxels, dropped, destructive);
+            }
+            BulkVoxelGroup group;
+            group.begin = i;
+            group.end = i + 1;
+            group.minOrder = group.maxOrder = bulkVoxel.order;
+            group.latestAncestorOrder = groups.isEmpty() ? -1 :
+                qMax(groups.last().latestAncestorOrder, groups.last().maxOrder);
+            group.earliestDescendantOrder = INT_MAX;
+            groups.append(group);
+        }
+        if (destructive && bulkVoxel.order < groups.last().latestAncestorOrder) {
+            dropped[i] = true;
+        }
+    }
+    while (!groups.isEmpty()) {
+        closeBulkVoxelGroup(groups, bulkVoxels, dropped, destructive);
+    }
+
+    int kept = 0;
+    for (int i = 0; i < bulkVoxels.size(); i++) {
+        if (!dropped.at(i)) {
+            bulkVoxels[kept++] = bulkVoxels.at(i);
+        }
+    }
+    bulkVoxels.resize(kept);
+}
+
+void VoxelTree::createVoxels(const QVector<VoxelDetail>& voxels, bool destructive, int progressFrom) {
+    QVector<BulkVoxel> bulkVoxels;
+    bulkVoxels.reserve(voxels.size());
+    QVector<VoxelDetail> tooSmall;
+    foreach (const VoxelDetail& voxel, voxels) {
+        BulkVoxel bulkVoxel;
+        if (voxelToBulkVoxel(voxel, bulkVoxel)) {
+            bulkVoxel.order = bulkVoxels.size();
+            bulkVoxels.append(bulkVoxel);
+        } else {
+            tooSmall.append(voxel);
+        }
+    }
+    // stable, so that the last of several voxels with the same code wins, just as it would one at a time
+    qStableSort(bulkVoxels.begin(), bulkVoxels.end());
+    resolveOverlaps(bulkVoxels, destructive);
+
+    lockForWrite();
+
+    // the elements from the root down to the last voxel, and whether anything beneath each of them has changed
+    VoxelTreeElement* path[MAX_BULK_VOXEL_LEVELS + 1];
+    bool subtreeChanged[MAX_BULK_VOXEL_LEVELS + 1];
+    path[0] = getRoot();
+    subtreeChanged[0] = false;
+    int depth = 0;
+
+    int lastProgress = progressFrom;
+    for (int i = 0; i < bulkVoxels.size(); i++) {
+        if (progressFrom < 100) {
+            int progress = progressFrom + ((100 - progressFrom) * i) / bulkVoxels.size();
+            if (progress != lastProgress) {
+                emit importProgress(progress);
+                lastProgress = progress;
+            }
+        }
+        const BulkVoxel& bulkVoxel = bulkVoxels.at(i);
+        int sharedLevels = 0;
+        if (i > 0) {
+            const BulkVoxel& last = bulkVoxels.at(i - 1);
+            int maxSharedLevels = qMin(depth, bulkVoxel.levels);
+            while (sharedLevels < maxSharedLevels && bulkVoxel.getSection(sharedLevels) == last.getSection(sharedLevels)) {
+                sharedLevels++;
+            }
+        }
+        // nothing more will be added beneath the elements we're leaving, so this is their one chance to reaverage
+        for (; depth > sharedLevels; depth--) {
+            if (subtreeChanged[depth]) {
+                path[depth]->handleSubtreeChanged(this);
+                subtreeChanged[depth - 1] = true;
+            }
+        }
+        for (; depth < bulkVoxel.levels; depth++) {
+            int childIndex = bulkVoxel.getSection(depth);
+            VoxelTreeElement* child = path[depth]->getChildAtIndex(childIndex);
+
+            // If the branch we need to traverse does not exist, then create it on the way down...
+            if (!child) {
+                child = path[depth]->addChildAtIndex(childIndex);
+            }
+            path[depth + 1] = child;
+            subtreeChanged[depth + 1] = false;
+        }
+        if (colorVoxel(path[depth], bulkVoxel.color, destructive) && depth > 0) {
+            subtreeChanged[depth - 1] = true;
+        }
+    }
+    for (; depth >= 0; depth--) {
+        if (subtreeChanged[depth]) {
+            path[depth]->handleSubtreeChanged(this);
+            if (depth > 0) {
+                subtreeChanged[depth - 1] = true;
+            }
+        }
+    }
+
+    // anything too small for the bulk path goes in one at a time, after the rest whatever its place in the batch
+    foreach (const VoxelDetail& voxel, tooSmall) {
+        unsigned char* voxelData = pointToVoxel(voxel.x, voxel.y, voxel.z, voxel.s, voxel.red, voxel.green, voxel.blue);
+        readCodeColorBufferToTree(voxelData, destructive);
+        delete[] voxelData;
+    }
+
+    unlock();
+}
+
 bool VoxelTree::handlesEditPacketType(PacketType packetType) const {
     // we handle these types of "edit" packets
     switch (packetType) {
@@ -504,6 +763,10 @@ bool VoxelTree::handlesEditPacketType(PacketType packetType) const {
     }
 }
 
+void VoxelTree::copySnapshotColor(const OctreeElement* element, unsigned char* color) const {
+    memcpy(color, static_cast<const VoxelTreeElement*>(element)->getColor(), BYTES_PER_COLOR);
+}
+
 const unsigned int REPORT_OVERFLOW_WARNING_INTERVAL = 100;
 unsigned int overflowWarnings = 0;
 int VoxelTree::processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
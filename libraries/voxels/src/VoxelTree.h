@@ -30,6 +30,12 @@ public:
     void createVoxel(float x, float y, float z, float s,
                      unsigned char red, unsigned char green, unsigned char blue, bool destructive = false);
 
+    /// Creates a batch of voxels under a single write lock, with the same result as creating them one at a time in order.
+    /// The voxels are sorted by octal code so the tree is walked once, and each changed element is reaveraged once, after
+    /// everything beneath it is in place.
+    /// \param progressFrom if under 100, importProgress() is emitted from there to 100 as the voxels go in
+    void createVoxels(const QVector<VoxelDetail>& voxels, bool destructive = false, int progressFrom = 100);
+
     void nudgeSubTree(VoxelTreeElement* elementToNudge, const glm::vec3& nudgeAmount, VoxelEditPacketSender& voxelEditSender);
 
     /// reads voxels from square image with alpha as a Y-axis
@@ -45,6 +51,8 @@ public:
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& node);
 
+    virtual void copySnapshotColor(const OctreeElement* element, unsigned char* color) const;
+
 private:
     // helper functions for nudgeSubTree
     void recurseNodeForNudge(VoxelTreeElement* element, RecurseOctreeOperation operation, void* extraData);
@@ -52,6 +60,10 @@ private:
     void nudgeLeaf(VoxelTreeElement* element, void* extraData);
     void chunkifyLeaf(VoxelTreeElement* element);
     void readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadCodeColorBufferToTreeArgs& args);
+
+    /// Colors the element at the end of a create, clearing its children first if destructive.
+    /// \return true if the element changed
+    bool colorVoxel(VoxelTreeElement* element, const unsigned char* color, bool destructive);
 };
 
 #endif /* defined(__hifi__VoxelTree__) */
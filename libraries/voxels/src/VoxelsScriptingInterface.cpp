@@ -6,6 +6,8 @@
 //  Copyright (c) 2013 HighFidelity, Inc. All rights reserved.
 //
 
+#include <OctreeSnapshot.h>
+
 #include "VoxelsScriptingInterface.h"
 
 void VoxelsScriptingInterface::queueVoxelAdd(PacketType addPacketType, VoxelDetail& addVoxelDetails) {
@@ -83,7 +85,22 @@ void VoxelsScriptingInterface::eraseVoxel(float x, float y, float z, float scale
 
 RayToVoxelIntersectionResult VoxelsScriptingInterface::findRayIntersection(const PickRay& ray) {
     RayToVoxelIntersectionResult result;
-    if (_tree) {
+    QSharedPointer<const OctreeSnapshot> snapshot = _tree ? _tree->getSnapshot() : QSharedPointer<const OctreeSnapshot>();
+    if (snapshot) {
+        // trees that publish snapshots get picked without waiting on, or failing to get, their lock
+        OctreeSnapshotHit hit;
+        result.intersects = snapshot->findRayIntersection(ray.origin, ray.direction, result.distance, result.face, &hit);
+        if (result.intersects) {
+            result.voxel.x = hit.corner.x;
+            result.voxel.y = hit.corner.y;
+            result.voxel.z = hit.corner.z;
+            result.voxel.s = hit.scale;
+            result.voxel.red = hit.color[0];
+            result.voxel.green = hit.color[1];
+            result.voxel.blue = hit.color[2];
+            result.intersection = ray.origin + (ray.direction * result.distance);
+        }
+    } else if (_tree) {
         OctreeElement* element;
         result.intersects = _tree->findRayIntersection(ray.origin, ray.direction, element, result.distance, result.face);
         if (result.intersects) {
@@ -0,0 +1,346 @@
+//
+//  AvatarDataTests.cpp
+//  avatars-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <AvatarData.h>
+#include <HeadData.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <UUID.h>
+
+#include "AvatarDataTests.h"
+
+const int NUM_JOINTS = 24;
+const int NUM_MOVING_JOINTS = 3;
+const float ANGLE_TOLERANCE = 0.01f; // degrees, two byte angles are good to about 0.006
+const float ROTATION_TOLERANCE = 0.001f;
+const float BLENDSHAPE_TOLERANCE = 1.01f / 255.0f; // weights are floored to 8 bits
+const int NUM_BLENDSHAPES = 48;
+
+// lets the tests drive the face tracking state that's normally set by Faceshift or Visage
+class TestHeadData : public HeadData {
+public:
+    TestHeadData(AvatarData* owningAvatar) : HeadData(owningAvatar) { }
+
+    void setFaceTracked(int frame) {
+        _isFaceshiftConnected = true;
+        _leftEyeBlink = _rightEyeBlink = (frame % 10) / 10.0f;
+        _blendshapeCoefficients.resize(NUM_BLENDSHAPES);
+        for (int i = 0; i < NUM_BLENDSHAPES; i++) {
+            _blendshapeCoefficients[i] = 0.5f + 0.5f * sinf(frame * 0.1f + i);
+        }
+    }
+
+    /// Packs the face field as AvatarData does, or as the previous encoding did with floats for the eye blinks and
+    /// blendshapes.
+    QByteArray packFace(bool quantized) const {
+        QByteArray face;
+        face.append((char)_isFaceshiftConnected);
+        if (_isFaceshiftConnected) {
+            appendUnitFloat(face, _leftEyeBlink, quantized);
+            appendUnitFloat(face, _rightEyeBlink, quantized);
+            face.append(reinterpret_cast<const char*>(&_averageLoudness), sizeof(float));
+            face.append(reinterpret_cast<const char*>(&_browAudioLift), sizeof(float));
+            face.append((char)_blendshapeCoefficients.size());
+            foreach (float coefficient, _blendshapeCoefficients) {
+                appendUnitFloat(face, coefficient, quantized);
+            }
+        }
+        return face;
+    }
+
+private:
+    static void appendUnitFloat(QByteArray& buffer, float value, bool quantized) {
+        if (quantized) {
+            unsigned char byte;
+            packFloatToByte(&byte, glm::clamp(value, 0.0f, 1.0f), 1.0f);
+            buffer.append((char)byte);
+        } else {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(float));
+        }
+    }
+};
+
+class TestAvatar : public AvatarData {
+public:
+    TestAvatar() { _headData = new TestHeadData(this); }
+
+    TestHeadData* getTestHeadData() { return static_cast<TestHeadData*>(_headData); }
+};
+
+// moves the avatar the way a walking avatar would: position, body yaw and a few joints change every frame
+static void simulateFrame(AvatarData& avatar, int frame) {
+    avatar.setPosition(glm::vec3(1.0f + frame * 0.01f, 0.5f, 2.0f));
+    avatar.setBodyYaw(-90.0f + frame * 0.5f);
+    for (int i = 0; i < NUM_JOINTS; i++) {
+        float angle = (i < NUM_MOVING_JOINTS) ? frame * 0.05f : i * 0.1f;
+        avatar.setJointData(i, glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+}
+
+// packs the joints field as AvatarData does, or as the previous encoding did with four two byte components per joint
+static QByteArray packJoints(const AvatarData& avatar, bool quantized) {
+    const QVector<JointData>& jointData = avatar.getJointData();
+    QByteArray joints;
+    joints.append((char)jointData.size());
+    unsigned char validity = 0;
+    int validityBit = 0;
+    foreach (const JointData& data, jointData) {
+        if (data.valid) {
+            validity |= (1 << validityBit);
+        }
+        if (++validityBit == BITS_IN_BYTE) {
+            joints.append((char)validity);
+            validityBit = validity = 0;
+        }
+    }
+    if (validityBit != 0) {
+        joints.append((char)validity);
+    }
+    foreach (const JointData& data, jointData) {
+        if (data.valid) {
+            unsigned char rotation[8];
+            int rotationBytes = quantized ? packOrientationQuatToSixBytes(rotation, data.rotation)
+                : packOrientationQuatToBytes(rotation, data.rotation);
+            joints.append(reinterpret_cast<const char*>(rotation), rotationBytes);
+        }
+    }
+    return joints;
+}
+
+static bool matches(const AvatarData& sent, const AvatarData& received) {
+    if (sent.getPosition() != received.getPosition()
+            || glm::abs(sent.getBodyYaw() - received.getBodyYaw()) > ANGLE_TOLERANCE
+            || sent.getJointData().size() != received.getJointData().size()) {
+        return false;
+    }
+    for (int i = 0; i < sent.getJointData().size(); i++) {
+        const JointData& sentJoint = sent.getJointData().at(i);
+        const JointData& receivedJoint = received.getJointData().at(i);
+        if (sentJoint.valid != receivedJoint.valid
+                || glm::abs(glm::dot(sentJoint.rotation, receivedJoint.rotation)) < 1.0f - ROTATION_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AvatarDataTests::deltasRoundTrip() {
+    AvatarData sender;
+    AvatarData receiver;
+    const int NUMBER_OF_FRAMES = AVATAR_KEYFRAME_INTERVAL * 3;
+    int keyframes = 0;
+    for (int frame = 0; frame < NUMBER_OF_FRAMES; frame++) {
+        simulateFrame(sender, frame);
+        QByteArray packed = sender.toByteArray();
+        if (AvatarData::isKeyframe(packed)) {
+            keyframes++;
+        }
+        int bytesRead = receiver.parseDataAtOffset(packed, 0);
+        if (bytesRead != packed.size()) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: frame " << frame << " read " << bytesRead
+                << " of " << packed.size() << " bytes" << std::endl;
+        }
+        if (!matches(sender, receiver)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: receiver doesn't match sender after frame " << frame << std::endl;
+            return;
+        }
+    }
+    if (keyframes != NUMBER_OF_FRAMES / AVATAR_KEYFRAME_INTERVAL) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a keyframe every " << AVATAR_KEYFRAME_INTERVAL
+            << " frames, got " << keyframes << " in " << NUMBER_OF_FRAMES << std::endl;
+    }
+}
+
+void AvatarDataTests::deltasIgnoredUntilNextKeyframe() {
+    AvatarData sender;
+    AvatarData receiver;
+    receiver.setPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+    for (int frame = 0; frame < AVATAR_KEYFRAME_INTERVAL + 1; frame++) {
+        simulateFrame(sender, frame);
+        QByteArray packed = sender.toByteArray();
+        if (frame == 0) {
+            continue; // the first keyframe is lost
+        }
+        receiver.parseDataAtOffset(packed, 0);
+        if (frame < AVATAR_KEYFRAME_INTERVAL && receiver.getPosition() != glm::vec3(0.0f, 0.0f, 0.0f)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: delta applied without its keyframe at frame " << frame << std::endl;
+            return;
+        }
+    }
+    if (!matches(sender, receiver)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: receiver didn't recover at the next keyframe" << std::endl;
+    }
+}
+
+void AvatarDataTests::quantizedJointsAndBlendshapes() {
+    // the smallest three compression has to hold up for whichever component is the largest, and for either sign
+    const int NUMBER_OF_ROTATIONS = 1000;
+    for (int i = 0; i < NUMBER_OF_ROTATIONS; i++) {
+        glm::quat rotation = glm::normalize(glm::quat(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                                      randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f)));
+        unsigned char buffer[6];
+        glm::quat unpacked;
+        int packedBytes = packOrientationQuatToSixBytes(buffer, rotation);
+        int unpackedBytes = unpackOrientationQuatFromSixBytes(buffer, unpacked);
+        if (packedBytes != sizeof(buffer) || unpackedBytes != sizeof(buffer)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected quats to pack into " << sizeof(buffer)
+                << " bytes, packed " << packedBytes << " and unpacked " << unpackedBytes << std::endl;
+            return;
+        }
+        if (glm::abs(glm::dot(rotation, unpacked)) < 1.0f - ROTATION_TOLERANCE) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: quat (" << rotation.x << ", " << rotation.y << ", "
+                << rotation.z << ", " << rotation.w << ") came back as (" << unpacked.x << ", " << unpacked.y << ", "
+                << unpacked.z << ", " << unpacked.w << ")" << std::endl;
+            return;
+        }
+    }
+
+    TestAvatar sender;
+    AvatarData receiver;
+    simulateFrame(sender, 1);
+    sender.getTestHeadData()->setFaceTracked(1);
+    receiver.parseDataAtOffset(sender.toByteArray(true), 0);
+
+    const QVector<float>& sent = sender.getHeadData()->getBlendshapeCoefficients();
+    const QVector<float>& received = receiver.getHeadData()->getBlendshapeCoefficients();
+    if (sent.size() != received.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: sent " << sent.size() << " blendshapes, received "
+            << received.size() << std::endl;
+        return;
+    }
+    for (int i = 0; i < sent.size(); i++) {
+        if (glm::abs(sent.at(i) - received.at(i)) > BLENDSHAPE_TOLERANCE) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: blendshape " << i << " sent as " << sent.at(i)
+                << " came back as " << received.at(i) << std::endl;
+            return;
+        }
+    }
+    if (!matches(sender, receiver)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: face tracked receiver doesn't match sender" << std::endl;
+    }
+}
+
+void AvatarDataTests::reportBytesPerUpdate() {
+    AvatarData fullSender;
+    AvatarData deltaSender;
+    const int NUMBER_OF_FRAMES = AVATAR_KEYFRAME_INTERVAL * 10;
+    int fullBytes = 0;
+    int deltaBytes = 0;
+    for (int frame = 0; frame < NUMBER_OF_FRAMES; frame++) {
+        simulateFrame(fullSender, frame);
+        simulateFrame(deltaSender, frame);
+        fullBytes += fullSender.toByteArray(true).size();
+        deltaBytes += deltaSender.toByteArray().size();
+    }
+    std::cout << "AvatarData bytes per update with " << NUM_JOINTS << " joints (" << NUM_MOVING_JOINTS << " moving): "
+        << "full state " << (float)fullBytes / NUMBER_OF_FRAMES
+        << ", delta " << (float)deltaBytes / NUMBER_OF_FRAMES << std::endl;
+}
+
+void AvatarDataTests::reportMixerEgressAtFiftyAvatars() {
+    // every listener is sent every other avatar, so the mixer's egress grows with the square of the avatar count
+    const int NUMBER_OF_AVATARS = 50;
+    const int MIXER_FRAMES_PER_SECOND = 60;
+    const int NUMBER_OF_FRAMES = AVATAR_KEYFRAME_INTERVAL * 2;
+
+    QVector<TestAvatar*> avatars;
+    for (int i = 0; i < NUMBER_OF_AVATARS; i++) {
+        avatars.append(new TestAvatar());
+    }
+    // the face and joints of each avatar's last keyframe in the previous encoding, which its deltas were compared with
+    QVector<QByteArray> previousKeyframeFaces(NUMBER_OF_AVATARS);
+    QVector<QByteArray> previousKeyframeJoints(NUMBER_OF_AVATARS);
+    int headerBytes = numBytesForPacketHeaderGivenPacketType(PacketTypeBulkAvatarData);
+    int availableBytes = MAX_PACKET_SIZE - headerBytes;
+
+    quint64 quantizedBytes = 0;
+    quint64 previousBytes = 0;
+    bool encodingMatches = true;
+    for (int frame = 0; frame < NUMBER_OF_FRAMES; frame++) {
+        int quantizedFrameBytes = 0;
+        int previousFrameBytes = 0;
+        for (int i = 0; i < NUMBER_OF_AVATARS; i++) {
+            // stagger the avatars so they aren't all sending keyframes on the same frame
+            simulateFrame(*avatars[i], frame + i);
+            avatars[i]->getTestHeadData()->setFaceTracked(frame + i);
+            QByteArray packed = avatars[i]->toByteArray();
+            bool keyframe = AvatarData::isKeyframe(packed);
+            uint16_t fieldMask = 0;
+            if (!keyframe) {
+                memcpy(&fieldMask, packed.constData() + 2, sizeof(fieldMask));
+            }
+
+            QByteArray face = avatars[i]->getTestHeadData()->packFace(true);
+            QByteArray joints = packJoints(*avatars[i], true);
+            if (keyframe && encodingMatches && !packed.endsWith(joints)) {
+                std::cout << __FILE__ << ":" << __LINE__
+                    << " ERROR: the test's joint encoding doesn't match what AvatarData sent" << std::endl;
+                encodingMatches = false;
+            }
+            QByteArray previousFace = avatars[i]->getTestHeadData()->packFace(false);
+            QByteArray previousJoints = packJoints(*avatars[i], false);
+            if (keyframe) {
+                previousKeyframeFaces[i] = previousFace;
+                previousKeyframeJoints[i] = previousJoints;
+            }
+
+            // the same packet with the face and joints, where it has them, swapped for their previous encoding, and
+            // with them added where that encoding would have found them changed since its keyframe
+            int previousPackedBytes = packed.size();
+            if (keyframe || (fieldMask & (1 << AVATAR_FIELD_FACE))) {
+                previousPackedBytes -= face.size();
+            }
+            if (keyframe || (fieldMask & (1 << AVATAR_FIELD_JOINTS))) {
+                previousPackedBytes -= joints.size();
+            }
+            if (keyframe || previousFace != previousKeyframeFaces[i]) {
+                previousPackedBytes += previousFace.size();
+            }
+            if (keyframe || previousJoints != previousKeyframeJoints[i]) {
+                previousPackedBytes += previousJoints.size();
+            }
+            quantizedFrameBytes += NUM_BYTES_RFC4122_UUID + packed.size();
+            previousFrameBytes += NUM_BYTES_RFC4122_UUID + previousPackedBytes;
+        }
+        // each listener gets everyone else, split up into as many packets as it takes
+        int listenerQuantizedBytes = quantizedFrameBytes * (NUMBER_OF_AVATARS - 1) / NUMBER_OF_AVATARS;
+        int listenerPreviousBytes = previousFrameBytes * (NUMBER_OF_AVATARS - 1) / NUMBER_OF_AVATARS;
+        quantizedBytes += NUMBER_OF_AVATARS * (listenerQuantizedBytes
+            + headerBytes * (listenerQuantizedBytes / availableBytes + 1));
+        previousBytes += NUMBER_OF_AVATARS * (listenerPreviousBytes
+            + headerBytes * (listenerPreviousBytes / availableBytes + 1));
+    }
+    foreach (TestAvatar* avatar, avatars) {
+        delete avatar;
+    }
+
+    const float BITS_PER_MEGABIT = 1000000.0f;
+    float quantizedMegabits = (float)quantizedBytes * BITS_IN_BYTE * MIXER_FRAMES_PER_SECOND / NUMBER_OF_FRAMES
+        / BITS_PER_MEGABIT;
+    float previousMegabits = (float)previousBytes * BITS_IN_BYTE * MIXER_FRAMES_PER_SECOND / NUMBER_OF_FRAMES
+        / BITS_PER_MEGABIT;
+    std::cout << "Avatar mixer egress at " << NUMBER_OF_AVATARS << " face tracked avatars: "
+        << "previous encoding " << previousMegabits << " Mbps, "
+        << "quantized " << quantizedMegabits << " Mbps" << std::endl;
+}
+
+void AvatarDataTests::runAllTests() {
+    deltasRoundTrip();
+    deltasIgnoredUntilNextKeyframe();
+    quantizedJointsAndBlendshapes();
+    reportBytesPerUpdate();
+    reportMixerEgressAtFiftyAvatars();
+}
@@ -0,0 +1,23 @@
+//
+//  AvatarDataTests.h
+//  avatars-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__AvatarDataTests__
+#define __tests__AvatarDataTests__
+
+namespace AvatarDataTests {
+
+    void deltasRoundTrip();
+    void deltasIgnoredUntilNextKeyframe();
+    void quantizedJointsAndBlendshapes();
+
+    void reportBytesPerUpdate();
+    void reportMixerEgressAtFiftyAvatars();
+
+    void runAllTests();
+}
+
+#endif // __tests__AvatarDataTests__
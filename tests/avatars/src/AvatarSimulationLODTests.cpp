@@ -0,0 +1,410 @@
+//
+//  AvatarSimulationLODTests.cpp
+//  avatars-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <AvatarData.h>
+#include <AvatarHashMap.h>
+#include <AvatarSimulationLOD.h>
+#include <HeadData.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <UUID.h>
+#include <WorkStealingPool.h>
+
+#include "AvatarSimulationLODTests.h"
+
+const quint64 USECS_PER_FRAME = USECS_PER_SECOND / 60;
+
+// roughly the skeleton and face of the default avatar
+const int NUM_JOINTS = 60;
+const int NUM_BLENDSHAPES = 48;
+const int NUM_BLENDED_VERTICES = 2000;
+
+/// The interface's Avatar as far as it goes without a GL context: parses the same data and goes through the same tiers,
+/// and when simulated walks its joint chain the way Model::updateJointState does, blends reduced rate joints the way
+/// Model::interpolateJoints does and blends its face the way Model's Blender does.
+class BenchmarkAvatar : public AvatarData {
+public:
+    BenchmarkAvatar() :
+        _modelsDirty(true),
+        _lastJointsUpdate(0),
+        _tier(AvatarSimulationLOD::FULL_TIER),
+        _needsJoints(false),
+        _isReducedRate(false),
+        _isInterpolating(false),
+        _hasLatestRotations(false),
+        _jointInterpolation(1.0f),
+        _shownInterpolation(1.0f),
+        _jointRotations(NUM_JOINTS),
+        _previousRotations(NUM_JOINTS),
+        _latestRotations(NUM_JOINTS),
+        _jointTransforms(NUM_JOINTS),
+        _baseVertices(NUM_BLENDED_VERTICES),
+        _blendedVertices(NUM_BLENDED_VERTICES),
+        _blendshapeDeltas(NUM_BLENDSHAPES * NUM_BLENDED_VERTICES) {
+        _headData = new HeadData(this);
+        for (int i = 0; i < _blendshapeDeltas.size(); i++) {
+            _blendshapeDeltas[i] = glm::vec3(0.001f * (i % 7), 0.001f * (i % 5), 0.001f * (i % 3));
+        }
+    }
+
+    virtual int parseDataAtOffset(const QByteArray& packet, int offset) {
+        // as Avatar does, note that the models need updating
+        _modelsDirty = true;
+        return AvatarData::parseDataAtOffset(packet, offset);
+    }
+
+    AvatarSimulationLOD::Tier getTier() const { return _tier; }
+
+    /// Like Avatar::beginSimulate, picks the tier and returns whether there's joint work for a worker.
+    bool beginSimulate(const AvatarSimulationLOD& simulationLOD, const glm::vec3& cameraPosition, quint64 now) {
+        // the camera looks down negative z
+        bool inView = (_position.z < cameraPosition.z);
+        _tier = simulationLOD.getTier(glm::distance(cameraPosition, _position) / _targetScale, inView);
+        _needsJoints = false;
+        _isInterpolating = false;
+        if (_tier == AvatarSimulationLOD::FROZEN_TIER) {
+            return false;
+        }
+        bool jointsDue = simulationLOD.isJointUpdateDue(_tier, _lastJointsUpdate, now);
+        if (jointsDue) {
+            _lastJointsUpdate = now;
+        }
+        _isReducedRate = (_tier == AvatarSimulationLOD::REDUCED_RATE_TIER);
+        _needsJoints = _modelsDirty && jointsDue;
+        if (_needsJoints) {
+            _modelsDirty = false;
+        }
+        _jointInterpolation = simulationLOD.getJointInterpolation(_lastJointsUpdate, now);
+        _isInterpolating = !_needsJoints && _isReducedRate && _hasLatestRotations && _shownInterpolation < 1.0f;
+        return _needsJoints || _isInterpolating;
+    }
+
+    /// Like Avatar::simulateJoints, runs on a worker.
+    void simulateJoints() {
+        if (_needsJoints) {
+            for (int i = 0; i < NUM_JOINTS; i++) {
+                _jointRotations[i] = (i < _jointData.size()) ? _jointData.at(i).rotation : glm::quat();
+            }
+            if (!_isReducedRate) {
+                _hasLatestRotations = false;
+                updateJoints();
+                return;
+            }
+            // start from where the joints are shown, unless they've only just started blending
+            for (int i = 0; i < NUM_JOINTS; i++) {
+                _previousRotations[i] = _hasLatestRotations ? safeMix(_previousRotations.at(i),
+                    _latestRotations.at(i), _shownInterpolation) : _jointRotations.at(i);
+                _latestRotations[i] = _jointRotations.at(i);
+            }
+            interpolateJoints(_hasLatestRotations ? 0.0f : 1.0f);
+            _hasLatestRotations = true;
+
+        } else if (_isInterpolating) {
+            interpolateJoints(_jointInterpolation);
+        }
+    }
+
+    /// Like Avatar::finishSimulate, blends the face of avatars near enough to see it.
+    void finishSimulate(quint64 now) {
+        if (_tier == AvatarSimulationLOD::FULL_TIER) {
+            blend(now);
+        }
+    }
+
+private:
+    void interpolateJoints(float proportion) {
+        _shownInterpolation = proportion;
+        for (int i = 0; i < NUM_JOINTS; i++) {
+            _jointRotations[i] = safeMix(_previousRotations.at(i), _latestRotations.at(i), proportion);
+        }
+        updateJoints();
+    }
+
+    void updateJoints() {
+        // a chain, like Model::updateJointState walking parents before children
+        glm::mat4 parentTransform = glm::translate(glm::mat4(), _position);
+        for (int i = 0; i < NUM_JOINTS; i++) {
+            _jointTransforms[i] = parentTransform * glm::translate(glm::mat4(), glm::vec3(0.0f, 0.1f, 0.0f)) *
+                glm::mat4_cast(_jointRotations.at(i));
+            parentTransform = _jointTransforms[i];
+        }
+    }
+
+    void blend(quint64 now) {
+        // like Blender::run: start from the base mesh and add each blendshape in proportion to its coefficient
+        _blendedVertices = _baseVertices;
+        for (int i = 0; i < NUM_BLENDSHAPES; i++) {
+            float coefficient = 0.5f + 0.5f * sinf(now * 0.000001f + i);
+            const glm::vec3* deltas = _blendshapeDeltas.constData() + i * NUM_BLENDED_VERTICES;
+            for (int j = 0; j < NUM_BLENDED_VERTICES; j++) {
+                _blendedVertices[j] += deltas[j] * coefficient;
+            }
+        }
+    }
+
+    bool _modelsDirty;
+    quint64 _lastJointsUpdate;
+    AvatarSimulationLOD::Tier _tier;
+    bool _needsJoints;
+    bool _isReducedRate;
+    bool _isInterpolating;
+    bool _hasLatestRotations;
+    float _jointInterpolation;
+    float _shownInterpolation;
+    QVector<glm::quat> _jointRotations;
+    QVector<glm::quat> _previousRotations;
+    QVector<glm::quat> _latestRotations;
+    QVector<glm::mat4> _jointTransforms;
+    QVector<glm::vec3> _baseVertices;
+    QVector<glm::vec3> _blendedVertices;
+    QVector<glm::vec3> _blendshapeDeltas;
+};
+
+class SenderAvatar : public AvatarData {
+public:
+    SenderAvatar() { _headData = new HeadData(this); }
+};
+
+/// Runs one avatar's joints on a worker, like AvatarManager's AvatarJointsTask.
+class BenchmarkJointsTask : public WorkStealingTask {
+public:
+    BenchmarkJointsTask() : avatar(NULL) { }
+
+    virtual void run() { avatar->simulateJoints(); }
+
+    BenchmarkAvatar* avatar;
+};
+
+/// The interface's AvatarManager as far as it goes without a GL context: takes bulk avatar data packets from the mixer
+/// and simulates every avatar they describe, fanning the joints out across the work stealing pool.
+class BenchmarkAvatarManager : public AvatarHashMap {
+public:
+    void processAvatarDataPacket(const QByteArray& datagram) {
+        int bytesRead = numBytesForPacketHeader(datagram);
+        while (bytesRead < datagram.size()) {
+            QUuid nodeUUID = QUuid::fromRfc4122(datagram.mid(bytesRead, NUM_BYTES_RFC4122_UUID));
+            bytesRead += NUM_BYTES_RFC4122_UUID;
+
+            AvatarSharedPointer matchingAvatar = _avatarHash.value(nodeUUID);
+            if (!matchingAvatar) {
+                matchingAvatar = AvatarSharedPointer(new BenchmarkAvatar());
+                _avatarHash.insert(nodeUUID, matchingAvatar);
+            }
+            bytesRead += matchingAvatar->parseDataAtOffset(datagram, bytesRead);
+        }
+    }
+
+    void updateOtherAvatars(const AvatarSimulationLOD& simulationLOD, quint64 now, int* tierCounts) {
+        QVector<BenchmarkJointsTask> tasks;
+        for (AvatarHash::iterator it = _avatarHash.begin(); it != _avatarHash.end(); it++) {
+            BenchmarkAvatar* avatar = static_cast<BenchmarkAvatar*>(it.value().data());
+            if (avatar->beginSimulate(simulationLOD, glm::vec3(), now)) {
+                tasks.resize(tasks.size() + 1);
+                tasks.last().avatar = avatar;
+            }
+        }
+        WorkStealingPool* pool = WorkStealingPool::getInstance();
+        WorkStealingGroup group;
+        for (int i = 0; i < tasks.size(); i++) {
+            pool->start(&tasks[i], group);
+        }
+        pool->wait(group);
+
+        for (AvatarHash::iterator it = _avatarHash.begin(); it != _avatarHash.end(); it++) {
+            BenchmarkAvatar* avatar = static_cast<BenchmarkAvatar*>(it.value().data());
+            avatar->finishSimulate(now);
+            tierCounts[avatar->getTier()]++;
+        }
+    }
+};
+
+void AvatarSimulationLODTests::tiersByDistanceAndView() {
+    AvatarSimulationLOD simulationLOD;
+    simulationLOD.setBlendshapeDistance(5.0f);
+    simulationLOD.setReducedRateDistance(10.0f);
+
+    struct Case {
+        float distance;
+        bool inView;
+        AvatarSimulationLOD::Tier tier;
+    };
+    const Case CASES[] = {
+        { 1.0f, true, AvatarSimulationLOD::FULL_TIER },
+        { 5.0f, true, AvatarSimulationLOD::FULL_TIER },
+        { 7.0f, true, AvatarSimulationLOD::NO_BLENDSHAPES_TIER },
+        { 10.0f, true, AvatarSimulationLOD::NO_BLENDSHAPES_TIER },
+        { 20.0f, true, AvatarSimulationLOD::REDUCED_RATE_TIER },
+        { 1.0f, false, AvatarSimulationLOD::FROZEN_TIER },
+        { 20.0f, false, AvatarSimulationLOD::FROZEN_TIER }
+    };
+    for (unsigned int i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        AvatarSimulationLOD::Tier tier = simulationLOD.getTier(CASES[i].distance, CASES[i].inView);
+        if (tier != CASES[i].tier) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: an avatar " << CASES[i].distance << "m away"
+                << (CASES[i].inView ? "" : " out of view") << " was simulated "
+                << AvatarSimulationLOD::getTierName(tier) << " rather than "
+                << AvatarSimulationLOD::getTierName(CASES[i].tier) << std::endl;
+        }
+    }
+}
+
+void AvatarSimulationLODTests::reducedRateSpacesJointUpdates() {
+    AvatarSimulationLOD simulationLOD;
+    simulationLOD.setReducedRate(10.0f);
+
+    // a second of frames should see ten updates of a reduced rate avatar, and none of a frozen one
+    const int FRAMES = 60;
+    int reducedUpdates = 0;
+    int frozenUpdates = 0;
+    int fullUpdates = 0;
+    quint64 lastReduced = 0;
+    quint64 lastFrozen = 0;
+    quint64 lastFull = 0;
+    for (int frame = 1; frame <= FRAMES; frame++) {
+        quint64 now = USECS_PER_SECOND + frame * USECS_PER_FRAME;
+        if (simulationLOD.isJointUpdateDue(AvatarSimulationLOD::REDUCED_RATE_TIER, lastReduced, now)) {
+            lastReduced = now;
+            reducedUpdates++;
+        }
+        if (simulationLOD.isJointUpdateDue(AvatarSimulationLOD::FROZEN_TIER, lastFrozen, now)) {
+            lastFrozen = now;
+            frozenUpdates++;
+        }
+        if (simulationLOD.isJointUpdateDue(AvatarSimulationLOD::FULL_TIER, lastFull, now)) {
+            lastFull = now;
+            fullUpdates++;
+        }
+    }
+    if (reducedUpdates != 10 || frozenUpdates != 0 || fullUpdates != FRAMES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: over " << FRAMES << " frames, expected 10 reduced rate, "
+            << "0 frozen and " << FRAMES << " full updates; got " << reducedUpdates << ", " << frozenUpdates << " and "
+            << fullUpdates << std::endl;
+    }
+}
+
+void AvatarSimulationLODTests::reducedRateInterpolatesJoints() {
+    AvatarSimulationLOD simulationLOD;
+    simulationLOD.setReducedRate(10.0f);
+
+    // between updates a tenth of a second apart, the joints should blend steadily from one to the next, then hold
+    quint64 lastUpdate = USECS_PER_SECOND;
+    float lastInterpolation = 0.0f;
+    for (int frame = 0; frame <= 6; frame++) {
+        float interpolation = simulationLOD.getJointInterpolation(lastUpdate, lastUpdate + frame * USECS_PER_FRAME);
+        float expected = frame / 6.0f;
+        if (glm::abs(interpolation - expected) > 0.01f || interpolation < lastInterpolation) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << frame
+                << " frames after an update, the joints were " << interpolation << " of the way to it rather than "
+                << expected << std::endl;
+            return;
+        }
+        lastInterpolation = interpolation;
+    }
+    float held = simulationLOD.getJointInterpolation(lastUpdate, lastUpdate + USECS_PER_SECOND);
+    if (held != 1.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a second after an update, the joints were " << held
+            << " of the way to it rather than all the way" << std::endl;
+    }
+
+    simulationLOD.setReducedRate(0.0f);
+    float everyFrame = simulationLOD.getJointInterpolation(lastUpdate, lastUpdate);
+    if (everyFrame != 1.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: with joints updating every frame, they were " << everyFrame
+            << " of the way to the latest rather than all the way" << std::endl;
+    }
+}
+
+// runs a scene of avatars standing around us for a few seconds, returning the usecs spent simulating them each frame
+static quint64 runScene(const AvatarSimulationLOD& simulationLOD, int* tierCounts) {
+    const int NUM_AVATARS = 100;
+    const float MAX_DISTANCE = 60.0f;
+    const int FRAMES = 180;
+
+    QVector<SenderAvatar*> senders;
+    QVector<QUuid> senderUUIDs;
+    for (int i = 0; i < NUM_AVATARS; i++) {
+        SenderAvatar* sender = new SenderAvatar();
+        // spread out in distance and all the way around us, so that about half are behind
+        float distance = 1.0f + MAX_DISTANCE * i / NUM_AVATARS;
+        float angle = i * 2.4f;
+        sender->setPosition(glm::vec3(distance * sinf(angle), 0.0f, distance * cosf(angle)));
+        senders.append(sender);
+        senderUUIDs.append(QUuid::createUuid());
+    }
+
+    BenchmarkAvatarManager manager;
+    quint64 simulateUsecs = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        // the mixer sends everyone, packed into as few packets as fit
+        QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeBulkAvatarData);
+        int headerBytes = packet.size();
+        for (int i = 0; i < NUM_AVATARS; i++) {
+            for (int j = 0; j < NUM_JOINTS; j++) {
+                senders[i]->setJointData(j, glm::angleAxis(0.01f * (frame + i + j), glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+            QByteArray avatarBytes = senderUUIDs.at(i).toRfc4122() + senders[i]->toByteArray(true);
+            if (packet.size() + avatarBytes.size() > MAX_PACKET_SIZE && packet.size() > headerBytes) {
+                manager.processAvatarDataPacket(packet);
+                packet.resize(headerBytes);
+            }
+            packet.append(avatarBytes);
+        }
+        manager.processAvatarDataPacket(packet);
+
+        memset(tierCounts, 0, AvatarSimulationLOD::TIER_COUNT * sizeof(int));
+        quint64 start = usecTimestampNow();
+        manager.updateOtherAvatars(simulationLOD, USECS_PER_SECOND + frame * USECS_PER_FRAME, tierCounts);
+        simulateUsecs += usecTimestampNow() - start;
+    }
+    foreach (SenderAvatar* sender, senders) {
+        delete sender;
+    }
+    return simulateUsecs / FRAMES;
+}
+
+void AvatarSimulationLODTests::benchmarkHundredAvatars() {
+    // everything in view simulated in full, as it was before the distance tiers
+    int untieredCounts[AvatarSimulationLOD::TIER_COUNT];
+    AvatarSimulationLOD untiered;
+    const float EVERYWHERE = 1000000.0f;
+    untiered.setBlendshapeDistance(EVERYWHERE);
+    untiered.setReducedRateDistance(EVERYWHERE);
+    quint64 untieredUsecs = runScene(untiered, untieredCounts);
+
+    int tierCounts[AvatarSimulationLOD::TIER_COUNT];
+    AvatarSimulationLOD tiered;
+    quint64 tieredUsecs = runScene(tiered, tierCounts);
+
+    std::cout << "100 avatars, usecs per frame with the distance tiers out of reach: " << untieredUsecs
+        << ", with the default tiers: " << tieredUsecs << " (";
+    for (int i = 0; i < AvatarSimulationLOD::TIER_COUNT; i++) {
+        std::cout << (i == 0 ? "" : ", ") << tierCounts[i] << " "
+            << AvatarSimulationLOD::getTierName((AvatarSimulationLOD::Tier)i);
+    }
+    std::cout << ")" << std::endl;
+
+    if (tierCounts[AvatarSimulationLOD::FROZEN_TIER] == 0 || tierCounts[AvatarSimulationLOD::REDUCED_RATE_TIER] == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the scene didn't spread the avatars across the tiers"
+            << std::endl;
+    }
+}
+
+void AvatarSimulationLODTests::runAllTests() {
+    tiersByDistanceAndView();
+    reducedRateSpacesJointUpdates();
+    reducedRateInterpolatesJoints();
+
+    benchmarkHundredAvatars();
+}
@@ -0,0 +1,22 @@
+//
+//  AvatarSimulationLODTests.h
+//  avatars-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__AvatarSimulationLODTests__
+#define __tests__AvatarSimulationLODTests__
+
+namespace AvatarSimulationLODTests {
+
+    void tiersByDistanceAndView();
+    void reducedRateSpacesJointUpdates();
+    void reducedRateInterpolatesJoints();
+
+    void benchmarkHundredAvatars();
+
+    void runAllTests();
+}
+
+#endif // __tests__AvatarSimulationLODTests__
@@ -0,0 +1,13 @@
+//
+//  main.cpp
+//  avatars-tests
+//
+
+#include "AvatarDataTests.h"
+#include "AvatarSimulationLODTests.h"
+
+int main(int argc, char** argv) {
+    AvatarDataTests::runAllTests();
+    AvatarSimulationLODTests::runAllTests();
+    return 0;
+}
@@ -31,8 +31,11 @@ static int reliableMessagesSent = 0;
 static int reliableMessagesReceived = 0;
 static int streamedBytesSent = 0;
 static int streamedBytesReceived = 0;
-static int sharedObjectsCreated = 0;
-static int sharedObjectsDestroyed = 0;
+static QAtomicInt sharedObjectsCreated(0);
+static QAtomicInt sharedObjectsDestroyed(0);
+
+static bool testConcurrentSharedObjects();
+static bool testParallelGuide();
 
 bool MetavoxelTests::run() {
     
@@ -61,7 +64,11 @@ bool MetavoxelTests::run() {
     qDebug() << "Sent" << reliableMessagesSent << "reliable messages, received" << reliableMessagesReceived;
     qDebug() << "Sent" << streamedBytesSent << "streamed bytes, received" << streamedBytesReceived;
     qDebug() << "Sent" << datagramsSent << "datagrams, received" << datagramsReceived;
-    qDebug() << "Created" << sharedObjectsCreated << "shared objects, destroyed" << sharedObjectsDestroyed;
+    qDebug() << "Created" << sharedObjectsCreated.load() << "shared objects, destroyed" << sharedObjectsDestroyed.load();
+    
+    if (testConcurrentSharedObjects() || testParallelGuide()) {
+        return true;
+    }
     
     qDebug() << "All tests passed!";
     
@@ -309,11 +316,11 @@ void Endpoint::readReliableChannel() {
 
 TestSharedObjectA::TestSharedObjectA(float foo) :
         _foo(foo) {
-    sharedObjectsCreated++;    
+    sharedObjectsCreated.ref();
 }
 
 TestSharedObjectA::~TestSharedObjectA() {
-    sharedObjectsDestroyed++;
+    sharedObjectsDestroyed.ref();
 }
 
 void TestSharedObjectA::setFoo(float foo) {
@@ -323,9 +330,236 @@ void TestSharedObjectA::setFoo(float foo) {
 }
 
 TestSharedObjectB::TestSharedObjectB() {
-    sharedObjectsCreated++;
+    sharedObjectsCreated.ref();
 }
 
 TestSharedObjectB::~TestSharedObjectB() {
-    sharedObjectsDestroyed++;
+    sharedObjectsDestroyed.ref();
+}
+
+static bool testConcurrentSharedObjects() {
+    qDebug() << "Running concurrent shared object test...";
+    
+    int registeredBefore = SharedObject::getWeakHash().size();
+    int destroyedBefore = sharedObjectsDestroyed.load();
+    int createdBefore = sharedObjectsCreated.load();
+    
+    const int OBJECT_COUNT = 64;
+    QVector<SharedObjectPointer> objects;
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        objects.append(new TestSharedObjectA(i));
+    }
+    
+    const int THREAD_COUNT = 8;
+    QVector<SharedObjectStressThread*> threads;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.append(new SharedObjectStressThread(objects, i + 1));
+    }
+    foreach (SharedObjectStressThread* thread, threads) {
+        thread->start();
+    }
+    int lookupFailures = 0;
+    foreach (SharedObjectStressThread* thread, threads) {
+        thread->wait();
+        lookupFailures += thread->getLookupFailures();
+        delete thread;
+    }
+    if (lookupFailures > 0) {
+        qDebug() << lookupFailures << "lookups of live shared objects failed.";
+        return true;
+    }
+    foreach (const SharedObjectPointer& object, objects) {
+        if (object->getReferenceCount() != 1) {
+            qDebug() << "Shared object has" << object->getReferenceCount() << "references once the threads are done, "
+                "expected 1.";
+            return true;
+        }
+    }
+    objects.clear();
+    
+    int created = sharedObjectsCreated.load() - createdBefore;
+    int destroyed = sharedObjectsDestroyed.load() - destroyedBefore;
+    if (created != destroyed) {
+        qDebug() << "Created" << created << "shared objects under contention, but destroyed" << destroyed;
+        return true;
+    }
+    if (SharedObject::getWeakHash().size() != registeredBefore) {
+        qDebug() << "Registry holds" << SharedObject::getWeakHash().size() << "objects, expected" << registeredBefore;
+        return true;
+    }
+    qDebug() << "Created and destroyed" << created << "shared objects from" << THREAD_COUNT << "threads";
+    return false;
+}
+
+static bool testParallelGuide() {
+    qDebug() << "Running parallel guide test...";
+    
+    const int RESOLUTION = 32;
+    const int LEAF_COUNT = RESOLUTION * RESOLUTION * RESOLUTION;
+    const int PARALLEL_LEVELS = 2;
+    
+    MetavoxelData serialData;
+    ColorGridWriteVisitor serialWriter(RESOLUTION, 0);
+    serialData.guide(serialWriter);
+    
+    MetavoxelData parallelData;
+    ColorGridWriteVisitor parallelWriter(RESOLUTION, 0);
+    parallelWriter.setParallelLevels(PARALLEL_LEVELS);
+    parallelData.guide(parallelWriter);
+    
+    // each tree should read back the same whether it's toured serially or in parallel
+    MetavoxelData* trees[] = { &serialData, &parallelData };
+    for (int i = 0; i < 2; i++) {
+        for (int levels = 0; levels <= PARALLEL_LEVELS; levels += PARALLEL_LEVELS) {
+            ColorGridCheckVisitor checker(RESOLUTION, 0);
+            checker.setParallelLevels(levels);
+            trees[i]->guide(checker);
+            if (checker.getLeafCount() != LEAF_COUNT || checker.getMismatchCount() != 0) {
+                qDebug() << "Tour with" << levels << "parallel levels found" << checker.getLeafCount() << "leaves and"
+                    << checker.getMismatchCount() << "mismatches, expected" << LEAF_COUNT << "leaves.";
+                return true;
+            }
+        }
+    }
+    
+    // recolor copies of one tree from several threads at once, which share (and release) its nodes as they go
+    const int THREAD_COUNT = 4;
+    QVector<MetavoxelStressThread*> threads;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.append(new MetavoxelStressThread(parallelData, RESOLUTION, i + 1));
+    }
+    foreach (MetavoxelStressThread* thread, threads) {
+        thread->start();
+    }
+    int failures = 0;
+    foreach (MetavoxelStressThread* thread, threads) {
+        thread->wait();
+        failures += thread->getFailures();
+        delete thread;
+    }
+    if (failures > 0) {
+        qDebug() << failures << "concurrent tours didn't read back what they wrote.";
+        return true;
+    }
+    
+    // the copies mustn't have touched the original
+    ColorGridCheckVisitor checker(RESOLUTION, 0);
+    parallelData.guide(checker);
+    if (checker.getMismatchCount() != 0) {
+        qDebug() << "Recoloring copies changed" << checker.getMismatchCount() << "leaves of the original.";
+        return true;
+    }
+    return false;
+}
+
+/// Steps a linear congruential generator; rand() isn't safe to share between threads.
+static uint nextRandom(uint& seed) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+SharedObjectStressThread::SharedObjectStressThread(const QVector<SharedObjectPointer>& objects, int seed) :
+    _objects(objects),
+    _seed(seed),
+    _lookupFailures(0) {
+}
+
+void SharedObjectStressThread::run() {
+    const int REFERENCE_COUNT = 8;
+    SharedObjectPointer references[REFERENCE_COUNT];
+    
+    const int ITERATIONS = 200000;
+    for (int i = 0; i < ITERATIONS; i++) {
+        SharedObjectPointer& reference = references[nextRandom(_seed) % REFERENCE_COUNT];
+        const SharedObjectPointer& object = _objects.at(nextRandom(_seed) % _objects.size());
+        switch (nextRandom(_seed) % 4) {
+            case 0:
+                reference = object;
+                break;
+                
+            case 1:
+                reference.reset();
+                break;
+                
+            case 2:
+                reference = new TestSharedObjectB();
+                break;
+                
+            case 3:
+                if (SharedObject::getObject(object->getID()) != object) {
+                    _lookupFailures++;
+                }
+                break;
+        }
+    }
+    _objects.clear();
+}
+
+static QRgb getGridColor(const glm::vec3& minimum, int resolution, int tint) {
+    // the data spans -0.5 to 0.5 on each axis; the tint has to stay under a step for the color to fit
+    int step = 256 / resolution;
+    int x = (int)((minimum.x + 0.5f) * resolution + 0.5f);
+    int y = (int)((minimum.y + 0.5f) * resolution + 0.5f);
+    int z = (int)((minimum.z + 0.5f) * resolution + 0.5f);
+    return qRgb(x * step + tint, y * step, z * step);
+}
+
+ColorGridWriteVisitor::ColorGridWriteVisitor(int resolution, int tint) :
+    MetavoxelVisitor(QVector<AttributePointer>(),
+        QVector<AttributePointer>() << AttributeRegistry::getInstance()->getColorAttribute()),
+    _resolution(resolution),
+    _tint(tint) {
+}
+
+int ColorGridWriteVisitor::visit(MetavoxelInfo& info) {
+    if (info.size > 1.0f / _resolution) {
+        return DEFAULT_ORDER;
+    }
+    info.outputValues[0] = AttributeValue(_outputs.at(0),
+        encodeInline<QRgb>(getGridColor(info.minimum, _resolution, _tint)));
+    return STOP_RECURSION;
+}
+
+ColorGridCheckVisitor::ColorGridCheckVisitor(int resolution, int tint) :
+    MetavoxelVisitor(QVector<AttributePointer>() << AttributeRegistry::getInstance()->getColorAttribute()),
+    _resolution(resolution),
+    _tint(tint),
+    _leafCount(0),
+    _mismatchCount(0) {
+}
+
+int ColorGridCheckVisitor::visit(MetavoxelInfo& info) {
+    if (!info.isLeaf) {
+        return DEFAULT_ORDER;
+    }
+    _leafCount.ref();
+    if (info.inputValues.at(0).getInlineValue<QRgb>() != getGridColor(info.minimum, _resolution, _tint)) {
+        _mismatchCount.ref();
+    }
+    return STOP_RECURSION;
+}
+
+MetavoxelStressThread::MetavoxelStressThread(const MetavoxelData& data, int resolution, int tint) :
+    _data(data),
+    _resolution(resolution),
+    _tint(tint),
+    _failures(0) {
+}
+
+void MetavoxelStressThread::run() {
+    const int PARALLEL_LEVELS = 2;
+    const int TOURS = 8;
+    for (int i = 0; i < TOURS; i++) {
+        MetavoxelData data = _data;
+        ColorGridWriteVisitor writer(_resolution, _tint);
+        writer.setParallelLevels(PARALLEL_LEVELS);
+        data.guide(writer);
+        
+        ColorGridCheckVisitor checker(_resolution, _tint);
+        checker.setParallelLevels(PARALLEL_LEVELS);
+        data.guide(checker);
+        if (checker.getLeafCount() != _resolution * _resolution * _resolution || checker.getMismatchCount() != 0) {
+            _failures++;
+        }
+    }
 }
@@ -10,9 +10,11 @@
 #define __interface__MetavoxelTests__
 
 #include <QCoreApplication>
+#include <QThread>
 #include <QVariantList>
 
 #include <DatagramSequencer.h>
+#include <MetavoxelData.h>
 
 class SequencedTestMessage;
 
@@ -96,6 +98,80 @@ public:
     virtual ~TestSharedObjectB();
 };
 
+/// Copies, resets and looks up references to a set of shared objects, while creating and dropping objects of its own.
+class SharedObjectStressThread : public QThread {
+public:
+    
+    SharedObjectStressThread(const QVector<SharedObjectPointer>& objects, int seed);
+    
+    /// Returns the number of lookups that didn't find the object they were looking for.
+    int getLookupFailures() const { return _lookupFailures; }
+    
+protected:
+    
+    virtual void run();
+
+private:
+    
+    QVector<SharedObjectPointer> _objects;
+    uint _seed;
+    int _lookupFailures;
+};
+
+/// Colors every voxel down to a fixed granularity according to its position.
+class ColorGridWriteVisitor : public MetavoxelVisitor {
+public:
+    
+    ColorGridWriteVisitor(int resolution, int tint);
+    
+    virtual int visit(MetavoxelInfo& info);
+
+private:
+    
+    int _resolution;
+    int _tint;
+};
+
+/// Counts the leaves and the leaves whose color doesn't match what a ColorGridWriteVisitor would have written.
+class ColorGridCheckVisitor : public MetavoxelVisitor {
+public:
+    
+    ColorGridCheckVisitor(int resolution, int tint);
+    
+    int getLeafCount() const { return _leafCount.load(); }
+    int getMismatchCount() const { return _mismatchCount.load(); }
+    
+    virtual int visit(MetavoxelInfo& info);
+
+private:
+    
+    int _resolution;
+    int _tint;
+    QAtomicInt _leafCount;
+    QAtomicInt _mismatchCount;
+};
+
+/// Repeatedly recolors its own copy of a shared tree in parallel and checks the result.
+class MetavoxelStressThread : public QThread {
+public:
+    
+    MetavoxelStressThread(const MetavoxelData& data, int resolution, int tint);
+    
+    /// Returns the number of tours that didn't find what was written.
+    int getFailures() const { return _failures; }
+    
+protected:
+    
+    virtual void run();
+
+private:
+    
+    MetavoxelData _data;
+    int _resolution;
+    int _tint;
+    int _failures;
+};
+
 /// A simple test message.
 class TestMessageA {
     STREAMABLE
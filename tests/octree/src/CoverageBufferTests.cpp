@@ -0,0 +1,203 @@
+//
+//  CoverageBufferTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <CoverageBuffer.h>
+#include <CoverageMap.h>
+#include <OctreeSceneStats.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "CoverageBufferTests.h"
+
+const float CITY_VOXEL_SIZE = 1.0f / 4096.0f;
+const int CITY_BLOCKS = 12; // buildings along each side
+const int BUILDING_WIDTH = 6; // in voxels
+const int STREET_WIDTH = 2;
+const int MIN_BUILDING_HEIGHT = 8;
+const int MAX_BUILDING_HEIGHT = 32;
+
+// a rectangle in screen space, wound the way projected polygons are
+static OctreeProjectedPolygon rectangle(float left, float bottom, float right, float top) {
+    OctreeProjectedPolygon polygon(4);
+    polygon.setVertex(0, glm::vec2(left, bottom));
+    polygon.setVertex(1, glm::vec2(right, bottom));
+    polygon.setVertex(2, glm::vec2(right, top));
+    polygon.setVertex(3, glm::vec2(left, top));
+    polygon.setAllInView(true);
+    return polygon;
+}
+
+void CoverageBufferTests::nearPolygonOccludesFartherOne() {
+    CoverageBuffer buffer;
+    if (buffer.checkBuffer(rectangle(-0.5f, -0.5f, 0.5f, 0.5f), 1.0f, 2.0f, true) != STORED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the first polygon should have been stored" << std::endl;
+    }
+    if (buffer.checkBuffer(rectangle(-0.1f, -0.1f, 0.1f, 0.1f), 5.0f, 6.0f, false) != OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a small polygon behind a big one should be occluded"
+            << std::endl;
+    }
+    // depths that overlap the stored polygon's can't be occluded by it
+    if (buffer.checkBuffer(rectangle(-0.1f, -0.1f, 0.1f, 0.1f), 1.5f, 2.5f, false) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a polygon as near as the stored one was occluded"
+            << std::endl;
+    }
+
+    CoverageBuffer reversed;
+    reversed.checkBuffer(rectangle(-0.1f, -0.1f, 0.1f, 0.1f), 5.0f, 6.0f, true);
+    if (reversed.checkBuffer(rectangle(-0.5f, -0.5f, 0.5f, 0.5f), 1.0f, 2.0f, true) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a big near polygon was occluded by a small far one"
+            << std::endl;
+    }
+}
+
+void CoverageBufferTests::occlusionNeedsFullCoverage() {
+    CoverageBuffer buffer;
+    buffer.checkBuffer(rectangle(-0.5f, -0.5f, 0.5f, 0.5f), 1.0f, 2.0f, true);
+    if (buffer.checkBuffer(rectangle(0.3f, 0.3f, 0.7f, 0.7f), 5.0f, 6.0f, false) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a polygon sticking out from behind another was occluded"
+            << std::endl;
+    }
+
+    // a triangle only covers the cells entirely inside it, so a square over its bounds isn't hidden
+    CoverageBuffer triangleBuffer;
+    OctreeProjectedPolygon triangle(3);
+    triangle.setVertex(0, glm::vec2(-0.5f, -0.5f));
+    triangle.setVertex(1, glm::vec2(0.5f, -0.5f));
+    triangle.setVertex(2, glm::vec2(-0.5f, 0.5f));
+    triangleBuffer.checkBuffer(triangle, 1.0f, 2.0f, true);
+    if (triangleBuffer.checkBuffer(rectangle(0.1f, 0.1f, 0.4f, 0.4f), 5.0f, 6.0f, false) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a polygon beyond a triangle's edge was occluded"
+            << std::endl;
+    }
+    if (triangleBuffer.checkBuffer(rectangle(-0.4f, -0.4f, -0.2f, -0.2f), 5.0f, 6.0f, false) != OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a polygon inside a triangle's shadow wasn't occluded"
+            << std::endl;
+    }
+
+    buffer.erase();
+    if (buffer.checkBuffer(rectangle(-0.1f, -0.1f, 0.1f, 0.1f), 5.0f, 6.0f, false) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: erase() left coverage behind" << std::endl;
+    }
+}
+
+void CoverageBufferTests::severalPolygonsOccludeTogether() {
+    // neither half hides the polygon on its own, which is as far as CoverageMap goes, but together they do
+    CoverageBuffer buffer;
+    buffer.checkBuffer(rectangle(-0.5f, -0.5f, 0.0f, 0.5f), 1.0f, 2.0f, true);
+    buffer.checkBuffer(rectangle(0.0f, -0.5f, 0.5f, 0.5f), 1.0f, 3.0f, true);
+    if (buffer.checkBuffer(rectangle(-0.2f, -0.2f, 0.2f, 0.2f), 5.0f, 6.0f, false) != OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: two adjacent polygons should occlude together"
+            << std::endl;
+    }
+    if (buffer.checkBuffer(rectangle(-0.2f, -0.2f, 0.2f, 0.2f), 2.5f, 3.5f, false) == OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: occluded by a polygon that isn't nearer" << std::endl;
+    }
+}
+
+static void buildCity(VoxelTree& tree) {
+    int cityWidth = CITY_BLOCKS * (BUILDING_WIDTH + STREET_WIDTH);
+    for (int x = 0; x < cityWidth; x++) {
+        for (int z = 0; z < cityWidth; z++) {
+            tree.createVoxel(x * CITY_VOXEL_SIZE, 0.0f, z * CITY_VOXEL_SIZE, CITY_VOXEL_SIZE, 64, 64, 64);
+        }
+    }
+    for (int blockX = 0; blockX < CITY_BLOCKS; blockX++) {
+        for (int blockZ = 0; blockZ < CITY_BLOCKS; blockZ++) {
+            int height = randIntInRange(MIN_BUILDING_HEIGHT, MAX_BUILDING_HEIGHT);
+            unsigned char shade = randIntInRange(128, 255);
+            for (int x = 0; x < BUILDING_WIDTH; x++) {
+                for (int z = 0; z < BUILDING_WIDTH; z++) {
+                    for (int y = 1; y <= height; y++) {
+                        tree.createVoxel((blockX * (BUILDING_WIDTH + STREET_WIDTH) + STREET_WIDTH + x) * CITY_VOXEL_SIZE,
+                            y * CITY_VOXEL_SIZE, (blockZ * (BUILDING_WIDTH + STREET_WIDTH) + STREET_WIDTH + z) *
+                            CITY_VOXEL_SIZE, CITY_VOXEL_SIZE, shade, shade, shade);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Encodes a full scene the way OctreeSendThread does, returning the bytes it took.
+static int encodeScene(VoxelTree& tree, const ViewFrustum& viewFrustum, CoverageMap* map, CoverageBuffer* buffer,
+                       OctreeSceneStats& stats, quint64& elapsedUsec) {
+    OctreeElementBag bag;
+    bag.setViewFrustum(&viewFrustum);
+    bag.insert(tree.getRoot());
+    bool wantOcclusionCulling = (map || buffer);
+
+    OctreePacketData packetData;
+    int bytes = 0;
+    quint64 start = usecTimestampNow();
+    stats.sceneStarted(true, false, tree.getRoot(), IGNORE_JURISDICTION_MAP);
+    while (!bag.isEmpty()) {
+        OctreeElement* subTree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, &viewFrustum, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+                                     IGNORE_VIEW_FRUSTUM, wantOcclusionCulling, map, NO_BOUNDARY_ADJUST,
+                                     DEFAULT_OCTREE_SIZE_SCALE, IGNORE_LAST_SENT, true, &stats);
+        params.coverageBuffer = buffer;
+        int bytesWritten = tree.encodeTreeBitstream(subTree, &packetData, bag, params);
+
+        bool sendNow = bag.isEmpty() || (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT);
+        if (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT) {
+            bag.insert(subTree);
+        }
+        if (sendNow && packetData.hasContent()) {
+            bytes += packetData.getFinalizedSize();
+            packetData.reset();
+        }
+    }
+    stats.sceneCompleted();
+    elapsedUsec = usecTimestampNow() - start;
+    return bytes;
+}
+
+void CoverageBufferTests::benchmarkCityScene() {
+    VoxelTree tree;
+    buildCity(tree);
+
+    // standing in a street at the edge of the city, looking down it
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(CITY_VOXEL_SIZE, 2.0f * CITY_VOXEL_SIZE,
+        (CITY_BLOCKS * (BUILDING_WIDTH + STREET_WIDTH) + 4) * CITY_VOXEL_SIZE) * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::quat());
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.calculate();
+
+    OctreeSceneStats noCullingStats, mapStats, bufferStats;
+    quint64 noCullingUsec, mapUsec, bufferUsec;
+    CoverageMap map;
+    CoverageBuffer buffer;
+    int noCullingBytes = encodeScene(tree, viewFrustum, NULL, NULL, noCullingStats, noCullingUsec);
+    int mapBytes = encodeScene(tree, viewFrustum, &map, NULL, mapStats, mapUsec);
+    int bufferBytes = encodeScene(tree, viewFrustum, NULL, &buffer, bufferStats, bufferUsec);
+
+    std::cout << "city scene, no occlusion culling: " << noCullingBytes << " bytes " << noCullingUsec << " usecs"
+        << std::endl;
+    std::cout << "city scene, coverage map:         " << mapBytes << " bytes " << mapUsec << " usecs, occluded "
+        << mapStats.getItemValue(OctreeSceneStats::ITEM_SKIPPED_OCCLUDED) << std::endl;
+    std::cout << "city scene, coverage buffer:      " << bufferBytes << " bytes " << bufferUsec << " usecs, occluded "
+        << bufferStats.getItemValue(OctreeSceneStats::ITEM_SKIPPED_OCCLUDED) << std::endl;
+
+    if (bufferBytes > noCullingBytes) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the coverage buffer made the scene bigger" << std::endl;
+    }
+}
+
+void CoverageBufferTests::runAllTests() {
+    nearPolygonOccludesFartherOne();
+    occlusionNeedsFullCoverage();
+    severalPolygonsOccludeTogether();
+
+    benchmarkCityScene();
+}
@@ -0,0 +1,22 @@
+//
+//  CoverageBufferTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__CoverageBufferTests__
+#define __tests__CoverageBufferTests__
+
+namespace CoverageBufferTests {
+
+    void nearPolygonOccludesFartherOne();
+    void occlusionNeedsFullCoverage();
+    void severalPolygonsOccludeTogether();
+
+    void benchmarkCityScene();
+
+    void runAllTests();
+}
+
+#endif // __tests__CoverageBufferTests__
@@ -0,0 +1,265 @@
+//
+//  JurisdictionIndexTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+#include <vector>
+
+#include <QtCore/QSet>
+
+#include <JurisdictionIndex.h>
+#include <JurisdictionMap.h>
+#include <OctalCode.h>
+#include <SharedUtil.h>
+
+#include "JurisdictionIndexTests.h"
+
+const int SERVER_COUNT = 64;
+const int RANDOM_CODE_COUNT = 10000;
+const int MAX_RANDOM_CODE_LENGTH = 10;
+const int BENCHMARK_EDIT_COUNT = 100000;
+const int BENCHMARK_EDIT_CODE_LENGTH = 10;
+
+static unsigned char* codeForPath(const int* path, int length) {
+    unsigned char* code = new unsigned char[1];
+    *code = 0;
+    for (int i = 0; i < length; i++) {
+        unsigned char* child = childOctalCode(code, path[i]);
+        delete[] code;
+        code = child;
+    }
+    return code;
+}
+
+static unsigned char* randomCode(int length, const int* prefix = NULL, int prefixLength = 0) {
+    int path[MAX_RANDOM_CODE_LENGTH];
+    for (int i = 0; i < length; i++) {
+        path[i] = (i < prefixLength) ? prefix[i] : randIntInRange(0, 7);
+    }
+    return codeForPath(path, length);
+}
+
+// the jurisdiction rules spelled out with isAncestorOf(), the way JurisdictionMap used to check them
+static JurisdictionMap::Area referenceJurisdiction(const JurisdictionMap& map, const unsigned char* code, int childIndex) {
+    unsigned char* root = map.getRootOctalCode();
+    if (isAncestorOf(code, root)) {
+        return JurisdictionMap::ABOVE;
+    }
+    if (!isAncestorOf(root, code, childIndex)) {
+        return JurisdictionMap::BELOW;
+    }
+    for (int i = 0; i < map.getEndNodeCount(); i++) {
+        if (isAncestorOf(map.getEndNodeOctalCode(i), code)) {
+            return JurisdictionMap::BELOW;
+        }
+    }
+    return JurisdictionMap::WITHIN;
+}
+
+// 64 servers that each own one of the level two octants, every fourth of them handing two smaller octants off to
+// some other server, plus whatever extra servers the test wants
+static void populateJurisdictions(NodeToJurisdictionMap& jurisdictions) {
+    for (int server = 0; server < SERVER_COUNT; server++) {
+        int rootPath[] = { server / 8, server % 8 };
+        std::vector<unsigned char*> endNodes;
+        if (server % 4 == 0) {
+            int firstEndNodePath[] = { server / 8, server % 8, 0, 3 };
+            int secondEndNodePath[] = { server / 8, server % 8, 5 };
+            endNodes.push_back(codeForPath(firstEndNodePath, 4));
+            endNodes.push_back(codeForPath(secondEndNodePath, 3));
+        }
+        jurisdictions.insert(QUuid::createUuid(), JurisdictionMap(codeForPath(rootPath, 2), endNodes));
+    }
+}
+
+static QSet<QUuid> linearServersFor(const NodeToJurisdictionMap& jurisdictions, const unsigned char* code) {
+    QSet<QUuid> servers;
+    for (NodeToJurisdictionMap::const_iterator i = jurisdictions.constBegin(); i != jurisdictions.constEnd(); ++i) {
+        if (i.value().isMyJurisdiction(code, CHECK_NODE_ONLY) == JurisdictionMap::WITHIN) {
+            servers.insert(i.key());
+        }
+    }
+    return servers;
+}
+
+static QSet<QUuid> indexedServersFor(const JurisdictionIndex& index, const unsigned char* code) {
+    QSet<QUuid> servers;
+    foreach (int server, index.serversFor(code)) {
+        servers.insert(index.getServerUUID(server));
+    }
+    return servers;
+}
+
+void JurisdictionIndexTests::compiledMapMatchesAncestorChecks() {
+    int rootPath[] = { 2, 6, 1 };
+    int endNodePaths[][4] = { { 2, 6, 1, 4 }, { 2, 6, 1, 7 }, { 2, 6, 1, 0 } };
+    std::vector<unsigned char*> endNodes;
+    endNodes.push_back(codeForPath(endNodePaths[0], 4));
+    endNodes.push_back(codeForPath(endNodePaths[1], 4));
+    endNodes.push_back(codeForPath(endNodePaths[2], 3)); // just the root, which should leave nothing within
+    JurisdictionMap withEndAtRoot(codeForPath(rootPath, 3), endNodes);
+    endNodes.pop_back();
+    JurisdictionMap map(codeForPath(rootPath, 3), endNodes);
+    JurisdictionMap everything;
+
+    int mismatches = 0;
+    for (int i = 0; i < RANDOM_CODE_COUNT; i++) {
+        // bias the codes towards the root so that we actually land within it
+        unsigned char* code = randomCode(randIntInRange(0, MAX_RANDOM_CODE_LENGTH), rootPath, randomBoolean() ? 3 : 0);
+        int childIndex = randomBoolean() ? CHECK_NODE_ONLY : randIntInRange(0, 7);
+        if (map.isMyJurisdiction(code, childIndex) != referenceJurisdiction(map, code, childIndex)
+                || withEndAtRoot.isMyJurisdiction(code, childIndex) != referenceJurisdiction(withEndAtRoot, code, childIndex)
+                || everything.isMyJurisdiction(code, childIndex) != referenceJurisdiction(everything, code, childIndex)) {
+            mismatches++;
+        }
+        delete[] code;
+    }
+    if (mismatches > 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: compiled jurisdiction disagreed with ancestor checks "
+            << mismatches << " times" << std::endl;
+    }
+
+    // the root and its ancestors are ABOVE, whatever child we ask about
+    int parentPath[] = { 2, 6 };
+    unsigned char* parent = codeForPath(parentPath, 2);
+    unsigned char* root = codeForPath(rootPath, 3);
+    if (map.isMyJurisdiction(parent, 1) != JurisdictionMap::ABOVE || map.isMyJurisdiction(parent, 5) != JurisdictionMap::ABOVE
+            || map.isMyJurisdiction(root, CHECK_NODE_ONLY) != JurisdictionMap::ABOVE) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the root and its parent to be ABOVE" << std::endl;
+    }
+    if (map.isMyJurisdiction(root, 3) != JurisdictionMap::WITHIN || map.isMyJurisdiction(root, 2) != JurisdictionMap::WITHIN) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the root's children to be WITHIN" << std::endl;
+    }
+    unsigned char* endNode = codeForPath(endNodePaths[1], 4);
+    if (map.isMyJurisdiction(endNode, CHECK_NODE_ONLY) != JurisdictionMap::BELOW) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected an end node to be BELOW" << std::endl;
+    }
+    delete[] endNode;
+    delete[] root;
+    delete[] parent;
+}
+
+void JurisdictionIndexTests::indexMatchesEachServersMap() {
+    NodeToJurisdictionMap jurisdictions;
+    populateJurisdictions(jurisdictions);
+
+    // a server owning the whole world except one octant, one rooted inside another's end node, one with an end node above
+    // its own root (so it owns nothing), and one without a root at all
+    int octantPath[] = { 4 };
+    std::vector<unsigned char*> worldEndNodes;
+    worldEndNodes.push_back(codeForPath(octantPath, 1));
+    jurisdictions.insert(QUuid::createUuid(), JurisdictionMap(codeForPath(octantPath, 0), worldEndNodes));
+
+    int nestedPath[] = { 0, 0, 5, 2 };
+    jurisdictions.insert(QUuid::createUuid(), JurisdictionMap(codeForPath(nestedPath, 4), std::vector<unsigned char*>()));
+
+    int shadowedRootPath[] = { 3, 3, 3 };
+    std::vector<unsigned char*> shadowingEndNodes;
+    shadowingEndNodes.push_back(codeForPath(shadowedRootPath, 1));
+    jurisdictions.insert(QUuid::createUuid(), JurisdictionMap(codeForPath(shadowedRootPath, 3), shadowingEndNodes));
+
+    unsigned char* noRoot = NULL;
+    jurisdictions.insert(QUuid::createUuid(), JurisdictionMap(noRoot, std::vector<unsigned char*>()));
+
+    JurisdictionIndex index;
+    index.update(jurisdictions, 0);
+
+    int mismatches = 0;
+    for (int i = 0; i < RANDOM_CODE_COUNT; i++) {
+        unsigned char* code = randomCode(randIntInRange(0, MAX_RANDOM_CODE_LENGTH));
+        if (indexedServersFor(index, code) != linearServersFor(jurisdictions, code)) {
+            mismatches++;
+        }
+        delete[] code;
+    }
+    if (mismatches > 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: index disagreed with the jurisdiction maps "
+            << mismatches << " times" << std::endl;
+    }
+}
+
+void JurisdictionIndexTests::indexRebuildsWhenJurisdictionsChange() {
+    NodeToJurisdictionMap jurisdictions;
+    int version = 0;
+    JurisdictionIndex index;
+    index.update(jurisdictions, version);
+
+    int path[] = { 1, 2, 3, 4 };
+    unsigned char* code = codeForPath(path, 4);
+    if (!index.serversFor(code).isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected no servers before any jurisdictions" << std::endl;
+    }
+
+    QUuid serverUUID = QUuid::createUuid();
+    jurisdictions[serverUUID] = JurisdictionMap(codeForPath(path, 1), std::vector<unsigned char*>());
+    index.update(jurisdictions, ++version);
+    if (index.serversFor(code).size() != 1 || index.getServerUUID(index.serversFor(code).at(0)) != serverUUID) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the new server after an insert" << std::endl;
+    }
+
+    // an unchanged version keeps the compiled index, even through non-const access to the map
+    jurisdictions[serverUUID];
+    index.update(jurisdictions, version);
+    if (index.serversFor(code).size() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the server to survive a read" << std::endl;
+    }
+
+    jurisdictions.remove(serverUUID);
+    index.update(jurisdictions, ++version);
+    if (!index.serversFor(code).isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected no servers after a remove" << std::endl;
+    }
+    delete[] code;
+}
+
+void JurisdictionIndexTests::benchmarkEditRoutingAtSixtyFourServers() {
+    NodeToJurisdictionMap jurisdictions;
+    populateJurisdictions(jurisdictions);
+
+    std::vector<unsigned char*> edits;
+    for (int i = 0; i < BENCHMARK_EDIT_COUNT; i++) {
+        edits.push_back(randomCode(BENCHMARK_EDIT_CODE_LENGTH));
+    }
+
+    // what the edit sender used to do, ask each server's map about each edit
+    int linearRouted = 0;
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_EDIT_COUNT; i++) {
+        for (NodeToJurisdictionMap::const_iterator j = jurisdictions.constBegin(); j != jurisdictions.constEnd(); ++j) {
+            if (j.value().isMyJurisdiction(edits[i], CHECK_NODE_ONLY) == JurisdictionMap::WITHIN) {
+                linearRouted++;
+            }
+        }
+    }
+    quint64 linearUsecs = usecTimestampNow() - start;
+
+    JurisdictionIndex index;
+    int indexedRouted = 0;
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_EDIT_COUNT; i++) {
+        index.update(jurisdictions, 0);
+        indexedRouted += index.serversFor(edits[i]).size();
+    }
+    quint64 indexedUsecs = usecTimestampNow() - start;
+
+    if (linearRouted != indexedRouted) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: index routed " << indexedRouted
+            << " edits, expected " << linearRouted << std::endl;
+    }
+    std::cout << "routing " << BENCHMARK_EDIT_COUNT << " edits across " << SERVER_COUNT << " servers: "
+        << "per server checks " << linearUsecs << " usecs, index " << indexedUsecs << " usecs" << std::endl;
+
+    for (size_t i = 0; i < edits.size(); i++) {
+        delete[] edits[i];
+    }
+}
+
+void JurisdictionIndexTests::runAllTests() {
+    compiledMapMatchesAncestorChecks();
+    indexMatchesEachServersMap();
+    indexRebuildsWhenJurisdictionsChange();
+    benchmarkEditRoutingAtSixtyFourServers();
+}
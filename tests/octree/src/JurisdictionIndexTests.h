@@ -0,0 +1,22 @@
+//
+//  JurisdictionIndexTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__JurisdictionIndexTests__
+#define __tests__JurisdictionIndexTests__
+
+namespace JurisdictionIndexTests {
+
+    void compiledMapMatchesAncestorChecks();
+    void indexMatchesEachServersMap();
+    void indexRebuildsWhenJurisdictionsChange();
+
+    void benchmarkEditRoutingAtSixtyFourServers();
+
+    void runAllTests();
+}
+
+#endif // __tests__JurisdictionIndexTests__
@@ -0,0 +1,166 @@
+//
+//  OctreeCacheTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QDir>
+#include <QFile>
+#include <QUuid>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <OctreeCache.h>
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <OctreeQuery.h>
+#include <OctreeSceneStats.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <UUID.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "OctreeCacheTests.h"
+#include "OctreeTestUtil.h"
+
+const int TOWN_WIDTH = 48;
+const int MAX_HOUSE_HEIGHT = 6;
+const float VIEW_DISTANCE = 80.0f; // meters back from the edge of town, far enough that all of it stays in view
+
+// looking at the town from its far side, moved along x and turned about y
+static ViewFrustum viewOfTown(float offset, float yaw) {
+    ViewFrustum view;
+    view.setPosition(glm::vec3(TOWN_WIDTH * 0.5f + offset, 10.0f, TOWN_WIDTH + VIEW_DISTANCE));
+    view.setOrientation(glm::quat(glm::radians(glm::vec3(-10.0f, yaw, 0.0f))));
+    view.setFieldOfView(60.0f);
+    view.setAspectRatio(16.0f / 9.0f);
+    view.setNearClip(0.1f);
+    view.setFarClip(500.0f);
+    view.setEyeOffsetPosition(glm::vec3());
+    view.calculate();
+    return view;
+}
+
+static bool countColoredOperation(OctreeElement* element, void* extraData) {
+    if (static_cast<VoxelTreeElement*>(element)->isColored()) {
+        (*static_cast<int*>(extraData))++;
+    }
+    return true;
+}
+
+static int countColored(VoxelTree& tree) {
+    int count = 0;
+    tree.recurseTreeWithOperation(countColoredOperation, &count);
+    return count;
+}
+
+/// Plays a client joining a server: the client prepares its query from its cache, the query crosses the wire, and the
+/// server sends a full scene for it the way OctreeSendThread does, which the client reads into its tree.
+/// \return the octree bytes the client received
+static int joinServer(VoxelTree& serverTree, const QUuid& serverUUID, VoxelTree& clientTree, OctreeCache& cache,
+                      const ViewFrustum& view) {
+    cache.loadServer(serverUUID, &clientTree, view, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST);
+
+    OctreeQuery clientQuery;
+    cache.prepareQuery(serverUUID, clientQuery, view, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST);
+    unsigned char queryPacket[MAX_PACKET_SIZE];
+    int queryBytes = populatePacketHeader(reinterpret_cast<char*>(queryPacket), PacketTypeVoxelQuery);
+    queryBytes += clientQuery.getBroadcastData(queryPacket + queryBytes);
+    OctreeQuery serverQuery;
+    serverQuery.parseData(QByteArray(reinterpret_cast<char*>(queryPacket), queryBytes));
+
+    OctreeSceneStats stats;
+    stats.sceneStarted(true, false, serverTree.getRoot(), IGNORE_JURISDICTION_MAP);
+    OctreeElementBag bag;
+    bag.insert(serverTree.getRoot());
+    OctreePacketData packetData;
+    int receivedBytes = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* subtree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, &view, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+                                     IGNORE_VIEW_FRUSTUM, NO_OCCLUSION_CULLING, IGNORE_COVERAGE_MAP, NO_BOUNDARY_ADJUST,
+                                     DEFAULT_OCTREE_SIZE_SCALE, IGNORE_LAST_SENT, true, &stats,
+                                     IGNORE_JURISDICTION_MAP);
+        params.subtreeVersions = &serverQuery.getSubtreeVersions();
+        int bytesWritten = serverTree.encodeTreeBitstream(subtree, &packetData, bag, params);
+
+        // a full packet goes out, and the subtree that didn't fit starts the next
+        if ((bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT && packetData.hasContent()) ||
+                (bag.isEmpty() && packetData.hasContent())) {
+            ReadBitstreamToTreeParams args(WANT_COLOR, WANT_EXISTS_BITS, NULL, serverUUID);
+            clientTree.readBitstreamToTree(packetData.getFinalizedData(), packetData.getFinalizedSize(), args);
+            receivedBytes += packetData.getFinalizedSize();
+            packetData.reset();
+            if (bytesWritten == 0) {
+                bag.insert(subtree);
+            }
+        }
+    }
+    stats.sceneCompleted();
+
+    cache.sceneCompleted(serverUUID, stats, &clientTree);
+    return receivedBytes;
+}
+
+void OctreeCacheTests::reportReconnectBytes() {
+    VoxelTree serverTree;
+    buildTown(serverTree, glm::vec3(), TOWN_WIDTH, MAX_HOUSE_HEIGHT);
+    QUuid serverUUID = QUuid::createUuid();
+    QString directory = QDir::temp().filePath("octree-tests-cache");
+
+    // the first visit fills the cache
+    VoxelTree firstVisit;
+    int coldBytes;
+    {
+        OctreeCache cache("voxels");
+        cache.setCacheDirectory(directory);
+        coldBytes = joinServer(serverTree, serverUUID, firstVisit, cache, viewOfTown(0.0f, 0.0f));
+        cache.saveServer(serverUUID, &firstVisit);
+    }
+    int sceneVoxels = countColored(firstVisit);
+
+    // returning to the same spot, a few meters over, and turned far enough that the view is no longer similar
+    const int VIEW_COUNT = 3;
+    const float OFFSETS[VIEW_COUNT] = { 0.0f, 3.0f, 0.0f };
+    const float YAWS[VIEW_COUNT] = { 0.0f, 0.0f, 20.0f };
+    int warmBytes[VIEW_COUNT];
+    for (int i = 0; i < VIEW_COUNT; i++) {
+        OctreeCache cache("voxels");
+        cache.setCacheDirectory(directory);
+        VoxelTree returningVisit;
+        ViewFrustum view = viewOfTown(OFFSETS[i], YAWS[i]);
+        warmBytes[i] = joinServer(serverTree, serverUUID, returningVisit, cache, view);
+
+        // skipped subtrees must already be there, so the client ends up with the scene a cold join would give it
+        VoxelTree coldVisit;
+        OctreeCache noCache("voxels");
+        noCache.setCacheDirectory(QDir::temp().filePath("octree-tests-no-cache"));
+        joinServer(serverTree, serverUUID, coldVisit, noCache, view);
+        if (countColored(returningVisit) != countColored(coldVisit)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: returning with a warm cache left the client with "
+                << countColored(returningVisit) << " voxels where a cold join has " << countColored(coldVisit)
+                << std::endl;
+        }
+    }
+    QFile::remove(QDir(directory).filePath(QString("voxels-%1.svo").arg(uuidStringWithoutCurlyBraces(serverUUID))));
+
+    std::cout << "Octree bytes received joining a scene of " << sceneVoxels << " voxels: cold " << coldBytes
+        << ", returning with a warm cache to the same view " << warmBytes[0] << ", moved " << OFFSETS[1] << "m "
+        << warmBytes[1] << ", turned " << YAWS[2] << " degrees " << warmBytes[2] << std::endl;
+
+    // the same view should cost next to nothing, while a view the cache wasn't captured from falls back to a full scene
+    const int NEAR_ZERO_DIVISOR = 20;
+    if (warmBytes[0] * NEAR_ZERO_DIVISOR > coldBytes || warmBytes[1] * NEAR_ZERO_DIVISOR > coldBytes) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a warm cache for a similar view still received "
+            << warmBytes[0] << " and " << warmBytes[1] << " of the " << coldBytes << " bytes of a cold join" << std::endl;
+    }
+}
+
+void OctreeCacheTests::runAllTests() {
+    reportReconnectBytes();
+}
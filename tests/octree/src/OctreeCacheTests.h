@@ -0,0 +1,18 @@
+//
+//  OctreeCacheTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeCacheTests__
+#define __tests__OctreeCacheTests__
+
+namespace OctreeCacheTests {
+
+    void reportReconnectBytes();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeCacheTests__
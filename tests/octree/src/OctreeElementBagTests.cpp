@@ -0,0 +1,288 @@
+//
+//  OctreeElementBagTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "OctreeElementBagTests.h"
+
+const float VOXEL_SIZE = 1.0f / 256.0f;
+
+static void setUpViewFrustum(ViewFrustum& viewFrustum, const glm::vec3& position) {
+    viewFrustum.setPosition(position);
+    viewFrustum.setOrientation(glm::quat());
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.calculate();
+}
+
+void OctreeElementBagTests::insertionOrderWithoutViewFrustum() {
+    VoxelTree tree;
+    for (int i = 0; i < 4; i++) {
+        tree.createVoxel(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    }
+    OctreeElementBag bag;
+    for (int i = 3; i >= 0; i--) {
+        bag.insert(tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+    for (int i = 3; i >= 0; i--) {
+        OctreeElement* element = bag.extract();
+        if (element != tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: expected element " << i << " to come out in insertion order" << std::endl;
+        }
+    }
+    if (!bag.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected bag to be empty" << std::endl;
+    }
+}
+
+void OctreeElementBagTests::nearestFirstWithViewFrustum() {
+    VoxelTree tree;
+    const int NUMBER_OF_VOXELS = 8;
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        tree.createVoxel(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    }
+    ViewFrustum viewFrustum;
+    setUpViewFrustum(viewFrustum, glm::vec3(0.0f, 0.0f, 0.0f));
+
+    OctreeElementBag bag;
+    bag.setViewFrustum(&viewFrustum);
+
+    // insert in a scrambled order
+    int insertOrder[NUMBER_OF_VOXELS] = { 5, 2, 7, 0, 3, 6, 1, 4 };
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        bag.insert(tree.getVoxelAt(insertOrder[i] * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        OctreeElement* element = bag.extract();
+        if (element != tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: expected element " << i << " to be the nearest remaining element" << std::endl;
+        }
+    }
+}
+
+void OctreeElementBagTests::containsAndRemove() {
+    VoxelTree tree;
+    tree.createVoxel(0.0f, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    tree.createVoxel(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    OctreeElement* first = tree.getVoxelAt(0.0f, 0.0f, 0.0f, VOXEL_SIZE);
+    OctreeElement* second = tree.getVoxelAt(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE);
+
+    OctreeElementBag bagA;
+    OctreeElementBag bagB;
+    bagA.insert(first);
+    bagA.insert(first);
+    bagA.insert(second);
+    bagB.insert(second);
+
+    if (bagA.count() != 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected duplicate insert to be ignored, count is "
+            << bagA.count() << std::endl;
+    }
+    if (!bagA.contains(first) || !bagA.contains(second) || bagB.contains(first) || !bagB.contains(second)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bag membership is shared between bags" << std::endl;
+    }
+
+    bagA.remove(second);
+    if (bagA.contains(second) || !bagB.contains(second) || bagA.count() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: remove() from one bag affected the other" << std::endl;
+    }
+
+    // deleting the element must take it out of any bag it was in
+    tree.deleteVoxelAt(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE);
+    if (!bagB.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: deleted element still in bag" << std::endl;
+    }
+}
+
+void OctreeElementBagTests::removedEntriesAreSkipped() {
+    VoxelTree tree;
+    const int NUMBER_OF_VOXELS = 8;
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        tree.createVoxel(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    }
+    OctreeElementBag bag;
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        bag.insert(tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+
+    // take out the odd ones, then put one back: it keeps its place rather than going to the end
+    for (int i = 1; i < NUMBER_OF_VOXELS; i += 2) {
+        bag.remove(tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+    bag.insert(tree.getVoxelAt(3 * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    if (bag.count() != NUMBER_OF_VOXELS / 2 + 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << NUMBER_OF_VOXELS / 2 + 1 << " elements, got "
+            << bag.count() << std::endl;
+    }
+    const int EXPECTED[] = { 0, 2, 3, 4, 6 };
+    for (unsigned int i = 0; i < sizeof(EXPECTED) / sizeof(EXPECTED[0]); i++) {
+        OctreeElement* element = bag.extract();
+        if (element != tree.getVoxelAt(EXPECTED[i] * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected element " << EXPECTED[i] << " next"
+                << std::endl;
+        }
+    }
+    if (!bag.isEmpty() || bag.extract()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected only removed elements left, and none extracted"
+            << std::endl;
+    }
+
+    // removing everything but one leaves only that one to come out
+    for (int i = 0; i < NUMBER_OF_VOXELS; i++) {
+        bag.insert(tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+    for (int i = 1; i < NUMBER_OF_VOXELS; i++) {
+        bag.remove(tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE));
+    }
+    if (bag.count() != 1 || bag.extract() != tree.getVoxelAt(0.0f, 0.0f, 0.0f, VOXEL_SIZE) || !bag.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected just the first element to survive removal"
+            << std::endl;
+    }
+}
+
+void OctreeElementBagTests::moreLiveBagsThanSlots() {
+    const int LIVE_BAGS = OctreeElement::MAX_BAG_MEMBERSHIP_SLOTS + 8;
+    VoxelTree tree;
+    for (int i = 0; i <= LIVE_BAGS; i++) {
+        tree.createVoxel(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    }
+    OctreeElement* elements[LIVE_BAGS + 1];
+    for (int i = 0; i <= LIVE_BAGS; i++) {
+        elements[i] = tree.getVoxelAt(i * VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE);
+    }
+    OctreeElementBag bags[LIVE_BAGS];
+
+    // like the bags of a server's clients, they all stay alive but take turns holding elements
+    for (int i = 0; i < LIVE_BAGS; i++) {
+        bags[i].insert(elements[i]);
+        bags[i].insert(elements[i + 1]);
+        if (!bags[i].hasMembershipSlot()) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bag " << i << " of " << LIVE_BAGS
+                << " live bags fell back to a set" << std::endl;
+        }
+        if (!bags[i].contains(elements[i]) || !bags[i].contains(elements[i + 1]) ||
+                (i > 0 && bags[i].contains(elements[i - 1]))) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bag " << i << " has the wrong members" << std::endl;
+        }
+        if (i > 0) {
+            bags[i - 1].extract();
+            bags[i - 1].extract();
+            if (bags[i - 1].hasMembershipSlot()) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: empty bag " << i - 1 << " kept its slot"
+                    << std::endl;
+            }
+        }
+    }
+    bags[LIVE_BAGS - 1].deleteAll();
+
+    // with more of them holding elements at once than there are slots, the extras make do with a set until one frees up
+    for (int i = 0; i < LIVE_BAGS; i++) {
+        bags[i].insert(elements[i]);
+    }
+    const int FIRST_WITHOUT_SLOT = OctreeElement::MAX_BAG_MEMBERSHIP_SLOTS;
+    OctreeElementBag& overflowing = bags[FIRST_WITHOUT_SLOT];
+    if (overflowing.hasMembershipSlot() || !overflowing.contains(elements[FIRST_WITHOUT_SLOT])) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected bag " << FIRST_WITHOUT_SLOT
+            << " to track its members with a set" << std::endl;
+    }
+    bags[0].extract();
+    overflowing.insert(elements[LIVE_BAGS]);
+    if (!overflowing.hasMembershipSlot() || !overflowing.contains(elements[FIRST_WITHOUT_SLOT]) ||
+            !overflowing.contains(elements[LIVE_BAGS]) || bags[0].contains(elements[0])) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected bag " << FIRST_WITHOUT_SLOT
+            << " to move to the slot bag 0 gave back, keeping its members" << std::endl;
+    }
+    for (int i = 0; i < LIVE_BAGS; i++) {
+        bags[i].deleteAll();
+    }
+}
+
+// Encodes a full scene the way OctreeSendThread does and decodes each packet into a "client" tree, returning the
+// number of packets it took until the voxel nearest the viewer showed up on the client.
+static int packetsUntilVisible(VoxelTree& serverTree, const ViewFrustum* bagViewFrustum, const ViewFrustum& viewFrustum,
+                               const glm::vec3& nearestVoxel, quint64& elapsedUsec) {
+    VoxelTree clientTree;
+    OctreeElementBag bag;
+    bag.setViewFrustum(bagViewFrustum);
+    bag.insert(serverTree.getRoot());
+
+    OctreePacketData packetData;
+    int packets = 0;
+    quint64 start = usecTimestampNow();
+    while (!bag.isEmpty()) {
+        OctreeElement* subTree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, &viewFrustum, WANT_COLOR, NO_EXISTS_BITS);
+        int bytesWritten = serverTree.encodeTreeBitstream(subTree, &packetData, bag, params);
+
+        bool sendNow = bag.isEmpty() || (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT);
+        if (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT) {
+            bag.insert(subTree);
+        }
+        if (sendNow && packetData.hasContent()) {
+            ReadBitstreamToTreeParams args(WANT_COLOR, NO_EXISTS_BITS);
+            clientTree.readBitstreamToTree(packetData.getFinalizedData(), packetData.getFinalizedSize(), args);
+            packetData.reset();
+            packets++;
+            if (clientTree.getVoxelAt(nearestVoxel.x, nearestVoxel.y, nearestVoxel.z, VOXEL_SIZE)) {
+                break;
+            }
+        }
+    }
+    elapsedUsec = usecTimestampNow() - start;
+    return packets;
+}
+
+void OctreeElementBagTests::benchmarkTimeToFirstVisibleVoxel() {
+    // a field of voxels stretching away from a viewer standing at its near edge
+    const int FIELD_WIDTH = 64;
+    VoxelTree serverTree;
+    for (int x = 0; x < FIELD_WIDTH; x++) {
+        for (int z = 0; z < FIELD_WIDTH; z++) {
+            serverTree.createVoxel(x * VOXEL_SIZE, 0.0f, z * VOXEL_SIZE, VOXEL_SIZE, x * 4, z * 4, 128);
+        }
+    }
+    glm::vec3 nearestVoxel((FIELD_WIDTH / 2) * VOXEL_SIZE, 0.0f, (FIELD_WIDTH - 1) * VOXEL_SIZE);
+    ViewFrustum viewFrustum;
+    setUpViewFrustum(viewFrustum, glm::vec3(nearestVoxel.x, VOXEL_SIZE, (FIELD_WIDTH + 3) * VOXEL_SIZE) * (float)TREE_SCALE);
+
+    quint64 unorderedUsec;
+    int unorderedPackets = packetsUntilVisible(serverTree, NULL, viewFrustum, nearestVoxel, unorderedUsec);
+    quint64 orderedUsec;
+    int orderedPackets = packetsUntilVisible(serverTree, &viewFrustum, viewFrustum, nearestVoxel, orderedUsec);
+
+    std::cout << "time to first visible voxel, insertion order: " << unorderedPackets << " packets "
+        << unorderedUsec << " usecs" << std::endl;
+    std::cout << "time to first visible voxel, nearest first:   " << orderedPackets << " packets "
+        << orderedUsec << " usecs" << std::endl;
+
+    if (orderedPackets > unorderedPackets) {
+        std::cout << __FILE__ << ":" << __LINE__
+            << " ERROR: nearest first ordering took more packets to reach the nearest voxel" << std::endl;
+    }
+}
+
+void OctreeElementBagTests::runAllTests() {
+    insertionOrderWithoutViewFrustum();
+    nearestFirstWithViewFrustum();
+    containsAndRemove();
+    removedEntriesAreSkipped();
+    moreLiveBagsThanSlots();
+
+    benchmarkTimeToFirstVisibleVoxel();
+}
@@ -0,0 +1,24 @@
+//
+//  OctreeElementBagTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeElementBagTests__
+#define __tests__OctreeElementBagTests__
+
+namespace OctreeElementBagTests {
+
+    void insertionOrderWithoutViewFrustum();
+    void nearestFirstWithViewFrustum();
+    void containsAndRemove();
+    void removedEntriesAreSkipped();
+    void moreLiveBagsThanSlots();
+
+    void benchmarkTimeToFirstVisibleVoxel();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeElementBagTests__
@@ -0,0 +1,228 @@
+//
+//  OctreeParallelEncoderTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QList>
+#include <QMap>
+#include <QThread>
+#include <QtAlgorithms>
+#include <QThreadPool>
+
+#include <OctalCode.h>
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <OctreeParallelEncoder.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeParallelEncoderTests.h"
+#include "OctreeTestUtil.h"
+
+const int TOWN_WIDTH = 32;
+const int MAX_HOUSE_HEIGHT = 8;
+const int TOWNS_PER_SIDE = 4; // one town in each of the subtrees the encoder splits the scene into
+const int SENDER_POLL_USECS = 100;
+
+// a town in every cell SPLIT_DEPTH levels down, so that the workers all have a share of the scene to encode
+static void buildTowns(VoxelTree& tree) {
+    const float TOWN_SPACING = 1.0f / TOWNS_PER_SIDE;
+    for (int x = 0; x < TOWNS_PER_SIDE; x++) {
+        for (int y = 0; y < TOWNS_PER_SIDE; y++) {
+            for (int z = 0; z < TOWNS_PER_SIDE; z++) {
+                buildTown(tree, glm::vec3(x, y, z) * TOWN_SPACING, TOWN_WIDTH, MAX_HOUSE_HEIGHT);
+            }
+        }
+    }
+}
+
+// with no view the whole tree goes out, so every run encodes exactly the same scene
+static EncodeBitstreamParams fullSceneParams() {
+    return EncodeBitstreamParams(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+                                 IGNORE_VIEW_FRUSTUM, NO_OCCLUSION_CULLING, IGNORE_COVERAGE_MAP, NO_BOUNDARY_ADJUST,
+                                 DEFAULT_OCTREE_SIZE_SCALE, IGNORE_LAST_SENT, true, IGNORE_SCENE_STATS,
+                                 IGNORE_JURISDICTION_MAP);
+}
+
+// reads a packet or section into the tree, as a client would
+static void decode(VoxelTree* decodedTree, const unsigned char* data, int size) {
+    if (decodedTree) {
+        ReadBitstreamToTreeParams args(WANT_COLOR, WANT_EXISTS_BITS);
+        decodedTree->readBitstreamToTree(data, size, args);
+    }
+}
+
+/// Encodes the scene the way OctreeSendThread does without an encode thread pool, out of a single bag.
+/// \param decodedTree if not null, gets each packet read into it
+/// \return the usecs taken
+static quint64 encodeSerially(VoxelTree& tree, int& packets, int& bytes, VoxelTree* decodedTree = NULL) {
+    quint64 start = usecTimestampNow();
+    OctreeElementBag bag;
+    bag.insert(tree.getRoot());
+    OctreePacketData packetData;
+    while (!bag.isEmpty()) {
+        OctreeElement* subtree = bag.extract();
+        EncodeBitstreamParams params = fullSceneParams();
+        int bytesWritten = tree.encodeTreeBitstream(subtree, &packetData, bag, params);
+        if ((bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT && packetData.hasContent()) ||
+                (bag.isEmpty() && packetData.hasContent())) {
+            packets++;
+            bytes += packetData.getFinalizedSize();
+            decode(decodedTree, packetData.getFinalizedData(), packetData.getFinalizedSize());
+            packetData.reset();
+            if (bytesWritten == 0) {
+                bag.insert(subtree);
+            }
+        }
+    }
+    return usecTimestampNow() - start;
+}
+
+/// Encodes the scene on a pool of threadCount workers, with a sender taking each section as soon as it's ready the way
+/// OctreeSendThread would with no limit on its packet rate.
+/// \param decodedTree if not null, gets each section read into it in the order they're taken
+/// \return the usecs from starting the scene until its last section was taken
+static quint64 encodeInParallel(VoxelTree& tree, int threadCount, int& sections, int& bytes,
+                                VoxelTree* decodedTree = NULL) {
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+    OctreeParallelEncoder encoder(&tree, &threadPool);
+
+    quint64 start = usecTimestampNow();
+    encoder.start(fullSceneParams(), false);
+    QByteArray section;
+    while (!encoder.isComplete()) {
+        encoder.scheduleWorkers();
+        bool tookSection = false;
+        while (encoder.takeNextSection(section)) {
+            sections++;
+            bytes += section.size();
+            decode(decodedTree, reinterpret_cast<const unsigned char*>(section.constData()), section.size());
+            tookSection = true;
+        }
+        if (!tookSection) {
+            usleep(SENDER_POLL_USECS);
+        }
+    }
+    quint64 elapsed = usecTimestampNow() - start;
+    threadPool.waitForDone();
+    return elapsed;
+}
+
+static bool collectColoredOperation(OctreeElement* element, void* extraData) {
+    VoxelTreeElement* voxel = static_cast<VoxelTreeElement*>(element);
+    if (voxel->isColored()) {
+        const unsigned char* code = voxel->getOctalCode();
+        QByteArray key(reinterpret_cast<const char*>(code),
+                       bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(code)));
+        QByteArray color(reinterpret_cast<const char*>(voxel->getColor()), BYTES_PER_COLOR);
+        static_cast<QMap<QByteArray, QByteArray>*>(extraData)->insert(key, color);
+    }
+    return true;
+}
+
+// every colored voxel in the tree, keyed by its octal code
+static QMap<QByteArray, QByteArray> collectColored(VoxelTree& tree) {
+    QMap<QByteArray, QByteArray> voxels;
+    tree.recurseTreeWithOperation(collectColoredOperation, &voxels);
+    return voxels;
+}
+
+void OctreeParallelEncoderTests::decodesToTheSameTree() {
+    // towns in some of the subtrees the encoder splits the scene into, and voxels at and around the split: a leaf that
+    // only the head unit reaches, one that is itself the root of a split subtree, and one just below such a root
+    const int SMALL_TOWN_WIDTH = 16;
+    const float SPLIT_SCALE = 1.0f / (1 << OctreeParallelEncoder::SPLIT_DEPTH);
+    VoxelTree tree;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 2; y++) {
+            for (int z = 0; z < 2; z++) {
+                buildTown(tree, glm::vec3(x, y, z) * SPLIT_SCALE, SMALL_TOWN_WIDTH, MAX_HOUSE_HEIGHT);
+            }
+        }
+    }
+    buildTown(tree, glm::vec3(0.0f, 0.5f, 0.5f), SMALL_TOWN_WIDTH, MAX_HOUSE_HEIGHT);
+    tree.createVoxel(0.5f, 0.5f, 0.5f, 0.5f, 255, 0, 0);
+    tree.createVoxel(0.5f, 0.0f, 0.0f, SPLIT_SCALE, 0, 255, 0);
+    tree.createVoxel(0.5f, SPLIT_SCALE, 0.0f, SPLIT_SCALE / 2.0f, 0, 0, 255);
+    buildTown(tree, glm::vec3(0.75f, 0.0f, 0.0f), SMALL_TOWN_WIDTH, MAX_HOUSE_HEIGHT);
+
+    VoxelTree serialTree;
+    int packets = 0;
+    int bytes = 0;
+    encodeSerially(tree, packets, bytes, &serialTree);
+    QMap<QByteArray, QByteArray> serialVoxels = collectColored(serialTree);
+
+    const int THREAD_COUNTS[] = { 1, 4 };
+    for (int i = 0; i < (int)(sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0])); i++) {
+        VoxelTree parallelTree;
+        int sections = 0;
+        bytes = 0;
+        encodeInParallel(tree, THREAD_COUNTS[i], sections, bytes, &parallelTree);
+        QMap<QByteArray, QByteArray> parallelVoxels = collectColored(parallelTree);
+        if (parallelVoxels != serialVoxels) {
+            int differing = 0;
+            foreach (const QByteArray& code, serialVoxels.keys()) {
+                if (parallelVoxels.value(code) != serialVoxels.value(code)) {
+                    differing++;
+                }
+            }
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: decoding the sections of " << THREAD_COUNTS[i]
+                << " threads gave " << parallelVoxels.size() << " voxels where the serial encode gave "
+                << serialVoxels.size() << ", " << differing << " of those missing or a different color" << std::endl;
+        }
+    }
+}
+
+void OctreeParallelEncoderTests::benchmarkTimeToFullScene() {
+    VoxelTree tree;
+    buildTowns(tree);
+
+    int serialPackets = 0;
+    int serialBytes = 0;
+    quint64 serialUsecs = encodeSerially(tree, serialPackets, serialBytes);
+    std::cout << "Full scene of " << serialBytes << " bytes encoded from a single bag in " << serialUsecs << " usecs"
+        << std::endl;
+
+    // the same tree at each thread count, up to a few more than this machine has cores
+    QList<int> threadCounts;
+    threadCounts << 1 << 2 << 4 << 8;
+    int idealThreadCount = QThread::idealThreadCount();
+    if (!threadCounts.contains(idealThreadCount) && idealThreadCount > 0) {
+        threadCounts << idealThreadCount;
+        qSort(threadCounts);
+    }
+
+    quint64 oneThreadUsecs = 0;
+    int oneThreadSections = 0;
+    int oneThreadBytes = 0;
+    foreach (int threadCount, threadCounts) {
+        int sections = 0;
+        int bytes = 0;
+        quint64 usecs = encodeInParallel(tree, threadCount, sections, bytes);
+        if (threadCount == 1) {
+            oneThreadUsecs = usecs;
+            oneThreadSections = sections;
+            oneThreadBytes = bytes;
+
+        } else if (sections != oneThreadSections || bytes != oneThreadBytes) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << threadCount << " threads encoded " << sections
+                << " sections of " << bytes << " bytes where one encoded "
+                << oneThreadSections << " of " << oneThreadBytes << std::endl;
+        }
+        std::cout << "Time to full scene on " << threadCount << " encode threads: " << usecs << " usecs, "
+            << sections << " sections of " << bytes << " bytes, " << (float)oneThreadUsecs / qMax(usecs, (quint64)1)
+            << "x the speed of one thread and " << (float)serialUsecs / qMax(usecs, (quint64)1)
+            << "x that of a single bag" << std::endl;
+    }
+    std::cout << "(" << idealThreadCount << " cores on this machine)" << std::endl;
+}
+
+void OctreeParallelEncoderTests::runAllTests() {
+    decodesToTheSameTree();
+    benchmarkTimeToFullScene();
+}
@@ -0,0 +1,20 @@
+//
+//  OctreeParallelEncoderTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeParallelEncoderTests__
+#define __tests__OctreeParallelEncoderTests__
+
+namespace OctreeParallelEncoderTests {
+
+    void decodesToTheSameTree();
+
+    void benchmarkTimeToFullScene();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeParallelEncoderTests__
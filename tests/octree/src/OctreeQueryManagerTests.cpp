@@ -0,0 +1,263 @@
+//
+//  OctreeQueryManagerTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <OctreeConstants.h>
+#include <OctreeQueryManager.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+
+#include "OctreeQueryManagerTests.h"
+
+const float HALF_TREE_SCALE = TREE_SCALE / 2.0f;
+const float VIEW_DISTANCE = 1000.0f;
+const int TOTAL_PPS = 600;
+const quint64 USECS_PER_FRAME = USECS_PER_SECOND / 60;
+
+static void setUpViewFrustum(ViewFrustum& viewFrustum, const glm::vec3& position,
+        const glm::quat& orientation = glm::quat()) {
+    viewFrustum.setPosition(position);
+    viewFrustum.setOrientation(orientation);
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(VIEW_DISTANCE);
+    viewFrustum.calculate();
+}
+
+// one server for each of the eighths of the tree
+static QVector<OctreeServerBudget> makeServers() {
+    QVector<OctreeServerBudget> servers;
+    for (int i = 0; i < 8; i++) {
+        OctreeServerBudget server;
+        server.nodeUUID = QUuid::createUuid();
+        server.isJurisdictionKnown = true;
+        server.hasBounds = true;
+        server.bounds = AABox(glm::vec3((i & 1) ? HALF_TREE_SCALE : 0.0f, (i & 2) ? HALF_TREE_SCALE : 0.0f,
+            (i & 4) ? HALF_TREE_SCALE : 0.0f), HALF_TREE_SCALE);
+        servers.append(server);
+    }
+    return servers;
+}
+
+void OctreeQueryManagerTests::budgetFollowsVisibleVolume() {
+    QVector<OctreeServerBudget> servers = makeServers();
+    ViewFrustum viewFrustum;
+
+    // well inside the first server, looking down -z: it should get everything
+    setUpViewFrustum(viewFrustum, glm::vec3(HALF_TREE_SCALE / 2.0f, 100.0f, HALF_TREE_SCALE / 2.0f));
+    OctreeQueryManager::allocateBudget(viewFrustum, TOTAL_PPS, servers);
+    for (int i = 0; i < servers.size(); i++) {
+        int expected = (i == 0) ? TOTAL_PPS : 0;
+        if (servers.at(i).packetsPerSecond != expected) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: server " << i << " got " << servers.at(i).packetsPerSecond
+                << " PPS rather than " << expected << std::endl;
+        }
+    }
+
+    // straddling the first two, but mostly in the second: both should get some, the second more
+    setUpViewFrustum(viewFrustum, glm::vec3(HALF_TREE_SCALE + 100.0f, 100.0f, HALF_TREE_SCALE / 2.0f));
+    OctreeQueryManager::allocateBudget(viewFrustum, TOTAL_PPS, servers);
+    if (!servers.at(0).isInView || !servers.at(1).isInView || servers.at(0).packetsPerSecond <= 0 ||
+            servers.at(1).packetsPerSecond <= servers.at(0).packetsPerSecond) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: straddling two servers, gave them "
+            << servers.at(0).packetsPerSecond << " and " << servers.at(1).packetsPerSecond << " PPS" << std::endl;
+    }
+    if (servers.at(0).packetsPerSecond + servers.at(1).packetsPerSecond > TOTAL_PPS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gave out more than the budget" << std::endl;
+    }
+
+    // a server we know nothing about yet gets a little to tell us its jurisdiction, out of the same total
+    servers[7].isJurisdictionKnown = false;
+    setUpViewFrustum(viewFrustum, glm::vec3(HALF_TREE_SCALE / 2.0f, 100.0f, HALF_TREE_SCALE / 2.0f));
+    OctreeQueryManager::allocateBudget(viewFrustum, TOTAL_PPS, servers);
+    if (servers.at(7).packetsPerSecond <= 0 ||
+            servers.at(0).packetsPerSecond + servers.at(7).packetsPerSecond != TOTAL_PPS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: with an unknown server, gave " << servers.at(0).packetsPerSecond
+            << " PPS to the one in view and " << servers.at(7).packetsPerSecond << " to the unknown" << std::endl;
+    }
+
+    // a jurisdiction without a root isn't anywhere, so even one around the view gets nothing
+    servers[7].isJurisdictionKnown = true;
+    servers[0].hasBounds = false;
+    OctreeQueryManager::allocateBudget(viewFrustum, TOTAL_PPS, servers);
+    if (servers.at(0).isInView || servers.at(0).packetsPerSecond != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gave " << servers.at(0).packetsPerSecond
+            << " PPS to a server whose jurisdiction has no root" << std::endl;
+    }
+}
+
+void OctreeQueryManagerTests::queryDueOnlyWhenViewOrLODChanges() {
+    OctreeQueryManager manager;
+    ViewFrustum viewFrustum;
+    glm::vec3 position(HALF_TREE_SCALE / 2.0f, 100.0f, HALF_TREE_SCALE / 2.0f);
+    setUpViewFrustum(viewFrustum, position);
+    float sizeScale = DEFAULT_OCTREE_SIZE_SCALE;
+    quint64 now = USECS_PER_SECOND;
+
+    if (!manager.isQueryDue(viewFrustum, sizeScale, 0, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the first query wasn't due" << std::endl;
+    }
+
+    // a small step isn't enough
+    now += USECS_PER_FRAME;
+    setUpViewFrustum(viewFrustum, position + glm::vec3(1.0f, 0.0f, 0.0f));
+    if (manager.isQueryDue(viewFrustum, sizeScale, 0, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a query was due after a small step" << std::endl;
+    }
+
+    // a big one is
+    now += USECS_PER_FRAME;
+    setUpViewFrustum(viewFrustum, position + glm::vec3(10.0f, 0.0f, 0.0f));
+    if (!manager.isQueryDue(viewFrustum, sizeScale, 0, now) || !manager.hasViewChanged()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: no query was due after a big step" << std::endl;
+    }
+
+    // as is a change of LOD
+    now += USECS_PER_FRAME;
+    if (!manager.isQueryDue(viewFrustum, sizeScale / 2.0f, 0, now) || !manager.hasViewChanged()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: no query was due after a change of size scale" << std::endl;
+    }
+    now += USECS_PER_FRAME;
+    if (!manager.isQueryDue(viewFrustum, sizeScale / 2.0f, 1, now) || !manager.hasViewChanged()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: no query was due after a change of boundary level adjust"
+            << std::endl;
+    }
+
+    // standing still, servers are looked at again now and then, but the view hasn't changed
+    now += USECS_PER_FRAME;
+    if (manager.isQueryDue(viewFrustum, sizeScale / 2.0f, 1, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a query was due standing still" << std::endl;
+    }
+    now += 5 * USECS_PER_SECOND;
+    if (!manager.isQueryDue(viewFrustum, sizeScale / 2.0f, 1, now) || manager.hasViewChanged()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: standing still for a while should check the servers "
+            << "without the view having changed" << std::endl;
+    }
+}
+
+void OctreeQueryManagerTests::unchangedServersAreSkipped() {
+    OctreeQueryManager manager;
+    ViewFrustum viewFrustum;
+    glm::vec3 position(HALF_TREE_SCALE / 2.0f, 100.0f, HALF_TREE_SCALE / 2.0f);
+    setUpViewFrustum(viewFrustum, position);
+    quint64 now = USECS_PER_SECOND;
+    const quint64 WAKE = 1;
+    QUuid inView = QUuid::createUuid();
+    QUuid outOfView = QUuid::createUuid();
+
+    manager.isQueryDue(viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, 0, now);
+    if (!manager.isServerQueryDue(inView, WAKE, TOTAL_PPS, now) || !manager.isServerQueryDue(outOfView, WAKE, 0, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: servers never queried should be due" << std::endl;
+    }
+    manager.queryWasSent(inView, WAKE, TOTAL_PPS, 100, now);
+    manager.queryWasSent(outOfView, WAKE, 0, 100, now);
+
+    // turn: the server in view needs to know, the one that's sending nothing doesn't
+    now += USECS_PER_FRAME;
+    setUpViewFrustum(viewFrustum, position, glm::angleAxis(0.5f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    manager.isQueryDue(viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, 0, now);
+    if (!manager.isServerQueryDue(inView, WAKE, TOTAL_PPS, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a server in view wasn't due after turning" << std::endl;
+    }
+    if (manager.isServerQueryDue(outOfView, WAKE, 0, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a server out of view was due after turning" << std::endl;
+    }
+
+    // unless its budget changes, it's come back under the same UUID, or it's been a long time
+    if (!manager.isServerQueryDue(outOfView, WAKE, 10, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a server wasn't due after its budget changed" << std::endl;
+    }
+    if (!manager.isServerQueryDue(outOfView, WAKE + 1, 0, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a server wasn't due after it rejoined" << std::endl;
+    }
+    if (!manager.isServerQueryDue(outOfView, WAKE, 0, now + 30 * USECS_PER_SECOND)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a server wasn't due after a long while" << std::endl;
+    }
+
+    // skips count what they saved, reported a second later
+    manager.queryWasSkipped(outOfView);
+    manager.isQueryDue(viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, 0, now + USECS_PER_SECOND);
+    if (manager.getSavedPacketsPerSecond() != 1 || manager.getSavedBytesPerSecond() != 100) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: saved " << manager.getSavedPacketsPerSecond() << " packets and "
+            << manager.getSavedBytesPerSecond() << " bytes, rather than 1 and 100" << std::endl;
+    }
+}
+
+void OctreeQueryManagerTests::benchmarkQueriesOverAWalk() {
+    // a minute walking and looking around a world of eight servers, against querying every server each time the view
+    // changes or three seconds pass, as Application::queryOctree used to
+    const int FRAMES = 60 * 60;
+    const quint64 OLD_QUERY_INTERVAL = 3 * USECS_PER_SECOND;
+    const int QUERY_BYTES = 100;
+    const float WALK_SPEED = 1.5f;
+    const float TURN_SPEED = 0.5f;
+
+    QVector<OctreeServerBudget> servers = makeServers();
+    OctreeQueryManager manager;
+    ViewFrustum viewFrustum;
+    ViewFrustum oldLastQueried;
+    quint64 oldLastQuery = 0;
+    int oldQueries = 0;
+    int newQueries = 0;
+    int skippedQueries = 0;
+    quint64 allocateUsecs = 0;
+    int allocations = 0;
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        quint64 now = USECS_PER_SECOND + frame * USECS_PER_FRAME;
+        float seconds = frame / 60.0f;
+        glm::quat orientation = glm::angleAxis(TURN_SPEED * seconds, glm::vec3(0.0f, 1.0f, 0.0f));
+        setUpViewFrustum(viewFrustum, glm::vec3(HALF_TREE_SCALE - 50.0f, 100.0f, HALF_TREE_SCALE - 50.0f) +
+            orientation * IDENTITY_FRONT * (WALK_SPEED * seconds), orientation);
+
+        if (oldLastQuery == 0 || now - oldLastQuery > OLD_QUERY_INTERVAL || !oldLastQueried.isVerySimilar(viewFrustum)) {
+            oldLastQuery = now;
+            oldLastQueried = viewFrustum;
+            oldQueries += servers.size();
+        }
+
+        if (!manager.isQueryDue(viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, 0, now)) {
+            continue;
+        }
+        quint64 start = usecTimestampNow();
+        OctreeQueryManager::allocateBudget(viewFrustum, TOTAL_PPS, servers);
+        allocateUsecs += usecTimestampNow() - start;
+        allocations++;
+        for (int i = 0; i < servers.size(); i++) {
+            if (manager.isServerQueryDue(servers.at(i).nodeUUID, 1, servers.at(i).packetsPerSecond, now)) {
+                manager.queryWasSent(servers.at(i).nodeUUID, 1, servers.at(i).packetsPerSecond, QUERY_BYTES, now);
+                newQueries++;
+            } else {
+                manager.queryWasSkipped(servers.at(i).nodeUUID);
+                skippedQueries++;
+            }
+        }
+    }
+
+    std::cout << "Octree queries over a minute's walk among 8 servers: " << oldQueries << " querying every server, "
+        << newQueries << " querying only changed ones (" << skippedQueries << " skipped, "
+        << (oldQueries - newQueries) * QUERY_BYTES << " bytes saved), "
+        << (allocations ? allocateUsecs / allocations : 0) << " usecs per budget" << std::endl;
+
+    if (newQueries >= oldQueries) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: querying only changed servers sent no fewer queries"
+            << std::endl;
+    }
+}
+
+void OctreeQueryManagerTests::runAllTests() {
+    budgetFollowsVisibleVolume();
+    queryDueOnlyWhenViewOrLODChanges();
+    unchangedServersAreSkipped();
+
+    benchmarkQueriesOverAWalk();
+}
@@ -0,0 +1,22 @@
+//
+//  OctreeQueryManagerTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeQueryManagerTests__
+#define __tests__OctreeQueryManagerTests__
+
+namespace OctreeQueryManagerTests {
+
+    void budgetFollowsVisibleVolume();
+    void queryDueOnlyWhenViewOrLODChanges();
+    void unchangedServersAreSkipped();
+
+    void benchmarkQueriesOverAWalk();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeQueryManagerTests__
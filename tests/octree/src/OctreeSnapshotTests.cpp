@@ -0,0 +1,297 @@
+//
+//  OctreeSnapshotTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <OctreeSnapshot.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeSnapshotTests.h"
+
+const float CITY_VOXEL_SIZE = 1.0f / 4096.0f;
+const int CITY_BLOCKS = 12;
+const int BUILDING_WIDTH = 6;
+const int STREET_WIDTH = 2;
+const int CITY_WIDTH = CITY_BLOCKS * (BUILDING_WIDTH + STREET_WIDTH);
+const int MAX_BUILDING_HEIGHT = 32;
+const int RANDOM_QUERY_COUNT = 2000;
+const int BENCHMARK_RAY_COUNT = 1000000;
+const float DISTANCE_EPSILON = 0.001f; // meters
+
+static void buildCity(VoxelTree& tree) {
+    for (int x = 0; x < CITY_WIDTH; x++) {
+        for (int z = 0; z < CITY_WIDTH; z++) {
+            tree.createVoxel(x * CITY_VOXEL_SIZE, 0.0f, z * CITY_VOXEL_SIZE, CITY_VOXEL_SIZE, 64, 64, 64);
+        }
+    }
+    for (int blockX = 0; blockX < CITY_BLOCKS; blockX++) {
+        for (int blockZ = 0; blockZ < CITY_BLOCKS; blockZ++) {
+            int height = randIntInRange(1, MAX_BUILDING_HEIGHT);
+            unsigned char shade = randIntInRange(128, 255);
+            for (int x = 0; x < BUILDING_WIDTH; x++) {
+                for (int z = 0; z < BUILDING_WIDTH; z++) {
+                    for (int y = 1; y <= height; y++) {
+                        tree.createVoxel((blockX * (BUILDING_WIDTH + STREET_WIDTH) + STREET_WIDTH + x) * CITY_VOXEL_SIZE,
+                            y * CITY_VOXEL_SIZE, (blockZ * (BUILDING_WIDTH + STREET_WIDTH) + STREET_WIDTH + z) *
+                            CITY_VOXEL_SIZE, CITY_VOXEL_SIZE, shade, shade, shade);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// a ray from somewhere above the city, heading down into it at an angle
+static void randomRay(glm::vec3& origin, glm::vec3& direction) {
+    float cityWidth = CITY_WIDTH * CITY_VOXEL_SIZE * TREE_SCALE;
+    origin = glm::vec3(randFloatInRange(0.0f, cityWidth), (MAX_BUILDING_HEIGHT + 8) * CITY_VOXEL_SIZE * TREE_SCALE,
+        randFloatInRange(0.0f, cityWidth));
+    direction = glm::normalize(glm::vec3(randFloatInRange(-1.0f, 1.0f), -1.0f, randFloatInRange(-1.0f, 1.0f)));
+}
+
+// the recursive search the tree used before it had a query engine, kept as the reference
+class RecursiveRayArgs {
+public:
+    glm::vec3 origin;
+    glm::vec3 direction;
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
+    bool found;
+};
+
+static bool recursiveRayOperation(OctreeElement* element, void* extraData) {
+    RecursiveRayArgs* args = static_cast<RecursiveRayArgs*>(extraData);
+    float distance;
+    BoxFace face;
+    if (!element->getAABox().findRayIntersection(args->origin, args->direction, distance, face)) {
+        return false;
+    }
+    if (!element->isLeaf()) {
+        return true;
+    }
+    distance *= TREE_SCALE;
+    if (element->hasContent() && (!args->found || distance < args->distance)) {
+        args->element = element;
+        args->distance = distance;
+        args->face = face;
+        args->found = true;
+    }
+    return false;
+}
+
+static bool recursiveRayIntersection(VoxelTree& tree, const glm::vec3& origin, const glm::vec3& direction,
+                                     float& distance) {
+    RecursiveRayArgs args = { origin / (float)TREE_SCALE, direction, NULL, 0.0f, MIN_X_FACE, false };
+    tree.recurseTreeWithOperation(recursiveRayOperation, &args);
+    distance = args.distance;
+    return args.found;
+}
+
+void OctreeSnapshotTests::rayQueriesMatchRecursiveSearch() {
+    VoxelTree tree;
+    buildCity(tree);
+    tree.publishSnapshot();
+    QSharedPointer<const OctreeSnapshot> snapshot = tree.getSnapshot();
+
+    for (int i = 0; i < RANDOM_QUERY_COUNT; i++) {
+        glm::vec3 origin, direction;
+        randomRay(origin, direction);
+
+        float expectedDistance;
+        bool expected = recursiveRayIntersection(tree, origin, direction, expectedDistance);
+
+        OctreeElement* element;
+        float treeDistance;
+        BoxFace treeFace;
+        bool fromTree = tree.findRayIntersection(origin, direction, element, treeDistance, treeFace, Octree::Lock);
+
+        OctreeSnapshotHit hit;
+        float snapshotDistance;
+        BoxFace snapshotFace;
+        bool fromSnapshot = snapshot->findRayIntersection(origin, direction, snapshotDistance, snapshotFace, &hit);
+
+        if (fromTree != expected || fromSnapshot != expected) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ray " << i << " hit: expected " << expected
+                << " tree " << fromTree << " snapshot " << fromSnapshot << std::endl;
+            return;
+        }
+        if (expected && (fabsf(treeDistance - expectedDistance) > DISTANCE_EPSILON ||
+                fabsf(snapshotDistance - expectedDistance) > DISTANCE_EPSILON)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ray " << i << " distance: expected "
+                << expectedDistance << " tree " << treeDistance << " snapshot " << snapshotDistance << std::endl;
+            return;
+        }
+        if (expected && (hit.corner != element->getAABox().getCorner() || treeFace != snapshotFace ||
+                hit.color[0] != static_cast<VoxelTreeElement*>(element)->getColor()[0])) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ray " << i
+                << " hit a different voxel in the snapshot" << std::endl;
+            return;
+        }
+    }
+}
+
+void OctreeSnapshotTests::shapeQueriesMatchTree() {
+    VoxelTree tree;
+    buildCity(tree);
+    tree.publishSnapshot();
+    QSharedPointer<const OctreeSnapshot> snapshot = tree.getSnapshot();
+
+    float cityWidth = CITY_WIDTH * CITY_VOXEL_SIZE * TREE_SCALE;
+    float cityHeight = MAX_BUILDING_HEIGHT * CITY_VOXEL_SIZE * TREE_SCALE;
+    float radius = CITY_VOXEL_SIZE * TREE_SCALE;
+    int penetrations = 0;
+    for (int i = 0; i < RANDOM_QUERY_COUNT; i++) {
+        glm::vec3 center(randFloatInRange(0.0f, cityWidth), randFloatInRange(0.0f, cityHeight),
+            randFloatInRange(0.0f, cityWidth));
+
+        glm::vec3 treePenetration, snapshotPenetration;
+        bool fromTree = tree.findSpherePenetration(center, radius, treePenetration, NULL, Octree::Lock);
+        bool fromSnapshot = snapshot->findSpherePenetration(center, radius, snapshotPenetration);
+        if (fromTree != fromSnapshot || glm::distance(treePenetration, snapshotPenetration) > DISTANCE_EPSILON) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: sphere " << i << " penetration differs" << std::endl;
+            return;
+        }
+
+        // a standing avatar sized capsule
+        glm::vec3 top = center + glm::vec3(0.0f, 4.0f * radius, 0.0f);
+        fromTree = tree.findCapsulePenetration(center, top, radius, treePenetration, Octree::Lock);
+        fromSnapshot = snapshot->findCapsulePenetration(center, top, radius, snapshotPenetration);
+        if (fromTree != fromSnapshot || glm::distance(treePenetration, snapshotPenetration) > DISTANCE_EPSILON) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: capsule " << i << " penetration differs" << std::endl;
+            return;
+        }
+        penetrations += fromTree ? 1 : 0;
+    }
+    if (penetrations == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: no capsule touched the city, so nothing was compared"
+            << std::endl;
+    }
+}
+
+void OctreeSnapshotTests::snapshotOutlivesEdits() {
+    VoxelTree tree;
+    if (tree.getSnapshot()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a tree has a snapshot before one is published" << std::endl;
+    }
+    tree.createVoxel(0.0f, 0.0f, 0.0f, CITY_VOXEL_SIZE, 255, 0, 0);
+    tree.publishSnapshot();
+    QSharedPointer<const OctreeSnapshot> snapshot = tree.getSnapshot();
+
+    // the snapshot keeps answering for the tree as it was
+    tree.deleteVoxelAt(0.0f, 0.0f, 0.0f, CITY_VOXEL_SIZE);
+    glm::vec3 origin = glm::vec3(0.5f, 2.0f, 0.5f) * CITY_VOXEL_SIZE * (float)TREE_SCALE;
+    glm::vec3 down(0.0f, -1.0f, 0.0f);
+    float distance;
+    BoxFace face;
+    OctreeSnapshotHit hit;
+    if (!snapshot->findRayIntersection(origin, down, distance, face, &hit) || face != MAX_Y_FACE || hit.color[0] != 255) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: snapshot lost the voxel deleted after it was taken"
+            << std::endl;
+    }
+    OctreeElement* element;
+    if (tree.findRayIntersection(origin, down, element, distance, face, Octree::Lock)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: tree still has the deleted voxel" << std::endl;
+    }
+    tree.publishSnapshot();
+    if (tree.getSnapshot()->findRayIntersection(origin, down, distance, face)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: republished snapshot still has the deleted voxel"
+            << std::endl;
+    }
+}
+
+void OctreeSnapshotTests::editsMarkSnapshotStale() {
+    VoxelTree tree;
+    if (!tree.isSnapshotStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a new tree's snapshot isn't stale" << std::endl;
+    }
+    tree.createVoxel(0.0f, 0.0f, 0.0f, CITY_VOXEL_SIZE, 255, 0, 0);
+    tree.publishSnapshot();
+    if (tree.isSnapshotStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: snapshot stale right after publishing" << std::endl;
+    }
+
+    // the renderer clearing the dirty bit mustn't hide a change from the snapshot
+    tree.createVoxel(CITY_VOXEL_SIZE, 0.0f, 0.0f, CITY_VOXEL_SIZE, 0, 255, 0);
+    tree.clearDirtyBit();
+    if (!tree.isSnapshotStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: snapshot not stale after a create" << std::endl;
+    }
+    tree.publishSnapshot();
+
+    tree.deleteVoxelAt(0.0f, 0.0f, 0.0f, CITY_VOXEL_SIZE);
+    tree.clearDirtyBit();
+    if (!tree.isSnapshotStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: snapshot not stale after a delete" << std::endl;
+    }
+    tree.publishSnapshot();
+    if (tree.isSnapshotStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: snapshot stale after republishing" << std::endl;
+    }
+}
+
+void OctreeSnapshotTests::benchmarkMillionRays() {
+    VoxelTree tree;
+    buildCity(tree);
+
+    quint64 start = usecTimestampNow();
+    tree.publishSnapshot();
+    quint64 publishUsec = usecTimestampNow() - start;
+    QSharedPointer<const OctreeSnapshot> snapshot = tree.getSnapshot();
+
+    QVector<glm::vec3> origins(BENCHMARK_RAY_COUNT), directions(BENCHMARK_RAY_COUNT);
+    for (int i = 0; i < BENCHMARK_RAY_COUNT; i++) {
+        randomRay(origins[i], directions[i]);
+    }
+
+    int recursiveHits = 0;
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_RAY_COUNT; i++) {
+        float distance;
+        recursiveHits += recursiveRayIntersection(tree, origins.at(i), directions.at(i), distance) ? 1 : 0;
+    }
+    quint64 recursiveUsec = usecTimestampNow() - start;
+
+    int treeHits = 0;
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_RAY_COUNT; i++) {
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        treeHits += tree.findRayIntersection(origins.at(i), directions.at(i), element, distance, face, Octree::Lock) ? 1 : 0;
+    }
+    quint64 treeUsec = usecTimestampNow() - start;
+
+    int snapshotHits = 0;
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_RAY_COUNT; i++) {
+        float distance;
+        BoxFace face;
+        snapshotHits += snapshot->findRayIntersection(origins.at(i), directions.at(i), distance, face) ? 1 : 0;
+    }
+    quint64 snapshotUsec = usecTimestampNow() - start;
+
+    std::cout << BENCHMARK_RAY_COUNT << " rays against " << snapshot->getElementCount() << " elements, snapshot took "
+        << publishUsec << " usecs to publish" << std::endl;
+    std::cout << "  recursive search: " << recursiveUsec << " usecs, " << recursiveHits << " hits" << std::endl;
+    std::cout << "  tree query:       " << treeUsec << " usecs, " << treeHits << " hits" << std::endl;
+    std::cout << "  snapshot query:   " << snapshotUsec << " usecs, " << snapshotHits << " hits" << std::endl;
+
+    if (treeHits != recursiveHits || snapshotHits != recursiveHits) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: queries disagree on how many rays hit" << std::endl;
+    }
+}
+
+void OctreeSnapshotTests::runAllTests() {
+    rayQueriesMatchRecursiveSearch();
+    shapeQueriesMatchTree();
+    snapshotOutlivesEdits();
+    editsMarkSnapshotStale();
+
+    benchmarkMillionRays();
+}
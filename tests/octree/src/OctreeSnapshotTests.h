@@ -0,0 +1,23 @@
+//
+//  OctreeSnapshotTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeSnapshotTests__
+#define __tests__OctreeSnapshotTests__
+
+namespace OctreeSnapshotTests {
+
+    void rayQueriesMatchRecursiveSearch();
+    void shapeQueriesMatchTree();
+    void snapshotOutlivesEdits();
+    void editsMarkSnapshotStale();
+
+    void benchmarkMillionRays();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeSnapshotTests__
@@ -0,0 +1,24 @@
+//
+//  OctreeTestUtil.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include "OctreeTestUtil.h"
+
+void buildTown(VoxelTree& tree, const glm::vec3& corner, int width, int maxHouseHeight) {
+    for (int x = 0; x < width; x++) {
+        for (int z = 0; z < width; z++) {
+            tree.createVoxel(corner.x + x * TOWN_VOXEL_SIZE, corner.y, corner.z + z * TOWN_VOXEL_SIZE, TOWN_VOXEL_SIZE,
+                64, 96, 64);
+            if (x % 4 != 0 && z % 4 != 0) {
+                int height = (x * 7 + z * 3) % maxHouseHeight;
+                for (int y = 1; y <= height; y++) {
+                    tree.createVoxel(corner.x + x * TOWN_VOXEL_SIZE, corner.y + y * TOWN_VOXEL_SIZE,
+                        corner.z + z * TOWN_VOXEL_SIZE, TOWN_VOXEL_SIZE, 160, 128, 96);
+                }
+            }
+        }
+    }
+}
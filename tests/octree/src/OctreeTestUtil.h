@@ -0,0 +1,22 @@
+//
+//  OctreeTestUtil.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeTestUtil__
+#define __tests__OctreeTestUtil__
+
+#include <glm/glm.hpp>
+
+#include <VoxelTree.h>
+
+const float TOWN_VOXEL_SIZE = 1.0f / TREE_SCALE; // a meter
+
+/// Lays out a town of one meter voxels: a width by width square of ground with its low corner at corner (in the tree's 0
+/// to 1 units), and on it houses up to maxHouseHeight high, with a street every fourth row. The same arguments always
+/// build the same town.
+void buildTown(VoxelTree& tree, const glm::vec3& corner, int width, int maxHouseHeight);
+
+#endif // __tests__OctreeTestUtil__
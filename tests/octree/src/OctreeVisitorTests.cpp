@@ -0,0 +1,285 @@
+//
+//  OctreeVisitorTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cmath>
+#include <iostream>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "OctreeVisitorTests.h"
+
+const float VOXEL_SIZE = 1.0f / 1024.0f;
+const int TERRAIN_WIDTH = 128; // voxels along each side
+const int MAX_TERRAIN_HEIGHT = 16;
+const int PRUNED_LEVEL = 6; // the order test doesn't go below this level, to check that pruning matches too
+const int BENCHMARK_PASSES = 20;
+
+// rolling hills, so the frustum walks see every kind of element
+static void buildTerrain(VoxelTree& tree) {
+    for (int x = 0; x < TERRAIN_WIDTH; x++) {
+        for (int z = 0; z < TERRAIN_WIDTH; z++) {
+            int height = 1 + (int)((MAX_TERRAIN_HEIGHT - 1) * 0.5f * (1.0f + sinf(x * 0.1f) * cosf(z * 0.07f)));
+            for (int y = 0; y < height; y++) {
+                unsigned char shade = 64 + y * 8;
+                tree.createVoxel(x * VOXEL_SIZE, y * VOXEL_SIZE, z * VOXEL_SIZE, VOXEL_SIZE, shade, shade, shade);
+            }
+        }
+    }
+}
+
+// the recursive walk recurseTreeWithOperation used before the visitors, kept as the reference
+static void recurseWithOperation(OctreeElement* element, RecurseOctreeOperation operation, void* extraData) {
+    if (operation(element, extraData)) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            OctreeElement* child = element->getChildAtIndex(i);
+            if (child) {
+                recurseWithOperation(child, operation, extraData);
+            }
+        }
+    }
+}
+
+static bool recordOperation(OctreeElement* element, void* extraData) {
+    static_cast<QVector<OctreeElement*>*>(extraData)->append(element);
+    return element->getLevel() < PRUNED_LEVEL;
+}
+
+class RecordVisitor {
+public:
+    QVector<OctreeElement*> visited;
+    bool visit(OctreeElement* element) { return recordOperation(element, &visited); }
+};
+
+void OctreeVisitorTests::visitOrderMatchesRecursion() {
+    VoxelTree tree;
+    buildTerrain(tree);
+
+    QVector<OctreeElement*> recursed;
+    recurseWithOperation(tree.getRoot(), recordOperation, &recursed);
+
+    RecordVisitor visitor;
+    tree.visitTree(visitor);
+    if (visitor.visited != recursed) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: visitTree visited " << visitor.visited.size()
+            << " elements in a different order from the recursion's " << recursed.size() << std::endl;
+    }
+
+    QVector<OctreeElement*> operated;
+    tree.recurseTreeWithOperation(recordOperation, &operated);
+    if (operated != recursed) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: recurseTreeWithOperation changed its order" << std::endl;
+    }
+}
+
+// stops at the first leaf it comes to
+class FirstLeafVisitor {
+public:
+    FirstLeafVisitor() : leaf(NULL) { }
+    OctreeElement* leaf;
+    bool visit(OctreeElement* element) {
+        if (leaf) {
+            return false;
+        }
+        if (element->isLeaf()) {
+            leaf = element;
+        }
+        return true;
+    }
+};
+
+void OctreeVisitorTests::nearestFirstStartsAtPoint() {
+    VoxelTree tree;
+    buildTerrain(tree);
+
+    for (int i = 0; i < 100; i++) {
+        int x = randIntInRange(0, TERRAIN_WIDTH - 1);
+        int z = randIntInRange(0, TERRAIN_WIDTH - 1);
+        glm::vec3 point = glm::vec3(x + 0.5f, 0.5f, z + 0.5f) * VOXEL_SIZE;
+
+        FirstLeafVisitor visitor;
+        tree.visitTreeNearestFirst(point, visitor);
+        if (!visitor.leaf || !visitor.leaf->getAABox().contains(point)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the first leaf visited nearest first doesn't hold "
+                "the point" << std::endl;
+            return;
+        }
+    }
+}
+
+// deletes the voxel next to the first one when it gets to it, before the walk reaches the sibling
+class DeleteSiblingVisitor {
+public:
+    DeleteSiblingVisitor(VoxelTree& tree) : tree(tree), deleted(NULL) { }
+    VoxelTree& tree;
+    OctreeElement* deleted;
+    QVector<OctreeElement*> visited;
+    bool visit(OctreeElement* element) {
+        visited.append(element);
+        if (!deleted && element == tree.getVoxelAt(0.0f, 0.0f, 0.0f, VOXEL_SIZE)) {
+            deleted = tree.getVoxelAt(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE);
+            tree.deleteVoxelAt(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE);
+        }
+        return true;
+    }
+};
+
+void OctreeVisitorTests::visitMayDeleteSiblings() {
+    VoxelTree tree;
+    tree.createVoxel(0.0f, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    tree.createVoxel(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 0, 255, 0);
+    tree.createVoxel(0.0f, VOXEL_SIZE, 0.0f, VOXEL_SIZE, 0, 0, 255);
+
+    DeleteSiblingVisitor visitor(tree);
+    tree.visitTree(visitor);
+    if (!visitor.deleted) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: never reached the first voxel" << std::endl;
+        return;
+    }
+    // the walk should find the sibling gone rather than visit what's left of it, and still visit the others
+    if (visitor.visited.contains(visitor.deleted) ||
+            !visitor.visited.contains(tree.getVoxelAt(0.0f, VOXEL_SIZE, 0.0f, VOXEL_SIZE))) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the walk didn't see the sibling's deletion" << std::endl;
+    }
+}
+
+// the frustum checks VoxelSystem::hideOutOfView makes of every element it reaches
+class HideOutOfViewArgs {
+public:
+    const ViewFrustum* viewFrustum;
+    int inside;
+    int outside;
+    int shown;
+};
+
+static bool hideOutOfView(OctreeElement* element, HideOutOfViewArgs& args) {
+    switch (element->inFrustum(*args.viewFrustum)) {
+        case ViewFrustum::OUTSIDE:
+            args.outside++;
+            return false;
+        case ViewFrustum::INSIDE:
+            args.inside++;
+            break;
+        default:
+            break;
+    }
+    if (element->calculateShouldRender(args.viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST)) {
+        args.shown++;
+    }
+    return true;
+}
+
+static bool hideOutOfViewOperation(OctreeElement* element, void* extraData) {
+    return hideOutOfView(element, *static_cast<HideOutOfViewArgs*>(extraData));
+}
+
+class HideOutOfViewVisitor {
+public:
+    HideOutOfViewVisitor(HideOutOfViewArgs& args) : _args(args) { }
+    bool visit(OctreeElement* element) { return hideOutOfView(element, _args); }
+private:
+    HideOutOfViewArgs& _args;
+};
+
+void OctreeVisitorTests::benchmarkHideOutOfView() {
+    VoxelTree tree;
+    buildTerrain(tree);
+
+    // over one corner of the terrain, looking across it
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(0.0f, MAX_TERRAIN_HEIGHT * VOXEL_SIZE, 0.0f) * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::angleAxis(-135.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.calculate();
+
+    HideOutOfViewArgs recursedArgs = { &viewFrustum, 0, 0, 0 };
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_PASSES; i++) {
+        recurseWithOperation(tree.getRoot(), hideOutOfViewOperation, &recursedArgs);
+    }
+    quint64 recursedUsec = usecTimestampNow() - start;
+
+    HideOutOfViewArgs visitedArgs = { &viewFrustum, 0, 0, 0 };
+    HideOutOfViewVisitor visitor(visitedArgs);
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_PASSES; i++) {
+        tree.visitTree(visitor);
+    }
+    quint64 visitedUsec = usecTimestampNow() - start;
+
+    std::cout << "hideOutOfView walk, recursion: " << recursedUsec / BENCHMARK_PASSES << " usecs" << std::endl;
+    std::cout << "hideOutOfView walk, visitor:   " << visitedUsec / BENCHMARK_PASSES << " usecs" << std::endl;
+
+    if (visitedArgs.inside != recursedArgs.inside || visitedArgs.outside != recursedArgs.outside ||
+            visitedArgs.shown != recursedArgs.shown) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the walks classified the tree differently" << std::endl;
+    }
+}
+
+// the per element update and the prune ParticleTree::update makes of every element
+static bool updateOperation(OctreeElement* element, void* extraData) {
+    if (element->isLeaf() && element->hasContent()) {
+        (*static_cast<int*>(extraData))++;
+    }
+    return true;
+}
+
+static bool pruneOperation(OctreeElement* element, void* extraData) {
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        if (child && child->isLeaf() && !child->hasContent()) {
+            element->deleteChildAtIndex(i);
+        }
+    }
+    return true;
+}
+
+void OctreeVisitorTests::benchmarkUpdateAndPrune() {
+    VoxelTree tree;
+    buildTerrain(tree);
+
+    int recursedLeaves = 0;
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_PASSES; i++) {
+        recurseWithOperation(tree.getRoot(), updateOperation, &recursedLeaves);
+        recurseWithOperation(tree.getRoot(), pruneOperation, NULL);
+    }
+    quint64 recursedUsec = usecTimestampNow() - start;
+
+    int visitedLeaves = 0;
+    OctreeOperationVisitor<updateOperation> updateVisitor(&visitedLeaves);
+    OctreeOperationVisitor<pruneOperation> pruneVisitor;
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_PASSES; i++) {
+        tree.visitTree(updateVisitor);
+        tree.visitTree(pruneVisitor);
+    }
+    quint64 visitedUsec = usecTimestampNow() - start;
+
+    std::cout << "update and prune walks, recursion: " << recursedUsec / BENCHMARK_PASSES << " usecs" << std::endl;
+    std::cout << "update and prune walks, visitor:   " << visitedUsec / BENCHMARK_PASSES << " usecs" << std::endl;
+
+    if (visitedLeaves != recursedLeaves) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the walks updated " << recursedLeaves << " and "
+            << visitedLeaves << " leaves" << std::endl;
+    }
+}
+
+void OctreeVisitorTests::runAllTests() {
+    visitOrderMatchesRecursion();
+    nearestFirstStartsAtPoint();
+    visitMayDeleteSiblings();
+
+    benchmarkHideOutOfView();
+    benchmarkUpdateAndPrune();
+}
@@ -0,0 +1,23 @@
+//
+//  OctreeVisitorTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__OctreeVisitorTests__
+#define __tests__OctreeVisitorTests__
+
+namespace OctreeVisitorTests {
+
+    void visitOrderMatchesRecursion();
+    void nearestFirstStartsAtPoint();
+    void visitMayDeleteSiblings();
+
+    void benchmarkHideOutOfView();
+    void benchmarkUpdateAndPrune();
+
+    void runAllTests();
+}
+
+#endif // __tests__OctreeVisitorTests__
@@ -0,0 +1,157 @@
+//
+//  VoxelMeshBuilderTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cmath>
+#include <iostream>
+
+#include <SharedUtil.h>
+#include <VoxelMeshBuilder.h>
+#include <VoxelTree.h>
+#include <WorkStealingPool.h>
+
+#include "VoxelMeshBuilderTests.h"
+
+const float VOXEL_SIZE = 1.0f / 1024.0f;
+const int TERRAIN_WIDTH = 128; // voxels along each side
+const int MAX_TERRAIN_HEIGHT = 16;
+const int BENCHMARK_BUILDS = 5;
+
+static void buildTerrain(VoxelTree& tree) {
+    for (int x = 0; x < TERRAIN_WIDTH; x++) {
+        for (int z = 0; z < TERRAIN_WIDTH; z++) {
+            int height = 1 + (int)((MAX_TERRAIN_HEIGHT - 1) * 0.5f * (1.0f + sinf(x * 0.1f) * cosf(z * 0.07f)));
+            for (int y = 0; y < height; y++) {
+                unsigned char shade = 64 + y * 8;
+                tree.createVoxel(x * VOXEL_SIZE, y * VOXEL_SIZE, z * VOXEL_SIZE, VOXEL_SIZE, shade, shade, shade);
+            }
+        }
+    }
+}
+
+// close enough to the terrain that every voxel renders at full detail
+static void setUpViewFrustum(ViewFrustum& viewFrustum) {
+    viewFrustum.setPosition(glm::vec3(TERRAIN_WIDTH * 0.5f, MAX_TERRAIN_HEIGHT * 2.0f, TERRAIN_WIDTH * 0.5f) *
+        VOXEL_SIZE * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::quat());
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.calculate();
+}
+
+void VoxelMeshBuilderTests::sharedFacesAreCulled() {
+    VoxelTree tree;
+    tree.createVoxel(0.0f, 0.0f, 0.0f, VOXEL_SIZE, 255, 0, 0);
+    tree.createVoxel(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE, 0, 255, 0);
+
+    VoxelMesh mesh;
+    appendVoxelFaces(tree.getRoot(), tree.getVoxelAt(0.0f, 0.0f, 0.0f, VOXEL_SIZE), mesh);
+    appendVoxelFaces(tree.getRoot(), tree.getVoxelAt(VOXEL_SIZE, 0.0f, 0.0f, VOXEL_SIZE), mesh);
+    if (mesh.getFaceCount() != 10 || mesh.culledFaceCount != 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: two touching voxels gave " << mesh.getFaceCount()
+            << " faces with " << mesh.culledFaceCount << " culled, expected 10 and 2" << std::endl;
+    }
+
+    // a small voxel against a big one loses the face it shares, but the big one keeps its face, which is only partly hidden
+    VoxelTree mixedTree;
+    mixedTree.createVoxel(0.0f, 0.0f, 0.0f, VOXEL_SIZE * 2.0f, 255, 0, 0);
+    mixedTree.createVoxel(VOXEL_SIZE * 2.0f, 0.0f, 0.0f, VOXEL_SIZE, 0, 255, 0);
+
+    VoxelMesh bigMesh;
+    appendVoxelFaces(mixedTree.getRoot(), mixedTree.getVoxelAt(0.0f, 0.0f, 0.0f, VOXEL_SIZE * 2.0f), bigMesh);
+    VoxelMesh smallMesh;
+    appendVoxelFaces(mixedTree.getRoot(), mixedTree.getVoxelAt(VOXEL_SIZE * 2.0f, 0.0f, 0.0f, VOXEL_SIZE), smallMesh);
+    if (bigMesh.culledFaceCount != 0 || smallMesh.culledFaceCount != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: voxels of different sizes culled " << bigMesh.culledFaceCount
+            << " and " << smallMesh.culledFaceCount << " faces, expected 0 and 1" << std::endl;
+    }
+}
+
+void VoxelMeshBuilderTests::onlyChangedRegionsAreRebuilt() {
+    VoxelTree tree;
+    buildTerrain(tree);
+    ViewFrustum viewFrustum;
+    setUpViewFrustum(viewFrustum);
+
+    VoxelMeshBuilder builder;
+    int regionCount = builder.build(&tree, viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST, false);
+    QVector<VoxelMeshUpdate> updates;
+    builder.swapMeshes(updates);
+    if (regionCount == 0 || updates.size() != regionCount + 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the first build gave " << updates.size()
+            << " meshes for " << regionCount << " regions" << std::endl;
+    }
+
+    int rebuilt = builder.build(&tree, viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST, false);
+    updates.clear();
+    builder.swapMeshes(updates);
+    if (rebuilt != 0 || !updates.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: an unchanged tree rebuilt " << rebuilt << " regions"
+            << std::endl;
+    }
+
+    // one region and its neighbors at most
+    tree.createVoxel(TERRAIN_WIDTH * 0.5f * VOXEL_SIZE, 0.0f, TERRAIN_WIDTH * 0.5f * VOXEL_SIZE, VOXEL_SIZE, 255, 0, 0);
+    rebuilt = builder.build(&tree, viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST, false);
+    const int MAX_REBUILT_REGIONS = 7;
+    if (rebuilt == 0 || rebuilt > MAX_REBUILT_REGIONS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: changing a voxel rebuilt " << rebuilt << " regions"
+            << std::endl;
+    }
+
+    // only the pointers move when swapped, so the meshes are the ones that were built
+    updates.clear();
+    builder.swapMeshes(updates);
+    int faceCount = builder.getFaceCount();
+    updates.clear();
+    builder.swapMeshes(updates);
+    if (!updates.isEmpty() || builder.getFaceCount() != faceCount) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a second swap changed the meshes" << std::endl;
+    }
+}
+
+static void timeBuilds(VoxelTree& tree, const ViewFrustum& viewFrustum, WorkStealingPool* pool, const char* label) {
+    VoxelMeshBuilder builder(DEFAULT_VOXEL_MESH_CHUNK_LEVEL, pool);
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_BUILDS; i++) {
+        builder.build(&tree, viewFrustum, DEFAULT_OCTREE_SIZE_SCALE, NO_BOUNDARY_ADJUST, true);
+    }
+    quint64 elapsed = (usecTimestampNow() - start) / BENCHMARK_BUILDS;
+
+    QVector<VoxelMeshUpdate> updates;
+    builder.swapMeshes(updates);
+    int voxelCount = 0;
+    int faceCount = 0;
+    int culledFaceCount = 0;
+    foreach (const VoxelMeshUpdate& update, updates) {
+        voxelCount += update.mesh->voxelCount;
+        faceCount += update.mesh->getFaceCount();
+        culledFaceCount += update.mesh->culledFaceCount;
+    }
+    std::cout << "mesh build, " << label << ": " << voxelCount << " voxels, " << faceCount << " faces (" << culledFaceCount
+        << " culled) in " << updates.size() << " regions, " << elapsed << " usecs, "
+        << (elapsed ? (quint64)faceCount * USECS_PER_SECOND / elapsed : 0) << " faces/second" << std::endl;
+}
+
+void VoxelMeshBuilderTests::benchmarkMeshBuild() {
+    VoxelTree tree;
+    buildTerrain(tree);
+    ViewFrustum viewFrustum;
+    setUpViewFrustum(viewFrustum);
+
+    WorkStealingPool callerOnly(0);
+    timeBuilds(tree, viewFrustum, &callerOnly, "one thread");
+    timeBuilds(tree, viewFrustum, WorkStealingPool::getInstance(), "all cores ");
+}
+
+void VoxelMeshBuilderTests::runAllTests() {
+    sharedFacesAreCulled();
+    onlyChangedRegionsAreRebuilt();
+
+    benchmarkMeshBuild();
+}
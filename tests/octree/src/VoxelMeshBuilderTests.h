@@ -0,0 +1,21 @@
+//
+//  VoxelMeshBuilderTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__VoxelMeshBuilderTests__
+#define __tests__VoxelMeshBuilderTests__
+
+namespace VoxelMeshBuilderTests {
+
+    void sharedFacesAreCulled();
+    void onlyChangedRegionsAreRebuilt();
+
+    void benchmarkMeshBuild();
+
+    void runAllTests();
+}
+
+#endif // __tests__VoxelMeshBuilderTests__
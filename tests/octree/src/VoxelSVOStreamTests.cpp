@@ -0,0 +1,291 @@
+//
+//  VoxelSVOStreamTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+#include <vector>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QVector>
+
+#include <JurisdictionMap.h>
+#include <OctalCode.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+#include <VoxelSVOStream.h>
+#include <VoxelSVOTools.h>
+#include <VoxelTree.h>
+
+#include "VoxelSVOStreamTests.h"
+
+const int RANDOM_VOXEL_COUNT = 5000;
+const int RANDOM_VOXEL_RESOLUTION = 64;
+const int SURFACE_RESOLUTION = 256;
+const int SURFACE_DEPTH = 4;
+
+static QString tempFileName(const QString& name) {
+    return QDir::temp().filePath("octree-tests-" + name + ".svo");
+}
+
+static VoxelDetail randomVoxel(int resolution) {
+    float size = 1.0f / resolution;
+    VoxelDetail voxel = { randIntInRange(0, resolution - 1) * size, randIntInRange(0, resolution - 1) * size,
+        randIntInRange(0, resolution - 1) * size, size, (unsigned char)randIntInRange(0, 255),
+        (unsigned char)randIntInRange(0, 255), (unsigned char)randIntInRange(0, 255) };
+    return voxel;
+}
+
+class ColoredVoxelCount {
+public:
+    ColoredVoxelCount(const unsigned char* within = NULL) : within(within), count(0) { }
+
+    const unsigned char* within;
+    int count;
+};
+
+static bool countColoredOperation(OctreeElement* element, void* extraData) {
+    ColoredVoxelCount* args = (ColoredVoxelCount*)extraData;
+    if (static_cast<VoxelTreeElement*>(element)->isColored() &&
+            (!args->within || isAncestorOf(args->within, element->getOctalCode()))) {
+        args->count++;
+    }
+    return true;
+}
+
+static int countColored(VoxelTree& tree, const unsigned char* within = NULL) {
+    ColoredVoxelCount args(within);
+    tree.recurseTreeWithOperation(countColoredOperation, &args);
+    return args.count;
+}
+
+static bool hasColor(const VoxelTreeElement* voxel, const unsigned char* color) {
+    return voxel && voxel->isColored() && memcmp(voxel->getColor(), color, SIZE_OF_COLOR_DATA) == 0;
+}
+
+void VoxelSVOStreamTests::octalCodesRoundTrip() {
+    for (int i = 0; i < 1000; i++) {
+        VoxelDetail voxel = randomVoxel(1 << randIntInRange(1, 20));
+        unsigned char* octalCode = pointToOctalCode(voxel.x, voxel.y, voxel.z, voxel.s);
+        VoxelSVOCell cell;
+        QByteArray roundTrip;
+        if (!VoxelSVOCell::fromOctalCode(octalCode, cell)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't read octal code "
+                << octalCodeToHexString(octalCode).toLocal8Bit().constData() << std::endl;
+        } else {
+            cell.appendOctalCode(roundTrip);
+            if (compareOctalCodes(octalCode, (const unsigned char*)roundTrip.constData()) != EXACT_MATCH ||
+                    cell.x != (quint64)(voxel.x / voxel.s + 0.5f) || cell.y != (quint64)(voxel.y / voxel.s + 0.5f)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: octal code "
+                    << octalCodeToHexString(octalCode).toLocal8Bit().constData() << " didn't round trip" << std::endl;
+                delete[] octalCode;
+                return;
+            }
+        }
+        delete[] octalCode;
+    }
+}
+
+void VoxelSVOStreamTests::statsCountEveryVoxel() {
+    QVector<VoxelDetail> voxels;
+    for (int i = 0; i < RANDOM_VOXEL_COUNT; i++) {
+        voxels.append(randomVoxel(RANDOM_VOXEL_RESOLUTION));
+    }
+    VoxelTree tree;
+    tree.createVoxels(voxels, true);
+    QString fileName = tempFileName("stats");
+    tree.writeToSVOFile(fileName.toLocal8Bit().constData());
+
+    VoxelSVOStats stats;
+    if (!VoxelSVOTools::computeStats(fileName, stats)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't stream " << fileName.toLocal8Bit().constData()
+            << std::endl;
+    } else if (stats.voxelCount != (quint64)countColored(tree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: streamed " << stats.voxelCount << " voxels, the tree has "
+            << countColored(tree) << std::endl;
+    } else if (stats.byteCount != (quint64)QFile(fileName).size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: streamed " << stats.byteCount << " bytes of "
+            << QFile(fileName).size() << std::endl;
+    }
+    QFile::remove(fileName);
+}
+
+void VoxelSVOStreamTests::splitThenMergeMatchesOriginal() {
+    QVector<VoxelDetail> voxels;
+    for (int i = 0; i < RANDOM_VOXEL_COUNT; i++) {
+        voxels.append(randomVoxel(RANDOM_VOXEL_RESOLUTION));
+    }
+    VoxelTree tree;
+    tree.createVoxels(voxels, true);
+    QString fileName = tempFileName("split");
+    tree.writeToSVOFile(fileName.toLocal8Bit().constData());
+
+    // one end node just beneath the root, and one further down
+    unsigned char* rootCode = new unsigned char[1];
+    rootCode[0] = 0;
+    std::vector<unsigned char*> endNodeCodes;
+    endNodeCodes.push_back(pointToOctalCode(0.5f, 0.0f, 0.0f, 0.5f));
+    endNodeCodes.push_back(pointToOctalCode(0.25f, 0.25f, 0.25f, 0.25f));
+    JurisdictionMap jurisdiction(rootCode, endNodeCodes);
+
+    QString rootFileName = tempFileName("split-root");
+    QStringList endNodeFileNames;
+    endNodeFileNames << tempFileName("split-end-node-0") << tempFileName("split-end-node-1");
+    QString mergedFileName = tempFileName("split-merged");
+    if (!VoxelSVOTools::split(fileName, jurisdiction, rootFileName, endNodeFileNames) ||
+            !VoxelSVOTools::merge(QStringList() << rootFileName << endNodeFileNames, mergedFileName)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't split and merge "
+            << fileName.toLocal8Bit().constData() << std::endl;
+        return;
+    }
+
+    VoxelTree rootTree;
+    rootTree.readFromSVOFile(rootFileName.toLocal8Bit().constData());
+    int voxelsInPieces = countColored(rootTree);
+    for (int i = 0; i < endNodeFileNames.size(); i++) {
+        if (countColored(rootTree, jurisdiction.getEndNodeOctalCode(i)) != 0) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the root kept voxels beneath end node " << i
+                << std::endl;
+        }
+        VoxelTree endNodeTree;
+        endNodeTree.readFromSVOFile(endNodeFileNames.at(i).toLocal8Bit().constData());
+        int endNodeVoxels = countColored(endNodeTree);
+        if (countColored(endNodeTree, jurisdiction.getEndNodeOctalCode(i)) != endNodeVoxels) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: end node " << i << " got voxels from outside it"
+                << std::endl;
+        }
+        voxelsInPieces += endNodeVoxels;
+    }
+    if (voxelsInPieces != countColored(tree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the pieces hold " << voxelsInPieces << " voxels, expected "
+            << countColored(tree) << std::endl;
+    }
+
+    VoxelTree merged;
+    merged.readFromSVOFile(mergedFileName.toLocal8Bit().constData());
+    foreach (const VoxelDetail& voxel, voxels) {
+        VoxelTreeElement* expected = tree.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s);
+        if (!hasColor(merged.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s), expected->getColor())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: merged voxel at " << voxel.x << ", " << voxel.y
+                << ", " << voxel.z << " doesn't match" << std::endl;
+            break;
+        }
+    }
+
+    QFile::remove(fileName);
+    QFile::remove(rootFileName);
+    foreach (const QString& endNodeFileName, endNodeFileNames) {
+        QFile::remove(endNodeFileName);
+    }
+    QFile::remove(mergedFileName);
+}
+
+void VoxelSVOStreamTests::fillOnlyFillsBeneathLeaves() {
+    // reaveraged, so the file holds colors for the interior voxels too, and those mustn't be filled
+    const int RESOLUTION = 16;
+    const float SIZE = 1.0f / RESOLUTION;
+    const unsigned char COLOR[] = { 10, 20, 30 };
+    const int X = 3, Y = 5, Z = 7;
+    VoxelTree tree(true);
+    tree.createVoxel(X * SIZE, Y * SIZE, Z * SIZE, SIZE, COLOR[0], COLOR[1], COLOR[2]);
+    tree.reaverageOctreeElements();
+    QString fileName = tempFileName("fill");
+    tree.writeToSVOFile(fileName.toLocal8Bit().constData());
+
+    QString filledFileName = tempFileName("filled");
+    VoxelSVOStats created;
+    if (!VoxelSVOTools::fill(fileName, filledFileName, created)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't fill " << fileName.toLocal8Bit().constData()
+            << std::endl;
+        return;
+    }
+    if (created.voxelCount != (quint64)(Y + 1)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: fill created " << created.voxelCount << " voxels, expected "
+            << (Y + 1) << std::endl;
+    }
+
+    VoxelTree filled;
+    filled.readFromSVOFile(filledFileName.toLocal8Bit().constData());
+    for (int y = 0; y <= Y; y++) {
+        if (!hasColor(filled.getVoxelAt(X * SIZE, y * SIZE, Z * SIZE, SIZE), COLOR)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: missing fill voxel at height " << y << std::endl;
+        }
+    }
+    if (countColored(filled) != Y + 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: filled file has " << countColored(filled)
+            << " voxels, expected " << (Y + 1) << std::endl;
+    }
+    QFile::remove(fileName);
+    QFile::remove(filledFileName);
+}
+
+void VoxelSVOStreamTests::benchmarkStreamingTools() {
+    // the same rolling surface as the bulk load benchmark
+    QVector<VoxelDetail> voxels;
+    float size = 1.0f / SURFACE_RESOLUTION;
+    for (int x = 0; x < SURFACE_RESOLUTION; x++) {
+        for (int z = 0; z < SURFACE_RESOLUTION; z++) {
+            int height = SURFACE_RESOLUTION / 2 + (int)((SURFACE_RESOLUTION / 8) * sinf(x * 0.05f) * cosf(z * 0.07f));
+            for (int y = height - SURFACE_DEPTH; y < height; y++) {
+                VoxelDetail voxel = { x * size, y * size, z * size, size, (unsigned char)x, (unsigned char)y,
+                    (unsigned char)z };
+                voxels.append(voxel);
+            }
+        }
+    }
+    QString fileName = tempFileName("benchmark");
+    {
+        VoxelTree tree;
+        tree.createVoxels(voxels, true);
+        tree.writeToSVOFile(fileName.toLocal8Bit().constData());
+    }
+
+    quint64 start = usecTimestampNow();
+    {
+        VoxelTree tree;
+        tree.readFromSVOFile(fileName.toLocal8Bit().constData());
+    }
+    quint64 loadUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    VoxelSVOStats stats;
+    VoxelSVOTools::computeStats(fileName, stats);
+    quint64 statsUsecs = usecTimestampNow() - start;
+
+    unsigned char* rootCode = new unsigned char[1];
+    rootCode[0] = 0;
+    std::vector<unsigned char*> endNodeCodes;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        endNodeCodes.push_back(childOctalCode(rootCode, i));
+    }
+    JurisdictionMap jurisdiction(rootCode, endNodeCodes);
+    QString rootFileName = tempFileName("benchmark-root");
+    QStringList endNodeFileNames;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        endNodeFileNames << tempFileName("benchmark-end-node-" + QString::number(i));
+    }
+    start = usecTimestampNow();
+    VoxelSVOTools::split(fileName, jurisdiction, rootFileName, endNodeFileNames);
+    quint64 splitUsecs = usecTimestampNow() - start;
+
+    std::cout << "streaming " << stats.byteCount << " bytes, " << stats.voxelCount << " voxels: loading into a tree "
+        << loadUsecs << " usecs, stats " << statsUsecs << " usecs, split eight ways " << splitUsecs << " usecs"
+        << std::endl;
+
+    QFile::remove(fileName);
+    QFile::remove(rootFileName);
+    foreach (const QString& endNodeFileName, endNodeFileNames) {
+        QFile::remove(endNodeFileName);
+    }
+}
+
+void VoxelSVOStreamTests::runAllTests() {
+    octalCodesRoundTrip();
+    statsCountEveryVoxel();
+    splitThenMergeMatchesOriginal();
+    fillOnlyFillsBeneathLeaves();
+    benchmarkStreamingTools();
+}
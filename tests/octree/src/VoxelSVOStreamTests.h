@@ -0,0 +1,23 @@
+//
+//  VoxelSVOStreamTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__VoxelSVOStreamTests__
+#define __tests__VoxelSVOStreamTests__
+
+namespace VoxelSVOStreamTests {
+
+    void octalCodesRoundTrip();
+    void statsCountEveryVoxel();
+    void splitThenMergeMatchesOriginal();
+    void fillOnlyFillsBeneathLeaves();
+
+    void benchmarkStreamingTools();
+
+    void runAllTests();
+}
+
+#endif // __tests__VoxelSVOStreamTests__
@@ -0,0 +1,197 @@
+//
+//  VoxelTreeBulkLoadTests.cpp
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "VoxelTreeBulkLoadTests.h"
+
+const int RANDOM_VOXEL_COUNT = 5000;
+const int RANDOM_VOXEL_RESOLUTION = 64;
+const int SCHEMATIC_RESOLUTION = 256;
+const int SCHEMATIC_SURFACE_DEPTH = 4;
+
+static VoxelDetail randomVoxel(int resolution) {
+    float size = 1.0f / resolution;
+    VoxelDetail voxel = { randIntInRange(0, resolution - 1) * size, randIntInRange(0, resolution - 1) * size,
+        randIntInRange(0, resolution - 1) * size, size, (unsigned char)randIntInRange(0, 255),
+        (unsigned char)randIntInRange(0, 255), (unsigned char)randIntInRange(0, 255) };
+    return voxel;
+}
+
+static void createOneAtATime(VoxelTree& tree, const QVector<VoxelDetail>& voxels, bool destructive = true) {
+    foreach (const VoxelDetail& voxel, voxels) {
+        tree.createVoxel(voxel.x, voxel.y, voxel.z, voxel.s, voxel.red, voxel.green, voxel.blue, destructive);
+    }
+}
+
+static VoxelDetail coloredVoxel(float x, float y, float z, float s, unsigned char shade) {
+    VoxelDetail voxel = { x, y, z, s, shade, shade, shade };
+    return voxel;
+}
+
+static bool sameColor(const VoxelTreeElement* first, const VoxelTreeElement* second) {
+    return first && second && memcmp(first->getColor(), second->getColor(), sizeof(nodeColor)) == 0;
+}
+
+static bool sameVoxel(const VoxelTreeElement* first, const VoxelTreeElement* second) {
+    return (!first && !second) || (sameColor(first, second) && first->isLeaf() == second->isLeaf());
+}
+
+/// \return whether a bulk load of the voxels gives the same tree as creating them one at a time, at every voxel asked for
+static bool bulkLoadMatches(const QVector<VoxelDetail>& voxels, bool destructive) {
+    VoxelTree expected(true), bulk(true);
+    createOneAtATime(expected, voxels, destructive);
+    bulk.createVoxels(voxels, destructive);
+
+    if (bulk.getOctreeElementsCount() != expected.getOctreeElementsCount() || !sameColor(bulk.getRoot(),
+            expected.getRoot())) {
+        return false;
+    }
+    foreach (const VoxelDetail& voxel, voxels) {
+        if (!sameVoxel(bulk.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s),
+                expected.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void VoxelTreeBulkLoadTests::bulkLoadMatchesOneAtATime() {
+    QVector<VoxelDetail> voxels;
+    for (int i = 0; i < RANDOM_VOXEL_COUNT; i++) {
+        voxels.append(randomVoxel(RANDOM_VOXEL_RESOLUTION));
+    }
+    VoxelTree expected(true), bulk(true);
+    createOneAtATime(expected, voxels);
+    bulk.createVoxels(voxels, true);
+
+    if (bulk.getOctreeElementsCount() != expected.getOctreeElementsCount()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bulk load made " << bulk.getOctreeElementsCount()
+            << " elements, expected " << expected.getOctreeElementsCount() << std::endl;
+    }
+    foreach (const VoxelDetail& voxel, voxels) {
+        if (!sameColor(bulk.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s),
+                expected.getVoxelAt(voxel.x, voxel.y, voxel.z, voxel.s))) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bulk loaded voxel at " << voxel.x << ", " << voxel.y
+                << ", " << voxel.z << " doesn't match" << std::endl;
+            break;
+        }
+    }
+    // the averages are only worked out once in a bulk load, but should come out the same
+    if (!sameColor(bulk.getRoot(), expected.getRoot())) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bulk loaded root average doesn't match" << std::endl;
+    }
+}
+
+void VoxelTreeBulkLoadTests::bulkLoadKeepsLastDuplicate() {
+    VoxelDetail first = randomVoxel(RANDOM_VOXEL_RESOLUTION);
+    VoxelDetail second = first;
+    second.red = first.red ^ 0xFF;
+
+    QVector<VoxelDetail> voxels;
+    voxels << first << randomVoxel(RANDOM_VOXEL_RESOLUTION) << second;
+    VoxelTree tree;
+    tree.createVoxels(voxels, true);
+
+    VoxelTreeElement* voxel = tree.getVoxelAt(first.x, first.y, first.z, first.s);
+    if (!voxel || voxel->getColor()[RED_INDEX] != second.red) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the last of two voxels at the same place should win"
+            << std::endl;
+    }
+}
+
+void VoxelTreeBulkLoadTests::bulkLoadKeepsOrderOfOverlaps() {
+    const float PARENT_SIZE = 1.0f / 8.0f;
+    VoxelDetail parent = coloredVoxel(PARENT_SIZE, PARENT_SIZE, PARENT_SIZE, PARENT_SIZE, 64);
+    VoxelDetail child = coloredVoxel(PARENT_SIZE, PARENT_SIZE, PARENT_SIZE, PARENT_SIZE / 2, 192);
+
+    QVector<VoxelDetail> childFirst;
+    childFirst << child << parent;
+    QVector<VoxelDetail> parentFirst;
+    parentFirst << parent << child;
+
+    // destructively, the parent written last wipes out the child; otherwise it's refused, as the child gives it children
+    VoxelTree tree;
+    tree.createVoxels(childFirst, true);
+    VoxelTreeElement* voxel = tree.getVoxelAt(parent.x, parent.y, parent.z, parent.s);
+    if (!voxel || !voxel->isLeaf() || voxel->getColor()[RED_INDEX] != parent.red) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a parent written after its child should replace it"
+            << std::endl;
+    }
+    for (int i = 0; i < 2; i++) {
+        bool destructive = (i == 0);
+        if (!bulkLoadMatches(childFirst, destructive)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: child then parent doesn't match one at a time, "
+                << (destructive ? "destructive" : "non-destructive") << std::endl;
+        }
+        if (!bulkLoadMatches(parentFirst, destructive)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: parent then child doesn't match one at a time, "
+                << (destructive ? "destructive" : "non-destructive") << std::endl;
+        }
+    }
+
+    // a fill writes voxels of every size over each other in a small volume
+    const int OVERLAPPING_VOXEL_COUNT = 2000;
+    const int MAX_RESOLUTION_SHIFT = 5;
+    QVector<VoxelDetail> overlapping;
+    for (int i = 0; i < OVERLAPPING_VOXEL_COUNT; i++) {
+        overlapping.append(randomVoxel(1 << randIntInRange(1, MAX_RESOLUTION_SHIFT)));
+    }
+    for (int i = 0; i < 2; i++) {
+        bool destructive = (i == 0);
+        if (!bulkLoadMatches(overlapping, destructive)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: overlapping voxels of mixed sizes don't match one at "
+                "a time, " << (destructive ? "destructive" : "non-destructive") << std::endl;
+        }
+    }
+}
+
+void VoxelTreeBulkLoadTests::benchmarkSchematicSizedImport() {
+    // a rolling surface a few voxels deep through a 256^3 volume, about what a large terrain schematic holds
+    QVector<VoxelDetail> voxels;
+    float size = 1.0f / SCHEMATIC_RESOLUTION;
+    for (int x = 0; x < SCHEMATIC_RESOLUTION; x++) {
+        for (int z = 0; z < SCHEMATIC_RESOLUTION; z++) {
+            int height = SCHEMATIC_RESOLUTION / 2 + (int)((SCHEMATIC_RESOLUTION / 8) *
+                sinf(x * 0.05f) * cosf(z * 0.07f));
+            for (int y = height - SCHEMATIC_SURFACE_DEPTH; y < height; y++) {
+                VoxelDetail voxel = { x * size, y * size, z * size, size, (unsigned char)x, (unsigned char)y,
+                    (unsigned char)z };
+                voxels.append(voxel);
+            }
+        }
+    }
+
+    VoxelTree oneAtATime(true);
+    quint64 start = usecTimestampNow();
+    createOneAtATime(oneAtATime, voxels);
+    quint64 oneAtATimeUsecs = usecTimestampNow() - start;
+
+    VoxelTree bulk(true);
+    start = usecTimestampNow();
+    bulk.createVoxels(voxels, true);
+    quint64 bulkUsecs = usecTimestampNow() - start;
+
+    if (bulk.getOctreeElementsCount() != oneAtATime.getOctreeElementsCount()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bulk load made " << bulk.getOctreeElementsCount()
+            << " elements, expected " << oneAtATime.getOctreeElementsCount() << std::endl;
+    }
+    std::cout << "importing " << voxels.size() << " voxels at " << SCHEMATIC_RESOLUTION << "^3: one at a time "
+        << oneAtATimeUsecs << " usecs, bulk " << bulkUsecs << " usecs" << std::endl;
+}
+
+void VoxelTreeBulkLoadTests::runAllTests() {
+    bulkLoadMatchesOneAtATime();
+    bulkLoadKeepsLastDuplicate();
+    bulkLoadKeepsOrderOfOverlaps();
+    benchmarkSchematicSizedImport();
+}
@@ -0,0 +1,22 @@
+//
+//  VoxelTreeBulkLoadTests.h
+//  octree-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__VoxelTreeBulkLoadTests__
+#define __tests__VoxelTreeBulkLoadTests__
+
+namespace VoxelTreeBulkLoadTests {
+
+    void bulkLoadMatchesOneAtATime();
+    void bulkLoadKeepsLastDuplicate();
+    void bulkLoadKeepsOrderOfOverlaps();
+
+    void benchmarkSchematicSizedImport();
+
+    void runAllTests();
+}
+
+#endif // __tests__VoxelTreeBulkLoadTests__
@@ -0,0 +1,31 @@
+//
+//  main.cpp
+//  octree-tests
+//
+
+#include "CoverageBufferTests.h"
+#include "OctreeCacheTests.h"
+#include "JurisdictionIndexTests.h"
+#include "OctreeElementBagTests.h"
+#include "OctreeParallelEncoderTests.h"
+#include "OctreeQueryManagerTests.h"
+#include "OctreeSnapshotTests.h"
+#include "OctreeVisitorTests.h"
+#include "VoxelMeshBuilderTests.h"
+#include "VoxelSVOStreamTests.h"
+#include "VoxelTreeBulkLoadTests.h"
+
+int main(int argc, char** argv) {
+    OctreeElementBagTests::runAllTests();
+    JurisdictionIndexTests::runAllTests();
+    VoxelTreeBulkLoadTests::runAllTests();
+    VoxelSVOStreamTests::runAllTests();
+    CoverageBufferTests::runAllTests();
+    OctreeSnapshotTests::runAllTests();
+    OctreeVisitorTests::runAllTests();
+    VoxelMeshBuilderTests::runAllTests();
+    OctreeQueryManagerTests::runAllTests();
+    OctreeCacheTests::runAllTests();
+    OctreeParallelEncoderTests::runAllTests();
+    return 0;
+}
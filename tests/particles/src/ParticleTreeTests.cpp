@@ -0,0 +1,341 @@
+//
+//  ParticleTreeTests.cpp
+//  particles-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+
+#include <PacketHeaders.h>
+#include <ParticleTree.h>
+#include <SharedUtil.h>
+
+#include "ParticleTreeTests.h"
+
+const int MOVING_PARTICLE_COUNT = 1000;
+const int BENCHMARK_PARTICLE_COUNT = 50000;
+const int BENCHMARK_WALK_COUNT = 200; // full tree walks are slow enough that a sample of them will do
+const uint32_t FIRST_PARTICLE_ID = 1000;
+const float WORLD_SIZE = 1000.0f; // meters along each side that particles are spread over
+const float MAX_SPEED = 20.0f; // meters per second
+const int TICK_USECS = 10000; // how often the persist thread updates the tree on a server
+const int BENCHMARK_TICKS = 20;
+
+// a still particle that lives longer than the tests do, in meters
+static ParticleProperties makeProperties(const glm::vec3& position) {
+    ParticleProperties properties;
+    properties.setPosition(position);
+    properties.setRadius(0.5f);
+    properties.setVelocity(glm::vec3(0.0f, 0.0f, 0.0f));
+    properties.setGravity(glm::vec3(0.0f, 0.0f, 0.0f));
+    properties.setLifetime(1000.0f);
+    return properties;
+}
+
+static glm::vec3 randomPosition() {
+    return glm::vec3(randFloatInRange(1.0f, WORLD_SIZE), randFloatInRange(1.0f, WORLD_SIZE),
+        randFloatInRange(1.0f, WORLD_SIZE));
+}
+
+static void fillTree(ParticleTree& tree, int count, bool moving = false) {
+    for (int i = 0; i < count; i++) {
+        ParticleProperties properties = makeProperties(randomPosition());
+        if (moving) {
+            properties.setVelocity(glm::vec3(randFloatInRange(-MAX_SPEED, MAX_SPEED),
+                randFloatInRange(-MAX_SPEED, MAX_SPEED), randFloatInRange(-MAX_SPEED, MAX_SPEED)));
+        }
+        Particle particle(ParticleID(FIRST_PARTICLE_ID + i), properties);
+        tree.storeParticle(particle);
+    }
+}
+
+class FindByWalkArgs {
+public:
+    uint32_t id;
+    ParticleTreeElement* element;
+};
+
+// how the tree found particles before the index, kept as the reference
+static bool findByWalkOperation(OctreeElement* element, void* extraData) {
+    FindByWalkArgs* args = static_cast<FindByWalkArgs*>(extraData);
+    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
+    if (particleTreeElement->getParticleWithID(args->id)) {
+        args->element = particleTreeElement;
+        return false;
+    }
+    return args->element == NULL;
+}
+
+static ParticleTreeElement* findByWalk(ParticleTree& tree, uint32_t id) {
+    FindByWalkArgs args = { id, NULL };
+    tree.recurseTreeWithOperation(findByWalkOperation, &args);
+    return args.element;
+}
+
+void ParticleTreeTests::indexFollowsMovingParticles() {
+    ParticleTree tree;
+    fillTree(tree, MOVING_PARTICLE_COUNT);
+
+    // move every particle somewhere else, then let update re-bucket them
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        ParticleProperties properties;
+        properties.setPosition(randomPosition());
+        tree.updateParticle(ParticleID(FIRST_PARTICLE_ID + i), properties);
+    }
+    tree.update();
+
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        uint32_t id = FIRST_PARTICLE_ID + i;
+        ParticleTreeElement* element = tree.getContainingElement(id);
+        if (element != findByWalk(tree, id)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << id
+                << " is indexed under the wrong element" << std::endl;
+            return;
+        }
+        const Particle* particle = tree.findParticleByID(id);
+        if (!particle || !element->getAABox().contains(particle->getPosition())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << id
+                << " wasn't found where it moved to" << std::endl;
+            return;
+        }
+    }
+
+    // deleting every other one leaves the rest findable
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i += 2) {
+        tree.deleteParticle(ParticleID(FIRST_PARTICLE_ID + i));
+    }
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        bool shouldBeFound = (i % 2 == 1);
+        if ((tree.findParticleByID(FIRST_PARTICLE_ID + i) != NULL) != shouldBeFound) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << FIRST_PARTICLE_ID + i
+                << (shouldBeFound ? " went missing" : " survived its delete") << std::endl;
+            return;
+        }
+    }
+
+    // and clearing the tree empties the index
+    tree.eraseAllOctreeElements();
+    if (tree.getContainingElement(FIRST_PARTICLE_ID + 1)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: erased particles are still indexed" << std::endl;
+    }
+}
+
+void ParticleTreeTests::indexFollowsCreatorTokens() {
+    const uint32_t CREATOR_TOKEN = 7;
+    const uint32_t ASSIGNED_ID = 42;
+
+    ParticleTree tree;
+    tree.setIsViewing(true);
+    glm::vec3 position(100.0f, 100.0f, 100.0f);
+    tree.addParticle(ParticleID(UNKNOWN_PARTICLE_ID, CREATOR_TOKEN, false), makeProperties(position));
+
+    // the server's copy arrives before its answer to our add
+    Particle viewedParticle(ParticleID(ASSIGNED_ID), makeProperties(position + glm::vec3(50.0f, 0.0f, 0.0f)));
+    tree.storeParticle(viewedParticle);
+
+    // edits by token reach ours
+    ParticleProperties properties;
+    properties.setRadius(2.0f);
+    tree.updateParticle(ParticleID(UNKNOWN_PARTICLE_ID, CREATOR_TOKEN, false), properties);
+
+    QByteArray packet;
+    populatePacketHeader(packet, PacketTypeParticleAddResponse, QUuid::createUuid());
+    packet.append(reinterpret_cast<const char*>(&CREATOR_TOKEN), sizeof(CREATOR_TOKEN));
+    packet.append(reinterpret_cast<const char*>(&ASSIGNED_ID), sizeof(ASSIGNED_ID));
+    tree.handleAddParticleResponse(packet);
+
+    // ours takes the ID and the viewed copy goes
+    const Particle* particle = tree.findParticleByID(ASSIGNED_ID);
+    if (!particle || particle->getCreatorTokenID() != CREATOR_TOKEN || particle->getRadius() != 2.0f / TREE_SCALE) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: our particle didn't take its ID" << std::endl;
+        return;
+    }
+    if (findByWalk(tree, ASSIGNED_ID) != tree.getContainingElement(ASSIGNED_ID)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the ID is indexed under the wrong element" << std::endl;
+        return;
+    }
+    tree.deleteParticle(ParticleID(ASSIGNED_ID));
+    if (tree.findParticleByID(ASSIGNED_ID) || findByWalk(tree, ASSIGNED_ID)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a copy of the particle was left behind" << std::endl;
+    }
+}
+
+void ParticleTreeTests::updateRebucketsAndPrunes() {
+    ParticleTree tree;
+    fillTree(tree, MOVING_PARTICLE_COUNT, true);
+    QVector<glm::vec3> startPositions;
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        startPositions.append(tree.findParticleByID(FIRST_PARTICLE_ID + i)->getPosition());
+    }
+
+    usleep(TICK_USECS);
+    tree.update();
+
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        uint32_t id = FIRST_PARTICLE_ID + i;
+        const Particle* particle = tree.findParticleByID(id);
+        if (!particle || particle->getPosition() == startPositions.at(i)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << id << " wasn't stepped" << std::endl;
+            return;
+        }
+        if (!tree.getContainingElement(id)->getAABox().contains(particle->getPosition())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << id
+                << " wasn't re-bucketed when it left its element" << std::endl;
+            return;
+        }
+    }
+
+    // when they all die, the elements they leave go with them, without waiting for a full prune
+    for (int i = 0; i < MOVING_PARTICLE_COUNT; i++) {
+        ParticleProperties properties;
+        properties.setShouldDie(true);
+        tree.updateParticle(ParticleID(FIRST_PARTICLE_ID + i), properties);
+    }
+    tree.update();
+
+    if (tree.findParticleByID(FIRST_PARTICLE_ID) || !tree.hasAnyDeletedParticles()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: dying particles weren't deleted" << std::endl;
+        return;
+    }
+    if (!tree.getRoot()->isLeaf()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: emptied elements weren't pruned" << std::endl;
+    }
+}
+
+void ParticleTreeTests::benchmarkEdits() {
+    ParticleTree tree;
+    quint64 start = usecTimestampNow();
+    fillTree(tree, BENCHMARK_PARTICLE_COUNT);
+    quint64 storeUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    int walkFound = 0;
+    for (int i = 0; i < BENCHMARK_WALK_COUNT; i++) {
+        walkFound += findByWalk(tree, FIRST_PARTICLE_ID + randIntInRange(0, BENCHMARK_PARTICLE_COUNT - 1)) ? 1 : 0;
+    }
+    quint64 walkUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    int indexFound = 0;
+    for (int i = 0; i < BENCHMARK_PARTICLE_COUNT; i++) {
+        indexFound += tree.findParticleByID(FIRST_PARTICLE_ID + i) ? 1 : 0;
+    }
+    quint64 findUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    ParticleProperties properties;
+    properties.setRadius(0.25f);
+    for (int i = 0; i < BENCHMARK_PARTICLE_COUNT; i++) {
+        tree.updateParticle(ParticleID(FIRST_PARTICLE_ID + i), properties);
+    }
+    quint64 updateUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_PARTICLE_COUNT; i++) {
+        tree.deleteParticle(ParticleID(FIRST_PARTICLE_ID + i));
+    }
+    quint64 deleteUsecs = usecTimestampNow() - start;
+
+    std::cout << BENCHMARK_PARTICLE_COUNT << " particles, stores: " << storeUsecs << " usecs" << std::endl;
+    std::cout << "lookups by walk:  " << (float)walkUsecs / BENCHMARK_WALK_COUNT << " usecs each" << std::endl;
+    std::cout << "lookups by index: " << (float)findUsecs / BENCHMARK_PARTICLE_COUNT << " usecs each" << std::endl;
+    std::cout << "updates:          " << (float)updateUsecs / BENCHMARK_PARTICLE_COUNT << " usecs each" << std::endl;
+    std::cout << "deletes:          " << (float)deleteUsecs / BENCHMARK_PARTICLE_COUNT << " usecs each" << std::endl;
+
+    if (walkFound != BENCHMARK_WALK_COUNT || indexFound != BENCHMARK_PARTICLE_COUNT) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the walk found " << walkFound << " of "
+            << BENCHMARK_WALK_COUNT << " and the index " << indexFound << " of " << BENCHMARK_PARTICLE_COUNT
+            << " particles" << std::endl;
+    }
+    if (tree.getRoot()->hasParticles() || tree.findParticleByID(FIRST_PARTICLE_ID)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particles survived their deletes" << std::endl;
+    }
+}
+
+// the update and prune ParticleTree::update made of every element before it had a simulation, kept as the reference
+static bool referenceUpdateOperation(OctreeElement* element, void* extraData) {
+    static_cast<ParticleTreeElement*>(element)->update(*static_cast<ParticleTreeUpdateArgs*>(extraData));
+    return true;
+}
+
+static bool referencePruneOperation(OctreeElement* element, void* extraData) {
+    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        ParticleTreeElement* child = particleTreeElement->getChildAtIndex(i);
+        if (child && child->isLeaf() && !child->hasParticles()) {
+            particleTreeElement->deleteChildAtIndex(i);
+        }
+    }
+    return true;
+}
+
+static void referenceUpdate(ParticleTree& tree) {
+    tree.lockForWrite();
+    ParticleTreeUpdateArgs args;
+    tree.recurseTreeWithOperation(referenceUpdateOperation, &args);
+    for (int i = 0; i < args._movingParticles.size(); i++) {
+        if (!args._movingParticles[i].getShouldDie() && tree.getRoot()->getAABox().contains(
+                args._movingParticles[i].getPosition())) {
+            tree.storeParticle(args._movingParticles[i]);
+        }
+    }
+    tree.recurseTreeWithOperation(referencePruneOperation);
+    tree.unlock();
+}
+
+void ParticleTreeTests::benchmarkUpdate() {
+    const int PARTICLE_COUNTS[] = { 10000, 50000, 100000 };
+    for (size_t c = 0; c < sizeof(PARTICLE_COUNTS) / sizeof(PARTICLE_COUNTS[0]); c++) {
+        int count = PARTICLE_COUNTS[c];
+
+        ParticleTree referenceTree;
+        fillTree(referenceTree, count, true);
+        quint64 referenceUsecs = 0;
+        for (int i = 0; i < BENCHMARK_TICKS; i++) {
+            usleep(TICK_USECS);
+            quint64 start = usecTimestampNow();
+            referenceUpdate(referenceTree);
+            referenceUsecs += usecTimestampNow() - start;
+        }
+
+        ParticleTree tree;
+        fillTree(tree, count, true);
+        quint64 updateUsecs = 0;
+        quint64 lockedUsecs = 0;
+        for (int i = 0; i < BENCHMARK_TICKS; i++) {
+            usleep(TICK_USECS);
+            tree.update();
+            updateUsecs += tree.getLastUpdateUsecs();
+            lockedUsecs += tree.getLastUpdateLockedUsecs();
+        }
+
+        std::cout << count << " particles, tick before simulation: " << referenceUsecs / BENCHMARK_TICKS
+            << " usecs, all locked" << std::endl;
+        std::cout << count << " particles, tick: " << updateUsecs / BENCHMARK_TICKS << " usecs, "
+            << lockedUsecs / BENCHMARK_TICKS << " locked" << std::endl;
+
+        for (int i = 0; i < count; i += count / 100) {
+            uint32_t id = FIRST_PARTICLE_ID + i;
+            const Particle* particle = tree.findParticleByID(id);
+            if (particle && !tree.getContainingElement(id)->getAABox().contains(particle->getPosition())) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: particle " << id << " is in the wrong element"
+                    << std::endl;
+                break;
+            }
+        }
+    }
+}
+
+void ParticleTreeTests::runAllTests() {
+    indexFollowsMovingParticles();
+    indexFollowsCreatorTokens();
+    updateRebucketsAndPrunes();
+
+    benchmarkEdits();
+    benchmarkUpdate();
+}
@@ -0,0 +1,23 @@
+//
+//  ParticleTreeTests.h
+//  particles-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__ParticleTreeTests__
+#define __tests__ParticleTreeTests__
+
+namespace ParticleTreeTests {
+
+    void indexFollowsMovingParticles();
+    void indexFollowsCreatorTokens();
+    void updateRebucketsAndPrunes();
+
+    void benchmarkEdits();
+    void benchmarkUpdate();
+
+    void runAllTests();
+}
+
+#endif // __tests__ParticleTreeTests__
@@ -0,0 +1,11 @@
+//
+//  main.cpp
+//  particles-tests
+//
+
+#include "ParticleTreeTests.h"
+
+int main(int argc, char** argv) {
+    ParticleTreeTests::runAllTests();
+    return 0;
+}
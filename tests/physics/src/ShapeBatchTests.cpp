@@ -0,0 +1,274 @@
+//
+//  ShapeBatchTests.cpp
+//  physics-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QPair>
+#include <QVector>
+
+#include <glm/glm.hpp>
+
+#include <CapsuleShape.h>
+#include <CollisionInfo.h>
+#include <ShapeBatch.h>
+#include <ShapeCollider.h>
+#include <SharedUtil.h>
+#include <SphereShape.h>
+
+#include "PhysicsTestUtil.h"
+#include "ShapeBatchTests.h"
+
+const int SHAPES_A = 20;
+const int SHAPES_B = 150; // more than a couple of the colliders' blocks
+const float WORLD_SIZE = 10.f;
+const float MAX_RADIUS = 1.5f;
+const float MAX_HALF_HEIGHT = 2.f;
+const float TOLERANCE = 0.0001f;
+const int BENCHMARK_SHAPES = 1000;
+const int BENCHMARK_PASSES = 10;
+
+static glm::vec3 randomPoint() {
+    return glm::vec3(randFloatInRange(0.f, WORLD_SIZE), randFloatInRange(0.f, WORLD_SIZE),
+        randFloatInRange(0.f, WORLD_SIZE));
+}
+
+static glm::vec3 randomAxis() {
+    glm::vec3 axis;
+    do {
+        axis = glm::vec3(randFloatInRange(-1.f, 1.f), randFloatInRange(-1.f, 1.f), randFloatInRange(-1.f, 1.f));
+    } while (glm::length(axis) < 0.1f);
+    return glm::normalize(axis);
+}
+
+static void makeSpheres(QVector<SphereShape>& spheres, SphereBatch& batch, int count) {
+    for (int i = 0; i < count; i++) {
+        spheres.append(SphereShape(randFloatInRange(0.1f, MAX_RADIUS), randomPoint()));
+        batch.addShape(&spheres.last());
+    }
+}
+
+static CapsuleShape makeCapsule(const glm::vec3& center, const glm::vec3& axis, float halfHeight, float radius) {
+    CapsuleShape capsule(radius, center - halfHeight * axis, center + halfHeight * axis);
+    capsule.setPosition(center);
+    return capsule;
+}
+
+static void makeCapsules(QVector<CapsuleShape>& capsules, CapsuleBatch& batch, int count) {
+    for (int i = 0; i < count; i++) {
+        capsules.append(makeCapsule(randomPoint(), randomAxis(), randFloatInRange(0.1f, MAX_HALF_HEIGHT),
+            randFloatInRange(0.1f, MAX_RADIUS)));
+        batch.addShape(&capsules.last());
+    }
+}
+
+static bool isClose(const glm::vec3& a, const glm::vec3& b) {
+    return glm::length(a - b) < TOLERANCE * glm::max(1.f, glm::length(b));
+}
+
+// checks the batch's contacts against the scalar collisions of each pair in turn
+static void compareContacts(const ContactBuffer& contacts, CollisionList& collisions,
+                            const QVector<QPair<int, int> >& pairs, const char* file, int line) {
+    if (contacts.size() != collisions.size()) {
+        std::cout << file << ":" << line << " ERROR: the batch found " << contacts.size()
+            << " contacts and the scalar collider " << collisions.size() << std::endl;
+        return;
+    }
+    for (int i = 0; i < contacts.size(); i++) {
+        const ShapeContact& contact = contacts.getContact(i);
+        const CollisionInfo* collision = collisions.getCollision(i);
+        if (contact.indexA != pairs.at(i).first || contact.indexB != pairs.at(i).second) {
+            std::cout << file << ":" << line << " ERROR: contact " << i << " is between " << contact.indexA
+                << " and " << contact.indexB << " rather than " << pairs.at(i).first << " and "
+                << pairs.at(i).second << std::endl;
+            return;
+        }
+        if (!isClose(contact.penetration, collision->_penetration) ||
+                !isClose(contact.contactPoint, collision->_contactPoint)) {
+            std::cout << file << ":" << line << " ERROR: contact " << i << " has penetration "
+                << contact.penetration << " and contact point " << contact.contactPoint << " rather than "
+                << *collision << std::endl;
+            return;
+        }
+    }
+}
+
+void ShapeBatchTests::sphereSpheresMatchScalar() {
+    QVector<SphereShape> spheresA, spheresB;
+    SphereBatch batchA, batchB;
+    makeSpheres(spheresA, batchA, SHAPES_A);
+    makeSpheres(spheresB, batchB, SHAPES_B);
+
+    // two on top of each other, for the arbitrary direction
+    spheresB[SHAPES_B - 1].setPosition(spheresA[0].getPosition());
+    batchB.clear();
+    for (int i = 0; i < SHAPES_B; i++) {
+        batchB.addShape(&spheresB[i]);
+    }
+
+    CollisionList collisions(SHAPES_A * SHAPES_B);
+    QVector<QPair<int, int> > pairs;
+    for (int a = 0; a < SHAPES_A; a++) {
+        for (int b = 0; b < SHAPES_B; b++) {
+            if (ShapeCollider::sphereSphere(&spheresA[a], &spheresB[b], collisions)) {
+                pairs.append(QPair<int, int>(a, b));
+            }
+        }
+    }
+    ContactBuffer contacts(SHAPES_A * SHAPES_B);
+    int found = ShapeCollider::sphereSphereBatch(batchA, batchB, contacts);
+
+    if (found != contacts.size() || found == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the batch reported " << found << " contacts" << std::endl;
+    }
+    compareContacts(contacts, collisions, pairs, __FILE__, __LINE__);
+}
+
+void ShapeBatchTests::sphereCapsulesMatchScalar() {
+    QVector<SphereShape> spheres;
+    QVector<CapsuleShape> capsules;
+    SphereBatch sphereBatch;
+    CapsuleBatch capsuleBatch;
+    makeSpheres(spheres, sphereBatch, SHAPES_A);
+    makeCapsules(capsules, capsuleBatch, SHAPES_B);
+
+    CollisionList collisions(SHAPES_A * SHAPES_B);
+    QVector<QPair<int, int> > pairs;
+    for (int a = 0; a < SHAPES_A; a++) {
+        for (int b = 0; b < SHAPES_B; b++) {
+            if (ShapeCollider::sphereCapsule(&spheres[a], &capsules[b], collisions)) {
+                pairs.append(QPair<int, int>(a, b));
+            }
+        }
+    }
+    ContactBuffer contacts(SHAPES_A * SHAPES_B);
+    ShapeCollider::sphereCapsuleBatch(sphereBatch, capsuleBatch, contacts);
+
+    if (contacts.size() == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: no spheres touched capsules" << std::endl;
+    }
+    compareContacts(contacts, collisions, pairs, __FILE__, __LINE__);
+}
+
+void ShapeBatchTests::spheresOnCapsuleAxesMatchScalar() {
+    // spheres centered on the axis of a capsule: inside it, touching either cap from beyond, and too far away
+    float radius = 1.f;
+    float halfHeight = 2.f;
+    glm::vec3 center(1.f, 2.f, 3.f);
+    glm::vec3 axis = glm::normalize(glm::vec3(1.f, 1.f, 0.f));
+    QVector<CapsuleShape> capsules;
+    capsules.append(makeCapsule(center, axis, halfHeight, radius));
+    CapsuleBatch capsuleBatch;
+    capsuleBatch.addShape(&capsules[0]);
+
+    const float OFFSETS[] = { 0.f, 1.5f, -1.5f, 2.5f, -2.5f, 5.f };
+    const int OFFSET_COUNT = sizeof(OFFSETS) / sizeof(OFFSETS[0]);
+    QVector<SphereShape> spheres;
+    SphereBatch sphereBatch;
+    for (int i = 0; i < OFFSET_COUNT; i++) {
+        spheres.append(SphereShape(0.5f, center + OFFSETS[i] * axis));
+        sphereBatch.addShape(&spheres.last());
+    }
+
+    CollisionList collisions(OFFSET_COUNT);
+    QVector<QPair<int, int> > pairs;
+    for (int a = 0; a < OFFSET_COUNT; a++) {
+        if (ShapeCollider::sphereCapsule(&spheres[a], &capsules[0], collisions)) {
+            pairs.append(QPair<int, int>(a, 0));
+        }
+    }
+    ContactBuffer contacts(OFFSET_COUNT);
+    ShapeCollider::sphereCapsuleBatch(sphereBatch, capsuleBatch, contacts);
+    compareContacts(contacts, collisions, pairs, __FILE__, __LINE__);
+}
+
+void ShapeBatchTests::fullBufferStopsBatch() {
+    const int CAPACITY = 5;
+    SphereBatch spheres;
+    for (int i = 0; i < 10; i++) {
+        spheres.addSphere(glm::vec3(0.f, 0.1f * i, 0.f), 1.f);
+    }
+    ContactBuffer contacts(CAPACITY);
+    int found = ShapeCollider::sphereSphereBatch(spheres, spheres, contacts);
+    if (found != CAPACITY || !contacts.isFull()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full buffer of " << CAPACITY
+            << " contacts but found " << found << std::endl;
+    }
+    if (ShapeCollider::sphereSphereBatch(spheres, spheres, contacts) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a full buffer took more contacts" << std::endl;
+    }
+}
+
+void ShapeBatchTests::benchmarkThroughput() {
+    QVector<SphereShape> spheresA, spheresB;
+    QVector<CapsuleShape> capsules;
+    SphereBatch batchA, batchB;
+    CapsuleBatch capsuleBatch;
+    makeSpheres(spheresA, batchA, BENCHMARK_SHAPES);
+    makeSpheres(spheresB, batchB, BENCHMARK_SHAPES);
+    makeCapsules(capsules, capsuleBatch, BENCHMARK_SHAPES);
+
+    const int MAX_CONTACTS = BENCHMARK_SHAPES * BENCHMARK_SHAPES;
+    CollisionList collisions(MAX_CONTACTS);
+    ContactBuffer contacts(MAX_CONTACTS);
+    float pairs = (float)BENCHMARK_PASSES * BENCHMARK_SHAPES * BENCHMARK_SHAPES;
+
+    // the nested loops of shapeShape that Model::findCollisions makes
+    quint64 start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        collisions.clear();
+        for (int a = 0; a < BENCHMARK_SHAPES; a++) {
+            for (int b = 0; b < BENCHMARK_SHAPES; b++) {
+                ShapeCollider::shapeShape(&spheresA[a], &spheresB[b], collisions);
+            }
+        }
+    }
+    quint64 scalarSphereUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        contacts.clear();
+        ShapeCollider::sphereSphereBatch(batchA, batchB, contacts);
+    }
+    quint64 batchSphereUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        collisions.clear();
+        for (int a = 0; a < BENCHMARK_SHAPES; a++) {
+            for (int b = 0; b < BENCHMARK_SHAPES; b++) {
+                ShapeCollider::shapeShape(&spheresA[a], &capsules[b], collisions);
+            }
+        }
+    }
+    quint64 scalarCapsuleUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        contacts.clear();
+        ShapeCollider::sphereCapsuleBatch(batchA, capsuleBatch, contacts);
+    }
+    quint64 batchCapsuleUsecs = usecTimestampNow() - start;
+
+    std::cout << "sphere/sphere pairs per usec, scalar: " << pairs / glm::max(scalarSphereUsecs, (quint64)1)
+        << " batched: " << pairs / glm::max(batchSphereUsecs, (quint64)1) << std::endl;
+    std::cout << "sphere/capsule pairs per usec, scalar: " << pairs / glm::max(scalarCapsuleUsecs, (quint64)1)
+        << " batched: " << pairs / glm::max(batchCapsuleUsecs, (quint64)1) << std::endl;
+
+    if (contacts.size() != collisions.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the batch found " << contacts.size()
+            << " sphere/capsule contacts and the scalar collider " << collisions.size() << std::endl;
+    }
+}
+
+void ShapeBatchTests::runAllTests() {
+    sphereSpheresMatchScalar();
+    sphereCapsulesMatchScalar();
+    spheresOnCapsuleAxesMatchScalar();
+    fullBufferStopsBatch();
+
+    benchmarkThroughput();
+}
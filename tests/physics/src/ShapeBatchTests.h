@@ -0,0 +1,23 @@
+//
+//  ShapeBatchTests.h
+//  physics-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__ShapeBatchTests__
+#define __tests__ShapeBatchTests__
+
+namespace ShapeBatchTests {
+
+    void sphereSpheresMatchScalar();
+    void sphereCapsulesMatchScalar();
+    void spheresOnCapsuleAxesMatchScalar();
+    void fullBufferStopsBatch();
+
+    void benchmarkThroughput();
+
+    void runAllTests();
+}
+
+#endif // __tests__ShapeBatchTests__
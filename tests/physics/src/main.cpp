@@ -3,9 +3,11 @@
 //  physics-tests
 //
 
+#include "ShapeBatchTests.h"
 #include "ShapeColliderTests.h"
 
 int main(int argc, char** argv) {
     ShapeColliderTests::runAllTests();
+    ShapeBatchTests::runAllTests();
     return 0;
 }
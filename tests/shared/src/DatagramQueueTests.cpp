@@ -0,0 +1,288 @@
+//
+//  DatagramQueueTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cstring>
+#include <iostream>
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+
+#include <DatagramQueue.h>
+#include <SPSCQueue.h>
+#include <SharedUtil.h>
+
+#include "DatagramQueueTests.h"
+
+static QByteArray makeDatagram(int sequence) {
+    QByteArray datagram(sizeof(int), 0);
+    memcpy(datagram.data(), &sequence, sizeof(int));
+    return datagram;
+}
+
+static int getSequence(const QByteArray& datagram) {
+    int sequence;
+    memcpy(&sequence, datagram.constData(), sizeof(int));
+    return sequence;
+}
+
+void DatagramQueueTests::slotsWrapAround() {
+    const int CAPACITY = 4;
+    const int LAPS = 10;
+    SPSCQueue<int> queue(CAPACITY);
+    int pushed = 0;
+    int popped = 0;
+    for (int lap = 0; lap < LAPS; lap++) {
+        // fill the ring from wherever the last lap left it, then check it refuses another
+        while (int* slot = queue.getBack()) {
+            *slot = pushed++;
+            queue.push();
+        }
+        if (queue.size() != CAPACITY) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full queue of " << CAPACITY << ", got "
+                << queue.size() << std::endl;
+            return;
+        }
+        // drain part of it, so that the next lap starts mid ring
+        for (int i = 0; i < CAPACITY - 1 - lap % 2; i++) {
+            int* slot = queue.getFront();
+            if (!slot || *slot != popped) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << popped << " at the front" << std::endl;
+                return;
+            }
+            popped++;
+            queue.pop();
+        }
+    }
+    while (int* slot = queue.getFront()) {
+        if (*slot != popped++) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: popped out of order" << std::endl;
+            return;
+        }
+        queue.pop();
+    }
+    if (popped != pushed || queue.size() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << pushed << " popped, got " << popped << std::endl;
+    }
+}
+
+void DatagramQueueTests::dropsWhenFull() {
+    const int CAPACITY = 2;
+    DatagramQueue queue(CAPACITY);
+    for (int i = 0; i <= CAPACITY; i++) {
+        QByteArray datagram = makeDatagram(i);
+        bool pushed = queue.push(datagram, QWeakPointer<Node>());
+        if (pushed != (i < CAPACITY)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: push " << i << " returned " << pushed << std::endl;
+        }
+        // a pushed datagram leaves the slot's spare buffer in its place
+        if (pushed && datagram.capacity() < MAX_PACKET_SIZE) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a spare buffer back from push" << std::endl;
+        }
+    }
+    if (queue.getDroppedCount() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected 1 dropped, got " << queue.getDroppedCount()
+            << std::endl;
+    }
+    for (int i = 0; i < CAPACITY; i++) {
+        QueuedDatagram* queued = queue.getFront();
+        if (!queued || getSequence(queued->datagram) != i) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected datagram " << i << " at the front" << std::endl;
+            return;
+        }
+        queue.pop();
+    }
+}
+
+void DatagramQueueTests::spillsInOrderWhenFull() {
+    const int CAPACITY = 2;
+    const int DATAGRAMS = 5;
+    DatagramQueue queue(CAPACITY);
+    int pushed = 0;
+    for (; pushed < DATAGRAMS; pushed++) {
+        QByteArray datagram = makeDatagram(pushed);
+        queue.pushOrSpill(datagram, QWeakPointer<Node>());
+    }
+    if (queue.getDroppedCount() != 0 || queue.size() != CAPACITY) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full ring and nothing dropped" << std::endl;
+    }
+
+    // a slot frees up, but the next one must still go behind the ones that spilled
+    int received = 0;
+    queue.getFront();
+    queue.pop();
+    received++;
+    QByteArray datagram = makeDatagram(pushed++);
+    queue.pushOrSpill(datagram, QWeakPointer<Node>());
+
+    QList<QueuedDatagram> spilled;
+    while (true) {
+        for (QueuedDatagram* queued = queue.getFront(); queued; queued = queue.getFront()) {
+            if (getSequence(queued->datagram) != received++) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << getSequence(queued->datagram)
+                    << " out of order in the ring" << std::endl;
+            }
+            queue.pop();
+        }
+        if (!queue.takeSpilled(spilled)) {
+            break;
+        }
+        foreach (const QueuedDatagram& queued, spilled) {
+            if (getSequence(queued.datagram) != received++) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << getSequence(queued.datagram)
+                    << " out of order in the spill" << std::endl;
+            }
+        }
+    }
+    if (received != pushed) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << pushed << " received, got " << received
+            << std::endl;
+    }
+
+    // once drained, the ring takes them again
+    datagram = makeDatagram(pushed);
+    queue.pushOrSpill(datagram, QWeakPointer<Node>());
+    if (queue.size() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a push after the drain to go to the ring"
+            << std::endl;
+    }
+}
+
+void DatagramQueueTests::wakesConsumerOncePerDrain() {
+    DatagramQueue queue(4);
+    if (!queue.shouldWakeConsumer() || queue.shouldWakeConsumer()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected only the first push to wake the consumer" << std::endl;
+    }
+    queue.consumerWoke();
+    if (!queue.shouldWakeConsumer()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a push after the drain to wake the consumer again"
+            << std::endl;
+    }
+}
+
+// plays the network thread, waking the consumer the way the interface does
+class DatagramProducer : public QThread {
+public:
+    DatagramProducer(DatagramQueue* queue, QSemaphore* wakes, int datagrams, bool spill) :
+        _queue(queue), _wakes(wakes), _datagrams(datagrams), _spill(spill) { }
+
+protected:
+    virtual void run() {
+        QByteArray datagram;
+        for (int i = 0; i < _datagrams; i++) {
+            datagram = makeDatagram(i);
+            if (_spill) {
+                _queue->pushOrSpill(datagram, QWeakPointer<Node>());
+                if (_queue->shouldWakeConsumer()) {
+                    _wakes->release();
+                }
+            } else if (_queue->push(datagram, QWeakPointer<Node>()) && _queue->shouldWakeConsumer()) {
+                _wakes->release();
+            }
+        }
+    }
+
+private:
+    DatagramQueue* _queue;
+    QSemaphore* _wakes;
+    int _datagrams;
+    bool _spill;
+};
+
+void DatagramQueueTests::consumerNeverMissesAWake() {
+    const int CAPACITY = 64;
+    const int DATAGRAMS = 100000;
+    const int LOST_WAKE_MSECS = 1000;
+    DatagramQueue queue(CAPACITY);
+    QSemaphore wakes;
+    DatagramProducer producer(&queue, &wakes, DATAGRAMS, false);
+    producer.start();
+
+    // the consumer only looks at the queue when woken; a missed wake would leave datagrams stranded
+    int received = 0;
+    int last = -1;
+    while (received + queue.getDroppedCount() < DATAGRAMS) {
+        if (!wakes.tryAcquire(1, LOST_WAKE_MSECS)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: consumer missed a wake with " << queue.size()
+                << " datagrams waiting" << std::endl;
+            break;
+        }
+        queue.consumerWoke();
+        for (QueuedDatagram* queued = queue.getFront(); queued; queued = queue.getFront()) {
+            int sequence = getSequence(queued->datagram);
+            if (sequence <= last) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << sequence << " after " << last
+                    << std::endl;
+            }
+            last = sequence;
+            received++;
+            queue.pop();
+        }
+    }
+    producer.wait();
+
+    if (received + queue.getDroppedCount() != DATAGRAMS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << DATAGRAMS << " received or dropped, got "
+            << received << " and " << queue.getDroppedCount() << std::endl;
+    }
+}
+
+void DatagramQueueTests::spillingConsumerGetsEveryDatagramInOrder() {
+    const int CAPACITY = 4;
+    const int DATAGRAMS = 100000;
+    const int LOST_WAKE_MSECS = 1000;
+    DatagramQueue queue(CAPACITY);
+    QSemaphore wakes;
+    DatagramProducer producer(&queue, &wakes, DATAGRAMS, true);
+    producer.start();
+
+    // a ring this small fills constantly, so most of these go through the spill
+    int received = 0;
+    QList<QueuedDatagram> spilled;
+    while (received < DATAGRAMS) {
+        if (!wakes.tryAcquire(1, LOST_WAKE_MSECS)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: spilling consumer missed a wake after " << received
+                << " datagrams" << std::endl;
+            break;
+        }
+        queue.consumerWoke();
+        while (true) {
+            for (QueuedDatagram* queued = queue.getFront(); queued; queued = queue.getFront()) {
+                if (getSequence(queued->datagram) != received++) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << getSequence(queued->datagram)
+                        << " out of order from the ring" << std::endl;
+                    received = getSequence(queued->datagram) + 1;
+                }
+                queue.pop();
+            }
+            if (!queue.takeSpilled(spilled)) {
+                break;
+            }
+            foreach (const QueuedDatagram& queued, spilled) {
+                if (getSequence(queued.datagram) != received++) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << getSequence(queued.datagram)
+                        << " out of order from the spill" << std::endl;
+                    received = getSequence(queued.datagram) + 1;
+                }
+            }
+        }
+    }
+    producer.wait();
+
+    if (received != DATAGRAMS || queue.getDroppedCount() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected all " << DATAGRAMS << " datagrams, got "
+            << received << " with " << queue.getDroppedCount() << " dropped" << std::endl;
+    }
+}
+
+void DatagramQueueTests::runAllTests() {
+    slotsWrapAround();
+    dropsWhenFull();
+    spillsInOrderWhenFull();
+    wakesConsumerOncePerDrain();
+    consumerNeverMissesAWake();
+    spillingConsumerGetsEveryDatagramInOrder();
+}
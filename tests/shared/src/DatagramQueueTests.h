@@ -0,0 +1,23 @@
+//
+//  DatagramQueueTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__DatagramQueueTests__
+#define __tests__DatagramQueueTests__
+
+namespace DatagramQueueTests {
+
+    void slotsWrapAround();
+    void dropsWhenFull();
+    void spillsInOrderWhenFull();
+    void wakesConsumerOncePerDrain();
+    void consumerNeverMissesAWake();
+    void spillingConsumerGetsEveryDatagramInOrder();
+
+    void runAllTests();
+}
+
+#endif // __tests__DatagramQueueTests__
@@ -0,0 +1,220 @@
+//
+//  DomainMembershipLogTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QHash>
+
+#include <DomainListPacker.h>
+#include <DomainMembershipLog.h>
+#include <Node.h>
+#include <NodeList.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+
+#include "DomainMembershipLogTests.h"
+
+/// Packs the domain list with the secrets the nodes already have, where the domain-server would make them up.
+class TestListPacker : public DomainListPacker {
+protected:
+    virtual QUuid getConnectionSecret(const SharedNodePointer& node, const SharedNodePointer& otherNode) {
+        return otherNode->getConnectionSecret();
+    }
+};
+
+static SharedNodePointer newNode(NodeType_t type, int port) {
+    HifiSockAddr socket(QHostAddress::LocalHost, port);
+    return SharedNodePointer(new Node(QUuid::createUuid(), type, socket, socket));
+}
+
+void DomainMembershipLogTests::changesSinceVersion() {
+    DomainMembershipLog log;
+    QUuid first = QUuid::createUuid();
+    QUuid second = QUuid::createUuid();
+    
+    log.nodeAdded(first);
+    quint32 seenVersion = log.getVersion();
+    
+    log.nodeAdded(second);
+    log.nodeRemoved(first);
+    log.nodeAdded(second); // a socket change, which should collapse with the add
+    
+    QList<DomainMembershipLog::Change> changes;
+    if (!log.changesSince(log.getEpoch(), seenVersion, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected changes since version " << seenVersion << std::endl;
+        return;
+    }
+    if (changes.size() != 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected 2 changes, got " << changes.size() << std::endl;
+        return;
+    }
+    if (changes.at(0).nodeUUID != first || changes.at(0).type != DomainMembershipLog::NodeRemoved
+            || changes.at(1).nodeUUID != second || changes.at(1).type != DomainMembershipLog::NodeAdded) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the latest change for each node, in order" << std::endl;
+    }
+    
+    changes.clear();
+    if (!log.changesSince(log.getEpoch(), log.getVersion(), changes) || !changes.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected no changes since the current version" << std::endl;
+    }
+}
+
+void DomainMembershipLogTests::fullListOnGapOrEpochMismatch() {
+    const int MAX_CHANGES = 4;
+    DomainMembershipLog log(MAX_CHANGES);
+    log.nodeAdded(QUuid::createUuid());
+    quint32 seenVersion = log.getVersion();
+    
+    QList<DomainMembershipLog::Change> changes;
+    if (log.changesSince(log.getEpoch(), NO_DOMAIN_LIST_VERSION, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full list for a node with no version" << std::endl;
+    }
+    if (log.changesSince(log.getEpoch() + 1, seenVersion, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full list for a version from another epoch"
+            << std::endl;
+    }
+    
+    for (int i = 0; i < MAX_CHANGES; i++) {
+        log.nodeAdded(QUuid::createUuid());
+    }
+    if (!log.changesSince(log.getEpoch(), seenVersion, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the log to still reach back to version "
+            << seenVersion << std::endl;
+    }
+    log.nodeAdded(QUuid::createUuid());
+    if (log.changesSince(log.getEpoch(), seenVersion, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a full list once version " << seenVersion
+            << " dropped off the log" << std::endl;
+    }
+}
+
+void DomainMembershipLogTests::silentNodeAsksForFullList() {
+    NodeList* nodeList = NodeList::createInstance(NodeType::Agent);
+    
+    DomainMembershipLog log;
+    NodeHash nodes;
+    SharedNodePointer self = newNode(NodeType::Agent, 40000);
+    SharedNodePointer mixer = newNode(NodeType::AudioMixer, 40001);
+    nodes.insert(self->getUUID(), self);
+    nodes.insert(mixer->getUUID(), mixer);
+    log.nodeAdded(self->getUUID());
+    log.nodeAdded(mixer->getUUID());
+    
+    NodeSet nodeInterestList;
+    nodeInterestList << NodeType::AudioMixer;
+    TestListPacker packer;
+    foreach (const QByteArray& packet, packer.pack(log, self, nodes, nodeInterestList, 0, NO_DOMAIN_LIST_VERSION)) {
+        nodeList->processDomainServerList(packet);
+    }
+    if (nodeList->getDomainListVersion() != log.getVersion()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected version " << log.getVersion()
+            << " after the full list, got " << nodeList->getDomainListVersion() << std::endl;
+        return;
+    }
+    
+    // while everyone is still talking, we keep our version and only hear what changes
+    nodeList->removeSilentNodes();
+    if (nodeList->getDomainListVersion() != log.getVersion()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: lost our version with no node gone silent" << std::endl;
+    }
+    
+    SharedNodePointer addedMixer = nodeList->nodeWithUUID(mixer->getUUID());
+    if (!addedMixer) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the mixer from the domain list" << std::endl;
+        return;
+    }
+    addedMixer->setLastHeardMicrostamp(usecTimestampNow() - 2 * NODE_SILENCE_THRESHOLD_USECS);
+    nodeList->removeSilentNodes();
+    if (nodeList->nodeWithUUID(mixer->getUUID())) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the silent mixer to be removed" << std::endl;
+    }
+    
+    // the domain-server won't mention the mixer again unless it changes, so our next check-in has to get everything
+    if (nodeList->getDomainListVersion() != NO_DOMAIN_LIST_VERSION) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected to ask for the full list after removing a silent "
+            << "node, still at version " << nodeList->getDomainListVersion() << std::endl;
+    }
+    QList<DomainMembershipLog::Change> changes;
+    if (log.changesSince(log.getEpoch(), nodeList->getDomainListVersion(), changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the next check-in to be answered in full"
+            << std::endl;
+    }
+    nodeList->reset();
+}
+
+static quint64 packetBytes(const QList<QByteArray>& packets) {
+    quint64 bytes = 0;
+    foreach (const QByteArray& packet, packets) {
+        bytes += packet.size();
+    }
+    return bytes;
+}
+
+void DomainMembershipLogTests::benchmarkCheckInsAtFiveHundredNodes() {
+    // every node checks in once a second and is interested in every other node, with a few joining and leaving each second
+    const int NUMBER_OF_NODES = 500;
+    const int CHURN_PER_SECOND = 5;
+    const int NUMBER_OF_SECONDS = 10;
+    
+    QList<SharedNodePointer> nodes;
+    NodeHash nodesByUUID;
+    DomainMembershipLog log;
+    for (int i = 0; i < NUMBER_OF_NODES; i++) {
+        SharedNodePointer node = newNode(NodeType::Agent, 40000 + i);
+        nodes.append(node);
+        nodesByUUID.insert(node->getUUID(), node);
+        log.nodeAdded(node->getUUID());
+    }
+    QVector<quint32> seenVersions(NUMBER_OF_NODES, log.getVersion());
+    
+    NodeSet nodeInterestList;
+    nodeInterestList << NodeType::Agent;
+    TestListPacker packer;
+    quint64 fullBytes = 0, fullUsecs = 0, incrementalBytes = 0, incrementalUsecs = 0;
+    
+    for (int second = 0; second < NUMBER_OF_SECONDS; second++) {
+        for (int i = 0; i < CHURN_PER_SECOND; i++) {
+            int replaced = randIntInRange(0, NUMBER_OF_NODES - 1);
+            log.nodeRemoved(nodes[replaced]->getUUID());
+            nodesByUUID.remove(nodes[replaced]->getUUID());
+            nodes[replaced] = newNode(NodeType::Agent, 41000 + i);
+            nodesByUUID.insert(nodes[replaced]->getUUID(), nodes[replaced]);
+            log.nodeAdded(nodes[replaced]->getUUID());
+        }
+        
+        // the full list, the way every check-in was answered before
+        quint64 start = usecTimestampNow();
+        for (int i = 0; i < NUMBER_OF_NODES; i++) {
+            fullBytes += packetBytes(packer.pack(log, nodes[i], nodesByUUID, nodeInterestList,
+                                                 0, NO_DOMAIN_LIST_VERSION));
+        }
+        fullUsecs += usecTimestampNow() - start;
+        
+        // just the changes since the version each node last saw
+        start = usecTimestampNow();
+        for (int i = 0; i < NUMBER_OF_NODES; i++) {
+            incrementalBytes += packetBytes(packer.pack(log, nodes[i], nodesByUUID, nodeInterestList,
+                                                        log.getEpoch(), seenVersions[i]));
+            seenVersions[i] = log.getVersion();
+        }
+        incrementalUsecs += usecTimestampNow() - start;
+    }
+    
+    std::cout << "Domain-server check-ins at " << NUMBER_OF_NODES << " nodes: "
+        << "full list " << fullUsecs / NUMBER_OF_SECONDS << " usecs and " << fullBytes / NUMBER_OF_SECONDS << " bytes/sec, "
+        << "incremental " << incrementalUsecs / NUMBER_OF_SECONDS << " usecs and "
+        << incrementalBytes / NUMBER_OF_SECONDS << " bytes/sec" << std::endl;
+}
+
+void DomainMembershipLogTests::runAllTests() {
+    changesSinceVersion();
+    fullListOnGapOrEpochMismatch();
+    silentNodeAsksForFullList();
+    
+    benchmarkCheckInsAtFiveHundredNodes();
+}
@@ -0,0 +1,22 @@
+//
+//  DomainMembershipLogTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__DomainMembershipLogTests__
+#define __tests__DomainMembershipLogTests__
+
+namespace DomainMembershipLogTests {
+
+    void changesSinceVersion();
+    void fullListOnGapOrEpochMismatch();
+    void silentNodeAsksForFullList();
+
+    void benchmarkCheckInsAtFiveHundredNodes();
+
+    void runAllTests();
+}
+
+#endif // __tests__DomainMembershipLogTests__
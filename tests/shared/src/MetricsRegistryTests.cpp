@@ -0,0 +1,158 @@
+//
+//  MetricsRegistryTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+
+#include <MetricsRegistry.h>
+#include <SharedUtil.h>
+
+#include "MetricsRegistryTests.h"
+
+void MetricsRegistryTests::countersSurviveScrapes() {
+    MetricCounter* counter = MetricsRegistry::getInstance()->counter("test_counter_total", "A test counter");
+    counter->increment(5);
+    MetricsRegistry::getInstance()->toPrometheusText();
+    counter->increment(2);
+
+    QByteArray text = MetricsRegistry::getInstance()->toPrometheusText();
+    if (!text.contains("# TYPE test_counter_total counter\n") || !text.contains("\ntest_counter_total 7\n")) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the counter to be 7 across scrapes, got "
+            << text.constData() << std::endl;
+    }
+    if (MetricsRegistry::getInstance()->toJSON()["test_counter_total"].toDouble() != 7.0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the counter to be 7 in JSON" << std::endl;
+    }
+
+    MetricGauge* gauge = MetricsRegistry::getInstance()->gauge("test_gauge", "A test gauge");
+    gauge->set(0.25f);
+    if (MetricsRegistry::getInstance()->toJSON()["test_gauge"].toDouble() != 0.25) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the gauge to be 0.25" << std::endl;
+    }
+}
+
+void MetricsRegistryTests::histogramBucketsAreCumulative() {
+    QVector<quint64> bounds = QVector<quint64>() << 10 << 100;
+    MetricHistogram* histogram = MetricsRegistry::getInstance()->histogram("test_latency_usecs", "A test histogram",
+                                                                           bounds);
+    histogram->observe(5);
+    histogram->observe(10);
+    histogram->observe(50);
+    histogram->observe(1000);
+
+    QByteArray text = MetricsRegistry::getInstance()->toPrometheusText();
+    if (!text.contains("test_latency_usecs_bucket{le=\"10\"} 2\n")
+            || !text.contains("test_latency_usecs_bucket{le=\"100\"} 3\n")
+            || !text.contains("test_latency_usecs_bucket{le=\"+Inf\"} 4\n")
+            || !text.contains("test_latency_usecs_sum 1065\n")
+            || !text.contains("test_latency_usecs_count 4\n")) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: unexpected histogram " << text.constData() << std::endl;
+    }
+
+    QJsonObject histogramObject = MetricsRegistry::getInstance()->toJSON()["test_latency_usecs"].toObject();
+    if (histogramObject["count"].toDouble() != 4.0 || histogramObject["buckets"].toObject()["100"].toDouble() != 3.0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: unexpected histogram in JSON" << std::endl;
+    }
+}
+
+void MetricsRegistryTests::sameNameSameMetric() {
+    MetricCounter* first = MetricsRegistry::getInstance()->counter("test_shared_total", "Shared");
+    MetricCounter* second = MetricsRegistry::getInstance()->counter("test_shared_total", "Shared");
+    if (first != second) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the same counter for the same name" << std::endl;
+    }
+
+    // a different type under the same name is refused
+    if (MetricsRegistry::getInstance()->gauge("test_shared_total", "Not shared")) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected no gauge under a counter's name" << std::endl;
+    }
+    if (!MetricsRegistry::getInstance()->toPrometheusText().contains("# TYPE test_shared_total counter\n")) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the first registration to win" << std::endl;
+    }
+}
+
+void MetricsRegistryTests::totalsDontWrapBetweenScrapes() {
+    const quint64 THREE_GIGABYTES = Q_UINT64_C(3) << 30;
+    MetricCounter* counter = MetricsRegistry::getInstance()->counter("test_bytes_total", "A test byte counter");
+    counter->increment(THREE_GIGABYTES);
+    counter->increment(THREE_GIGABYTES);
+
+    QVector<quint64> bounds = QVector<quint64>() << 10;
+    MetricHistogram* histogram = MetricsRegistry::getInstance()->histogram("test_large_usecs", "Large samples", bounds);
+    histogram->observe(THREE_GIGABYTES);
+    histogram->observe(THREE_GIGABYTES);
+
+    QByteArray text = MetricsRegistry::getInstance()->toPrometheusText();
+    QByteArray twice = QByteArray::number(2 * THREE_GIGABYTES);
+    if (!text.contains("\ntest_bytes_total " + twice + "\n") || !text.contains("test_large_usecs_sum " + twice + "\n")) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected 6 GiB totals within one scrape, got "
+            << text.constData() << std::endl;
+    }
+}
+
+class UpdatingThread : public QThread {
+public:
+    UpdatingThread(MetricCounter* counter, MetricHistogram* histogram, int updates) :
+        _counter(counter), _histogram(histogram), _updates(updates) { }
+protected:
+    virtual void run() {
+        for (int i = 0; i < _updates; i++) {
+            _counter->increment();
+            _histogram->observe(i % 2000);
+        }
+    }
+private:
+    MetricCounter* _counter;
+    MetricHistogram* _histogram;
+    int _updates;
+};
+
+void MetricsRegistryTests::benchmarkUpdatesWhileScraping() {
+    const int UPDATES_PER_THREAD = 1000000;
+    const int THREAD_COUNT = 4;
+    MetricCounter* counter = MetricsRegistry::getInstance()->counter("test_contended_total", "Contended");
+    MetricHistogram* histogram = MetricsRegistry::getInstance()->histogram("test_contended_usecs", "Contended");
+
+    quint64 start = usecTimestampNow();
+    QList<UpdatingThread*> threads;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.append(new UpdatingThread(counter, histogram, UPDATES_PER_THREAD));
+        threads.last()->start();
+    }
+    int scrapes = 0;
+    bool running = true;
+    while (running) {
+        MetricsRegistry::getInstance()->toPrometheusText();
+        scrapes++;
+        running = false;
+        foreach (UpdatingThread* thread, threads) {
+            running = running || thread->isRunning();
+        }
+    }
+    foreach (UpdatingThread* thread, threads) {
+        thread->wait();
+        delete thread;
+    }
+    quint64 elapsed = usecTimestampNow() - start;
+
+    double total = MetricsRegistry::getInstance()->toJSON()["test_contended_total"].toDouble();
+    if (total != (double)UPDATES_PER_THREAD * THREAD_COUNT) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: lost updates, counted " << total << std::endl;
+    }
+    std::cout << THREAD_COUNT * UPDATES_PER_THREAD << " counter and histogram updates on " << THREAD_COUNT
+        << " threads while scraping " << scrapes << " times: " << elapsed << " usecs" << std::endl;
+}
+
+void MetricsRegistryTests::runAllTests() {
+    countersSurviveScrapes();
+    histogramBucketsAreCumulative();
+    sameNameSameMetric();
+    totalsDontWrapBetweenScrapes();
+    benchmarkUpdatesWhileScraping();
+}
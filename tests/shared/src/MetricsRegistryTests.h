@@ -0,0 +1,23 @@
+//
+//  MetricsRegistryTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__MetricsRegistryTests__
+#define __tests__MetricsRegistryTests__
+
+namespace MetricsRegistryTests {
+
+    void countersSurviveScrapes();
+    void histogramBucketsAreCumulative();
+    void sameNameSameMetric();
+    void totalsDontWrapBetweenScrapes();
+
+    void benchmarkUpdatesWhileScraping();
+
+    void runAllTests();
+}
+
+#endif // __tests__MetricsRegistryTests__
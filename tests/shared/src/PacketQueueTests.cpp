@@ -0,0 +1,253 @@
+//
+//  PacketQueueTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <NetworkPacket.h>
+#include <PacketQueue.h>
+#include <SharedUtil.h>
+
+#include "PacketQueueTests.h"
+
+const int TEST_PACKET_SIZE = 100;
+
+// a packet carrying the producer that sent it and its place in that producer's sequence
+static QByteArray makePacket(int producer, int sequence) {
+    QByteArray packet(TEST_PACKET_SIZE, 0);
+    memcpy(packet.data(), &producer, sizeof(int));
+    memcpy(packet.data() + sizeof(int), &sequence, sizeof(int));
+    return packet;
+}
+
+// checks that each producer's packets arrive complete and in order
+class OrderChecker {
+public:
+    OrderChecker(int producers) : received(0), errors(0) { nextSequences.fill(0, producers); }
+
+    void handlePacket(const SharedNodePointer& node, const QByteArray& packet) {
+        int producer, sequence;
+        memcpy(&producer, packet.constData(), sizeof(int));
+        memcpy(&sequence, packet.constData() + sizeof(int), sizeof(int));
+        if (packet.size() != TEST_PACKET_SIZE || producer < 0 || producer >= nextSequences.size() ||
+                sequence != nextSequences[producer]) {
+            if (errors++ == 0) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: got packet " << sequence << " of producer " << producer
+                    << " of size " << packet.size() << std::endl;
+            }
+            return;
+        }
+        nextSequences[producer]++;
+        received++;
+    }
+
+    QVector<int> nextSequences;
+    int received;
+    int errors;
+};
+
+// the locked vector the senders and processors used to queue packets in
+class LockedVectorQueue {
+public:
+    void push(const SharedNodePointer& node, const QByteArray& packet) {
+        NetworkPacket networkPacket(node, packet);
+        _mutex.lock();
+        _packets.push_back(networkPacket);
+        _mutex.unlock();
+    }
+
+    template<class Handler> int drain(Handler& handler) {
+        int count = 0;
+        _mutex.lock();
+        while (!_packets.empty()) {
+            NetworkPacket temporary = _packets.front();
+            _packets.erase(_packets.begin());
+            _mutex.unlock();
+            handler.handlePacket(temporary.getDestinationNode(), temporary.getByteArray());
+            count++;
+            _mutex.lock();
+        }
+        _mutex.unlock();
+        return count;
+    }
+
+private:
+    QMutex _mutex;
+    std::vector<NetworkPacket> _packets;
+};
+
+template<class Queue> class Producer : public QThread {
+public:
+    Producer(Queue* queue, int producer, int packets) : _queue(queue), _producer(producer), _packets(packets) { }
+
+protected:
+    virtual void run() {
+        for (int i = 0; i < _packets; i++) {
+            _queue->push(SharedNodePointer(), makePacket(_producer, i));
+        }
+    }
+
+private:
+    Queue* _queue;
+    int _producer;
+    int _packets;
+};
+
+// runs the producers against one consumer draining on this thread
+// \return the usecs from starting the producers to draining their last packet
+template<class Queue> static quint64 runProducers(Queue& queue, OrderChecker& checker, int producers, int packetsEach) {
+    QVector<Producer<Queue>*> threads;
+    for (int i = 0; i < producers; i++) {
+        threads.append(new Producer<Queue>(&queue, i, packetsEach));
+    }
+    quint64 start = usecTimestampNow();
+    foreach (Producer<Queue>* thread, threads) {
+        thread->start();
+    }
+    while (checker.received + checker.errors < producers * packetsEach) {
+        if (queue.drain(checker) == 0) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    quint64 elapsed = usecTimestampNow() - start;
+    foreach (Producer<Queue>* thread, threads) {
+        thread->wait();
+        delete thread;
+    }
+    return elapsed;
+}
+
+void PacketQueueTests::drainsInOrderThroughOverflow() {
+    const int CAPACITY = 4;
+    const int PACKETS = 10;
+    PacketQueue queue(CAPACITY);
+    for (int i = 0; i < PACKETS; i++) {
+        queue.push(SharedNodePointer(), makePacket(0, i));
+    }
+    if (queue.size() != PACKETS || queue.getOverflowCount() != PACKETS - CAPACITY) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << PACKETS << " queued with "
+            << PACKETS - CAPACITY << " overflowed, got " << queue.size() << " with " << queue.getOverflowCount() << std::endl;
+    }
+
+    // a batch stops at its limit, and overflowed packets wait for the ring to empty
+    OrderChecker checker(1);
+    int drained = queue.drain(checker, 3);
+    if (drained != 3 || checker.received != 3) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a batch of 3, got " << drained << std::endl;
+    }
+    queue.push(SharedNodePointer(), makePacket(0, PACKETS));
+    drained = queue.drain(checker);
+    if (drained != PACKETS - 2 || checker.errors != 0 || !queue.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the remaining " << PACKETS - 2
+            << " in order, got " << drained << " with " << checker.errors << " out of order" << std::endl;
+    }
+
+    // empty and oversized packets are refused
+    queue.push(SharedNodePointer(), QByteArray());
+    queue.push(SharedNodePointer(), QByteArray(MAX_PACKET_SIZE + 1, 0));
+    if (!queue.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected malformed packets to be refused" << std::endl;
+    }
+}
+
+// records where each packet handed out lives
+class BufferRecorder {
+public:
+    void handlePacket(const SharedNodePointer& node, const QByteArray& packet) { buffers.append(packet.constData()); }
+
+    QVector<const char*> buffers;
+};
+
+void PacketQueueTests::reusesSlotBuffers() {
+    const int CAPACITY = 2;
+    PacketQueue queue(CAPACITY);
+    BufferRecorder recorder;
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < CAPACITY; i++) {
+            queue.push(SharedNodePointer(), makePacket(0, i));
+        }
+        queue.drain(recorder);
+    }
+    for (int i = CAPACITY; i < recorder.buffers.size(); i++) {
+        if (recorder.buffers.at(i) != recorder.buffers.at(i % CAPACITY)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packet " << i << " was handed out in a new buffer"
+                << std::endl;
+            return;
+        }
+    }
+}
+
+void PacketQueueTests::copiesBorrowedBuffers() {
+    // a packet built over a buffer its sender rewrites, as the jurisdiction sender's are, in the ring and the overflow
+    const int CAPACITY = 1;
+    PacketQueue queue(CAPACITY);
+    char buffer[TEST_PACKET_SIZE];
+    for (int i = 0; i <= CAPACITY; i++) {
+        QByteArray packet = makePacket(0, i);
+        memcpy(buffer, packet.constData(), TEST_PACKET_SIZE);
+        queue.push(SharedNodePointer(), QByteArray::fromRawData(buffer, TEST_PACKET_SIZE));
+    }
+    memset(buffer, 0xFF, TEST_PACKET_SIZE);
+
+    OrderChecker checker(1);
+    queue.drain(checker);
+    if (checker.received != CAPACITY + 1 || checker.errors != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the packets as pushed, got " << checker.received
+            << " intact and " << checker.errors << " changed" << std::endl;
+    }
+}
+
+void PacketQueueTests::keepsEachProducersOrderUnderContention() {
+    // a ring small enough that the producers regularly find it full
+    const int CAPACITY = 64;
+    const int PRODUCERS = 4;
+    const int PACKETS_EACH = 20000;
+    PacketQueue queue(CAPACITY);
+    OrderChecker checker(PRODUCERS);
+    runProducers(queue, checker, PRODUCERS, PACKETS_EACH);
+
+    if (checker.errors != 0 || checker.received != PRODUCERS * PACKETS_EACH || !queue.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << PRODUCERS * PACKETS_EACH
+            << " packets in order, got " << checker.received << " with " << checker.errors << " out of order" << std::endl;
+    }
+}
+
+void PacketQueueTests::benchmarkContendedEnqueueDequeue() {
+    const int PRODUCERS = 4;
+    const int PACKETS_EACH = 10000;
+    const float PACKETS = PRODUCERS * PACKETS_EACH;
+
+    LockedVectorQueue lockedQueue;
+    OrderChecker lockedChecker(PRODUCERS);
+    quint64 lockedUsecs = runProducers(lockedQueue, lockedChecker, PRODUCERS, PACKETS_EACH);
+
+    PacketQueue queue;
+    OrderChecker checker(PRODUCERS);
+    quint64 usecs = runProducers(queue, checker, PRODUCERS, PACKETS_EACH);
+
+    std::cout << PRODUCERS << " producers, " << PACKETS << " packets: locked vector "
+        << PACKETS * USECS_PER_SECOND / qMax(lockedUsecs, (quint64)1) << " packets/sec, packet queue "
+        << PACKETS * USECS_PER_SECOND / qMax(usecs, (quint64)1) << " packets/sec with " << queue.getOverflowCount()
+        << " overflowed" << std::endl;
+
+    if (checker.errors != 0 || lockedChecker.errors != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packets arrived out of order" << std::endl;
+    }
+}
+
+void PacketQueueTests::runAllTests() {
+    drainsInOrderThroughOverflow();
+    reusesSlotBuffers();
+    copiesBorrowedBuffers();
+    keepsEachProducersOrderUnderContention();
+    benchmarkContendedEnqueueDequeue();
+}
@@ -0,0 +1,23 @@
+//
+//  PacketQueueTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__PacketQueueTests__
+#define __tests__PacketQueueTests__
+
+namespace PacketQueueTests {
+
+    void drainsInOrderThroughOverflow();
+    void reusesSlotBuffers();
+    void copiesBorrowedBuffers();
+    void keepsEachProducersOrderUnderContention();
+
+    void benchmarkContendedEnqueueDequeue();
+
+    void runAllTests();
+}
+
+#endif // __tests__PacketQueueTests__
@@ -0,0 +1,353 @@
+//
+//  PacketSchedulerTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <cmath>
+#include <iostream>
+
+#include <PacketScheduler.h>
+#include <SharedUtil.h>
+
+#include "PacketSchedulerTests.h"
+
+// stands in for the PacketSender, recording what goes out instead of writing it to the socket
+class RecordingSender {
+public:
+    RecordingSender() : failures(0) { }
+
+    bool sendPacket(const SharedNodePointer& node, const QByteArray& packet) {
+        if (failures > 0) {
+            failures--;
+            return false;
+        }
+        nodes.append(node);
+        packets.append(packet);
+        return true;
+    }
+
+    int countSentTo(const SharedNodePointer& node) const { return nodes.count(node); }
+
+    QVector<SharedNodePointer> nodes;
+    QVector<QByteArray> packets;
+    int failures; // how many sends to refuse, as a full socket would
+};
+
+static SharedNodePointer makeServer() {
+    return SharedNodePointer(new Node(QUuid::createUuid(), NodeType::VoxelServer, HifiSockAddr(), HifiSockAddr()));
+}
+
+static void queuePackets(PacketScheduler& scheduler, const SharedNodePointer& node, int count) {
+    for (int i = 0; i < count; i++) {
+        scheduler.queuePacket(node, QByteArray(1, (char)i));
+    }
+}
+
+static float getTargetPacketsPerSecond(const PacketScheduler& scheduler, const SharedNodePointer& node) {
+    foreach (const DestinationRate& rate, scheduler.getDestinationRates()) {
+        if (rate.uuid == node->getUUID()) {
+            return rate.targetPacketsPerSecond;
+        }
+    }
+    return 0.0f;
+}
+
+// keeps the server busy for another second
+static void sendForASecond(PacketScheduler& scheduler, RecordingSender& sender, const SharedNodePointer& server,
+        quint64& now) {
+    queuePackets(scheduler, server, scheduler.getPacketsPerSecond());
+    now += USECS_PER_SECOND;
+    scheduler.sendPackets(sender, now);
+}
+
+const quint64 CALL_INTERVAL_USECS = 50 * USECS_PER_MSEC;
+
+void PacketSchedulerTests::burstDoesNotStarveOtherDestinations() {
+    const int PACKETS_PER_SECOND = 20;
+    const int BURST_PACKETS = 100;
+    const int OTHER_PACKETS = 10;
+    PacketScheduler scheduler(PACKETS_PER_SECOND);
+    scheduler.setBurstUsecs(CALL_INTERVAL_USECS * 2);
+
+    // a burst of edits to one server, then a few to another
+    SharedNodePointer busy = makeServer();
+    SharedNodePointer other = makeServer();
+    queuePackets(scheduler, busy, BURST_PACKETS);
+    queuePackets(scheduler, other, OTHER_PACKETS);
+
+    RecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+    for (quint64 end = now + USECS_PER_SECOND; now <= end; now += CALL_INTERVAL_USECS) {
+        scheduler.sendPackets(sender, now);
+    }
+
+    // with one queue the other server would have waited five seconds behind the burst; shared, it's done in one
+    if (sender.countSentTo(other) != OTHER_PACKETS || sender.countSentTo(busy) < OTHER_PACKETS ||
+            sender.nodes.size() > PACKETS_PER_SECOND + 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << OTHER_PACKETS << " packets to each server in "
+            << "the first second, got " << sender.countSentTo(other) << " and " << sender.countSentTo(busy) << std::endl;
+    }
+
+    // each server's packets keep their order
+    char expected = 0;
+    for (int i = 0; i < sender.nodes.size(); i++) {
+        if (sender.nodes.at(i) == other && sender.packets.at(i).at(0) != expected++) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packets sent out of order" << std::endl;
+            break;
+        }
+    }
+}
+
+void PacketSchedulerTests::weightsShareTheRate() {
+    const int PACKETS_PER_SECOND = 40;
+    const float HEAVY_WEIGHT = 3.0f;
+    PacketScheduler scheduler(PACKETS_PER_SECOND);
+    scheduler.setBurstUsecs(CALL_INTERVAL_USECS * 2);
+
+    SharedNodePointer heavy = makeServer();
+    SharedNodePointer light = makeServer();
+    scheduler.setWeight(heavy->getUUID(), HEAVY_WEIGHT);
+    queuePackets(scheduler, heavy, PACKETS_PER_SECOND * 2);
+    queuePackets(scheduler, light, PACKETS_PER_SECOND * 2);
+
+    RecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+    for (quint64 end = now + USECS_PER_SECOND; now <= end; now += CALL_INTERVAL_USECS) {
+        scheduler.sendPackets(sender, now);
+    }
+
+    float ratio = (float)sender.countSentTo(heavy) / qMax(sender.countSentTo(light), 1);
+    const float RATIO_TOLERANCE = 0.5f;
+    if (fabsf(ratio - HEAVY_WEIGHT) > RATIO_TOLERANCE) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a " << HEAVY_WEIGHT << " to 1 split, got "
+            << sender.countSentTo(heavy) << " to " << sender.countSentTo(light) << std::endl;
+    }
+}
+
+void PacketSchedulerTests::congestedLinksSlowDown() {
+    const int PACKETS_PER_SECOND = 100;
+    const int PINGS_PER_SAMPLE = 5;
+    PacketScheduler scheduler(PACKETS_PER_SECOND);
+    scheduler.setBurstUsecs(USECS_PER_SECOND);
+
+    SharedNodePointer server = makeServer();
+    server->setPingMs(20);
+    RecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+
+    scheduler.queuePacket(server, QByteArray(1, 0));
+    scheduler.sendPackets(sender, now);
+    sendForASecond(scheduler, sender, server, now);
+    if (getTargetPacketsPerSecond(scheduler, server) != PACKETS_PER_SECOND) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected a healthy link to run at the full rate, got "
+            << getTargetPacketsPerSecond(scheduler, server) << std::endl;
+    }
+
+    // a run of unanswered pings halves the rate, then holds it while the loss lingers
+    for (int i = 0; i <= PINGS_PER_SAMPLE; i++) {
+        server->recordPingSent();
+    }
+    sendForASecond(scheduler, sender, server, now);
+    sendForASecond(scheduler, sender, server, now);
+    if (getTargetPacketsPerSecond(scheduler, server) != PACKETS_PER_SECOND / 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the rate halved on loss, got "
+            << getTargetPacketsPerSecond(scheduler, server) << std::endl;
+    }
+
+    // once the pings come back the rate grows back
+    const int MAX_SAMPLES = 10;
+    const float RECOVERED_LOSS_RATE = 0.05f;
+    for (int i = 0; i < MAX_SAMPLES && server->getPingLossRate() > RECOVERED_LOSS_RATE; i++) {
+        for (int j = 0; j < PINGS_PER_SAMPLE; j++) {
+            server->recordPingReply();
+            server->recordPingSent();
+        }
+    }
+    sendForASecond(scheduler, sender, server, now);
+    if (getTargetPacketsPerSecond(scheduler, server) <= PACKETS_PER_SECOND / 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the rate to recover, got "
+            << getTargetPacketsPerSecond(scheduler, server) << std::endl;
+    }
+
+    // a round trip swollen well past the quietest seen halves it too
+    float recovered = getTargetPacketsPerSecond(scheduler, server);
+    server->setPingMs(200);
+    sendForASecond(scheduler, sender, server, now);
+    if (getTargetPacketsPerSecond(scheduler, server) != recovered / 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the rate halved on a swollen ping, got "
+            << getTargetPacketsPerSecond(scheduler, server) << std::endl;
+    }
+}
+
+void PacketSchedulerTests::refusedPacketsAreRetried() {
+    const int PACKETS = 3;
+    PacketScheduler scheduler(PACKETS);
+    scheduler.setBurstUsecs(USECS_PER_SECOND);
+    SharedNodePointer server = makeServer();
+
+    RecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+    scheduler.sendPackets(sender, now);
+    now += USECS_PER_SECOND;
+    queuePackets(scheduler, server, PACKETS);
+
+    // the socket's full; nothing more goes until it's had a moment
+    sender.failures = 1;
+    if (scheduler.sendPackets(sender, now) != 0 || scheduler.getUsecsUntilNextSend(now) <= 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected to wait after a refused send" << std::endl;
+    }
+    now += CALL_INTERVAL_USECS;
+    scheduler.sendPackets(sender, now);
+    now += USECS_PER_SECOND;
+    scheduler.sendPackets(sender, now);
+    if (sender.packets.size() != PACKETS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected all " << PACKETS << " packets sent, got "
+            << sender.packets.size() << std::endl;
+    }
+    for (int i = 0; i < sender.packets.size(); i++) {
+        if (sender.packets.at(i).at(0) != i) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: retried packet sent out of order" << std::endl;
+            break;
+        }
+    }
+
+    // one the socket keeps refusing is kept and tried again until it goes, since edits must not be lost
+    queuePackets(scheduler, server, 1);
+    sender.failures = PACKETS;
+    for (int i = 0; i < PACKETS; i++) {
+        now += USECS_PER_SECOND;
+        scheduler.sendPackets(sender, now);
+    }
+    if (scheduler.getQueuedPacketCount() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the refused packet kept" << std::endl;
+    }
+    now += USECS_PER_SECOND;
+    scheduler.sendPackets(sender, now);
+    if (sender.packets.size() != PACKETS + 1 || scheduler.getQueuedPacketCount() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the refused packet sent once the socket took it"
+            << std::endl;
+    }
+}
+
+void PacketSchedulerTests::onlyTakesWhatItCanSend() {
+    const int PACKETS_PER_SECOND = 10;
+    PacketScheduler scheduler(PACKETS_PER_SECOND);
+    scheduler.setBurstUsecs(CALL_INTERVAL_USECS);
+    SharedNodePointer server = makeServer();
+    SharedNodePointer other = makeServer();
+    RecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+
+    // the bucket holds a single token, so once one packet's queued the rest are left where they are
+    if (!scheduler.hasRoomFor(server, now)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected room for the first packet" << std::endl;
+    }
+    queuePackets(scheduler, server, 1);
+    if (scheduler.hasRoomFor(server, now) || !scheduler.isWaitingForRoom() ||
+            scheduler.getUsecsUntilNextSend(now) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected no room until the queued packet was sent"
+            << std::endl;
+    }
+    scheduler.sendPackets(sender, now);
+
+    // with the token spent, the wait is for the next one
+    if (scheduler.hasRoomFor(other, now) || scheduler.getUsecsUntilNextSend(now) <= 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected to wait for a token" << std::endl;
+    }
+    now += 2 * USECS_PER_SECOND / PACKETS_PER_SECOND;
+    if (!scheduler.hasRoomFor(other, now) || scheduler.isWaitingForRoom()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected room once a token came in" << std::endl;
+    }
+}
+
+// notes where each packet it's handed lives, without keeping a reference to it
+class BufferRecordingSender {
+public:
+    bool sendPacket(const SharedNodePointer& node, const QByteArray& packet) {
+        buffers.append(packet.constData());
+        contents.append(packet.at(0));
+        return true;
+    }
+
+    QVector<const char*> buffers;
+    QVector<char> contents;
+};
+
+void PacketSchedulerTests::reusesPacketBuffers() {
+    const int PACKETS = 4;
+    PacketScheduler scheduler(PACKETS);
+    scheduler.setBurstUsecs(USECS_PER_SECOND);
+    SharedNodePointer server = makeServer();
+    BufferRecordingSender sender;
+    quint64 now = USECS_PER_SECOND;
+    scheduler.sendPackets(sender, now);
+
+    // the caller's buffer is reused straight away, as a slot of the sender's queue is
+    QByteArray packet(1, 0);
+    for (int i = 0; i < PACKETS; i++) {
+        packet[0] = (char)i;
+        scheduler.queuePacket(server, packet);
+        now += USECS_PER_SECOND;
+        scheduler.sendPackets(sender, now);
+    }
+    for (int i = 0; i < sender.contents.size(); i++) {
+        if (sender.contents.at(i) != i) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a queued packet changed along with the caller's buffer"
+                << std::endl;
+            break;
+        }
+    }
+    if (sender.buffers.size() != PACKETS || sender.buffers.count(sender.buffers.first()) != PACKETS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected every packet sent from the same reused buffer"
+            << std::endl;
+    }
+}
+
+void PacketSchedulerTests::benchmarkSchedulingManyDestinations() {
+    const int DESTINATIONS = 16;
+    const int PACKETS_PER_DESTINATION = 10000;
+    const int PACKETS_PER_SECOND = DESTINATIONS * PACKETS_PER_DESTINATION;
+    PacketScheduler scheduler(PACKETS_PER_SECOND);
+    scheduler.setBurstUsecs(USECS_PER_SECOND);
+
+    QVector<SharedNodePointer> servers;
+    for (int i = 0; i < DESTINATIONS; i++) {
+        servers.append(makeServer());
+    }
+    QByteArray packet(MAX_PACKET_SIZE, 0);
+    RecordingSender sender;
+    sender.nodes.reserve(PACKETS_PER_SECOND);
+    sender.packets.reserve(PACKETS_PER_SECOND);
+    scheduler.sendPackets(sender, USECS_PER_SECOND);
+
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < PACKETS_PER_DESTINATION; i++) {
+        for (int j = 0; j < DESTINATIONS; j++) {
+            scheduler.queuePacket(servers.at(j), packet);
+        }
+    }
+    quint64 queued = usecTimestampNow();
+    scheduler.sendPackets(sender, 2 * USECS_PER_SECOND);
+    quint64 sent = usecTimestampNow();
+
+    std::cout << "Scheduling " << PACKETS_PER_SECOND << " packets to " << DESTINATIONS << " destinations: "
+        << (float)(queued - start) * 1000.0f / PACKETS_PER_SECOND << " nsecs per queue, "
+        << (float)(sent - queued) * 1000.0f / PACKETS_PER_SECOND << " nsecs per send" << std::endl;
+
+    if (sender.packets.size() != PACKETS_PER_SECOND) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << PACKETS_PER_SECOND << " packets sent, got "
+            << sender.packets.size() << std::endl;
+    }
+}
+
+void PacketSchedulerTests::runAllTests() {
+    burstDoesNotStarveOtherDestinations();
+    weightsShareTheRate();
+    congestedLinksSlowDown();
+    refusedPacketsAreRetried();
+    onlyTakesWhatItCanSend();
+    reusesPacketBuffers();
+    benchmarkSchedulingManyDestinations();
+}
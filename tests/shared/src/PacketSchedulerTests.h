@@ -0,0 +1,25 @@
+//
+//  PacketSchedulerTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__PacketSchedulerTests__
+#define __tests__PacketSchedulerTests__
+
+namespace PacketSchedulerTests {
+
+    void burstDoesNotStarveOtherDestinations();
+    void weightsShareTheRate();
+    void congestedLinksSlowDown();
+    void refusedPacketsAreRetried();
+    void onlyTakesWhatItCanSend();
+    void reusesPacketBuffers();
+
+    void benchmarkSchedulingManyDestinations();
+
+    void runAllTests();
+}
+
+#endif // __tests__PacketSchedulerTests__
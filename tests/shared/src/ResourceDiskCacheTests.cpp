@@ -0,0 +1,250 @@
+//
+//  ResourceDiskCacheTests.cpp
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#include <iostream>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+
+#include <ResourceDiskCache.h>
+#include <SharedUtil.h>
+
+#include "ResourceDiskCacheTests.h"
+
+// stores a download as the network access manager would
+static void insertDownload(ResourceDiskCache& cache, const QUrl& url, const QByteArray& body,
+        const QByteArray& eTag = QByteArray("\"1\"")) {
+    QNetworkCacheMetaData metaData;
+    metaData.setUrl(url);
+    metaData.setSaveToDisk(true);
+    metaData.setRawHeaders(QNetworkCacheMetaData::RawHeaderList() << qMakePair(QByteArray("ETag"), eTag));
+    QIODevice* device = cache.prepare(metaData);
+    if (!device) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't prepare " << qPrintable(url.toString()) << std::endl;
+        return;
+    }
+    device->write(body);
+    cache.insert(device);
+}
+
+static QByteArray readDownload(ResourceDiskCache& cache, const QUrl& url) {
+    QIODevice* device = cache.data(url);
+    if (!device) {
+        return QByteArray();
+    }
+    QByteArray body = device->readAll();
+    delete device;
+    return body;
+}
+
+static QByteArray makeBody(int size, char seed) {
+    QByteArray body(size, 0);
+    for (int i = 0; i < size; i++) {
+        body[i] = (char)(seed + i * 7);
+    }
+    return body;
+}
+
+void ResourceDiskCacheTests::sameContentStoredOnce() {
+    QTemporaryDir directory;
+    ResourceDiskCache cache;
+    cache.setCacheDirectory(directory.path());
+
+    QByteArray shared = makeBody(1000, 1);
+    QByteArray other = makeBody(500, 2);
+    QUrl first("http://example.com/models/first/skin.png");
+    QUrl second("http://example.com/models/second/skin.png");
+    QUrl third("http://example.com/models/third/mesh.fbx");
+    insertDownload(cache, first, shared);
+    insertDownload(cache, second, shared);
+    insertDownload(cache, third, other);
+
+    if (cache.getEntryCount() != 3 || cache.getContentCount() != 2 || cache.cacheSize() != shared.size() + other.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected 3 entries of 2 bodies in " << shared.size() + other.size()
+            << " bytes, got " << cache.getEntryCount() << " entries of " << cache.getContentCount() << " in "
+            << cache.cacheSize() << std::endl;
+    }
+    if (readDownload(cache, first) != shared || readDownload(cache, second) != shared || readDownload(cache, third) != other) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: read back the wrong content" << std::endl;
+    }
+
+    // the shared body stays while any URL refers to it
+    cache.remove(first);
+    if (readDownload(cache, second) != shared || cache.getContentCount() != 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: removing one URL lost the content of another" << std::endl;
+    }
+    cache.remove(second);
+    if (cache.getContentCount() != 1 || cache.cacheSize() != other.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: content outlived the last URL referring to it" << std::endl;
+    }
+
+    // a download abandoned after being prepared is dropped with its URL
+    QNetworkCacheMetaData metaData;
+    metaData.setUrl(first);
+    metaData.setSaveToDisk(true);
+    QIODevice* device = cache.prepare(metaData);
+    device->write(shared);
+    cache.remove(first);
+    if (cache.metaData(first).isValid()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: an abandoned download was cached" << std::endl;
+    }
+}
+
+void ResourceDiskCacheTests::entriesSurviveRestart() {
+    QTemporaryDir directory;
+    QUrl mesh("http://example.com/models/mesh.fbx");
+    QUrl texture("http://example.com/models/texture.png");
+    QByteArray meshBody = makeBody(2000, 3);
+    QByteArray textureBody = makeBody(3000, 4);
+    {
+        ResourceDiskCache cache;
+        cache.setCacheDirectory(directory.path());
+        insertDownload(cache, mesh, meshBody);
+        insertDownload(cache, texture, textureBody);
+
+        // a conditional request came back unmodified, with a new expiry
+        QNetworkCacheMetaData metaData = cache.metaData(mesh);
+        metaData.setRawHeaders(QNetworkCacheMetaData::RawHeaderList() <<
+            qMakePair(QByteArray("ETag"), QByteArray("\"2\"")));
+        cache.updateMetaData(metaData);
+    }
+
+    // damage the texture's entry, as a crash partway through writing it might have
+    QFile entryFile(directory.path() + "/entries/" +
+        QCryptographicHash::hash(texture.toEncoded(), QCryptographicHash::Sha1).toHex());
+    if (!entryFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't find the texture's entry" << std::endl;
+    }
+    entryFile.write("garbage");
+    entryFile.close();
+
+    ResourceDiskCache cache;
+    cache.setCacheDirectory(directory.path());
+    QNetworkCacheMetaData metaData = cache.metaData(mesh);
+    if (!metaData.isValid() || metaData.rawHeaders().isEmpty() || metaData.rawHeaders().first().second != "\"2\"" ||
+            readDownload(cache, mesh) != meshBody) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the revalidated mesh didn't survive a restart" << std::endl;
+    }
+    if (cache.metaData(texture).isValid() || cache.getContentCount() != 1 || cache.cacheSize() != meshBody.size() ||
+            QDir(directory.path() + "/content").entryList(QDir::Files).size() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the damaged entry and its content weren't dropped" << std::endl;
+    }
+}
+
+void ResourceDiskCacheTests::leastRecentlyUsedExpireFirst() {
+    QTemporaryDir directory;
+    ResourceDiskCache cache;
+    cache.setCacheDirectory(directory.path());
+    const int BODY_SIZE = 3000;
+    cache.setMaximumCacheSize(10000);
+
+    QVector<QUrl> urls;
+    for (int i = 0; i < 4; i++) {
+        urls.append(QUrl(QString("http://example.com/%1.png").arg(i)));
+    }
+    for (int i = 0; i < 3; i++) {
+        insertDownload(cache, urls.at(i), makeBody(BODY_SIZE, i));
+        QThread::msleep(2);
+    }
+    // use the first again, so that the second is the least recently used when the fourth doesn't fit
+    readDownload(cache, urls.at(0));
+    QThread::msleep(2);
+    insertDownload(cache, urls.at(3), makeBody(BODY_SIZE, 3));
+
+    if (!cache.metaData(urls.at(0)).isValid() || cache.metaData(urls.at(1)).isValid() ||
+            !cache.metaData(urls.at(2)).isValid() || !cache.metaData(urls.at(3)).isValid()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected only the second download to expire" << std::endl;
+    }
+    if (cache.cacheSize() > cache.getMaximumCacheSize()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the cache is over its maximum at " << cache.cacheSize()
+            << std::endl;
+    }
+}
+
+void ResourceDiskCacheTests::oldNetworkDiskCacheRemoved() {
+    // lay out a QNetworkDiskCache next to our cache, as an install from before it would have
+    QTemporaryDir directory;
+    QDir(directory.path()).mkpath("data8/4");
+    QDir(directory.path()).mkpath("prepared");
+    QFile oldFile(directory.path() + "/data8/4/old.d");
+    oldFile.open(QIODevice::WriteOnly);
+    oldFile.write(makeBody(1000, 3));
+    oldFile.close();
+
+    ResourceDiskCache cache;
+    cache.setCacheDirectory(directory.path() + "/resourceCache");
+    insertDownload(cache, QUrl("http://example.com/kept.png"), makeBody(1000, 4));
+
+    ResourceDiskCache::removeNetworkDiskCache(directory.path());
+    if (QDir(directory.path() + "/data8").exists() || QDir(directory.path() + "/prepared").exists()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected the old cache directories to be removed"
+            << std::endl;
+    }
+
+    ResourceDiskCache restarted;
+    restarted.setCacheDirectory(directory.path() + "/resourceCache");
+    if (readDownload(restarted, QUrl("http://example.com/kept.png")) != makeBody(1000, 4)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: removing the old cache took the new one with it"
+            << std::endl;
+    }
+}
+
+void ResourceDiskCacheTests::benchmarkStartupWithSharedTextures() {
+    // fifty avatars, each with a mesh of its own and four textures drawn from a shared set of twenty
+    const int AVATARS = 50;
+    const int TEXTURES_PER_AVATAR = 4;
+    const int SHARED_TEXTURES = 20;
+    const int MESH_SIZE = 256 * 1024;
+    const int TEXTURE_SIZE = 128 * 1024;
+
+    QTemporaryDir directory;
+    qint64 totalBytes = 0;
+    quint64 insertUsecs;
+    {
+        ResourceDiskCache cache;
+        cache.setCacheDirectory(directory.path());
+        quint64 start = usecTimestampNow();
+        for (int i = 0; i < AVATARS; i++) {
+            insertDownload(cache, QUrl(QString("http://example.com/avatars/%1/mesh.fbx").arg(i)), makeBody(MESH_SIZE, i));
+            totalBytes += MESH_SIZE;
+            for (int j = 0; j < TEXTURES_PER_AVATAR; j++) {
+                int texture = (i * TEXTURES_PER_AVATAR + j) % SHARED_TEXTURES;
+                insertDownload(cache, QUrl(QString("http://example.com/avatars/%1/texture%2.png").arg(i).arg(j)),
+                    makeBody(TEXTURE_SIZE, 100 + texture));
+                totalBytes += TEXTURE_SIZE;
+            }
+        }
+        insertUsecs = usecTimestampNow() - start;
+    }
+
+    ResourceDiskCache cache;
+    quint64 start = usecTimestampNow();
+    cache.setCacheDirectory(directory.path());
+    quint64 loadUsecs = usecTimestampNow() - start;
+
+    std::cout << "Disk cache of " << cache.getEntryCount() << " downloads: " << totalBytes / 1024 << " KB fetched, "
+        << cache.cacheSize() / 1024 << " KB stored in " << cache.getContentCount() << " files, "
+        << insertUsecs / cache.getEntryCount() << " usecs per insert, " << loadUsecs << " usecs to load at startup"
+        << std::endl;
+
+    if (cache.getEntryCount() != AVATARS * (1 + TEXTURES_PER_AVATAR) || cache.getContentCount() != AVATARS + SHARED_TEXTURES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: expected " << AVATARS * (1 + TEXTURES_PER_AVATAR)
+            << " entries of " << AVATARS + SHARED_TEXTURES << " bodies after restart" << std::endl;
+    }
+}
+
+void ResourceDiskCacheTests::runAllTests() {
+    sameContentStoredOnce();
+    entriesSurviveRestart();
+    leastRecentlyUsedExpireFirst();
+    oldNetworkDiskCacheRemoved();
+
+    benchmarkStartupWithSharedTextures();
+}
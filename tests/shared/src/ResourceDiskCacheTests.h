@@ -0,0 +1,23 @@
+//
+//  ResourceDiskCacheTests.h
+//  shared-tests
+//
+//  Copyright (c) 2014 High Fidelity, Inc. All rights reserved.
+//
+
+#ifndef __tests__ResourceDiskCacheTests__
+#define __tests__ResourceDiskCacheTests__
+
+namespace ResourceDiskCacheTests {
+
+    void sameContentStoredOnce();
+    void entriesSurviveRestart();
+    void leastRecentlyUsedExpireFirst();
+    void oldNetworkDiskCacheRemoved();
+
+    void benchmarkStartupWithSharedTextures();
+
+    void runAllTests();
+}
+
+#endif // __tests__ResourceDiskCacheTests__
@@ -0,0 +1,21 @@
+//
+//  main.cpp
+//  shared-tests
+//
+
+#include "DatagramQueueTests.h"
+#include "DomainMembershipLogTests.h"
+#include "MetricsRegistryTests.h"
+#include "PacketQueueTests.h"
+#include "PacketSchedulerTests.h"
+#include "ResourceDiskCacheTests.h"
+
+int main(int argc, char** argv) {
+    DatagramQueueTests::runAllTests();
+    DomainMembershipLogTests::runAllTests();
+    MetricsRegistryTests::runAllTests();
+    PacketQueueTests::runAllTests();
+    PacketSchedulerTests::runAllTests();
+    ResourceDiskCacheTests::runAllTests();
+    return 0;
+}
@@ -7,9 +7,12 @@
 //
 
 #include <VoxelTree.h>
+#include <VoxelSVOTools.h>
 #include <SharedUtil.h>
 #include "SceneUtils.h"
 #include <JurisdictionMap.h>
+#include <QDir>
+#include <QFileInfo>
 #include <QString>
 #include <QStringList>
 
@@ -141,7 +144,7 @@ void processSplitSVOFile(const char* splitSVOFile,const char* splitJurisdictionR
 
 class copyAndFillArgs {
 public:
-    VoxelTree* destinationTree;
+    QVector<VoxelDetail> voxels; // created in one batch once the whole tree has been visited
     unsigned long outCount;
     unsigned long inCount;
     unsigned long originalCount;
@@ -166,9 +169,8 @@ bool copyAndFillOperation(OctreeElement* element, void* extraData) {
         unsigned char red = voxel->getColor()[RED_INDEX];
         unsigned char green = voxel->getColor()[GREEN_INDEX];
         unsigned char blue = voxel->getColor()[BLUE_INDEX];
-        bool destructive = true;
-
-        args->destinationTree->createVoxel(x, y, z, s, red, green, blue, destructive);
+        VoxelDetail leaf = { x, y, z, s, red, green, blue };
+        args->voxels.append(leaf);
         args->outCount++;
 
         sprintf(outputMessage,"Completed: %d%% (%lu of %lu) - Creating voxel %lu at [%f,%f,%f,%f]",
@@ -180,7 +182,8 @@ bool copyAndFillOperation(OctreeElement* element, void* extraData) {
 
         // and create same sized leafs from this leaf voxel down to zero in the destination tree
         for (float yFill = y-s; yFill >= 0.0f; yFill -= s) {
-            args->destinationTree->createVoxel(x, yFill, z, s, red, green, blue, destructive);
+            VoxelDetail fill = { x, yFill, z, s, red, green, blue };
+            args->voxels.append(fill);
 
             args->outCount++;
 
@@ -210,12 +213,12 @@ void processFillSVOFile(const char* fillSVOFile) {
     qDebug("Nodes after reaveraging %lu nodes", originalSVO.getOctreeElementsCount());
 
     copyAndFillArgs args;
-    args.destinationTree = &filledSVO;
     args.inCount = 0;
     args.outCount = 0;
     args.originalCount = originalSVO.getOctreeElementsCount();
     qDebug("Begin processing...");
     originalSVO.recurseTreeWithOperation(copyAndFillOperation, &args);
+    filledSVO.createVoxels(args.voxels, true);
     qDebug("DONE processing...");
 
     qDebug("Original input nodes used for filling %lu nodes", args.originalCount);
@@ -233,6 +236,73 @@ void processFillSVOFile(const char* fillSVOFile) {
     qDebug("exiting now");
 }
 
+// the streaming commands below never load the whole SVO, so they work on worlds bigger than memory
+
+// puts the prefix on the file name, in the same directory
+QString prefixedFileName(const char* fileName, const QString& prefix) {
+    QFileInfo fileInfo(fileName);
+    return fileInfo.dir().filePath(prefix + fileInfo.fileName());
+}
+
+void processStreamSVOStats(const char* statsSVOFile) {
+    qDebug("streamSVOStats: %s", statsSVOFile);
+
+    VoxelSVOStats stats;
+    if (!VoxelSVOTools::computeStats(statsSVOFile, stats)) {
+        qDebug("Couldn't read %s", statsSVOFile);
+        return;
+    }
+    qDebug("Records: %llu Bytes: %llu Voxels: %llu", stats.recordCount, stats.byteCount, stats.voxelCount);
+    for (int level = 0; level < stats.voxelsPerLevel.size(); level++) {
+        if (stats.voxelsPerLevel[level] > 0) {
+            qDebug("Level %d (%f meters): %llu voxels", level, TREE_SCALE / powf(2.0f, level),
+                stats.voxelsPerLevel[level]);
+        }
+    }
+}
+
+void processStreamSplitSVOFile(const char* splitSVOFile, const char* splitJurisdictionRoot,
+                               const char* splitJurisdictionEndNodes) {
+    qDebug("streamSplitSVO: %s Jurisdictions Root: %s EndNodes: %s",
+            splitSVOFile, splitJurisdictionRoot, splitJurisdictionEndNodes);
+
+    JurisdictionMap jurisdiction(splitJurisdictionRoot, splitJurisdictionEndNodes);
+    QStringList endNodeFileNames;
+    for (int i = 0; i < jurisdiction.getEndNodeCount(); i++) {
+        endNodeFileNames << prefixedFileName(splitSVOFile, QString("splitENDNODE%1").arg(i));
+    }
+    if (!VoxelSVOTools::split(splitSVOFile, jurisdiction, prefixedFileName(splitSVOFile, "splitROOT"),
+            endNodeFileNames)) {
+        qDebug("Split of %s failed", splitSVOFile);
+        return;
+    }
+    qDebug("exiting now");
+}
+
+void processStreamMergeSVOFiles(const char* mergeSVOFiles, const char* mergeOutputFile) {
+    qDebug("streamMergeSVO: %s outputFile: %s", mergeSVOFiles, mergeOutputFile);
+
+    if (!VoxelSVOTools::merge(QString(mergeSVOFiles).split(QString(",")), mergeOutputFile)) {
+        qDebug("Merge into %s failed", mergeOutputFile);
+        return;
+    }
+    qDebug("exiting now");
+}
+
+void processStreamFillSVOFile(const char* fillSVOFile) {
+    qDebug("streamFillSVO: %s", fillSVOFile);
+
+    QString outputFileName = prefixedFileName(fillSVOFile, "filled");
+    VoxelSVOStats created;
+    if (!VoxelSVOTools::fill(fillSVOFile, outputFileName, created)) {
+        qDebug("Fill of %s failed", fillSVOFile);
+        return;
+    }
+    qDebug("Voxels created during filling %llu, %llu bytes", created.voxelCount, created.byteCount);
+    qDebug("outputFile: %s", outputFileName.toLocal8Bit().constData());
+    qDebug("exiting now");
+}
+
 void unitTest(VoxelTree * tree);
 
 
@@ -324,6 +394,37 @@ int main(int argc, const char * argv[])
         return 0;
     }
 
+    // Streaming versions of the above, and stats and merging, for SVOs too big to load
+    const char* STREAM_SVO_STATS = "--streamSVOStats";
+    const char* statsSVOFile = getCmdOption(argc, argv, STREAM_SVO_STATS);
+    if (statsSVOFile) {
+        processStreamSVOStats(statsSVOFile);
+        return 0;
+    }
+
+    const char* STREAM_SPLIT_SVO = "--streamSplitSVO";
+    const char* streamSplitSVOFile = getCmdOption(argc, argv, STREAM_SPLIT_SVO);
+    if (streamSplitSVOFile && splitJurisdictionRoot && splitJurisdictionEndNodes) {
+        processStreamSplitSVOFile(streamSplitSVOFile, splitJurisdictionRoot, splitJurisdictionEndNodes);
+        return 0;
+    }
+
+    const char* STREAM_MERGE_SVO = "--streamMergeSVO";
+    const char* MERGE_OUTPUT = "--mergeOutput";
+    const char* mergeSVOFiles = getCmdOption(argc, argv, STREAM_MERGE_SVO);
+    const char* mergeOutputFile = getCmdOption(argc, argv, MERGE_OUTPUT);
+    if (mergeSVOFiles && mergeOutputFile) {
+        processStreamMergeSVOFiles(mergeSVOFiles, mergeOutputFile);
+        return 0;
+    }
+
+    const char* STREAM_FILL_SVO = "--streamFillSVO";
+    const char* streamFillSVOFile = getCmdOption(argc, argv, STREAM_FILL_SVO);
+    if (streamFillSVOFile) {
+        processStreamFillSVOFile(streamFillSVOFile);
+        return 0;
+    }
+
     const char* DONT_CREATE_FILE = "--dontCreateSceneFile";
     bool dontCreateFile = cmdOptionExists(argc, argv, DONT_CREATE_FILE);
 